@@ -38,5 +38,5 @@
     rm -r /data/hwd/pg14.17/tpce-log/capture.*
 
 # 第 5 步:
-    dbt5-run --client-side -d 47 -f 100 --tpcetools=/home/hwd/dbt5/egen -t 1000 -u 2 -w 25 pgsql /data/hwd/pg14.17/dbt5_results
+    dbt5-run --client-side --bh-capture=results --bh-capture-file=/data/hwd/pg14.17/tpce-log/capture.log -d 47 -f 100 --tpcetools=/home/hwd/dbt5/egen -t 1000 -u 2 -w 25 pgsql /data/hwd/pg14.17/dbt5_results
     # dbt5-run --client-side -d 76 -f 100 --tpcetools=/mnt/disk/egen -t 1000 -u 1 -w 25 pgsql /mnt/disk/pg15.7/dbt5_results
@@ -0,0 +1,154 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Check that splitArray() and splitRecord() take apart the text forms
+ * PostgreSQL gives arrays and records the way the server-side frames expect.
+ * Exit with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "ArrayTokenizer.h"
+
+using namespace std;
+
+static int iChecks = 0;
+static int iFailed = 0;
+
+// Compare the elements split from input with expected, where a NULL stands
+// for an element that was NULL.
+static void
+check(const char *name, const char *input, bool bRecord, int count,
+		const char *expected[])
+{
+	char value[256];
+	strncpy(value, input, sizeof(value) - 1);
+	value[sizeof(value) - 1] = '\0';
+
+	vector<TArrayElement> elements;
+	if (bRecord)
+		splitRecord(value, elements);
+	else
+		splitArray(value, elements);
+
+	++iChecks;
+	bool bOk = (int) elements.size() == count;
+	for (int i = 0; bOk && i < count; i++) {
+		const char *text = expected[i] == NULL ? "" : expected[i];
+		bOk = strcmp(elements[i].c_str(), text) == 0
+				&& elements[i].length == strlen(text)
+				&& elements[i].text >= value
+				&& elements[i].text < value + sizeof(value);
+	}
+	if (bOk)
+		return;
+
+	++iFailed;
+	printf("FAILED %s: %s gave %d elements:", name, input,
+			(int) elements.size());
+	for (size_t i = 0; i < elements.size(); i++)
+		printf(" [%s]", elements[i].c_str());
+	printf("\n");
+}
+
+static void
+checkArrays()
+{
+	const char *simple[] = { "1", "22", "333" };
+	check("plain elements", "{1,22,333}", false, 3, simple);
+
+	const char *quoted[] = { "a b", "c,d", "{e}" };
+	check("quoted elements", "{\"a b\",\"c,d\",\"{e}\"}", false, 3, quoted);
+
+	const char *escaped[] = { "say \"hi\"", "back\\slash" };
+	check("backslash escapes", "{\"say \\\"hi\\\"\",\"back\\\\slash\"}",
+			false, 2, escaped);
+
+	const char *nulls[] = { "1", NULL, "NULL", "3" };
+	check("unquoted NULL against quoted \"NULL\"", "{1,NULL,\"NULL\",3}",
+			false, 4, nulls);
+
+	const char *notNull[] = { "NULLS", "xNULL" };
+	check("NULL as part of an element", "{NULLS,xNULL}", false, 2, notNull);
+
+	check("empty array", "{}", false, 0, NULL);
+	check("not an array", "1,2", false, 0, NULL);
+
+	const char *empty[] = { "" };
+	check("empty quoted element", "{\"\"}", false, 1, empty);
+
+	const char *records[] = { "(1,\"a b\")", "(2,)" };
+	check("array of records", "{\"(1,\\\"a b\\\")\",\"(2,)\"}", false, 2,
+			records);
+}
+
+static void
+checkRecords()
+{
+	const char *simple[] = { "1", "abc", "2.50" };
+	check("plain fields", "(1,abc,2.50)", true, 3, simple);
+
+	const char *doubled[] = { "1", "a \"b\"", NULL };
+	check("doubled quotes", "(1,\"a \"\"b\"\"\",)", true, 3, doubled);
+
+	const char *mixed[] = { "x \"y\" z", "\"" };
+	check("doubled quotes and backslashes",
+			"(\"x \\\"y\"\" z\",\"\"\"\")", true, 2, mixed);
+
+	const char *trailing[] = { "a", NULL, NULL };
+	check("empty trailing fields", "(a,,)", true, 3, trailing);
+
+	const char *leading[] = { NULL, "b" };
+	check("empty leading field", "(,b)", true, 2, leading);
+
+	const char *one[] = { NULL };
+	check("record of one NULL", "()", true, 1, one);
+
+	const char *word[] = { "NULL", "x" };
+	check("NULL as text in a record", "(NULL,x)", true, 2, word);
+}
+
+// The elements are left in the value, which is rewritten around them.
+static void
+checkInPlace()
+{
+	char value[] = "{\"a\\\"b\",c,NULL}";
+	vector<TArrayElement> elements;
+	splitArray(value, elements);
+
+	++iChecks;
+	if (elements.size() != 3 || elements[0].text != value + 1
+			|| memcmp(value, "{a\"b\0", 5) != 0
+			|| elements[1].text != value + 8
+			|| memcmp(value + 8, "c\0", 2) != 0
+			|| elements[2].text != value + 10 || value[10] != '\0') {
+		++iFailed;
+		printf("FAILED in place rewriting\n");
+	}
+
+	// Splitting again reuses the elements.
+	char other[] = "{x}";
+	splitArray(other, elements);
+	++iChecks;
+	if (elements.size() != 1 || elements[0].text != other + 1
+			|| strcmp(elements[0].c_str(), "x") != 0) {
+		++iFailed;
+		printf("FAILED reuse of the elements\n");
+	}
+}
+
+int
+main()
+{
+	checkArrays();
+	checkRecords();
+	checkInPlace();
+
+	printf("%d checks, %d failed\n", iChecks, iFailed);
+	return iFailed == 0 ? 0 : 1;
+}
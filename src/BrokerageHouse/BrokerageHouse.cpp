@@ -7,11 +7,17 @@
  * 25 July 2006
  */
 
+#include <signal.h>
+
 #include "BrokerageHouse.h"
+#include "BrokerageReactor.h"
+#include "BrokerageScheduler.h"
+#include "BrokerageSession.h"
 #include "CommonStructs.h"
 #include "DBConnection.h"
 #include "DBConnectionClientSide.h"
 #include "DBConnectionServerSide.h"
+#include "StatementStats.h"
 
 #include "BrokerVolumeDB.h"
 #include "CustomerPositionDB.h"
@@ -26,277 +32,65 @@
 #include "TradeStatusDB.h"
 #include "TradeUpdateDB.h"
 
+// How often the statistics files are written.
+#define BH_STATS_SECONDS 10
+
+// Longest wait before the first retry of a transaction, doubled at each of
+// the next ones up to BH_RETRY_BACKOFF_MAX_US.  The actual wait is random,
+// so that the transactions in conflict do not meet again.
+#define BH_RETRY_BACKOFF_US 1000
+#define BH_RETRY_BACKOFF_MAX_US 64000
+
+// Keep the statistics files up to date, the Brokerage House is usually
+// killed.  SIGUSR1, blocked by main(), has them written at once, as
+// dbt5-run does before killing it.
 void *
-workerThread(void *data)
+statsThread(void *data)
 {
-	try {
-		PThreadParameter pThrParam = reinterpret_cast<PThreadParameter>(data);
-
-		CSocket sockDrv;
-		sockDrv.setSocketFd(pThrParam->iSockfd); // client socket
-
-		PMsgDriverBrokerage pMessage = new TMsgDriverBrokerage;
-		memset(pMessage, 0, sizeof(TMsgDriverBrokerage)); // zero the structure
-
-		TMsgBrokerageDriver Reply; // return message
-		INT32 iRet = 0; // transaction return code
-		CDBConnection *pDBConnection = NULL;
-
-		// new database connection
-		if (pThrParam->pBrokerageHouse->m_ClientSide == 1) {
-			pDBConnection = new CDBConnectionClientSide(
-					pThrParam->pBrokerageHouse->m_szHost,
-					pThrParam->pBrokerageHouse->m_szDBName,
-					pThrParam->pBrokerageHouse->m_szDBPort,
-					pThrParam->pBrokerageHouse->verbose());
-		} else {
-			pDBConnection = new CDBConnectionServerSide(
-					pThrParam->pBrokerageHouse->m_szHost,
-					pThrParam->pBrokerageHouse->m_szDBName,
-					pThrParam->pBrokerageHouse->m_szDBPort,
-					pThrParam->pBrokerageHouse->verbose());
-		}
-		pDBConnection->setBrokerageHouse(pThrParam->pBrokerageHouse);
-		CSendToMarket sendToMarket
-				= CSendToMarket(&(pThrParam->pBrokerageHouse->m_fLog),
-						pThrParam->m_szMEEHost, atoi(pThrParam->m_szMEEPort));
-		CMarketFeedDB marketFeedDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CMarketFeed marketFeed = CMarketFeed(&marketFeedDB, &sendToMarket);
-		CTradeOrderDB tradeOrderDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CTradeOrder tradeOrder = CTradeOrder(&tradeOrderDB, &sendToMarket);
-
-		// Initialize all classes that will be used to execute transactions.
-		CBrokerVolumeDB brokerVolumeDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CBrokerVolume brokerVolume = CBrokerVolume(&brokerVolumeDB);
-		CCustomerPositionDB customerPositionDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CCustomerPosition customerPosition
-				= CCustomerPosition(&customerPositionDB);
-		CMarketWatchDB marketWatchDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CMarketWatch marketWatch = CMarketWatch(&marketWatchDB);
-		CSecurityDetailDB securityDetailDB = CSecurityDetailDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CSecurityDetail securityDetail = CSecurityDetail(&securityDetailDB);
-		CTradeLookupDB tradeLookupDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CTradeLookup tradeLookup = CTradeLookup(&tradeLookupDB);
-		CTradeStatusDB tradeStatusDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CTradeStatus tradeStatus = CTradeStatus(&tradeStatusDB);
-		CTradeUpdateDB tradeUpdateDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CTradeUpdate tradeUpdate = CTradeUpdate(&tradeUpdateDB);
-		CDataMaintenanceDB dataMaintenanceDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CDataMaintenance dataMaintenance
-				= CDataMaintenance(&dataMaintenanceDB);
-		CTradeCleanupDB tradeCleanupDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CTradeCleanup tradeCleanup = CTradeCleanup(&tradeCleanupDB);
-		CTradeResultDB tradeResultDB(
-				pDBConnection, pThrParam->pBrokerageHouse->verbose());
-		CTradeResult tradeResult = CTradeResult(&tradeResultDB);
-
-		do {
-			try {
-				sockDrv.dbt5Receive(reinterpret_cast<void *>(pMessage),
-						sizeof(TMsgDriverBrokerage));
-			} catch (std::runtime_error &err) {
-				sockDrv.dbt5Disconnect();
-
-				ostringstream osErr;
-				osErr << "Error on Receive: " << err.what()
-					  << " at BrokerageHouse::workerThread" << endl;
-				pThrParam->pBrokerageHouse->logErrorMessage(osErr.str());
-
-				// The socket has been closed, break and let this thread die.
-				break;
-			} catch (CSocketErr *pErr) {
-				sockDrv.dbt5Disconnect();
-
-				if (pErr->getAction() == CSocketErr::ERR_SOCKET_CLOSED) {
-					delete pErr;
-					break;
-				}
-
-				ostringstream osErr;
-				osErr << "Error on Receive: " << pErr->ErrorText()
-					  << " at BrokerageHouse::workerThread" << endl;
-				pThrParam->pBrokerageHouse->logErrorMessage(osErr.str());
-				delete pErr;
-
-				// The socket has been closed, break and let this thread die.
-				break;
-			}
-
-			try {
-				//  Parse Txn type
-				switch (pMessage->TxnType) {
-				case BROKER_VOLUME:
-					iRet = pThrParam->pBrokerageHouse->RunBrokerVolume(
-							&(pMessage->TxnInput.BrokerVolumeTxnInput),
-							brokerVolume);
-					break;
-				case CUSTOMER_POSITION:
-					iRet = pThrParam->pBrokerageHouse->RunCustomerPosition(
-							&(pMessage->TxnInput.CustomerPositionTxnInput),
-							customerPosition);
-					if (iRet != 0)
-						pDBConnection->rollback();
-					break;
-				case MARKET_FEED:
-					iRet = pThrParam->pBrokerageHouse->RunMarketFeed(
-							&(pMessage->TxnInput.MarketFeedTxnInput),
-							marketFeed);
-					break;
-				case MARKET_WATCH:
-					iRet = pThrParam->pBrokerageHouse->RunMarketWatch(
-							&(pMessage->TxnInput.MarketWatchTxnInput),
-							marketWatch);
-					break;
-				case SECURITY_DETAIL:
-					iRet = pThrParam->pBrokerageHouse->RunSecurityDetail(
-							&(pMessage->TxnInput.SecurityDetailTxnInput),
-							securityDetail);
-					break;
-				case TRADE_LOOKUP:
-					iRet = pThrParam->pBrokerageHouse->RunTradeLookup(
-							&(pMessage->TxnInput.TradeLookupTxnInput),
-							tradeLookup);
-					break;
-				case TRADE_ORDER:
-					iRet = pThrParam->pBrokerageHouse->RunTradeOrder(
-							&(pMessage->TxnInput.TradeOrderTxnInput),
-							tradeOrder);
-					break;
-				case TRADE_RESULT:
-					iRet = pThrParam->pBrokerageHouse->RunTradeResult(
-							&(pMessage->TxnInput.TradeResultTxnInput),
-							tradeResult);
-					if (iRet != 0)
-						pDBConnection->rollback();
-					break;
-				case TRADE_STATUS:
-					iRet = pThrParam->pBrokerageHouse->RunTradeStatus(
-							&(pMessage->TxnInput.TradeStatusTxnInput),
-							tradeStatus);
-					break;
-				case TRADE_UPDATE:
-					iRet = pThrParam->pBrokerageHouse->RunTradeUpdate(
-							&(pMessage->TxnInput.TradeUpdateTxnInput),
-							tradeUpdate);
-					break;
-				case DATA_MAINTENANCE:
-					iRet = pThrParam->pBrokerageHouse->RunDataMaintenance(
-							&(pMessage->TxnInput.DataMaintenanceTxnInput),
-							dataMaintenance);
-					break;
-				case TRADE_CLEANUP:
-					iRet = pThrParam->pBrokerageHouse->RunTradeCleanup(
-							&(pMessage->TxnInput.TradeCleanupTxnInput),
-							tradeCleanup);
-					break;
-				default:
-					cout << "wrong txn type" << endl;
-					iRet = ERR_TYPE_WRONGTXN;
-				}
-			} catch (std::string const &e) {
-				pid_t pid = syscall(SYS_gettid);
-				ostringstream msg;
-				msg << time(NULL) << " " << pid << " "
-					<< szTransactionName[pMessage->TxnType] << " " << e
-					<< endl;
-				pThrParam->pBrokerageHouse->logErrorMessage(msg.str());
-				iRet = CBaseTxnErr::EXPECTED_ROLLBACK;
-			}
-
-			if (iRet < 0)
-				cerr << "INVALID RUN : see "
-					 << pThrParam->pBrokerageHouse->errorLogFilename()
-					 << " for transaction details" << endl;
-
-			// send status to driver
-			Reply.iStatus = iRet;
-			try {
-				sockDrv.dbt5Send(
-						reinterpret_cast<void *>(&Reply), sizeof(Reply));
-			} catch (CSocketErr *pErr) {
-				sockDrv.dbt5Disconnect();
-
-				ostringstream osErr;
-				osErr << "Error on Send: " << pErr->ErrorText()
-					  << " at BrokerageHouse::workerThread" << endl;
-				pThrParam->pBrokerageHouse->logErrorMessage(osErr.str());
-				delete pErr;
-
-				// The socket has been closed, break and let this thread die.
-				break;
-			}
-		} while (true);
-
-		close(pThrParam->iSockfd); // close socket connection with the driver
-		delete pThrParam;
-		delete pMessage;
-	} catch (CSocketErr *err) {
+	CBrokerageHouse *pBrokerageHouse
+			= reinterpret_cast<CBrokerageHouse *>(data);
+
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	struct timespec timeout = { BH_STATS_SECONDS, 0 };
+	while (true) {
+		sigtimedwait(&signals, NULL, &timeout);
+		pBrokerageHouse->writeStats();
 	}
 	return NULL;
 }
 
-// entry point for worker thread
-void
-entryWorkerThread(void *data)
+// Run the queued requests, whatever connection they came from.
+void *
+workerThread(void *data)
 {
-	PThreadParameter pThrParam = reinterpret_cast<PThreadParameter>(data);
-
-	pthread_t threadID; // thread ID
-	pthread_attr_t threadAttribute; // thread attribute
-
-	try {
-		// initialize the attribute object
-		int status = pthread_attr_init(&threadAttribute);
-		if (status != 0) {
-			throw new CThreadErr(CThreadErr::ERR_THREAD_ATTR_INIT);
-		}
-
-		// set the detachstate attribute to detached
-		status = pthread_attr_setdetachstate(
-				&threadAttribute, PTHREAD_CREATE_DETACHED);
-		if (status != 0) {
-			throw new CThreadErr(CThreadErr::ERR_THREAD_ATTR_DETACH);
-		}
+	CBrokerageHouse *pBrokerageHouse
+			= reinterpret_cast<CBrokerageHouse *>(data);
 
-		// create the thread in the detached state
-		status = pthread_create(
-				&threadID, &threadAttribute, &workerThread, data);
-
-		if (status != 0) {
-			throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE);
-		}
-	} catch (CThreadErr *pErr) {
-		// close recently accepted connection, to release driver threads
-		close(pThrParam->iSockfd);
-
-		ostringstream osErr;
-		osErr << "Error: " << pErr->ErrorText() << " at "
-			  << "BrokerageHouse::entryWorkerThread" << endl
-			  << "accepted socket connection closed" << endl;
-		pThrParam->pBrokerageHouse->logErrorMessage(osErr.str());
-		delete pThrParam;
-		delete pErr;
-	}
+	while (true)
+		pBrokerageHouse->serveRequest(pBrokerageHouse->m_RequestQueue.pop());
+	return NULL;
 }
 
 // Constructor
 CBrokerageHouse::CBrokerageHouse(const char *szHost, const char *szDBName,
 		const char *szDBPort, const char *szMEEHost, const char *szMEEPort,
-		const int iListenPort, char *outputDirectory, int iClientSide,
-		bool verbose = false)
-: m_iListenPort(iListenPort), m_ClientSide(iClientSide), m_Verbose(verbose)
+		const int iListenPort, const char *szListenAddress,
+		char *outputDirectory, int iClientSide, int iReactors, int iWorkers,
+		int iTransactions, int iConnections, int iQueueDepth,
+		eQueuePolicy ePolicy, bool bPipeline, ePlanCache ePlanCache,
+		int iRetries, bool bBinary, eCaptureLevel eCapture,
+		const double *pCaptureRates, bool verbose = false)
+: m_iListenPort(iListenPort), m_ClientSide(iClientSide),
+  m_bPipeline(bPipeline), m_ePlanCache(ePlanCache), m_bBinary(bBinary),
+  m_eCapture(eCapture), m_Verbose(verbose), m_iRetries(iRetries),
+  m_iReactors(iReactors), m_iWorkers(iWorkers),
+  m_iTransactions(iTransactions), m_RequestQueue(iQueueDepth, ePolicy),
+  m_iMaxSessions(iConnections), m_iSessions(0)
 {
+	strncpy(m_szListenAddress, szListenAddress, iMaxHostname);
+	m_szListenAddress[iMaxHostname] = '\0';
 	strncpy(m_szHost, szHost, iMaxHostname);
 	m_szHost[iMaxHostname] = '\0';
 	strncpy(m_szDBName, szDBName, iMaxDBName);
@@ -309,8 +103,26 @@ CBrokerageHouse::CBrokerageHouse(const char *szHost, const char *szDBName,
 	strncpy(m_szMEEPort, szMEEPort, iMaxPort);
 	m_szMEEPort[iMaxPort] = '\0';
 
+	for (int i = 0; i <= TRADE_CLEANUP; i++)
+		m_fCaptureRates[i] = pCaptureRates[i];
+
+	pthread_mutex_init(&m_SessionLock, NULL);
+	pthread_cond_init(&m_SessionIdle, NULL);
+
 	snprintf(m_errorLogFilename, iMaxPath, "%s/BrokerageHouse_Error.log",
 			outputDirectory);
+	snprintf(m_pipelineStatsFilename, iMaxPath, "%s/pipeline_stats.csv",
+			outputDirectory);
+	snprintf(m_retryStatsFilename, iMaxPath, "%s/retry_stats.csv",
+			outputDirectory);
+	snprintf(m_statementStatsFilename, iMaxPath, "%s/statement_stats.csv",
+			outputDirectory);
+	for (int i = 0; i <= TRADE_CLEANUP; i++) {
+		m_llRetries[i] = 0;
+		m_llRetriesExhausted[i] = 0;
+		m_llWastedNs[i] = 0;
+		m_llBackoffNs[i] = 0;
+	}
 	m_fLog.open(m_errorLogFilename, ios::out);
 }
 
@@ -318,9 +130,336 @@ CBrokerageHouse::CBrokerageHouse(const char *szHost, const char *szDBName,
 CBrokerageHouse::~CBrokerageHouse()
 {
 	m_Socket.closeListenerSocket();
+	for (size_t i = 0; i < m_IdleSessions.size(); i++)
+		delete m_IdleSessions[i];
+	pthread_cond_destroy(&m_SessionIdle);
+	pthread_mutex_destroy(&m_SessionLock);
 	m_fLog.close();
 }
 
+// Take an idle session, or open a new one while there are fewer than the
+// database connections allowed.  Sessions are opened on first use because
+// the Market Exchange Emulator is started after the Brokerage House.
+CBrokerageSession *
+CBrokerageHouse::acquireSession()
+{
+	pthread_mutex_lock(&m_SessionLock);
+	while (m_IdleSessions.empty() && m_iSessions >= m_iMaxSessions)
+		pthread_cond_wait(&m_SessionIdle, &m_SessionLock);
+	if (!m_IdleSessions.empty()) {
+		CBrokerageSession *pSession = m_IdleSessions.back();
+		m_IdleSessions.pop_back();
+		pthread_mutex_unlock(&m_SessionLock);
+		return pSession;
+	}
+	++m_iSessions;
+	pthread_mutex_unlock(&m_SessionLock);
+
+	// Connect without holding the lock.
+	try {
+		return newSession();
+	} catch (CSocketErr *) {
+		pthread_mutex_lock(&m_SessionLock);
+		--m_iSessions;
+		pthread_cond_signal(&m_SessionIdle);
+		pthread_mutex_unlock(&m_SessionLock);
+		throw;
+	}
+}
+
+void
+CBrokerageHouse::releaseSession(CBrokerageSession *pSession)
+{
+	pthread_mutex_lock(&m_SessionLock);
+	m_IdleSessions.push_back(pSession);
+	pthread_cond_signal(&m_SessionIdle);
+	pthread_mutex_unlock(&m_SessionLock);
+}
+
+// new database connection
+CDBConnection *
+CBrokerageHouse::newDBConnection()
+{
+	CDBConnection *pDBConnection;
+	if (m_ClientSide == 1) {
+		pDBConnection = new CDBConnectionClientSide(
+				m_szHost, m_szDBName, m_szDBPort, m_Verbose);
+	} else {
+		pDBConnection = new CDBConnectionServerSide(
+				m_szHost, m_szDBName, m_szDBPort, m_Verbose);
+	}
+	pDBConnection->setBrokerageHouse(this);
+	pDBConnection->setPipeline(m_bPipeline);
+	pDBConnection->setPlanCache(m_ePlanCache);
+	pDBConnection->setBinaryResults(m_bBinary);
+	pDBConnection->setCapture(m_eCapture, m_fCaptureRates);
+	return pDBConnection;
+}
+
+// new session, connected to the database and to the Market Exchange
+// Emulator
+CBrokerageSession *
+CBrokerageHouse::newSession()
+{
+	CDBConnection *pDBConnection = newDBConnection();
+	try {
+		return new CBrokerageSession(pDBConnection, &m_fLog, m_szMEEHost,
+				atoi(m_szMEEPort), m_Verbose);
+	} catch (CSocketErr *) {
+		delete pDBConnection;
+		throw;
+	}
+}
+
+// Hand a request to the workers.  Return false if the queue is full and the
+// reactor is to keep the request until there is room, the caller still owns
+// it then.
+bool
+CBrokerageHouse::queueRequest(PBrokerageRequest pRequest)
+{
+	if (m_RequestQueue.push(pRequest))
+		return true;
+	if (m_RequestQueue.policy() == QUEUE_BLOCK)
+		return false;
+	rejectRequest(pRequest, ERR_TYPE_BUSY);
+	return true;
+}
+
+// Answer a request for which no session could be opened.
+void
+CBrokerageHouse::failRequest(PBrokerageRequest pRequest, CSocketErr *pErr)
+{
+	ostringstream osErr;
+	osErr << "Cannot open a session: " << pErr->ErrorText()
+		  << " at BrokerageHouse::serveRequest" << endl;
+	logErrorMessage(osErr.str());
+	delete pErr;
+	rejectRequest(pRequest, ERR_TYPE_SOCKET);
+}
+
+// Answer a request without running it.
+void
+CBrokerageHouse::rejectRequest(PBrokerageRequest pRequest, INT32 iStatus)
+{
+	TMsgTimedReply Reply;
+	memset(&Reply, 0, sizeof(TMsgTimedReply));
+	Reply.iRequestId = pRequest->iRequestId;
+	Reply.Reply.iStatus = iStatus;
+	sendReply(pRequest->pConnection, &Reply);
+
+	pRequest->pConnection->release();
+	delete pRequest;
+}
+
+INT32
+CBrokerageHouse::dispatchTransaction(
+		CBrokerageSession *pSession, PMsgDriverBrokerage pMessage)
+{
+	INT32 iRet = 0; // transaction return code
+	//  Parse Txn type
+	switch (pMessage->TxnType) {
+	case BROKER_VOLUME:
+		iRet = RunBrokerVolume(&(pMessage->TxnInput.BrokerVolumeTxnInput),
+				pSession->m_BrokerVolume);
+		break;
+	case CUSTOMER_POSITION:
+		iRet = RunCustomerPosition(
+				&(pMessage->TxnInput.CustomerPositionTxnInput),
+				pSession->m_CustomerPosition);
+		if (iRet != 0)
+			pSession->m_pDBConnection->rollback();
+		break;
+	case MARKET_FEED:
+		iRet = RunMarketFeed(&(pMessage->TxnInput.MarketFeedTxnInput),
+				pSession->m_MarketFeed);
+		break;
+	case MARKET_WATCH:
+		iRet = RunMarketWatch(&(pMessage->TxnInput.MarketWatchTxnInput),
+				pSession->m_MarketWatch);
+		break;
+	case SECURITY_DETAIL:
+		iRet = RunSecurityDetail(
+				&(pMessage->TxnInput.SecurityDetailTxnInput),
+				pSession->m_SecurityDetail);
+		break;
+	case TRADE_LOOKUP:
+		iRet = RunTradeLookup(&(pMessage->TxnInput.TradeLookupTxnInput),
+				pSession->m_TradeLookup);
+		break;
+	case TRADE_ORDER:
+		iRet = RunTradeOrder(&(pMessage->TxnInput.TradeOrderTxnInput),
+				pSession->m_TradeOrder);
+		break;
+	case TRADE_RESULT:
+		iRet = RunTradeResult(&(pMessage->TxnInput.TradeResultTxnInput),
+				pSession->m_TradeResult);
+		if (iRet != 0)
+			pSession->m_pDBConnection->rollback();
+		break;
+	case TRADE_STATUS:
+		iRet = RunTradeStatus(&(pMessage->TxnInput.TradeStatusTxnInput),
+				pSession->m_TradeStatus);
+		break;
+	case TRADE_UPDATE:
+		iRet = RunTradeUpdate(&(pMessage->TxnInput.TradeUpdateTxnInput),
+				pSession->m_TradeUpdate);
+		break;
+	case DATA_MAINTENANCE:
+		iRet = RunDataMaintenance(
+				&(pMessage->TxnInput.DataMaintenanceTxnInput),
+				pSession->m_DataMaintenance);
+		break;
+	case TRADE_CLEANUP:
+		iRet = RunTradeCleanup(&(pMessage->TxnInput.TradeCleanupTxnInput),
+				pSession->m_TradeCleanup);
+		break;
+	default:
+		cout << "wrong txn type" << endl;
+		iRet = ERR_TYPE_WRONGTXN;
+	}
+	return iRet;
+}
+
+// Run a transaction, again while PostgreSQL aborts it for a conflict and
+// retries are left.
+INT32
+CBrokerageHouse::runTransaction(
+		CBrokerageSession *pSession, PMsgDriverBrokerage pMessage)
+{
+	INT32 iRet = 0; // transaction return code
+	if (pMessage->TxnType >= 0 && pMessage->TxnType <= TRADE_CLEANUP)
+		pSession->m_pDBConnection->sampleCapture(pMessage->TxnType);
+	for (int iRetry = 0;; iRetry++) {
+		INT64 llStart = serverClockNs();
+		string sErr;
+		try {
+			iRet = dispatchTransaction(pSession, pMessage);
+			break;
+		} catch (CDBRetryErr const &e) {
+			// Market Feed runs its aborted entries again by itself.
+			if (pMessage->TxnType != MARKET_FEED
+					&& retryTransaction(pSession->m_pDBConnection,
+							pMessage->TxnType, iRetry, llStart))
+				continue;
+			sErr = e;
+		} catch (std::string const &e) {
+			sErr = e;
+		}
+
+		pid_t pid = syscall(SYS_gettid);
+		ostringstream msg;
+		msg << time(NULL) << " " << pid << " "
+			<< szTransactionName[pMessage->TxnType] << " " << sErr << endl;
+		logErrorMessage(msg.str());
+		iRet = CBaseTxnErr::EXPECTED_ROLLBACK;
+		break;
+	}
+
+	if (iRet < 0)
+		cerr << "INVALID RUN : see " << errorLogFilename()
+			 << " for transaction details" << endl;
+	return iRet;
+}
+
+// Send the status to the driver, with the ID of the request when
+// pipelining.  The driver may be gone already.
+void
+CBrokerageHouse::sendReply(CBrokerageConnection *pConnection,
+		PMsgTimedReply pReply)
+{
+	try {
+		pConnection->sendReply(pReply);
+	} catch (CSocketErr *pErr) {
+		if (pErr->getAction() != CSocketErr::ERR_SOCKET_CLOSED) {
+			ostringstream osErr;
+			osErr << "Error on Send: " << pErr->ErrorText()
+				  << " at BrokerageHouse::sendReply" << endl;
+			logErrorMessage(osErr.str());
+		}
+		delete pErr;
+	}
+}
+
+// Run a request on a session from the pool.
+void
+CBrokerageHouse::serveRequest(PBrokerageRequest pRequest)
+{
+	CBrokerageSession *pSession;
+	try {
+		pSession = acquireSession();
+	} catch (CSocketErr *pErr) {
+		failRequest(pRequest, pErr);
+		return;
+	}
+	serveRequest(pRequest, pSession);
+	releaseSession(pSession);
+}
+
+// Run a request on a session and answer it.
+void
+CBrokerageHouse::serveRequest(
+		PBrokerageRequest pRequest, CBrokerageSession *pSession)
+{
+	CBrokerageConnection *pConnection = pRequest->pConnection;
+
+	TMsgTimedReply Reply; // return message
+	PMsgServerTimes pTimes = NULL;
+	if (pConnection->m_iWireVersion >= WIRE_VERSION_TIMED) {
+		pTimes = &Reply.Times;
+		memset(pTimes, 0, sizeof(TMsgServerTimes));
+	}
+
+	pSession->setServerTimes(pTimes);
+	// The dispatch time includes the wait in the queue and for a session.
+	if (pTimes != NULL)
+		pTimes->llDispatch = serverClockNs() - pRequest->llReceived;
+	INT32 iRet = runTransaction(pSession, &pRequest->Message);
+
+	Reply.iRequestId = pRequest->iRequestId;
+	Reply.Reply.iStatus = iRet;
+	if (pTimes != NULL)
+		pTimes->llTotal = serverClockNs() - pRequest->llReceived;
+	sendReply(pConnection, &Reply);
+
+	pConnection->release();
+	delete pRequest;
+}
+
+// Start the workers, which live as long as the Brokerage House.
+void
+CBrokerageHouse::startWorkers()
+{
+	if (m_iTransactions > 0) {
+		for (int i = 0; i < m_iWorkers; i++) {
+			m_Schedulers.push_back(
+					new CBrokerageScheduler(this, m_iTransactions));
+		}
+		return;
+	}
+
+	pthread_attr_t threadAttribute;
+	if (pthread_attr_init(&threadAttribute) != 0) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_ATTR_INIT,
+				"CBrokerageHouse::startWorkers");
+	}
+	if (pthread_attr_setdetachstate(&threadAttribute, PTHREAD_CREATE_DETACHED)
+			!= 0) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_ATTR_DETACH,
+				"CBrokerageHouse::startWorkers");
+	}
+
+	for (int i = 0; i < m_iWorkers; i++) {
+		pthread_t threadID;
+		if (pthread_create(&threadID, &threadAttribute, &workerThread,
+					reinterpret_cast<void *>(this))
+				!= 0) {
+			throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+					"CBrokerageHouse::startWorkers");
+		}
+	}
+	pthread_attr_destroy(&threadAttribute);
+}
+
 void
 CBrokerageHouse::dumpInputData(PBrokerVolumeTxnInput pTxnInput)
 {
@@ -990,29 +1129,25 @@ CBrokerageHouse::RunTradeUpdate(
 void
 CBrokerageHouse::startListener(void)
 {
-	int acc_socket;
-	PThreadParameter pThrParam = NULL;
-
-	m_Socket.dbt5Listen(m_iListenPort);
+	m_Socket.dbt5Listen(m_szListenAddress, m_iListenPort);
+	startWorkers();
+	pthread_t threadID;
+	if (pthread_create(&threadID, NULL, &statsThread,
+				reinterpret_cast<void *>(this))
+			!= 0) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+				"CBrokerageHouse::startListener");
+	}
+	pthread_detach(threadID);
+	for (int i = 0; i < m_iReactors; i++)
+		m_Reactors.push_back(new CBrokerageReactor(this));
 
-	while (true) {
-		acc_socket = 0;
+	// Spread the connections over the reactors.
+	for (size_t iNext = 0;; iNext++) {
+		int acc_socket = 0;
 		try {
 			acc_socket = m_Socket.dbt5Accept();
-
-			pThrParam = new TThreadParameter;
-			// zero the structure
-			memset(pThrParam, 0, sizeof(TThreadParameter));
-
-			pThrParam->iSockfd = acc_socket;
-			pThrParam->pBrokerageHouse = this;
-			strncpy(pThrParam->m_szMEEHost, m_szMEEHost, iMaxHostname);
-			pThrParam->m_szMEEHost[iMaxHostname] = '\0';
-			strncpy(pThrParam->m_szMEEPort, m_szMEEPort, iMaxPort);
-			pThrParam->m_szMEEPort[iMaxPort] = '\0';
-
-			// call entry point
-			entryWorkerThread(reinterpret_cast<void *>(pThrParam));
+			m_Reactors[iNext % m_Reactors.size()]->addConnection(acc_socket);
 		} catch (CSocketErr *pErr) {
 			ostringstream osErr;
 			osErr << "Problem accepting socket connection" << endl
@@ -1020,7 +1155,6 @@ CBrokerageHouse::startListener(void)
 				  << "BrokerageHouse::Listener" << endl;
 			logErrorMessage(osErr.str());
 			delete pErr;
-			delete pThrParam;
 		}
 	}
 }
@@ -1043,6 +1177,55 @@ CBrokerageHouse::errorLogFilename()
 	return m_errorLogFilename;
 }
 
+bool
+CBrokerageHouse::retryTransaction(CDBConnection *pConnection, int iTxnType,
+		int iRetry, INT64 llStart)
+{
+	m_llWastedNs[iTxnType] += serverClockNs() - llStart;
+	if (iRetry >= m_iRetries) {
+		++m_llRetriesExhausted[iTxnType];
+		return false;
+	}
+	++m_llRetries[iTxnType];
+
+	// A worker running several transactions at once goes on with the
+	// others meanwhile.
+	static thread_local unsigned int iSeed
+			= (unsigned int) serverClockNs() ^ syscall(SYS_gettid);
+	int iCeiling = BH_RETRY_BACKOFF_US << (iRetry < 6 ? iRetry : 6);
+	if (iCeiling > BH_RETRY_BACKOFF_MAX_US)
+		iCeiling = BH_RETRY_BACKOFF_MAX_US;
+	INT64 llSleep = serverClockNs();
+	pConnection->backoff(rand_r(&iSeed) % iCeiling);
+	m_llBackoffNs[iTxnType] += serverClockNs() - llSleep;
+	return true;
+}
+
+// Rewrite the statistics of the frames sent in pipeline mode, of the
+// transactions retried, and of the statements run, so far.
+void
+CBrokerageHouse::writeStats()
+{
+	if (m_bPipeline) {
+		ofstream fStats(m_pipelineStatsFilename, ios::out | ios::trunc);
+		CDBConnection::writePipelineStats(fStats);
+	}
+
+	ofstream fStats(m_retryStatsFilename, ios::out | ios::trunc);
+	fStats << "transaction,retries,retries_exhausted,wasted_ms,backoff_ms"
+		   << endl;
+	for (int i = 0; i <= TRADE_CLEANUP; i++) {
+		long long llWasted = m_llWastedNs[i];
+		long long llBackoff = m_llBackoffNs[i];
+		fStats << szTransactionName[i] << "," << m_llRetries[i] << ","
+			   << m_llRetriesExhausted[i] << "," << llWasted / 1000000 << ","
+			   << llBackoff / 1000000 << endl;
+	}
+
+	ofstream fStatements(m_statementStatsFilename, ios::out | ios::trunc);
+	CStatementStats::write(fStatements);
+}
+
 bool
 CBrokerageHouse::verbose()
 {
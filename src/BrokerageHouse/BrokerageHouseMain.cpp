@@ -8,16 +8,20 @@
  * 25 July 2006
  */
 
+#include <signal.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/async.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 
 #include "BrokerageHouse.h"
+#include "CaptureLog.h"
+#include "DBConnection.h"
 #include "DBT5Consts.h"
 
 // Establish defaults for command line option
 int iClientSide = 0;
 int iListenPort = iBrokerageHousePort;
+char szListenAddress[iMaxHostname + 1] = "";
 bool verbose = false;
 
 char szHost[iMaxHostname + 1] = "";
@@ -27,6 +31,24 @@ char szMEEHost[iMaxHostname + 1] = "localhost";
 char szMEEPort[iMaxPort + 1] = "";
 char outputDirectory[iMaxPath + 1] = ".";
 
+int iReactors = 2;
+int iWorkers = 64;
+int iTransactions = 0; // one at a time per worker
+int iConnections = 0; // as many as workers
+int iQueueDepth = 0; // no limit
+eQueuePolicy ePolicy = QUEUE_BLOCK;
+bool bPipeline = false;
+ePlanCache ePlans = PLAN_CACHE_AUTO;
+static const char *szPlans[] = { "auto", "generic", "custom", "off" };
+int iRetries = 3;
+bool bBinary = false;
+eCaptureLevel eCapture = CAPTURE_OFF;
+static const char *szCapture[] = { "off", "statements", "params", "results" };
+double fCaptureRates[TRADE_CLEANUP + 1] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1 };
+char szCaptureFile[iMaxPath + 1] = ""; // capture.log in the output directory
+bool bCaptureBinary = false;
+
 // shows program usage
 void
 usage()
@@ -35,18 +57,103 @@ usage()
 	cout << "   Option      Default    Description" << endl;
 	cout << "   =========   =========  ===============" << endl;
 	cout << "   -1                     Use client-side app logic" << endl;
+	cout << "   -a integer  0          Transactions each worker runs at once,"
+		 << endl
+		 << "                          on database connections of its own,"
+		 << endl
+		 << "                          0 to run one at a time" << endl;
+	cout << "   -b                     Fetch the client-side results in binary"
+		 << endl;
+	cout << "   -B                     Capture in binary, to capture.bin by"
+		 << endl
+		 << "                          default, for CaptureDecode" << endl;
+	cout << "   -c integer  workers    Database connections" << endl;
+	cout << "   -C string   off        Capture the statements run: off,"
+		 << endl
+		 << "                          statements, params with their"
+		 << endl
+		 << "                          parameters, or results with their"
+		 << endl
+		 << "                          parameters and results" << endl;
 	cout << "   -d string              Database name" << endl;
+	printf("   -e integer  %-9d  Threads reading the connections\n",
+			iReactors);
 	cout << "   -h string   localhost  Database server" << endl;
-	printf("   -l integer  %-9d  Socket listen port\n", iListenPort);
-	printf("   -m string   %9s  Market Exchange Emulator hostname\n",
+	cout << "   -L string              Capture file, capture.log in the"
+		 << endl
+		 << "                          output directory by default" << endl;
+	printf("   -l string   %-9d  Socket listen port, or unix:<path>\n",
+			iListenPort);
+	printf("   -m string   %9s  Market Exchange Emulator hostname,\n",
 			szMEEHost);
+	printf("                          or unix:<path> or shm:<path>\n");
 	printf("   -M integer  %9s  Market Exchange Emulator port\n", szMEEPort);
 	cout << "   -o string   .          Output directory" << endl;
 	cout << "   -p integer             Database port" << endl;
+	cout << "   -P                     Send the independent statements of a"
+		 << endl
+		 << "                          frame together, in libpq pipeline mode"
+		 << endl;
+	cout << "   -q integer  0          Requests queued for the workers,"
+		 << endl
+		 << "                          0 for no limit" << endl;
+	printf("   -R integer  %-9d  Retries of a transaction aborted for a\n",
+			iRetries);
+	cout << "                          serialization failure or a deadlock"
+		 << endl;
+	cout << "   -r                     Reject requests when the queue is full,"
+		 << endl
+		 << "                          instead of waiting for room" << endl;
+	cout << "   -S string   1          Share of the transactions captured,"
+		 << endl
+		 << "                          from 0 to 1, for all the types and"
+		 << endl
+		 << "                          then by type, as 0.01,TRADE_RESULT=1"
+		 << endl;
+	cout << "   -s string   auto       Prepare the client-side statements, or"
+		 << endl
+		 << "                          the stored function calls, and plan"
+		 << endl
+		 << "                          them auto, generic or custom, or off to"
+		 << endl
+		 << "                          send their text every time" << endl;
 	cout << "   -v                     Verbose output" << endl;
+	printf("   -w integer  %-9d  Worker threads\n", iWorkers);
 	cout << endl;
 }
 
+// Parse rates such as 0.01,TRADE_RESULT=1 into fCaptureRates: a rate alone
+// is for all the transaction types, the following ones name theirs.
+bool
+parseCaptureRates(char *rates)
+{
+	for (char *p = strtok(rates, ","); p != NULL; p = strtok(NULL, ",")) {
+		int iFirst = 0;
+		int iLast = TRADE_CLEANUP;
+		char *pRate = strchr(p, '=');
+		if (pRate != NULL) {
+			*pRate++ = '\0';
+			for (iFirst = 0; iFirst <= TRADE_CLEANUP; iFirst++) {
+				if (strcasecmp(p, szTransactionName[iFirst]) == 0)
+					break;
+			}
+			if (iFirst > TRADE_CLEANUP)
+				return false;
+			iLast = iFirst;
+		} else {
+			pRate = p;
+		}
+
+		char *end;
+		double fRate = strtod(pRate, &end);
+		if (end == pRate || *end != '\0' || fRate < 0 || fRate > 1)
+			return false;
+		for (int i = iFirst; i <= iLast; i++)
+			fCaptureRates[i] = fRate;
+	}
+	return true;
+}
+
 // Parse command line
 void
 parse_command_line(int argc, char *argv[])
@@ -54,6 +161,7 @@ parse_command_line(int argc, char *argv[])
 	int arg;
 	char *sp;
 	char *vp;
+	const char *path;
 
 	// Scan the command line arguments
 	for (arg = 1; arg < argc; ++arg) {
@@ -82,14 +190,45 @@ parse_command_line(int argc, char *argv[])
 		case '1':
 			iClientSide = 1;
 			break;
+		case 'a':
+			iTransactions = atoi(vp);
+			break;
+		case 'b':
+			bBinary = true;
+			break;
+		case 'B':
+			bCaptureBinary = true;
+			break;
+		case 'c':
+			iConnections = atoi(vp);
+			break;
+		case 'C':
+			for (eCapture = CAPTURE_OFF; eCapture < CAPTURE_RESULTS;
+					eCapture = (eCaptureLevel) (eCapture + 1)) {
+				if (strcmp(vp, szCapture[eCapture]) == 0)
+					break;
+			}
+			if (strcmp(vp, szCapture[eCapture]) != 0) {
+				usage();
+				cout << endl << "Error: Unknown capture level: " << vp << endl;
+				exit(1);
+			}
+			break;
 		case 'd': // Database name.
 			strncpy(szDBName, vp, iMaxDBName);
 			szDBName[iMaxDBName] = '\0';
 			break;
+		case 'e':
+			iReactors = atoi(vp);
+			break;
 		case 'h': // Database host name.
 			strncpy(szHost, vp, iMaxHostname);
 			szHost[iMaxHostname] = '\0';
 			break;
+		case 'L':
+			strncpy(szCaptureFile, vp, iMaxPath);
+			szCaptureFile[iMaxPath] = '\0';
+			break;
 		case 'm':
 			strncpy(szMEEHost, vp, iMaxHostname);
 			szMEEHost[iMaxHostname] = '\0';
@@ -106,12 +245,51 @@ parse_command_line(int argc, char *argv[])
 			strncpy(szDBPort, vp, iMaxPort);
 			szDBPort[iMaxPort] = '\0';
 			break;
+		case 'P':
+			bPipeline = true;
+			break;
 		case 'l':
-			iListenPort = atoi(vp);
+			if (CSocket::parseAddress(vp, &path) == TRANSPORT_TCP) {
+				iListenPort = atoi(vp);
+			} else {
+				strncpy(szListenAddress, vp, iMaxHostname);
+				szListenAddress[iMaxHostname] = '\0';
+			}
+			break;
+		case 'q':
+			iQueueDepth = atoi(vp);
+			break;
+		case 'r':
+			ePolicy = QUEUE_REJECT;
+			break;
+		case 'R':
+			iRetries = atoi(vp);
+			break;
+		case 'S':
+			if (!parseCaptureRates(vp)) {
+				usage();
+				cout << endl << "Error: Bad capture rates: " << vp << endl;
+				exit(1);
+			}
+			break;
+		case 's':
+			for (ePlans = PLAN_CACHE_AUTO; ePlans < PLAN_CACHE_OFF;
+					ePlans = (ePlanCache) (ePlans + 1)) {
+				if (strcmp(vp, szPlans[ePlans]) == 0)
+					break;
+			}
+			if (strcmp(vp, szPlans[ePlans]) != 0) {
+				usage();
+				cout << endl << "Error: Unknown plans: " << vp << endl;
+				exit(1);
+			}
 			break;
 		case 'v':
 			verbose = true;
 			break;
+		case 'w':
+			iWorkers = atoi(vp);
+			break;
 		default:
 			usage();
 			cout << endl << "Error: Unrecognized option: " << sp << endl;
@@ -130,6 +308,28 @@ main(int argc, char *argv[])
 
 	// Parse command line
 	parse_command_line(argc, argv);
+	if (iReactors < 1 || iWorkers < 1 || iTransactions < 0 || iConnections < 0
+			|| iQueueDepth < 0 || iRetries < 0) {
+		usage();
+		return 1;
+	}
+	if (bPipeline && !CDBConnection::pipelineSupported()) {
+		cerr << "ERROR: pipeline mode needs libpq 14 or later" << endl;
+		return 1;
+	}
+
+	// SIGUSR1 asks for the statistics files at once.  Only the thread
+	// writing them waits for it, every thread started from here on blocks
+	// it.
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	if (iTransactions > 0)
+		iConnections = iWorkers * iTransactions;
+	else if (iConnections == 0 || iConnections > iWorkers)
+		iConnections = iWorkers;
 
 	char *pidFilename = new char[1024];
 	snprintf(pidFilename, 1023, "%s/bh.pid", outputDirectory);
@@ -142,6 +342,10 @@ main(int argc, char *argv[])
 	fclose(fpid);
 	delete[] pidFilename;
 
+	if (szCaptureFile[0] == '\0')
+		snprintf(szCaptureFile, iMaxPath + 1, "%s/%s", outputDirectory,
+				bCaptureBinary ? CAPTURE_LOG_NAME : "capture.log");
+
 	// Let the user know what settings will be used.
 	cout << "Using the following database settings:" << endl
 		 << "  Database hostname: " << szHost << endl
@@ -151,29 +355,55 @@ main(int argc, char *argv[])
 	cout << "Using the following Market Exchange Emulator settings:" << endl
 		 << "  Hostname: " << szMEEHost << endl
 		 << "  Port: " << szMEEPort << endl;
-	
-	// 初始化异步线程池
-	spdlog::init_thread_pool(8192, 1);
 
-	// 定义日志文件的目标目录和文件名
-	string capture_dir = "/data/hwd/pg14.17/tpce-log/";
-	string file_name = "capture.log";
-	string full_capture_path = capture_dir + file_name;
+	cout << "Using the following worker settings:" << endl
+		 << "  Reactors: " << iReactors << endl
+		 << "  Workers: " << iWorkers << endl
+		 << "  Transactions per worker: "
+		 << (iTransactions > 0 ? iTransactions : 1) << endl
+		 << "  Pipeline mode: " << (bPipeline ? "on" : "off") << endl
+		 << "  Prepared statements: " << szPlans[ePlans] << endl
+		 << "  Retries: " << iRetries << endl
+		 << "  Results: " << (bBinary ? "binary" : "text") << endl
+		 << "  Capture: " << szCapture[eCapture];
+	if (eCapture != CAPTURE_OFF) {
+		cout << (bCaptureBinary ? " in binary" : "") << " to "
+			 << szCaptureFile << ", sampling";
+		for (int i = 0; i <= TRADE_CLEANUP; i++)
+			cout << " " << szTransactionName[i] << "=" << fCaptureRates[i];
+	}
+	cout << endl
+		 << "  Database connections: " << iConnections << endl
+		 << "  Queue depth: ";
+	if (iQueueDepth == 0)
+		cout << "unlimited" << endl;
+	else
+		cout << iQueueDepth << (ePolicy == QUEUE_REJECT ? ", reject" : "")
+			 << endl;
 
-	try {
-		auto logger = spdlog::rotating_logger_mt("file_logger", full_capture_path, 
-				1048576 * 10, 64);
-		
-		logger->set_pattern("%v");
-		spdlog::set_default_logger(logger);
-
-	} catch (const spdlog::spdlog_ex &ex) {
-		cout << "Log initialization failed: " << ex.what() << endl;
-        return (1);
+	// The statements are captured by a thread of their own, the workers
+	// only queue them.
+	if (eCapture != CAPTURE_OFF && bCaptureBinary) {
+		CCaptureLog::open(szCaptureFile, eCapture);
+	} else if (eCapture != CAPTURE_OFF) {
+		spdlog::init_thread_pool(8192, 1);
+		try {
+			auto logger
+					= spdlog::rotating_logger_mt<spdlog::async_factory>(
+							"file_logger", szCaptureFile, 1048576 * 10, 64);
+			logger->set_pattern("%v");
+			spdlog::set_default_logger(logger);
+		} catch (const spdlog::spdlog_ex &ex) {
+			cout << "Log initialization failed: " << ex.what() << endl;
+			return (1);
+		}
 	}
 
 	CBrokerageHouse BrokerageHouse(szHost, szDBName, szDBPort, szMEEHost,
-			szMEEPort, iListenPort, outputDirectory, iClientSide, verbose);
+			szMEEPort, iListenPort, szListenAddress, outputDirectory,
+			iClientSide, iReactors, iWorkers, iTransactions, iConnections,
+			iQueueDepth, ePolicy, bPipeline, ePlans, iRetries, bBinary,
+			eCapture, fCaptureRates, verbose);
 	cout << "Brokerage House opened for business, waiting for traders..."
 		 << endl;
 	try {
@@ -197,6 +427,7 @@ main(int argc, char *argv[])
 
 	pthread_exit(NULL);
 
+	CCaptureLog::close();
 	spdlog::shutdown();
 
 	cout << "Brokerage House closed for business" << endl;
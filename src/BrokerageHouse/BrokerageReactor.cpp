@@ -0,0 +1,341 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * A connection is read until nothing is left each time epoll reports it,
+ * into a buffer of its own from which the complete messages are taken: the
+ * hello, answered right away, then the requests, each copied into its own
+ * queue entry.  The socket stays blocking, only the reads are not, so that
+ * the workers can send the replies with the usual calls.
+ *
+ * A request that finds the queue full is left in the buffer and the
+ * connection is no longer read, the others go on.  It is queued, and the
+ * connection read again, once the queue has room.
+ */
+
+#include <time.h>
+#include <sys/epoll.h>
+
+#include "BrokerageReactor.h"
+#include "BrokerageHouse.h"
+
+#define BH_REACTOR_MAX_EVENTS 256
+// How often the shared-memory connections are read without their doorbell.
+#define BH_REACTOR_SWEEP_MS 100
+
+static long long
+monotonicMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// reactor thread
+void *
+brokerageReactorThread(void *data)
+{
+	CBrokerageReactor *pReactor = reinterpret_cast<CBrokerageReactor *>(data);
+	pReactor->run();
+	return NULL;
+}
+
+// Constructor
+CBrokerageReactor::CBrokerageReactor(CBrokerageHouse *pBrokerageHouse)
+: m_pBrokerageHouse(pBrokerageHouse), m_llLastSweep(monotonicMs())
+{
+	m_iRoomFd = pBrokerageHouse->m_RequestQueue.roomFd();
+	m_epfd = epoll_create1(0);
+	if (m_epfd == -1) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+				"CBrokerageReactor::CBrokerageReactor");
+	}
+
+	if (pthread_create(&m_tid, NULL, &brokerageReactorThread,
+				reinterpret_cast<void *>(this))
+			!= 0) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+				"CBrokerageReactor::CBrokerageReactor");
+	}
+	pthread_detach(m_tid);
+}
+
+void
+CBrokerageReactor::addConnection(int iSockfd)
+{
+	CBrokerageConnection *pConnection = new CBrokerageConnection(iSockfd);
+
+	// Data that came before the connection was added is reported as well.
+	struct epoll_event ev;
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	ev.data.ptr = pConnection;
+	if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, iSockfd, &ev) == -1) {
+		pConnection->release();
+		throw new CSocketErr(CSocketErr::ERR_SOCKET_ACCEPT,
+				"CBrokerageReactor::addConnection");
+	}
+}
+
+// Stop reading the connection.  It is closed once the requests it still has
+// queued are answered.
+void
+CBrokerageReactor::closeConnection(CBrokerageConnection *pConnection)
+{
+	epoll_ctl(m_epfd, EPOLL_CTL_DEL, pConnection->m_Socket.getSocketFd(),
+			NULL);
+	if (pConnection->m_bChannel) {
+		for (size_t i = 0; i < m_Channels.size(); i++) {
+			if (m_Channels[i] == pConnection) {
+				m_Channels[i] = m_Channels.back();
+				m_Channels.pop_back();
+				break;
+			}
+		}
+	}
+	pConnection->release();
+}
+
+// Take the complete messages at the start of the buffer.  The first message
+// on a connection is either a hello offering the framed protocol, or a whole
+// request from a driver that predates it.  Return false on a protocol error.
+bool
+CBrokerageReactor::parse(CBrokerageConnection *pConnection)
+{
+	char *data = pConnection->m_Buffer;
+	size_t used = 0;
+	while (used < pConnection->m_iReceived) {
+		char *message = data + used;
+		size_t available = pConnection->m_iReceived - used;
+
+		if (pConnection->m_iWireVersion == WIRE_VERSION_UNKNOWN) {
+			INT32 iMagic;
+			if (available < sizeof(iMagic))
+				break;
+			memcpy(&iMagic, message, sizeof(iMagic));
+			if (iMagic != WIRE_MAGIC) {
+				pConnection->m_iWireVersion = WIRE_VERSION_LEGACY;
+				continue;
+			}
+
+			TMsgHello Hello;
+			if (available < sizeof(Hello))
+				break;
+			memcpy(&Hello, message, sizeof(Hello));
+			used += sizeof(Hello);
+
+			TMsgHelloReply Reply;
+			Reply.iMagic = WIRE_MAGIC;
+			Reply.iVersion = Hello.iVersion < WIRE_VERSION ? Hello.iVersion
+														   : WIRE_VERSION;
+			pConnection->m_iWireVersion = Reply.iVersion;
+			try {
+				pConnection->send(
+						reinterpret_cast<void *>(&Reply), sizeof(Reply));
+			} catch (CSocketErr *pErr) {
+				delete pErr;
+				return false;
+			}
+			continue;
+		}
+
+		PBrokerageRequest pRequest;
+		size_t size;
+		if (pConnection->m_iWireVersion == WIRE_VERSION_LEGACY) {
+			if (available < sizeof(TMsgDriverBrokerage))
+				break;
+			pRequest = new TBrokerageRequest;
+			memcpy(&pRequest->Message, message, sizeof(TMsgDriverBrokerage));
+			pRequest->iRequestId = 0;
+			size = sizeof(TMsgDriverBrokerage);
+		} else {
+			TMsgHeader Header;
+			size_t iHeaderSize = wireHeaderSize(pConnection->m_iWireVersion);
+			if (available < iHeaderSize)
+				break;
+			memset(&Header, 0, sizeof(Header));
+			memcpy(&Header, message, iHeaderSize);
+			size_t length = txnInputSize(Header.iTxnType);
+			if (Header.iVersion != pConnection->m_iWireVersion || length == 0
+					|| Header.iLength != length) {
+				m_pBrokerageHouse->logErrorMessage(
+						"Error on Receive: malformed request at "
+						"CBrokerageReactor::parse\n");
+				return false;
+			}
+			if (available < iHeaderSize + length)
+				break;
+
+			pRequest = new TBrokerageRequest;
+			memset(&pRequest->Message, 0, sizeof(TMsgDriverBrokerage));
+			pRequest->Message.TxnType = (eTxnType) Header.iTxnType;
+			memcpy(&pRequest->Message.TxnInput, message + iHeaderSize, length);
+			pRequest->iRequestId = Header.iRequestId;
+			size = iHeaderSize + length;
+		}
+		// Otherwise the request is taken from the buffer again later.
+		if (!queueRequest(pConnection, pRequest)) {
+			stall(pConnection);
+			break;
+		}
+		used += size;
+	}
+
+	memmove(data, data + used, pConnection->m_iReceived - used);
+	pConnection->m_iReceived -= used;
+	return true;
+}
+
+// Return false, having dropped the request, if there is no room for it.
+bool
+CBrokerageReactor::queueRequest(
+		CBrokerageConnection *pConnection, PBrokerageRequest pRequest)
+{
+	pRequest->pConnection = pConnection;
+	// Time the parts of the transaction only when the driver asked for them.
+	pRequest->llReceived = pConnection->m_iWireVersion >= WIRE_VERSION_TIMED
+			? serverClockNs()
+			: 0;
+	pConnection->acquire();
+	if (m_pBrokerageHouse->queueRequest(pRequest))
+		return true;
+	pConnection->release();
+	delete pRequest;
+	return false;
+}
+
+// Read and queue whatever the connection sent.  Return false once it is
+// closed or broken.
+bool
+CBrokerageReactor::receive(CBrokerageConnection *pConnection)
+{
+	while (!pConnection->m_bStalled) {
+		size_t space
+				= sizeof(pConnection->m_Buffer) - pConnection->m_iReceived;
+		int received;
+		try {
+			received = pConnection->m_Socket.dbt5ReceiveAvailable(
+					pConnection->m_Buffer + pConnection->m_iReceived, space);
+		} catch (CSocketErr *pErr) {
+			if (pErr->getAction() != CSocketErr::ERR_SOCKET_CLOSED) {
+				ostringstream osErr;
+				osErr << "Error on Receive: " << pErr->ErrorText()
+					  << " at CBrokerageReactor::receive" << endl;
+				m_pBrokerageHouse->logErrorMessage(osErr.str());
+			}
+			delete pErr;
+			return false;
+		}
+
+		// The first read tells whether a Unix-domain client set up a
+		// shared-memory channel.
+		if (!pConnection->m_bChannel
+				&& pConnection->m_Socket.getTransport() == TRANSPORT_SHM) {
+			pConnection->m_bChannel = true;
+			m_Channels.push_back(pConnection);
+		}
+
+		pConnection->m_iReceived += received;
+		if (!parse(pConnection))
+			return false;
+		if ((size_t) received < space)
+			return true;
+	}
+	return true;
+}
+
+// Queue the requests the stalled connections were left with, and read again
+// those that have no more.
+void
+CBrokerageReactor::resume()
+{
+	std::vector<CBrokerageConnection *> stalled;
+	stalled.swap(m_Stalled);
+	epoll_ctl(m_epfd, EPOLL_CTL_DEL, m_iRoomFd, NULL);
+
+	for (size_t i = 0; i < stalled.size(); i++) {
+		CBrokerageConnection *pConnection = stalled[i];
+		pConnection->m_bStalled = false;
+		if (!parse(pConnection)) {
+			closeConnection(pConnection);
+			continue;
+		}
+		if (pConnection->m_bStalled)
+			continue;
+
+		// What came meanwhile is reported again.
+		struct epoll_event ev;
+		ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+		ev.data.ptr = pConnection;
+		epoll_ctl(m_epfd, EPOLL_CTL_MOD, pConnection->m_Socket.getSocketFd(),
+				&ev);
+		if (!receive(pConnection))
+			closeConnection(pConnection);
+	}
+}
+
+void
+CBrokerageReactor::run()
+{
+	struct epoll_event events[BH_REACTOR_MAX_EVENTS];
+	while (true) {
+		int n = epoll_wait(m_epfd, events, BH_REACTOR_MAX_EVENTS,
+				m_Channels.empty() ? -1 : BH_REACTOR_SWEEP_MS);
+		if (n == -1 && errno != EINTR) {
+			m_pBrokerageHouse->logErrorMessage(
+					"epoll_wait failed at CBrokerageReactor::run\n");
+			return;
+		}
+
+		for (int i = 0; i < n; i++) {
+			CBrokerageConnection *pConnection
+					= reinterpret_cast<CBrokerageConnection *>(
+							events[i].data.ptr);
+			if (pConnection == NULL)
+				resume();
+			else if (!receive(pConnection))
+				closeConnection(pConnection);
+		}
+
+		if (!m_Channels.empty()
+				&& monotonicMs() - m_llLastSweep >= BH_REACTOR_SWEEP_MS)
+			sweep();
+	}
+}
+
+// Stop reading the connection until there is room in the queue.
+void
+CBrokerageReactor::stall(CBrokerageConnection *pConnection)
+{
+	pConnection->m_bStalled = true;
+
+	// Only a hang up or an error is still reported, and ignored.
+	struct epoll_event ev;
+	ev.events = EPOLLET;
+	ev.data.ptr = pConnection;
+	epoll_ctl(m_epfd, EPOLL_CTL_MOD, pConnection->m_Socket.getSocketFd(),
+			&ev);
+
+	if (m_Stalled.empty()) {
+		ev.events = EPOLLIN;
+		ev.data.ptr = NULL;
+		epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_iRoomFd, &ev);
+	}
+	m_Stalled.push_back(pConnection);
+}
+
+void
+CBrokerageReactor::sweep()
+{
+	m_llLastSweep = monotonicMs();
+	for (size_t i = 0; i < m_Channels.size();) {
+		CBrokerageConnection *pConnection = m_Channels[i];
+		if (receive(pConnection)) {
+			i++;
+			continue;
+		}
+		// Closing moves the last connection into this slot.
+		closeConnection(pConnection);
+	}
+}
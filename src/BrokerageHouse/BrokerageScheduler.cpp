@@ -0,0 +1,193 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * The transactions are switched with swapcontext(), only from inside
+ * CDBConnection, which sends each statement and waits for its results, or
+ * for the timer of a retry backoff, through wait().  Everything else a
+ * transaction does, such as sending to the Market Exchange Emulator or
+ * replying to the driver, still blocks the worker.
+ */
+
+#include <poll.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "BrokerageScheduler.h"
+#include "BrokerageHouse.h"
+#include "BrokerageSession.h"
+
+// Stack of each transaction, only the pages used are ever touched.
+#define BH_FIBER_STACK (1024 * 1024)
+
+// worker thread
+void *
+brokerageSchedulerThread(void *data)
+{
+	CBrokerageScheduler *pScheduler
+			= reinterpret_cast<CBrokerageScheduler *>(data);
+	pScheduler->run();
+	return NULL;
+}
+
+// makecontext() only passes ints, the scheduler comes in two halves.
+void
+brokerageFiber(unsigned int iHigh, unsigned int iLow)
+{
+	uintptr_t p = ((uintptr_t) iHigh << 16 << 16) | iLow;
+	reinterpret_cast<CBrokerageScheduler *>(p)->fiber();
+}
+
+// Constructor
+CBrokerageScheduler::CBrokerageScheduler(
+		CBrokerageHouse *pBrokerageHouse, int iTransactions)
+: m_pBrokerageHouse(pBrokerageHouse), m_Fibers(iTransactions),
+  m_pCurrent(NULL), m_iRunning(0)
+{
+	for (size_t i = 0; i < m_Fibers.size(); i++) {
+		m_Fibers[i].pStack = NULL;
+		m_Fibers[i].pSession = NULL;
+		m_Fibers[i].pRequest = NULL;
+	}
+
+	if (pthread_create(&m_tid, NULL, &brokerageSchedulerThread,
+				reinterpret_cast<void *>(this))
+			!= 0) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+				"CBrokerageScheduler::CBrokerageScheduler");
+	}
+	pthread_detach(m_tid);
+}
+
+// Body of every fiber: serve the request it was given, then go back to the
+// scheduler until the next one.
+void
+CBrokerageScheduler::fiber()
+{
+	PFiber pFiber = m_pCurrent;
+	while (true) {
+		if (pFiber->pSession == NULL) {
+			try {
+				pFiber->pSession = m_pBrokerageHouse->newSession();
+				pFiber->pSession->m_pDBConnection->setWait(this);
+			} catch (CSocketErr *pErr) {
+				m_pBrokerageHouse->failRequest(pFiber->pRequest, pErr);
+			}
+		}
+		if (pFiber->pSession != NULL)
+			m_pBrokerageHouse->serveRequest(
+					pFiber->pRequest, pFiber->pSession);
+
+		pFiber->pRequest = NULL;
+		--m_iRunning;
+		swapcontext(&pFiber->Context, &m_Context);
+	}
+}
+
+// Run the fiber until it waits or is done.
+void
+CBrokerageScheduler::resume(PFiber pFiber)
+{
+	m_pCurrent = pFiber;
+	swapcontext(&m_Context, &pFiber->Context);
+	m_pCurrent = NULL;
+}
+
+void
+CBrokerageScheduler::run()
+{
+	CRequestQueue &Queue = m_pBrokerageHouse->m_RequestQueue;
+	int iReadyFd = Queue.readyFd();
+	std::vector<struct pollfd> fds;
+	std::vector<PFiber> waiting;
+
+	while (true) {
+		// Take new requests while some fibers are idle, waiting for one only
+		// when there is nothing else to do.
+		while (m_iRunning < (int) m_Fibers.size()) {
+			PBrokerageRequest pRequest
+					= m_iRunning == 0 ? Queue.pop() : Queue.tryPop();
+			if (pRequest == NULL)
+				break;
+			start(pRequest);
+		}
+		if (m_iRunning == 0)
+			continue;
+
+		fds.clear();
+		waiting.clear();
+		for (size_t i = 0; i < m_Fibers.size(); i++) {
+			if (m_Fibers[i].pRequest == NULL)
+				continue;
+			struct pollfd fd = { m_Fibers[i].iSockfd, m_Fibers[i].iEvents, 0 };
+			fds.push_back(fd);
+			waiting.push_back(&m_Fibers[i]);
+		}
+		if (m_iRunning < (int) m_Fibers.size()) {
+			struct pollfd fd = { iReadyFd, POLLIN, 0 };
+			fds.push_back(fd);
+		}
+
+		if (poll(&fds[0], fds.size(), -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			m_pBrokerageHouse->logErrorMessage(
+					"poll failed at CBrokerageScheduler::run\n");
+			return;
+		}
+		for (size_t i = 0; i < waiting.size(); i++) {
+			if (fds[i].revents != 0)
+				resume(waiting[i]);
+		}
+	}
+}
+
+// Give the request to an idle fiber and run it until it first waits.
+void
+CBrokerageScheduler::start(PBrokerageRequest pRequest)
+{
+	PFiber pFiber = NULL;
+	for (size_t i = 0; i < m_Fibers.size(); i++) {
+		if (m_Fibers[i].pRequest == NULL) {
+			pFiber = &m_Fibers[i];
+			break;
+		}
+	}
+
+	if (pFiber->pStack == NULL) {
+		// The lowest page is left out to catch an overflow.
+		void *pStack = mmap(NULL, BH_FIBER_STACK, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1,
+				0);
+		if (pStack == MAP_FAILED) {
+			throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+					"CBrokerageScheduler::start");
+		}
+		mprotect(pStack, getpagesize(), PROT_NONE);
+		pFiber->pStack = reinterpret_cast<char *>(pStack);
+
+		uintptr_t p = reinterpret_cast<uintptr_t>(this);
+		getcontext(&pFiber->Context);
+		pFiber->Context.uc_stack.ss_sp = pFiber->pStack;
+		pFiber->Context.uc_stack.ss_size = BH_FIBER_STACK;
+		pFiber->Context.uc_link = NULL;
+		makecontext(&pFiber->Context, (void (*)()) brokerageFiber, 2,
+				(unsigned int) (p >> 16 >> 16), (unsigned int) p);
+	}
+
+	pFiber->pRequest = pRequest;
+	++m_iRunning;
+	resume(pFiber);
+}
+
+// Go back to the scheduler until the socket is ready.
+void
+CBrokerageScheduler::wait(int iSockfd, bool bWrite)
+{
+	PFiber pFiber = m_pCurrent;
+	pFiber->iSockfd = iSockfd;
+	pFiber->iEvents = bWrite ? POLLOUT : POLLIN;
+	swapcontext(&pFiber->Context, &m_Context);
+}
@@ -0,0 +1,46 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ */
+
+#include "BrokerageSession.h"
+
+// Constructor, connects to the Market Exchange Emulator.
+CBrokerageSession::CBrokerageSession(CDBConnection *pDBConnection,
+		ofstream *pfLog, char *szMEEHost, int iMEEPort, bool bVerbose)
+: m_pDBConnection(pDBConnection), m_SendToMarket(pfLog, szMEEHost, iMEEPort),
+  m_BrokerVolumeDB(pDBConnection, bVerbose), m_BrokerVolume(&m_BrokerVolumeDB),
+  m_CustomerPositionDB(pDBConnection, bVerbose),
+  m_CustomerPosition(&m_CustomerPositionDB),
+  m_DataMaintenanceDB(pDBConnection, bVerbose),
+  m_DataMaintenance(&m_DataMaintenanceDB),
+  m_MarketFeedDB(pDBConnection, bVerbose),
+  m_MarketFeed(&m_MarketFeedDB, &m_SendToMarket),
+  m_MarketWatchDB(pDBConnection, bVerbose), m_MarketWatch(&m_MarketWatchDB),
+  m_SecurityDetailDB(pDBConnection, bVerbose),
+  m_SecurityDetail(&m_SecurityDetailDB),
+  m_TradeCleanupDB(pDBConnection, bVerbose), m_TradeCleanup(&m_TradeCleanupDB),
+  m_TradeLookupDB(pDBConnection, bVerbose), m_TradeLookup(&m_TradeLookupDB),
+  m_TradeOrderDB(pDBConnection, bVerbose),
+  m_TradeOrder(&m_TradeOrderDB, &m_SendToMarket),
+  m_TradeResultDB(pDBConnection, bVerbose), m_TradeResult(&m_TradeResultDB),
+  m_TradeStatusDB(pDBConnection, bVerbose), m_TradeStatus(&m_TradeStatusDB),
+  m_TradeUpdateDB(pDBConnection, bVerbose), m_TradeUpdate(&m_TradeUpdateDB)
+{
+}
+
+// Destructor
+CBrokerageSession::~CBrokerageSession()
+{
+	delete m_pDBConnection;
+}
+
+// Time the parts of the next transaction into pTimes, or not if NULL.
+void
+CBrokerageSession::setServerTimes(PMsgServerTimes pTimes)
+{
+	m_pDBConnection->setServerTimes(pTimes);
+	m_SendToMarket.setServerTimes(pTimes);
+}
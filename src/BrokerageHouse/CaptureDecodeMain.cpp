@@ -0,0 +1,166 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Convert a binary capture of the Brokerage House into its text capture,
+ * one statement per line.
+ */
+
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "CaptureReader.h"
+#include "DBResult.h"
+
+using namespace std;
+
+void
+usage()
+{
+	cout << "Usage: CaptureDecode <capture.bin> [capture.log]" << endl
+		 << endl
+		 << "Writes to standard output when no output file is given." << endl;
+}
+
+static void
+writeSql(ostream &out, const char *sql)
+{
+	for (const char *p = sql; *p != '\0'; p++)
+		out << (*p == '\n' ? ' ' : *p);
+}
+
+static bool
+writeParams(ostream &out, CRecordReader &reader)
+{
+	UINT16 nParams = reader.number<UINT16>();
+	if (nParams == 0)
+		return !reader.failed();
+
+	out << "[para=";
+	for (UINT16 i = 0; i < nParams; i++) {
+		uint8_t kind = reader.number<uint8_t>();
+		reader.number<UINT32>(); // type
+		INT32 length;
+		const char *value = reader.value(&length);
+		if (reader.failed())
+			return false;
+
+		if (value == NULL)
+			out << "NULL";
+		else if (kind == CAPTURE_PARAM_BINARY)
+			out << binary_to_int(value, length);
+		// A value replaced is quoted like text if it is an array.
+		else if (kind == CAPTURE_PARAM_REPLACED
+				&& memchr(value, ',', length) == NULL)
+			out.write(value, length);
+		else
+			out << "'" << string(value, length) << "'";
+		if (i < nParams - 1)
+			out << ",";
+	}
+	out << "]";
+	return true;
+}
+
+static bool
+writeResults(ostream &out, CRecordReader &reader)
+{
+	uint8_t kind = reader.number<uint8_t>();
+	INT32 length;
+	const char *value;
+
+	switch (kind) {
+	case CAPTURE_RESULT_COMMAND:
+		value = reader.value(&length);
+		out << "[res=";
+		if (value != NULL)
+			out.write(value, length);
+		out << "]";
+		break;
+	case CAPTURE_RESULT_TUPLES: {
+		UINT32 nRows = reader.number<UINT32>();
+		UINT16 nFields = reader.number<UINT16>();
+		vector<Oid> types(nFields);
+		vector<uint8_t> formats(nFields);
+		for (UINT16 j = 0; j < nFields; j++) {
+			types[j] = reader.number<UINT32>();
+			formats[j] = reader.number<uint8_t>();
+		}
+		for (UINT32 i = 0; i < nRows && !reader.failed(); i++) {
+			out << "[res=";
+			for (UINT16 j = 0; j < nFields; j++) {
+				value = reader.value(&length);
+				if (value != NULL && formats[j] == 1)
+					writeBinaryValue(out, types[j], value, length);
+				else if (value != NULL)
+					out.write(value, length);
+				if (j < nFields - 1)
+					out << ",";
+			}
+			out << "]";
+		}
+		break;
+	}
+	}
+	return !reader.failed();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc < 2 || argc > 3) {
+		usage();
+		return 1;
+	}
+
+	CCaptureReader capture;
+	if (!capture.open(argv[1]))
+		return 1;
+
+	ofstream file;
+	if (argc == 3) {
+		file.open(argv[2], ios::out);
+		if (!file.is_open()) {
+			cerr << "cannot create " << argv[2] << endl;
+			return 1;
+		}
+	}
+	ostream &out = argc == 3 ? file : cout;
+
+	TCaptureRecord record;
+	CRecordReader reader;
+	while (capture.next(&record, &reader)) {
+		out << "[timestamp=" << record.llStart / 1000000
+			<< "][connId=" << record.iPid << "][sql=";
+		if (record.iKind == CAPTURE_RECORD_COMMAND) {
+			writeSql(out, reader.text());
+			out << "]";
+			const char *name = reader.text();
+			if (name[0] != '\0')
+				out << "[name=" << name << "]";
+		} else if (record.iStatement == 0) {
+			writeSql(out, reader.text());
+			out << "]";
+		} else {
+			const char *sql = capture.statement(record.iStatement);
+			if (sql == NULL) {
+				cerr << "undefined statement " << record.iStatement << endl;
+				return 1;
+			}
+			writeSql(out, sql);
+			out << "]";
+		}
+		if (record.iKind == CAPTURE_RECORD_EXEC
+				&& !(writeParams(out, reader) && writeResults(out, reader))) {
+			cerr << "bad record at " << capture.offset() << endl;
+			return 1;
+		}
+		out << '\n';
+	}
+
+	return 0;
+}
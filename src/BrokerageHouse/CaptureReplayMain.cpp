@@ -0,0 +1,752 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Run the statements of a capture of the Brokerage House again, text or
+ * binary, without the Driver and the Market Exchange Emulator.  The
+ * statements of each connection of the capture are replayed in their order,
+ * a transaction from its BEGIN to its COMMIT or ROLLBACK, as fast as possible
+ * or at the pace they were captured at, and the response times are reported
+ * by transaction.
+ */
+
+#include <ctype.h>
+#include <pthread.h>
+#include <time.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <libpq-fe.h>
+
+#include "CaptureReader.h"
+#include "DBResult.h"
+#include "DBT5Consts.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+char szHost[iMaxHostname + 1] = "";
+char szDBName[iMaxDBName + 1] = "";
+char szDBPort[iMaxPort + 1] = "";
+int iConnections = 0; // one per connection of the capture
+bool bPaced = false;
+double fSpeed = 1;
+bool bPrepare = true;
+
+// A statement or transaction control, with its parameters.
+typedef struct TReplayStatement
+{
+	INT64 llStart; // microseconds since the epoch
+	INT64 llEnd; // 0 unless captured in binary
+	INT64 llSequence;
+	UINT32 iSql;
+	// Of the transaction, from a BEGIN or the name of a statement of the
+	// lists, 0 if unknown.
+	UINT32 iName;
+	size_t iFirstParam;
+	UINT16 nParams;
+} *PReplayStatement;
+
+// The parameters of every statement, as text ended by a NUL in paramData.
+typedef struct TReplayParam
+{
+	size_t iOffset; // in paramData
+	bool bNull;
+	Oid type; // 0 for PostgreSQL to infer
+} *PReplayParam;
+
+// Statements from a BEGIN to its COMMIT or ROLLBACK, or one outside a
+// transaction.
+typedef struct TReplayTransaction
+{
+	INT64 llStart;
+	const TReplayStatement *pFirst;
+	UINT32 nStatements;
+	UINT32 iName;
+} *PReplayTransaction;
+
+// Response times of the transactions of a name, in nanoseconds.
+class CReplayStats
+{
+public:
+	CLatencyHistogram histogram;
+	UINT64 errors;
+	INT64 llTotal;
+	// Microseconds the transactions took when they were captured.
+	INT64 llCaptured;
+	UINT64 nCaptured;
+
+	CReplayStats(): errors(0), llTotal(0), llCaptured(0), nCaptured(0) {}
+
+	void
+	merge(const CReplayStats &stats)
+	{
+		histogram.merge(stats.histogram);
+		errors += stats.errors;
+		llTotal += stats.llTotal;
+		llCaptured += stats.llCaptured;
+		nCaptured += stats.nCaptured;
+	}
+};
+
+typedef struct TReplayWorker
+{
+	pthread_t tid;
+	PGconn *pConn;
+	vector<TReplayTransaction> transactions;
+	vector<CReplayStats> stats; // by name
+	CLatencyHistogram statements;
+	UINT64 statementErrors;
+	INT64 llLate; // the most a statement started behind the capture
+	vector<bool> prepared; // by statement
+	vector<const char *> values;
+	vector<Oid> types;
+} *PReplayWorker;
+
+vector<string> sqls;
+unordered_map<string, UINT32> sqlIds;
+vector<string> names;
+map<string, UINT32> nameIds;
+string paramData;
+vector<TReplayParam> params;
+// The statements of each connection of the capture, by backend.
+map<INT32, vector<TReplayStatement> > streams;
+INT64 llCaptureStart = 0;
+long long llReplayStart = 0;
+
+void
+usage()
+{
+	cout << "Usage: CaptureReplay [options] <capture.bin|capture.log>"
+		 << endl
+		 << endl;
+	cout << "   Option      Default    Description" << endl;
+	cout << "   =========   =========  ===============" << endl;
+	cout << "   -c integer  captured   Database connections, by default one"
+		 << endl
+		 << "                          per connection of the capture" << endl;
+	cout << "   -d string              Database name" << endl;
+	cout << "   -h string   localhost  Database server" << endl;
+	cout << "   -p integer             Database port" << endl;
+	cout << "   -r                     Keep the pace of the capture, instead"
+		 << endl
+		 << "                          of running as fast as possible, to"
+		 << endl
+		 << "                          the second for a text capture" << endl;
+	cout << "   -s float    1          Speed-up of the pace kept" << endl;
+	cout << "   -u                     Send the text of the statements with"
+		 << endl
+		 << "                          parameters every time, instead of"
+		 << endl
+		 << "                          preparing them on each connection"
+		 << endl;
+	cout << endl
+		 << "The statements must have been captured with their parameters."
+		 << endl;
+}
+
+static long long
+monotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static UINT32
+intern(unordered_map<string, UINT32> &ids, vector<string> &values,
+		const string &value)
+{
+	unordered_map<string, UINT32>::const_iterator it = ids.find(value);
+	if (it != ids.end())
+		return it->second;
+	UINT32 id = values.size();
+	ids[value] = id;
+	values.push_back(value);
+	return id;
+}
+
+static UINT32
+nameId(const string &name)
+{
+	map<string, UINT32>::const_iterator it = nameIds.find(name);
+	if (it != nameIds.end())
+		return it->second;
+	UINT32 id = names.size();
+	nameIds[name] = id;
+	names.push_back(name);
+	return id;
+}
+
+static void
+addParam(const char *value, INT32 length, Oid type)
+{
+	TReplayParam param;
+	param.iOffset = paramData.size();
+	param.bNull = value == NULL;
+	param.type = type;
+	if (value != NULL)
+		paramData.append(value, length);
+	paramData.push_back('\0');
+	params.push_back(param);
+}
+
+static bool
+startsWith(const string &text, const char *prefix)
+{
+	return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Whether the text of a statement has parameters.
+static bool
+hasParams(const string &sql)
+{
+	for (size_t i = sql.find('$'); i != string::npos;
+			i = sql.find('$', i + 1)) {
+		if (i + 1 < sql.size() && isdigit((unsigned char) sql[i + 1]))
+			return true;
+	}
+	return false;
+}
+
+// The transaction a statement of the lists is for, from the start of its
+// name: TO for TOF1Q1.
+static string
+transactionName(const char *statement)
+{
+	const char *p = statement;
+	while (*p != '\0' && !(p[0] == 'F' && isdigit((unsigned char) p[1])))
+		p++;
+	return *p != '\0' && p != statement ? string(statement, p) : string();
+}
+
+static bool
+loadBinary(const char *filename)
+{
+	CCaptureReader capture;
+	if (!capture.open(filename))
+		return false;
+	if (capture.header()->iLevel < CAPTURE_PARAMS) {
+		cerr << filename << " was captured without the parameters" << endl;
+		return false;
+	}
+
+	// The statements of the lists, by their identifier, and the
+	// transactions they are for.
+	map<UINT32, UINT32> ids;
+	map<UINT32, UINT32> transactionIds;
+	TCaptureRecord record;
+	CRecordReader reader;
+	while (capture.next(&record, &reader)) {
+		TReplayStatement statement;
+		statement.llStart = record.llStart;
+		statement.llEnd = record.llStart + record.llDuration;
+		statement.llSequence = record.llSequence;
+		statement.iName = 0;
+		statement.iFirstParam = params.size();
+		statement.nParams = 0;
+
+		if (record.iKind == CAPTURE_RECORD_COMMAND) {
+			statement.iSql = intern(sqlIds, sqls, reader.text());
+			const char *name = reader.text();
+			statement.iName = name[0] != '\0' ? nameId(name) : 0;
+		} else if (record.iStatement == 0) {
+			statement.iSql = intern(sqlIds, sqls, reader.text());
+		} else {
+			map<UINT32, UINT32>::const_iterator it
+					= ids.find(record.iStatement);
+			if (it == ids.end()) {
+				const char *sql = capture.statement(record.iStatement);
+				if (sql == NULL) {
+					cerr << "undefined statement " << record.iStatement
+						 << endl;
+					return false;
+				}
+				string name = transactionName(
+						capture.statementName(record.iStatement));
+				ids[record.iStatement] = intern(sqlIds, sqls, sql);
+				transactionIds[record.iStatement]
+						= name.empty() ? 0 : nameId(name);
+				it = ids.find(record.iStatement);
+			}
+			statement.iSql = it->second;
+			statement.iName = transactionIds[record.iStatement];
+		}
+
+		if (record.iKind == CAPTURE_RECORD_EXEC) {
+			statement.nParams = reader.number<UINT16>();
+			for (UINT16 i = 0; i < statement.nParams; i++) {
+				uint8_t kind = reader.number<uint8_t>();
+				Oid type = reader.number<UINT32>();
+				INT32 length;
+				const char *value = reader.value(&length);
+				if (value != NULL && kind == CAPTURE_PARAM_BINARY) {
+					string text = binary_to_int(value, length);
+					addParam(text.data(), text.size(), type);
+				} else {
+					addParam(value, length, type);
+				}
+			}
+		}
+		if (reader.failed()) {
+			cerr << "bad record at " << capture.offset() << endl;
+			return false;
+		}
+		streams[record.iPid].push_back(statement);
+	}
+	return true;
+}
+
+// Parameters of a text capture, from after [para= to its closing bracket:
+// NULL, a value between quotes, or one logged without them.
+static bool
+parseParams(const string &line, size_t i, TReplayStatement *pStatement)
+{
+	while (i < line.size()) {
+		size_t end;
+		if (line.compare(i, 4, "NULL") == 0
+				&& (line[i + 4] == ',' || line[i + 4] == ']')) {
+			addParam(NULL, 0, 0);
+			end = i + 4;
+		} else if (line[i] == '\'') {
+			// A quote within a value is only taken for its end when a
+			// separator follows it.
+			end = i + 1;
+			while ((end = line.find('\'', end)) != string::npos
+					&& end + 1 < line.size() && line[end + 1] != ','
+					&& line[end + 1] != ']') {
+				end++;
+			}
+			if (end == string::npos || end + 1 >= line.size())
+				return false;
+			addParam(line.data() + i + 1, end - i - 1, 0);
+			end++;
+		} else {
+			end = line.find_first_of(",]", i);
+			if (end == string::npos)
+				return false;
+			addParam(line.data() + i, end - i, 0);
+		}
+		pStatement->nParams++;
+		if (line[end] == ']')
+			return true;
+		i = end + 1;
+	}
+	return false;
+}
+
+static bool
+loadText(const char *filename)
+{
+	ifstream file(filename);
+	if (!file.is_open()) {
+		cerr << "cannot open " << filename << endl;
+		return false;
+	}
+
+	static const char *szEnds[] = { "][para=", "][res=", "][name=" };
+	string line;
+	INT64 llLine = 0;
+	while (getline(file, line)) {
+		llLine++;
+		size_t timestamp = line.find("[timestamp=");
+		size_t connId = line.find("][connId=", timestamp);
+		size_t sql = line.find("][sql=", connId);
+		if (timestamp == string::npos || connId == string::npos
+				|| sql == string::npos) {
+			continue;
+		}
+		sql += 6;
+
+		size_t end = string::npos;
+		for (int i = 0; i < 3; i++)
+			end = min(end, line.find(szEnds[i], sql));
+		if (end == string::npos)
+			end = line.rfind(']');
+		if (end == string::npos || end < sql) {
+			cerr << filename << ":" << llLine << ": no end to the statement"
+				 << endl;
+			return false;
+		}
+
+		TReplayStatement statement;
+		statement.llStart = atoll(line.c_str() + timestamp + 11) * 1000000;
+		statement.llEnd = 0;
+		statement.llSequence = llLine;
+		statement.iSql = intern(sqlIds, sqls, line.substr(sql, end - sql));
+		statement.iName = 0;
+		statement.iFirstParam = params.size();
+		statement.nParams = 0;
+
+		if (line.compare(end, 7, "][para=") == 0) {
+			if (!parseParams(line, end + 7, &statement)) {
+				cerr << filename << ":" << llLine
+					 << ": cannot read the parameters" << endl;
+				return false;
+			}
+		} else if (line.compare(end, 7, "][name=") == 0) {
+			size_t close = line.find(']', end + 7);
+			statement.iName
+					= nameId(line.substr(end + 7, close - end - 7));
+		} else if (hasParams(sqls[statement.iSql])) {
+			cerr << filename << ":" << llLine
+				 << ": the statement was captured without its parameters"
+				 << endl;
+			return false;
+		}
+		streams[atoi(line.c_str() + connId + 9)].push_back(statement);
+	}
+	return true;
+}
+
+static bool
+bySequence(const TReplayStatement &a, const TReplayStatement &b)
+{
+	return a.llSequence < b.llSequence;
+}
+
+static bool
+byStart(const TReplayTransaction &a, const TReplayTransaction &b)
+{
+	return a.llStart < b.llStart;
+}
+
+// Split the statements of a connection into transactions.  A transaction
+// left open when the capture ended is not replayed.
+static void
+splitTransactions(vector<TReplayStatement> &stream,
+		vector<TReplayTransaction> &transactions)
+{
+	stable_sort(stream.begin(), stream.end(), bySequence);
+
+	TReplayTransaction transaction;
+	bool bOpen = false;
+	for (size_t i = 0; i < stream.size(); i++) {
+		const TReplayStatement &statement = stream[i];
+		const string &sql = sqls[statement.iSql];
+		if (!bOpen) {
+			transaction.llStart = statement.llStart;
+			transaction.pFirst = &statement;
+			transaction.nStatements = 0;
+			transaction.iName = 0;
+			bOpen = startsWith(sql, "BEGIN");
+		}
+		transaction.nStatements++;
+		if (transaction.iName == 0)
+			transaction.iName = statement.iName;
+
+		if (!bOpen || startsWith(sql, "COMMIT")
+				|| startsWith(sql, "ROLLBACK")) {
+			transactions.push_back(transaction);
+			bOpen = false;
+		}
+	}
+}
+
+// Wait until the time of the statement in the capture, as paced.
+static void
+pace(PReplayWorker pWorker, const TReplayStatement &statement)
+{
+	long long llTarget = llReplayStart
+			+ (long long) ((statement.llStart - llCaptureStart) * 1000
+					/ fSpeed);
+	long long llNow = monotonicNs();
+	if (llNow >= llTarget) {
+		pWorker->llLate = max(pWorker->llLate, (INT64) (llNow - llTarget));
+		return;
+	}
+
+	struct timespec ts;
+	ts.tv_sec = llTarget / 1000000000;
+	ts.tv_nsec = llTarget % 1000000000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+		;
+}
+
+// Run a statement, preparing it first on the connection if asked to.
+static PGresult *
+execute(PReplayWorker pWorker, const TReplayStatement &statement)
+{
+	const char *sql = sqls[statement.iSql].c_str();
+	if (statement.nParams == 0)
+		return PQexec(pWorker->pConn, sql);
+
+	pWorker->values.resize(statement.nParams);
+	pWorker->types.resize(statement.nParams);
+	for (UINT16 i = 0; i < statement.nParams; i++) {
+		const TReplayParam &param = params[statement.iFirstParam + i];
+		pWorker->values[i]
+				= param.bNull ? NULL : paramData.c_str() + param.iOffset;
+		pWorker->types[i] = param.type;
+	}
+
+	if (!bPrepare) {
+		return PQexecParams(pWorker->pConn, sql, statement.nParams,
+				&pWorker->types[0], &pWorker->values[0], NULL, NULL, 0);
+	}
+
+	char name[16];
+	snprintf(name, sizeof(name), "r%u", statement.iSql);
+	if (!pWorker->prepared[statement.iSql]) {
+		PGresult *res = PQprepare(pWorker->pConn, name, sql,
+				statement.nParams, &pWorker->types[0]);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			return res;
+		PQclear(res);
+		pWorker->prepared[statement.iSql] = true;
+	}
+	return PQexecPrepared(pWorker->pConn, name, statement.nParams,
+			&pWorker->values[0], NULL, NULL, 0);
+}
+
+// Replay the transactions of a worker in their order in the capture.
+void *
+replayWorkerThread(void *data)
+{
+	PReplayWorker pWorker = reinterpret_cast<PReplayWorker>(data);
+	pWorker->prepared.resize(sqls.size(), false);
+
+	for (size_t i = 0; i < pWorker->transactions.size(); i++) {
+		const TReplayTransaction &transaction = pWorker->transactions[i];
+		CReplayStats &stats = pWorker->stats[transaction.iName];
+		bool bTransaction
+				= startsWith(sqls[transaction.pFirst->iSql], "BEGIN");
+
+		long long llStart = 0;
+		bool bFailed = false;
+		for (UINT32 j = 0; j < transaction.nStatements; j++) {
+			const TReplayStatement &statement = transaction.pFirst[j];
+			if (bPaced)
+				pace(pWorker, statement);
+
+			long long llStatementStart = monotonicNs();
+			if (j == 0)
+				llStart = llStatementStart;
+			PGresult *res = execute(pWorker, statement);
+			pWorker->statements.add(CLatencyHistogram::index(
+											monotonicNs() - llStatementStart),
+					1);
+			ExecStatusType status = PQresultStatus(res);
+			PQclear(res);
+			if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK)
+				continue;
+
+			// The rest of the transaction is skipped.
+			pWorker->statementErrors++;
+			bFailed = true;
+			if (bTransaction)
+				PQclear(PQexec(pWorker->pConn, "ROLLBACK"));
+			break;
+		}
+
+		INT64 llElapsed = monotonicNs() - llStart;
+		if (bFailed) {
+			stats.errors++;
+			continue;
+		}
+		stats.histogram.add(CLatencyHistogram::index(llElapsed), 1);
+		stats.llTotal += llElapsed;
+
+		const TReplayStatement &last
+				= transaction.pFirst[transaction.nStatements - 1];
+		if (last.llEnd != 0) {
+			stats.llCaptured += max(last.llEnd, last.llStart)
+					- transaction.pFirst->llStart;
+			stats.nCaptured++;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+printStats(const char *name, const CReplayStats &stats, double fElapsed)
+{
+	UINT64 count = stats.histogram.total();
+	printf("%-12s %9llu %7llu %9.1f", name, (unsigned long long) count,
+			(unsigned long long) stats.errors, count / fElapsed);
+	if (count == 0) {
+		printf(" %9s %9s %9s %9s", "-", "-", "-", "-");
+	} else {
+		printf(" %9.3f %9.3f %9.3f %9.3f", stats.llTotal / 1000000.0 / count,
+				stats.histogram.percentile(50) / 1000000.0,
+				stats.histogram.percentile(90) / 1000000.0,
+				stats.histogram.percentile(99) / 1000000.0);
+	}
+	if (stats.nCaptured == 0)
+		printf(" %9s\n", "-");
+	else
+		printf(" %9.3f\n", stats.llCaptured / 1000.0 / stats.nCaptured);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *filename = NULL;
+	for (int arg = 1; arg < argc; ++arg) {
+		char *sp = argv[arg];
+		if (*sp != '-') {
+			filename = sp;
+			continue;
+		}
+
+		++sp;
+		char *vp = sp + 1;
+		if (*vp == 0 && arg + 1 < argc && argv[arg + 1][0] != '-')
+			vp = argv[++arg];
+
+		switch (*sp) {
+		case 'c':
+			iConnections = atoi(vp);
+			break;
+		case 'd':
+			strncpy(szDBName, vp, iMaxDBName);
+			break;
+		case 'h':
+			strncpy(szHost, vp, iMaxHostname);
+			break;
+		case 'p':
+			strncpy(szDBPort, vp, iMaxPort);
+			break;
+		case 'r':
+			bPaced = true;
+			break;
+		case 's':
+			fSpeed = atof(vp);
+			break;
+		case 'u':
+			bPrepare = false;
+			break;
+		default:
+			usage();
+			cout << endl << "Error: Unrecognized option: " << sp << endl;
+			return 1;
+		}
+	}
+	if (filename == NULL || iConnections < 0 || fSpeed <= 0) {
+		usage();
+		return 1;
+	}
+
+	// The transactions nothing names.
+	nameId("-");
+
+	char szMagic[sizeof(CAPTURE_LOG_MAGIC)] = "";
+	ifstream file(filename, ios::binary);
+	file.read(szMagic, sizeof(szMagic));
+	file.close();
+	bool bBinary = memcmp(szMagic, CAPTURE_LOG_MAGIC, sizeof(szMagic)) == 0;
+	if (!(bBinary ? loadBinary(filename) : loadText(filename)))
+		return 1;
+	if (streams.empty()) {
+		cerr << filename << " has no statements" << endl;
+		return 1;
+	}
+	if (iConnections == 0)
+		iConnections = streams.size();
+
+	// The connections of the capture are shared out among the workers.
+	vector<TReplayWorker> workers(iConnections);
+	llCaptureStart = streams.begin()->second.front().llStart;
+	int iStream = 0;
+	for (map<INT32, vector<TReplayStatement> >::iterator it
+			= streams.begin();
+			it != streams.end(); ++it, ++iStream) {
+		splitTransactions(
+				it->second, workers[iStream % iConnections].transactions);
+		for (size_t i = 0; i < it->second.size(); i++)
+			llCaptureStart = min(llCaptureStart, it->second[i].llStart);
+	}
+
+	char szConnectStr[iMaxConnectString + 1] = "";
+	if (szHost[0] != '\0') {
+		strcat(szConnectStr, " host=");
+		strcat(szConnectStr, szHost);
+	}
+	if (szDBName[0] != '\0') {
+		strcat(szConnectStr, " dbname=");
+		strcat(szConnectStr, szDBName);
+	}
+	if (szDBPort[0] != '\0') {
+		strcat(szConnectStr, " port=");
+		strcat(szConnectStr, szDBPort);
+	}
+
+	size_t nTransactions = 0;
+	size_t nStatements = 0;
+	for (int i = 0; i < iConnections; i++) {
+		TReplayWorker &worker = workers[i];
+		stable_sort(worker.transactions.begin(), worker.transactions.end(),
+				byStart);
+		nTransactions += worker.transactions.size();
+		for (size_t j = 0; j < worker.transactions.size(); j++)
+			nStatements += worker.transactions[j].nStatements;
+		worker.stats.resize(names.size());
+		worker.statementErrors = 0;
+		worker.llLate = 0;
+		worker.pConn = PQconnectdb(szConnectStr);
+		if (PQstatus(worker.pConn) != CONNECTION_OK) {
+			cerr << "cannot connect: " << PQerrorMessage(worker.pConn);
+			return 1;
+		}
+	}
+
+	cout << "Replaying " << nTransactions << " transactions, "
+		 << nStatements << " statements, of " << streams.size()
+		 << " connections on " << iConnections << ", ";
+	if (bPaced)
+		cout << "at " << fSpeed << " times the pace of the capture" << endl;
+	else
+		cout << "as fast as possible" << endl;
+
+	llReplayStart = monotonicNs();
+	for (int i = 0; i < iConnections; i++) {
+		if (pthread_create(&workers[i].tid, NULL, &replayWorkerThread,
+					reinterpret_cast<void *>(&workers[i]))
+				!= 0) {
+			cerr << "cannot create worker " << i << endl;
+			return 1;
+		}
+	}
+
+	CReplayStats total;
+	vector<CReplayStats> stats(names.size());
+	CLatencyHistogram statements;
+	UINT64 statementErrors = 0;
+	INT64 llLate = 0;
+	for (int i = 0; i < iConnections; i++) {
+		pthread_join(workers[i].tid, NULL);
+		PQfinish(workers[i].pConn);
+		for (size_t j = 0; j < names.size(); j++) {
+			stats[j].merge(workers[i].stats[j]);
+			total.merge(workers[i].stats[j]);
+		}
+		statements.merge(workers[i].statements);
+		statementErrors += workers[i].statementErrors;
+		llLate = max(llLate, workers[i].llLate);
+	}
+	double fElapsed = (monotonicNs() - llReplayStart) / 1000000000.0;
+
+	printf("\n%.3f seconds, %.1f statements per second, %llu failed\n",
+			fElapsed, statements.total() / fElapsed,
+			(unsigned long long) statementErrors);
+	if (bPaced)
+		printf("At most %.3f ms behind the capture\n", llLate / 1000000.0);
+	cout << endl << "Response times in milliseconds" << endl << endl;
+	printf("%-12s %9s %7s %9s %9s %9s %9s %9s %9s\n", "transaction",
+			"count", "errors", "txn/s", "mean", "p50", "p90", "p99",
+			"captured");
+	for (size_t i = 0; i < names.size(); i++) {
+		if (stats[i].histogram.total() + stats[i].errors > 0)
+			printStats(names[i].c_str(), stats[i], fElapsed);
+	}
+	printStats("all", total, fElapsed);
+
+	return statementErrors == 0 ? 0 : 1;
+}
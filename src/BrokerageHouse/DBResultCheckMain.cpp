@@ -0,0 +1,236 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Check the binary decoders of DBResult against the text PostgreSQL gives
+ * for the same values: each wire encoding is put in a result made up
+ * without a server, then read back as text and with the typed getters.
+ * Exit with 1 if any check fails.
+ */
+
+#include <endian.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+
+#include <catalog/pg_type_d.h>
+
+#include "DBResult.h"
+
+using namespace std;
+
+// Numeric sign, as DBResult knows it.
+#define NUMERIC_POS 0x0000
+#define NUMERIC_NEG 0x4000
+#define NUMERIC_NAN 0xC000
+
+static int iChecks = 0;
+static int iFailed = 0;
+
+static void
+put16(string &s, int i)
+{
+	UINT16 n = htobe16((UINT16) i);
+	s.append(reinterpret_cast<const char *>(&n), sizeof(n));
+}
+
+static string
+numeric(int weight, int sign, int dscale, initializer_list<int> digits)
+{
+	string s;
+	put16(s, (int) digits.size());
+	put16(s, weight);
+	put16(s, sign);
+	put16(s, dscale);
+	for (int digit : digits)
+		put16(s, digit);
+	return s;
+}
+
+static string
+date(INT32 days)
+{
+	UINT32 n = htobe32((UINT32) days);
+	return string(reinterpret_cast<const char *>(&n), sizeof(n));
+}
+
+static string
+timestamp(INT64 usecs)
+{
+	UINT64 n = htobe64((UINT64) usecs);
+	return string(reinterpret_cast<const char *>(&n), sizeof(n));
+}
+
+// A result of one binary column of the type given, with value in its row.
+static PGresult *
+makeResult(Oid type, const string &value)
+{
+	PGresult *res = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+	PGresAttDesc attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.name = const_cast<char *>("value");
+	attr.format = 1;
+	attr.typid = type;
+	attr.typlen = -1;
+	attr.atttypmod = -1;
+	if (res == NULL || !PQsetResultAttrs(res, 1, &attr)
+			|| !PQsetvalue(res, 0, 0, const_cast<char *>(value.data()),
+					(int) value.size())) {
+		fprintf(stderr, "cannot make a result\n");
+		exit(1);
+	}
+	return res;
+}
+
+static void
+fail(const char *what, const string &text, const string &got)
+{
+	++iFailed;
+	printf("FAILED %s of %s: got %s\n", what, text.c_str(), got.c_str());
+}
+
+// The text writeValue() gives the value, and what it gives the column of
+// a result.
+static void
+checkText(Oid type, const string &value, const PGresult *res,
+		const string &text)
+{
+	ostringstream written, column;
+	writeBinaryValue(written, type, value.data(), (int) value.size());
+	writeValue(column, res, 0, 0);
+
+	++iChecks;
+	if (written.str() != text)
+		fail("writeBinaryValue", text, written.str());
+	++iChecks;
+	if (column.str() != text)
+		fail("writeValue", text, column.str());
+}
+
+// A numeric reads as its text and as atoll() and atof() read that text.
+static void
+checkNumeric(const string &value, const string &text)
+{
+	PGresult *res = makeResult(NUMERICOID, value);
+	checkText(NUMERICOID, value, res, text);
+
+	INT64 i = getInt64(res, 0, 0);
+	++iChecks;
+	if (i != atoll(text.c_str()))
+		fail("getInt64", text, to_string(i));
+
+	double d = getDouble(res, 0, 0);
+	++iChecks;
+	if (d != atof(text.c_str()) && !(isnan(d) && isnan(atof(text.c_str()))))
+		fail("getDouble", text, to_string(d));
+	PQclear(res);
+}
+
+// A date or timestamp reads as its text, and its fields as those of the
+// text.
+static void
+checkTimestamp(Oid type, const string &value, const string &text)
+{
+	PGresult *res = makeResult(type, value);
+	checkText(type, value, res, text);
+
+	TIMESTAMP_STRUCT ts;
+	memset(&ts, 0xff, sizeof(ts));
+	getTimestamp(res, 0, 0, &ts);
+
+	int year, month, day, hour = 0, minute = 0, second = 0;
+	char fraction[8] = "";
+	sscanf(text.c_str(), "%d-%d-%d %d:%d:%d.%6[0-9]", &year, &month, &day,
+			&hour, &minute, &second, fraction);
+	// The fraction is in microseconds.
+	UINT32 usecs = 0;
+	for (int i = 0; i < 6; i++)
+		usecs = usecs * 10 + (fraction[i] != '\0' ? fraction[i] - '0' : 0);
+
+	++iChecks;
+	if (ts.year != year || ts.month != month || ts.day != day
+			|| ts.hour != hour || ts.minute != minute || ts.second != second
+			|| ts.fraction != usecs) {
+		char got[64];
+		snprintf(got, sizeof(got), "%d-%d-%d %d:%d:%d %u", ts.year, ts.month,
+				ts.day, ts.hour, ts.minute, ts.second, ts.fraction);
+		fail("getTimestamp", text, got);
+	}
+	PQclear(res);
+}
+
+static void
+checkNumerics()
+{
+	checkNumeric(numeric(0, NUMERIC_NAN, 0, {}), "NaN");
+	checkNumeric(numeric(0, NUMERIC_POS, 0, {}), "0");
+	checkNumeric(numeric(0, NUMERIC_POS, 2, {}), "0.00");
+	checkNumeric(numeric(0, NUMERIC_POS, 2, { 12, 5000 }), "12.50");
+	checkNumeric(numeric(0, NUMERIC_NEG, 2, { 12, 5000 }), "-12.50");
+	checkNumeric(numeric(0, NUMERIC_NEG, 0, { 7 }), "-7");
+
+	// Weight below 0, the first digits are fraction.
+	checkNumeric(numeric(-1, NUMERIC_POS, 4, { 12 }), "0.0012");
+	checkNumeric(numeric(-2, NUMERIC_NEG, 6, { 100 }), "-0.000001");
+	checkNumeric(numeric(-1, NUMERIC_POS, 8, { 1, 2345 }), "0.00012345");
+
+	// Display scale past the digits sent, and groups left out at the end.
+	checkNumeric(numeric(0, NUMERIC_POS, 3, { 1, 5000 }), "1.500");
+	checkNumeric(numeric(0, NUMERIC_POS, 2, { 7 }), "7.00");
+	checkNumeric(numeric(1, NUMERIC_POS, 0, { 1000 }), "10000000");
+	checkNumeric(numeric(2, NUMERIC_NEG, 1, { 3 }), "-300000000.0");
+	checkNumeric(numeric(2, NUMERIC_POS, 4, { 1, 2345, 6789, 123 }),
+			"123456789.0123");
+}
+
+static void
+checkDates()
+{
+	checkTimestamp(DATEOID, date(0), "2000-01-01");
+	checkTimestamp(DATEOID, date(8825), "2024-02-29");
+
+	// Before 2000-01-01, across leap and non-leap centuries.
+	checkTimestamp(DATEOID, date(-1), "1999-12-31");
+	checkTimestamp(DATEOID, date(-10957), "1970-01-01");
+	checkTimestamp(DATEOID, date(-36466), "1900-02-28");
+	checkTimestamp(DATEOID, date(-36465), "1900-03-01");
+	checkTimestamp(DATEOID, date(-146038), "1600-02-29");
+	checkTimestamp(DATEOID, date(-730119), "0001-01-01");
+}
+
+static void
+checkTimestamps()
+{
+	checkTimestamp(TIMESTAMPOID, timestamp(0), "2000-01-01 00:00:00");
+	checkTimestamp(TIMESTAMPOID, timestamp(192877803500000LL),
+			"2006-02-10 09:10:03.5");
+
+	// Before 2000-01-01, with a fraction that must not be taken as going
+	// back from the second.
+	checkTimestamp(TIMESTAMPOID, timestamp(-500000), "1999-12-31 23:59:59.5");
+	checkTimestamp(
+			TIMESTAMPOID, timestamp(-1), "1999-12-31 23:59:59.999999");
+	checkTimestamp(
+			TIMESTAMPOID, timestamp(-86400000000LL), "1999-12-31 00:00:00");
+	checkTimestamp(TIMESTAMPOID, timestamp(-960867739750000LL),
+			"1969-07-20 20:17:40.25");
+	checkTimestamp(TIMESTAMPOID, timestamp(-3155716799999999LL),
+			"1899-12-31 12:00:00.000001");
+}
+
+int
+main()
+{
+	checkNumerics();
+	checkDates();
+	checkTimestamps();
+
+	printf("%d checks, %d failed\n", iChecks, iFailed);
+	return iFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ */
+
+#include <sys/eventfd.h>
+
+#include "RequestQueue.h"
+
+// Constructor
+CBrokerageConnection::CBrokerageConnection(int iSockfd)
+: m_iRefs(1), m_iWireVersion(WIRE_VERSION_UNKNOWN), m_iReceived(0),
+  m_bChannel(false), m_bStalled(false)
+{
+	m_Socket.setSocketFd(iSockfd);
+}
+
+// Destructor, the socket closes itself.
+CBrokerageConnection::~CBrokerageConnection() {}
+
+void
+CBrokerageConnection::acquire()
+{
+	m_iRefs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+CBrokerageConnection::release()
+{
+	if (m_iRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete this;
+}
+
+void
+CBrokerageConnection::send(void *data, int length)
+{
+	m_SendLock.lock();
+	try {
+		m_Socket.dbt5Send(data, length);
+	} catch (CSocketErr *) {
+		m_SendLock.unlock();
+		throw;
+	}
+	m_SendLock.unlock();
+}
+
+// Send the reply in the form the driver negotiated.
+void
+CBrokerageConnection::sendReply(PMsgTimedReply pReply)
+{
+	if (m_iWireVersion >= WIRE_VERSION_PIPELINED)
+		send(reinterpret_cast<void *>(pReply), wireReplySize(m_iWireVersion));
+	else
+		send(reinterpret_cast<void *>(&pReply->Reply), sizeof(pReply->Reply));
+}
+
+// Constructor
+CRequestQueue::CRequestQueue(size_t iDepth, eQueuePolicy ePolicy)
+: m_iDepth(iDepth), m_ePolicy(ePolicy), m_iReadyFd(-1), m_iRoomFd(-1)
+{
+	pthread_mutex_init(&m_Lock, NULL);
+	pthread_cond_init(&m_NotEmpty, NULL);
+}
+
+// Destructor
+CRequestQueue::~CRequestQueue()
+{
+	pthread_cond_destroy(&m_NotEmpty);
+	pthread_mutex_destroy(&m_Lock);
+	if (m_iReadyFd != -1)
+		close(m_iReadyFd);
+	if (m_iRoomFd != -1)
+		close(m_iRoomFd);
+}
+
+bool
+CRequestQueue::push(PBrokerageRequest pRequest)
+{
+	pthread_mutex_lock(&m_Lock);
+	if (m_iDepth > 0 && m_Requests.size() >= m_iDepth) {
+		pthread_mutex_unlock(&m_Lock);
+		return false;
+	}
+	m_Requests.push_back(pRequest);
+	if (m_iReadyFd != -1 && m_Requests.size() == 1)
+		eventfd_write(m_iReadyFd, 1);
+	if (m_iRoomFd != -1 && m_Requests.size() == m_iDepth) {
+		eventfd_t value;
+		eventfd_read(m_iRoomFd, &value);
+	}
+	pthread_cond_signal(&m_NotEmpty);
+	pthread_mutex_unlock(&m_Lock);
+	return true;
+}
+
+PBrokerageRequest
+CRequestQueue::pop()
+{
+	pthread_mutex_lock(&m_Lock);
+	while (m_Requests.empty())
+		pthread_cond_wait(&m_NotEmpty, &m_Lock);
+	PBrokerageRequest pRequest = take();
+	pthread_mutex_unlock(&m_Lock);
+	return pRequest;
+}
+
+PBrokerageRequest
+CRequestQueue::tryPop()
+{
+	pthread_mutex_lock(&m_Lock);
+	PBrokerageRequest pRequest = m_Requests.empty() ? NULL : take();
+	pthread_mutex_unlock(&m_Lock);
+	return pRequest;
+}
+
+int
+CRequestQueue::readyFd()
+{
+	pthread_mutex_lock(&m_Lock);
+	if (m_iReadyFd == -1) {
+		m_iReadyFd = eventfd(m_Requests.empty() ? 0 : 1, EFD_NONBLOCK);
+		if (m_iReadyFd == -1) {
+			pthread_mutex_unlock(&m_Lock);
+			throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+					"CRequestQueue::readyFd");
+		}
+	}
+	pthread_mutex_unlock(&m_Lock);
+	return m_iReadyFd;
+}
+
+int
+CRequestQueue::roomFd()
+{
+	pthread_mutex_lock(&m_Lock);
+	if (m_iRoomFd == -1) {
+		bool bFull = m_iDepth > 0 && m_Requests.size() >= m_iDepth;
+		m_iRoomFd = eventfd(bFull ? 0 : 1, EFD_NONBLOCK);
+		if (m_iRoomFd == -1) {
+			pthread_mutex_unlock(&m_Lock);
+			throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+					"CRequestQueue::roomFd");
+		}
+	}
+	pthread_mutex_unlock(&m_Lock);
+	return m_iRoomFd;
+}
+
+// Remove the oldest request, with the lock held.
+PBrokerageRequest
+CRequestQueue::take()
+{
+	PBrokerageRequest pRequest = m_Requests.front();
+	m_Requests.pop_front();
+	if (m_iReadyFd != -1 && m_Requests.empty()) {
+		eventfd_t value;
+		eventfd_read(m_iReadyFd, &value);
+	}
+	if (m_iRoomFd != -1 && m_iDepth > 0 && m_Requests.size() == m_iDepth - 1)
+		eventfd_write(m_iRoomFd, 1);
+	return pRequest;
+}
+
+size_t
+CRequestQueue::size()
+{
+	pthread_mutex_lock(&m_Lock);
+	size_t iSize = m_Requests.size();
+	pthread_mutex_unlock(&m_Lock);
+	return iSize;
+}
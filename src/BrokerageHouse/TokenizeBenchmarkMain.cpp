@@ -0,0 +1,440 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Measure what splitting the arrays returned by the stored functions costs
+ * the server-side frames: the tokenizers they used to copy every element
+ * into a string against splitArray() in place, and looking up the columns
+ * of a result by name against the numbers the connection keeps.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <libpq-fe.h>
+
+#include "ArrayTokenizer.h"
+#include "CaptureReader.h"
+
+using namespace std;
+
+int iRounds = 10000;
+const char *szFilter = "TradeLookupFrame";
+
+void
+usage()
+{
+	cout << "Usage: TokenizeBenchmark [options] [capture.bin]" << endl
+		 << endl;
+	cout << "   Option      Default    Description" << endl;
+	cout << "   =========   =========  ===============" << endl;
+	printf("   -f string   %-9s  Only the results of the statements with\n"
+		   "                          this in their text\n",
+			szFilter);
+	printf("   -n integer  %-9d  Rounds over the arrays\n", iRounds);
+	cout << endl
+		 << "The arrays are taken from the results of a binary capture at the"
+		 << endl
+		 << "'results' level of a server-side run, or else made up like those"
+		 << endl
+		 << "of TradeLookupFrame1 for 20 trades." << endl;
+}
+
+static long long
+monotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// The tokenizers of CDBConnectionServerSide before splitArray(), as they
+// were.
+void inline TokenizeArray2(const string &str2, vector<string> &tokens)
+{
+	// This is essentially an empty array. i.e. '()'
+	if (str2.size() < 3)
+		return;
+
+	// We only call this function because we need to chop up arrays that
+	// are in the format '{(1,2,3),(a,b,c)}', so trim off the braces.
+	string str = str2.substr(1, str2.size() - 2);
+
+	// Skip delimiters at beginning.
+	string::size_type lastPos = str.find_first_of("(", 0);
+	// Find first "non-delimiter".
+	string::size_type pos = str.find_first_of(")", lastPos);
+
+	while (string::npos != pos || string::npos != lastPos) {
+		// Found a token, add it to the vector.
+		tokens.push_back(str.substr(lastPos, pos - lastPos + 1));
+
+		lastPos = str.find_first_of("(", pos);
+		pos = str.find_first_of(")", lastPos);
+	}
+}
+
+void inline TokenizeSmart(const string &str, vector<string> &tokens)
+{
+	// This is essentially an empty array. i.e. '{}'
+	if (str.size() < 3)
+		return;
+
+	string::size_type lastPos = 1;
+	string::size_type pos = 1;
+	bool end = false;
+	while (end == false) {
+		if (str[lastPos] == '"') {
+			pos = str.find_first_of("\"", lastPos + 1);
+			if (pos == string::npos) {
+				pos = str.find_first_of("}", lastPos);
+				end = true;
+			}
+			tokens.push_back(str.substr(lastPos + 1, pos - lastPos - 1));
+			lastPos = pos + 2;
+		} else if (str[lastPos] == '\0') {
+			return;
+		} else {
+			pos = str.find_first_of(",", lastPos);
+			if (pos == string::npos) {
+				pos = str.find_first_of("}", lastPos);
+				end = true;
+			}
+			tokens.push_back(str.substr(lastPos, pos - lastPos));
+			lastPos = pos + 1;
+		}
+	}
+}
+
+// The arrays of a TradeLookupFrame1 result for 20 trades, by column.
+static void
+makeArrays(vector<string> &arrays, vector<string> &columns)
+{
+	static const char *szStatus[3] = { "SBMT", "PNDG", "CMPT" };
+	ostringstream bid, amount, dts, name, exec, cash, market, settlement,
+			due, type, history, status, price;
+	for (int i = 0; i < 20; i++) {
+		const char *sep = i == 0 ? "{" : ",";
+		bid << sep << 20 + i << "." << 10 + i;
+		amount << sep << 1000 + 37 * i << ".5";
+		dts << sep << "\"2006-02-" << 10 + i << " 09:1" << i % 10 << ":03.5\"";
+		name << sep << "\"Market-Buy " << 100 * (i + 1)
+			 << " shares of \\\"COMMON\\\" of Company " << i << "\"";
+		exec << sep << "\"Executive Broker " << i << "\"";
+		cash << sep << i % 2;
+		market << sep << (i + 1) % 2;
+		settlement << sep << 2000 + 41 * i << ".25";
+		due << sep << "\"2006-03-" << 10 + i << " 00:00:00\"";
+		type << sep << (i % 2 ? "\"Cash Account\"" : "Margin");
+		price << sep << 19 + i << "." << 90 - i;
+		for (int j = 0; j < 3; j++) {
+			const char *hsep = i == 0 && j == 0 ? "{" : ",";
+			if (i % 4 == 3 && j == 2) {
+				history << hsep << "NULL";
+				status << hsep << "NULL";
+			} else {
+				history << hsep << "\"2006-02-" << 10 + i << " 09:1" << j
+						<< ":00\"";
+				status << hsep << szStatus[j];
+			}
+		}
+	}
+
+	const ostringstream *columnArrays[] = { &bid, &amount, &dts, &name, &exec,
+		&cash, &market, &settlement, &due, &type, &history, &status, &price };
+	const char *szColumns[] = { "bid_price", "cash_transaction_amount",
+		"cash_transaction_dts", "cash_transaction_name", "exec_name",
+		"is_cash", "is_market", "settlement_amount",
+		"settlement_cash_due_date", "settlement_cash_type",
+		"trade_history_dts", "trade_history_status_id", "trade_price" };
+	for (size_t i = 0; i < sizeof(szColumns) / sizeof(szColumns[0]); i++) {
+		arrays.push_back(columnArrays[i]->str() + "}");
+		columns.push_back(szColumns[i]);
+	}
+	columns.push_back("num_found");
+}
+
+// Skip the parameters of an exec record.
+static void
+skipParams(CRecordReader &reader)
+{
+	UINT16 nParams = reader.number<UINT16>();
+	for (UINT16 i = 0; i < nParams && !reader.failed(); i++) {
+		reader.number<uint8_t>(); // eCaptureParam
+		reader.number<UINT32>(); // type
+		INT32 length;
+		reader.value(&length);
+	}
+}
+
+// The text arrays in the results of the statements matching szFilter.
+static bool
+readArrays(const char *filename, vector<string> &arrays)
+{
+	CCaptureReader capture;
+	if (!capture.open(filename))
+		return false;
+
+	TCaptureRecord record;
+	CRecordReader reader;
+	while (capture.next(&record, &reader)) {
+		if (record.iKind != CAPTURE_RECORD_EXEC)
+			continue;
+
+		const char *sql = record.iStatement == 0
+				? reader.text()
+				: capture.statement(record.iStatement);
+		skipParams(reader);
+		if (sql == NULL || strstr(sql, szFilter) == NULL
+				|| reader.number<uint8_t>() != CAPTURE_RESULT_TUPLES)
+			continue;
+
+		UINT32 nRows = reader.number<UINT32>();
+		UINT16 nFields = reader.number<UINT16>();
+		vector<uint8_t> formats(nFields);
+		for (UINT16 j = 0; j < nFields; j++) {
+			reader.number<UINT32>(); // type
+			formats[j] = reader.number<uint8_t>();
+		}
+		for (UINT32 i = 0; i < nRows && !reader.failed(); i++) {
+			for (UINT16 j = 0; j < nFields; j++) {
+				INT32 length;
+				const char *value = reader.value(&length);
+				if (value != NULL && formats[j] == 0 && length > 0
+						&& value[0] == '{')
+					arrays.push_back(string(value, length));
+			}
+		}
+	}
+	if (arrays.empty()) {
+		cerr << "no arrays in the results of the statements with "
+			 << szFilter << " in " << filename
+			 << ", captured at the 'results' level?" << endl;
+		return false;
+	}
+	return true;
+}
+
+static void
+report(const char *name, long long llNs, size_t iArrays, size_t iElements)
+{
+	printf("%-22s %12.1f %12.1f %12.1f\n", name,
+			(double) llNs / iRounds / iArrays,
+			(double) llNs / iRounds / iElements,
+			iElements * (double) iRounds / (llNs / 1000000000.0) / 1000000);
+}
+
+// Look up the columns of a result made up with their names, each time by
+// name and through the numbers kept, as CDBConnectionServerSide::column()
+// does.
+static void
+benchmarkColumns(const vector<string> &columns)
+{
+	vector<PGresAttDesc> attributes(columns.size());
+	for (size_t i = 0; i < columns.size(); i++) {
+		memset(&attributes[i], 0, sizeof(attributes[i]));
+		attributes[i].name = const_cast<char *>(columns[i].c_str());
+		attributes[i].typid = 25; // text
+		attributes[i].typlen = -1;
+		attributes[i].atttypmod = -1;
+	}
+	PGresult *res = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+	if (res == NULL
+			|| !PQsetResultAttrs(res, attributes.size(), &attributes[0])) {
+		cerr << "cannot make a result to look columns up in" << endl;
+		PQclear(res);
+		return;
+	}
+
+	// Looked up from the end, the worst case for PQfnumber().
+	vector<const char *> names;
+	for (size_t i = columns.size(); i > 0; i--)
+		names.push_back(columns[i - 1].c_str());
+
+	long long llSum = 0;
+	long long llStart = monotonicNs();
+	for (int round = 0; round < iRounds; round++) {
+		for (size_t i = 0; i < names.size(); i++)
+			llSum += PQfnumber(res, names[i]);
+	}
+	long long llByName = monotonicNs() - llStart;
+
+	unordered_map<const char *, int> numbers;
+	llStart = monotonicNs();
+	for (int round = 0; round < iRounds; round++) {
+		for (size_t i = 0; i < names.size(); i++) {
+			unordered_map<const char *, int>::iterator it
+					= numbers.find(names[i]);
+			if (it != numbers.end() && it->second < PQnfields(res)
+					&& strcmp(PQfname(res, it->second), names[i]) == 0) {
+				llSum -= it->second;
+				continue;
+			}
+			int number = PQfnumber(res, names[i]);
+			numbers[names[i]] = number;
+			llSum -= number;
+		}
+	}
+	long long llKept = monotonicNs() - llStart;
+	PQclear(res);
+
+	cout << endl << names.size() << " columns looked up" << endl;
+	printf("%-22s %12s\n", "lookup", "ns/column");
+	printf("%-22s %12.1f\n", "PQfnumber",
+			(double) llByName / iRounds / names.size());
+	printf("%-22s %12.1f\n", "number kept",
+			(double) llKept / iRounds / names.size());
+	if (llSum != 0)
+		cerr << "the column numbers kept are wrong" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *szCapture = NULL;
+	for (int arg = 1; arg < argc; ++arg) {
+		char *sp = argv[arg];
+		if (*sp != '-') {
+			szCapture = sp;
+			continue;
+		}
+
+		++sp;
+		char *vp = sp + 1;
+		if (*vp == 0 && arg + 1 < argc)
+			vp = argv[++arg];
+
+		switch (*sp) {
+		case 'f':
+			szFilter = vp;
+			break;
+		case 'n':
+			iRounds = atoi(vp);
+			break;
+		default:
+			usage();
+			cout << endl << "Error: Unrecognized option: " << sp << endl;
+			return 1;
+		}
+	}
+	if (iRounds < 1) {
+		usage();
+		return 1;
+	}
+
+	vector<string> arrays;
+	vector<string> columns;
+	// The names of the columns are only known for the arrays made up.
+	if (szCapture != NULL) {
+		if (!readArrays(szCapture, arrays))
+			return 1;
+	} else {
+		makeArrays(arrays, columns);
+	}
+
+	size_t iBytes = 0;
+	size_t iLongest = 0;
+	for (size_t i = 0; i < arrays.size(); i++) {
+		iBytes += arrays[i].size();
+		if (arrays[i].size() > iLongest)
+			iLongest = arrays[i].size();
+	}
+
+	// splitArray() splits the value of a result, here a copy of the array
+	// made each time, which the frames do not need.
+	vector<char> buffer(iLongest + 1);
+	vector<TArrayElement> elements;
+	size_t iElements = 0;
+	size_t iSplitElements = 0;
+	long long llCopy = 0;
+	long long llSplit = 0;
+	long long llTokenize = 0;
+	for (int round = 0; round < iRounds; round++) {
+		long long llStart = monotonicNs();
+		for (size_t i = 0; i < arrays.size(); i++)
+			memcpy(&buffer[0], arrays[i].c_str(), arrays[i].size() + 1);
+		llCopy += monotonicNs() - llStart;
+
+		llStart = monotonicNs();
+		for (size_t i = 0; i < arrays.size(); i++) {
+			memcpy(&buffer[0], arrays[i].c_str(), arrays[i].size() + 1);
+			splitArray(&buffer[0], elements);
+			iSplitElements += elements.size();
+		}
+		llSplit += monotonicNs() - llStart;
+
+		llStart = monotonicNs();
+		for (size_t i = 0; i < arrays.size(); i++) {
+			vector<string> tokens;
+			TokenizeSmart(arrays[i].c_str(), tokens);
+			iElements += tokens.size();
+		}
+		llTokenize += monotonicNs() - llStart;
+	}
+	iElements /= iRounds;
+	iSplitElements /= iRounds;
+
+	cout << arrays.size() << " arrays, " << iBytes << " bytes, "
+		 << iSplitElements << " elements, " << iRounds << " rounds" << endl;
+	if (iElements != iSplitElements)
+		cout << "TokenizeSmart found " << iElements << " elements" << endl;
+	printf("%-22s %12s %12s %12s\n", "tokenizer", "ns/array", "ns/element",
+			"M elements/s");
+	report("TokenizeSmart", llTokenize, arrays.size(), iSplitElements);
+	report("splitArray", llSplit - llCopy, arrays.size(), iSplitElements);
+	report("splitArray with copy", llSplit, arrays.size(), iSplitElements);
+
+	// The arrays of records, as Security Detail returns them.
+	vector<string> records;
+	for (size_t i = 0; i < arrays.size(); i++) {
+		if (arrays[i].compare(0, 3, "{\"(") == 0)
+			records.push_back(arrays[i]);
+	}
+	if (!records.empty()) {
+		vector<TArrayElement> fields;
+		iSplitElements = 0;
+		long long llStart = monotonicNs();
+		for (int round = 0; round < iRounds; round++) {
+			for (size_t i = 0; i < records.size(); i++) {
+				memcpy(&buffer[0], records[i].c_str(), records[i].size() + 1);
+				splitArray(&buffer[0], elements);
+				for (size_t j = 0; j < elements.size(); j++) {
+					splitRecord(elements[j].text, fields);
+					iSplitElements += fields.size();
+				}
+			}
+		}
+		llSplit = monotonicNs() - llStart;
+
+		llStart = monotonicNs();
+		for (int round = 0; round < iRounds; round++) {
+			for (size_t i = 0; i < records.size(); i++) {
+				vector<string> tokens;
+				TokenizeArray2(records[i].c_str(), tokens);
+				for (size_t j = 0; j < tokens.size(); j++) {
+					vector<string> fields;
+					TokenizeSmart(tokens[j].c_str(), fields);
+				}
+			}
+		}
+		llTokenize = monotonicNs() - llStart;
+
+		cout << endl << records.size() << " arrays of records" << endl;
+		report("TokenizeArray2", llTokenize, records.size(),
+				iSplitElements / iRounds);
+		report("splitRecord with copy", llSplit, records.size(),
+				iSplitElements / iRounds);
+	}
+
+	if (!columns.empty())
+		benchmarkColumns(columns);
+
+	return 0;
+}
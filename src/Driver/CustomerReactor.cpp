@@ -0,0 +1,1129 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Each reactor thread runs many emulated users.  A user is a state machine:
+ * it generates a transaction with its own CCE, sends it to the Brokerage
+ * House on a non-blocking socket, waits for the reply through epoll, logs
+ * the response time in the usual mix log format and then sleeps for the
+ * pacing delay on the reactor's timer wheel.
+ *
+ * In open-loop mode users do not pace themselves.  The reactor generates
+ * arrivals at the target rate whether or not earlier transactions have
+ * completed, queues them until a connected user is free, and measures the
+ * response time from the intended start time so that SUT stalls show up in
+ * the latencies instead of lowering the offered load.
+ *
+ * Each user normally has a connection of its own.  Users can instead share
+ * a few connections per reactor: their requests are then pipelined, tagged
+ * with the user's index as request ID so that replies can come back in any
+ * order.
+ *
+ * The Brokerage House may also be reached through a Unix-domain socket or,
+ * when co-located, a shared-memory channel whose doorbell socket is what
+ * epoll watches.
+ */
+
+#include <cmath>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "CustomerReactor.h"
+#include "Driver.h"
+#include "DBT5Consts.h"
+
+#define REACTOR_MAX_EVENTS 256
+// Longest time epoll_wait() may block so that the end of the test is
+// noticed even when no user has anything to do.
+#define REACTOR_MAX_WAIT_MS 100
+// Time to wait before trying to connect again.
+#define REACTOR_RECONNECT_MS 1000
+// Most pipelined requests gathered into a single send.
+#define REACTOR_MAX_BATCH 32
+
+extern int stop_time;
+
+static long long
+monotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static long long
+monotonicMs()
+{
+	return monotonicNs() / 1000000;
+}
+
+// sendmsg() and recv() on a connection of either transport.  A shared-memory
+// channel asks for its doorbell to be rung before reporting EAGAIN.
+static ssize_t
+connectionSend(CReactorConnection *pConnection, struct iovec *iov, int iovcnt)
+{
+	CShmChannel *pChannel = pConnection->m_pChannel;
+	if (pChannel == NULL) {
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		return sendmsg(pConnection->m_iSockfd, &msg, MSG_NOSIGNAL);
+	}
+
+	while (!pChannel->closed()) {
+		size_t sent = pChannel->write(iov, iovcnt);
+		if (sent > 0)
+			return sent;
+		if (pChannel->armWrite()) {
+			errno = EAGAIN;
+			return -1;
+		}
+	}
+	errno = EPIPE;
+	return -1;
+}
+
+static ssize_t
+connectionReceive(CReactorConnection *pConnection, void *data, size_t length)
+{
+	CShmChannel *pChannel = pConnection->m_pChannel;
+	if (pChannel == NULL)
+		return recv(pConnection->m_iSockfd, data, length, 0);
+
+	while (true) {
+		size_t received = pChannel->read(data, length);
+		if (received > 0)
+			return received;
+		if (pChannel->closed())
+			return 0;
+		if (pChannel->armRead()) {
+			errno = EAGAIN;
+			return -1;
+		}
+	}
+}
+
+// Constructor
+CArrivalProfile::CArrivalProfile()
+: dRate(0), bPoisson(false), eRamp(RAMP_NONE), dEndRate(0), dIncrement(0),
+  iRampSeconds(0)
+{
+}
+
+// Parse a ramp specification, either "step:<end>:<increment>:<seconds>" or
+// "linear:<end>:<seconds>".  The end rate must be positive, as no interval
+// between arrivals follows from a rate of 0 or less.
+bool
+CArrivalProfile::parseRamp(const char *szRamp)
+{
+	if (sscanf(szRamp, "step:%lf:%lf:%d", &dEndRate, &dIncrement,
+				&iRampSeconds)
+			== 3) {
+		eRamp = RAMP_STEP;
+		return dEndRate > 0 && dIncrement > 0 && iRampSeconds > 0;
+	}
+	if (sscanf(szRamp, "linear:%lf:%d", &dEndRate, &iRampSeconds) == 2) {
+		eRamp = RAMP_LINEAR;
+		return dEndRate > 0 && iRampSeconds > 0;
+	}
+	return false;
+}
+
+// Target rate in txn/s the given number of seconds after ramp-up.
+double
+CArrivalProfile::rateAt(double dElapsed) const
+{
+	double rate;
+
+	switch (eRamp) {
+	case RAMP_STEP:
+		rate = dRate + floor(dElapsed / iRampSeconds) * dIncrement;
+		return rate < dEndRate ? rate : dEndRate;
+	case RAMP_LINEAR:
+		if (dElapsed >= iRampSeconds)
+			return dEndRate;
+		return dRate + (dEndRate - dRate) * dElapsed / iRampSeconds;
+	default:
+		return dRate;
+	}
+}
+
+bool
+CCEReactorSUT::BrokerVolume(PBrokerVolumeTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = BROKER_VOLUME;
+	memcpy(&(m_pRequest->TxnInput.BrokerVolumeTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.BrokerVolumeTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::CustomerPosition(PCustomerPositionTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = CUSTOMER_POSITION;
+	memcpy(&(m_pRequest->TxnInput.CustomerPositionTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.CustomerPositionTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::MarketWatch(PMarketWatchTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = MARKET_WATCH;
+	memcpy(&(m_pRequest->TxnInput.MarketWatchTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.MarketWatchTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::SecurityDetail(PSecurityDetailTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = SECURITY_DETAIL;
+	memcpy(&(m_pRequest->TxnInput.SecurityDetailTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.SecurityDetailTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::TradeLookup(PTradeLookupTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = TRADE_LOOKUP;
+	memcpy(&(m_pRequest->TxnInput.TradeLookupTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.TradeLookupTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::TradeOrder(PTradeOrderTxnInput pTxnInput, INT32, bool)
+{
+	m_pRequest->TxnType = TRADE_ORDER;
+	memcpy(&(m_pRequest->TxnInput.TradeOrderTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.TradeOrderTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::TradeStatus(PTradeStatusTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = TRADE_STATUS;
+	memcpy(&(m_pRequest->TxnInput.TradeStatusTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.TradeStatusTxnInput));
+	return true;
+}
+
+bool
+CCEReactorSUT::TradeUpdate(PTradeUpdateTxnInput pTxnInput)
+{
+	m_pRequest->TxnType = TRADE_UPDATE;
+	memcpy(&(m_pRequest->TxnInput.TradeUpdateTxnInput), pTxnInput,
+			sizeof(m_pRequest->TxnInput.TradeUpdateTxnInput));
+	return true;
+}
+
+CTimerWheel::CTimerWheel(long long llNow)
+: m_llLastTick(llNow), m_iCount(0)
+{
+	memset(m_pSlots, 0, sizeof(m_pSlots));
+}
+
+void
+CTimerWheel::schedule(CEmulatedUser *pUser, long long llExpiry)
+{
+	// Never schedule into a tick that has already been processed.
+	if (llExpiry <= m_llLastTick)
+		llExpiry = m_llLastTick + 1;
+
+	int slot = (int) (llExpiry & (iWheelSlots - 1));
+	pUser->m_llTimerExpiry = llExpiry;
+	pUser->m_pNextTimer = m_pSlots[slot];
+	m_pSlots[slot] = pUser;
+	++m_iCount;
+}
+
+CEmulatedUser *
+CTimerWheel::expire(long long llNow)
+{
+	CEmulatedUser *pExpired = NULL;
+
+	if (llNow <= m_llLastTick)
+		return NULL;
+
+	// Visit each slot at most once even if the reactor fell behind by more
+	// than a full turn of the wheel.
+	long long llTicks = llNow - m_llLastTick;
+	if (llTicks > iWheelSlots)
+		llTicks = iWheelSlots;
+
+	for (long long tick = llNow - llTicks + 1; tick <= llNow; tick++) {
+		CEmulatedUser **ppUser = &m_pSlots[tick & (iWheelSlots - 1)];
+		while (*ppUser != NULL) {
+			CEmulatedUser *pUser = *ppUser;
+			if (pUser->m_llTimerExpiry <= llNow) {
+				*ppUser = pUser->m_pNextTimer;
+				pUser->m_pNextTimer = pExpired;
+				pExpired = pUser;
+				--m_iCount;
+			} else {
+				ppUser = &pUser->m_pNextTimer;
+			}
+		}
+	}
+	m_llLastTick = llNow;
+
+	return pExpired;
+}
+
+// Constructor
+CCustomerReactor::CCustomerReactor(CDriver *pDriver, int iReactorId)
+: m_pDriver(pDriver), m_iReactorId(iReactorId), m_pid(0), m_pLog(NULL),
+  m_bInboxClosed(false), m_bWarnedLegacy(false), m_pTimers(NULL),
+  m_iActiveUsers(0), m_bStopping(false),
+  m_bOpenLoop(pDriver->m_Arrivals.dRate > 0), m_llArrivalStart(0),
+  m_dNextArrival(0)
+{
+	m_xsubi[0] = (unsigned short) iReactorId;
+	m_xsubi[1] = (unsigned short) pDriver->iSeed;
+	m_xsubi[2] = (unsigned short) time(NULL);
+
+	memset(&m_Hello, 0, sizeof(m_Hello));
+	m_Hello.iMagic = WIRE_MAGIC;
+	m_Hello.iVersion = WIRE_VERSION;
+
+	// Resolve the Brokerage House address once, gethostbyname() is not
+	// thread safe.
+	const char *path;
+	m_eTransport = CSocket::parseAddress(pDriver->szBHaddr, &path);
+	memset(&m_BHAddr, 0, sizeof(m_BHAddr));
+	if (m_eTransport != TRANSPORT_TCP) {
+		m_iBHAddrLen = CSocket::unixAddress(
+				path, reinterpret_cast<struct sockaddr_un *>(&m_BHAddr));
+	} else {
+		struct sockaddr_in *pAddr
+				= reinterpret_cast<struct sockaddr_in *>(&m_BHAddr);
+		pAddr->sin_family = AF_INET;
+		pAddr->sin_port = htons(pDriver->iBHlistenPort);
+		if (inet_pton(AF_INET, pDriver->szBHaddr, &pAddr->sin_addr) <= 0) {
+			struct hostent *he = gethostbyname(pDriver->szBHaddr);
+			if (he == NULL) {
+				throw new CSocketErr(CSocketErr::ERR_SOCKET_HOSTBYNAME,
+						"CCustomerReactor::CCustomerReactor");
+			}
+			memcpy(&pAddr->sin_addr, he->h_addr_list[0], he->h_length);
+		}
+		m_iBHAddrLen = sizeof(struct sockaddr_in);
+	}
+
+	m_epfd = epoll_create1(0);
+	m_eventfd = eventfd(0, EFD_NONBLOCK);
+	if (m_epfd == -1 || m_eventfd == -1) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+				"CCustomerReactor::CCustomerReactor");
+	}
+
+	// A NULL connection marks the wake-up event from the driver.
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_eventfd, &ev);
+}
+
+// Destructor
+CCustomerReactor::~CCustomerReactor()
+{
+	for (size_t i = 0; i < m_Connections.size(); i++) {
+		closeConnection(m_Connections[i]);
+		delete m_Connections[i];
+	}
+	close(m_eventfd);
+	close(m_epfd);
+	delete m_pTimers;
+	delete m_pLog;
+	m_fLog.close();
+}
+
+// Hand a new user to this reactor, called by the driver during ramp-up.
+void
+CCustomerReactor::addUser(UINT32 UniqueId)
+{
+	m_InboxLock.lock();
+	m_Inbox.push_back(UniqueId);
+	m_InboxLock.unlock();
+
+	uint64_t one = 1;
+	if (write(m_eventfd, &one, sizeof(one)) != sizeof(one)) {
+		cerr << "cannot wake up customer reactor " << m_iReactorId << endl;
+	}
+}
+
+// No more users will be added after ramp-up.
+void
+CCustomerReactor::closeInbox()
+{
+	m_InboxLock.lock();
+	m_bInboxClosed = true;
+	m_InboxLock.unlock();
+
+	// Let an open-loop reactor start issuing arrivals right away.
+	uint64_t one = 1;
+	if (write(m_eventfd, &one, sizeof(one)) != sizeof(one)) {
+		cerr << "cannot wake up customer reactor " << m_iReactorId << endl;
+	}
+}
+
+void
+CCustomerReactor::acceptUsers()
+{
+	uint64_t count;
+	if (read(m_eventfd, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+		logErrorMessage("cannot read customer reactor wake up event\n");
+	}
+
+	vector<UINT32> users;
+	m_InboxLock.lock();
+	users.swap(m_Inbox);
+	m_InboxLock.unlock();
+
+	for (size_t i = 0; i < users.size(); i++) {
+		CEmulatedUser *pUser
+				= new CEmulatedUser(users[i], (UINT32) m_Users.size());
+		m_Users.push_back(pUser);
+
+		if (m_pDriver->iSeed == 0) {
+			pUser->m_pCCE = new CCE(&pUser->m_SUT, m_pLog,
+					m_pDriver->m_InputFiles,
+					m_pDriver->iConfiguredCustomerCount,
+					m_pDriver->iActiveCustomerCount, m_pDriver->iScaleFactor,
+					m_pDriver->iDaysOfInitialTrades, pUser->m_UniqueId);
+		} else {
+			// Specifying the random number generator seed is considered an
+			// invalid run.
+			pUser->m_pCCE = new CCE(&pUser->m_SUT, m_pLog,
+					m_pDriver->m_InputFiles,
+					m_pDriver->iConfiguredCustomerCount,
+					m_pDriver->iActiveCustomerCount, m_pDriver->iScaleFactor,
+					m_pDriver->iDaysOfInitialTrades, pUser->m_UniqueId,
+					m_pDriver->iSeed, m_pDriver->iSeed);
+		}
+
+		if (m_pDriver->iConnections > 0) {
+			pUser->m_pConnection = m_Connections[pUser->m_iRequestId
+					% m_pDriver->iConnections];
+		} else {
+			pUser->m_pConnection = new CReactorConnection(true);
+			m_Connections.push_back(pUser->m_pConnection);
+			connect(pUser->m_pConnection);
+		}
+
+		// Requests made before the connection is ready wait in its queue.
+		++m_iActiveUsers;
+		if (m_bOpenLoop)
+			releaseUser(pUser);
+		else
+			think(pUser, 0);
+	}
+}
+
+void
+CCustomerReactor::closeConnection(CReactorConnection *pConnection)
+{
+	if (pConnection->m_iSockfd != -1) {
+		// Closing the descriptor also removes it from the epoll set.
+		close(pConnection->m_iSockfd);
+		pConnection->m_iSockfd = -1;
+	}
+	delete pConnection->m_pChannel;
+	pConnection->m_pChannel = NULL;
+	pConnection->m_eState = CReactorConnection::CONN_CLOSED;
+	pConnection->m_iEvents = 0;
+	pConnection->m_iOffset = 0;
+	pConnection->m_iReceived = 0;
+	pConnection->m_iInFlight = 0;
+	pConnection->m_pInFlight = NULL;
+}
+
+void
+CCustomerReactor::completeTxn(
+		CEmulatedUser *pUser, int iStatus, const TMsgServerTimes *pServer)
+{
+	// calculate txn response time, in open-loop mode this includes the time
+	// the arrival spent waiting for a free user
+	long long llTxnTime = monotonicNs() - pUser->m_llStartTime;
+
+	logResponseTime(iStatus, pUser->m_Request.TxnType, llTxnTime, pServer);
+
+	if (m_bOpenLoop) {
+		releaseUser(pUser);
+	} else {
+		// wait for pacing delay -- this delays happens after the mix logging
+		think(pUser, m_pDriver->iPacingDelay);
+	}
+}
+
+// Start a non-blocking connection to the Brokerage House.
+void
+CCustomerReactor::connect(CReactorConnection *pConnection)
+{
+	pConnection->m_eState = CReactorConnection::CONN_CONNECTING;
+
+	// A shared-memory channel is set up over a blocking connection, it is
+	// local and quick.
+	int type = SOCK_STREAM;
+	if (m_eTransport != TRANSPORT_SHM)
+		type |= SOCK_NONBLOCK;
+	pConnection->m_iSockfd = socket(m_BHAddr.ss_family, type, 0);
+	if (pConnection->m_iSockfd == -1) {
+		failConnection(pConnection, CSocketErr::ERR_SOCKET_CREATE);
+		return;
+	}
+
+	struct epoll_event ev;
+	ev.data.ptr = pConnection;
+
+	if (m_eTransport == TRANSPORT_SHM) {
+		if (::connect(pConnection->m_iSockfd, (struct sockaddr *) &m_BHAddr,
+					m_iBHAddrLen)
+				== -1) {
+			failConnection(pConnection, CSocketErr::ERR_SOCKET_CONNECT);
+			return;
+		}
+		try {
+			pConnection->m_pChannel
+					= CShmChannel::connect(pConnection->m_iSockfd);
+		} catch (CSocketErr *pErr) {
+			failConnection(pConnection, pErr->getAction());
+			delete pErr;
+			return;
+		}
+
+		// Whatever the reactor waits for, the doorbell rings.
+		ev.events = EPOLLIN;
+		epoll_ctl(m_epfd, EPOLL_CTL_ADD, pConnection->m_iSockfd, &ev);
+		pConnection->m_iEvents = EPOLLIN;
+		pConnection->m_eState = CReactorConnection::CONN_HELLO;
+		sendHello(pConnection);
+		return;
+	}
+
+	ev.events = EPOLLOUT;
+	epoll_ctl(m_epfd, EPOLL_CTL_ADD, pConnection->m_iSockfd, &ev);
+	pConnection->m_iEvents = EPOLLOUT;
+
+	if (::connect(pConnection->m_iSockfd, (struct sockaddr *) &m_BHAddr,
+				m_iBHAddrLen)
+			== 0) {
+		// Connected right away.
+		pConnection->m_eState = CReactorConnection::CONN_HELLO;
+		sendHello(pConnection);
+	} else if (errno != EINPROGRESS) {
+		failConnection(pConnection, CSocketErr::ERR_SOCKET_CONNECT);
+	}
+}
+
+// Close a broken connection and try again later.  Requests that were sent,
+// even in part, are lost and logged as errors; requests still queued go out
+// on the next connection.
+void
+CCustomerReactor::failConnection(
+		CReactorConnection *pConnection, CSocketErr::Action eAction)
+{
+	vector<CEmulatedUser *> lost;
+	if (pConnection->m_iOffset > 0
+			&& pConnection->m_eState == CReactorConnection::CONN_READY
+			&& !pConnection->m_Queue.empty()) {
+		CEmulatedUser *pUser = pConnection->m_Queue.front();
+		pConnection->m_Queue.pop_front();
+		logResponseTime(-1, 0, MIX_RESPONSE_SEND_ERROR);
+		lost.push_back(pUser);
+	}
+	if (pConnection->m_pInFlight != NULL) {
+		logResponseTime(-1, 0, MIX_RESPONSE_RECV_ERROR);
+		lost.push_back(pConnection->m_pInFlight);
+	} else if (pConnection->m_iInFlight > 0) {
+		for (size_t i = 0; i < m_Users.size(); i++) {
+			CEmulatedUser *pUser = m_Users[i];
+			if (pUser != NULL && pUser->m_pConnection == pConnection
+					&& pUser->m_eState == CEmulatedUser::USER_RECEIVING) {
+				logResponseTime(-1, 0, MIX_RESPONSE_RECV_ERROR);
+				lost.push_back(pUser);
+			}
+		}
+	}
+
+	// The Brokerage House may close an idle connection, that is not worth
+	// reporting.
+	if (!lost.empty()
+			|| pConnection->m_eState != CReactorConnection::CONN_READY
+			|| eAction != CSocketErr::ERR_SOCKET_CLOSED) {
+		ostringstream msg;
+		msg << time(NULL) << " " << m_pid << " Error: "
+			<< CSocketErr(eAction).ErrorText() << ", errno " << errno
+			<< ", " << lost.size() << " transactions lost" << endl;
+		logErrorMessage(msg.str());
+	}
+
+	closeConnection(pConnection);
+	pConnection->m_llRetryTime = monotonicMs() + REACTOR_RECONNECT_MS;
+	m_Retries.push_back(pConnection);
+
+	// Users whose transaction was lost carry on once the connection had
+	// time to come back.
+	for (size_t i = 0; i < lost.size(); i++) {
+		if (m_bOpenLoop)
+			releaseUser(lost[i]);
+		else
+			think(lost[i], REACTOR_RECONNECT_MS);
+	}
+}
+
+// Send as many queued requests as the socket takes, several at a time with a
+// single system call when pipelining.
+void
+CCustomerReactor::flushConnection(CReactorConnection *pConnection)
+{
+	if (pConnection->m_eState != CReactorConnection::CONN_READY)
+		return;
+
+	bool bPipelined = pConnection->m_iWireVersion >= WIRE_VERSION_PIPELINED;
+	size_t headerSize = wireHeaderSize(pConnection->m_iWireVersion);
+
+	while (!pConnection->m_Queue.empty()
+			&& (bPipelined || pConnection->m_iInFlight == 0)) {
+		struct iovec iov[2 * REACTOR_MAX_BATCH];
+		int n = 0;
+		size_t skip = pConnection->m_iOffset;
+		size_t batch = bPipelined ? REACTOR_MAX_BATCH : 1;
+		if (batch > pConnection->m_Queue.size())
+			batch = pConnection->m_Queue.size();
+
+		for (size_t i = 0; i < batch; i++) {
+			CEmulatedUser *pUser = pConnection->m_Queue[i];
+			struct iovec request[2];
+			int iovcnt;
+			if (pConnection->m_iWireVersion >= WIRE_VERSION_FRAMED) {
+				pUser->m_Header.iVersion = pConnection->m_iWireVersion;
+				pUser->m_Header.iTxnType = pUser->m_Request.TxnType;
+				pUser->m_Header.iLength
+						= txnInputSize(pUser->m_Request.TxnType);
+				pUser->m_Header.iRequestId = pUser->m_iRequestId;
+				request[0].iov_base = &pUser->m_Header;
+				request[0].iov_len = headerSize;
+				request[1].iov_base = &pUser->m_Request.TxnInput;
+				request[1].iov_len = pUser->m_Header.iLength;
+				iovcnt = 2;
+			} else {
+				// A legacy peer gets the whole message.
+				request[0].iov_base = &pUser->m_Request;
+				request[0].iov_len = sizeof(pUser->m_Request);
+				iovcnt = 1;
+			}
+
+			// Skip what was sent before the socket buffer filled up.
+			for (int j = 0; j < iovcnt; j++) {
+				if (skip >= request[j].iov_len) {
+					skip -= request[j].iov_len;
+					continue;
+				}
+				iov[n].iov_base = (char *) request[j].iov_base + skip;
+				iov[n].iov_len = request[j].iov_len - skip;
+				skip = 0;
+				++n;
+			}
+		}
+
+		ssize_t sent = connectionSend(pConnection, iov, n);
+		if (sent == -1 && (errno == EAGAIN || errno == EINTR)) {
+			setInterest(pConnection, EPOLLIN | EPOLLOUT);
+			return;
+		} else if (sent <= 0) {
+			failConnection(pConnection, CSocketErr::ERR_SOCKET_SEND);
+			return;
+		}
+
+		// Requests sent completely now wait for their reply.
+		size_t done = pConnection->m_iOffset + sent;
+		while (!pConnection->m_Queue.empty()) {
+			CEmulatedUser *pUser = pConnection->m_Queue.front();
+			size_t length = pConnection->m_iWireVersion >= WIRE_VERSION_FRAMED
+					? headerSize + txnInputSize(pUser->m_Request.TxnType)
+					: sizeof(pUser->m_Request);
+			if (done < length)
+				break;
+			done -= length;
+			pConnection->m_Queue.pop_front();
+			pUser->m_eState = CEmulatedUser::USER_RECEIVING;
+			++pConnection->m_iInFlight;
+			if (!bPipelined)
+				pConnection->m_pInFlight = pUser;
+		}
+		pConnection->m_iOffset = done;
+	}
+
+	setInterest(pConnection, EPOLLIN);
+}
+
+void
+CCustomerReactor::handleEvent(CReactorConnection *pConnection, UINT32 events)
+{
+	// The doorbell does not tell what the peer did, check everything.  A
+	// closed channel shows when nothing is left to receive.
+	if (pConnection->m_pChannel != NULL) {
+		pConnection->m_pChannel->drain();
+		events = EPOLLIN | EPOLLOUT;
+	}
+
+	switch (pConnection->m_eState) {
+	case CReactorConnection::CONN_CONNECTING: {
+		int error = 0;
+		socklen_t len = sizeof(error);
+		if (getsockopt(pConnection->m_iSockfd, SOL_SOCKET, SO_ERROR, &error,
+					&len)
+						== -1
+				|| error != 0) {
+			errno = error;
+			failConnection(pConnection, CSocketErr::ERR_SOCKET_CONNECT);
+		} else {
+			pConnection->m_eState = CReactorConnection::CONN_HELLO;
+			pConnection->m_iOffset = 0;
+			sendHello(pConnection);
+		}
+		break;
+	}
+	case CReactorConnection::CONN_HELLO:
+		sendHello(pConnection);
+		break;
+	case CReactorConnection::CONN_HELLO_REPLY:
+		receiveHelloReply(pConnection);
+		break;
+	case CReactorConnection::CONN_READY:
+		if (events & EPOLLOUT)
+			flushConnection(pConnection);
+		if ((events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+				&& pConnection->m_eState == CReactorConnection::CONN_READY)
+			receiveReplies(pConnection);
+		break;
+	case CReactorConnection::CONN_CLOSED:
+		// An event reported before the connection was closed.
+		break;
+	}
+}
+
+// Queue every arrival due by now and hand queued arrivals to free users.
+void
+CCustomerReactor::issueArrivals(long long llNow)
+{
+	const CArrivalProfile &arrivals = m_pDriver->m_Arrivals;
+
+	while (m_dNextArrival <= llNow) {
+		m_Backlog.push_back((long long) m_dNextArrival);
+
+		// Each reactor issues its share of the total rate.
+		double elapsed = (m_dNextArrival - m_llArrivalStart) / 1000000000.0;
+		double rate = arrivals.rateAt(elapsed) / m_pDriver->iReactors;
+		if (rate <= 0) {
+			// Nothing arrives at this rate, look again in a second.
+			m_dNextArrival = llNow + 1000000000.0;
+			break;
+		}
+		double interval = arrivals.bPoisson
+				? -log(1.0 - erand48(m_xsubi)) / rate
+				: 1.0 / rate;
+		m_dNextArrival += interval * 1000000000.0;
+	}
+
+	while (!m_Backlog.empty() && !m_IdleUsers.empty()) {
+		CEmulatedUser *pUser = m_IdleUsers.back();
+		m_IdleUsers.pop_back();
+		long long llIntended = m_Backlog.front();
+		m_Backlog.pop_front();
+		startTxn(pUser, llIntended);
+	}
+}
+
+// A Brokerage House that does not know the framed protocol answers the hello
+// with a TMsgBrokerageDriver, a framed one with a TMsgHelloReply starting
+// with WIRE_MAGIC.
+void
+CCustomerReactor::receiveHelloReply(CReactorConnection *pConnection)
+{
+	PMsgHelloReply pReply
+			= reinterpret_cast<PMsgHelloReply>(pConnection->m_Buffer);
+	while (true) {
+		size_t length = sizeof(TMsgBrokerageDriver);
+		if (pConnection->m_iReceived >= length
+				&& pReply->iMagic == WIRE_MAGIC)
+			length = sizeof(TMsgHelloReply);
+		if (pConnection->m_iReceived >= length)
+			break;
+
+		ssize_t received = connectionReceive(pConnection,
+				pConnection->m_Buffer + pConnection->m_iReceived,
+				length - pConnection->m_iReceived);
+		if (received > 0) {
+			pConnection->m_iReceived += received;
+		} else if (received == -1 && (errno == EAGAIN || errno == EINTR)) {
+			return;
+		} else {
+			failConnection(pConnection,
+					received == 0 ? CSocketErr::ERR_SOCKET_CLOSED
+								  : CSocketErr::ERR_SOCKET_RECV);
+			return;
+		}
+	}
+
+	if (pReply->iMagic != WIRE_MAGIC)
+		pConnection->m_iWireVersion = WIRE_VERSION_LEGACY;
+	else if (pReply->iVersion < WIRE_VERSION)
+		pConnection->m_iWireVersion = pReply->iVersion;
+	else
+		pConnection->m_iWireVersion = WIRE_VERSION;
+
+	if (!pConnection->m_bDedicated
+			&& pConnection->m_iWireVersion < WIRE_VERSION_PIPELINED
+			&& !m_bWarnedLegacy) {
+		logErrorMessage("The Brokerage House does not pipeline requests, "
+						"shared connections send them one at a time\n");
+		m_bWarnedLegacy = true;
+	}
+
+	pConnection->m_eState = CReactorConnection::CONN_READY;
+	pConnection->m_iOffset = 0;
+	pConnection->m_iReceived = 0;
+	flushConnection(pConnection);
+	if (pConnection->m_pChannel != NULL
+			&& pConnection->m_eState == CReactorConnection::CONN_READY)
+		receiveReplies(pConnection);
+}
+
+// Read every reply available and hand each to the user waiting for it.
+void
+CCustomerReactor::receiveReplies(CReactorConnection *pConnection)
+{
+	size_t replySize = wireReplySize(pConnection->m_iWireVersion);
+
+	while (true) {
+		ssize_t received = connectionReceive(pConnection,
+				pConnection->m_Buffer + pConnection->m_iReceived,
+				CReactorConnection::iBufferSize - pConnection->m_iReceived);
+		if (received == -1 && (errno == EAGAIN || errno == EINTR)) {
+			break;
+		} else if (received <= 0) {
+			failConnection(pConnection,
+					received == 0 ? CSocketErr::ERR_SOCKET_CLOSED
+								  : CSocketErr::ERR_SOCKET_RECV);
+			return;
+		}
+		pConnection->m_iReceived += received;
+
+		size_t used = 0;
+		while (pConnection->m_iReceived - used >= replySize) {
+			char *pReply = pConnection->m_Buffer + used;
+			used += replySize;
+
+			CEmulatedUser *pUser;
+			int iStatus;
+			const TMsgServerTimes *pServer = NULL;
+			if (pConnection->m_iWireVersion >= WIRE_VERSION_PIPELINED) {
+				PMsgPipelinedReply pPipelined
+						= reinterpret_cast<PMsgPipelinedReply>(pReply);
+				pUser = pPipelined->iRequestId < m_Users.size()
+						? m_Users[pPipelined->iRequestId]
+						: NULL;
+				iStatus = pPipelined->Reply.iStatus;
+				if (pConnection->m_iWireVersion >= WIRE_VERSION_TIMED) {
+					pServer = &reinterpret_cast<PMsgTimedReply>(pReply)->Times;
+				}
+			} else {
+				pUser = pConnection->m_pInFlight;
+				iStatus = reinterpret_cast<PMsgBrokerageDriver>(pReply)
+								  ->iStatus;
+			}
+			if (pUser == NULL || pUser->m_pConnection != pConnection
+					|| pUser->m_eState != CEmulatedUser::USER_RECEIVING) {
+				failConnection(pConnection, CSocketErr::ERR_SOCKET_PROTOCOL);
+				return;
+			}
+
+			--pConnection->m_iInFlight;
+			pConnection->m_pInFlight = NULL;
+			completeTxn(pUser, iStatus, pServer);
+			// The last user of a dedicated connection may have retired.
+			if (pConnection->m_eState != CReactorConnection::CONN_READY)
+				return;
+		}
+		memmove(pConnection->m_Buffer, pConnection->m_Buffer + used,
+				pConnection->m_iReceived - used);
+		pConnection->m_iReceived -= used;
+	}
+
+	// Before pipelining the next request could only wait for this reply.
+	flushConnection(pConnection);
+}
+
+// Make a connected user available for the next open-loop arrival.
+void
+CCustomerReactor::releaseUser(CEmulatedUser *pUser)
+{
+	if (m_bStopping) {
+		retireUser(pUser);
+		return;
+	}
+	pUser->m_eState = CEmulatedUser::USER_IDLE;
+	m_IdleUsers.push_back(pUser);
+}
+
+void
+CCustomerReactor::retireUser(CEmulatedUser *pUser)
+{
+	if (pUser->m_pConnection->m_bDedicated)
+		closeConnection(pUser->m_pConnection);
+	m_Users[pUser->m_iRequestId] = NULL;
+	delete pUser->m_pCCE;
+	delete pUser;
+	--m_iActiveUsers;
+}
+
+// Connect again the connections whose retry time has come.  At the end of
+// the test the requests still waiting on them are dropped instead.
+void
+CCustomerReactor::retryConnections(long long llNow)
+{
+	for (size_t i = 0; i < m_Retries.size();) {
+		CReactorConnection *pConnection = m_Retries[i];
+		if (!m_bStopping && pConnection->m_llRetryTime > llNow) {
+			i++;
+			continue;
+		}
+		m_Retries[i] = m_Retries.back();
+		m_Retries.pop_back();
+
+		if (m_bStopping) {
+			while (!pConnection->m_Queue.empty()) {
+				retireUser(pConnection->m_Queue.front());
+				pConnection->m_Queue.pop_front();
+			}
+		} else {
+			connect(pConnection);
+		}
+	}
+}
+
+void
+CCustomerReactor::sendHello(CReactorConnection *pConnection)
+{
+	char *data = reinterpret_cast<char *>(&m_Hello);
+	while (pConnection->m_iOffset < sizeof(m_Hello)) {
+		struct iovec iov;
+		iov.iov_base = data + pConnection->m_iOffset;
+		iov.iov_len = sizeof(m_Hello) - pConnection->m_iOffset;
+		ssize_t sent = connectionSend(pConnection, &iov, 1);
+		if (sent > 0) {
+			pConnection->m_iOffset += sent;
+		} else if (sent == -1 && (errno == EAGAIN || errno == EINTR)) {
+			setInterest(pConnection, EPOLLOUT);
+			return;
+		} else {
+			failConnection(pConnection, CSocketErr::ERR_SOCKET_SEND);
+			return;
+		}
+	}
+
+	pConnection->m_eState = CReactorConnection::CONN_HELLO_REPLY;
+	pConnection->m_iOffset = 0;
+	pConnection->m_iReceived = 0;
+	memset(pConnection->m_Buffer, 0, sizeof(TMsgHelloReply));
+	setInterest(pConnection, EPOLLIN);
+
+	// A channel only rings once asked to, which receiving until there is
+	// nothing left does.
+	if (pConnection->m_pChannel != NULL)
+		receiveHelloReply(pConnection);
+}
+
+void
+CCustomerReactor::setInterest(CReactorConnection *pConnection, UINT32 events)
+{
+	// A shared-memory channel stays registered for its doorbell.
+	if (pConnection->m_iEvents == events || pConnection->m_pChannel != NULL)
+		return;
+
+	struct epoll_event ev;
+	ev.events = events;
+	ev.data.ptr = pConnection;
+	epoll_ctl(m_epfd, EPOLL_CTL_MOD, pConnection->m_iSockfd, &ev);
+	pConnection->m_iEvents = events;
+}
+
+void
+CCustomerReactor::startTxn(CEmulatedUser *pUser, long long llStartTime)
+{
+	// Only the input of the transaction is filled in and sent.
+	pUser->m_Request.TxnType = NULL_TXN;
+
+	// The CE picks the next transaction and hands its input to m_SUT.
+	pUser->m_pCCE->DoTxn();
+	if (pUser->m_Request.TxnType == NULL_TXN) {
+		if (m_bOpenLoop)
+			releaseUser(pUser);
+		else
+			think(pUser, m_pDriver->iPacingDelay);
+		return;
+	}
+
+	// record txn start time -- please, see TPC-E specification clause
+	// 6.2.1.3
+	pUser->m_llStartTime = llStartTime;
+	pUser->m_eState = CEmulatedUser::USER_QUEUED;
+	pUser->m_pConnection->m_Queue.push_back(pUser);
+	flushConnection(pUser->m_pConnection);
+}
+
+// Park the user on the timer wheel.
+void
+CCustomerReactor::think(CEmulatedUser *pUser, long long llDelayMs)
+{
+	pUser->m_eState = CEmulatedUser::USER_THINKING;
+	m_pTimers->schedule(pUser, monotonicMs() + llDelayMs);
+}
+
+void
+CCustomerReactor::run()
+{
+	m_pid = syscall(SYS_gettid);
+
+	char filename[iMaxPath + 1];
+	snprintf(filename, iMaxPath, "%s/Customer_%d.log",
+			m_pDriver->outputDirectory, m_pid);
+	m_pLog = new CEGenLogger(eDriverEGenLoader, 0, filename, &m_fmt);
+
+	m_pMixLog = CMixLogWriter::open(m_pDriver->outputDirectory)
+						->openRing(MIX_RING_REACTOR);
+	snprintf(filename, iMaxPath, "%s/error-ce-%d.log",
+			m_pDriver->outputDirectory, m_pid);
+	m_fLog.open(filename, ios::out);
+
+	m_pTimers = new CTimerWheel(monotonicMs());
+
+	// Connections shared by the users, dedicated ones are opened with each
+	// user.
+	for (int i = 0; i < m_pDriver->iConnections; i++) {
+		m_Connections.push_back(new CReactorConnection(false));
+		connect(m_Connections.back());
+	}
+
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	while (true) {
+		if (time(NULL) >= stop_time)
+			m_bStopping = true;
+
+		CEmulatedUser *pUser = m_pTimers->expire(monotonicMs());
+		while (pUser != NULL) {
+			CEmulatedUser *pNext = pUser->m_pNextTimer;
+			pUser->m_pNextTimer = NULL;
+			if (m_bStopping) {
+				retireUser(pUser);
+			} else {
+				startTxn(pUser, monotonicNs());
+			}
+			pUser = pNext;
+		}
+		if (!m_Retries.empty())
+			retryConnections(monotonicMs());
+
+		int timeout = REACTOR_MAX_WAIT_MS;
+		if (m_bOpenLoop && m_bStopping) {
+			// Arrivals that were never started are not part of the test.
+			m_Backlog.clear();
+			while (!m_IdleUsers.empty()) {
+				retireUser(m_IdleUsers.back());
+				m_IdleUsers.pop_back();
+			}
+		} else if (m_bOpenLoop) {
+			if (m_llArrivalStart == 0) {
+				// Arrivals start at the end of ramp-up.
+				m_InboxLock.lock();
+				bool bRampedUp = m_bInboxClosed;
+				m_InboxLock.unlock();
+				if (bRampedUp) {
+					m_llArrivalStart = monotonicNs();
+					m_dNextArrival = m_llArrivalStart;
+				}
+			}
+			if (m_llArrivalStart != 0) {
+				long long llNow = monotonicNs();
+				issueArrivals(llNow);
+				long long llWait
+						= ((long long) m_dNextArrival - llNow) / 1000000;
+				if (llWait < timeout)
+					timeout = (int) llWait;
+			}
+		}
+
+		if (m_bStopping && m_iActiveUsers == 0) {
+			m_InboxLock.lock();
+			bool bDone = m_bInboxClosed && m_Inbox.empty();
+			m_InboxLock.unlock();
+			if (bDone)
+				break;
+		}
+
+		// Wake up on every tick while users are waiting on the wheel or
+		// connections are waiting to be retried.
+		if ((m_pTimers->count() > 0 || !m_Retries.empty()) && timeout > 1)
+			timeout = 1;
+		int n = epoll_wait(m_epfd, events, REACTOR_MAX_EVENTS, timeout);
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.ptr == NULL) {
+				acceptUsers();
+			} else {
+				handleEvent(reinterpret_cast<CReactorConnection *>(
+									events[i].data.ptr),
+						events[i].events);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < m_Connections.size(); i++)
+		closeConnection(m_Connections[i]);
+
+	m_pMixLog->logStopTime(m_pid);
+	m_pMixLog->close();
+
+	cout << "Customer reactor # " << m_iReactorId << " (" << m_pid
+		 << ") terminated." << endl;
+}
+
+// Log Transaction Response Times
+void
+CCustomerReactor::logResponseTime(int iStatus, int iTxnType, INT64 llRT,
+		const TMsgServerTimes *pServer)
+{
+	m_pMixLog->logResponseTime(iStatus, iTxnType, llRT, m_pid, pServer);
+}
+
+// logErrorMessage
+void
+CCustomerReactor::logErrorMessage(const string sErr)
+{
+	cerr << sErr;
+	m_fLog << sErr;
+	m_fLog.flush();
+}
+
+// reactor thread
+void *
+reactorWorkerThread(void *data)
+{
+	CCustomerReactor *pReactor = reinterpret_cast<CCustomerReactor *>(data);
+	pReactor->run();
+	return NULL;
+}
@@ -8,12 +8,14 @@
  */
 
 #include <unistd.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 
 #include "DM.h"
 
 #include "Driver.h"
 #include "Customer.h"
+#include "CustomerReactor.h"
 
 // global variables
 pthread_t *g_tid = NULL;
@@ -24,7 +26,9 @@ CDriver::CDriver(const DataFileManager &inputFiles, char *szInDir,
 		TIdent iConfiguredCustomerCount, TIdent iActiveCustomerCount,
 		INT32 iScaleFactor, INT32 iDaysOfInitialTrades, UINT32 iSeed,
 		char *szBHaddr, int iBHlistenPort, int iUsers, int iPacingDelay,
-		char *outputDirectory)
+		char *outputDirectory, int iReactors, int iConnections,
+		const CArrivalProfile &arrivals)
+: m_InputFiles(inputFiles), m_Arrivals(arrivals)
 {
 	strncpy(this->szInDir, szInDir, iMaxPath);
 	this->szInDir[iMaxPath] = '\0';
@@ -38,6 +42,8 @@ CDriver::CDriver(const DataFileManager &inputFiles, char *szInDir,
 	this->iBHlistenPort = iBHlistenPort;
 	this->iUsers = iUsers;
 	this->iPacingDelay = iPacingDelay;
+	this->iReactors = iReactors;
+	this->iConnections = iConnections;
 	strncpy(this->outputDirectory, outputDirectory, iMaxPath);
 	this->outputDirectory[iMaxPath] = '\0';
 
@@ -48,8 +54,7 @@ CDriver::CDriver(const DataFileManager &inputFiles, char *szInDir,
 
 	snprintf(filename, iMaxPath, "%s/Driver_Error.log", outputDirectory);
 	m_fLog.open(filename, ios::out);
-	snprintf(filename, iMaxPath, "%s/%s", outputDirectory, CE_MIX_LOG_NAME);
-	m_fMix.open(filename, ios::out);
+	m_pMixLog = CMixLogWriter::open(outputDirectory)->openRing(MIX_RING_USER);
 
 	cout << "initializing data maintenance..." << endl;
 
@@ -84,11 +89,10 @@ customerWorkerThread(void *data)
 	ts.tv_sec = (time_t) (pThrParam->pDriver->iPacingDelay / 1000);
 	ts.tv_nsec = (long) (pThrParam->pDriver->iPacingDelay % 1000) * 1000000;
 
-	const DataFileManager inputFiles(pThrParam->pDriver->szInDir,
-			pThrParam->pDriver->iConfiguredCustomerCount,
-			pThrParam->pDriver->iActiveCustomerCount,
-			TPCE::DataFileManager::IMMEDIATE_LOAD);
-	customer = new CCustomer(inputFiles, pThrParam->pDriver->szInDir,
+	// The input files were fully loaded up front (IMMEDIATE_LOAD) and are
+	// only read from here on, so every customer can share the same instance.
+	customer = new CCustomer(pThrParam->pDriver->m_InputFiles,
+			pThrParam->pDriver->szInDir,
 			pThrParam->pDriver->iConfiguredCustomerCount,
 			pThrParam->pDriver->iActiveCustomerCount,
 			pThrParam->pDriver->iScaleFactor,
@@ -155,12 +159,45 @@ entryCustomerWorkerThread(void *data)
 	}
 }
 
+// entry point for reactor thread
+void
+entryReactorThread(CCustomerReactor *pReactor, int iReactorId)
+{
+	pthread_attr_t threadAttribute; // thread attribute
+
+	try {
+		// initialize the attribute object
+		int status = pthread_attr_init(&threadAttribute);
+		if (status != 0) {
+			throw new CThreadErr(CThreadErr::ERR_THREAD_ATTR_INIT);
+		}
+
+		// create the thread in the joinable state
+		status = pthread_create(&g_tid[iReactorId], &threadAttribute,
+				&reactorWorkerThread, reinterpret_cast<void *>(pReactor));
+
+		if (status != 0) {
+			throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE);
+		}
+	} catch (CThreadErr *pErr) {
+		cerr << "Reactor " << iReactorId << " didn't spawn correctly" << endl
+			 << endl
+			 << "Error: " << pErr->ErrorText() << " at entryReactorThread"
+			 << endl;
+		exit(1);
+	}
+}
+
 // Destructor
 CDriver::~CDriver()
 {
 	delete m_pCDM;
 	delete m_pCDMSUT;
 
+	// Every customer has finished, write out the rest of the mix log.
+	m_pMixLog->close();
+	CMixLogWriter::close();
+
 	m_fLog.close();
 
 	delete m_pDriverCETxnSettings;
@@ -171,9 +208,10 @@ CDriver::~CDriver()
 void
 CDriver::runTest(int iSleep, int iTestDuration)
 {
-	// Create enough space for all of the users plus an additional thread for
-	// data maintenance.
-	g_tid = (pthread_t *) malloc(sizeof(pthread_t) * (iUsers + 1));
+	// Create enough space for all of the users, or all of the reactors that
+	// run them, plus an additional thread for data maintenance.
+	int iThreads = iReactors > 0 ? iReactors : iUsers;
+	g_tid = (pthread_t *) malloc(sizeof(pthread_t) * (iThreads + 1));
 
 	// before starting the test run Trade-Cleanup transaction
 	cout << endl
@@ -202,20 +240,33 @@ CDriver::runTest(int iSleep, int iTestDuration)
 	dtAux.AddMinutes((iTestDuration + threads_start_time) / 60);
 	cout << "Estimated end time " << dtAux.ToStr(02) << endl;
 
+	logMemoryUsage("before ramp-up");
 	cout << ">> Start of ramp-up." << endl;
 
 	// start thread that runs the Data Maintenance transaction
 	entryDMWorkerThread(this);
 
+	// In event-driven mode the users are spread over a few reactor threads
+	// instead of getting a thread each.
+	vector<CCustomerReactor *> reactors;
+	for (int i = 1; i <= iReactors; i++) {
+		reactors.push_back(new CCustomerReactor(this, i));
+		entryReactorThread(reactors.back(), i);
+	}
+
 	for (int i = 1; i <= iUsers; i++) {
-		// parameter for the new thread
-		PCustomerThreadParam pThrParam = new TCustomerThreadParam;
+		if (iReactors > 0) {
+			reactors[(i - 1) % iReactors]->addUser(i);
+		} else {
+			// parameter for the new thread
+			PCustomerThreadParam pThrParam = new TCustomerThreadParam;
 
-		// zero the structure
-		pThrParam->UniqueId = i;
-		pThrParam->pDriver = this;
+			// zero the structure
+			pThrParam->UniqueId = i;
+			pThrParam->pDriver = this;
 
-		entryCustomerWorkerThread(reinterpret_cast<void *>(pThrParam));
+			entryCustomerWorkerThread(reinterpret_cast<void *>(pThrParam));
+		}
 
 		// Sleep for between starting terminals
 		while (nanosleep(&ts, &rem) == -1) {
@@ -231,20 +282,29 @@ CDriver::runTest(int iSleep, int iTestDuration)
 		}
 	}
 
+	for (size_t i = 0; i < reactors.size(); i++) {
+		reactors[i]->closeInbox();
+	}
+
 	// mark end of ramp-up
 	pid_t pid = syscall(SYS_gettid);
-	m_fMix << (int) time(NULL) << ",START,,," << pid << endl;
+	m_pMixLog->logStartTime(pid);
 
 	cout << ">> End of ramp-up." << endl;
+	logMemoryUsage("after ramp-up");
 
 	// wait until all threads quit
 	// 0 represents the Data-Maintenance thread
-	for (int i = 0; i <= iUsers; i++) {
+	for (int i = 0; i <= iThreads; i++) {
 		if (pthread_join(g_tid[i], NULL) != 0) {
 			throw new CThreadErr(
 					CThreadErr::ERR_THREAD_JOIN, "Driver::RunTest");
 		}
 	}
+
+	for (size_t i = 0; i < reactors.size(); i++) {
+		delete reactors[i];
+	}
 }
 
 // DM worker thread
@@ -302,6 +362,32 @@ entryDMWorkerThread(CDriver *ptr)
 	}
 }
 
+// Report the resident set size so memory growth with the number of users can
+// be tracked.
+void
+CDriver::logMemoryUsage(const char *szWhen)
+{
+	long rssKB = 0;
+	FILE *fp = fopen("/proc/self/statm", "r");
+	if (fp != NULL) {
+		long size, resident;
+		if (fscanf(fp, "%ld %ld", &size, &resident) == 2) {
+			rssKB = resident * (sysconf(_SC_PAGESIZE) / 1024);
+		}
+		fclose(fp);
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	ostringstream osMsg;
+	osMsg << "Driver RSS " << szWhen << ": " << rssKB << " kB (peak "
+		  << usage.ru_maxrss << " kB, " << iUsers << " users)" << endl;
+	m_LogLock.lock();
+	cout << osMsg.str();
+	m_LogLock.unlock();
+}
+
 // logErrorMessage
 void
 CDriver::logErrorMessage(const string sErr)
@@ -11,6 +11,7 @@
 // constructor.
 
 #include "Driver.h"
+#include "MetricsServer.h"
 #include "DBT5Consts.h"
 
 // Establish defaults for command line options
@@ -26,6 +27,11 @@ int iTestDuration = 0;
 int iSleep = 1000; // msec between thread creation
 int iUsers = 0; // # users
 int iPacingDelay = 0;
+int iReactors = 0; // reactor threads, 0 for one thread per user
+int iConnections = 0; // pipelined connections per reactor, 0 for one per user
+CArrivalProfile arrivals; // open-loop arrival rate, 0 for closed loop
+int iLatencyInterval = 0; // seconds between percentile reports
+int iMetricsPort = 0; // live metrics port, 0 to disable
 
 char szInDir[iMaxPath + 1]; // path to EGen input files
 char outputDirectory[iMaxPath + 1] = "."; // path to output files
@@ -41,11 +47,32 @@ usage()
 		 << "   Option      Default    Description" << endl
 		 << "   ==========  =========  ==============================="
 		 << endl;
+	printf("   -A string   fixed      Open-loop arrivals: fixed or poisson\n");
+	printf("   -H integer  %-9d  seconds between latency percentile\n",
+			iLatencyInterval);
+	printf("                          reports, 0 for the end of the test\n");
+	printf("   -M integer  %-9d  local port serving live metrics,\n",
+			iMetricsPort);
+	printf("                          0 to disable\n");
+	printf("   -P string              Open-loop ramp profile:\n");
+	cout << "                          step:<max rate>:<increment>:<seconds>"
+		 << endl;
+	printf("                          linear:<final rate>:<seconds>\n");
+	printf("   -R number   %-9g  Open-loop target rate (txn/s),\n",
+			arrivals.dRate);
+	printf("                          0 for closed loop\n");
 	printf("   -c integer  %-9ld  Configured customer count\n",
 			iActiveCustomerCount);
 	printf("   -d integer             Duration of the test (seconds)\n");
+	printf("   -e integer  %-9d  # of reactor threads,\n", iReactors);
+	printf("                          0 for thread per user\n");
 	printf("   -f integer  %-9d  # of customers per 1 TRTPS\n", iScaleFactor);
-	printf("   -h string   %-9s  Brokerage House address\n", szBHaddr);
+	printf("   -h string   %-9s  Brokerage House address, or unix:<path>\n",
+			szBHaddr);
+	printf("                          or shm:<path> when co-located\n");
+	printf("   -k integer  %-9d  # of pipelined connections per reactor,\n",
+			iConnections);
+	printf("                          0 for one connection per user\n");
 	printf("   -i string   %-9s  Path to EGen flat_in directory\n", szInDir);
 	printf("   -n integer  %-9d  millisecond delay between transactions\n",
 			iPacingDelay);
@@ -96,12 +123,41 @@ parse_command_line(int argc, char *argv[])
 
 		// Parse the switch
 		switch (*sp) {
+		case 'A':
+			if (strcmp(vp, "poisson") == 0) {
+				arrivals.bPoisson = true;
+			} else if (strcmp(vp, "fixed") != 0) {
+				usage();
+				cout << endl
+					 << "Error: Unknown arrival process: " << vp << endl;
+				exit(1);
+			}
+			break;
+		case 'H':
+			iLatencyInterval = atoi(vp);
+			break;
+		case 'M':
+			iMetricsPort = atoi(vp);
+			break;
+		case 'P':
+			if (!arrivals.parseRamp(vp)) {
+				usage();
+				cout << endl << "Error: Invalid ramp profile: " << vp << endl;
+				exit(1);
+			}
+			break;
+		case 'R':
+			arrivals.dRate = atof(vp);
+			break;
 		case 'c':
 			iActiveCustomerCount = atol(vp);
 			break;
 		case 'd':
 			iTestDuration = atoi(vp);
 			break;
+		case 'e':
+			iReactors = atoi(vp);
+			break;
 		case 'f':
 			iScaleFactor = atoi(vp);
 			break;
@@ -113,6 +169,9 @@ parse_command_line(int argc, char *argv[])
 			strncpy(szInDir, vp, iMaxPath);
 			szInDir[iMaxPath] = '\0';
 			break;
+		case 'k':
+			iConnections = atoi(vp);
+			break;
 		case 'n':
 			iPacingDelay = atoi(vp);
 			break;
@@ -205,6 +264,13 @@ ValidateParameters()
 		bRet = false;
 	}
 
+	if (arrivals.eRamp != CArrivalProfile::RAMP_NONE) {
+		if (arrivals.dRate <= 0) {
+			cerr << "A ramp profile (-P) needs a target rate (-R)." << endl;
+			bRet = false;
+		}
+	}
+
 	// iTestDuration must be assigned
 	if (iTestDuration == 0) {
 		cerr << "The duration of the test must be specified." << endl;
@@ -241,6 +307,16 @@ main(int argc, char *argv[])
 		return 2; // exit returning a non-zero code
 	}
 
+	// Open-loop arrivals are issued by the reactors, the users only provide
+	// the connections.
+	if (arrivals.dRate > 0 && iReactors == 0) {
+		iReactors = 1;
+	}
+	// Only the reactors share connections between users.
+	if (iConnections > 0 && iReactors == 0) {
+		iReactors = 1;
+	}
+
 	// Let the user know what settings will be used.
 	cout << "Using the following settings:" << endl << endl;
 
@@ -256,20 +332,54 @@ main(int argc, char *argv[])
 	cout << "Scale Factor: " << iScaleFactor << endl << endl;
 
 	cout << "User Threads: " << iUsers << endl;
+	cout << "Reactor Threads: " << iReactors << endl;
+	if (iConnections > 0)
+		cout << "Pipelined connections per reactor: " << iConnections << endl;
+	if (arrivals.dRate > 0) {
+		cout << "Open-loop target rate (txn/s): " << arrivals.dRate << " "
+			 << (arrivals.bPoisson ? "poisson" : "fixed") << endl;
+		if (arrivals.eRamp == CArrivalProfile::RAMP_STEP)
+			cout << "Ramp: +" << arrivals.dIncrement << " txn/s every "
+				 << arrivals.iRampSeconds << " s up to " << arrivals.dEndRate
+				 << endl;
+		else if (arrivals.eRamp == CArrivalProfile::RAMP_LINEAR)
+			cout << "Ramp: linear to " << arrivals.dEndRate << " txn/s over "
+				 << arrivals.iRampSeconds << " s" << endl;
+	}
 	cout << "Sleep between creating users: " << iSleep << endl << endl;
 
 	cout << "Test duration (sec): " << iTestDuration << endl;
 	cout << "Pacing Delay (msec): " << iPacingDelay << endl << endl;
 	cout << "Unique ID (seed): " << iSeed << endl;
+	cout << "Latency report interval (sec): " << iLatencyInterval << endl;
+	cout << "Metrics port: " << iMetricsPort << endl;
 
 	try {
+		// Load the EGen input files once; the same read-only instance is
+		// handed to data maintenance and to every customer thread.
+		struct timespec tsLoadStart, tsLoadEnd;
+		clock_gettime(CLOCK_MONOTONIC, &tsLoadStart);
 		const DataFileManager inputFiles(szInDir, iConfiguredCustomerCount,
 				iActiveCustomerCount, TPCE::DataFileManager::IMMEDIATE_LOAD);
+		clock_gettime(CLOCK_MONOTONIC, &tsLoadEnd);
+		cout << "EGen input files loaded in "
+			 << (double) (tsLoadEnd.tv_sec - tsLoadStart.tv_sec)
+						+ (double) (tsLoadEnd.tv_nsec - tsLoadStart.tv_nsec)
+								/ 1000000000.0
+			 << " seconds" << endl;
+
+		CMixLogWriter::setReportInterval(iLatencyInterval);
 		CDriver Driver(inputFiles, szInDir, iConfiguredCustomerCount,
 				iActiveCustomerCount, iScaleFactor, iDaysOfInitialTrades,
 				iSeed, szBHaddr, iBHListenerPort, iUsers, iPacingDelay,
-				outputDirectory);
+				outputDirectory, iReactors, iConnections, arrivals);
+
+		CMetricsServer *pMetrics = NULL;
+		if (iMetricsPort > 0) {
+			pMetrics = new CMetricsServer(iMetricsPort, outputDirectory);
+		}
 		Driver.runTest(iSleep, iTestDuration);
+		delete pMetrics;
 
 	} catch (CBaseErr *pErr) {
 		cout << endl
@@ -0,0 +1,262 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Once a second the metrics thread merges the per-thread counters and
+ * histograms kept with the mix log rings, so the transaction path never
+ * takes a lock for it, and renders the page returned to every request.
+ */
+
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "MetricsServer.h"
+#include "CommonStructs.h"
+#include "CThreadErr.h"
+#include "DBT5Consts.h"
+
+#define METRICS_SAMPLE_MS 1000
+
+static const char *szOutcomeName[TXN_OUTCOMES]
+		= { "success", "rollback", "warning", "error" };
+
+static double
+monotonicSeconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+// metrics thread
+void *
+metricsServerThread(void *data)
+{
+	CMetricsServer *pServer = reinterpret_cast<CMetricsServer *>(data);
+
+	double dLastSample = monotonicSeconds();
+	while (!pServer->m_bStop.load(std::memory_order_acquire)) {
+		int timeout = METRICS_SAMPLE_MS
+				- (int) ((monotonicSeconds() - dLastSample) * 1000);
+		if (timeout < 0)
+			timeout = 0;
+
+		struct pollfd pfd;
+		pfd.fd = pServer->m_iListenfd;
+		pfd.events = POLLIN;
+		int n = poll(&pfd, 1, timeout);
+
+		double dNow = monotonicSeconds();
+		if (dNow - dLastSample >= METRICS_SAMPLE_MS / 1000.0) {
+			pServer->m_dElapsed = dNow - dLastSample;
+			pServer->sample();
+			pServer->render();
+			dLastSample = dNow;
+		}
+
+		if (n > 0 && (pfd.revents & POLLIN))
+			pServer->serve();
+	}
+
+	return NULL;
+}
+
+// Constructor
+CMetricsServer::CMetricsServer(int iPort, const char *outputDirectory)
+: m_iPort(iPort), m_bStop(false), m_dElapsed(1)
+{
+	m_pMixLog = CMixLogWriter::open(outputDirectory);
+
+	m_iListenfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (m_iListenfd == -1) {
+		throw new CSocketErr(CSocketErr::ERR_SOCKET_CREATE,
+				"CMetricsServer::CMetricsServer");
+	}
+
+	int on = 1;
+	setsockopt(m_iListenfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	// Only serve the local host.
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(m_iPort);
+	if (bind(m_iListenfd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_BIND, "CMetricsServer::CMetricsServer");
+	}
+	if (listen(m_iListenfd, 16) == -1) {
+		throw new CSocketErr(CSocketErr::ERR_SOCKET_LISTEN,
+				"CMetricsServer::CMetricsServer");
+	}
+
+	sample();
+	render();
+
+	if (pthread_create(&m_tid, NULL, &metricsServerThread,
+				reinterpret_cast<void *>(this))
+			!= 0) {
+		throw new CThreadErr(CThreadErr::ERR_THREAD_CREATE,
+				"CMetricsServer::CMetricsServer");
+	}
+
+	cout << "Serving metrics on http://127.0.0.1:" << m_iPort << "/metrics"
+		 << endl;
+}
+
+// Destructor
+CMetricsServer::~CMetricsServer()
+{
+	m_bStop.store(true, std::memory_order_release);
+	pthread_join(m_tid, NULL);
+	close(m_iListenfd);
+}
+
+void
+CMetricsServer::render()
+{
+	ostringstream page;
+
+	page << "# HELP dbt5_transactions_total Transactions completed by outcome."
+		 << endl
+		 << "# TYPE dbt5_transactions_total counter" << endl;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		for (int j = 0; j < TXN_OUTCOMES; j++) {
+			if (m_Total.outcomes[i][j] == 0)
+				continue;
+			page << "dbt5_transactions_total{txn=\"" << szTransactionName[i]
+				 << "\",outcome=\"" << szOutcomeName[j] << "\"} "
+				 << m_Total.outcomes[i][j] << endl;
+		}
+	}
+
+	page << "# HELP dbt5_transactions_per_second Transactions completed "
+			"during the last second."
+		 << endl
+		 << "# TYPE dbt5_transactions_per_second gauge" << endl;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		if (m_Total.histograms[i].total() == 0)
+			continue;
+		page << "dbt5_transactions_per_second{txn=\"" << szTransactionName[i]
+			 << "\"} " << m_LastSecond.histograms[i].total() / m_dElapsed
+			 << endl;
+	}
+
+	page << "# HELP dbt5_socket_errors_total Requests that failed to reach "
+			"the Brokerage House."
+		 << endl
+		 << "# TYPE dbt5_socket_errors_total counter" << endl
+		 << "dbt5_socket_errors_total " << m_Total.socketErrors << endl;
+
+	static const double quantiles[] = { 0.5, 0.9, 0.95, 0.99, 0.999, 0.9999 };
+	page << "# HELP dbt5_response_time_seconds Response time quantiles "
+			"during the last second."
+		 << endl
+		 << "# TYPE dbt5_response_time_seconds gauge" << endl;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		if (m_LastSecond.histograms[i].total() == 0)
+			continue;
+		for (size_t j = 0; j < sizeof(quantiles) / sizeof(quantiles[0]);
+				j++) {
+			page << "dbt5_response_time_seconds{txn=\""
+				 << szTransactionName[i] << "\",quantile=\"" << quantiles[j]
+				 << "\"} "
+				 << m_LastSecond.histograms[i].percentile(quantiles[j] * 100)
+							/ 1000000000.0
+				 << endl;
+		}
+	}
+
+	// Parts are only known for transactions the Brokerage House timed.
+	static const double partQuantiles[] = { 0.5, 0.99 };
+	page << "# HELP dbt5_response_time_part_seconds Quantiles of the parts of "
+			"the response time during the last second."
+		 << endl
+		 << "# TYPE dbt5_response_time_part_seconds gauge" << endl;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		for (int j = 0; j < LATENCY_PARTS; j++) {
+			const CLatencyHistogram &histogram = m_LastSecond.parts[i][j];
+			if (histogram.total() == 0)
+				continue;
+			for (size_t k = 0;
+					k < sizeof(partQuantiles) / sizeof(partQuantiles[0]);
+					k++) {
+				page << "dbt5_response_time_part_seconds{txn=\""
+					 << szTransactionName[i] << "\",part=\""
+					 << szLatencyPartName[j] << "\",quantile=\""
+					 << partQuantiles[k] << "\"} "
+					 << histogram.percentile(partQuantiles[k] * 100)
+								/ 1000000000.0
+					 << endl;
+			}
+		}
+	}
+
+	m_sPage = page.str();
+}
+
+void
+CMetricsServer::sample()
+{
+	CLatencySnapshot current;
+	m_pMixLog->mergeLatencies(&current);
+
+	m_LastSecond = current;
+	m_LastSecond.subtract(m_Total);
+	m_Total = current;
+}
+
+// Answer one request with the last rendered page.
+void
+CMetricsServer::serve()
+{
+	int fd = accept(m_iListenfd, NULL, NULL);
+	if (fd == -1)
+		return;
+
+	// Don't let a slow client hold up sampling.
+	struct timeval tv;
+	tv.tv_sec = 1;
+	tv.tv_usec = 0;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	// Read the request headers, whatever was asked for gets the metrics.
+	char request[4096];
+	size_t length = 0;
+	while (length < sizeof(request) - 1) {
+		ssize_t received = recv(fd, request + length,
+				sizeof(request) - 1 - length, 0);
+		if (received <= 0)
+			break;
+		length += received;
+		request[length] = '\0';
+		if (strstr(request, "\r\n\r\n") != NULL)
+			break;
+	}
+
+	ostringstream response;
+	response << "HTTP/1.0 200 OK\r\n"
+			 << "Content-Type: text/plain; version=0.0.4\r\n"
+			 << "Content-Length: " << m_sPage.size() << "\r\n"
+			 << "Connection: close\r\n\r\n"
+			 << m_sPage;
+	string sResponse = response.str();
+
+	const char *data = sResponse.c_str();
+	size_t remaining = sResponse.size();
+	while (remaining > 0) {
+		ssize_t sent = send(fd, data, remaining, MSG_NOSIGNAL);
+		if (sent <= 0)
+			break;
+		data += sent;
+		remaining -= sent;
+	}
+	close(fd);
+}
@@ -0,0 +1,140 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Convert a binary mix log into the comma separated mix log format read by
+ * dbt5-post-process, and optionally list the parts of the response times of
+ * the transactions the Brokerage House timed.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MixLog.h"
+
+void
+usage()
+{
+	cout << "Usage: MixLogConvert <mix.bin> [mix.log [server.csv]]" << endl
+		 << endl
+		 << "Writes to standard output when no output file is given." << endl
+		 << "server.csv lists the parts of each response time in seconds."
+		 << endl;
+}
+
+static void
+writeServerTimes(FILE *out, const TMixLogRecord *pRecord)
+{
+	const TMsgServerTimes &server = pRecord->Server;
+	fprintf(out, "%lld,%d,%d,%.9g,%d,%.9g,%.9g",
+			(long long) (pRecord->llTime / 1000000000), pRecord->iTxnType,
+			pRecord->iStatus, pRecord->llResponse / 1000000000.0,
+			pRecord->iPid,
+			(pRecord->llResponse - server.llTotal) / 1000000000.0,
+			server.llDispatch / 1000000000.0);
+	for (int i = 0; i < SERVER_TIME_FRAMES; i++) {
+		fprintf(out, ",%.9g", server.llFrame[i] / 1000000000.0);
+	}
+	fprintf(out, ",%.9g,%.9g,%.9g\n", server.llCommit / 1000000000.0,
+			server.llSendToMarket / 1000000000.0,
+			server.llTotal / 1000000000.0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc < 2 || argc > 4) {
+		usage();
+		return 1;
+	}
+
+	int fd = open(argv[1], O_RDONLY);
+	if (fd == -1) {
+		cerr << "cannot open " << argv[1] << endl;
+		return 1;
+	}
+
+	struct stat sb;
+	if (fstat(fd, &sb) == -1 || (size_t) sb.st_size < sizeof(TMixLogHeader)) {
+		cerr << argv[1] << " is not a mix log" << endl;
+		return 1;
+	}
+
+	char *data = (char *) mmap(
+			NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		cerr << "cannot map " << argv[1] << endl;
+		return 1;
+	}
+	close(fd);
+
+	PMixLogHeader pHeader = reinterpret_cast<PMixLogHeader>(data);
+	if (strncmp(pHeader->szMagic, MIX_LOG_MAGIC, sizeof(pHeader->szMagic)) != 0
+			|| pHeader->iVersion != MIX_LOG_VERSION
+			|| pHeader->iRecordSize != sizeof(TMixLogRecord)) {
+		cerr << argv[1] << " is not a version " << MIX_LOG_VERSION
+			 << " mix log" << endl;
+		return 1;
+	}
+
+	FILE *out = stdout;
+	if (argc >= 3) {
+		out = fopen(argv[2], "w");
+		if (out == NULL) {
+			cerr << "cannot create " << argv[2] << endl;
+			return 1;
+		}
+	}
+
+	FILE *server = NULL;
+	if (argc == 4) {
+		server = fopen(argv[3], "w");
+		if (server == NULL) {
+			cerr << "cannot create " << argv[3] << endl;
+			return 1;
+		}
+		fprintf(server, "time,txn,status,response,pid,network,dispatch");
+		for (int i = 1; i <= SERVER_TIME_FRAMES; i++) {
+			fprintf(server, ",frame%d", i);
+		}
+		fprintf(server, ",commit,send_to_market,server\n");
+	}
+
+	// A record cut short by a crash of the driver is ignored.
+	size_t count
+			= (sb.st_size - sizeof(TMixLogHeader)) / sizeof(TMixLogRecord);
+	PMixLogRecord pRecord
+			= reinterpret_cast<PMixLogRecord>(data + sizeof(TMixLogHeader));
+	for (size_t i = 0; i < count; i++, pRecord++) {
+		switch (pRecord->iKind) {
+		case MIX_RECORD_TXN:
+			fprintf(out, "%lld,%d,%d,%.9g,%d\n",
+					(long long) (pRecord->llTime / 1000000000),
+					pRecord->iTxnType, pRecord->iStatus,
+					pRecord->llResponse / 1000000000.0, pRecord->iPid);
+			if (server != NULL && pRecord->Server.llTotal > 0)
+				writeServerTimes(server, pRecord);
+			break;
+		case MIX_RECORD_START:
+			fprintf(out, "%lld,START,,,%d\n",
+					(long long) (pRecord->llTime / 1000000000), pRecord->iPid);
+			break;
+		case MIX_RECORD_STOP:
+			fprintf(out, "%lld,STOP,,,%d\n",
+					(long long) (pRecord->llTime / 1000000000), pRecord->iPid);
+			break;
+		}
+	}
+
+	if (out != stdout)
+		fclose(out);
+	if (server != NULL)
+		fclose(server);
+	munmap(data, sb.st_size);
+
+	return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Measure what the harness transport costs per transaction.  A server
+ * process answers framed TRADE_STATUS requests at once, the way the
+ * Brokerage House frames its replies, so that the response times and the
+ * CPU time used on both sides are those of the transport alone.
+ */
+
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "CSocket.h"
+#include "CommonStructs.h"
+#include "LatencyHistogram.h"
+
+int iRequests = 100000;
+int iWarmUp = 1000;
+int iPort = 30050;
+// Leaves room for the transport prefix in an address.
+char szPath[iMaxHostname - 4] = "";
+
+void
+usage()
+{
+	cout << "Usage: TransportBenchmark [options] [tcp] [unix] [shm]" << endl
+		 << endl;
+	cout << "   Option      Default    Description" << endl;
+	cout << "   =========   =========  ===============" << endl;
+	printf("   -n integer  %-9d  Requests per transport\n", iRequests);
+	printf("   -p integer  %-9d  TCP port on the loopback interface\n", iPort);
+	cout << "   -s string              Unix-domain socket path," << endl
+		 << "                          /tmp/dbt5-transport-<pid> by default"
+		 << endl;
+	cout << endl << "All three transports are measured when none is named."
+		 << endl;
+}
+
+static long long
+monotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+cpuSeconds(const struct rusage &usage)
+{
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0
+			+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+// Answer requests until the client goes away.
+static void
+serve(const char *address, int readyfd)
+{
+	CSocket listener;
+	listener.dbt5Listen(address, iPort);
+	char ready = 1;
+	if (write(readyfd, &ready, 1) != 1)
+		return;
+	close(readyfd);
+
+	CSocket sock;
+	sock.setSocketFd(listener.dbt5Accept());
+
+	TMsgHeader header;
+	TMsgDriverBrokerage request;
+	TMsgPipelinedReply reply;
+	memset(&reply, 0, sizeof(reply));
+	try {
+		while (true) {
+			sock.dbt5Receive(&header, wireHeaderSize(WIRE_VERSION));
+			if (header.iLength > sizeof(request.TxnInput))
+				break;
+			sock.dbt5Receive(&request.TxnInput, header.iLength);
+			reply.iRequestId = header.iRequestId;
+			sock.dbt5Send(&reply, sizeof(reply));
+		}
+	} catch (CSocketErr *pErr) {
+		delete pErr;
+	}
+}
+
+static bool
+benchmark(const char *name, const char *address, const char *listenAddress)
+{
+	int readyfds[2];
+	if (pipe(readyfds) == -1) {
+		cerr << "cannot create pipe" << endl;
+		return false;
+	}
+
+	struct rusage childrenBefore;
+	getrusage(RUSAGE_CHILDREN, &childrenBefore);
+
+	pid_t pid = fork();
+	if (pid == -1) {
+		cerr << "cannot fork server" << endl;
+		return false;
+	}
+	if (pid == 0) {
+		close(readyfds[0]);
+		try {
+			serve(listenAddress, readyfds[1]);
+		} catch (CSocketErr *pErr) {
+			cerr << name << " server: " << pErr->ErrorText() << endl;
+		}
+		_exit(0);
+	}
+
+	close(readyfds[1]);
+	char ready;
+	bool bReady = read(readyfds[0], &ready, 1) == 1;
+	close(readyfds[0]);
+	if (!bReady) {
+		cerr << name << ": server did not start" << endl;
+		waitpid(pid, NULL, 0);
+		return false;
+	}
+
+	CLatencyHistogram histogram;
+	struct rusage before, after;
+	long long llElapsed = 0;
+	bool ok = true;
+	try {
+		CSocket sock(const_cast<char *>(address), iPort);
+		sock.dbt5Connect();
+
+		TMsgHeader header;
+		TMsgDriverBrokerage request;
+		TMsgPipelinedReply reply;
+		memset(&header, 0, sizeof(header));
+		memset(&request, 0, sizeof(request));
+		header.iVersion = WIRE_VERSION;
+		header.iTxnType = TRADE_STATUS;
+		header.iLength = txnInputSize(TRADE_STATUS);
+
+		for (int i = -iWarmUp; i < iRequests; i++) {
+			if (i == 0) {
+				getrusage(RUSAGE_SELF, &before);
+				llElapsed = monotonicNs();
+			}
+
+			long long llStart = monotonicNs();
+			header.iRequestId = i;
+			struct iovec iov[2];
+			iov[0].iov_base = &header;
+			iov[0].iov_len = wireHeaderSize(WIRE_VERSION);
+			iov[1].iov_base = &request.TxnInput;
+			iov[1].iov_len = header.iLength;
+			sock.dbt5Send(iov, 2);
+			sock.dbt5Receive(&reply, sizeof(reply));
+			if (reply.iRequestId != (UINT32) i) {
+				cerr << name << ": reply to request " << reply.iRequestId
+					 << " instead of " << i << endl;
+				ok = false;
+				break;
+			}
+			if (i >= 0)
+				histogram.add(
+						CLatencyHistogram::index(monotonicNs() - llStart), 1);
+		}
+
+		llElapsed = monotonicNs() - llElapsed;
+		getrusage(RUSAGE_SELF, &after);
+		sock.dbt5Disconnect();
+	} catch (CSocketErr *pErr) {
+		cerr << name << ": " << pErr->ErrorText() << endl;
+		delete pErr;
+		ok = false;
+	}
+
+	waitpid(pid, NULL, 0);
+	if (!ok)
+		return false;
+
+	struct rusage childrenAfter;
+	getrusage(RUSAGE_CHILDREN, &childrenAfter);
+
+	// The server's time includes its start, which is small next to the
+	// requests.
+	printf("%-9s %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", name,
+			iRequests / (llElapsed / 1000000000.0),
+			llElapsed / 1000.0 / iRequests,
+			histogram.percentile(50) / 1000.0,
+			histogram.percentile(99) / 1000.0,
+			histogram.percentile(99.9) / 1000.0,
+			(cpuSeconds(after) - cpuSeconds(before)) * 1000000 / iRequests,
+			(cpuSeconds(childrenAfter) - cpuSeconds(childrenBefore))
+					* 1000000 / (iRequests + iWarmUp));
+	return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+	vector<string> transports;
+	for (int arg = 1; arg < argc; ++arg) {
+		char *sp = argv[arg];
+		if (*sp != '-') {
+			if (strcmp(sp, "tcp") != 0 && strcmp(sp, "unix") != 0
+					&& strcmp(sp, "shm") != 0) {
+				usage();
+				cout << endl << "Error: Unknown transport: " << sp << endl;
+				return 1;
+			}
+			transports.push_back(sp);
+			continue;
+		}
+
+		++sp;
+		char *vp = sp + 1;
+		if (*vp == 0 && arg + 1 < argc)
+			vp = argv[++arg];
+
+		switch (*sp) {
+		case 'n':
+			iRequests = atoi(vp);
+			break;
+		case 'p':
+			iPort = atoi(vp);
+			break;
+		case 's':
+			strncpy(szPath, vp, sizeof(szPath) - 1);
+			szPath[sizeof(szPath) - 1] = '\0';
+			break;
+		default:
+			usage();
+			cout << endl << "Error: Unrecognized option: " << sp << endl;
+			return 1;
+		}
+	}
+	if (iRequests < 1) {
+		usage();
+		return 1;
+	}
+	if (transports.empty()) {
+		transports.push_back("tcp");
+		transports.push_back("unix");
+		transports.push_back("shm");
+	}
+	if (szPath[0] == '\0')
+		snprintf(szPath, sizeof(szPath), "/tmp/dbt5-transport-%d", getpid());
+
+	char szUnix[iMaxHostname + 1];
+	char szShm[iMaxHostname + 1];
+	snprintf(szUnix, sizeof(szUnix), "unix:%s", szPath);
+	snprintf(szShm, sizeof(szShm), "shm:%s", szPath);
+
+	cout << iRequests << " TRADE_STATUS requests per transport, "
+		 << "times in microseconds" << endl
+		 << endl;
+	printf("%-9s %10s %9s %9s %9s %9s %9s %9s\n", "transport", "txn/s",
+			"mean", "p50", "p99", "p99.9", "cpu drv", "cpu srv");
+
+	int failures = 0;
+	for (size_t i = 0; i < transports.size(); i++) {
+		bool ok;
+		if (transports[i] == "tcp")
+			ok = benchmark("tcp", "127.0.0.1", "");
+		else if (transports[i] == "unix")
+			ok = benchmark("unix", szUnix, szUnix);
+		else
+			ok = benchmark("shm", szShm, szUnix);
+		if (!ok)
+			++failures;
+	}
+	unlink(szPath);
+
+	return failures == 0 ? 0 : 1;
+}
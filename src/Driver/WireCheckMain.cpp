@@ -0,0 +1,366 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Check that drivers and Brokerage Houses of different wire protocol
+ * versions understand each other.  The driver interface is run against
+ * Brokerage Houses made up here that speak at most each version, one of them
+ * from before the hello.  Given the address of a running Brokerage House,
+ * peers of each version, one of them from before the hello and one from
+ * after the last version, are run against it as well.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+
+#include "BaseInterface.h"
+#include "DBT5Consts.h"
+
+// Requests sent on each connection, all at once to a pipelining peer.
+#define WIRE_CHECK_REQUESTS 3
+
+char szBHaddr[iMaxHostname + 1] = "";
+int iBHlistenPort = iBrokerageHousePort;
+char szOutDir[iMaxPath + 1] = ".";
+// Leaves room for the transport prefix in an address.
+char szPath[iMaxHostname - 4] = "";
+
+static const char *szWireVersion[] = { "legacy", "framed", "pipelined",
+	"timed" };
+
+void
+usage()
+{
+	cout << "Usage: WireCheck [options]" << endl << endl;
+	cout << "   Option      Default    Description" << endl;
+	cout << "   =========   =========  ===============" << endl;
+	cout << "   -h string              Brokerage House address to check, or"
+		 << endl
+		 << "                          unix:<path>, none by default" << endl;
+	printf("   -o string   %-9s  Directory of the driver logs\n", szOutDir);
+	printf("   -p integer  %-9d  Brokerage House listener port\n",
+			iBHlistenPort);
+	cout << "   -s string              Unix-domain socket path of the"
+		 << endl
+		 << "                          Brokerage Houses made up here,"
+		 << endl
+		 << "                          /tmp/dbt5-wire-<pid> by default"
+		 << endl;
+}
+
+static const char *
+versionName(int iVersion)
+{
+	if (iVersion >= WIRE_VERSION_LEGACY && iVersion <= WIRE_VERSION)
+		return szWireVersion[iVersion];
+	return "future";
+}
+
+// The driver side of the protocol, as the users of the Driver run it.
+class CWireDriver : public CBaseInterface
+{
+public:
+	CWireDriver(char *szAddress)
+	: CBaseInterface("WC", szOutDir, szAddress, iBHlistenPort)
+	{
+	}
+
+	bool tradeStatus()
+	{
+		TMsgDriverBrokerage Request;
+		memset(&Request, 0, sizeof(Request));
+		return talkToSUT(TRADE_STATUS, &Request.TxnInput);
+	}
+};
+
+// Answer one driver the way a Brokerage House speaking at most iMaxVersion
+// would, WIRE_VERSION_LEGACY for one that predates the hello.  Return true
+// if every request came in the version agreed.
+static bool
+serve(int iMaxVersion, int readyfd)
+{
+	CSocket listener;
+	char szAddress[iMaxHostname + 1];
+	snprintf(szAddress, sizeof(szAddress), "unix:%s", szPath);
+	listener.dbt5Listen(szAddress, 0);
+	char ready = 1;
+	if (write(readyfd, &ready, 1) != 1)
+		return false;
+	close(readyfd);
+
+	CSocket sock;
+	sock.setSocketFd(listener.dbt5Accept());
+
+	TMsgDriverBrokerage Request;
+	TMsgTimedReply Reply;
+	memset(&Reply, 0, sizeof(Reply));
+	int iVersion = WIRE_VERSION_LEGACY;
+	int served = 0;
+	try {
+		if (iMaxVersion == WIRE_VERSION_LEGACY) {
+			// The hello reads as a request of an unknown type.
+			sock.dbt5Receive(&Request, sizeof(Request));
+			Reply.Reply.iStatus = ERR_TYPE_WRONGTXN;
+			sock.dbt5Send(&Reply.Reply, sizeof(Reply.Reply));
+		} else {
+			TMsgHello Hello;
+			sock.dbt5Receive(&Hello, sizeof(Hello));
+			if (Hello.iMagic != WIRE_MAGIC)
+				return false;
+			TMsgHelloReply HelloReply;
+			HelloReply.iMagic = WIRE_MAGIC;
+			HelloReply.iVersion = Hello.iVersion < iMaxVersion
+					? Hello.iVersion
+					: iMaxVersion;
+			iVersion = HelloReply.iVersion;
+			sock.dbt5Send(&HelloReply, sizeof(HelloReply));
+		}
+
+		for (served = 0; served < WIRE_CHECK_REQUESTS; served++) {
+			if (iVersion == WIRE_VERSION_LEGACY) {
+				sock.dbt5Receive(&Request, sizeof(Request));
+				if (Request.TxnType != TRADE_STATUS)
+					return false;
+				Reply.Reply.iStatus = 0;
+				sock.dbt5Send(&Reply.Reply, sizeof(Reply.Reply));
+				continue;
+			}
+
+			TMsgHeader Header;
+			memset(&Header, 0, sizeof(Header));
+			sock.dbt5Receive(&Header, wireHeaderSize(iVersion));
+			if (Header.iVersion != iVersion || Header.iTxnType != TRADE_STATUS
+					|| Header.iLength != txnInputSize(TRADE_STATUS))
+				return false;
+			sock.dbt5Receive(&Request.TxnInput, Header.iLength);
+			Reply.iRequestId = Header.iRequestId;
+			Reply.Reply.iStatus = 0;
+			Reply.Times.llTotal = 1000;
+			if (iVersion >= WIRE_VERSION_PIPELINED)
+				sock.dbt5Send(&Reply, wireReplySize(iVersion));
+			else
+				sock.dbt5Send(&Reply.Reply, sizeof(Reply.Reply));
+		}
+	} catch (CSocketErr *pErr) {
+		delete pErr;
+	}
+	return served == WIRE_CHECK_REQUESTS;
+}
+
+// Run the driver interface against a Brokerage House speaking at most
+// iMaxVersion.
+static bool
+checkDriver(int iMaxVersion)
+{
+	int readyfds[2];
+	if (pipe(readyfds) == -1) {
+		cerr << "cannot create pipe" << endl;
+		return false;
+	}
+
+	pid_t pid = fork();
+	if (pid == -1) {
+		cerr << "cannot fork server" << endl;
+		return false;
+	}
+	if (pid == 0) {
+		close(readyfds[0]);
+		bool ok = false;
+		try {
+			ok = serve(iMaxVersion, readyfds[1]);
+		} catch (CSocketErr *pErr) {
+			cerr << "server: " << pErr->ErrorText() << endl;
+		}
+		_exit(ok ? 0 : 1);
+	}
+
+	close(readyfds[1]);
+	char ready;
+	bool bReady = read(readyfds[0], &ready, 1) == 1;
+	close(readyfds[0]);
+	if (!bReady) {
+		cerr << "server did not start" << endl;
+		waitpid(pid, NULL, 0);
+		return false;
+	}
+
+	char szAddress[iMaxHostname + 1];
+	snprintf(szAddress, sizeof(szAddress), "unix:%s", szPath);
+	bool ok = true;
+	{
+		CWireDriver Driver(szAddress);
+		for (int i = 0; i < WIRE_CHECK_REQUESTS; i++)
+			ok = Driver.tradeStatus() && ok;
+	}
+	unlink(szPath);
+
+	int status;
+	waitpid(pid, &status, 0);
+	ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	printf("driver against %s Brokerage House: %s\n",
+			iMaxVersion == WIRE_VERSION_LEGACY ? "pre-hello"
+											   : versionName(iMaxVersion),
+			ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// Send requests to the Brokerage House as a peer offering iVersion,
+// WIRE_VERSION_UNKNOWN for one that predates the hello, and check the
+// replies are framed as agreed.  Their status is not checked.
+static bool
+checkPeer(int iVersion)
+{
+	int iAgreed = WIRE_VERSION_LEGACY;
+	bool ok = true;
+	try {
+		CSocket sock(szBHaddr, iBHlistenPort);
+		sock.dbt5Connect();
+
+		if (iVersion != WIRE_VERSION_UNKNOWN) {
+			TMsgHello Hello;
+			memset(&Hello, 0, sizeof(Hello));
+			Hello.iMagic = WIRE_MAGIC;
+			Hello.iVersion = iVersion;
+			sock.dbt5Send(&Hello, sizeof(Hello));
+
+			// A Brokerage House that predates the hello sends only a status.
+			TMsgHelloReply HelloReply;
+			sock.dbt5Receive(&HelloReply, sizeof(TMsgBrokerageDriver));
+			if (HelloReply.iMagic != WIRE_MAGIC) {
+				cerr << "hello answered with status " << HelloReply.iMagic
+					 << endl;
+				ok = false;
+			} else {
+				sock.dbt5Receive(
+						&HelloReply.iVersion, sizeof(HelloReply.iVersion));
+				iAgreed = iVersion < WIRE_VERSION ? iVersion : WIRE_VERSION;
+				if (HelloReply.iVersion != iAgreed) {
+					cerr << "hello answered with version "
+						 << HelloReply.iVersion << endl;
+					ok = false;
+				}
+			}
+		}
+
+		// A pipelining peer sends every request before the first reply.
+		int batch = iAgreed >= WIRE_VERSION_PIPELINED ? WIRE_CHECK_REQUESTS
+													  : 1;
+		bool bAnswered[WIRE_CHECK_REQUESTS + 1] = {};
+		for (int sent = 0; ok && sent < WIRE_CHECK_REQUESTS;) {
+			for (int i = 0; i < batch; i++, sent++) {
+				TMsgDriverBrokerage Request;
+				memset(&Request, 0, sizeof(Request));
+				Request.TxnType = TRADE_STATUS;
+				if (iAgreed == WIRE_VERSION_LEGACY) {
+					sock.dbt5Send(&Request, sizeof(Request));
+					continue;
+				}
+				TMsgHeader Header;
+				Header.iVersion = iAgreed;
+				Header.iTxnType = TRADE_STATUS;
+				Header.iLength = txnInputSize(TRADE_STATUS);
+				Header.iRequestId = sent + 1;
+				struct iovec iov[2];
+				iov[0].iov_base = &Header;
+				iov[0].iov_len = wireHeaderSize(iAgreed);
+				iov[1].iov_base = &Request.TxnInput;
+				iov[1].iov_len = Header.iLength;
+				sock.dbt5Send(iov, 2);
+			}
+
+			// Replies may come in any order, once each.
+			for (int i = 0; i < batch; i++) {
+				TMsgTimedReply Reply;
+				memset(&Reply, 0, sizeof(Reply));
+				if (iAgreed < WIRE_VERSION_PIPELINED) {
+					sock.dbt5Receive(&Reply.Reply, sizeof(Reply.Reply));
+					continue;
+				}
+				sock.dbt5Receive(&Reply, wireReplySize(iAgreed));
+				if (Reply.iRequestId < 1
+						|| Reply.iRequestId > (UINT32) sent
+						|| bAnswered[Reply.iRequestId]) {
+					cerr << "reply to request " << Reply.iRequestId << endl;
+					ok = false;
+					break;
+				}
+				bAnswered[Reply.iRequestId] = true;
+			}
+		}
+		sock.dbt5Disconnect();
+	} catch (CSocketErr *pErr) {
+		cerr << pErr->ErrorText() << endl;
+		delete pErr;
+		ok = false;
+	}
+
+	printf("%s peer against the Brokerage House: %s\n",
+			iVersion == WIRE_VERSION_UNKNOWN ? "pre-hello"
+											 : versionName(iVersion),
+			ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+	for (int arg = 1; arg < argc; ++arg) {
+		char *sp = argv[arg];
+		if (*sp != '-') {
+			usage();
+			return 1;
+		}
+
+		++sp;
+		char *vp = sp + 1;
+		if (*vp == 0 && arg + 1 < argc)
+			vp = argv[++arg];
+
+		switch (*sp) {
+		case 'h':
+			strncpy(szBHaddr, vp, iMaxHostname);
+			szBHaddr[iMaxHostname] = '\0';
+			break;
+		case 'o':
+			strncpy(szOutDir, vp, iMaxPath);
+			szOutDir[iMaxPath] = '\0';
+			break;
+		case 'p':
+			iBHlistenPort = atoi(vp);
+			break;
+		case 's':
+			strncpy(szPath, vp, sizeof(szPath) - 1);
+			szPath[sizeof(szPath) - 1] = '\0';
+			break;
+		default:
+			usage();
+			cout << endl << "Error: Unrecognized option: " << sp << endl;
+			return 1;
+		}
+	}
+	// A peer that hangs up fails its check rather than the whole run.
+	signal(SIGPIPE, SIG_IGN);
+	if (szPath[0] == '\0')
+		snprintf(szPath, sizeof(szPath), "/tmp/dbt5-wire-%d", getpid());
+
+	int failures = 0;
+	for (int i = WIRE_VERSION_LEGACY; i <= WIRE_VERSION; i++) {
+		if (!checkDriver(i))
+			++failures;
+	}
+	CMixLogWriter::close();
+
+	if (szBHaddr[0] != '\0') {
+		if (!checkPeer(WIRE_VERSION_UNKNOWN))
+			++failures;
+		for (int i = WIRE_VERSION_LEGACY; i <= WIRE_VERSION + 1; i++) {
+			if (!checkPeer(i))
+				++failures;
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
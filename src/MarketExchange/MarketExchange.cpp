@@ -105,10 +105,14 @@ EntryMarketWorkerThread(void *data)
 // Constructor
 CMarketExchange::CMarketExchange(const DataFileManager &inputFiles,
 		char *szFileLoc, UINT32 UniqueId, TIdent iConfiguredCustomerCount,
-		TIdent iActiveCustomerCount, int iListenPort, char *szBHaddr,
-		int iBHlistenPort, char *outputDirectory, bool verbose = false)
+		TIdent iActiveCustomerCount, int iListenPort,
+		const char *szListenAddress, char *szBHaddr, int iBHlistenPort,
+		char *outputDirectory, bool verbose = false)
 : m_UniqueId(UniqueId), m_iListenPort(iListenPort), m_Verbose(verbose)
 {
+	strncpy(m_szListenAddress, szListenAddress, iMaxHostname);
+	m_szListenAddress[iMaxHostname] = '\0';
+
 	char filename[iMaxPath + 1];
 	snprintf(filename, iMaxPath, "%s/MarketExchange.log", outputDirectory);
 	m_pLog = new CEGenLogger(eDriverEGenLoader, 0, filename, &m_fmt);
@@ -135,7 +139,7 @@ CMarketExchange::startListener(void)
 	int acc_socket;
 	PMarketThreadParam pThrParam;
 
-	m_Socket.dbt5Listen(m_iListenPort);
+	m_Socket.dbt5Listen(m_szListenAddress, m_iListenPort);
 
 	while (true) {
 		acc_socket = 0;
@@ -14,6 +14,7 @@
 // Establish defaults for command line options
 char szBHaddr[iMaxHostname + 1] = "localhost"; // Brokerage House address
 int iListenPort = iMarketExchangePort; // socket port to listen
+char szListenAddress[iMaxHostname + 1] = ""; // or Unix-domain socket
 int iBHlistenPort = iBrokerageHousePort;
 // # of customers for this instance
 TIdent iConfiguredCustomerCount = iDefaultCustomerCount;
@@ -38,8 +39,11 @@ usage()
 			iConfiguredCustomerCount);
 	cout << "   -i string               Location of EGen flat_in directory"
 		 << endl;
-	printf("   -l integer  %-10d  Socket listen port\n", iListenPort);
-	printf("   -h string   %-10s  Brokerage House address\n", szBHaddr);
+	printf("   -l string   %-10d  Socket listen port, or unix:<path>\n",
+			iListenPort);
+	printf("   -h string   %-10s  Brokerage House address, or unix:<path>\n",
+			szBHaddr);
+	printf("                           or shm:<path> when co-located\n");
 	printf("   -o string   %-10s  directory for output files\n",
 			outputDirectory);
 	printf("   -t integer  %-10ld  Active customer count\n",
@@ -56,6 +60,7 @@ parse_command_line(int argc, char *argv[])
 	int arg;
 	char *sp;
 	char *vp;
+	const char *path;
 
 	// Scan the command line arguments
 	for (arg = 1; arg < argc; ++arg) {
@@ -91,7 +96,12 @@ parse_command_line(int argc, char *argv[])
 			strncpy(szFileLoc, vp, iMaxPath);
 			break;
 		case 'l':
-			iListenPort = atoi(vp);
+			if (CSocket::parseAddress(vp, &path) == TRANSPORT_TCP) {
+				iListenPort = atoi(vp);
+			} else {
+				strncpy(szListenAddress, vp, iMaxHostname);
+				szListenAddress[iMaxHostname] = '\0';
+			}
 			break;
 		case 'o':
 			strncpy(outputDirectory, vp, iMaxPath);
@@ -149,7 +159,8 @@ main(int argc, char *argv[])
 	try {
 		CMarketExchange MarketExchange(inputFiles, szFileLoc, 1,
 				iConfiguredCustomerCount, iActiveCustomerCount, iListenPort,
-				szBHaddr, iBHlistenPort, outputDirectory, verbose);
+				szListenAddress, szBHaddr, iBHlistenPort, outputDirectory,
+				verbose);
 		cout << "Market Exchange started, waiting for trade requests..."
 			 << endl;
 
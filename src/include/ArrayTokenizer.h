@@ -0,0 +1,104 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Splitting of the arrays and records returned as text by the stored
+ * functions of the server-side frames.
+ */
+
+#ifndef ARRAY_TOKENIZER_H
+#define ARRAY_TOKENIZER_H
+
+#include <string.h>
+#include <vector>
+
+// An element of an array, or a field of a record, left where it was in the
+// value split: unquoted, unescaped and ended by a NUL.  A NULL is empty.
+typedef struct TArrayElement
+{
+	char *text;
+	size_t length;
+
+	const char *c_str() const { return text; }
+} TArrayElement;
+
+// Split value from open to close into elements, in place, without copying
+// or allocating once elements has grown to the size needed.  An array quotes
+// its elements with backslash escapes and writes NULL unquoted, a record
+// also doubles the quotes in its fields and leaves a NULL empty.
+inline void
+splitElements(char *value, char open, char close, bool bRecord,
+		std::vector<TArrayElement> &elements)
+{
+	elements.clear();
+	char *p = value;
+	if (*p != open)
+		return;
+	p++;
+	if (*p == close && !bRecord)
+		return;
+
+	while (true) {
+		TArrayElement element;
+		element.text = p;
+		char *out = p;
+		bool bQuoted = false;
+		bool bWasQuoted = false;
+		while (*p != '\0') {
+			if (bQuoted) {
+				if (*p == '"') {
+					if (bRecord && p[1] == '"') {
+						*out++ = '"';
+						p += 2;
+					} else {
+						bQuoted = false;
+						p++;
+					}
+					continue;
+				}
+			} else if (*p == ',' || *p == close) {
+				break;
+			} else if (*p == '"') {
+				bQuoted = true;
+				bWasQuoted = true;
+				p++;
+				continue;
+			}
+			if (*p == '\\' && p[1] != '\0')
+				p++;
+			*out++ = *p++;
+		}
+		char delimiter = *p;
+		*out = '\0';
+		element.length = out - element.text;
+		if (!bRecord && !bWasQuoted && element.length == 4
+				&& strncmp(element.text, "NULL", 4) == 0) {
+			element.text[0] = '\0';
+			element.length = 0;
+		}
+		elements.push_back(element);
+
+		if (delimiter != ',')
+			return;
+		p++;
+	}
+}
+
+// Elements of a one-dimensional array such as {1,"a b",NULL}.  An array of
+// records gives each record as text, to split with splitRecord().
+inline void
+splitArray(char *value, std::vector<TArrayElement> &elements)
+{
+	splitElements(value, '{', '}', false, elements);
+}
+
+// Fields of a record such as (1,"a ""b""",).
+inline void
+splitRecord(char *value, std::vector<TArrayElement> &fields)
+{
+	splitElements(value, '(', ')', true, fields);
+}
+
+#endif // ARRAY_TOKENIZER_H
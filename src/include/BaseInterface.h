@@ -15,12 +15,13 @@
 
 #include "CommonStructs.h"
 #include "CSocket.h"
+#include "MixLog.h"
 using namespace TPCE;
 
 class CBaseInterface
 {
 protected:
-	bool talkToSUT(PMsgDriverBrokerage);
+	bool talkToSUT(eTxnType, const void *);
 	void logErrorMessage(const string);
 
 	char *m_szBHAddress;
@@ -30,9 +31,15 @@ private:
 	CSocket *sock;
 	pid_t m_pid;
 	ofstream m_fLog; // error log file
-	ofstream m_fMix; // mix log file
+	CMixLogRing *m_pMixLog; // mix log records of this thread
 
-	void logResponseTime(int, int, double);
+	int m_iWireVersion; // protocol agreed with the Brokerage House
+	UINT32 m_iRequestId; // ID of the last pipelined request
+	TMsgDriverBrokerage m_Request; // request sent to a legacy peer
+
+	void logResponseTime(int, int, INT64, const TMsgServerTimes * = NULL);
+	void negotiate();
+	void reconnect();
 
 public:
 	CBaseInterface(const char *, char *, char *, const int);
@@ -12,6 +12,8 @@
 #define BROKERAGE_HOUSE_H
 
 #include <fstream>
+#include <vector>
+#include <pthread.h>
 using namespace std;
 
 #include "locking.h"
@@ -31,12 +33,19 @@ using namespace std;
 
 #include "DBT5Consts.h"
 #include "CSocket.h"
+#include "RequestQueue.h"
 using namespace TPCE;
 
+class CBrokerageReactor;
+class CBrokerageScheduler;
+class CBrokerageSession;
+class CDBConnection;
+
 class CBrokerageHouse
 {
 private:
 	int m_iListenPort;
+	char m_szListenAddress[iMaxHostname + 1]; // Unix-domain socket if set
 	CSocket m_Socket;
 	CMutex m_LogLock;
 	ofstream m_fLog;
@@ -49,12 +58,53 @@ private:
 	char m_szMEEPort[iMaxPort + 1];
 
 	char m_errorLogFilename[iMaxPath + 1];
+	char m_pipelineStatsFilename[iMaxPath + 1];
+	char m_retryStatsFilename[iMaxPath + 1];
+	char m_statementStatsFilename[iMaxPath + 1];
 
 	int m_ClientSide;
+	bool m_bPipeline; // libpq pipeline mode
+	ePlanCache m_ePlanCache;
+	bool m_bBinary; // binary results for the client-side frames
+
+	// Statements captured, and the share of the transactions of each type
+	// they are captured in.
+	eCaptureLevel m_eCapture;
+	double m_fCaptureRates[TRADE_CLEANUP + 1];
 
 	bool m_Verbose;
 
-	friend void entryWorkerThread(void *); // entry point for worker thread
+	// A transaction aborted by PostgreSQL for a conflict is run again up to
+	// m_iRetries times.  By transaction type: the retries, the transactions
+	// that were out of them, and the time lost in the aborted runs and in
+	// waiting before the next.
+	int m_iRetries;
+	std::atomic<long long> m_llRetries[TRADE_CLEANUP + 1];
+	std::atomic<long long> m_llRetriesExhausted[TRADE_CLEANUP + 1];
+	std::atomic<long long> m_llWastedNs[TRADE_CLEANUP + 1];
+	std::atomic<long long> m_llBackoffNs[TRADE_CLEANUP + 1];
+
+	// The connections are read by m_iReactors reactors, their requests are
+	// run by m_iWorkers workers on at most m_iMaxSessions database
+	// connections.  Or, when m_iTransactions is set, each worker runs that
+	// many at once on database connections of its own.
+	int m_iReactors;
+	vector<CBrokerageReactor *> m_Reactors;
+	int m_iWorkers;
+	int m_iTransactions;
+	vector<CBrokerageScheduler *> m_Schedulers;
+	CRequestQueue m_RequestQueue;
+
+	int m_iMaxSessions;
+	int m_iSessions; // sessions created so far
+	vector<CBrokerageSession *> m_IdleSessions;
+	pthread_mutex_t m_SessionLock;
+	pthread_cond_t m_SessionIdle;
+
+	friend class CBrokerageReactor;
+	friend class CBrokerageScheduler;
+	friend void *statsThread(void *);
+	friend void *workerThread(void *);
 
 	void dumpInputData(PBrokerVolumeTxnInput);
 	void dumpInputData(PCustomerPositionTxnInput);
@@ -94,27 +144,40 @@ private:
 	INT32 RunTradeUpdate(
 			PTradeUpdateTxnInput pTxnInput, CTradeUpdate &TradeUpdate);
 
-	friend void *workerThread(void *);
+	CDBConnection *newDBConnection();
+	CBrokerageSession *newSession();
+	CBrokerageSession *acquireSession();
+	void releaseSession(CBrokerageSession *);
+
+	INT32 dispatchTransaction(CBrokerageSession *, PMsgDriverBrokerage);
+	bool queueRequest(PBrokerageRequest);
+	INT32 runTransaction(CBrokerageSession *, PMsgDriverBrokerage);
+	void serveRequest(PBrokerageRequest);
+	void serveRequest(PBrokerageRequest, CBrokerageSession *);
+	void failRequest(PBrokerageRequest, CSocketErr *);
+	void rejectRequest(PBrokerageRequest, INT32);
+	void sendReply(CBrokerageConnection *, PMsgTimedReply);
+	void startWorkers();
+	void writeStats();
 
 public:
 	CBrokerageHouse(const char[], const char *, const char *, const char *,
-			const char *, const int, char *, int, bool);
+			const char *, const int, const char *, char *, int, int, int, int,
+			int, int, eQueuePolicy, bool, ePlanCache, int, bool,
+			eCaptureLevel, const double *, bool);
 	~CBrokerageHouse();
 
 	void logErrorMessage(const string sErr, bool bScreen = true);
 	char *errorLogFilename();
 
+	// Account for a transaction of type iTxnType started at llStart and
+	// aborted for a conflict after iRetry retries.  Wait a while on its
+	// connection and return true if it may be run again.
+	bool retryTransaction(CDBConnection *pConnection, int iTxnType,
+			int iRetry, INT64 llStart);
+
 	void startListener(void);
 	bool verbose();
 };
 
-// parameter structure for the threads
-typedef struct TThreadParameter
-{
-	CBrokerageHouse *pBrokerageHouse;
-	int iSockfd;
-	char m_szMEEHost[iMaxHostname + 1];
-	char m_szMEEPort[iMaxPort + 1];
-} *PThreadParameter;
-
 #endif // BROKERAGE_HOUSE_H
@@ -0,0 +1,58 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Network front end of the Brokerage House: a few reactor threads read the
+ * driver connections through edge-triggered epoll and queue each complete
+ * request for the workers.
+ */
+
+#ifndef BROKERAGE_REACTOR_H
+#define BROKERAGE_REACTOR_H
+
+#include <vector>
+#include <pthread.h>
+
+#include "RequestQueue.h"
+
+class CBrokerageHouse;
+
+class CBrokerageReactor
+{
+private:
+	CBrokerageHouse *m_pBrokerageHouse;
+	int m_epfd;
+	pthread_t m_tid;
+
+	// Shared-memory connections.  A worker waiting for room to send a reply
+	// may consume the doorbell, so they are also read now and then.
+	std::vector<CBrokerageConnection *> m_Channels;
+	long long m_llLastSweep;
+
+	// Connections left unread until there is room in the queue for their
+	// next request, the room descriptor of the queue is watched meanwhile.
+	std::vector<CBrokerageConnection *> m_Stalled;
+	int m_iRoomFd;
+
+	friend void *brokerageReactorThread(void *);
+
+	void closeConnection(CBrokerageConnection *);
+	bool parse(CBrokerageConnection *);
+	bool queueRequest(CBrokerageConnection *, PBrokerageRequest);
+	bool receive(CBrokerageConnection *);
+	void resume();
+	void run();
+	void stall(CBrokerageConnection *);
+	void sweep();
+
+public:
+	// Start the reactor thread, which lives as long as the Brokerage House.
+	CBrokerageReactor(CBrokerageHouse *);
+
+	// Read an accepted connection from now on, called by the listener.
+	void addConnection(int);
+};
+
+#endif // BROKERAGE_REACTOR_H
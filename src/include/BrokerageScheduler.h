@@ -0,0 +1,65 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * A Brokerage House worker that runs several transactions at once, each on a
+ * database connection of its own.  A transaction runs on a stack of its own
+ * and gives the thread back whenever it waits for PostgreSQL, so that the
+ * worker can go on with the others meanwhile.
+ */
+
+#ifndef BROKERAGE_SCHEDULER_H
+#define BROKERAGE_SCHEDULER_H
+
+#include <vector>
+#include <pthread.h>
+#include <ucontext.h>
+
+#include "DBConnection.h"
+#include "RequestQueue.h"
+
+class CBrokerageHouse;
+class CBrokerageSession;
+
+class CBrokerageScheduler : public CDBWait
+{
+private:
+	// A transaction and what it waits for.  The stack and the session are
+	// kept for the next one.
+	typedef struct TFiber
+	{
+		ucontext_t Context;
+		char *pStack;
+		CBrokerageSession *pSession; // opened on first use
+		PBrokerageRequest pRequest; // NULL when idle
+		int iSockfd;
+		short iEvents;
+	} *PFiber;
+
+	CBrokerageHouse *m_pBrokerageHouse;
+	pthread_t m_tid;
+
+	std::vector<TFiber> m_Fibers;
+	PFiber m_pCurrent;
+	ucontext_t m_Context; // where the fibers return to
+	int m_iRunning;
+
+	friend void *brokerageSchedulerThread(void *);
+	friend void brokerageFiber(unsigned int, unsigned int);
+
+	void fiber();
+	void resume(PFiber);
+	void run();
+	void start(PBrokerageRequest);
+
+public:
+	// Start the worker thread, which lives as long as the Brokerage House.
+	CBrokerageScheduler(CBrokerageHouse *, int);
+
+	// Called by the database connections of the transactions.
+	void wait(int, bool);
+};
+
+#endif // BROKERAGE_SCHEDULER_H
@@ -0,0 +1,69 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Everything a Brokerage House worker needs to run any transaction: a
+ * database connection, a link to the Market Exchange Emulator and the
+ * transaction objects that use them.  A session is used by one worker at a
+ * time.
+ */
+
+#ifndef BROKERAGE_SESSION_H
+#define BROKERAGE_SESSION_H
+
+#include "DBConnection.h"
+#include "TxnHarnessSendToMarket.h"
+
+#include "BrokerVolumeDB.h"
+#include "CustomerPositionDB.h"
+#include "DataMaintenanceDB.h"
+#include "MarketFeedDB.h"
+#include "MarketWatchDB.h"
+#include "SecurityDetailDB.h"
+#include "TradeCleanupDB.h"
+#include "TradeLookupDB.h"
+#include "TradeOrderDB.h"
+#include "TradeResultDB.h"
+#include "TradeStatusDB.h"
+#include "TradeUpdateDB.h"
+
+class CBrokerageSession
+{
+public:
+	CDBConnection *m_pDBConnection; // owned by the session
+	CSendToMarket m_SendToMarket;
+
+	CBrokerVolumeDB m_BrokerVolumeDB;
+	CBrokerVolume m_BrokerVolume;
+	CCustomerPositionDB m_CustomerPositionDB;
+	CCustomerPosition m_CustomerPosition;
+	CDataMaintenanceDB m_DataMaintenanceDB;
+	CDataMaintenance m_DataMaintenance;
+	CMarketFeedDB m_MarketFeedDB;
+	CMarketFeed m_MarketFeed;
+	CMarketWatchDB m_MarketWatchDB;
+	CMarketWatch m_MarketWatch;
+	CSecurityDetailDB m_SecurityDetailDB;
+	CSecurityDetail m_SecurityDetail;
+	CTradeCleanupDB m_TradeCleanupDB;
+	CTradeCleanup m_TradeCleanup;
+	CTradeLookupDB m_TradeLookupDB;
+	CTradeLookup m_TradeLookup;
+	CTradeOrderDB m_TradeOrderDB;
+	CTradeOrder m_TradeOrder;
+	CTradeResultDB m_TradeResultDB;
+	CTradeResult m_TradeResult;
+	CTradeStatusDB m_TradeStatusDB;
+	CTradeStatus m_TradeStatus;
+	CTradeUpdateDB m_TradeUpdateDB;
+	CTradeUpdate m_TradeUpdate;
+
+	CBrokerageSession(CDBConnection *, ofstream *, char *, int, bool);
+	~CBrokerageSession();
+
+	void setServerTimes(PMsgServerTimes);
+};
+
+#endif // BROKERAGE_SESSION_H
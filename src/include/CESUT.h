@@ -32,9 +32,6 @@ public:
 	bool TradeOrder(PTradeOrderTxnInput, INT32, bool);
 	bool TradeStatus(PTradeStatusTxnInput);
 	bool TradeUpdate(PTradeUpdateTxnInput);
-
-private:
-	struct TMsgDriverBrokerage request;
 };
 
 #endif // CE_SUT_H
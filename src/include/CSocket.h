@@ -14,6 +14,8 @@
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
@@ -21,10 +23,25 @@
 
 #include "CThreadErr.h"
 #include "MiscConsts.h"
+#include "ShmChannel.h"
+
+// Transports, chosen by the address: "unix:<path>" is a Unix-domain stream
+// socket, "shm:<path>" a shared-memory channel set up through the
+// Unix-domain socket at <path>, anything else a TCP host.  The port only
+// matters for TCP.  A Unix-domain listener serves both kinds of clients.
+enum eTransport
+{
+	TRANSPORT_TCP = 0,
+	TRANSPORT_UNIX,
+	TRANSPORT_SHM
+};
 
 class CSocket
 {
 public:
+	static eTransport parseAddress(const char *, const char **);
+	static socklen_t unixAddress(const char *, struct sockaddr_un *);
+
 	CSocket(void);
 	CSocket(char *, int);
 	~CSocket();
@@ -33,15 +50,14 @@ public:
 	void dbt5Connect();
 	void dbt5Disconnect();
 	void dbt5Listen(const int);
+	void dbt5Listen(const char *, const int);
 	int dbt5Receive(void *, int);
+	int dbt5ReceiveAvailable(void *, int);
 	void dbt5Reconnect();
 	int dbt5Send(void *, int);
+	int dbt5Send(struct iovec *, int);
 
-	void
-	setSocketFd(int sockfd)
-	{
-		m_sockfd = sockfd;
-	}
+	void setSocketFd(int);
 
 	int
 	getSocketFd()
@@ -49,21 +65,35 @@ public:
 		return m_sockfd;
 	}
 
+	eTransport
+	getTransport()
+	{
+		return m_eTransport;
+	}
+
 	void
 	closeListenerSocket()
 	{
-		close(m_listenfd);
+		if (m_listenfd != 0)
+			close(m_listenfd);
+		m_listenfd = 0;
 	}
 
 private:
 	void throwError(CSocketErr::Action);
 	int resolveProto(const char *);
+	int probe(void *, bool);
 
 	char address[iMaxHostname + 1];
 	int port;
+	eTransport m_eTransport;
 
 	int m_listenfd; // listen socket
 	int m_sockfd; // accept socket
+	// An accepted Unix-domain socket whose first byte may bring a
+	// shared-memory channel.
+	bool m_bProbe;
+	CShmChannel *m_pChannel;
 };
 
 #endif // SOCKET_H
@@ -19,7 +19,7 @@ using namespace TPCE;
 #define ERR_TYPE_THREAD 14 // thread error
 #define ERR_TYPE_PQXX 15 // libpqxx error
 #define ERR_TYPE_WRONGTXN 16 // wrong txn type
-#define CE_MIX_LOG_NAME "mix-dr.log"
+#define ERR_TYPE_BUSY 17 // request queue full
 
 class CSocketErr: public CBaseErr
 {
@@ -40,7 +40,8 @@ public:
 		ERR_SOCKET_CLOSED,
 		ERR_SOCKET_RECVPARTIAL,
 		ERR_SOCKET_SEND,
-		ERR_SOCKET_SENDPARTIAL
+		ERR_SOCKET_SENDPARTIAL,
+		ERR_SOCKET_PROTOCOL
 	};
 
 private:
@@ -74,7 +75,7 @@ public:
 	const char *
 	ErrorText() const
 	{
-		static char *szErrMsg[15] = {
+		static char *szErrMsg[16] = {
 			(char *) "Can't accept client connection",
 			(char *) "Please specify port on which server listen for "
 					 "request",
@@ -92,7 +93,8 @@ public:
 			(char *) "cannot receive data",
 			(char *) "socket closed on operation",
 			(char *) "did not receive all data", (char *) "cannot send data",
-			(char *) "did not send all data"
+			(char *) "did not send all data",
+			(char *) "malformed message"
 		};
 
 		return szErrMsg[m_eAction];
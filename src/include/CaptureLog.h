@@ -0,0 +1,151 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Binary capture of the statements run by the Brokerage House.  Every thread
+ * appends whole records to a ring of its own, and a single writer thread
+ * drains all of them into one file.  A statement prepared from the list of a
+ * connection is logged by an identifier, defined once in the file, instead
+ * of by its text.  CaptureDecode turns the file back into the text capture,
+ * CaptureReplay runs it again.
+ */
+
+#ifndef CAPTURE_LOG_H
+#define CAPTURE_LOG_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "locking.h"
+#include "EGenStandardTypes.h"
+using namespace TPCE;
+
+#define CAPTURE_LOG_NAME "capture.bin"
+#define CAPTURE_LOG_MAGIC "DBT5CAP"
+#define CAPTURE_LOG_VERSION 2
+
+// Bytes of the ring of each thread.  A record larger than a quarter of it is
+// written by the thread itself.
+#define CAPTURE_RING_SIZE (256 * 1024)
+
+enum eCaptureRecordKind
+{
+	CAPTURE_RECORD_STATEMENT = 0, // identifier, name and text of a statement
+	CAPTURE_RECORD_COMMAND, // transaction control, with its text
+	CAPTURE_RECORD_EXEC // a statement with its parameters and results
+};
+
+// What an exec record holds after its parameters.
+enum eCaptureResult
+{
+	CAPTURE_RESULT_NONE = 0, // not captured, or an error
+	CAPTURE_RESULT_COMMAND, // the rows affected, as text
+	CAPTURE_RESULT_TUPLES // the columns then the values of each row
+};
+
+// How an exec record holds a parameter.
+enum eCaptureParam
+{
+	CAPTURE_PARAM_TEXT = 0,
+	CAPTURE_PARAM_BINARY,
+	CAPTURE_PARAM_REPLACED // the text logged instead of a binary value
+};
+
+// File header, followed by records up to the end of the file.
+typedef struct TCaptureLogHeader
+{
+	char szMagic[8];
+	UINT32 iVersion;
+	UINT32 iLevel; // eCaptureLevel
+} *PCaptureLogHeader;
+
+// Header of every record.  The rest, in the native byte order:
+//  - statement: the name then the text, each ended by a NUL.
+//  - command: the text then the name of the transaction, each ended by a
+//    NUL.
+//  - exec: the text ended by a NUL if iStatement is 0, UINT16 parameters,
+//    each an eCaptureParam byte, a UINT32 type and a value, then an
+//    eCaptureResult byte.  The rows affected are a value.  Tuples are UINT32
+//    rows, UINT16 columns, for each a UINT32 type and a format byte, then
+//    the values row by row.
+// A value is an INT32 length, -1 for NULL, and its bytes.
+typedef struct TCaptureRecord
+{
+	UINT32 iLength; // of the whole record
+	UINT16 iKind; // eCaptureRecordKind
+	UINT16 iReserved;
+	INT32 iPid; // backend
+	UINT32 iStatement; // 0 for a statement logged by its text
+	INT64 llStart; // microseconds since the epoch
+	INT64 llDuration; // microseconds
+	// Order of the records of the connection, from 1.  The records of a
+	// connection handed from one thread to another may be written out of
+	// order.
+	INT64 llSequence;
+} *PCaptureRecord;
+
+// Single producer, single consumer ring of records.  Only whole records are
+// published, so that the writer never splits one.
+class CCaptureRing
+{
+private:
+	std::vector<char> m_Buffer;
+	size_t m_iMask;
+	std::atomic<size_t> m_iHead; // next byte to fill
+	std::atomic<size_t> m_iTail; // next byte to write out
+
+	friend class CCaptureLog;
+
+public:
+	CCaptureRing(size_t);
+
+	void push(const char *, size_t);
+};
+
+class CCaptureLog
+{
+private:
+	int m_fd;
+	pthread_t m_tid;
+	std::atomic<bool> m_bStop;
+
+	CMutex m_RingsLock;
+	std::vector<CCaptureRing *> m_Rings;
+	// Held while writing to the file, by the writer or by a thread writing
+	// a large record.
+	CMutex m_FileLock;
+
+	CMutex m_StatementsLock;
+	std::map<std::string, UINT32> m_Statements;
+
+	static CCaptureLog *m_pLog;
+
+	CCaptureLog(const char *, int);
+	~CCaptureLog();
+
+	bool drain();
+	void write(const char *, size_t);
+
+	friend void *captureLogWriterThread(void *);
+
+public:
+	// Start the process wide writer, capturing at the level given.
+	static CCaptureLog *open(const char *, int);
+	// The writer, NULL unless open.
+	static CCaptureLog *get();
+	// Write out everything still queued and stop the writer.
+	static void close();
+
+	// Queue a record from the calling thread.
+	void push(const char *, size_t);
+	// The identifier of a statement of the name given, defined in the file
+	// the first time it is asked for.
+	UINT32 statementId(const char *, const char *);
+};
+
+#endif // CAPTURE_LOG_H
@@ -0,0 +1,114 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Reading back a binary capture, for CaptureDecode and CaptureReplay.
+ */
+
+#ifndef CAPTURE_READER_H
+#define CAPTURE_READER_H
+
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+#include "CaptureLog.h"
+
+// Reads the fields of a record, failing once past its end.
+class CRecordReader
+{
+private:
+	const char *m_p;
+	const char *m_pEnd;
+	bool m_bFailed;
+
+public:
+	CRecordReader(): m_p(NULL), m_pEnd(NULL), m_bFailed(false) {}
+
+	CRecordReader(const char *p, const char *pEnd)
+	: m_p(p), m_pEnd(pEnd), m_bFailed(false)
+	{
+	}
+
+	bool failed() const { return m_bFailed; }
+
+	template <typename T>
+	T number()
+	{
+		T value = 0;
+		if (m_pEnd - m_p < (ptrdiff_t) sizeof(value)) {
+			m_bFailed = true;
+			return value;
+		}
+		memcpy(&value, m_p, sizeof(value));
+		m_p += sizeof(value);
+		return value;
+	}
+
+	const char *text()
+	{
+		const char *p = m_p;
+		const char *nul = (const char *) memchr(m_p, '\0', m_pEnd - m_p);
+		if (nul == NULL) {
+			m_bFailed = true;
+			return "";
+		}
+		m_p = nul + 1;
+		return p;
+	}
+
+	// The bytes of a value and their number, -1 for NULL.
+	const char *value(INT32 *pLength)
+	{
+		*pLength = number<INT32>();
+		if (*pLength < 0)
+			return NULL;
+		if (m_pEnd - m_p < *pLength) {
+			m_bFailed = true;
+			*pLength = -1;
+			return NULL;
+		}
+		const char *p = m_p;
+		m_p += *pLength;
+		return p;
+	}
+};
+
+// A capture mapped in memory.  The statement definitions are all read on
+// opening, since one may be written after the first records using it.
+class CCaptureReader
+{
+private:
+	char *m_pData;
+	size_t m_iSize;
+	const char *m_pRecord;
+	const char *m_pNext;
+	// The name and text of each statement, by its identifier.
+	std::map<UINT32, std::pair<std::string, std::string> > m_Statements;
+
+	bool readRecord(const char *, TCaptureRecord *) const;
+
+public:
+	CCaptureReader();
+	~CCaptureReader();
+
+	// Whether the file is a capture of this version, saying why not on
+	// standard error.
+	bool open(const char *);
+	const TCaptureLogHeader *header() const;
+
+	// Each record but the statement definitions in turn, with a reader of
+	// what follows its header.  A record cut short by a crash of the
+	// Brokerage House ends the file.
+	bool next(TCaptureRecord *, CRecordReader *);
+	// Offset in the file of the record last returned.
+	size_t offset() const;
+	// The text of a statement, NULL if it is not defined.
+	const char *statement(UINT32) const;
+	const char *statementName(UINT32) const;
+};
+
+#endif // CAPTURE_READER_H
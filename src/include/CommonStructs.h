@@ -10,6 +10,9 @@
 #ifndef COMMON_STRUCTS_H
 #define COMMON_STRUCTS_H
 
+#include <stddef.h>
+#include <time.h>
+
 #include "CE.h"
 using namespace TPCE;
 
@@ -59,4 +62,142 @@ typedef struct TMsgBrokerageDriver
 	int iStatus;
 } *PMsgBrokerageDriver;
 
+// Wire protocol versions.  A legacy peer sends every request as a whole
+// TMsgDriverBrokerage, a framed peer sends a TMsgHeader followed by only the
+// input of the transaction requested.
+#define WIRE_MAGIC 0x35544244 // "DBT5"
+#define WIRE_VERSION_UNKNOWN -1 // nothing received on the connection yet
+#define WIRE_VERSION_LEGACY 0
+#define WIRE_VERSION_FRAMED 1
+// Requests carry an ID echoed in the reply so that many can be outstanding
+// on one connection and be answered in any order.
+#define WIRE_VERSION_PIPELINED 2
+// Replies also carry the time the Brokerage House spent on each part of the
+// transaction.
+#define WIRE_VERSION_TIMED 3
+#define WIRE_VERSION WIRE_VERSION_TIMED
+
+// First message Driver --> Brokerage House on a new connection, offering the
+// highest protocol version the driver speaks.  It is as long as a legacy
+// request so a Brokerage House that predates the framed protocol reads it
+// whole and answers it as an unknown transaction type.
+typedef struct TMsgHello
+{
+	INT32 iMagic;
+	INT32 iVersion;
+	char pad[sizeof(TMsgDriverBrokerage) - 2 * sizeof(INT32)];
+} *PMsgHello;
+
+// Answer Brokerage House --> Driver with the version both sides will use.
+// The driver reads a TMsgBrokerageDriver first, anything but WIRE_MAGIC
+// there is a legacy reply.
+typedef struct TMsgHelloReply
+{
+	INT32 iMagic;
+	INT32 iVersion;
+} *PMsgHelloReply;
+
+// header of a framed request Driver --> Brokerage House
+typedef struct TMsgHeader
+{
+	INT16 iVersion;
+	INT16 iTxnType;
+	UINT32 iLength; // bytes of transaction input following the header
+	UINT32 iRequestId; // only sent from WIRE_VERSION_PIPELINED on
+} *PMsgHeader;
+
+// reply Brokerage House --> Driver to a pipelined request
+typedef struct TMsgPipelinedReply
+{
+	UINT32 iRequestId;
+	TMsgBrokerageDriver Reply;
+} *PMsgPipelinedReply;
+
+// Frames of the longest transactions, Trade Order and Trade Result.
+#define SERVER_TIME_FRAMES 6
+
+// Nanoseconds the Brokerage House spent on a request, 0 for the parts the
+// transaction does not have.  Frames are numbered from 1 and do not include
+// the commit or sending to the market.
+typedef struct TMsgServerTimes
+{
+	INT64 llDispatch; // request received to transaction started
+	INT64 llFrame[SERVER_TIME_FRAMES];
+	INT64 llCommit;
+	INT64 llSendToMarket;
+	INT64 llTotal; // request received to reply ready
+} *PMsgServerTimes;
+
+// reply Brokerage House --> Driver to a timed request, a pipelined reply
+// followed by the server times
+typedef struct TMsgTimedReply
+{
+	UINT32 iRequestId;
+	TMsgBrokerageDriver Reply;
+	TMsgServerTimes Times;
+} *PMsgTimedReply;
+
+// Clock the server times are taken with.
+inline INT64
+serverClockNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (INT64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Bytes of the request header sent with a protocol version.
+inline size_t
+wireHeaderSize(int iVersion)
+{
+	if (iVersion >= WIRE_VERSION_PIPELINED)
+		return sizeof(TMsgHeader);
+	return offsetof(TMsgHeader, iRequestId);
+}
+
+// Bytes of the reply sent with a protocol version.
+inline size_t
+wireReplySize(int iVersion)
+{
+	if (iVersion >= WIRE_VERSION_TIMED)
+		return sizeof(TMsgTimedReply);
+	return iVersion >= WIRE_VERSION_PIPELINED ? sizeof(TMsgPipelinedReply)
+											  : sizeof(TMsgBrokerageDriver);
+}
+
+// Size of the transaction input a framed request carries, 0 for an unknown
+// transaction type.
+inline size_t
+txnInputSize(INT32 iTxnType)
+{
+	switch (iTxnType) {
+	case SECURITY_DETAIL:
+		return sizeof(TSecurityDetailTxnInput);
+	case BROKER_VOLUME:
+		return sizeof(TBrokerVolumeTxnInput);
+	case CUSTOMER_POSITION:
+		return sizeof(TCustomerPositionTxnInput);
+	case MARKET_WATCH:
+		return sizeof(TMarketWatchTxnInput);
+	case TRADE_STATUS:
+		return sizeof(TTradeStatusTxnInput);
+	case TRADE_LOOKUP:
+		return sizeof(TTradeLookupTxnInput);
+	case TRADE_ORDER:
+		return sizeof(TTradeOrderTxnInput);
+	case TRADE_UPDATE:
+		return sizeof(TTradeUpdateTxnInput);
+	case MARKET_FEED:
+		return sizeof(TMarketFeedTxnInput);
+	case TRADE_RESULT:
+		return sizeof(TTradeResultTxnInput);
+	case DATA_MAINTENANCE:
+		return sizeof(TDataMaintenanceTxnInput);
+	case TRADE_CLEANUP:
+		return sizeof(TTradeCleanupTxnInput);
+	default:
+		return 0;
+	}
+}
+
 #endif // COMMON_STRUCTS_H
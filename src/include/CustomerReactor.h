@@ -0,0 +1,270 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Event-driven customer emulation: many emulated users multiplexed over a
+ * small number of epoll reactor threads.
+ */
+
+#ifndef CUSTOMER_REACTOR_H
+#define CUSTOMER_REACTOR_H
+
+#include <deque>
+#include <vector>
+#include <netinet/in.h>
+
+#include "CE.h"
+#include "CESUTInterface.h"
+#include "EGenLogFormatterTab.h"
+#include "EGenLogger.h"
+#include "locking.h"
+
+#include "CommonStructs.h"
+#include "CSocket.h"
+#include "CThreadErr.h"
+#include "MixLog.h"
+using namespace TPCE;
+
+class CDriver;
+
+// Transaction arrival rate for the open-loop mode.  A rate of 0 keeps the
+// closed-loop behaviour where each user waits for its reply and then sleeps
+// for the pacing delay.
+class CArrivalProfile
+{
+public:
+	enum eRampProfile
+	{
+		RAMP_NONE = 0,
+		RAMP_STEP,
+		RAMP_LINEAR
+	};
+
+	double dRate; // txn/s at the end of ramp-up
+	bool bPoisson; // exponential instead of fixed inter-arrival times
+	eRampProfile eRamp;
+	double dEndRate; // highest rate the ramp reaches
+	double dIncrement; // rate added at every step
+	int iRampSeconds; // length of a step, or of the whole linear ramp
+
+	CArrivalProfile();
+
+	bool parseRamp(const char *);
+	double rateAt(double) const;
+};
+
+// CE to SUT interface that only records the transaction input generated by
+// the CE so the reactor can send it without blocking.
+class CCEReactorSUT: public CCESUTInterface
+{
+private:
+	PMsgDriverBrokerage m_pRequest;
+
+public:
+	CCEReactorSUT(PMsgDriverBrokerage pRequest): m_pRequest(pRequest) {}
+
+	bool BrokerVolume(PBrokerVolumeTxnInput);
+	bool CustomerPosition(PCustomerPositionTxnInput);
+	bool MarketWatch(PMarketWatchTxnInput);
+	bool SecurityDetail(PSecurityDetailTxnInput);
+	bool TradeLookup(PTradeLookupTxnInput);
+	bool TradeOrder(PTradeOrderTxnInput, INT32, bool);
+	bool TradeStatus(PTradeStatusTxnInput);
+	bool TradeUpdate(PTradeUpdateTxnInput);
+};
+
+class CReactorConnection;
+
+// A single emulated user, run as a state machine by its reactor.
+class CEmulatedUser
+{
+public:
+	enum eUserState
+	{
+		USER_THINKING = 0,
+		USER_QUEUED, // waiting for its request to be sent
+		USER_RECEIVING,
+		USER_IDLE // waiting for an open-loop arrival
+	};
+
+	UINT32 m_UniqueId;
+	UINT32 m_iRequestId; // index in the reactor's users, sent as request ID
+	eUserState m_eState;
+	CReactorConnection *m_pConnection;
+	CCE *m_pCCE;
+
+	TMsgHeader m_Header;
+	TMsgDriverBrokerage m_Request;
+	// nanoseconds, the intended start time in open-loop mode
+	long long m_llStartTime;
+
+	// timer wheel linkage
+	CEmulatedUser *m_pNextTimer;
+	long long m_llTimerExpiry;
+
+	CCEReactorSUT m_SUT;
+
+	CEmulatedUser(UINT32 UniqueId, UINT32 iRequestId)
+	: m_UniqueId(UniqueId), m_iRequestId(iRequestId),
+	  m_eState(USER_THINKING), m_pConnection(NULL), m_pCCE(NULL),
+	  m_llStartTime(0), m_pNextTimer(NULL), m_llTimerExpiry(0),
+	  m_SUT(&m_Request)
+	{
+	}
+};
+
+// A connection to the Brokerage House.  It is either dedicated to one user
+// or, when pipelining, shared by many users whose requests are outstanding
+// on it at the same time.
+class CReactorConnection
+{
+public:
+	enum eConnectionState
+	{
+		CONN_CLOSED = 0,
+		CONN_CONNECTING,
+		CONN_HELLO, // offering the framed protocol
+		CONN_HELLO_REPLY, // waiting for the Brokerage House to answer
+		CONN_READY
+	};
+
+	static const size_t iBufferSize = 64 * sizeof(TMsgTimedReply);
+
+	eConnectionState m_eState;
+	int m_iSockfd;
+	// Shared-memory transport, m_iSockfd is then only its doorbell.
+	CShmChannel *m_pChannel;
+	UINT32 m_iEvents; // epoll interest
+	bool m_bDedicated;
+	int m_iWireVersion; // protocol agreed with the Brokerage House
+
+	// Requests waiting to be sent, the first one possibly in part.
+	deque<CEmulatedUser *> m_Queue;
+	// bytes of the hello, or of the first queued request, already sent
+	size_t m_iOffset;
+	// Requests sent and not answered yet.  Before WIRE_VERSION_PIPELINED
+	// there is at most one.
+	int m_iInFlight;
+	CEmulatedUser *m_pInFlight;
+
+	// replies, or the answer to the hello, received in part
+	alignas(8) char m_Buffer[iBufferSize]; // replies are read in place
+	size_t m_iReceived;
+
+	long long m_llRetryTime; // milliseconds
+
+	CReactorConnection(bool bDedicated)
+	: m_eState(CONN_CLOSED), m_iSockfd(-1), m_pChannel(NULL), m_iEvents(0),
+	  m_bDedicated(bDedicated), m_iWireVersion(WIRE_VERSION_LEGACY),
+	  m_iOffset(0), m_iInFlight(0), m_pInFlight(NULL), m_iReceived(0),
+	  m_llRetryTime(0)
+	{
+	}
+};
+
+// Hashed timing wheel with millisecond ticks used for the pacing delay.
+class CTimerWheel
+{
+private:
+	static const int iWheelSlots = 1024;
+
+	CEmulatedUser *m_pSlots[iWheelSlots];
+	long long m_llLastTick;
+	int m_iCount;
+
+public:
+	CTimerWheel(long long);
+
+	void schedule(CEmulatedUser *, long long);
+	// Unlink every user whose timer expired at or before the given tick and
+	// return them as a list chained through m_pNextTimer.
+	CEmulatedUser *expire(long long);
+
+	int
+	count()
+	{
+		return m_iCount;
+	}
+};
+
+class CCustomerReactor
+{
+private:
+	CDriver *m_pDriver;
+	int m_iReactorId;
+	pid_t m_pid;
+
+	int m_epfd;
+	int m_eventfd;
+	eTransport m_eTransport;
+	struct sockaddr_storage m_BHAddr;
+	socklen_t m_iBHAddrLen;
+	TMsgHello m_Hello;
+
+	CLogFormatTab m_fmt;
+	CEGenLogger *m_pLog;
+	ofstream m_fLog; // error log file
+	CMixLogRing *m_pMixLog; // mix log records of this reactor
+
+	// Users handed over by the driver during ramp-up.
+	CMutex m_InboxLock;
+	vector<UINT32> m_Inbox;
+	bool m_bInboxClosed;
+
+	// Users by request ID, NULL once retired.
+	vector<CEmulatedUser *> m_Users;
+	// Every connection opened, the shared ones first.
+	vector<CReactorConnection *> m_Connections;
+	// Closed connections waiting to connect again.
+	vector<CReactorConnection *> m_Retries;
+	bool m_bWarnedLegacy;
+
+	CTimerWheel *m_pTimers;
+	int m_iActiveUsers;
+	bool m_bStopping;
+
+	// Open-loop arrivals: intended start times not yet handed to a user and
+	// the users that are free to take them.
+	bool m_bOpenLoop;
+	long long m_llArrivalStart;
+	double m_dNextArrival;
+	unsigned short m_xsubi[3];
+	deque<long long> m_Backlog;
+	vector<CEmulatedUser *> m_IdleUsers;
+
+	void acceptUsers();
+	void closeConnection(CReactorConnection *);
+	void completeTxn(CEmulatedUser *, int, const TMsgServerTimes *);
+	void connect(CReactorConnection *);
+	void failConnection(CReactorConnection *, CSocketErr::Action);
+	void flushConnection(CReactorConnection *);
+	void handleEvent(CReactorConnection *, UINT32);
+	void issueArrivals(long long);
+	void logErrorMessage(const string);
+	void logResponseTime(int, int, INT64, const TMsgServerTimes * = NULL);
+	void receiveHelloReply(CReactorConnection *);
+	void receiveReplies(CReactorConnection *);
+	void releaseUser(CEmulatedUser *);
+	void retireUser(CEmulatedUser *);
+	void retryConnections(long long);
+	void sendHello(CReactorConnection *);
+	void setInterest(CReactorConnection *, UINT32);
+	void startTxn(CEmulatedUser *, long long);
+	void think(CEmulatedUser *, long long);
+
+	friend void *reactorWorkerThread(void *);
+
+public:
+	CCustomerReactor(CDriver *, int);
+	~CCustomerReactor();
+
+	void addUser(UINT32);
+	void closeInbox();
+	void run();
+};
+
+void *reactorWorkerThread(void *);
+
+#endif // CUSTOMER_REACTOR_H
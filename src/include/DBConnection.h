@@ -13,7 +13,11 @@
 
 #define TEMPLATE false	// 记录事务名称的开关
 
+#include <deque>
 #include <map>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
 #include <libpq-fe.h>
 #include <unistd.h>
 #include <sys/syscall.h>
@@ -22,9 +26,52 @@
 #include "TxnHarnessSendToMarket.h"
 
 #include "BrokerageHouse.h"
+#include "CommonStructs.h"
 #include "DBT5Consts.h"
+#include "StatementStats.h"
 using namespace TPCE;
 
+class CCaptureLog;
+
+// Lets the caller of a statement do something else while it runs: wait()
+// returns once the socket is ready to read, or to write.
+class CDBWait
+{
+public:
+	virtual ~CDBWait() {}
+	virtual void wait(int, bool) = 0;
+};
+
+// Thrown instead of the bare message of the error when PostgreSQL aborted the
+// transaction for a serialization failure or a deadlock, after which it may
+// succeed if run again.
+class CDBRetryErr : public std::string
+{
+public:
+	CDBRetryErr(const std::string &msg) : std::string(msg) {}
+};
+
+// Frames that send their independent statements together in pipeline mode.
+enum ePipelineFrame
+{
+	PIPELINE_MF1 = 0,
+	PIPELINE_TC1,
+	PIPELINE_TR5,
+	PIPELINE_TR6,
+	PIPELINE_TU2,
+	PIPELINE_FRAMES
+};
+
+// A statement of the frames, prepared under its name.  paramTypes is NULL
+// for the server to infer all the types, as when the frame passes none.
+typedef struct TPreparedStatement
+{
+	const char *name;
+	const char *sql;
+	int nParams;
+	const Oid *paramTypes;
+} TPreparedStatement;
+
 class CDBConnection
 {
 	char szConnectStr[iMaxConnectString + 1];
@@ -34,22 +81,146 @@ class CDBConnection
 
 	TTradeRequest m_TriggeredLimitOrders;
 
+	// Server times of the request being run, NULL when not asked for.
+	PMsgServerTimes m_pServerTimes;
+
+	// Statements are sent without waiting for the results when set.
+	CDBWait *m_pWait;
+
+	// Transaction control held back to go with the next statement: the
+	// BEGIN not sent yet with its options, and a COMMIT to send right after
+	// that statement, whose result waits for commit().
+	bool m_bBegin;
+	const char *m_szBeginName;
+	const char *m_szIsolation; // NULL for the default
+	bool m_bReadOnly;
+	bool m_bCommitWithNext;
+	PGresult *m_pCommitResult;
+
+	// Pipeline mode: the statements sent but not received yet, as they are
+	// logged, and the results received but not taken yet.
+	typedef struct TPipelined
+	{
+		const char *sql;
+		string params;
+		INT64 llStart; // microseconds, 0 unless captured
+		INT64 llSent; // nanoseconds, for the statistics
+		bool bSent;
+		bool bBegin; // the BEGIN held back, not a statement of the frame
+	} TPipelined;
+
+	bool m_bPipeline;
+	ePipelineFrame m_ePipelineFrame;
+	std::vector<TPipelined> m_Pipelined;
+	std::deque<PGresult *> m_Results;
+
+	// Statements prepared on the connection, found by the address of their
+	// text, or else by the length and hash of the text.
+	ePlanCache m_ePlanCache;
+	std::vector<const TPreparedStatement *> m_Statements;
+	std::unordered_map<const char *, const char *> m_PreparedSql;
+	std::unordered_multimap<size_t, const TPreparedStatement *>
+			m_PreparedText;
+
+	// The statements are only captured up to the level, and in the
+	// transactions sampled.
+	eCaptureLevel m_eCapture;
+	const double *m_pCaptureRates; // by transaction type
+	bool m_bCapture; // the current transaction was sampled
+	unsigned int m_iCaptureSeed;
+	// The binary capture, NULL for text through spdlog, and the identifiers
+	// there of the statements of the list.
+	CCaptureLog *m_pCaptureLog;
+	std::unordered_map<const char *, UINT32> m_CaptureIds;
+	string m_CaptureRecord;
+	INT64 m_llCaptureSequence;
+
+	// Time, rows and errors of each statement run, with the identifiers
+	// there of the statements of the list.
+	CStatementStats m_StatementStats;
+	std::unordered_map<const char *, UINT32> m_StatementIds;
+
+	string beginCommand();
+	void capture(const char *, const string &, INT64, PGresult *);
+	void captureCommand(const char *, const char *);
+	void captureRecord(const char *, const string &, INT64, PGresult *);
+	PGresult *check(const char *, const string &, INT64, PGresult *);
+	void clearResults();
+	void countStatement(UINT32, INT64, PGresult *);
+	void executeMarketFeedEntry(const TMarketFeedFrame1Input *, int,
+			TMarketFeedFrame1Output *, CSendToMarketInterface *);
+	bool flush();
+	PGresult *getResult();
+	void logBegin(const string &);
+	string paramString(int, const Oid *, const char *const *, const int *,
+			const int *);
+	const char *preparedName(const char *);
+	void prepareStatements();
+	PGresult *query(const char *);
+	PGresult *query(const char *, int, const Oid *, const char *const *,
+			const int *, const int *, int);
+	PGresult *pipelineResult();
+	PGresult *queryTransaction(const char *, int, const Oid *,
+			const char *const *, const int *, const int *, int);
+	PGresult *result();
+	UINT32 statementId(const char *);
+	int sendQuery(const char *, int, const Oid *, const char *const *,
+			const int *, const int *, int);
+	void syncPipeline();
+	void warmUp();
+
 protected:
 	PGconn *m_Conn;
 	bool m_bVerbose;
+	// resultFormat of the statements of the frames, 1 for binary.  Their
+	// results are read with the decoders of DBResult.h.
+	int m_iResultFormat;
 
 	std::map<int, string> replace_map;
 
+	bool capturing(eCaptureLevel level) const
+	{
+		return m_bCapture && m_eCapture >= level;
+	}
+	// Capture the value given for a binary parameter of the next statement
+	// instead of its bytes, when the parameters are captured.
+	void replaceDate(int, const TIMESTAMP_STRUCT &);
+	void replaceParam(int, const char *);
+	void replaceTimestamp(int, const TIMESTAMP_STRUCT &);
+
+	// Market Feed and Trade Cleanup, terminated by an entry without name.
+	static const TPreparedStatement Statements[];
+
+	// Statements to prepare on connecting, unless setPlanCache() says not
+	// to.  The list must outlive the connection.
+	void addStatements(const TPreparedStatement *);
+
+	// Statements of a frame that do not need the results of each other are
+	// sent with send() after pipeline(), and their results taken in the same
+	// order with receive().  In pipeline mode they all go in one round trip,
+	// otherwise each is run by send().
+	void pipeline(ePipelineFrame);
+	void send(const char *, int, const Oid *, const char *const *,
+			const int *, const int *, int);
+	PGresult *receive();
+
+	// Whether each frame is a single statement, after which the transaction
+	// can be committed at once.
+	virtual bool framesAreOneStatement();
+
 public:
 	CDBConnection(const char *szHost, const char *szDBName,
 			const char *szDBPort, bool bVerbose = false);
-	~CDBConnection();
+	virtual ~CDBConnection();
 #if TEMPLATE
 	void begin(const char *);
 #else
 	void begin();
 #endif
 	void commit();
+	// Commit along with the statement of the frame about to run, if that is
+	// its only one.  commit() must still be called.
+	void commitWithFrame();
 	void connect();
 	char *escape(string);
 	void disconnect();
@@ -145,9 +316,33 @@ public:
 
 	void rollback();
 
+	void setBinaryResults(bool);
 	void setBrokerageHouse(CBrokerageHouse *);
+	// rates holds the share of the transactions of each type to capture,
+	// from 0 to 1, and must outlive the connection.
+	void setCapture(eCaptureLevel, const double *);
+	// Decide whether to capture the transaction of the type about to run.
+	void sampleCapture(int);
+	void setPipeline(bool);
+	// Prepare the statements added, or not, and plan them as asked.
+	void setPlanCache(ePlanCache);
+	void setWait(CDBWait *);
+	// Wait some microseconds, giving the thread to the other transactions
+	// through the CDBWait set, if any, meanwhile.
+	void backoff(int);
+
+	// Pipeline mode needs libpq 14 or later.
+	static bool pipelineSupported();
+	// Statements sent and round trips taken by the frames in pipeline mode,
+	// as CSV.
+	static void writePipelineStats(std::ostream &);
+	void setServerTimes(PMsgServerTimes);
+	PMsgServerTimes serverTimes();
 
+	// The isolation level and READ ONLY go with the BEGIN held back when
+	// they follow begin().
 	void setReadCommitted();
+	void setReadOnly();
 	void setReadUncommitted();
 	void setRepeatableRead();
 	void setSerializable();
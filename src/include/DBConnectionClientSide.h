@@ -26,6 +26,10 @@ using namespace TPCE;
 
 class CDBConnectionClientSide: public CDBConnection
 {
+private:
+	// Every statement of the frames but those built on the fly.
+	static const TPreparedStatement Statements[];
+
 public:
 	CDBConnectionClientSide(const char *szHost, const char *szDBName,
 			const char *szDBPort, bool bVerbose = false);
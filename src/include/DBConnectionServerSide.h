@@ -8,6 +8,9 @@
 #ifndef DB_CONNECTION_SERVER_SIDE_H
 #define DB_CONNECTION_SERVER_SIDE_H
 
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <libpq-fe.h>
 #include <unistd.h>
 #include <sys/syscall.h>
@@ -15,6 +18,7 @@
 #include "TxnHarnessStructs.h"
 #include "TxnHarnessSendToMarket.h"
 
+#include "ArrayTokenizer.h"
 #include "DBConnection.h"
 #include "BrokerageHouse.h"
 #include "DBT5Consts.h"
@@ -34,6 +38,27 @@ private:
 
 	TTradeRequest m_TriggeredLimitOrders;
 
+	// The elements of the arrays, and the fields of the records, of the
+	// frame being run, kept to split the next ones without allocating.
+	std::vector<TArrayElement> m_Elements;
+	std::vector<TArrayElement> m_Fields;
+	// Number of each column in the last result it was looked up in, by the
+	// address of its name.
+	std::unordered_map<const char *, int> m_Columns;
+	// The array parameter of the frame being run, in the binary format,
+	// kept to encode the next one without allocating.
+	std::string m_Array;
+
+	void beginArray(Oid, int);
+	int column(PGresult *, const char *);
+	const char *int8Array(int, const TTrade *, int, int *);
+	const char *textArray(int, const char *, size_t, int, int *);
+	bool framesAreOneStatement();
+
+	// The stored functions of the frames, terminated by an entry without
+	// name.
+	static const TPreparedStatement Statements[];
+
 public:
 	CDBConnectionServerSide(const char *szHost, const char *szDBName,
 			const char *szDBPort, bool bVerbose = false);
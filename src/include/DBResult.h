@@ -0,0 +1,44 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Values of the columns of a statement result, whether PostgreSQL sent them
+ * as text or in binary.  The binary decoders know int2, int4, int8, float4,
+ * float8, numeric, bool, date, timestamp, bytea and the character types.  A
+ * NULL, or a binary value of a type they do not know, reads as 0 or empty.
+ */
+
+#ifndef DB_RESULT_H
+#define DB_RESULT_H
+
+#include <ostream>
+#include <string>
+#include <libpq-fe.h>
+
+#include "EGenStandardTypes.h"
+using namespace TPCE;
+
+bool getBool(const PGresult *, int, int);
+// Number of bytes copied, at most the size given.  A text bytea is unescaped.
+size_t getBytes(const PGresult *, int, int, char *, size_t);
+double getDouble(const PGresult *, int, int);
+INT32 getInt32(const PGresult *, int, int);
+// The integer part of a numeric, as atoll() does with its text.
+INT64 getInt64(const PGresult *, int, int);
+// Copy at most the length given like strncpy(), the value of a binary column
+// that is not of a character type as its text.
+void getString(const PGresult *, int, int, char *, size_t);
+// A date leaves the time of day at 0, the fraction is in microseconds.
+void getTimestamp(const PGresult *, int, int, TIMESTAMP_STRUCT *);
+
+// Write the value as PostgreSQL would have sent its text.
+void writeValue(std::ostream &, const PGresult *, int, int);
+// The same for a value of the type given, sent in binary.
+void writeBinaryValue(std::ostream &, Oid, const char *, int);
+
+// A binary parameter as the capture logs it, the integer of its length.
+std::string binary_to_int(const char *, int);
+
+#endif // DB_RESULT_H
@@ -20,6 +20,27 @@ const int iMaxConnectString = 128;
 const int iBrokerageHousePort = 30000;
 const int iMarketExchangePort = 30010;
 
+// How the statements of the client-side frames are run: prepared once per
+// connection and left to PostgreSQL to plan generically or not, or forced to
+// either, or else sent as text each time.
+enum ePlanCache
+{
+	PLAN_CACHE_AUTO = 0,
+	PLAN_CACHE_GENERIC,
+	PLAN_CACHE_CUSTOM,
+	PLAN_CACHE_OFF
+};
+
+// What the Brokerage House logs of the statements it runs, each level adding
+// to the one before.
+enum eCaptureLevel
+{
+	CAPTURE_OFF = 0,
+	CAPTURE_STATEMENTS,
+	CAPTURE_PARAMS,
+	CAPTURE_RESULTS
+};
+
 // Transaction Names
 static const char szTransactionName[12][18] = { "SECURITY_DETAIL",
 	"BROKER_VOLUME", "CUSTOMER_POSITION", "MARKET_WATCH", "TRADE_STATUS",
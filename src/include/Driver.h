@@ -16,6 +16,9 @@
 #include "DMSUT.h"
 #include "locking.h"
 
+#include "CustomerReactor.h"
+#include "MixLog.h"
+
 using namespace TPCE;
 
 class CDriver
@@ -23,12 +26,17 @@ class CDriver
 private:
 	CLogFormatTab m_fmt;
 	CEGenLogger *m_pLog;
+	// EGen input files loaded once and shared read-only by every customer.
+	const DataFileManager &m_InputFiles;
 	PDriverCETxnSettings m_pDriverCETxnSettings;
+	// open-loop arrival rate, shared by the reactors
+	CArrivalProfile m_Arrivals;
 	CMutex m_LogLock;
 	ofstream m_fLog; // error log file
-	ofstream m_fMix; // mix log file
+	CMixLogRing *m_pMixLog; // mix log records of the driver
 
 	void logErrorMessage(const string);
+	void logMemoryUsage(const char *);
 
 	friend void *customerWorkerThread(void *);
 	// entry point for driver worker thread
@@ -37,6 +45,8 @@ private:
 	friend void *dmWorkerThread(void *);
 	friend void entryDMWorkerThread(CDriver *);
 
+	friend class CCustomerReactor;
+
 public:
 	char szInDir[iMaxPath + 1];
 	TIdent iConfiguredCustomerCount;
@@ -48,12 +58,15 @@ public:
 	int iBHlistenPort;
 	int iUsers;
 	int iPacingDelay;
+	int iReactors;
+	int iConnections; // shared connections per reactor, 0 for one per user
 	char outputDirectory[iMaxPath + 1];
 	CDMSUT *m_pCDMSUT;
 	CDM *m_pCDM;
 
 	CDriver(const DataFileManager &, char *, TIdent, TIdent, INT32, INT32,
-			UINT32, char *, int, int, int, char *);
+			UINT32, char *, int, int, int, char *, int, int,
+			const CArrivalProfile &);
 	~CDriver();
 
 	void runTest(int, int);
@@ -0,0 +1,143 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Latency histograms with log-linear buckets in the style of HdrHistogram.
+ * Values are nanoseconds, kept with 2 significant decimal digits up to
+ * 2^40 ns (about 18 minutes).
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <vector>
+
+#include "EGenStandardTypes.h"
+using namespace TPCE;
+
+// Number of eTxnType values that are recorded, NULL_TXN excluded.
+#define LATENCY_TXN_TYPES 12
+
+// Transaction outcomes by the status returned by the Brokerage House, as
+// grouped by dbt5-post-process.
+enum eTxnOutcome
+{
+	TXN_SUCCESS = 0, // 0
+	TXN_ROLLBACK, // 1
+	TXN_WARNING, // greater than 1
+	TXN_ERROR, // negative
+	TXN_OUTCOMES
+};
+
+// Parts of the response time of a transaction, as reported by a Brokerage
+// House that times them.
+enum eLatencyPart
+{
+	PART_NETWORK = 0, // response time less the time in the Brokerage House
+	PART_SERVER, // request received to reply ready in the Brokerage House
+	PART_DISPATCH,
+	PART_FRAME_1,
+	PART_FRAME_2,
+	PART_FRAME_3,
+	PART_FRAME_4,
+	PART_FRAME_5,
+	PART_FRAME_6,
+	PART_COMMIT,
+	PART_SEND_TO_MARKET,
+	LATENCY_PARTS
+};
+
+extern const char *szLatencyPartName[LATENCY_PARTS];
+
+// The buckets are only allocated once a value is added, so that copies of
+// the many histograms that stay empty are cheap.
+class CLatencyHistogram
+{
+public:
+	static const int iSubBucketHalfMagnitude = 7;
+	static const int iSubBucketHalf = 1 << iSubBucketHalfMagnitude;
+	static const int iMaxMagnitude = 40;
+	static const int iCounts
+			= (iMaxMagnitude - iSubBucketHalfMagnitude + 1) * iSubBucketHalf;
+
+	static int index(INT64);
+	static INT64 highestEquivalentValue(int);
+
+private:
+	vector<UINT64> m_Counts;
+	UINT64 m_iTotal;
+
+public:
+	CLatencyHistogram();
+
+	void add(int, UINT64);
+	void clear();
+	UINT64 count(int) const;
+	UINT64 total() const;
+	// Latency at or below which the given percentage of values fall.
+	INT64 percentile(double) const;
+	void subtract(const CLatencyHistogram &);
+	void merge(const CLatencyHistogram &);
+};
+
+// Latencies and outcome counts of a set of threads merged for reporting.
+class CLatencySnapshot
+{
+public:
+	CLatencyHistogram histograms[LATENCY_TXN_TYPES];
+	CLatencyHistogram parts[LATENCY_TXN_TYPES][LATENCY_PARTS];
+	UINT64 outcomes[LATENCY_TXN_TYPES][TXN_OUTCOMES];
+	UINT64 socketErrors;
+
+	CLatencySnapshot();
+
+	void merge(const CLatencySnapshot &);
+	void subtract(const CLatencySnapshot &);
+};
+
+// Histogram that only one thread records values in, allocated on first use,
+// while other threads may read it at any time to merge it.
+class CLatencyCounter
+{
+private:
+	std::atomic<std::atomic<UINT32> *> m_pCounts;
+	// Range of buckets used so far, merging only needs to visit those.
+	std::atomic<int> m_iLowest;
+	std::atomic<int> m_iHighest;
+
+public:
+	CLatencyCounter();
+	~CLatencyCounter();
+
+	void mergeInto(CLatencyHistogram *) const;
+	void record(INT64);
+};
+
+// Histograms of one thread, one per transaction type and one per part of
+// each, allocated on first use, and the outcome counts of its transactions.
+// Only the owning thread records values; other threads may read them at any
+// time to merge them.
+class CLatencyRecorder
+{
+private:
+	// The response times of every transaction type, then their parts.
+	static const int iSeries = LATENCY_TXN_TYPES * (1 + LATENCY_PARTS);
+
+	CLatencyCounter m_Series[iSeries];
+	std::atomic<UINT64> m_Outcomes[LATENCY_TXN_TYPES][TXN_OUTCOMES];
+	std::atomic<UINT64> m_SocketErrors;
+
+public:
+	CLatencyRecorder();
+
+	void countOutcome(int, int);
+	void countSocketError();
+	void mergeInto(CLatencySnapshot *) const;
+	void record(int, INT64);
+	void recordPart(int, int, INT64);
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -24,6 +24,7 @@ class CMarketExchange
 private:
 	UINT32 m_UniqueId;
 	int m_iListenPort;
+	char m_szListenAddress[iMaxHostname + 1]; // Unix-domain socket if set
 	CSocket m_Socket;
 	CLogFormatTab m_fmt;
 	CEGenLogger *m_pLog;
@@ -39,7 +40,7 @@ public:
 	CMEE *m_pCMEE;
 
 	CMarketExchange(const DataFileManager &, char *, UINT32, TIdent, TIdent,
-			int, char *, int, char *, bool);
+			int, const char *, char *, int, char *, bool);
 	~CMarketExchange();
 
 	void startListener(void);
@@ -0,0 +1,46 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Live driver metrics served over HTTP in the Prometheus text format.
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <pthread.h>
+
+#include "MixLog.h"
+
+class CMetricsServer
+{
+private:
+	int m_iPort;
+	int m_iListenfd;
+	pthread_t m_tid;
+	std::atomic<bool> m_bStop;
+
+	CMixLogWriter *m_pMixLog;
+
+	// Totals at the last sample and the change over the second before it.
+	CLatencySnapshot m_Total;
+	CLatencySnapshot m_LastSecond;
+	double m_dElapsed;
+	string m_sPage;
+
+	void render();
+	void sample();
+	void serve();
+
+	friend void *metricsServerThread(void *);
+
+public:
+	CMetricsServer(int, const char *);
+	~CMetricsServer();
+};
+
+#endif // METRICS_SERVER_H
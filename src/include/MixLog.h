@@ -0,0 +1,140 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Binary mix log: every thread appends fixed size records to its own ring
+ * and a single writer thread drains all of them into one file.  Each ring
+ * also carries the latency histograms of its thread, which the writer
+ * merges into per transaction type percentiles.
+ */
+
+#ifndef MIX_LOG_H
+#define MIX_LOG_H
+
+#include <atomic>
+#include <vector>
+#include <pthread.h>
+
+#include "locking.h"
+#include "CommonStructs.h"
+#include "LatencyHistogram.h"
+using namespace TPCE;
+
+#define MIX_LOG_NAME "mix.bin"
+#define MIX_LOG_MAGIC "DBT5MIX"
+#define MIX_LOG_VERSION 3
+
+#define LATENCY_LOG_NAME "latency.csv"
+#define LATENCY_INTERVAL_LOG_NAME "latency-interval.csv"
+#define LATENCY_PARTS_LOG_NAME "latency-parts.csv"
+
+// Response times logged for socket errors, -1 and -2 seconds.
+#define MIX_RESPONSE_SEND_ERROR (-1000000000LL)
+#define MIX_RESPONSE_RECV_ERROR (-2000000000LL)
+
+// Records kept by a ring owned by a customer thread and by a reactor.
+#define MIX_RING_USER 256
+#define MIX_RING_REACTOR 16384
+
+enum eMixLogRecordKind
+{
+	MIX_RECORD_TXN = 0,
+	MIX_RECORD_START,
+	MIX_RECORD_STOP
+};
+
+// File header, followed by records up to the end of the file.
+typedef struct TMixLogHeader
+{
+	char szMagic[8];
+	UINT32 iVersion;
+	UINT32 iRecordSize;
+} *PMixLogHeader;
+
+typedef struct TMixLogRecord
+{
+	INT64 llTime; // nanoseconds since the epoch
+	INT64 llResponse; // nanoseconds, negative for socket errors
+	INT32 iTxnType;
+	INT32 iStatus;
+	INT32 iPid;
+	INT32 iKind;
+	// All zero when the Brokerage House did not time the transaction.
+	TMsgServerTimes Server;
+} *PMixLogRecord;
+
+// Single producer, single consumer ring of mix log records.  The thread that
+// opened it is the only producer, the writer thread the only consumer.
+class CMixLogRing
+{
+private:
+	vector<TMixLogRecord> m_Records;
+	size_t m_iMask;
+	std::atomic<size_t> m_iHead; // next record to fill
+	std::atomic<size_t> m_iTail; // next record to write out
+	std::atomic<bool> m_bClosed;
+
+	CLatencyRecorder m_Latencies;
+
+	friend class CMixLogWriter;
+
+public:
+	CMixLogRing(size_t);
+
+	// The producer is done, the writer frees the ring once it is empty.
+	void close();
+
+	void logResponseTime(
+			int, int, INT64, pid_t, const TMsgServerTimes * = NULL);
+	void logStartTime(pid_t);
+	void logStopTime(pid_t);
+	void push(const TMixLogRecord &);
+};
+
+class CMixLogWriter
+{
+private:
+	int m_fd;
+	pthread_t m_tid;
+	std::atomic<bool> m_bStop;
+
+	CMutex m_RingsLock;
+	vector<CMixLogRing *> m_Rings;
+	vector<TMixLogRecord> m_Buffer;
+
+	// Latencies of rings already closed, and everything merged so far for
+	// the interval report.
+	CLatencySnapshot m_Retired;
+	CLatencySnapshot m_Reported;
+	char m_szOutputDirectory[iMaxPath + 1];
+	ofstream m_fInterval;
+	time_t m_tNextReport;
+
+	static CMixLogWriter *m_pWriter;
+	static int m_iReportInterval;
+
+	CMixLogWriter(const char *);
+	~CMixLogWriter();
+
+	bool drain();
+	void reportLatencies(ostream &, const char *, CLatencyHistogram *);
+	void reportParts(ostream &, const char *, const CLatencySnapshot &);
+
+	friend void *mixLogWriterThread(void *);
+
+public:
+	// Start the process wide writer on first use.
+	static CMixLogWriter *open(const char *);
+	// Write out everything still queued and stop the writer.
+	static void close();
+	// Seconds between latency percentile reports, 0 for the end only.
+	static void setReportInterval(int);
+
+	// Latencies and outcomes of every thread, live or finished.
+	void mergeLatencies(CLatencySnapshot *);
+	CMixLogRing *openRing(size_t);
+};
+
+#endif // MIX_LOG_H
@@ -0,0 +1,114 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Requests read from the driver connections wait here for a Brokerage House
+ * worker, so that the number of workers and of database connections does not
+ * depend on the number of drivers connected.
+ */
+
+#ifndef REQUEST_QUEUE_H
+#define REQUEST_QUEUE_H
+
+#include <atomic>
+#include <deque>
+#include <pthread.h>
+
+#include "locking.h"
+
+#include "CommonStructs.h"
+#include "CSocket.h"
+
+// Room for a few requests, and at least for a whole request from a driver
+// that predates the framed protocol.
+#define BH_CONNECTION_BUFFER 8192
+
+// What to do with a request when the queue is full.
+enum eQueuePolicy
+{
+	QUEUE_BLOCK = 0, // stop reading the connection until there is room
+	QUEUE_REJECT // answer ERR_TYPE_BUSY at once
+};
+
+// A driver connection.  The reactor reading it and each of its requests
+// waiting for or being run by a worker hold a reference, the socket is
+// closed when the last one is released.
+class CBrokerageConnection
+{
+private:
+	std::atomic<int> m_iRefs;
+
+	~CBrokerageConnection();
+
+public:
+	CSocket m_Socket;
+	// Replies to pipelined requests can be sent by several workers at once.
+	CMutex m_SendLock;
+	int m_iWireVersion;
+
+	// What the reactor reading the connection received of the next
+	// messages, only used by that reactor.
+	char m_Buffer[BH_CONNECTION_BUFFER];
+	size_t m_iReceived;
+	bool m_bChannel; // shared-memory channel
+	bool m_bStalled; // the next request waits for room in the queue
+
+	CBrokerageConnection(int);
+
+	void acquire();
+	void release();
+
+	void send(void *, int);
+	void sendReply(PMsgTimedReply);
+};
+
+typedef struct TBrokerageRequest
+{
+	CBrokerageConnection *pConnection;
+	TMsgDriverBrokerage Message;
+	UINT32 iRequestId;
+	INT64 llReceived; // server clock, only set when the driver asked for times
+} *PBrokerageRequest;
+
+class CRequestQueue
+{
+private:
+	std::deque<PBrokerageRequest> m_Requests;
+	size_t m_iDepth; // 0 for no limit
+	eQueuePolicy m_ePolicy;
+
+	pthread_mutex_t m_Lock;
+	pthread_cond_t m_NotEmpty;
+
+	// Readable while requests are waiting, and while there is room for
+	// more, -1 until asked for.
+	int m_iReadyFd;
+	int m_iRoomFd;
+
+	PBrokerageRequest take();
+
+public:
+	CRequestQueue(size_t, eQueuePolicy);
+	~CRequestQueue();
+
+	// Return false if the queue is full, the caller still owns the request.
+	bool push(PBrokerageRequest);
+	// Wait for the oldest request.
+	PBrokerageRequest pop();
+	// The oldest request, or NULL if there is none.
+	PBrokerageRequest tryPop();
+	size_t size();
+	eQueuePolicy policy() const { return m_ePolicy; }
+
+	// A descriptor to poll() for requests, readable while there are some.
+	int readyFd();
+	// A descriptor to poll() for room, readable while the queue is not full.
+	int roomFd();
+};
+
+static_assert(sizeof(TMsgDriverBrokerage) <= BH_CONNECTION_BUFFER,
+		"a legacy request must fit in the connection buffer");
+
+#endif // REQUEST_QUEUE_H
@@ -0,0 +1,92 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Shared-memory transport: a pair of single-producer single-consumer byte
+ * rings in a memory segment set up over a Unix-domain socket.  The socket
+ * stays open as the doorbell of the channel: a byte is written to it only
+ * when the peer went to sleep waiting for data or for space, and its end of
+ * file tells that the peer is gone.
+ */
+
+#ifndef SHM_CHANNEL_H
+#define SHM_CHANNEL_H
+
+#include <atomic>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "EGenStandardTypes.h"
+using namespace TPCE;
+
+#define SHM_MAGIC 0x4d485344
+#define SHM_RING_SIZE (256 * 1024)
+
+// One direction of a channel.  Positions only grow, the offset in the ring
+// is the position modulo its size.
+struct TShmRing
+{
+	alignas(64) std::atomic<UINT64> iHead; // next byte to read
+	std::atomic<UINT32> bWriterWaiting; // producer asleep until there is space
+	alignas(64) std::atomic<UINT64> iTail; // next byte to write
+	std::atomic<UINT32> bReaderWaiting; // consumer asleep until there is data
+	alignas(64) char Data[SHM_RING_SIZE];
+};
+
+struct TShmSegment
+{
+	UINT32 iMagic;
+	UINT32 iRingSize;
+	TShmRing Rings[2]; // client to server, then server to client
+};
+
+class CShmChannel
+{
+private:
+	int m_iSockfd; // doorbell, owned by the caller
+	TShmSegment *m_pSegment;
+	TShmRing *m_pTx;
+	TShmRing *m_pRx;
+	bool m_bClosed;
+
+	CShmChannel(int, TShmSegment *, bool);
+
+	void ring();
+
+public:
+	// Create a segment and hand it to the server at the other end of a
+	// connected Unix-domain socket.
+	static CShmChannel *connect(int);
+	// Map the segment received from a client.
+	static CShmChannel *accept(int, int);
+
+	~CShmChannel();
+
+	// Copy what is available, or what fits, and return the byte count,
+	// 0 when nothing could be done.
+	size_t read(void *, size_t);
+	size_t write(const struct iovec *, int);
+
+	bool readable();
+	bool writable();
+
+	// Ask the peer to ring once there is data, or space.  Return false if
+	// there already is, the caller must not sleep then.
+	bool armRead();
+	bool armWrite();
+
+	// Consume the doorbell.  Return false once the peer closed its end.
+	bool drain();
+	// Block until the channel is readable, or writable, or closed.
+	void wait(bool);
+
+	bool
+	closed()
+	{
+		return m_bClosed;
+	}
+};
+
+#endif // SHM_CHANNEL_H
@@ -0,0 +1,72 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Statistics of the statements run by the Brokerage House, measured on the
+ * client side in the manner of pg_stat_statements.
+ */
+
+#ifndef STATEMENT_STATS_H
+#define STATEMENT_STATS_H
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+// Statements told apart, the ones beyond are counted together as the last.
+#define STATEMENT_STATS_MAX 256
+
+struct TStatementTotals;
+
+// Counters of the statements run on one connection.  Only the thread using
+// the connection updates them, other threads may read them at any time to
+// merge them, so neither needs a lock.
+class CStatementStats
+{
+private:
+	typedef struct TCounters
+	{
+		std::atomic<UINT64> calls;
+		std::atomic<UINT64> errors;
+		std::atomic<UINT64> rows;
+		std::atomic<INT64> total; // nanoseconds
+		std::atomic<INT64> min;
+		std::atomic<INT64> max;
+		CLatencyCounter latency;
+	} TCounters;
+
+	TCounters m_Counters[STATEMENT_STATS_MAX];
+	// Identifiers of the statements already seen by the connection, so that
+	// only new ones take the lock of the names.
+	std::unordered_map<std::string, UINT32> m_Ids;
+
+	void mergeInto(std::vector<TStatementTotals> &) const;
+
+	template <typename T>
+	static void add(std::atomic<T> &counter, T value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value,
+				std::memory_order_relaxed);
+	}
+
+public:
+	CStatementStats();
+	~CStatementStats();
+
+	UINT32 id(const std::string &);
+	// A run of a statement: nanoseconds taken, rows returned or changed,
+	// and whether it failed.
+	void record(UINT32, INT64, INT64, bool);
+
+	// Totals of every connection, the ones closed included, by statement,
+	// as CSV sorted by total time.
+	static void write(std::ostream &);
+};
+
+#endif // STATEMENT_STATS_H
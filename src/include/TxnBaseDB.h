@@ -30,6 +30,12 @@ protected:
 
 	CDBConnection *pDB;
 
+	// When the BEGIN of the frame about to run was sent, 0 if it was not.
+	INT64 m_llFrameStart;
+
+	// Commit along with the statement of the frame about to run where the
+	// connection can, commitTransaction() must still follow the frame.
+	void commitWithFrame();
 	void commitTransaction();
 	string escape(string);
 
@@ -78,9 +84,15 @@ protected:
 
 	void reconect();
 
+	// Add the time of a frame to the server times of the request.
+	INT64 startFrame();
+	void stopFrame(int, INT64);
+
 	void rollbackTransaction();
 
+	// These go with the BEGIN, sent along with the first statement.
 	void setReadCommitted();
+	void setReadOnly();
 	void setReadUncommitted();
 	void setRepeatableRead();
 	void setSerializable();
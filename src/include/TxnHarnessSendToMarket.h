@@ -13,6 +13,7 @@
 #include "TxnHarnessSendToMarketInterface.h"
 #include "locking.h"
 
+#include "CommonStructs.h"
 #include "DBT5Consts.h"
 #include "CSocket.h"
 
@@ -22,6 +23,8 @@ class CSendToMarket: public CSendToMarketInterface
 	int m_MEport;
 	CSocket *m_Socket;
 	CMutex m_LogLock;
+	// Server times of the request being run, NULL when not asked for.
+	PMsgServerTimes m_pServerTimes;
 
 public:
 	void LogErrorMessage(const string);
@@ -30,6 +33,7 @@ public:
 	~CSendToMarket();
 
 	bool SendToMarket(TTradeRequest &);
+	void setServerTimes(PMsgServerTimes);
 };
 
 #endif // TXN_HARNESS_SENDTOMARKET_H
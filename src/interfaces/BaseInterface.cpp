@@ -15,7 +15,8 @@
 
 CBaseInterface::CBaseInterface(const char type[3], char *outputDirectory,
 		char *addr, const int iListenPort)
-: m_szBHAddress(addr), m_iBHlistenPort(iListenPort)
+: m_szBHAddress(addr), m_iBHlistenPort(iListenPort),
+  m_iWireVersion(WIRE_VERSION_LEGACY), m_iRequestId(0)
 {
 	m_pid = syscall(SYS_gettid);
 
@@ -24,10 +25,7 @@ CBaseInterface::CBaseInterface(const char type[3], char *outputDirectory,
 
 	char filename[iMaxPath + 1];
 
-	memset(filename, 0, sizeof(filename));
-	snprintf(filename, iMaxPath, "%s/mix-%s-%d.log", outputDirectory, type,
-			m_pid);
-	m_fMix.open(filename, ios::out);
+	m_pMixLog = CMixLogWriter::open(outputDirectory)->openRing(MIX_RING_USER);
 
 	memset(filename, 0, sizeof(filename));
 	snprintf(filename, iMaxPath, "%s/error-%s-%d.log", outputDirectory, type,
@@ -41,7 +39,7 @@ CBaseInterface::~CBaseInterface()
 	biDisconnect();
 	delete sock;
 
-	m_fMix.close();
+	m_pMixLog->close();
 }
 
 // connect to BrokerageHouse
@@ -50,6 +48,7 @@ CBaseInterface::biConnect()
 {
 	try {
 		sock->dbt5Connect();
+		negotiate();
 		return true;
 	} catch (std::runtime_error &err) {
 		logErrorMessage(err.what());
@@ -79,29 +78,83 @@ CBaseInterface::biDisconnect()
 	}
 }
 
+// Agree on the wire protocol with the Brokerage House, a peer that does not
+// know the framed protocol answers the hello like an unknown transaction.
+void
+CBaseInterface::negotiate()
+{
+	TMsgHello Hello;
+	memset(&Hello, 0, sizeof(Hello));
+	Hello.iMagic = WIRE_MAGIC;
+	Hello.iVersion = WIRE_VERSION;
+	sock->dbt5Send(reinterpret_cast<void *>(&Hello), sizeof(Hello));
+
+	TMsgHelloReply Reply;
+	memset(&Reply, 0, sizeof(Reply));
+	sock->dbt5Receive(
+			reinterpret_cast<void *>(&Reply), sizeof(TMsgBrokerageDriver));
+	if (Reply.iMagic != WIRE_MAGIC) {
+		m_iWireVersion = WIRE_VERSION_LEGACY;
+		return;
+	}
+	sock->dbt5Receive(
+			reinterpret_cast<void *>(&Reply.iVersion), sizeof(Reply.iVersion));
+	m_iWireVersion
+			= Reply.iVersion < WIRE_VERSION ? Reply.iVersion : WIRE_VERSION;
+}
+
+void
+CBaseInterface::reconnect()
+{
+	biDisconnect();
+	biConnect();
+}
+
 // Connect to BrokerageHouse, send request, receive reply, and calculate RT
 bool
-CBaseInterface::talkToSUT(PMsgDriverBrokerage pRequest)
+CBaseInterface::talkToSUT(eTxnType TxnType, const void *pTxnInput)
 {
 	int length = 0;
-	TMsgBrokerageDriver Reply; // reply message from BrokerageHouse
+	TMsgTimedReply Reply; // reply message from BrokerageHouse
 	memset(&Reply, 0, sizeof(Reply));
 
 	// record txn start time -- please, see TPC-E specification clause
 	// 6.2.1.3
-	CDateTime StartTime; // to time the transaction
+	struct timespec StartTime; // to time the transaction
+	clock_gettime(CLOCK_MONOTONIC, &StartTime);
+
+	// A framed request sends the caller's input as it is, after the header.
+	TMsgHeader Header;
+	struct iovec iov[2];
+	int iovcnt;
+	if (m_iWireVersion >= WIRE_VERSION_FRAMED) {
+		Header.iVersion = m_iWireVersion;
+		Header.iTxnType = TxnType;
+		Header.iLength = txnInputSize(TxnType);
+		Header.iRequestId = ++m_iRequestId;
+		iov[0].iov_base = &Header;
+		iov[0].iov_len = wireHeaderSize(m_iWireVersion);
+		iov[1].iov_base = const_cast<void *>(pTxnInput);
+		iov[1].iov_len = Header.iLength;
+		iovcnt = 2;
+	} else {
+		m_Request.TxnType = TxnType;
+		memcpy(&m_Request.TxnInput, pTxnInput, txnInputSize(TxnType));
+		iov[0].iov_base = &m_Request;
+		iov[0].iov_len = sizeof(m_Request);
+		iovcnt = 1;
+	}
 
 	// send and wait for response
 	try {
-		length = sock->dbt5Send(
-				reinterpret_cast<void *>(pRequest), sizeof(*pRequest));
+		length = sock->dbt5Send(iov, iovcnt);
 	} catch (CSocketErr *pErr) {
-		sock->dbt5Reconnect();
-		logResponseTime(-1, 0, -1);
+		reconnect();
+		logResponseTime(-1, 0, MIX_RESPONSE_SEND_ERROR);
 
 		ostringstream msg;
 		msg << time(NULL) << " " << m_pid << " "
-			<< szTransactionName[pRequest->TxnType] << ": " << endl
+			<< szTransactionName[TxnType] << ": " << endl
 			<< "Error sending " << length << " bytes of data" << endl
 			<< pErr->ErrorText() << endl;
 		logErrorMessage(msg.str());
@@ -109,46 +162,58 @@ CBaseInterface::talkToSUT(PMsgDriverBrokerage pRequest)
 		delete pErr;
 	}
 	try {
-		length = sock->dbt5Receive(
-				reinterpret_cast<void *>(&Reply), sizeof(Reply));
+		// Only one request is outstanding, its reply must be the next one.
+		if (m_iWireVersion >= WIRE_VERSION_PIPELINED) {
+			length = sock->dbt5Receive(reinterpret_cast<void *>(&Reply),
+					wireReplySize(m_iWireVersion));
+			if (Reply.iRequestId != m_iRequestId) {
+				Reply.Reply.iStatus = 0;
+				throw new CSocketErr(CSocketErr::ERR_SOCKET_PROTOCOL,
+						"CBaseInterface::talkToSUT");
+			}
+		} else {
+			length = sock->dbt5Receive(reinterpret_cast<void *>(&Reply.Reply),
+					sizeof(Reply.Reply));
+		}
 	} catch (CSocketErr *pErr) {
-		logResponseTime(-1, 0, -2);
+		logResponseTime(-1, 0, MIX_RESPONSE_RECV_ERROR);
 
 		ostringstream msg;
 		msg << time(NULL) << " " << m_pid << " "
-			<< szTransactionName[pRequest->TxnType] << ": " << endl
+			<< szTransactionName[TxnType] << ": " << endl
 			<< "Error receiving " << length << " bytes of data" << endl
 			<< pErr->ErrorText() << endl;
 		logErrorMessage(msg.str());
 		length = -1;
-		if (pErr->getAction() == CSocketErr::ERR_SOCKET_CLOSED)
-			sock->dbt5Reconnect();
+		if (pErr->getAction() == CSocketErr::ERR_SOCKET_CLOSED
+				|| pErr->getAction() == CSocketErr::ERR_SOCKET_PROTOCOL)
+			reconnect();
 		delete pErr;
 	}
 
 	// record txn end time
-	CDateTime EndTime;
+	struct timespec EndTime;
+	clock_gettime(CLOCK_MONOTONIC, &EndTime);
 
-	// calculate txn response time
-	CDateTime TxnTime;
-	TxnTime.Set(0); // clear time
-	TxnTime.Add(0, (int) ((EndTime - StartTime) * MsPerSecond)); // add ms
+	// calculate txn response time in nanoseconds
+	INT64 TxnTime = (INT64) (EndTime.tv_sec - StartTime.tv_sec) * 1000000000
+			+ (EndTime.tv_nsec - StartTime.tv_nsec);
 
-	// log response time
-	logResponseTime(Reply.iStatus, pRequest->TxnType, TxnTime.MSec() / 1000.0);
+	// log response time, with its parts when the Brokerage House timed them
+	logResponseTime(Reply.Reply.iStatus, TxnType, TxnTime,
+			m_iWireVersion >= WIRE_VERSION_TIMED ? &Reply.Times : NULL);
 
-	if (Reply.iStatus == CBaseTxnErr::SUCCESS)
+	if (Reply.Reply.iStatus == CBaseTxnErr::SUCCESS)
 		return true;
 	return false;
 }
 
 // Log Transaction Response Times
 void
-CBaseInterface::logResponseTime(int iStatus, int iTxnType, double dRT)
+CBaseInterface::logResponseTime(int iStatus, int iTxnType, INT64 llRT,
+		const TMsgServerTimes *pServer)
 {
-	m_fMix << (long long) time(NULL) << "," << iTxnType << "," << iStatus
-		   << "," << dRT << "," << m_pid << endl;
-	m_fMix.flush();
+	m_pMixLog->logResponseTime(iStatus, iTxnType, llRT, m_pid, pServer);
 }
 
 // logErrorMessage
@@ -163,6 +228,5 @@ CBaseInterface::logErrorMessage(const string sErr)
 void
 CBaseInterface::logStopTime()
 {
-	m_fMix << time(NULL) << ",STOP,,," << m_pid << endl;
-	m_fMix.flush();
+	m_pMixLog->logStopTime(m_pid);
 }
@@ -22,78 +22,42 @@ CCESUT::~CCESUT() {}
 bool
 CCESUT::BrokerVolume(PBrokerVolumeTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = BROKER_VOLUME;
-	memcpy(&(request.TxnInput.BrokerVolumeTxnInput), pTxnInput,
-			sizeof(request.TxnInput.BrokerVolumeTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(BROKER_VOLUME, pTxnInput);
 }
 
 // Customer Position
 bool
 CCESUT::CustomerPosition(PCustomerPositionTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = CUSTOMER_POSITION;
-	memcpy(&(request.TxnInput.CustomerPositionTxnInput), pTxnInput,
-			sizeof(request.TxnInput.CustomerPositionTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(CUSTOMER_POSITION, pTxnInput);
 }
 
 // Market Watch
 bool
 CCESUT::MarketWatch(PMarketWatchTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = MARKET_WATCH;
-	memcpy(&(request.TxnInput.MarketWatchTxnInput), pTxnInput,
-			sizeof(request.TxnInput.MarketWatchTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(MARKET_WATCH, pTxnInput);
 }
 
 // Security Detail
 bool
 CCESUT::SecurityDetail(PSecurityDetailTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = SECURITY_DETAIL;
-	memcpy(&(request.TxnInput.SecurityDetailTxnInput), pTxnInput,
-			sizeof(request.TxnInput.SecurityDetailTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(SECURITY_DETAIL, pTxnInput);
 }
 
 // Trade Lookup
 bool
 CCESUT::TradeLookup(PTradeLookupTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = TRADE_LOOKUP;
-	memcpy(&(request.TxnInput.TradeLookupTxnInput), pTxnInput,
-			sizeof(request.TxnInput.TradeLookupTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(TRADE_LOOKUP, pTxnInput);
 }
 
 // Trade Status
 bool
 CCESUT::TradeStatus(PTradeStatusTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = TRADE_STATUS;
-	memcpy(&(request.TxnInput.TradeStatusTxnInput), pTxnInput,
-			sizeof(request.TxnInput.TradeStatusTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(TRADE_STATUS, pTxnInput);
 }
 
 // Trade Order
@@ -101,24 +65,12 @@ bool
 CCESUT::TradeOrder(PTradeOrderTxnInput pTxnInput, INT32 iTradeType,
 		bool bExecutorIsAccountOwner)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = TRADE_ORDER;
-	memcpy(&(request.TxnInput.TradeOrderTxnInput), pTxnInput,
-			sizeof(request.TxnInput.TradeOrderTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(TRADE_ORDER, pTxnInput);
 }
 
 // Trade Update
 bool
 CCESUT::TradeUpdate(PTradeUpdateTxnInput pTxnInput)
 {
-	memset(&request, 0, sizeof(struct TMsgDriverBrokerage));
-
-	request.TxnType = TRADE_UPDATE;
-	memcpy(&(request.TxnInput.TradeUpdateTxnInput), pTxnInput,
-			sizeof(request.TxnInput.TradeUpdateTxnInput));
-
-	return talkToSUT(&request);
+	return talkToSUT(TRADE_UPDATE, pTxnInput);
 }
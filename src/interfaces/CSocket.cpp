@@ -12,20 +12,64 @@
 #include <sstream>
 #include <unistd.h>
 #include <stdexcept>
+#include <stddef.h>
 
 #include "CSocket.h"
 #include "CThreadErr.h"
 
 #define LISTENQ 1024
 
+#define TRANSPORT_UNIX_PREFIX "unix:"
+#define TRANSPORT_SHM_PREFIX "shm:"
+
+// Tell the transport of an address and where its path starts.
+eTransport
+CSocket::parseAddress(const char *address, const char **path)
+{
+	if (strncmp(address, TRANSPORT_UNIX_PREFIX, strlen(TRANSPORT_UNIX_PREFIX))
+			== 0) {
+		*path = address + strlen(TRANSPORT_UNIX_PREFIX);
+		return TRANSPORT_UNIX;
+	}
+	if (strncmp(address, TRANSPORT_SHM_PREFIX, strlen(TRANSPORT_SHM_PREFIX))
+			== 0) {
+		*path = address + strlen(TRANSPORT_SHM_PREFIX);
+		return TRANSPORT_SHM;
+	}
+	*path = address;
+	return TRANSPORT_TCP;
+}
+
+socklen_t
+CSocket::unixAddress(const char *path, struct sockaddr_un *sa)
+{
+	bzero(sa, sizeof(*sa));
+	sa->sun_family = AF_UNIX;
+	if (*path == '\0' || strlen(path) >= sizeof(sa->sun_path)) {
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_HOSTBYNAME, "CSocket::unixAddress");
+	}
+	strcpy(sa->sun_path, path);
+	return offsetof(struct sockaddr_un, sun_path) + strlen(path) + 1;
+}
+
 // Constructor
-CSocket::CSocket(void): m_listenfd(0), m_sockfd(0) {}
+CSocket::CSocket(void)
+: port(0), m_eTransport(TRANSPORT_TCP), m_listenfd(0), m_sockfd(0),
+  m_bProbe(false), m_pChannel(NULL)
+{
+	address[0] = '\0';
+}
 
-CSocket::CSocket(char *address, int port): m_listenfd(0), m_sockfd(0)
+CSocket::CSocket(char *address, int port)
+: m_listenfd(0), m_sockfd(0), m_bProbe(false), m_pChannel(NULL)
 {
 	strncpy(this->address, address, iMaxHostname);
 	this->address[iMaxHostname] = '\0';
 	this->port = port;
+
+	const char *path;
+	m_eTransport = parseAddress(this->address, &path);
 }
 
 // Destructor
@@ -39,7 +83,7 @@ CSocket::~CSocket()
 int
 CSocket::dbt5Accept(void)
 {
-	struct sockaddr_in sa;
+	struct sockaddr_storage sa;
 
 	socklen_t addrlen = sizeof(sa);
 	errno = 0;
@@ -54,6 +98,43 @@ CSocket::dbt5Accept(void)
 void
 CSocket::dbt5Connect()
 {
+	if (m_eTransport != TRANSPORT_TCP) {
+		const char *path;
+		parseAddress(address, &path);
+		struct sockaddr_un sa;
+		socklen_t len = unixAddress(path, &sa);
+
+		errno = 0;
+		m_sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (m_sockfd == -1) {
+			throwError(CSocketErr::ERR_SOCKET_CREATE);
+		}
+
+		// Try to connect 5 times total, waiting 1 second between attempts.
+		bool ok = false;
+		for (int i = 0; i < 5; i++) {
+			if ((connect(m_sockfd, (struct sockaddr *) &sa, len)) != -1) {
+				ok = true;
+				break;
+			}
+			sleep(1);
+		}
+		if (ok == false) {
+			dbt5Disconnect();
+			throwError(CSocketErr::ERR_SOCKET_CONNECT);
+		}
+
+		if (m_eTransport == TRANSPORT_SHM) {
+			try {
+				m_pChannel = CShmChannel::connect(m_sockfd);
+			} catch (CSocketErr *) {
+				dbt5Disconnect();
+				throw;
+			}
+		}
+		return;
+	}
+
 	errno = 0;
 	m_sockfd = socket(AF_INET, SOCK_STREAM, resolveProto("tcp"));
 	if (m_sockfd == -1) {
@@ -101,8 +182,67 @@ CSocket::dbt5Connect()
 void
 CSocket::dbt5Disconnect()
 {
+	delete m_pChannel;
+	m_pChannel = NULL;
+	m_bProbe = false;
 	if (m_sockfd != 0)
 		close(m_sockfd);
+	m_sockfd = 0;
+}
+
+// Read the first byte sent by a Unix-domain client.  A shared-memory client
+// sends a single byte with the descriptor of its segment, any other byte is
+// the start of the data and is stored.  Return the number of bytes of data,
+// or -1 if nothing was sent yet and the caller does not want to wait.
+int
+CSocket::probe(void *data, bool bWait)
+{
+
+	char byte;
+	struct iovec iov;
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+
+	union {
+		struct cmsghdr header;
+		char buffer[CMSG_SPACE(sizeof(int))];
+	} control;
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+
+	ssize_t received;
+	do {
+		errno = 0;
+		received = recvmsg(m_sockfd, &msg,
+				MSG_CMSG_CLOEXEC | (bWait ? 0 : MSG_DONTWAIT));
+	} while (received == -1 && (errno == EINTR || (bWait && errno == EAGAIN)));
+	if (received == -1 && errno == EAGAIN) {
+		return -1;
+	} else if (received == -1) {
+		throwError(CSocketErr::ERR_SOCKET_RECV);
+	} else if (received == 0) {
+		throwError(CSocketErr::ERR_SOCKET_CLOSED);
+	}
+
+	m_bProbe = false;
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET
+			|| cmsg->cmsg_type != SCM_RIGHTS
+			|| cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+		*reinterpret_cast<char *>(data) = byte;
+		return 1;
+	}
+
+	int memfd;
+	memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+	m_pChannel = CShmChannel::accept(m_sockfd, memfd);
+	m_eTransport = TRANSPORT_SHM;
+	return 0;
 }
 
 // Receive
@@ -110,10 +250,28 @@ int
 CSocket::dbt5Receive(void *data, int length)
 {
 	int received, total, remaining;
-	remaining = length;
 	total = 0;
-	char *szData = NULL;
-	do {
+	if (m_bProbe && length > 0)
+		total = probe(data, true);
+
+	if (m_pChannel != NULL) {
+		char *szData = reinterpret_cast<char *>(data);
+		while (total < length) {
+			size_t n = m_pChannel->read(szData + total, length - total);
+			if (n > 0)
+				total += n;
+			else if (m_pChannel->closed())
+				throwError(CSocketErr::ERR_SOCKET_CLOSED);
+			else
+				m_pChannel->wait(false);
+		}
+		return total;
+	}
+
+	remaining = length - total;
+	char *szData = reinterpret_cast<char *>(data) + total;
+	data = reinterpret_cast<void *>(szData);
+	while (total < length) {
 		errno = 0;
 		received = recv(m_sockfd, data, remaining, MSG_WAITALL);
 		if (received == -1 && errno == EAGAIN) {
@@ -130,7 +288,7 @@ CSocket::dbt5Receive(void *data, int length)
 		szData += received;
 		data = reinterpret_cast<void *>(szData);
 		remaining -= received;
-	} while (total != length);
+	}
 
 	if (length != total) {
 		throwError(CSocketErr::ERR_SOCKET_RECVPARTIAL);
@@ -139,6 +297,56 @@ CSocket::dbt5Receive(void *data, int length)
 	return total;
 }
 
+// Receive what has arrived, up to length bytes, without waiting.  Fewer
+// bytes than asked for means that there is nothing more for now, and that a
+// shared-memory channel rings its doorbell once there is.
+int
+CSocket::dbt5ReceiveAvailable(void *data, int length)
+{
+	int total = 0;
+	if (m_bProbe && length > 0) {
+		total = probe(data, false);
+		if (total == -1)
+			return 0;
+	}
+
+	char *szData = reinterpret_cast<char *>(data);
+	if (m_pChannel != NULL) {
+		while (total < length) {
+			size_t n = m_pChannel->read(szData + total, length - total);
+			if (n > 0) {
+				total += n;
+				continue;
+			}
+			if (!m_pChannel->drain()) {
+				if (total > 0)
+					break;
+				throwError(CSocketErr::ERR_SOCKET_CLOSED);
+			}
+			if (m_pChannel->armRead())
+				break;
+		}
+		return total;
+	}
+
+	while (total < length) {
+		errno = 0;
+		ssize_t received
+				= recv(m_sockfd, szData + total, length - total, MSG_DONTWAIT);
+		if (received == -1 && errno == EINTR) {
+			continue;
+		} else if (received == -1 && errno == EAGAIN) {
+			break;
+		} else if (received == -1) {
+			throwError(CSocketErr::ERR_SOCKET_RECV);
+		} else if (received == 0) {
+			throwError(CSocketErr::ERR_SOCKET_CLOSED);
+		}
+		total += received;
+	}
+	return total;
+}
+
 void
 CSocket::dbt5Reconnect()
 {
@@ -149,6 +357,13 @@ CSocket::dbt5Reconnect()
 int
 CSocket::dbt5Send(void *data, int length)
 {
+	if (m_pChannel != NULL) {
+		struct iovec iov;
+		iov.iov_base = data;
+		iov.iov_len = length;
+		return dbt5Send(&iov, 1);
+	}
+
 	int sent = 0;
 	int remaining = length;
 	char *szData = NULL;
@@ -175,6 +390,68 @@ CSocket::dbt5Send(void *data, int length)
 	return sent;
 }
 
+// Send several buffers with a single system call.  The iovec array is
+// updated as data goes out.
+int
+CSocket::dbt5Send(struct iovec *iov, int iovcnt)
+{
+	int total = 0;
+
+	if (m_pChannel != NULL) {
+		while (iovcnt > 0) {
+			if (m_pChannel->closed())
+				throwError(CSocketErr::ERR_SOCKET_CLOSED);
+			size_t sent = m_pChannel->write(iov, iovcnt);
+			if (sent == 0) {
+				m_pChannel->wait(true);
+				continue;
+			}
+			total += sent;
+
+			// Skip what has been written.
+			while (iovcnt > 0 && sent >= iov->iov_len) {
+				sent -= iov->iov_len;
+				++iov;
+				--iovcnt;
+			}
+			if (iovcnt > 0) {
+				iov->iov_base = (char *) iov->iov_base + sent;
+				iov->iov_len -= sent;
+			}
+		}
+		return total;
+	}
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+	while (msg.msg_iovlen > 0) {
+		errno = 0;
+		ssize_t sent = sendmsg(m_sockfd, &msg, 0);
+
+		if (sent == -1) {
+			throwError(CSocketErr::ERR_SOCKET_SEND);
+		} else if (sent == 0) {
+			throwError(CSocketErr::ERR_SOCKET_CLOSED);
+		}
+		total += sent;
+
+		// Skip what has been sent.
+		while (msg.msg_iovlen > 0 && (size_t) sent >= msg.msg_iov->iov_len) {
+			sent -= msg.msg_iov->iov_len;
+			++msg.msg_iov;
+			--msg.msg_iovlen;
+		}
+		if (msg.msg_iovlen > 0) {
+			msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + sent;
+			msg.msg_iov->iov_len -= sent;
+		}
+	}
+
+	return total;
+}
+
 void
 CSocket::dbt5Listen(const int port)
 {
@@ -211,6 +488,41 @@ CSocket::dbt5Listen(const int port)
 	}
 }
 
+// Listen on a Unix-domain socket when the address asks for one, on the TCP
+// port otherwise.
+void
+CSocket::dbt5Listen(const char *address, const int port)
+{
+	const char *path;
+	if (address == NULL
+			|| parseAddress(address, &path) == TRANSPORT_TCP) {
+		dbt5Listen(port);
+		return;
+	}
+
+	struct sockaddr_un sa;
+	socklen_t len = unixAddress(path, &sa);
+
+	errno = 0;
+	m_listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listenfd < 0) {
+		throwError(CSocketErr::ERR_SOCKET_CREATE);
+	}
+
+	// Take over the socket left behind by an earlier run.
+	unlink(path);
+
+	errno = 0;
+	if (bind(m_listenfd, (struct sockaddr *) &sa, len) < 0) {
+		throwError(CSocketErr::ERR_SOCKET_BIND);
+	}
+
+	errno = 0;
+	if (listen(m_listenfd, LISTENQ) < 0) {
+		throwError(CSocketErr::ERR_SOCKET_LISTEN);
+	}
+}
+
 // ResolveProto
 int
 CSocket::resolveProto(const char *proto)
@@ -225,6 +537,21 @@ CSocket::resolveProto(const char *proto)
 	return protocol->p_proto;
 }
 
+// Take over an accepted socket.
+void
+CSocket::setSocketFd(int sockfd)
+{
+	m_sockfd = sockfd;
+
+	struct sockaddr_storage sa;
+	socklen_t len = sizeof(sa);
+	if (getsockname(sockfd, (struct sockaddr *) &sa, &len) == 0
+			&& sa.ss_family == AF_UNIX) {
+		m_eTransport = TRANSPORT_UNIX;
+		m_bProbe = true;
+	}
+}
+
 // throwError
 void
 CSocket::throwError(CSocketErr::Action eAction)
@@ -0,0 +1,248 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Binary capture.  As with the mix log, threads never wait for file I/O
+ * unless their ring is full: the writer thread wakes up every few
+ * milliseconds to append whatever is queued.
+ */
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <iostream>
+
+#include "CaptureLog.h"
+#include "CThreadErr.h"
+
+// How long the writer sleeps when there was nothing to write.
+#define CAPTURE_WRITER_SLEEP_NS 10000000
+
+CCaptureLog *CCaptureLog::m_pLog = NULL;
+static pthread_mutex_t captureLogLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Ring of the calling thread, opened on its first record.
+static thread_local CCaptureRing *pThreadRing = NULL;
+
+// Constructor, the capacity is rounded up to a power of 2
+CCaptureRing::CCaptureRing(size_t iCapacity)
+: m_iHead(0), m_iTail(0)
+{
+	size_t size = 1;
+	while (size < iCapacity)
+		size <<= 1;
+	m_Buffer.resize(size);
+	m_iMask = size - 1;
+}
+
+void
+CCaptureRing::push(const char *data, size_t length)
+{
+	size_t head = m_iHead.load(std::memory_order_relaxed);
+
+	// Records are never dropped, wait for the writer if the ring is full.
+	while (head + length - m_iTail.load(std::memory_order_acquire)
+			> m_Buffer.size()) {
+		sched_yield();
+	}
+
+	size_t offset = head & m_iMask;
+	size_t first = std::min(length, m_Buffer.size() - offset);
+	memcpy(&m_Buffer[offset], data, first);
+	memcpy(&m_Buffer[0], data + first, length - first);
+	m_iHead.store(head + length, std::memory_order_release);
+}
+
+// writer thread
+void *
+captureLogWriterThread(void *data)
+{
+	CCaptureLog *pLog = reinterpret_cast<CCaptureLog *>(data);
+
+	while (!pLog->m_bStop.load(std::memory_order_acquire)) {
+		if (!pLog->drain()) {
+			struct timespec ts;
+			ts.tv_sec = 0;
+			ts.tv_nsec = CAPTURE_WRITER_SLEEP_NS;
+			nanosleep(&ts, NULL);
+		}
+	}
+	// Pick up anything captured while stopping.
+	while (pLog->drain())
+		;
+
+	return NULL;
+}
+
+// Constructor
+CCaptureLog::CCaptureLog(const char *filename, int iLevel)
+: m_bStop(false)
+{
+	m_fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (m_fd == -1) {
+		std::cerr << "cannot create capture " << filename << std::endl;
+	} else {
+		TCaptureLogHeader header;
+		memset(&header, 0, sizeof(header));
+		strncpy(header.szMagic, CAPTURE_LOG_MAGIC, sizeof(header.szMagic));
+		header.iVersion = CAPTURE_LOG_VERSION;
+		header.iLevel = iLevel;
+		write(reinterpret_cast<const char *>(&header), sizeof(header));
+	}
+
+	if (pthread_create(&m_tid, NULL, &captureLogWriterThread,
+				reinterpret_cast<void *>(this))
+			!= 0) {
+		throw new CThreadErr(
+				CThreadErr::ERR_THREAD_CREATE, "CCaptureLog::CCaptureLog");
+	}
+}
+
+// Destructor.  Nothing may be captured any more.
+CCaptureLog::~CCaptureLog()
+{
+	m_bStop.store(true, std::memory_order_release);
+	pthread_join(m_tid, NULL);
+
+	for (size_t i = 0; i < m_Rings.size(); i++)
+		delete m_Rings[i];
+	if (m_fd != -1)
+		::close(m_fd);
+}
+
+// Write out every record queued, ring by ring.  Returns whether anything was
+// written.
+bool
+CCaptureLog::drain()
+{
+	bool bWritten = false;
+
+	m_RingsLock.lock();
+	for (size_t i = 0; i < m_Rings.size(); i++) {
+		CCaptureRing *pRing = m_Rings[i];
+		size_t head = pRing->m_iHead.load(std::memory_order_acquire);
+		size_t tail = pRing->m_iTail.load(std::memory_order_relaxed);
+		if (head == tail)
+			continue;
+
+		size_t offset = tail & pRing->m_iMask;
+		size_t first = std::min(head - tail, pRing->m_Buffer.size() - offset);
+		m_FileLock.lock();
+		write(&pRing->m_Buffer[offset], first);
+		write(&pRing->m_Buffer[0], head - tail - first);
+		m_FileLock.unlock();
+		pRing->m_iTail.store(head, std::memory_order_release);
+		bWritten = true;
+	}
+	m_RingsLock.unlock();
+
+	return bWritten;
+}
+
+void
+CCaptureLog::write(const char *data, size_t length)
+{
+	if (m_fd == -1)
+		return;
+
+	while (length > 0) {
+		ssize_t written = ::write(m_fd, data, length);
+		if (written == -1) {
+			if (errno == EINTR)
+				continue;
+			std::cerr << "cannot write capture, errno " << errno
+					  << std::endl;
+			break;
+		}
+		data += written;
+		length -= written;
+	}
+}
+
+CCaptureLog *
+CCaptureLog::open(const char *filename, int iLevel)
+{
+	pthread_mutex_lock(&captureLogLock);
+	if (m_pLog == NULL)
+		m_pLog = new CCaptureLog(filename, iLevel);
+	pthread_mutex_unlock(&captureLogLock);
+
+	return m_pLog;
+}
+
+CCaptureLog *
+CCaptureLog::get()
+{
+	return m_pLog;
+}
+
+void
+CCaptureLog::close()
+{
+	pthread_mutex_lock(&captureLogLock);
+	delete m_pLog;
+	m_pLog = NULL;
+	pthread_mutex_unlock(&captureLogLock);
+}
+
+void
+CCaptureLog::push(const char *data, size_t length)
+{
+	if (length > CAPTURE_RING_SIZE / 4) {
+		// Whatever the thread queued before goes out first.
+		while (pThreadRing != NULL
+				&& pThreadRing->m_iTail.load(std::memory_order_acquire)
+						!= pThreadRing->m_iHead.load(
+								std::memory_order_relaxed)) {
+			sched_yield();
+		}
+		m_FileLock.lock();
+		write(data, length);
+		m_FileLock.unlock();
+		return;
+	}
+
+	if (pThreadRing == NULL) {
+		pThreadRing = new CCaptureRing(CAPTURE_RING_SIZE);
+		m_RingsLock.lock();
+		m_Rings.push_back(pThreadRing);
+		m_RingsLock.unlock();
+	}
+	pThreadRing->push(data, length);
+}
+
+UINT32
+CCaptureLog::statementId(const char *name, const char *sql)
+{
+	m_StatementsLock.lock();
+	std::map<std::string, UINT32>::iterator it = m_Statements.find(name);
+	if (it != m_Statements.end()) {
+		UINT32 id = it->second;
+		m_StatementsLock.unlock();
+		return id;
+	}
+	UINT32 id = m_Statements.size() + 1;
+	m_Statements[name] = id;
+
+	std::string record(sizeof(TCaptureRecord), '\0');
+	record.append(name, strlen(name) + 1);
+	record.append(sql, strlen(sql) + 1);
+	TCaptureRecord header;
+	memset(&header, 0, sizeof(header));
+	header.iLength = record.size();
+	header.iKind = CAPTURE_RECORD_STATEMENT;
+	header.iStatement = id;
+	memcpy(&record[0], &header, sizeof(header));
+	// Other threads may log the statement before the writer gets to the
+	// definition, CaptureDecode reads all the definitions first.
+	push(record.data(), record.size());
+	m_StatementsLock.unlock();
+
+	return id;
+}
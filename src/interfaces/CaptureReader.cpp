@@ -0,0 +1,133 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <iostream>
+
+#include "CaptureReader.h"
+
+// Constructor
+CCaptureReader::CCaptureReader()
+: m_pData(NULL), m_iSize(0), m_pRecord(NULL), m_pNext(NULL)
+{
+}
+
+// Destructor
+CCaptureReader::~CCaptureReader()
+{
+	if (m_pData != NULL)
+		munmap(m_pData, m_iSize);
+}
+
+bool
+CCaptureReader::open(const char *filename)
+{
+	int fd = ::open(filename, O_RDONLY);
+	if (fd == -1) {
+		std::cerr << "cannot open " << filename << std::endl;
+		return false;
+	}
+
+	struct stat sb;
+	if (fstat(fd, &sb) == -1
+			|| (size_t) sb.st_size < sizeof(TCaptureLogHeader)) {
+		std::cerr << filename << " is not a capture" << std::endl;
+		close(fd);
+		return false;
+	}
+
+	char *data = (char *) mmap(
+			NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		std::cerr << "cannot map " << filename << std::endl;
+		return false;
+	}
+	m_pData = data;
+	m_iSize = sb.st_size;
+
+	const TCaptureLogHeader *pHeader = header();
+	if (strncmp(pHeader->szMagic, CAPTURE_LOG_MAGIC, sizeof(pHeader->szMagic))
+					!= 0
+			|| pHeader->iVersion != CAPTURE_LOG_VERSION) {
+		std::cerr << filename << " is not a version " << CAPTURE_LOG_VERSION
+				  << " capture" << std::endl;
+		return false;
+	}
+
+	const char *pFirst = m_pData + sizeof(TCaptureLogHeader);
+	TCaptureRecord record;
+	for (const char *p = pFirst; readRecord(p, &record); p += record.iLength) {
+		if (record.iKind != CAPTURE_RECORD_STATEMENT)
+			continue;
+
+		CRecordReader reader(p + sizeof(record), p + record.iLength);
+		std::string name = reader.text();
+		m_Statements[record.iStatement] = std::make_pair(name, reader.text());
+	}
+	m_pNext = pFirst;
+
+	return true;
+}
+
+const TCaptureLogHeader *
+CCaptureReader::header() const
+{
+	return reinterpret_cast<const TCaptureLogHeader *>(m_pData);
+}
+
+bool
+CCaptureReader::next(TCaptureRecord *pRecord, CRecordReader *pReader)
+{
+	while (readRecord(m_pNext, pRecord)) {
+		m_pRecord = m_pNext;
+		m_pNext += pRecord->iLength;
+		if (pRecord->iKind == CAPTURE_RECORD_STATEMENT)
+			continue;
+
+		*pReader = CRecordReader(m_pRecord + sizeof(*pRecord), m_pNext);
+		return true;
+	}
+	return false;
+}
+
+size_t
+CCaptureReader::offset() const
+{
+	return m_pRecord - m_pData;
+}
+
+// Copy the header of the record at p, false if it does not fit in the file.
+bool
+CCaptureReader::readRecord(const char *p, TCaptureRecord *pRecord) const
+{
+	const char *pEnd = m_pData + m_iSize;
+	if (pEnd - p < (ptrdiff_t) sizeof(*pRecord))
+		return false;
+	memcpy(pRecord, p, sizeof(*pRecord));
+	return pRecord->iLength >= sizeof(*pRecord)
+			&& (ptrdiff_t) pRecord->iLength <= pEnd - p;
+}
+
+const char *
+CCaptureReader::statement(UINT32 id) const
+{
+	std::map<UINT32, std::pair<std::string, std::string> >::const_iterator it
+			= m_Statements.find(id);
+	return it != m_Statements.end() ? it->second.second.c_str() : NULL;
+}
+
+const char *
+CCaptureReader::statementName(UINT32 id) const
+{
+	std::map<UINT32, std::pair<std::string, std::string> >::const_iterator it
+			= m_Statements.find(id);
+	return it != m_Statements.end() ? it->second.first.c_str() : NULL;
+}
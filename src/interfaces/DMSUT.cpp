@@ -22,26 +22,12 @@ CDMSUT::~CDMSUT() {}
 bool
 CDMSUT::DataMaintenance(PDataMaintenanceTxnInput pTxnInput)
 {
-	PMsgDriverBrokerage pRequest = new TMsgDriverBrokerage;
-	memset(pRequest, 0, sizeof(TMsgDriverBrokerage));
-
-	pRequest->TxnType = DATA_MAINTENANCE;
-	memcpy(&(pRequest->TxnInput.DataMaintenanceTxnInput), pTxnInput,
-			sizeof(TDataMaintenanceTxnInput));
-
-	return talkToSUT(pRequest);
+	return talkToSUT(DATA_MAINTENANCE, pTxnInput);
 }
 
 // Trade Cleanup
 bool
 CDMSUT::TradeCleanup(PTradeCleanupTxnInput pTxnInput)
 {
-	PMsgDriverBrokerage pRequest = new TMsgDriverBrokerage;
-	memset(pRequest, 0, sizeof(TMsgDriverBrokerage));
-
-	pRequest->TxnType = TRADE_CLEANUP;
-	memcpy(&(pRequest->TxnInput.TradeCleanupTxnInput), pTxnInput,
-			sizeof(TTradeCleanupTxnInput));
-
-	return talkToSUT(pRequest);
+	return talkToSUT(TRADE_CLEANUP, pTxnInput);
 }
@@ -0,0 +1,292 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Latency histograms.  A value v lands in bucket b = floor(log2(v)) - 7 and
+ * within it in one of 128 linear sub-buckets, so the relative error stays
+ * below 1% from 1 ns up to the largest value tracked.
+ */
+
+#include "LatencyHistogram.h"
+
+const char *szLatencyPartName[LATENCY_PARTS] = { "network", "server",
+	"dispatch", "frame1", "frame2", "frame3", "frame4", "frame5", "frame6",
+	"commit", "send_to_market" };
+
+int
+CLatencyHistogram::index(INT64 value)
+{
+	if (value < 0)
+		value = 0;
+	if (value >= (1LL << iMaxMagnitude))
+		value = (1LL << iMaxMagnitude) - 1;
+
+	int bucket = 63
+			- __builtin_clzll((UINT64) value | (2 * iSubBucketHalf - 1))
+			- iSubBucketHalfMagnitude;
+	int subBucket = (int) (value >> bucket);
+	return ((bucket + 1) << iSubBucketHalfMagnitude) + subBucket
+			- iSubBucketHalf;
+}
+
+INT64
+CLatencyHistogram::highestEquivalentValue(int index)
+{
+	int bucket = (index >> iSubBucketHalfMagnitude) - 1;
+	INT64 subBucket = (index & (iSubBucketHalf - 1)) + iSubBucketHalf;
+	if (bucket < 0) {
+		subBucket -= iSubBucketHalf;
+		bucket = 0;
+	}
+	return (subBucket << bucket) + (1LL << bucket) - 1;
+}
+
+// Constructor
+CLatencyHistogram::CLatencyHistogram(): m_iTotal(0) {}
+
+void
+CLatencyHistogram::add(int index, UINT64 count)
+{
+	if (m_Counts.empty())
+		m_Counts.resize(iCounts, 0);
+	m_Counts[index] += count;
+	m_iTotal += count;
+}
+
+void
+CLatencyHistogram::clear()
+{
+	fill(m_Counts.begin(), m_Counts.end(), 0);
+	m_iTotal = 0;
+}
+
+UINT64
+CLatencyHistogram::count(int index) const
+{
+	if (m_Counts.empty())
+		return 0;
+	return m_Counts[index];
+}
+
+UINT64
+CLatencyHistogram::total() const
+{
+	return m_iTotal;
+}
+
+INT64
+CLatencyHistogram::percentile(double dPercentile) const
+{
+	if (m_iTotal == 0)
+		return 0;
+
+	UINT64 target = (UINT64) (dPercentile / 100.0 * m_iTotal + 0.5);
+	if (target < 1)
+		target = 1;
+
+	UINT64 seen = 0;
+	for (int i = 0; i < iCounts; i++) {
+		seen += m_Counts[i];
+		if (seen >= target)
+			return highestEquivalentValue(i);
+	}
+	return highestEquivalentValue(iCounts - 1);
+}
+
+void
+CLatencyHistogram::merge(const CLatencyHistogram &other)
+{
+	if (other.m_Counts.empty())
+		return;
+	if (m_Counts.empty())
+		m_Counts.resize(iCounts, 0);
+	for (int i = 0; i < iCounts; i++) {
+		m_Counts[i] += other.m_Counts[i];
+	}
+	m_iTotal += other.m_iTotal;
+}
+
+void
+CLatencyHistogram::subtract(const CLatencyHistogram &other)
+{
+	if (other.m_Counts.empty())
+		return;
+	if (m_Counts.empty())
+		m_Counts.resize(iCounts, 0);
+	for (int i = 0; i < iCounts; i++) {
+		m_Counts[i] -= other.m_Counts[i];
+	}
+	m_iTotal -= other.m_iTotal;
+}
+
+// Constructor
+CLatencySnapshot::CLatencySnapshot(): socketErrors(0)
+{
+	memset(outcomes, 0, sizeof(outcomes));
+}
+
+void
+CLatencySnapshot::merge(const CLatencySnapshot &other)
+{
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		histograms[i].merge(other.histograms[i]);
+		for (int j = 0; j < LATENCY_PARTS; j++) {
+			parts[i][j].merge(other.parts[i][j]);
+		}
+		for (int j = 0; j < TXN_OUTCOMES; j++) {
+			outcomes[i][j] += other.outcomes[i][j];
+		}
+	}
+	socketErrors += other.socketErrors;
+}
+
+void
+CLatencySnapshot::subtract(const CLatencySnapshot &other)
+{
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		histograms[i].subtract(other.histograms[i]);
+		for (int j = 0; j < LATENCY_PARTS; j++) {
+			parts[i][j].subtract(other.parts[i][j]);
+		}
+		for (int j = 0; j < TXN_OUTCOMES; j++) {
+			outcomes[i][j] -= other.outcomes[i][j];
+		}
+	}
+	socketErrors -= other.socketErrors;
+}
+
+// Constructor
+CLatencyCounter::CLatencyCounter()
+: m_pCounts(NULL), m_iLowest(CLatencyHistogram::iCounts), m_iHighest(-1)
+{
+}
+
+// Destructor
+CLatencyCounter::~CLatencyCounter()
+{
+	delete[] m_pCounts.load(std::memory_order_relaxed);
+}
+
+// Add everything recorded so far to a histogram.
+void
+CLatencyCounter::mergeInto(CLatencyHistogram *pHistogram) const
+{
+	std::atomic<UINT32> *pCounts = m_pCounts.load(std::memory_order_acquire);
+	if (pCounts == NULL)
+		return;
+
+	int highest = m_iHighest.load(std::memory_order_relaxed);
+	for (int j = m_iLowest.load(std::memory_order_relaxed); j <= highest;
+			j++) {
+		UINT32 count = pCounts[j].load(std::memory_order_relaxed);
+		if (count != 0)
+			pHistogram->add(j, count);
+	}
+}
+
+void
+CLatencyCounter::record(INT64 llValue)
+{
+	std::atomic<UINT32> *pCounts = m_pCounts.load(std::memory_order_relaxed);
+	if (pCounts == NULL) {
+		pCounts = new std::atomic<UINT32>[CLatencyHistogram::iCounts];
+		for (int j = 0; j < CLatencyHistogram::iCounts; j++) {
+			pCounts[j].store(0, std::memory_order_relaxed);
+		}
+		m_pCounts.store(pCounts, std::memory_order_release);
+	}
+
+	int index = CLatencyHistogram::index(llValue);
+	if (index < m_iLowest.load(std::memory_order_relaxed))
+		m_iLowest.store(index, std::memory_order_relaxed);
+	if (index > m_iHighest.load(std::memory_order_relaxed))
+		m_iHighest.store(index, std::memory_order_relaxed);
+
+	std::atomic<UINT32> &count = pCounts[index];
+	count.store(count.load(std::memory_order_relaxed) + 1,
+			std::memory_order_relaxed);
+}
+
+// Constructor
+CLatencyRecorder::CLatencyRecorder()
+{
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		for (int j = 0; j < TXN_OUTCOMES; j++) {
+			m_Outcomes[i][j].store(0, std::memory_order_relaxed);
+		}
+	}
+	m_SocketErrors.store(0, std::memory_order_relaxed);
+}
+
+// Single writer: a plain load and store is enough, readers only need to see
+// a value that is not torn.
+static inline void
+increment(std::atomic<UINT64> &counter)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + 1,
+			std::memory_order_relaxed);
+}
+
+void
+CLatencyRecorder::countOutcome(int iTxnType, int iStatus)
+{
+	if (iTxnType < 0 || iTxnType >= LATENCY_TXN_TYPES)
+		return;
+
+	int outcome;
+	if (iStatus == 0)
+		outcome = TXN_SUCCESS;
+	else if (iStatus == 1)
+		outcome = TXN_ROLLBACK;
+	else if (iStatus > 1)
+		outcome = TXN_WARNING;
+	else
+		outcome = TXN_ERROR;
+	increment(m_Outcomes[iTxnType][outcome]);
+}
+
+void
+CLatencyRecorder::countSocketError()
+{
+	increment(m_SocketErrors);
+}
+
+// Add everything recorded so far to a snapshot.
+void
+CLatencyRecorder::mergeInto(CLatencySnapshot *pSnapshot) const
+{
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		for (int j = 0; j < TXN_OUTCOMES; j++) {
+			pSnapshot->outcomes[i][j]
+					+= m_Outcomes[i][j].load(std::memory_order_relaxed);
+		}
+	}
+
+	for (int i = 0; i < iSeries; i++) {
+		CLatencyHistogram *pHistogram = i < LATENCY_TXN_TYPES
+				? &pSnapshot->histograms[i]
+				: &pSnapshot->parts[(i - LATENCY_TXN_TYPES) / LATENCY_PARTS]
+								   [(i - LATENCY_TXN_TYPES) % LATENCY_PARTS];
+		m_Series[i].mergeInto(pHistogram);
+	}
+	pSnapshot->socketErrors += m_SocketErrors.load(std::memory_order_relaxed);
+}
+
+void
+CLatencyRecorder::record(int iTxnType, INT64 llValue)
+{
+	if (iTxnType < 0 || iTxnType >= LATENCY_TXN_TYPES)
+		return;
+	m_Series[iTxnType].record(llValue);
+}
+
+void
+CLatencyRecorder::recordPart(int iTxnType, int iPart, INT64 llValue)
+{
+	if (iTxnType < 0 || iTxnType >= LATENCY_TXN_TYPES)
+		return;
+	m_Series[LATENCY_TXN_TYPES + iTxnType * LATENCY_PARTS + iPart].record(
+			llValue);
+}
@@ -13,18 +13,11 @@ void *
 TradeResultAsync(void *data)
 {
 	PMEESUTThreadParam pThrParam = reinterpret_cast<PMEESUTThreadParam>(data);
-	struct TMsgDriverBrokerage request;
-
-	memset(&request, 0, sizeof(TMsgDriverBrokerage));
-
-	request.TxnType = TRADE_RESULT;
-	memcpy(&(request.TxnInput.TradeResultTxnInput),
-			&(pThrParam->TxnInput.m_TradeResultTxnInput),
-			sizeof(request.TxnInput.TradeResultTxnInput));
 
 	// communicate with the SUT and log response time
 	pThrParam->pCMEESUT->m_SocketLock.lock();
-	pThrParam->pCMEESUT->talkToSUT(&request);
+	pThrParam->pCMEESUT->talkToSUT(
+			TRADE_RESULT, &(pThrParam->TxnInput.m_TradeResultTxnInput));
 	pThrParam->pCMEESUT->m_SocketLock.unlock();
 
 	delete pThrParam;
@@ -93,18 +86,11 @@ void *
 MarketFeedAsync(void *data)
 {
 	PMEESUTThreadParam pThrParam = reinterpret_cast<PMEESUTThreadParam>(data);
-	struct TMsgDriverBrokerage request;
-
-	memset(&request, 0, sizeof(TMsgDriverBrokerage));
-
-	request.TxnType = MARKET_FEED;
-	memcpy(&(request.TxnInput.MarketFeedTxnInput),
-			&(pThrParam->TxnInput.m_MarketFeedTxnInput),
-			sizeof(request.TxnInput.MarketFeedTxnInput));
 
 	// communicate with the SUT and log response time
 	pThrParam->pCMEESUT->m_SocketLock.lock();
-	pThrParam->pCMEESUT->talkToSUT(&request);
+	pThrParam->pCMEESUT->talkToSUT(
+			MARKET_FEED, &(pThrParam->TxnInput.m_MarketFeedTxnInput));
 	pThrParam->pCMEESUT->m_SocketLock.unlock();
 
 	delete pThrParam;
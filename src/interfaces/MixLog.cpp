@@ -0,0 +1,424 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * Binary mix log.  Threads never block on file I/O: a record is copied into
+ * the thread's ring and the writer thread wakes up every few milliseconds to
+ * append whatever is queued with a single write().  Latency histograms
+ * are recorded by the producing thread and only merged by the writer, at
+ * the report interval and when the writer is closed.
+ */
+
+#include <fcntl.h>
+#include <iomanip>
+#include <sched.h>
+#include <unistd.h>
+
+#include "MixLog.h"
+#include "CThreadErr.h"
+#include "CommonStructs.h"
+#include "DBT5Consts.h"
+
+// How long the writer sleeps when there was nothing to write.
+#define MIX_WRITER_SLEEP_NS 10000000
+
+CMixLogWriter *CMixLogWriter::m_pWriter = NULL;
+int CMixLogWriter::m_iReportInterval = 0;
+static pthread_mutex_t mixLogWriterLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Constructor, the capacity is rounded up to a power of 2
+CMixLogRing::CMixLogRing(size_t iCapacity)
+: m_iHead(0), m_iTail(0), m_bClosed(false)
+{
+	size_t size = 1;
+	while (size < iCapacity)
+		size <<= 1;
+	m_Records.resize(size);
+	m_iMask = size - 1;
+}
+
+void
+CMixLogRing::close()
+{
+	m_bClosed.store(true, std::memory_order_release);
+}
+
+static INT64
+realtimeNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (INT64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void
+CMixLogRing::logResponseTime(int iStatus, int iTxnType, INT64 llResponse,
+		pid_t pid, const TMsgServerTimes *pServer)
+{
+	if (llResponse >= 0) {
+		m_Latencies.record(iTxnType, llResponse);
+		m_Latencies.countOutcome(iTxnType, iStatus);
+	} else {
+		m_Latencies.countSocketError();
+	}
+
+	// A timed reply splits the response time between the network and each
+	// part of the work of the Brokerage House.
+	bool bTimed = llResponse >= 0 && pServer != NULL && pServer->llTotal > 0;
+	if (bTimed) {
+		m_Latencies.recordPart(
+				iTxnType, PART_NETWORK, llResponse - pServer->llTotal);
+		m_Latencies.recordPart(iTxnType, PART_SERVER, pServer->llTotal);
+		m_Latencies.recordPart(iTxnType, PART_DISPATCH, pServer->llDispatch);
+		for (int i = 0; i < SERVER_TIME_FRAMES; i++) {
+			if (pServer->llFrame[i] > 0) {
+				m_Latencies.recordPart(
+						iTxnType, PART_FRAME_1 + i, pServer->llFrame[i]);
+			}
+		}
+		if (pServer->llCommit > 0)
+			m_Latencies.recordPart(iTxnType, PART_COMMIT, pServer->llCommit);
+		if (pServer->llSendToMarket > 0) {
+			m_Latencies.recordPart(
+					iTxnType, PART_SEND_TO_MARKET, pServer->llSendToMarket);
+		}
+	}
+
+	TMixLogRecord record;
+	record.llTime = realtimeNs();
+	record.llResponse = llResponse;
+	record.iTxnType = iTxnType;
+	record.iStatus = iStatus;
+	record.iPid = pid;
+	record.iKind = MIX_RECORD_TXN;
+	if (bTimed)
+		record.Server = *pServer;
+	else
+		memset(&record.Server, 0, sizeof(record.Server));
+	push(record);
+}
+
+void
+CMixLogRing::logStartTime(pid_t pid)
+{
+	TMixLogRecord record;
+	memset(&record, 0, sizeof(record));
+	record.llTime = realtimeNs();
+	record.iPid = pid;
+	record.iKind = MIX_RECORD_START;
+	push(record);
+}
+
+void
+CMixLogRing::logStopTime(pid_t pid)
+{
+	TMixLogRecord record;
+	memset(&record, 0, sizeof(record));
+	record.llTime = realtimeNs();
+	record.iPid = pid;
+	record.iKind = MIX_RECORD_STOP;
+	push(record);
+}
+
+void
+CMixLogRing::push(const TMixLogRecord &record)
+{
+	size_t head = m_iHead.load(std::memory_order_relaxed);
+
+	// Records are never dropped, wait for the writer if the ring is full.
+	while (head - m_iTail.load(std::memory_order_acquire) > m_iMask) {
+		sched_yield();
+	}
+
+	m_Records[head & m_iMask] = record;
+	m_iHead.store(head + 1, std::memory_order_release);
+}
+
+// writer thread
+void *
+mixLogWriterThread(void *data)
+{
+	CMixLogWriter *pWriter = reinterpret_cast<CMixLogWriter *>(data);
+
+	while (!pWriter->m_bStop.load(std::memory_order_acquire)) {
+		bool bWritten = pWriter->drain();
+
+		if (pWriter->m_tNextReport != 0
+				&& time(NULL) >= pWriter->m_tNextReport) {
+			CLatencySnapshot current;
+			pWriter->mergeLatencies(&current);
+
+			CLatencySnapshot interval = current;
+			interval.subtract(pWriter->m_Reported);
+			pWriter->m_Reported = current;
+
+			ostringstream label;
+			label << time(NULL);
+			pWriter->reportLatencies(pWriter->m_fInterval,
+					label.str().c_str(), interval.histograms);
+			pWriter->m_tNextReport += CMixLogWriter::m_iReportInterval;
+		}
+
+		if (!bWritten) {
+			struct timespec ts;
+			ts.tv_sec = 0;
+			ts.tv_nsec = MIX_WRITER_SLEEP_NS;
+			nanosleep(&ts, NULL);
+		}
+	}
+	// Pick up anything logged while stopping.
+	while (pWriter->drain())
+		;
+
+	return NULL;
+}
+
+// Constructor
+CMixLogWriter::CMixLogWriter(const char *outputDirectory)
+: m_bStop(false), m_tNextReport(0)
+{
+	strncpy(m_szOutputDirectory, outputDirectory, iMaxPath);
+	m_szOutputDirectory[iMaxPath] = '\0';
+
+	char filename[iMaxPath + 1];
+	snprintf(filename, iMaxPath, "%s/%s", outputDirectory, MIX_LOG_NAME);
+	m_fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (m_fd == -1) {
+		cerr << "cannot create mix log " << filename << endl;
+	} else {
+		TMixLogHeader header;
+		memset(&header, 0, sizeof(header));
+		strncpy(header.szMagic, MIX_LOG_MAGIC, sizeof(header.szMagic));
+		header.iVersion = MIX_LOG_VERSION;
+		header.iRecordSize = sizeof(TMixLogRecord);
+		if (write(m_fd, &header, sizeof(header)) != sizeof(header)) {
+			cerr << "cannot write mix log header" << endl;
+		}
+	}
+
+	if (m_iReportInterval > 0) {
+		snprintf(filename, iMaxPath, "%s/%s", outputDirectory,
+				LATENCY_INTERVAL_LOG_NAME);
+		m_fInterval.open(filename, ios::out);
+		m_fInterval << "time,txn,count,p50_ms,p90_ms,p95_ms,p99_ms,p99.9_ms,"
+					   "p99.99_ms,max_ms"
+					<< endl;
+		m_tNextReport = time(NULL) + m_iReportInterval;
+	}
+
+	if (pthread_create(&m_tid, NULL, &mixLogWriterThread,
+				reinterpret_cast<void *>(this))
+			!= 0) {
+		throw new CThreadErr(
+				CThreadErr::ERR_THREAD_CREATE, "CMixLogWriter::CMixLogWriter");
+	}
+}
+
+// Destructor
+CMixLogWriter::~CMixLogWriter()
+{
+	m_bStop.store(true, std::memory_order_release);
+	pthread_join(m_tid, NULL);
+
+	CLatencySnapshot total;
+	mergeLatencies(&total);
+
+	char filename[iMaxPath + 1];
+	snprintf(filename, iMaxPath, "%s/%s", m_szOutputDirectory,
+			LATENCY_LOG_NAME);
+	ofstream fLatency(filename, ios::out);
+	fLatency << "time,txn,count,p50_ms,p90_ms,p95_ms,p99_ms,p99.9_ms,"
+				"p99.99_ms,max_ms"
+			 << endl;
+	ostringstream label;
+	label << time(NULL);
+	reportLatencies(fLatency, label.str().c_str(), total.histograms);
+	fLatency.close();
+
+	cout << "Response time percentiles (ms):" << endl;
+	reportLatencies(cout, "total", total.histograms);
+
+	snprintf(filename, iMaxPath, "%s/%s", m_szOutputDirectory,
+			LATENCY_PARTS_LOG_NAME);
+	ofstream fParts(filename, ios::out);
+	fParts << "time,txn,part,count,p50_ms,p90_ms,p95_ms,p99_ms,p99.9_ms,"
+			  "p99.99_ms,max_ms"
+		   << endl;
+	reportParts(fParts, label.str().c_str(), total);
+	fParts.close();
+
+	// Only a Brokerage House that times transactions reports their parts.
+	UINT64 iTimed = 0;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		iTimed += total.parts[i][PART_SERVER].total();
+	}
+	if (iTimed > 0) {
+		cout << "Response time parts percentiles (ms):" << endl;
+		reportParts(cout, "total", total);
+	}
+
+	for (size_t i = 0; i < m_Rings.size(); i++) {
+		delete m_Rings[i];
+	}
+	if (m_fd != -1)
+		::close(m_fd);
+	m_fInterval.close();
+}
+
+// Copy out every queued record and write them with one system call.
+// Returns whether anything was written.
+bool
+CMixLogWriter::drain()
+{
+	m_Buffer.clear();
+
+	m_RingsLock.lock();
+	for (size_t i = 0; i < m_Rings.size();) {
+		CMixLogRing *pRing = m_Rings[i];
+
+		// Check for close before reading the head so that no record pushed
+		// before close() is missed.
+		bool bClosed = pRing->m_bClosed.load(std::memory_order_acquire);
+		size_t head = pRing->m_iHead.load(std::memory_order_acquire);
+		size_t tail = pRing->m_iTail.load(std::memory_order_relaxed);
+		for (; tail != head; tail++) {
+			m_Buffer.push_back(pRing->m_Records[tail & pRing->m_iMask]);
+		}
+		pRing->m_iTail.store(tail, std::memory_order_release);
+
+		if (bClosed) {
+			pRing->m_Latencies.mergeInto(&m_Retired);
+			delete pRing;
+			m_Rings[i] = m_Rings.back();
+			m_Rings.pop_back();
+		} else {
+			i++;
+		}
+	}
+	m_RingsLock.unlock();
+
+	if (m_Buffer.empty())
+		return false;
+
+	if (m_fd != -1) {
+		const char *data = reinterpret_cast<const char *>(&m_Buffer[0]);
+		size_t length = m_Buffer.size() * sizeof(TMixLogRecord);
+		while (length > 0) {
+			ssize_t written = write(m_fd, data, length);
+			if (written == -1) {
+				if (errno == EINTR)
+					continue;
+				cerr << "cannot write mix log, errno " << errno << endl;
+				break;
+			}
+			data += written;
+			length -= written;
+		}
+	}
+	return true;
+}
+
+CMixLogWriter *
+CMixLogWriter::open(const char *outputDirectory)
+{
+	pthread_mutex_lock(&mixLogWriterLock);
+	if (m_pWriter == NULL)
+		m_pWriter = new CMixLogWriter(outputDirectory);
+	pthread_mutex_unlock(&mixLogWriterLock);
+
+	return m_pWriter;
+}
+
+void
+CMixLogWriter::close()
+{
+	pthread_mutex_lock(&mixLogWriterLock);
+	delete m_pWriter;
+	m_pWriter = NULL;
+	pthread_mutex_unlock(&mixLogWriterLock);
+}
+
+// Histograms and outcome counts of every thread, live or finished.
+void
+CMixLogWriter::mergeLatencies(CLatencySnapshot *pSnapshot)
+{
+	m_RingsLock.lock();
+	*pSnapshot = m_Retired;
+	for (size_t i = 0; i < m_Rings.size(); i++) {
+		m_Rings[i]->m_Latencies.mergeInto(pSnapshot);
+	}
+	m_RingsLock.unlock();
+}
+
+static const double percentiles[] = { 50, 90, 95, 99, 99.9, 99.99, 100 };
+
+static void
+reportPercentiles(ostream &os, const CLatencyHistogram &histogram)
+{
+	os << "," << histogram.total();
+	for (size_t j = 0; j < sizeof(percentiles) / sizeof(percentiles[0]); j++) {
+		os << "," << histogram.percentile(percentiles[j]) / 1000000.0;
+	}
+	os << endl;
+}
+
+void
+CMixLogWriter::reportLatencies(
+		ostream &os, const char *szLabel, CLatencyHistogram *pHistograms)
+{
+	streamsize precision = os.precision(3);
+	os << fixed;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		if (pHistograms[i].total() == 0)
+			continue;
+
+		os << szLabel << "," << szTransactionName[i];
+		reportPercentiles(os, pHistograms[i]);
+	}
+	os.unsetf(ios::floatfield);
+	os.precision(precision);
+	os.flush();
+}
+
+// Percentiles of the parts of the response times, for the transactions a
+// Brokerage House timed.
+void
+CMixLogWriter::reportParts(
+		ostream &os, const char *szLabel, const CLatencySnapshot &snapshot)
+{
+	streamsize precision = os.precision(3);
+	os << fixed;
+	for (int i = 0; i < LATENCY_TXN_TYPES; i++) {
+		for (int j = 0; j < LATENCY_PARTS; j++) {
+			if (snapshot.parts[i][j].total() == 0)
+				continue;
+
+			os << szLabel << "," << szTransactionName[i] << ","
+			   << szLatencyPartName[j];
+			reportPercentiles(os, snapshot.parts[i][j]);
+		}
+	}
+	os.unsetf(ios::floatfield);
+	os.precision(precision);
+	os.flush();
+}
+
+void
+CMixLogWriter::setReportInterval(int iSeconds)
+{
+	m_iReportInterval = iSeconds;
+}
+
+CMixLogRing *
+CMixLogWriter::openRing(size_t iCapacity)
+{
+	CMixLogRing *pRing = new CMixLogRing(iCapacity);
+
+	m_RingsLock.lock();
+	m_Rings.push_back(pRing);
+	m_RingsLock.unlock();
+
+	return pRing;
+}
@@ -0,0 +1,283 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * The client creates the segment with memfd_create() and passes its
+ * descriptor to the server with SCM_RIGHTS along with a single byte.  The
+ * rings need no lock: each position is written by one side only, and the
+ * waiting flags are set and tested around the positions with sequentially
+ * consistent operations so that a sleeper is always woken.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "ShmChannel.h"
+#include "CThreadErr.h"
+
+// How long to poll the ring before going to sleep on the doorbell.
+#define SHM_SPIN_NS 20000
+// How long to sleep before looking at the ring again.  A thread reading and
+// another writing share the doorbell, one may consume the ring meant for the
+// other.
+#define SHM_SLEEP_MS 100
+
+static inline void
+cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+static long long
+monotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Constructor
+CShmChannel::CShmChannel(int iSockfd, TShmSegment *pSegment, bool bServer)
+: m_iSockfd(iSockfd), m_pSegment(pSegment), m_bClosed(false)
+{
+	m_pTx = &pSegment->Rings[bServer ? 1 : 0];
+	m_pRx = &pSegment->Rings[bServer ? 0 : 1];
+}
+
+// Destructor
+CShmChannel::~CShmChannel()
+{
+	munmap(m_pSegment, sizeof(TShmSegment));
+}
+
+CShmChannel *
+CShmChannel::connect(int iSockfd)
+{
+	int memfd = memfd_create("dbt5-shm", MFD_CLOEXEC);
+	if (memfd == -1) {
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_CREATE, "CShmChannel::connect");
+	}
+	if (ftruncate(memfd, sizeof(TShmSegment)) == -1) {
+		close(memfd);
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_CREATE, "CShmChannel::connect");
+	}
+	void *p = mmap(NULL, sizeof(TShmSegment), PROT_READ | PROT_WRITE,
+			MAP_SHARED, memfd, 0);
+	if (p == MAP_FAILED) {
+		close(memfd);
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_CREATE, "CShmChannel::connect");
+	}
+
+	// A new segment is zero filled, the rings are empty.
+	TShmSegment *pSegment = reinterpret_cast<TShmSegment *>(p);
+	pSegment->iMagic = SHM_MAGIC;
+	pSegment->iRingSize = SHM_RING_SIZE;
+
+	char byte = 'S';
+	struct iovec iov;
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+
+	union {
+		struct cmsghdr header;
+		char buffer[CMSG_SPACE(sizeof(int))];
+	} control;
+	memset(&control, 0, sizeof(control));
+
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+
+	ssize_t sent = sendmsg(iSockfd, &msg, MSG_NOSIGNAL);
+	close(memfd);
+	if (sent != 1) {
+		munmap(p, sizeof(TShmSegment));
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_SEND, "CShmChannel::connect");
+	}
+
+	return new CShmChannel(iSockfd, pSegment, false);
+}
+
+CShmChannel *
+CShmChannel::accept(int iSockfd, int memfd)
+{
+	struct stat sb;
+	if (fstat(memfd, &sb) == -1 || (size_t) sb.st_size < sizeof(TShmSegment)) {
+		close(memfd);
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_PROTOCOL, "CShmChannel::accept");
+	}
+
+	void *p = mmap(NULL, sizeof(TShmSegment), PROT_READ | PROT_WRITE,
+			MAP_SHARED, memfd, 0);
+	close(memfd);
+	if (p == MAP_FAILED) {
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_CREATE, "CShmChannel::accept");
+	}
+
+	TShmSegment *pSegment = reinterpret_cast<TShmSegment *>(p);
+	if (pSegment->iMagic != SHM_MAGIC
+			|| pSegment->iRingSize != SHM_RING_SIZE) {
+		munmap(p, sizeof(TShmSegment));
+		throw new CSocketErr(
+				CSocketErr::ERR_SOCKET_PROTOCOL, "CShmChannel::accept");
+	}
+
+	return new CShmChannel(iSockfd, pSegment, true);
+}
+
+bool
+CShmChannel::armRead()
+{
+	m_pRx->bReaderWaiting.store(1);
+	return !readable();
+}
+
+bool
+CShmChannel::armWrite()
+{
+	m_pTx->bWriterWaiting.store(1);
+	return !writable();
+}
+
+bool
+CShmChannel::drain()
+{
+	char buffer[64];
+	while (true) {
+		ssize_t received
+				= recv(m_iSockfd, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (received > 0 || (received == -1 && errno == EINTR))
+			continue;
+		if (received == 0 || errno != EAGAIN)
+			m_bClosed = true;
+		return !m_bClosed;
+	}
+}
+
+size_t
+CShmChannel::read(void *data, size_t length)
+{
+	UINT64 head = m_pRx->iHead.load(std::memory_order_relaxed);
+	UINT64 available = m_pRx->iTail.load(std::memory_order_acquire) - head;
+	if (available == 0)
+		return 0;
+	if (length > available)
+		length = available;
+
+	size_t offset = head % SHM_RING_SIZE;
+	size_t first = length < SHM_RING_SIZE - offset ? length
+												  : SHM_RING_SIZE - offset;
+	memcpy(data, m_pRx->Data + offset, first);
+	memcpy(reinterpret_cast<char *>(data) + first, m_pRx->Data,
+			length - first);
+
+	m_pRx->iHead.store(head + length);
+	if (m_pRx->bWriterWaiting.load() && m_pRx->bWriterWaiting.exchange(0))
+		ring();
+
+	return length;
+}
+
+bool
+CShmChannel::readable()
+{
+	return m_pRx->iTail.load()
+			!= m_pRx->iHead.load(std::memory_order_relaxed);
+}
+
+// Wake the peer.  A full socket buffer means it has been woken already.
+void
+CShmChannel::ring()
+{
+	char byte = 0;
+	send(m_iSockfd, &byte, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+void
+CShmChannel::wait(bool bWrite)
+{
+	// Spinning only helps when the peer can run at the same time.
+	static const bool bSpin = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+
+	long long llStart = monotonicNs();
+	for (int i = 1; bSpin; i++) {
+		if (m_bClosed || (bWrite ? writable() : readable()))
+			return;
+		if (i % 64 == 0 && monotonicNs() - llStart > SHM_SPIN_NS)
+			break;
+		cpuRelax();
+	}
+
+	if (!(bWrite ? armWrite() : armRead()))
+		return;
+
+	struct pollfd pfd;
+	pfd.fd = m_iSockfd;
+	pfd.events = POLLIN;
+	while (poll(&pfd, 1, SHM_SLEEP_MS) == -1 && errno == EINTR)
+		;
+	drain();
+}
+
+bool
+CShmChannel::writable()
+{
+	return m_pTx->iTail.load(std::memory_order_relaxed) - m_pTx->iHead.load()
+			< SHM_RING_SIZE;
+}
+
+size_t
+CShmChannel::write(const struct iovec *iov, int iovcnt)
+{
+	UINT64 tail = m_pTx->iTail.load(std::memory_order_relaxed);
+	size_t space = SHM_RING_SIZE
+			- (tail - m_pTx->iHead.load(std::memory_order_acquire));
+
+	size_t total = 0;
+	for (int i = 0; i < iovcnt && space > 0; i++) {
+		size_t length = iov[i].iov_len < space ? iov[i].iov_len : space;
+		const char *data = reinterpret_cast<const char *>(iov[i].iov_base);
+		size_t offset = (tail + total) % SHM_RING_SIZE;
+		size_t first = length < SHM_RING_SIZE - offset ? length
+													  : SHM_RING_SIZE - offset;
+		memcpy(m_pTx->Data + offset, data, first);
+		memcpy(m_pTx->Data, data + first, length - first);
+		total += length;
+		space -= length;
+	}
+	if (total == 0)
+		return 0;
+
+	m_pTx->iTail.store(tail + total);
+	if (m_pTx->bReaderWaiting.load() && m_pTx->bReaderWaiting.exchange(0))
+		ring();
+
+	return total;
+}
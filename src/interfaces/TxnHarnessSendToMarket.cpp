@@ -11,7 +11,7 @@
 
 CSendToMarket::CSendToMarket(
 		ofstream *pfile, char *addr, int MEport = iMarketExchangePort)
-: m_pfLog(pfile), m_MEport(MEport)
+: m_pfLog(pfile), m_MEport(MEport), m_pServerTimes(NULL)
 {
 	if (addr != NULL)
 		m_Socket = new CSocket(addr, m_MEport);
@@ -29,6 +29,7 @@ CSendToMarket::~CSendToMarket()
 bool
 CSendToMarket::SendToMarket(TTradeRequest &trade_mes)
 {
+	INT64 llStart = m_pServerTimes != NULL ? serverClockNs() : 0;
 	try {
 		// send Trade Request to MEE
 		m_Socket->dbt5Send(
@@ -45,9 +46,17 @@ CSendToMarket::SendToMarket(TTradeRequest &trade_mes)
 		return false;
 	}
 
+	if (m_pServerTimes != NULL)
+		m_pServerTimes->llSendToMarket += serverClockNs() - llStart;
 	return true;
 }
 
+void
+CSendToMarket::setServerTimes(PMsgServerTimes pServerTimes)
+{
+	m_pServerTimes = pServerTimes;
+}
+
 // LogErrorMessage
 void
 CSendToMarket::LogErrorMessage(const string sErr)
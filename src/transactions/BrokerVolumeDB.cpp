@@ -35,6 +35,8 @@ CBrokerVolumeDB::DoBrokerVolumeFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -35,6 +35,7 @@ CCustomerPositionDB::DoCustomerPositionFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
 	execute(pIn, pOut);
 
 	if (m_bVerbose) {
@@ -90,6 +91,7 @@ CCustomerPositionDB::DoCustomerPositionFrame2(
 			 << m_pid << " -- cust_id: " << pIn->acct_id << endl;
 	}
 
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -39,6 +39,7 @@ CDataMaintenanceDB::DoDataMaintenanceFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	commitWithFrame();
 	execute(pIn);
 	commitTransaction();
 
@@ -38,6 +38,8 @@ CMarketWatchDB::DoMarketWatchFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 
 	commitTransaction();
@@ -42,6 +42,8 @@ CSecurityDetailDB::DoSecurityDetailFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
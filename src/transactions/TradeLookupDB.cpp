@@ -35,6 +35,8 @@ CTradeLookupDB::DoTradeLookupFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -139,6 +141,8 @@ CTradeLookupDB::DoTradeLookupFrame2(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -244,6 +248,8 @@ CTradeLookupDB::DoTradeLookupFrame3(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -354,6 +360,8 @@ CTradeLookupDB::DoTradeLookupFrame4(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
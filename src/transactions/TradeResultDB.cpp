@@ -187,6 +187,7 @@ CTradeResultDB::DoTradeResultFrame6(
 			 << m_pid << " -- type_name: " << pIn->type_name << endl;
 	}
 
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -32,6 +32,8 @@ CTradeStatusDB::DoTradeStatusFrame1(
 #endif
 	// Isolation level required by Clause 7.4.1.3
 	setReadCommitted();
+	setReadOnly();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
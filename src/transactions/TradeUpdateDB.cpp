@@ -35,6 +35,7 @@ CTradeUpdateDB::DoTradeUpdateFrame1(
 	startTransaction();
 #endif
 	setRepeatableRead();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -140,6 +141,7 @@ CTradeUpdateDB::DoTradeUpdateFrame2(
 	startTransaction();
 #endif
 	setRepeatableRead();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -246,6 +248,7 @@ CTradeUpdateDB::DoTradeUpdateFrame3(
 	startTransaction();
 #endif
 	setRepeatableRead();
+	commitWithFrame();
 	execute(pIn, pOut);
 	commitTransaction();
 
@@ -12,7 +12,7 @@
 #include "TxnHarnessSendToMarketInterface.h"
 
 CTxnBaseDB::CTxnBaseDB(CDBConnection *pDB, bool bVerbose)
-: m_bVerbose(bVerbose), pDB(pDB)
+: m_bVerbose(bVerbose), pDB(pDB), m_llFrameStart(0)
 {
 }
 
@@ -24,7 +24,20 @@ CTxnBaseDB::commitTransaction()
 	if (m_bVerbose) {
 		cout << "COMMIT" << endl;
 	}
+	PMsgServerTimes pTimes = pDB->serverTimes();
+	if (pTimes == NULL) {
+		pDB->commit();
+		return;
+	}
+	INT64 llStart = serverClockNs();
 	pDB->commit();
+	pTimes->llCommit += serverClockNs() - llStart;
+}
+
+void
+CTxnBaseDB::commitWithFrame()
+{
+	pDB->commitWithFrame();
 }
 
 string
@@ -37,179 +50,256 @@ void
 CTxnBaseDB::execute(
 		const TBrokerVolumeFrame1Input *pIn, TBrokerVolumeFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TCustomerPositionFrame1Input *pIn,
 		TCustomerPositionFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TCustomerPositionFrame2Input *pIn,
 		TCustomerPositionFrame2Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(2, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TDataMaintenanceFrame1Input *pIn)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TMarketFeedFrame1Input *pIn,
 		TMarketFeedFrame1Output *pOut, CSendToMarketInterface *pMarketExchange)
 {
+	PMsgServerTimes pTimes = pDB->serverTimes();
+	INT64 llMarket = pTimes != NULL ? pTimes->llSendToMarket : 0;
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut, pMarketExchange);
+	// Sending to the market is timed on its own.
+	if (pTimes != NULL)
+		llStart += pTimes->llSendToMarket - llMarket;
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TMarketWatchFrame1Input *pIn, TMarketWatchFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TSecurityDetailFrame1Input *pIn,
 		TSecurityDetailFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TTradeCleanupFrame1Input *pIn)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeLookupFrame1Input *pIn, TTradeLookupFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeLookupFrame2Input *pIn, TTradeLookupFrame2Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(2, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeLookupFrame3Input *pIn, TTradeLookupFrame3Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(3, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeLookupFrame4Input *pIn, TTradeLookupFrame4Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(4, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeOrderFrame1Input *pIn, TTradeOrderFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeOrderFrame2Input *pIn, TTradeOrderFrame2Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(2, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeOrderFrame3Input *pIn, TTradeOrderFrame3Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(3, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeOrderFrame4Input *pIn, TTradeOrderFrame4Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(4, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeResultFrame1Input *pIn, TTradeResultFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeResultFrame2Input *pIn, TTradeResultFrame2Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(2, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeResultFrame3Input *pIn, TTradeResultFrame3Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(3, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeResultFrame4Input *pIn, TTradeResultFrame4Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(4, llStart);
 }
 
 void
 CTxnBaseDB::execute(const TTradeResultFrame5Input *pIn)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn);
+	stopFrame(5, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeResultFrame6Input *pIn, TTradeResultFrame6Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(6, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeStatusFrame1Input *pIn, TTradeStatusFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeUpdateFrame1Input *pIn, TTradeUpdateFrame1Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(1, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeUpdateFrame2Input *pIn, TTradeUpdateFrame2Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(2, llStart);
 }
 
 void
 CTxnBaseDB::execute(
 		const TTradeUpdateFrame3Input *pIn, TTradeUpdateFrame3Output *pOut)
 {
+	INT64 llStart = startFrame();
 	pDB->execute(pIn, pOut);
+	stopFrame(3, llStart);
+}
+
+// Start timing a frame, from the BEGIN when it starts the transaction.
+INT64
+CTxnBaseDB::startFrame()
+{
+	if (pDB->serverTimes() == NULL)
+		return 0;
+	INT64 llStart = m_llFrameStart;
+	m_llFrameStart = 0;
+	return llStart != 0 ? llStart : serverClockNs();
+}
+
+void
+CTxnBaseDB::stopFrame(int iFrame, INT64 llStart)
+{
+	PMsgServerTimes pTimes = pDB->serverTimes();
+	if (pTimes == NULL)
+		return;
+	pTimes->llFrame[iFrame - 1] += serverClockNs() - llStart;
 }
 
 void
@@ -228,6 +318,8 @@ CTxnBaseDB::startTransaction(const char *macroName)
 	if (m_bVerbose) {
 		cout << "BEGIN" << endl;
 	}
+	if (pDB->serverTimes() != NULL)
+		m_llFrameStart = serverClockNs();
 	pDB->begin(macroName);
 #else
 CTxnBaseDB::startTransaction()
@@ -235,6 +327,8 @@ CTxnBaseDB::startTransaction()
 	if (m_bVerbose) {
 		cout << "BEGIN" << endl;
 	}
+	if (pDB->serverTimes() != NULL)
+		m_llFrameStart = serverClockNs();
 	pDB->begin();
 #endif
 }
@@ -245,6 +339,12 @@ CTxnBaseDB::setReadCommitted()
 	pDB->setReadCommitted();
 }
 
+void
+CTxnBaseDB::setReadOnly()
+{
+	pDB->setReadOnly();
+}
+
 void
 CTxnBaseDB::setReadUncommitted()
 {
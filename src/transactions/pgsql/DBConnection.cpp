@@ -11,18 +11,99 @@
  * 13 June 2006
  */
 
+#include <atomic>
 #include <catalog/pg_type_d.h>
+#include <cctype>
 #include <ctime>
 #include <string>
 #include <sstream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include <spdlog/spdlog.h>
 
+#include "CaptureLog.h"
 #include "DBConnection.h"
+#include "DBResult.h"
+
+static const char *szPipelineFrame[PIPELINE_FRAMES] = { "market_feed_1",
+	"trade_cleanup_1", "trade_result_5", "trade_result_6", "trade_update_2" };
+static std::atomic<long long> llPipelineStatements[PIPELINE_FRAMES];
+static std::atomic<long long> llPipelineRoundTrips[PIPELINE_FRAMES];
+
+// The plan cache mode of each ePlanCache but PLAN_CACHE_OFF.
+static const char *szPlanCacheMode[PLAN_CACHE_OFF] = { "RESET plan_cache_mode",
+	"SET plan_cache_mode = force_generic_plan",
+	"SET plan_cache_mode = force_custom_plan" };
+
+// Whether the transaction was aborted by a serialization failure or a
+// deadlock.
+static bool
+retryable(const PGresult *res)
+{
+	const char *sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+	return sqlstate != NULL
+			&& (strcmp(sqlstate, "40001") == 0
+					|| strcmp(sqlstate, "40P01") == 0);
+}
+
+// Append a number to a binary capture record.
+template <typename T>
+static void
+appendBytes(string &record, T value)
+{
+	record.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Append a value to a binary capture record, NULL when length is -1.
+static void
+appendValue(string &record, const char *value, INT32 length)
+{
+	appendBytes(record, length);
+	if (length > 0)
+		record.append(value, length);
+}
+
+// Key of a statement text: its length and FNV-1a hash, in one pass over it.
+static size_t
+textKey(const char *sql)
+{
+	size_t hash = 2166136261u;
+	const char *p = sql;
+	for (; *p != '\0'; p++)
+		hash = (hash ^ (unsigned char) *p) * 16777619u;
+	return hash ^ ((size_t) (p - sql) << 20);
+}
+
+static INT64
+captureClockUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (INT64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Run a command of the session, whose failure is only worth a warning.
+static void
+setting(PGconn *conn, const char *sql)
+{
+	PGresult *res = PQexec(conn, sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		cerr << "WARNING: " << sql << ": " << PQresultErrorMessage(res);
+	PQclear(res);
+}
 
 // Constructor: Creates PgSQL connection
 CDBConnection::CDBConnection(const char *szHost, const char *szDBName,
 		const char *szDBPort, bool bVerbose)
-: m_bVerbose(bVerbose)
+: bh(NULL), m_pServerTimes(NULL), m_pWait(NULL), m_bBegin(false),
+  m_szBeginName(NULL), m_szIsolation(NULL), m_bReadOnly(false),
+  m_bCommitWithNext(false), m_pCommitResult(NULL), m_bPipeline(false),
+  m_ePipelineFrame(PIPELINE_MF1), m_ePlanCache(PLAN_CACHE_OFF),
+  m_eCapture(CAPTURE_OFF), m_pCaptureRates(NULL), m_bCapture(false),
+  m_iCaptureSeed(0), m_pCaptureLog(NULL), m_llCaptureSequence(0),
+  m_bVerbose(bVerbose), m_iResultFormat(0)
 {
 	szConnectStr[0] = '\0';
 
@@ -49,38 +130,108 @@ CDBConnection::CDBConnection(const char *szHost, const char *szDBName,
 // Destructor: Disconnect from server
 CDBConnection::~CDBConnection()
 {
+	clearResults();
+	PQclear(m_pCommitResult);
 	PQfinish(m_Conn);
 }
 
+// The BEGIN is held back until the first statement, to go with it.
 void
 #if TEMPLATE
 CDBConnection::begin(const char *macroName)
 {
-	PGresult *res = PQexec(m_Conn, "BEGIN;");
-	spdlog::info("[timestamp={}][connId={}][sql=BEGIN][name={}]", static_cast<time_t>(time(0)), PQbackendPID(m_Conn), macroName);
+	m_szBeginName = macroName;
 #else
 CDBConnection::begin()
 {
-	PGresult *res = PQexec(m_Conn, "BEGIN;");
-	spdlog::info("[timestamp={}][connId={}][sql=BEGIN]", static_cast<time_t>(time(0)), PQbackendPID(m_Conn));
 #endif
-	PQclear(res);
+	PQclear(m_pCommitResult);
+	m_pCommitResult = NULL;
+	m_bBegin = true;
+	m_szIsolation = NULL;
+	m_bReadOnly = false;
+	m_bCommitWithNext = false;
+}
+
+string
+CDBConnection::beginCommand()
+{
+	string command = "BEGIN";
+	if (m_szIsolation != NULL) {
+		command += " ISOLATION LEVEL ";
+		command += m_szIsolation;
+	}
+	if (m_bReadOnly)
+		command += " READ ONLY";
+	return command;
+}
+
+void
+CDBConnection::logBegin(const string &command)
+{
+#if TEMPLATE
+	captureCommand(command.c_str(), m_szBeginName);
+#else
+	captureCommand(command.c_str(), NULL);
+#endif
 }
 
 void
 CDBConnection::connect()
 {
 	m_Conn = PQconnectdb(szConnectStr);
+	prepareStatements();
+	if (m_pWait != NULL)
+		PQsetnonblocking(m_Conn, 1);
+}
+
+// Prepare each statement of list on connecting.
+void
+CDBConnection::addStatements(const TPreparedStatement *list)
+{
+	for (; list->name != NULL; list++) {
+		m_Statements.push_back(list);
+		m_StatementIds[list->sql] = m_StatementStats.id(list->name);
+	}
 }
 
 void
 CDBConnection::commit()
 {
-	PGresult *res = PQexec(m_Conn, "COMMIT;");
-	spdlog::info("[timestamp={}][connId={}][sql=COMMIT]", static_cast<time_t>(time(0)), PQbackendPID(m_Conn));
+	PGresult *res = m_pCommitResult;
+	m_pCommitResult = NULL;
+	m_bCommitWithNext = false;
+	if (res == NULL) {
+		// Nothing to commit if no statement was run.
+		if (m_bBegin) {
+			m_bBegin = false;
+			return;
+		}
+		INT64 llStart = serverClockNs();
+		res = query("COMMIT;");
+		countStatement(m_StatementStats.id("COMMIT"),
+				serverClockNs() - llStart, res);
+	}
+	captureCommand("COMMIT", NULL);
+
+	// A serializable transaction may also fail here.
+	if (PQresultStatus(res) == PGRES_FATAL_ERROR && retryable(res)) {
+		ostringstream msg;
+		msg << syscall(SYS_gettid) << " " << time(NULL) << " " << endl
+			<< "SQL: COMMIT" << endl
+			<< PQresultErrorMessage(res) << endl;
+		PQclear(res);
+		throw CDBRetryErr(msg.str());
+	}
 	PQclear(res);
 }
 
+void
+CDBConnection::commitWithFrame()
+{
+	m_bCommitWithNext = framesAreOneStatement();
+}
+
 char *
 CDBConnection::escape(string s)
 {
@@ -102,60 +253,72 @@ CDBConnection::exec(const char *sql)
 	return exec(sql, 0, NULL, NULL, NULL, NULL, 0);
 }
 
-string binary_to_int(const char* data, int length) {
-    ostringstream oss;
-	if (length == 1) {	// INT1
-		int8_t val;
-		memcpy(&val, data, sizeof(int8_t));
-		oss << static_cast<int16_t>(val);
-		return oss.str();
-	}
-    else if (length == 2) { // INT2
-        int16_t val;
-        memcpy(&val, data, sizeof(int16_t));
-        val = ntohs(val); // 转换为主机字节序
-        oss << val;
-    }
-    else if (length == 4) { // INT4
-        int32_t val;
-        memcpy(&val, data, sizeof(int32_t));
-        val = ntohl(val); // 转换为主机字节序
-        oss << val;
-    }
-    else if (length == 8) { // INT8
-        uint64_t val;
-        memcpy(&val, data, sizeof(uint64_t));
-        // 手动处理大端到主机字节序（假设主机是小端）
-        uint32_t high = ntohl(static_cast<uint32_t>(val >> 32));
-        uint32_t low = ntohl(static_cast<uint32_t>(val & 0xFFFFFFFF));
-        val = (static_cast<uint64_t>(low) << 32) | high;
-        oss << val;
-    }
-    else {
-        oss << "Unknown int length: " << length;
-    }
-    return oss.str();
-}
-
 PGresult *
 CDBConnection::exec(const char *sql, int nParams, const Oid *paramTypes,
 		const char *const *paramValues, const int *paramLengths,
 		const int *paramFormats, int resultFormat)
 {
-	// FIXME: Handle serialization errors.
-	// For PostgreSQL, see comment in the Concurrency Control chapter, under
-	// the Transaction Isolation section for dealing with serialization
-	// failures.  These serialization failures can occur with REPEATABLE READS
-	// or SERIALIZABLE.
+	string params = paramString(
+			nParams, paramTypes, paramValues, paramLengths, paramFormats);
+	INT64 llStart = capturing(CAPTURE_STATEMENTS) ? captureClockUs() : 0;
+	INT64 llSent = serverClockNs();
+	PGresult *res = query(sql, nParams, paramTypes, paramValues,
+			paramLengths, paramFormats, resultFormat);
+	countStatement(statementId(sql), serverClockNs() - llSent, res);
+	return check(sql, params, llStart, res);
+}
+
+// Log the parameters as the capture expects them, with the values of
+// replace_map instead of the binary ones it was given for.  Empty unless
+// they are captured.  For the binary capture, the parameters of an exec
+// record.
+string
+CDBConnection::paramString(int nParams, const Oid *paramTypes,
+		const char *const *paramValues, const int *paramLengths,
+		const int *paramFormats)
+{
+	if (!capturing(CAPTURE_PARAMS)) {
+		replace_map.clear();
+		return string();
+	}
+
+	if (m_pCaptureLog != NULL) {
+		string record;
+		appendBytes(record, (UINT16) nParams);
+		for (int i = 0; i < nParams; i++) {
+			std::map<int, string>::const_iterator it = replace_map.find(i);
+			if (it != replace_map.end()) {
+				appendBytes(record, (uint8_t) CAPTURE_PARAM_REPLACED);
+				appendBytes(record, (UINT32) 0);
+				appendValue(record, it->second.data(), it->second.size());
+			} else if (paramFormats != NULL && paramFormats[i] == 1) {
+				appendBytes(record, (uint8_t) CAPTURE_PARAM_BINARY);
+				appendBytes(record,
+						(UINT32) (paramTypes != NULL ? paramTypes[i] : 0));
+				appendValue(record, paramValues[i], paramLengths[i]);
+			} else {
+				appendBytes(record, (uint8_t) CAPTURE_PARAM_TEXT);
+				appendBytes(record,
+						(UINT32) (paramTypes != NULL ? paramTypes[i] : 0));
+				appendValue(record, paramValues[i],
+						paramValues[i] != NULL ? strlen(paramValues[i]) : 0);
+			}
+		}
+		replace_map.clear();
+		return record;
+	}
 
-	int connId = PQbackendPID(m_Conn);
 	ostringstream paramStream;
 	if (nParams > 0) {
 		paramStream << "[para=";
 		for (int i = 0; i < nParams; i++) {
 			if (paramValues[i] != nullptr) { // 判断 paramValue, 处理空字符串
 				if (replace_map.find(i) != replace_map.end()) {
-					paramStream << replace_map[i];
+					// Arrays are quoted for their commas.
+					if (replace_map[i].find(',') != string::npos)
+						paramStream << "'" << replace_map[i] << "'";
+					else
+						paramStream << replace_map[i];
 				} else {
 					if (paramFormats[i] == 1) { // 判断 paramFormat, 处理变长字节变量
 						paramStream << binary_to_int(paramValues[i], paramLengths[i]);
@@ -172,40 +335,217 @@ CDBConnection::exec(const char *sql, int nParams, const Oid *paramTypes,
 		paramStream << "]";
 	}
 	replace_map.clear();
+	return paramStream.str();
+}
 
-	time_t now = time(0);
-	PGresult *res = PQexecParams(m_Conn, sql, nParams, paramTypes, paramValues,
-			paramLengths, paramFormats, resultFormat);
+// Name of the statement prepared for sql, NULL to send the text.
+const char *
+CDBConnection::preparedName(const char *sql)
+{
+	if (m_PreparedText.empty())
+		return NULL;
+
+	std::unordered_map<const char *, const char *>::const_iterator it
+			= m_PreparedSql.find(sql);
+	if (it != m_PreparedSql.end())
+		return it->second;
+	// The same text elsewhere, if the compiler kept several copies of it.
+	// Text built by a frame is never prepared, nor kept by its address, so
+	// a miss costs one pass over the text and no copy of it.
+	typedef std::unordered_multimap<size_t,
+			const TPreparedStatement *>::const_iterator text_iterator;
+	std::pair<text_iterator, text_iterator> range
+			= m_PreparedText.equal_range(textKey(sql));
+	for (text_iterator text = range.first; text != range.second; ++text)
+		if (strcmp(text->second->sql, sql) == 0)
+			return text->second->name;
+	return NULL;
+}
+
+// Prepare the statements added and plan them once, so that the first
+// transactions do not have to, then switch to the plan cache mode asked
+// for.  A statement that cannot be prepared is still sent as text.
+void
+CDBConnection::prepareStatements()
+{
+	m_PreparedSql.clear();
+	m_PreparedText.clear();
+	if (m_ePlanCache == PLAN_CACHE_OFF || PQstatus(m_Conn) != CONNECTION_OK)
+		return;
+
+	for (size_t i = 0; i < m_Statements.size(); i++) {
+		const TPreparedStatement *pStatement = m_Statements[i];
+		PGresult *res = PQprepare(m_Conn, pStatement->name, pStatement->sql,
+				pStatement->nParams, pStatement->paramTypes);
+		if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+			m_PreparedSql[pStatement->sql] = pStatement->name;
+			m_PreparedText.insert(std::make_pair(
+					textKey(pStatement->sql), pStatement));
+		} else {
+			cerr << "WARNING: cannot prepare " << pStatement->name << ": "
+				 << PQresultErrorMessage(res);
+		}
+		PQclear(res);
+	}
+	if (!m_Statements.empty())
+		warmUp();
+
+	// Also applies to the statements of the stored functions.
+	setting(m_Conn, szPlanCacheMode[m_ePlanCache]);
+}
+
+// Log a statement sent at llStart with its result.
+void
+CDBConnection::capture(const char *sql, const string &params, INT64 llStart,
+		PGresult *res)
+{
+	if (m_pCaptureLog != NULL) {
+		captureRecord(sql, params, llStart, res);
+		return;
+	}
+
+	int connId = PQbackendPID(m_Conn);
 	ExecStatusType status = PQresultStatus(res);
+	time_t now = llStart / 1000000;
 
 	string sqlStr(sql);
 	replace(sqlStr.begin(), sqlStr.end(), '\n', ' ');
 
+	if (!capturing(CAPTURE_RESULTS)
+			|| (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK)) {
+		spdlog::info("[timestamp={}][connId={}][sql={}]{}", now, connId,
+				sqlStr, params);
+		return;
+	}
+	if (status == PGRES_COMMAND_OK) {
+		spdlog::info("[timestamp={}][connId={}][sql={}]{}[res={}]", now,
+				connId, sqlStr, params, PQcmdTuples(res));
+		return;
+	}
+
 	const int nRows = PQntuples(res);
 	const int nFields = PQnfields(res);
 
 	ostringstream resStream;
+	for (int i = 0; i < nRows; i++) {
+		resStream << "[res=";
+		for (int j = 0; j < nFields; j++) {
+			writeValue(resStream, res, i, j);
+			if (j < nFields - 1) resStream << ",";
+		}
+		resStream << "]";
+	}
+	spdlog::info("[timestamp={}][connId={}][sql={}]{}{}", now, connId,
+			sqlStr, params, resStream.str());
+}
 
-	switch (status) {
-	case PGRES_COMMAND_OK:
-		spdlog::info("[timestamp={}][connId={}][sql={}]{}[res={}]", now, connId, sqlStr, paramStream.str(), PQcmdTuples(res));
-		return res;
-	case PGRES_TUPLES_OK:
+// Log transaction control, with the name of the transaction if given.
+void
+CDBConnection::captureCommand(const char *command, const char *name)
+{
+	if (!capturing(CAPTURE_STATEMENTS))
+		return;
+
+	if (m_pCaptureLog == NULL) {
+		if (name != NULL)
+			spdlog::info("[timestamp={}][connId={}][sql={}][name={}]",
+					time(0), PQbackendPID(m_Conn), command, name);
+		else
+			spdlog::info("[timestamp={}][connId={}][sql={}]", time(0),
+					PQbackendPID(m_Conn), command);
+		return;
+	}
+
+	m_CaptureRecord.assign(sizeof(TCaptureRecord), '\0');
+	m_CaptureRecord.append(command, strlen(command) + 1);
+	if (name != NULL)
+		m_CaptureRecord.append(name);
+	m_CaptureRecord.push_back('\0');
+
+	TCaptureRecord header;
+	memset(&header, 0, sizeof(header));
+	header.iLength = m_CaptureRecord.size();
+	header.iKind = CAPTURE_RECORD_COMMAND;
+	header.iPid = PQbackendPID(m_Conn);
+	header.llSequence = ++m_llCaptureSequence;
+	header.llStart = captureClockUs();
+	memcpy(&m_CaptureRecord[0], &header, sizeof(header));
+	m_pCaptureLog->push(m_CaptureRecord.data(), m_CaptureRecord.size());
+}
+
+// Queue an exec record of the statement, by its identifier if it has one.
+void
+CDBConnection::captureRecord(const char *sql, const string &params,
+		INT64 llStart, PGresult *res)
+{
+	TCaptureRecord header;
+	memset(&header, 0, sizeof(header));
+	header.iKind = CAPTURE_RECORD_EXEC;
+	header.iPid = PQbackendPID(m_Conn);
+	header.llSequence = ++m_llCaptureSequence;
+	header.llStart = llStart;
+	header.llDuration = captureClockUs() - llStart;
+
+	m_CaptureRecord.assign(sizeof(TCaptureRecord), '\0');
+	std::unordered_map<const char *, UINT32>::const_iterator it
+			= m_CaptureIds.find(sql);
+	if (it != m_CaptureIds.end())
+		header.iStatement = it->second;
+	else
+		m_CaptureRecord.append(sql, strlen(sql) + 1);
+
+	if (params.empty())
+		appendBytes(m_CaptureRecord, (UINT16) 0);
+	else
+		m_CaptureRecord.append(params);
+
+	ExecStatusType status = PQresultStatus(res);
+	if (!capturing(CAPTURE_RESULTS)
+			|| (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK)) {
+		appendBytes(m_CaptureRecord, (uint8_t) CAPTURE_RESULT_NONE);
+	} else if (status == PGRES_COMMAND_OK) {
+		appendBytes(m_CaptureRecord, (uint8_t) CAPTURE_RESULT_COMMAND);
+		const char *tuples = PQcmdTuples(res);
+		appendValue(m_CaptureRecord, tuples, strlen(tuples));
+	} else {
+		const int nRows = PQntuples(res);
+		const int nFields = PQnfields(res);
+		appendBytes(m_CaptureRecord, (uint8_t) CAPTURE_RESULT_TUPLES);
+		appendBytes(m_CaptureRecord, (UINT32) nRows);
+		appendBytes(m_CaptureRecord, (UINT16) nFields);
+		for (int j = 0; j < nFields; j++) {
+			appendBytes(m_CaptureRecord, (UINT32) PQftype(res, j));
+			appendBytes(m_CaptureRecord, (uint8_t) PQfformat(res, j));
+		}
 		for (int i = 0; i < nRows; i++) {
-			resStream << "[res=";
 			for (int j = 0; j < nFields; j++) {
-				resStream << PQgetvalue(res, i, j);
-				if (j < nFields - 1) resStream << ",";
+				if (PQgetisnull(res, i, j))
+					appendValue(m_CaptureRecord, NULL, -1);
+				else
+					appendValue(m_CaptureRecord, PQgetvalue(res, i, j),
+							PQgetlength(res, i, j));
 			}
-			resStream << "]";
 		}
-		spdlog::info("[timestamp={}][connId={}][sql={}]{}{}", now, connId, sqlStr, paramStream.str(), resStream.str());
-		return res;
-	default:
-		spdlog::info("[timestamp={}][connId={}][sql={}]{}", now, connId, sqlStr, paramStream.str());
-		break;
 	}
 
+	header.iLength = m_CaptureRecord.size();
+	memcpy(&m_CaptureRecord[0], &header, sizeof(header));
+	m_pCaptureLog->push(m_CaptureRecord.data(), m_CaptureRecord.size());
+}
+
+// Capture the result of a statement sent at llStart, and roll back on an
+// error.
+PGresult *
+CDBConnection::check(const char *sql, const string &params, INT64 llStart,
+		PGresult *res)
+{
+	if (capturing(CAPTURE_STATEMENTS))
+		capture(sql, params, llStart, res);
+
+	ExecStatusType status = PQresultStatus(res);
+	if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK)
+		return res;
+
 	pid_t pid = syscall(SYS_gettid);
 	ostringstream msg;
 	switch (status) {
@@ -214,6 +554,10 @@ CDBConnection::exec(const char *sql, int nParams, const Oid *paramTypes,
 			<< "SQL: " << sql << endl
 			<< PQresultErrorMessage(res) << endl;
 		rollback();
+		// Serialization failures, with REPEATABLE READ or SERIALIZABLE, and
+		// deadlocks are worth running the transaction again.
+		if (retryable(res))
+			throw CDBRetryErr(msg.str());
 		throw msg.str();
 		break;
 	case PGRES_EMPTY_QUERY:
@@ -233,19 +577,47 @@ void
 CDBConnection::execute(const TMarketFeedFrame1Input *pIn,
 		TMarketFeedFrame1Output *pOut, CSendToMarketInterface *pMarketExchange)
 {
-	PGresult *res;
-	PGresult *res2;
-
 	pOut->num_updated = 0;
 	pOut->send_len = 0;
 
+	// Each entry is a transaction of its own, run again by itself when
+	// PostgreSQL aborts it for a conflict.
 	for (int i = 0; i < 20; i++) {
+		INT32 num_updated = pOut->num_updated;
+		for (int iRetry = 0;; iRetry++) {
+			INT64 llStart = serverClockNs();
+			try {
+				executeMarketFeedEntry(pIn, i, pOut, pMarketExchange);
+				break;
+			} catch (CDBRetryErr const &) {
+				// Without a Brokerage House, as in TestTxn, there is no retry
+				// policy to follow.
+				pOut->num_updated = num_updated;
+				if (bh == NULL
+						|| !bh->retryTransaction(
+								this, MARKET_FEED, iRetry, llStart))
+					throw;
+			}
+		}
+	}
+}
+
+// Update the price of entry i of the ticker, and send the limit orders it
+// triggers to the Market Exchange Emulator.
+void
+CDBConnection::executeMarketFeedEntry(const TMarketFeedFrame1Input *pIn,
+		int i, TMarketFeedFrame1Output *pOut,
+		CSendToMarketInterface *pMarketExchange)
+{
+	PGresult *res;
+	PGresult *res2;
+
 #if TEMPLATE
-		begin("MF");
+	begin("MF");
 #else
-		begin();
+	begin();
 #endif
-		setRepeatableRead();
+	setRepeatableRead();
 
 #define MFF1Q1                                                                \
 	"UPDATE last_trade\n"                                                     \
@@ -254,28 +626,29 @@ CDBConnection::execute(const TMarketFeedFrame1Input *pIn,
 	"  , lt_dts = CURRENT_TIMESTAMP\n"                                        \
 	"WHERE lt_s_symb = $3"
 
-		char price_quote[14];
-		snprintf(price_quote, 13, "%f", pIn->Entries[i].price_quote);
-		uint32_t trade_qty = htobe32((uint32_t) pIn->Entries[i].trade_qty);
+	char price_quote[14];
+	snprintf(price_quote, 13, "%f", pIn->Entries[i].price_quote);
+	uint32_t trade_qty = htobe32((uint32_t) pIn->Entries[i].trade_qty);
 
-		if (m_bVerbose) {
-			cout << MFF1Q1 << endl;
-			cout << "$1 = " << price_quote << endl;
-			cout << "$2 = " << be32toh(trade_qty) << endl;
-			cout << "$3 = " << pIn->Entries[i].symbol << endl;
-		}
+	if (m_bVerbose) {
+		cout << MFF1Q1 << endl;
+		cout << "$1 = " << price_quote << endl;
+		cout << "$2 = " << be32toh(trade_qty) << endl;
+		cout << "$3 = " << pIn->Entries[i].symbol << endl;
+	}
 
-		const Oid paramTypes1[3] = { NUMERICOID, INT4OID, TEXTOID };
-		const char *paramValues1[3]
-				= { price_quote, (char *) &trade_qty, pIn->Entries[i].symbol };
-		const int paramLengths1[3] = { sizeof(char) * 14, sizeof(uint32_t),
-			sizeof(char) * (cSYMBOL_len + 1) };
-		const int paramFormats1[3] = { 0, 1, 0 };
+	const Oid paramTypes1[3] = { NUMERICOID, INT4OID, TEXTOID };
+	const char *paramValues1[3]
+			= { price_quote, (char *) &trade_qty, pIn->Entries[i].symbol };
+	const int paramLengths1[3] = { sizeof(char) * 14, sizeof(uint32_t),
+		sizeof(char) * (cSYMBOL_len + 1) };
+	const int paramFormats1[3] = { 0, 1, 0 };
 
-		res = exec(MFF1Q1, 3, paramTypes1, paramValues1, paramLengths1,
-				paramFormats1, 0);
-		pOut->num_updated += atoi(PQcmdTuples(res));
-		PQclear(res);
+	// The update and the select of the entry go together, then the
+	// changes to all the trades triggered.
+	pipeline(PIPELINE_MF1);
+	send(MFF1Q1, 3, paramTypes1, paramValues1, paramLengths1,
+			paramFormats1, 0);
 
 #define MFF1Q2                                                                \
 	"SELECT tr_t_id\n"                                                        \
@@ -290,35 +663,39 @@ CDBConnection::execute(const TMarketFeedFrame1Input *pIn,
 	"        OR (tr_tt_id = $5 AND tr_bid_price >= $3)\n"                     \
 	"      )"
 
-		const char *paramValues2[5] = { pIn->Entries[i].symbol,
-			pIn->StatusAndTradeType.type_stop_loss, price_quote,
-			pIn->StatusAndTradeType.type_limit_sell,
-			pIn->StatusAndTradeType.type_limit_buy };
-		const int paramLengths2[5] = { sizeof(char) * (cSYMBOL_len + 1),
-			sizeof(char) * (cTT_ID_len + 1), sizeof(char) * 14,
-			sizeof(char) * (cTT_ID_len + 1), sizeof(char) * (cTT_ID_len + 1) };
-		const int paramFormats2[5] = { 0, 0, 0, 0, 0 };
+	const char *paramValues2[5] = { pIn->Entries[i].symbol,
+		pIn->StatusAndTradeType.type_stop_loss, price_quote,
+		pIn->StatusAndTradeType.type_limit_sell,
+		pIn->StatusAndTradeType.type_limit_buy };
+	const int paramLengths2[5] = { sizeof(char) * (cSYMBOL_len + 1),
+		sizeof(char) * (cTT_ID_len + 1), sizeof(char) * 14,
+		sizeof(char) * (cTT_ID_len + 1), sizeof(char) * (cTT_ID_len + 1) };
+	const int paramFormats2[5] = { 0, 0, 0, 0, 0 };
 
-		if (m_bVerbose) {
-			cout << MFF1Q2 << endl;
-			cout << "$1 = " << pIn->Entries[i].symbol << endl;
-			cout << "$2 = " << pIn->StatusAndTradeType.type_stop_loss << endl;
-			cout << "$3 = " << price_quote << endl;
-			cout << "$4 = " << pIn->StatusAndTradeType.type_limit_sell << endl;
-			cout << "$5 = " << pIn->StatusAndTradeType.type_limit_buy << endl;
-		}
+	if (m_bVerbose) {
+		cout << MFF1Q2 << endl;
+		cout << "$1 = " << pIn->Entries[i].symbol << endl;
+		cout << "$2 = " << pIn->StatusAndTradeType.type_stop_loss << endl;
+		cout << "$3 = " << price_quote << endl;
+		cout << "$4 = " << pIn->StatusAndTradeType.type_limit_sell << endl;
+		cout << "$5 = " << pIn->StatusAndTradeType.type_limit_buy << endl;
+	}
 
-		res = exec(MFF1Q2, 5, NULL, paramValues2, paramLengths2, paramFormats2,
-				0);
+	send(MFF1Q2, 5, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 
-		int count = PQntuples(res);
-		for (int j = 0; j < count; j++) {
-			uint64_t trade_id
-					= htobe64((uint64_t) atoll(PQgetvalue(res, j, 0)));
+	res = receive();
+	pOut->num_updated += atoi(PQcmdTuples(res));
+	PQclear(res);
+	res = receive();
 
-			if (m_bVerbose) {
-				cout << "t_id[" << j << "] = " << be64toh(trade_id);
-			}
+	int count = PQntuples(res);
+	for (int j = 0; j < count; j++) {
+		uint64_t trade_id = htobe64((uint64_t) getInt64(res, j, 0));
+
+		if (m_bVerbose) {
+			cout << "t_id[" << j << "] = " << be64toh(trade_id);
+		}
 
 #define MFF1Q3                                                                \
 	"UPDATE trade\n"                                                          \
@@ -326,42 +703,40 @@ CDBConnection::execute(const TMarketFeedFrame1Input *pIn,
 	"  , t_st_id = $1\n"                                                      \
 	"WHERE t_id = $2"
 
-			if (m_bVerbose) {
-				cout << MFF1Q3 << endl;
-				cout << "$1 = " << pIn->StatusAndTradeType.status_submitted
-					 << endl;
-				cout << "$2 = " << be64toh(trade_id) << endl;
-			}
+		if (m_bVerbose) {
+			cout << MFF1Q3 << endl;
+			cout << "$1 = " << pIn->StatusAndTradeType.status_submitted
+				 << endl;
+			cout << "$2 = " << be64toh(trade_id) << endl;
+		}
 
-			const char *paramValues3[2]
-					= { pIn->StatusAndTradeType.status_submitted,
-						  (char *) &trade_id };
-			const int paramLengths3[2]
-					= { sizeof(char) * (cST_ID_len + 1), sizeof(uint64_t) };
-			const int paramFormats3[2] = { 0, 1 };
+		const char *paramValues3[2]
+				= { pIn->StatusAndTradeType.status_submitted,
+					  (char *) &trade_id };
+		const int paramLengths3[2]
+				= { sizeof(char) * (cST_ID_len + 1), sizeof(uint64_t) };
+		const int paramFormats3[2] = { 0, 1 };
 
-			res2 = exec(MFF1Q3, 2, NULL, paramValues3, paramLengths3,
-					paramFormats3, 0);
-			PQclear(res2);
+		send(MFF1Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3,
+				0);
 
 #define MFF1Q4                                                                \
 	"DELETE FROM trade_request\n"                                             \
 	"WHERE tr_t_id = $1"
 
-			if (m_bVerbose) {
-				cout << MFF1Q4 << endl;
-				cout << "$1 = " << be64toh(trade_id) << endl;
-			}
+		if (m_bVerbose) {
+			cout << MFF1Q4 << endl;
+			cout << "$1 = " << be64toh(trade_id) << endl;
+		}
 
-			const char *paramValues4[2] = { (char *) &trade_id,
-				pIn->StatusAndTradeType.status_submitted };
-			const int paramLengths4[2]
-					= { sizeof(uint64_t), sizeof(char) * (cST_ID_len + 1) };
-			const int paramFormats4[2] = { 1, 0 };
+		const char *paramValues4[2] = { (char *) &trade_id,
+			pIn->StatusAndTradeType.status_submitted };
+		const int paramLengths4[2]
+				= { sizeof(uint64_t), sizeof(char) * (cST_ID_len + 1) };
+		const int paramFormats4[2] = { 1, 0 };
 
-			res2 = exec(MFF1Q4, 1, NULL, paramValues4, paramLengths4,
-					paramFormats4, 0);
-			PQclear(res2);
+		send(MFF1Q4, 1, NULL, paramValues4, paramLengths4, paramFormats4,
+				0);
 
 #define MFF1Q5                                                                \
 	"INSERT INTO trade_history\n"                                             \
@@ -371,54 +746,62 @@ CDBConnection::execute(const TMarketFeedFrame1Input *pIn,
 	"  , $2\n"                                                                \
 	")"
 
-			if (m_bVerbose) {
-				cout << MFF1Q5 << endl;
-				cout << "$1 = " << be64toh(trade_id) << endl;
-				cout << "$2 = " << pIn->StatusAndTradeType.status_submitted
-					 << endl;
-			}
+		if (m_bVerbose) {
+			cout << MFF1Q5 << endl;
+			cout << "$1 = " << be64toh(trade_id) << endl;
+			cout << "$2 = " << pIn->StatusAndTradeType.status_submitted
+				 << endl;
+		}
 
-			res2 = exec(MFF1Q5, 2, NULL, paramValues4, paramLengths4,
-					paramFormats4, 0);
+		send(MFF1Q5, 2, NULL, paramValues4, paramLengths4, paramFormats4,
+				0);
+	}
+	// The limit orders are read once the entry is committed, an error in
+	// any statement after the select leaves them to be cleared here.
+	try {
+		for (int j = 0; j < count * 3; j++) {
+			res2 = receive();
 			PQclear(res2);
 		}
-
 		commit();
+	} catch (...) {
+		PQclear(res);
+		throw;
+	}
 
-		for (int j = 0; j < count; j++) {
-			strncpy(m_TriggeredLimitOrders.symbol, pIn->Entries[i].symbol,
-					cSYMBOL_len);
-			m_TriggeredLimitOrders.trade_id = atoll(PQgetvalue(res, j, 0));
-			m_TriggeredLimitOrders.price_quote = atof(PQgetvalue(res, j, 1));
-			strncpy(m_TriggeredLimitOrders.trade_type_id,
-					PQgetvalue(res, j, 2), cTT_ID_len);
-			m_TriggeredLimitOrders.trade_qty = atoi(PQgetvalue(res, j, 3));
-
-			if (m_bVerbose) {
-				cout << "symbol[" << j
-					 << "] = " << m_TriggeredLimitOrders.symbol;
-				cout << "trade_id[" << j
-					 << "] = " << m_TriggeredLimitOrders.trade_id;
-				cout << "price_quote[" << j
-					 << "] = " << m_TriggeredLimitOrders.price_quote;
-				cout << "trade_type_id[" << j
-					 << "] = " << m_TriggeredLimitOrders.trade_type_id;
-				cout << "trade_qty[" << j
-					 << "] = " << m_TriggeredLimitOrders.trade_qty;
-			}
+	for (int j = 0; j < count; j++) {
+		strncpy(m_TriggeredLimitOrders.symbol, pIn->Entries[i].symbol,
+				cSYMBOL_len);
+		m_TriggeredLimitOrders.trade_id = getInt64(res, j, 0);
+		m_TriggeredLimitOrders.price_quote = getDouble(res, j, 1);
+		getString(res, j, 2, m_TriggeredLimitOrders.trade_type_id,
+				cTT_ID_len);
+		m_TriggeredLimitOrders.trade_qty = getInt32(res, j, 3);
 
-			bool bSent = pMarketExchange->SendToMarketFromFrame(
-					m_TriggeredLimitOrders);
-			if (!bSent) {
-				cout << "WARNING: SendToMarketFromFrame() returned failure "
-						"but continuing..."
-					 << endl;
-			}
-			++pOut->send_len;
+		if (m_bVerbose) {
+			cout << "symbol[" << j
+				 << "] = " << m_TriggeredLimitOrders.symbol;
+			cout << "trade_id[" << j
+				 << "] = " << m_TriggeredLimitOrders.trade_id;
+			cout << "price_quote[" << j
+				 << "] = " << m_TriggeredLimitOrders.price_quote;
+			cout << "trade_type_id[" << j
+				 << "] = " << m_TriggeredLimitOrders.trade_type_id;
+			cout << "trade_qty[" << j
+				 << "] = " << m_TriggeredLimitOrders.trade_qty;
 		}
 
-		PQclear(res);
+		bool bSent = pMarketExchange->SendToMarketFromFrame(
+				m_TriggeredLimitOrders);
+		if (!bSent) {
+			cout << "WARNING: SendToMarketFromFrame() returned failure "
+					"but continuing..."
+				 << endl;
+		}
+		++pOut->send_len;
 	}
+
+	PQclear(res);
 }
 
 void
@@ -437,11 +820,12 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 
 	res = exec(TCF1Q1);
 
+	// Everything up to the select of the trades still submitted goes
+	// together, then the changes to those trades.
+	pipeline(PIPELINE_TC1);
 	int n = PQntuples(res);
 	for (int i = 0; i < n; i++) {
-		PGresult *res2 = NULL;
-
-		uint64_t tr_t_id = htobe64((uint64_t) atoll(PQgetvalue(res, i, 0)));
+		uint64_t tr_t_id = htobe64((uint64_t) getInt64(res, i, 0));
 
 #define TCF1Q2                                                                \
 	"INSERT INTO trade_history(\n"                                            \
@@ -468,9 +852,7 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 				= { sizeof(uint64_t), sizeof(char) * (cST_ID_len + 1) };
 		const int paramFormats1[2] = { 1, 0 };
 
-		res2 = exec(TCF1Q2, 2, NULL, paramValues1, paramLengths1,
-				paramFormats1, 0);
-		PQclear(res2);
+		send(TCF1Q2, 2, NULL, paramValues1, paramLengths1, paramFormats1, 0);
 
 #define TCF1Q3                                                                \
 	"UPDATE trade\n"                                                          \
@@ -490,9 +872,7 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 				= { sizeof(char) * (cST_ID_len + 1), sizeof(uint64_t) };
 		const int paramFormats2[2] = { 0, 1 };
 
-		res2 = exec(TCF1Q3, 2, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
-		PQclear(res2);
+		send(TCF1Q3, 2, NULL, paramValues2, paramLengths2, paramFormats2, 0);
 
 #define TCF1Q4                                                                \
 	"INSERT INTO trade_history(\n"                                            \
@@ -515,9 +895,7 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 
 		paramValues1[1] = pIn->st_canceled_id;
 
-		res2 = exec(TCF1Q4, 2, NULL, paramValues1, paramLengths1,
-				paramFormats1, 0);
-		PQclear(res2);
+		send(TCF1Q4, 2, NULL, paramValues1, paramLengths1, paramFormats1, 0);
 	}
 	PQclear(res);
 
@@ -526,8 +904,7 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 	if (m_bVerbose) {
 		cout << TCF1Q5 << endl;
 	}
-	res = exec(TCF1Q5);
-	PQclear(res);
+	send(TCF1Q5, 0, NULL, NULL, NULL, NULL, 0);
 
 #define TCF1Q6                                                                \
 	"SELECT t_id\n"                                                           \
@@ -549,13 +926,19 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 			= { sizeof(uint64_t), sizeof(char) * (cST_ID_len + 1) };
 	const int paramFormats[2] = { 1, 0 };
 
-	res = exec(TCF1Q6, 2, NULL, paramValues, paramLengths, paramFormats, 0);
+	send(TCF1Q6, 2, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
+
+	for (int i = 0; i < n * 3 + 1; i++) {
+		res = receive();
+		PQclear(res);
+	}
+	res = receive();
 
+	pipeline(PIPELINE_TC1);
 	n = PQntuples(res);
 	for (int i = 0; i < n; i++) {
-		PGresult *res2 = NULL;
-
-		uint64_t tr_t_id = htobe64((uint64_t) atoll(PQgetvalue(res, i, 0)));
+		uint64_t tr_t_id = htobe64((uint64_t) getInt64(res, i, 0));
 
 #define TCF1Q7                                                                \
 	"UPDATE trade\n"                                                          \
@@ -575,9 +958,7 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 				= { sizeof(char) * (cST_ID_len + 1), sizeof(uint64_t) };
 		const int paramFormats2[2] = { 0, 1 };
 
-		res2 = exec(TCF1Q3, 2, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
-		PQclear(res2);
+		send(TCF1Q3, 2, NULL, paramValues2, paramLengths2, paramFormats2, 0);
 
 #define TCF1Q8                                                                \
 	"INSERT INTO trade_history(\n"                                            \
@@ -604,14 +985,348 @@ CDBConnection::execute(const TTradeCleanupFrame1Input *pIn)
 				= { sizeof(uint64_t), sizeof(char) * (cST_ID_len + 1) };
 		const int paramFormats1[2] = { 1, 0 };
 
-		res2 = exec(TCF1Q8, 2, NULL, paramValues1, paramLengths1,
-				paramFormats1, 0);
-		PQclear(res2);
+		send(TCF1Q8, 2, NULL, paramValues1, paramLengths1, paramFormats1, 0);
 	}
 	PQclear(res);
+
+	for (int i = 0; i < n * 2; i++) {
+		res = receive();
+		PQclear(res);
+	}
 }
 
 
+// Run a statement, through the simple query protocol like PQexec.
+PGresult *
+CDBConnection::query(const char *sql)
+{
+	if (m_pWait == NULL)
+		return PQexec(m_Conn, sql);
+	if (!PQsendQuery(m_Conn, sql))
+		return PQmakeEmptyPGresult(m_Conn, PGRES_FATAL_ERROR);
+	return result();
+}
+
+PGresult *
+CDBConnection::query(const char *sql, int nParams, const Oid *paramTypes,
+		const char *const *paramValues, const int *paramLengths,
+		const int *paramFormats, int resultFormat)
+{
+	if (m_bBegin || m_bCommitWithNext)
+		return queryTransaction(sql, nParams, paramTypes, paramValues,
+				paramLengths, paramFormats, resultFormat);
+	if (m_pWait == NULL) {
+		const char *name = preparedName(sql);
+		if (name != NULL)
+			return PQexecPrepared(m_Conn, name, nParams, paramValues,
+					paramLengths, paramFormats, resultFormat);
+		return PQexecParams(m_Conn, sql, nParams, paramTypes, paramValues,
+				paramLengths, paramFormats, resultFormat);
+	}
+	if (!sendQuery(sql, nParams, paramTypes, paramValues, paramLengths,
+				paramFormats, resultFormat))
+		return PQmakeEmptyPGresult(m_Conn, PGRES_FATAL_ERROR);
+	return result();
+}
+
+// Run a statement in one round trip with the BEGIN held back before it and,
+// if asked for, COMMIT after it.  Without pipeline mode, the BEGIN goes
+// first on its own and COMMIT waits for commit().
+PGresult *
+CDBConnection::queryTransaction(const char *sql, int nParams,
+		const Oid *paramTypes, const char *const *paramValues,
+		const int *paramLengths, const int *paramFormats, int resultFormat)
+{
+	bool bBegin = m_bBegin;
+	bool bCommit = m_bCommitWithNext;
+	m_bBegin = false;
+	m_bCommitWithNext = false;
+
+	string begin = beginCommand();
+	if (bBegin)
+		logBegin(begin);
+
+#ifdef LIBPQ_HAS_PIPELINING
+	PQenterPipelineMode(m_Conn);
+	bBegin = bBegin
+			&& PQsendQueryParams(m_Conn, begin.c_str(), 0, NULL, NULL, NULL,
+					   NULL, 0)
+					== 1;
+	bool bSent = sendQuery(sql, nParams, paramTypes, paramValues,
+						 paramLengths, paramFormats, resultFormat)
+			== 1;
+	bCommit = bCommit
+			&& PQsendQueryParams(
+					   m_Conn, "COMMIT", 0, NULL, NULL, NULL, NULL, 0)
+					== 1;
+	PQpipelineSync(m_Conn);
+	flush();
+
+	PGresult *resBegin = bBegin ? pipelineResult() : NULL;
+	PGresult *res = bSent ? pipelineResult()
+						  : PQmakeEmptyPGresult(m_Conn, PGRES_FATAL_ERROR);
+	if (bCommit)
+		m_pCommitResult = pipelineResult();
+	PQclear(getResult()); // PGRES_PIPELINE_SYNC
+	PQexitPipelineMode(m_Conn);
+
+	// The statement was not run if the BEGIN failed.
+	if (resBegin != NULL && PQresultStatus(resBegin) != PGRES_COMMAND_OK) {
+		PQclear(res);
+		return resBegin;
+	}
+	PQclear(resBegin);
+	return res;
+#else
+	if (bBegin)
+		PQclear(query(begin.c_str()));
+	return query(sql, nParams, paramTypes, paramValues, paramLengths,
+			paramFormats, resultFormat);
+#endif
+}
+
+// Queue a statement without waiting, by name if it is prepared.
+int
+CDBConnection::sendQuery(const char *sql, int nParams, const Oid *paramTypes,
+		const char *const *paramValues, const int *paramLengths,
+		const int *paramFormats, int resultFormat)
+{
+	const char *name = preparedName(sql);
+	if (name != NULL)
+		return PQsendQueryPrepared(m_Conn, name, nParams, paramValues,
+				paramLengths, paramFormats, resultFormat);
+	return PQsendQueryParams(m_Conn, sql, nParams, paramTypes, paramValues,
+			paramLengths, paramFormats, resultFormat);
+}
+
+// Finish sending the statement just queued and collect its results.  Like
+// PQexec, return the last result.
+PGresult *
+CDBConnection::result()
+{
+	if (!flush())
+		return PQmakeEmptyPGresult(m_Conn, PGRES_FATAL_ERROR);
+
+	PGresult *res = NULL;
+	PGresult *next;
+	while ((next = getResult()) != NULL) {
+		PQclear(res);
+		res = next;
+	}
+	return res;
+}
+
+// Results of the next statement of the pipeline, the last one like PQexec.
+PGresult *
+CDBConnection::pipelineResult()
+{
+	PGresult *res = NULL;
+	PGresult *next;
+	while ((next = getResult()) != NULL) {
+		PQclear(res);
+		res = next;
+	}
+	if (res == NULL)
+		res = PQmakeEmptyPGresult(m_Conn, PGRES_FATAL_ERROR);
+	return res;
+}
+
+// Send what libpq still holds, waiting for room in the socket.
+bool
+CDBConnection::flush()
+{
+	int flushed;
+	while ((flushed = PQflush(m_Conn)) == 1)
+		m_pWait->wait(PQsocket(m_Conn), true);
+	return flushed == 0;
+}
+
+// Next result, waiting for it through m_pWait if set.  A broken connection
+// is reported by PQgetResult().
+PGresult *
+CDBConnection::getResult()
+{
+	if (m_pWait != NULL) {
+		while (PQisBusy(m_Conn)) {
+			m_pWait->wait(PQsocket(m_Conn), false);
+			if (!PQconsumeInput(m_Conn))
+				break;
+		}
+	}
+	return PQgetResult(m_Conn);
+}
+
+// Count a statement that took llNs nanoseconds to return res.
+void
+CDBConnection::countStatement(UINT32 id, INT64 llNs, PGresult *res)
+{
+	switch (PQresultStatus(res)) {
+	case PGRES_TUPLES_OK:
+		m_StatementStats.record(id, llNs, PQntuples(res), false);
+		break;
+	case PGRES_COMMAND_OK:
+		m_StatementStats.record(id, llNs, atoll(PQcmdTuples(res)), false);
+		break;
+	default:
+		m_StatementStats.record(id, llNs, 0, true);
+		break;
+	}
+}
+
+void
+CDBConnection::clearResults()
+{
+	while (!m_Results.empty()) {
+		PQclear(m_Results.front());
+		m_Results.pop_front();
+	}
+}
+
+// Start sending the statements of eFrame that do not depend on each other.
+void
+CDBConnection::pipeline(ePipelineFrame eFrame)
+{
+	m_ePipelineFrame = eFrame;
+}
+
+void
+CDBConnection::send(const char *sql, int nParams, const Oid *paramTypes,
+		const char *const *paramValues, const int *paramLengths,
+		const int *paramFormats, int resultFormat)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (m_bPipeline) {
+		if (PQpipelineStatus(m_Conn) == PQ_PIPELINE_OFF)
+			PQenterPipelineMode(m_Conn);
+
+		TPipelined Statement;
+		if (m_bBegin) {
+			m_bBegin = false;
+			string begin = beginCommand();
+			logBegin(begin);
+			Statement.sql = "BEGIN";
+			Statement.llStart
+					= capturing(CAPTURE_STATEMENTS) ? captureClockUs() : 0;
+			Statement.llSent = serverClockNs();
+			Statement.bSent = PQsendQueryParams(m_Conn, begin.c_str(), 0,
+									  NULL, NULL, NULL, NULL, 0)
+					== 1;
+			Statement.bBegin = true;
+			m_Pipelined.push_back(Statement);
+		}
+
+		Statement.sql = sql;
+		Statement.params = paramString(nParams, paramTypes, paramValues,
+				paramLengths, paramFormats);
+		Statement.llStart
+				= capturing(CAPTURE_STATEMENTS) ? captureClockUs() : 0;
+		Statement.llSent = serverClockNs();
+		Statement.bSent = sendQuery(sql, nParams, paramTypes, paramValues,
+								  paramLengths, paramFormats, resultFormat)
+				== 1;
+		Statement.bBegin = false;
+		m_Pipelined.push_back(Statement);
+		return;
+	}
+#endif
+
+	PGresult *res;
+	try {
+		res = exec(sql, nParams, paramTypes, paramValues, paramLengths,
+				paramFormats, resultFormat);
+	} catch (std::string const &) {
+		clearResults();
+		throw;
+	}
+	m_Results.push_back(res);
+}
+
+// Result of the oldest statement sent, the caller clears it.
+PGresult *
+CDBConnection::receive()
+{
+	if (!m_Pipelined.empty())
+		syncPipeline();
+	PGresult *res = m_Results.front();
+	m_Results.pop_front();
+	return res;
+}
+
+// End the pipeline and take the results of all its statements, then check
+// them in order as if each had been run alone.
+void
+CDBConnection::syncPipeline()
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	std::vector<PGresult *> results;
+	PQpipelineSync(m_Conn);
+	flush();
+	// Each statement takes from its sending to the arrival of its results,
+	// the ones before it in the pipeline included.
+	for (size_t i = 0; i < m_Pipelined.size(); i++) {
+		results.push_back(m_Pipelined[i].bSent
+						? pipelineResult()
+						: PQmakeEmptyPGresult(m_Conn, PGRES_FATAL_ERROR));
+		if (!m_Pipelined[i].bBegin) {
+			countStatement(statementId(m_Pipelined[i].sql),
+					serverClockNs() - m_Pipelined[i].llSent, results[i]);
+		}
+	}
+	PQclear(getResult()); // PGRES_PIPELINE_SYNC
+	PQexitPipelineMode(m_Conn);
+
+	llPipelineStatements[m_ePipelineFrame] += m_Pipelined.size();
+	++llPipelineRoundTrips[m_ePipelineFrame];
+
+	std::vector<TPipelined> pipelined;
+	pipelined.swap(m_Pipelined);
+	for (size_t i = 0; i < pipelined.size(); i++) {
+		if (pipelined[i].bBegin
+				&& PQresultStatus(results[i]) == PGRES_COMMAND_OK) {
+			PQclear(results[i]);
+			continue;
+		}
+		try {
+			m_Results.push_back(check(pipelined[i].sql, pipelined[i].params,
+					pipelined[i].llStart, results[i]));
+		} catch (std::string const &) {
+			for (size_t j = i + 1; j < results.size(); j++)
+				PQclear(results[j]);
+			clearResults();
+			throw;
+		}
+	}
+#endif
+}
+
+bool
+CDBConnection::pipelineSupported()
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	return true;
+#else
+	return false;
+#endif
+}
+
+void
+CDBConnection::writePipelineStats(std::ostream &out)
+{
+	out << "frame,statements,round_trips,round_trips_saved" << endl;
+	for (int i = 0; i < PIPELINE_FRAMES; i++) {
+		long long llStatements = llPipelineStatements[i];
+		long long llRoundTrips = llPipelineRoundTrips[i];
+		out << szPipelineFrame[i] << "," << llStatements << ","
+			<< llRoundTrips << "," << llStatements - llRoundTrips << endl;
+	}
+}
+
+bool
+CDBConnection::framesAreOneStatement()
+{
+	return false;
+}
+
 void
 CDBConnection::reconnect()
 {
@@ -619,52 +1334,311 @@ CDBConnection::reconnect()
 	connect();
 }
 
+void
+CDBConnection::replaceDate(int param, const TIMESTAMP_STRUCT &date)
+{
+	if (!capturing(CAPTURE_PARAMS))
+		return;
+
+	ostringstream ss;
+	ss << date.year << "-" << date.month << "-" << date.day;
+	replace_map[param] = ss.str();
+}
+
+void
+CDBConnection::replaceParam(int param, const char *value)
+{
+	if (capturing(CAPTURE_PARAMS))
+		replace_map[param] = value;
+}
+
+void
+CDBConnection::replaceTimestamp(int param, const TIMESTAMP_STRUCT &timestamp)
+{
+	if (!capturing(CAPTURE_PARAMS))
+		return;
+
+	ostringstream ss;
+	ss << timestamp.year << "-" << timestamp.month << "-" << timestamp.day
+	   << " " << timestamp.hour << ":" << timestamp.minute << ":"
+	   << timestamp.second;
+	replace_map[param] = ss.str();
+}
+
 void
 CDBConnection::rollback()
 {
-	PGresult *res = PQexec(m_Conn, "ROLLBACK;");
-	spdlog::info("[timestamp={}][connId={}][sql=ROLLBACK]", time(0), PQbackendPID(m_Conn));
+	PQclear(m_pCommitResult);
+	m_pCommitResult = NULL;
+	m_bCommitWithNext = false;
+	// Nothing to roll back if no statement was run.
+	if (m_bBegin) {
+		m_bBegin = false;
+		return;
+	}
+
+	INT64 llStart = serverClockNs();
+	PGresult *res = query("ROLLBACK;");
+	countStatement(m_StatementStats.id("ROLLBACK"), serverClockNs() - llStart,
+			res);
+	captureCommand("ROLLBACK", NULL);
 	PQclear(res);
 }
 
+void
+CDBConnection::sampleCapture(int iTxnType)
+{
+	if (m_eCapture == CAPTURE_OFF) {
+		m_bCapture = false;
+		return;
+	}
+
+	double fRate = m_pCaptureRates[iTxnType];
+	m_bCapture = fRate >= 1
+			|| rand_r(&m_iCaptureSeed) < fRate * ((double) RAND_MAX + 1);
+}
+
+// Statements of the list by name, the functions called by the frames run on
+// the server by theirs, and any other by the start of its text.
+UINT32
+CDBConnection::statementId(const char *sql)
+{
+	std::unordered_map<const char *, UINT32>::const_iterator it
+			= m_StatementIds.find(sql);
+	if (it != m_StatementIds.end())
+		return it->second;
+
+	static const char szCall[] = "SELECT * FROM ";
+	if (strncmp(sql, szCall, sizeof(szCall) - 1) == 0) {
+		const char *name = sql + sizeof(szCall) - 1;
+		const char *paren = strchr(name, '(');
+		if (paren != NULL)
+			return m_StatementStats.id(string(name, paren - name));
+	}
+
+	string text;
+	for (const char *p = sql; *p != '\0' && text.size() < 40; p++) {
+		if (!isspace((unsigned char) *p))
+			text += *p;
+		else if (!text.empty() && text[text.size() - 1] != ' ')
+			text += ' ';
+	}
+	return m_StatementStats.id(text);
+}
+
+void
+CDBConnection::setBinaryResults(bool bBinary)
+{
+	m_iResultFormat = bBinary ? 1 : 0;
+}
+
 void
 CDBConnection::setBrokerageHouse(CBrokerageHouse *bh)
 {
 	this->bh = bh;
 }
 
+void
+CDBConnection::setCapture(eCaptureLevel eCapture, const double *pRates)
+{
+	m_eCapture = eCapture;
+	m_pCaptureRates = pRates;
+	// Everything is captured until a transaction is sampled.
+	m_bCapture = true;
+	m_iCaptureSeed = (unsigned int) time(NULL)
+			^ (unsigned int) reinterpret_cast<uintptr_t>(this);
+
+	// The binary capture logs the statements of the list by identifier.
+	m_pCaptureLog = eCapture != CAPTURE_OFF ? CCaptureLog::get() : NULL;
+	m_CaptureIds.clear();
+	if (m_pCaptureLog == NULL)
+		return;
+	for (size_t i = 0; i < m_Statements.size(); i++) {
+		m_CaptureIds[m_Statements[i]->sql] = m_pCaptureLog->statementId(
+				m_Statements[i]->name, m_Statements[i]->sql);
+	}
+}
+
+void
+CDBConnection::setPlanCache(ePlanCache ePlanCache)
+{
+	if (!m_PreparedText.empty())
+		setting(m_Conn, "DEALLOCATE ALL");
+	m_ePlanCache = ePlanCache;
+	prepareStatements();
+}
+
+// Send the independent statements of some frames together from now on.
+void
+CDBConnection::setPipeline(bool bPipeline)
+{
+	m_bPipeline = bPipeline && pipelineSupported();
+}
+
+// Send the statements without blocking from now on, waiting through pWait.
+void
+CDBConnection::setWait(CDBWait *pWait)
+{
+	m_pWait = pWait;
+	PQsetnonblocking(m_Conn, pWait != NULL ? 1 : 0);
+}
+
+// A timer that is never set never expires, a wait of 0 returns at once.
+void
+CDBConnection::backoff(int iMicroseconds)
+{
+	if (iMicroseconds <= 0)
+		return;
+
+	int fd = -1;
+	if (m_pWait != NULL)
+		fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (fd == -1) {
+		usleep(iMicroseconds);
+		return;
+	}
+
+	struct itimerspec timer = {};
+	timer.it_value.tv_sec = iMicroseconds / 1000000;
+	timer.it_value.tv_nsec = (long) (iMicroseconds % 1000000) * 1000;
+	if (timerfd_settime(fd, 0, &timer, NULL) == 0) {
+		uint64_t expirations;
+		m_pWait->wait(fd, false);
+		if (read(fd, &expirations, sizeof(expirations)) == -1) {
+			// Expired all the same, poll() said so.
+		}
+	} else {
+		usleep(iMicroseconds);
+	}
+	close(fd);
+}
+
+void
+CDBConnection::setServerTimes(PMsgServerTimes pServerTimes)
+{
+	m_pServerTimes = pServerTimes;
+}
+
+PMsgServerTimes
+CDBConnection::serverTimes()
+{
+	return m_pServerTimes;
+}
+
+// Plan every statement prepared through EXPLAIN, which changes nothing, with
+// all its parameters NULL.  The generic plans are built, and kept for the
+// executions to come if PostgreSQL finds them good enough, and the catalog
+// caches are loaded.
+void
+CDBConnection::warmUp()
+{
+	setting(m_Conn, szPlanCacheMode[PLAN_CACHE_GENERIC]);
+	for (size_t i = 0; i < m_Statements.size(); i++) {
+		const char *name = m_Statements[i]->name;
+		if (m_PreparedSql.find(m_Statements[i]->sql) == m_PreparedSql.end())
+			continue;
+
+		PGresult *res = PQdescribePrepared(m_Conn, name);
+		int nParams = PQnparams(res);
+		PQclear(res);
+
+		ostringstream osSQL;
+		osSQL << "EXPLAIN EXECUTE " << name;
+		for (int j = 0; j < nParams; j++)
+			osSQL << (j == 0 ? "(" : ", ") << "NULL";
+		if (nParams > 0)
+			osSQL << ")";
+
+		res = PQexec(m_Conn, osSQL.str().c_str());
+		if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+			cerr << "WARNING: cannot plan " << name << ": "
+				 << PQresultErrorMessage(res);
+		}
+		PQclear(res);
+	}
+}
+
 void
 CDBConnection::setReadCommitted()
 {
-	PGresult *res = PQexec(
-			m_Conn, "SET TRANSACTION ISOLATION LEVEL READ COMMITTED;");
-	spdlog::info("[timestamp={}][connId={}][sql=SET TRANSACTION ISOLATION LEVEL READ COMMITTED]", time(0), PQbackendPID(m_Conn));
+	if (m_bBegin) {
+		m_szIsolation = "READ COMMITTED";
+		return;
+	}
+
+	PGresult *res = query("SET TRANSACTION ISOLATION LEVEL READ COMMITTED;");
+	captureCommand("SET TRANSACTION ISOLATION LEVEL READ COMMITTED", NULL);
+	PQclear(res);
+}
+
+void
+CDBConnection::setReadOnly()
+{
+	if (m_bBegin) {
+		m_bReadOnly = true;
+		return;
+	}
+
+	PGresult *res = query("SET TRANSACTION READ ONLY;");
+	captureCommand("SET TRANSACTION READ ONLY", NULL);
 	PQclear(res);
 }
 
 void
 CDBConnection::setReadUncommitted()
 {
-	PGresult *res = PQexec(
-			m_Conn, "SET TRANSACTION ISOLATION LEVEL READ UNCOMMITTED;");
-	spdlog::info("[timestamp={}][connId={}][sql=SET TRANSACTION ISOLATION LEVEL READ UNCOMMITTED]", time(0), PQbackendPID(m_Conn));
+	if (m_bBegin) {
+		m_szIsolation = "READ UNCOMMITTED";
+		return;
+	}
+
+	PGresult *res = query("SET TRANSACTION ISOLATION LEVEL READ UNCOMMITTED;");
+	captureCommand("SET TRANSACTION ISOLATION LEVEL READ UNCOMMITTED", NULL);
 	PQclear(res);
 }
 
 void
 CDBConnection::setRepeatableRead()
 {
-	PGresult *res = PQexec(
-			m_Conn, "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ;");
-	spdlog::info("[timestamp={}][connId={}][sql=SET TRANSACTION ISOLATION LEVEL REPEATABLE READ]", time(0), PQbackendPID(m_Conn));
+	if (m_bBegin) {
+		m_szIsolation = "REPEATABLE READ";
+		return;
+	}
+
+	PGresult *res = query("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ;");
+	captureCommand("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ", NULL);
 	PQclear(res);
 }
 
 void
 CDBConnection::setSerializable()
 {
-	PGresult *res
-			= PQexec(m_Conn, "SET TRANSACTION ISOLATION LEVEL SERIALIZABLE");
-	spdlog::info("[timestamp={}][connId={}][sql=SET TRANSACTION ISOLATION LEVEL SERIALIZABLE]", time(0), PQbackendPID(m_Conn));
+	if (m_bBegin) {
+		m_szIsolation = "SERIALIZABLE";
+		return;
+	}
+
+	PGresult *res = query("SET TRANSACTION ISOLATION LEVEL SERIALIZABLE");
+	captureCommand("SET TRANSACTION ISOLATION LEVEL SERIALIZABLE", NULL);
 	PQclear(res);
 }
+
+// The statements of the frames above, with the parameter types they pass.
+static const Oid MFF1Q1Types[3] = { NUMERICOID, INT4OID, TEXTOID };
+
+const TPreparedStatement CDBConnection::Statements[] = {
+	{ "MFF1Q1", MFF1Q1, 3, MFF1Q1Types },
+	{ "MFF1Q2", MFF1Q2, 0, NULL },
+	{ "MFF1Q3", MFF1Q3, 0, NULL },
+	{ "MFF1Q4", MFF1Q4, 0, NULL },
+	{ "MFF1Q5", MFF1Q5, 0, NULL },
+	{ "TCF1Q1", TCF1Q1, 0, NULL },
+	{ "TCF1Q2", TCF1Q2, 0, NULL },
+	{ "TCF1Q3", TCF1Q3, 0, NULL },
+	{ "TCF1Q4", TCF1Q4, 0, NULL },
+	{ "TCF1Q5", TCF1Q5, 0, NULL },
+	{ "TCF1Q6", TCF1Q6, 0, NULL },
+	{ "TCF1Q7", TCF1Q7, 0, NULL },
+	{ "TCF1Q8", TCF1Q8, 0, NULL },
+	{ NULL, NULL, 0, NULL }
+};
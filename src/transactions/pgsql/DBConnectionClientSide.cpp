@@ -11,6 +11,7 @@
 
 #include "DBConnection.h"
 #include "DBConnectionClientSide.h"
+#include "DBResult.h"
 
 #define DATELEN 11
 
@@ -20,6 +21,8 @@ CDBConnectionClientSide::CDBConnectionClientSide(const char *szHost,
 		const char *szDBName, const char *szDBPort, bool bVerbose)
 : CDBConnection(szHost, szDBName, szDBPort, bVerbose)
 {
+	addStatements(CDBConnection::Statements);
+	addStatements(Statements);
 }
 
 CDBConnectionClientSide::~CDBConnectionClientSide() {}
@@ -68,12 +71,13 @@ CDBConnectionClientSide::execute(
 	const int paramFormats[2] = { 0, 0 };
 
 	PGresult *res = exec(
-			BVF1Q1, 2, NULL, paramValues, paramLengths, paramFormats, 0);
+			BVF1Q1, 2, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	pOut->list_len = PQntuples(res);
 	for (i = 0; i < pOut->list_len; i++) {
-		strncpy(pOut->broker_name[i], PQgetvalue(res, i, 0), cB_NAME_len);
-		pOut->volume[i] = atof(PQgetvalue(res, i, 1));
+		getString(res, i, 0, pOut->broker_name[i], cB_NAME_len);
+		pOut->volume[i] = getDouble(res, i, 1);
 	}
 	PQclear(res);
 
@@ -116,13 +120,14 @@ CDBConnectionClientSide::execute(const TCustomerPositionFrame1Input *pIn,
 		}
 
 		res = exec(
-				CPF1Q1, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				CPF1Q1, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			return;
 		}
 
-		pOut->cust_id = atoll(PQgetvalue(res, 0, 0));
+		pOut->cust_id = getInt64(res, 0, 0);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -167,36 +172,36 @@ CDBConnectionClientSide::execute(const TCustomerPositionFrame1Input *pIn,
 		cout << "$1 = " << be64toh(cust_id) << endl;
 	}
 
-	res = exec(CPF1Q2, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+	res = exec(CPF1Q2, 1, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	strncpy(pOut->c_st_id, PQgetvalue(res, 0, 0), cST_ID_len);
-	strncpy(pOut->c_l_name, PQgetvalue(res, 0, 1), cL_NAME_len);
-	strncpy(pOut->c_f_name, PQgetvalue(res, 0, 2), cF_NAME_len);
-	strncpy(pOut->c_m_name, PQgetvalue(res, 0, 3), cM_NAME_len);
-	strncpy(pOut->c_gndr, PQgetvalue(res, 0, 4), cGNDR_len);
-	pOut->c_tier = PQgetvalue(res, 0, 5)[0];
-	sscanf(PQgetvalue(res, 0, 6), "%hd-%hd-%hd", &pOut->c_dob.year,
-			&pOut->c_dob.month, &pOut->c_dob.day);
-	pOut->c_ad_id = atoll(PQgetvalue(res, 0, 7));
-	strncpy(pOut->c_ctry_1, PQgetvalue(res, 0, 8), cCTRY_len);
-	strncpy(pOut->c_area_1, PQgetvalue(res, 0, 9), cAREA_len);
-	strncpy(pOut->c_local_1, PQgetvalue(res, 0, 10), cLOCAL_len);
-	strncpy(pOut->c_ext_1, PQgetvalue(res, 0, 11), cEXT_len);
-	strncpy(pOut->c_ctry_2, PQgetvalue(res, 0, 12), cCTRY_len);
-	strncpy(pOut->c_area_2, PQgetvalue(res, 0, 13), cAREA_len);
-	strncpy(pOut->c_local_2, PQgetvalue(res, 0, 14), cLOCAL_len);
-	strncpy(pOut->c_ext_2, PQgetvalue(res, 0, 15), cEXT_len);
-	strncpy(pOut->c_ctry_3, PQgetvalue(res, 0, 16), cCTRY_len);
-	strncpy(pOut->c_area_3, PQgetvalue(res, 0, 17), cAREA_len);
-	strncpy(pOut->c_local_3, PQgetvalue(res, 0, 18), cLOCAL_len);
-	strncpy(pOut->c_ext_3, PQgetvalue(res, 0, 19), cEXT_len);
-	strncpy(pOut->c_email_1, PQgetvalue(res, 0, 20), cEMAIL_len);
-	strncpy(pOut->c_email_2, PQgetvalue(res, 0, 21), cEMAIL_len);
+	getString(res, 0, 0, pOut->c_st_id, cST_ID_len);
+	getString(res, 0, 1, pOut->c_l_name, cL_NAME_len);
+	getString(res, 0, 2, pOut->c_f_name, cF_NAME_len);
+	getString(res, 0, 3, pOut->c_m_name, cM_NAME_len);
+	getString(res, 0, 4, pOut->c_gndr, cGNDR_len);
+	pOut->c_tier = (char) ('0' + getInt32(res, 0, 5));
+	getTimestamp(res, 0, 6, &pOut->c_dob);
+	pOut->c_ad_id = getInt64(res, 0, 7);
+	getString(res, 0, 8, pOut->c_ctry_1, cCTRY_len);
+	getString(res, 0, 9, pOut->c_area_1, cAREA_len);
+	getString(res, 0, 10, pOut->c_local_1, cLOCAL_len);
+	getString(res, 0, 11, pOut->c_ext_1, cEXT_len);
+	getString(res, 0, 12, pOut->c_ctry_2, cCTRY_len);
+	getString(res, 0, 13, pOut->c_area_2, cAREA_len);
+	getString(res, 0, 14, pOut->c_local_2, cLOCAL_len);
+	getString(res, 0, 15, pOut->c_ext_2, cEXT_len);
+	getString(res, 0, 16, pOut->c_ctry_3, cCTRY_len);
+	getString(res, 0, 17, pOut->c_area_3, cAREA_len);
+	getString(res, 0, 18, pOut->c_local_3, cLOCAL_len);
+	getString(res, 0, 19, pOut->c_ext_3, cEXT_len);
+	getString(res, 0, 20, pOut->c_email_1, cEMAIL_len);
+	getString(res, 0, 21, pOut->c_email_2, cEMAIL_len);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -244,13 +249,14 @@ CDBConnectionClientSide::execute(const TCustomerPositionFrame1Input *pIn,
 		cout << "$1 = " << be64toh(cust_id) << endl;
 	}
 
-	res = exec(CPF1Q3, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+	res = exec(CPF1Q3, 1, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	pOut->acct_len = PQntuples(res);
 	for (int i = 0; i < pOut->acct_len; i++) {
-		pOut->acct_id[i] = atoll(PQgetvalue(res, i, 0));
-		pOut->cash_bal[i] = atof(PQgetvalue(res, i, 1));
-		pOut->asset_total[i] = atof(PQgetvalue(res, i, 2));
+		pOut->acct_id[i] = getInt64(res, i, 0);
+		pOut->cash_bal[i] = getDouble(res, i, 1);
+		pOut->asset_total[i] = getDouble(res, i, 2);
 	}
 	PQclear(res);
 
@@ -301,19 +307,16 @@ CDBConnectionClientSide::execute(const TCustomerPositionFrame2Input *pIn,
 	}
 
 	PGresult *res = exec(
-			CPF2Q1, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+			CPF2Q1, 1, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	pOut->hist_len = PQntuples(res);
 	for (int i = 0; i < pOut->hist_len; i++) {
-		pOut->trade_id[i] = atoll(PQgetvalue(res, i, 0));
-		strncpy(pOut->symbol[i], PQgetvalue(res, i, 1), cSYMBOL_len);
-		pOut->qty[i] = atoi(PQgetvalue(res, i, 2));
-		strncpy(pOut->trade_status[i], PQgetvalue(res, i, 3), cST_NAME_len);
-		sscanf(PQgetvalue(res, i, 4), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-				&pOut->hist_dts[i].year, &pOut->hist_dts[i].month,
-				&pOut->hist_dts[i].day, &pOut->hist_dts[i].hour,
-				&pOut->hist_dts[i].minute, &pOut->hist_dts[i].second,
-				&pOut->hist_dts[i].fraction);
+		pOut->trade_id[i] = getInt64(res, i, 0);
+		getString(res, i, 1, pOut->symbol[i], cSYMBOL_len);
+		pOut->qty[i] = getInt32(res, i, 2);
+		getString(res, i, 3, pOut->trade_status[i], cST_NAME_len);
+		getTimestamp(res, i, 4, &pOut->hist_dts[i]);
 	}
 	PQclear(res);
 
@@ -735,7 +738,8 @@ CDBConnectionClientSide::execute(
 		const int paramFormats[1] = { 1 };
 
 		res = exec(
-				MWF1Q1A, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				MWF1Q1A, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 	} else if (pIn->industry_name[0] != '\0') {
 #define MWF1Q1B                                                               \
 	"SELECT s_symb\n"                                                         \
@@ -765,7 +769,7 @@ CDBConnectionClientSide::execute(
 		const int paramFormats[3] = { 0, 1, 1 };
 
 		res = exec(MWF1Q1B, 3, paramTypes, paramValues, paramLengths,
-				paramFormats, 0);
+				paramFormats, m_iResultFormat);
 	} else if (pIn->acct_id != 0) {
 #define MWF1Q1C                                                               \
 	"SELECT hs_s_symb\n"                                                      \
@@ -784,7 +788,8 @@ CDBConnectionClientSide::execute(
 		const int paramFormats[1] = { 1 };
 
 		res = exec(
-				MWF1Q1C, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				MWF1Q1C, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 	} else {
 		cerr << "MarketWatchFrame1 error figuring out what to do" << endl;
 		return;
@@ -820,7 +825,8 @@ CDBConnectionClientSide::execute(
 		const int paramFormats[2] = { 0, 0 };
 
 		res2 = exec(
-				MWF1Q2, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				MWF1Q2, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res2) == 0) {
 			cerr << __FILE__ << ":" << __LINE__ << " WARNING: NO ROWS RETURNED"
@@ -830,7 +836,7 @@ CDBConnectionClientSide::execute(
 			return;
 		}
 
-		double new_price = atof(PQgetvalue(res2, 0, 0));
+		double new_price = getDouble(res2, 0, 0);
 		PQclear(res2);
 
 		if (m_bVerbose) {
@@ -848,7 +854,8 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(
-				MWF1Q3, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				MWF1Q3, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res2) == 0) {
 			cerr << __FILE__ << ":" << __LINE__ << " WARNING: NO ROWS RETURNED"
@@ -858,7 +865,7 @@ CDBConnectionClientSide::execute(
 			return;
 		}
 
-		double s_num_out = atof(PQgetvalue(res2, 0, 0));
+		double s_num_out = getDouble(res2, 0, 0);
 		PQclear(res2);
 
 		if (m_bVerbose) {
@@ -879,7 +886,8 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(
-				MWF1Q4, 2, NULL, paramValues, paramLengths, paramFormats, 0);
+				MWF1Q4, 2, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res2) == 0) {
 			cerr << __FILE__ << ":" << __LINE__ << " WARNING: NO ROWS RETURNED"
@@ -889,7 +897,7 @@ CDBConnectionClientSide::execute(
 			return;
 		}
 
-		double old_price = atof(PQgetvalue(res2, 0, 0));
+		double old_price = getDouble(res2, 0, 0);
 		PQclear(res2);
 
 		if (m_bVerbose) {
@@ -974,66 +982,48 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 	const int paramLengths1[1] = { sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats1[1] = { 0 };
 
-	res = exec(SDF1Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(SDF1Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	strncpy(pOut->s_name, PQgetvalue(res, 0, 0), cS_NAME_len);
-	uint64_t co_id = htobe64((uint64_t) atoll(PQgetvalue(res, 0, 1)));
-	strncpy(pOut->co_name, PQgetvalue(res, 0, 2), cCO_NAME_len);
-	strncpy(pOut->sp_rate, PQgetvalue(res, 0, 3), cSP_RATE_len);
-	strncpy(pOut->ceo_name, PQgetvalue(res, 0, 4), cCEO_NAME_len);
-	strncpy(pOut->co_desc, PQgetvalue(res, 0, 5), cCO_DESC_len);
-	sscanf(PQgetvalue(res, 0, 6), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-			&pOut->open_date.year, &pOut->open_date.month,
-			&pOut->open_date.day, &pOut->open_date.hour,
-			&pOut->open_date.minute, &pOut->open_date.second,
-			&pOut->open_date.fraction);
-	strncpy(pOut->co_st_id, PQgetvalue(res, 0, 7), cST_ID_len);
-	strncpy(pOut->co_ad_line1, PQgetvalue(res, 0, 8), cAD_LINE_len);
-	strncpy(pOut->co_ad_line2, PQgetvalue(res, 0, 9), cAD_LINE_len);
-	strncpy(pOut->co_ad_town, PQgetvalue(res, 0, 10), cAD_TOWN_len);
-	strncpy(pOut->co_ad_div, PQgetvalue(res, 0, 11), cAD_DIV_len);
-	strncpy(pOut->co_ad_zip, PQgetvalue(res, 0, 12), cAD_ZIP_len);
-	strncpy(pOut->co_ad_cty, PQgetvalue(res, 0, 13), cAD_CTRY_len);
-	pOut->num_out = atoll(PQgetvalue(res, 0, 14));
-	sscanf(PQgetvalue(res, 0, 15), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-			&pOut->start_date.year, &pOut->start_date.month,
-			&pOut->start_date.day, &pOut->start_date.hour,
-			&pOut->start_date.minute, &pOut->start_date.second,
-			&pOut->start_date.fraction);
-	sscanf(PQgetvalue(res, 0, 16), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-			&pOut->ex_date.year, &pOut->ex_date.month, &pOut->ex_date.day,
-			&pOut->ex_date.hour, &pOut->ex_date.minute, &pOut->ex_date.second,
-			&pOut->ex_date.fraction);
-	pOut->pe_ratio = atof(PQgetvalue(res, 0, 17));
-	pOut->s52_wk_high = atof(PQgetvalue(res, 0, 18));
-	sscanf(PQgetvalue(res, 0, 19), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-			&pOut->s52_wk_high_date.year, &pOut->s52_wk_high_date.month,
-			&pOut->s52_wk_high_date.day, &pOut->s52_wk_high_date.hour,
-			&pOut->s52_wk_high_date.minute, &pOut->s52_wk_high_date.second,
-			&pOut->s52_wk_high_date.fraction);
-	pOut->s52_wk_low = atof(PQgetvalue(res, 0, 20));
-	sscanf(PQgetvalue(res, 0, 21), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-			&pOut->s52_wk_low_date.year, &pOut->s52_wk_low_date.month,
-			&pOut->s52_wk_low_date.day, &pOut->s52_wk_low_date.hour,
-			&pOut->s52_wk_low_date.minute, &pOut->s52_wk_low_date.second,
-			&pOut->s52_wk_low_date.fraction);
-	pOut->divid = atof(PQgetvalue(res, 0, 22));
-	pOut->yield = atof(PQgetvalue(res, 0, 23));
-	strncpy(pOut->ex_ad_div, PQgetvalue(res, 0, 24), cAD_DIV_len);
-	strncpy(pOut->ex_ad_cty, PQgetvalue(res, 0, 25), cAD_CTRY_len);
-	strncpy(pOut->ex_ad_line1, PQgetvalue(res, 0, 26), cAD_LINE_len);
-	strncpy(pOut->ex_ad_line2, PQgetvalue(res, 0, 27), cAD_LINE_len);
-	strncpy(pOut->ex_ad_town, PQgetvalue(res, 0, 28), cAD_TOWN_len);
-	strncpy(pOut->ex_ad_zip, PQgetvalue(res, 0, 29), cAD_ZIP_len);
-	pOut->ex_close = atoi(PQgetvalue(res, 0, 30));
-	strncpy(pOut->ex_desc, PQgetvalue(res, 0, 31), cEX_DESC_len);
-	strncpy(pOut->ex_name, PQgetvalue(res, 0, 32), cEX_NAME_len);
-	pOut->ex_num_symb = atoi(PQgetvalue(res, 0, 33));
-	pOut->ex_open = atoi(PQgetvalue(res, 0, 34));
+	getString(res, 0, 0, pOut->s_name, cS_NAME_len);
+	uint64_t co_id = htobe64((uint64_t) getInt64(res, 0, 1));
+	getString(res, 0, 2, pOut->co_name, cCO_NAME_len);
+	getString(res, 0, 3, pOut->sp_rate, cSP_RATE_len);
+	getString(res, 0, 4, pOut->ceo_name, cCEO_NAME_len);
+	getString(res, 0, 5, pOut->co_desc, cCO_DESC_len);
+	getTimestamp(res, 0, 6, &pOut->open_date);
+	getString(res, 0, 7, pOut->co_st_id, cST_ID_len);
+	getString(res, 0, 8, pOut->co_ad_line1, cAD_LINE_len);
+	getString(res, 0, 9, pOut->co_ad_line2, cAD_LINE_len);
+	getString(res, 0, 10, pOut->co_ad_town, cAD_TOWN_len);
+	getString(res, 0, 11, pOut->co_ad_div, cAD_DIV_len);
+	getString(res, 0, 12, pOut->co_ad_zip, cAD_ZIP_len);
+	getString(res, 0, 13, pOut->co_ad_cty, cAD_CTRY_len);
+	pOut->num_out = getInt64(res, 0, 14);
+	getTimestamp(res, 0, 15, &pOut->start_date);
+	getTimestamp(res, 0, 16, &pOut->ex_date);
+	pOut->pe_ratio = getDouble(res, 0, 17);
+	pOut->s52_wk_high = getDouble(res, 0, 18);
+	getTimestamp(res, 0, 19, &pOut->s52_wk_high_date);
+	pOut->s52_wk_low = getDouble(res, 0, 20);
+	getTimestamp(res, 0, 21, &pOut->s52_wk_low_date);
+	pOut->divid = getDouble(res, 0, 22);
+	pOut->yield = getDouble(res, 0, 23);
+	getString(res, 0, 24, pOut->ex_ad_div, cAD_DIV_len);
+	getString(res, 0, 25, pOut->ex_ad_cty, cAD_CTRY_len);
+	getString(res, 0, 26, pOut->ex_ad_line1, cAD_LINE_len);
+	getString(res, 0, 27, pOut->ex_ad_line2, cAD_LINE_len);
+	getString(res, 0, 28, pOut->ex_ad_town, cAD_TOWN_len);
+	getString(res, 0, 29, pOut->ex_ad_zip, cAD_ZIP_len);
+	pOut->ex_close = getInt32(res, 0, 30);
+	getString(res, 0, 31, pOut->ex_desc, cEX_DESC_len);
+	getString(res, 0, 32, pOut->ex_name, cEX_NAME_len);
+	pOut->ex_num_symb = getInt32(res, 0, 33);
+	pOut->ex_open = getInt32(res, 0, 34);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -1121,12 +1111,12 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 	const int paramFormats2[2] = { 1, 1 };
 
 	res = exec(SDF1Q2, 2, paramTypes2, paramValues2, paramLengths2,
-			paramFormats2, 0);
+			paramFormats2, m_iResultFormat);
 
 	int count = PQntuples(res);
 	for (int i = 0; i < count; i++) {
-		strncpy(pOut->cp_co_name[i], PQgetvalue(res, i, 0), cCO_NAME_len);
-		strncpy(pOut->cp_in_name[i], PQgetvalue(res, i, 1), cIN_NAME_len);
+		getString(res, i, 0, pOut->cp_co_name[i], cCO_NAME_len);
+		getString(res, i, 1, pOut->cp_in_name[i], cIN_NAME_len);
 	}
 	PQclear(res);
 
@@ -1168,25 +1158,23 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 	}
 
 	res = exec(SDF1Q3, 2, paramTypes2, paramValues2, paramLengths2,
-			paramFormats2, 0);
+			paramFormats2, m_iResultFormat);
 
 	pOut->fin_len = PQntuples(res);
 	for (int i = 0; i < pOut->fin_len; i++) {
-		pOut->fin[i].year = atoi(PQgetvalue(res, i, 0));
-		pOut->fin[i].qtr = atoi(PQgetvalue(res, i, 1));
-		sscanf(PQgetvalue(res, i, 2), "%hd-%hd-%hd",
-				&pOut->fin[i].start_date.year, &pOut->fin[i].start_date.month,
-				&pOut->fin[i].start_date.day);
-		pOut->fin[i].rev = atof(PQgetvalue(res, i, 3));
-		pOut->fin[i].net_earn = atof(PQgetvalue(res, i, 4));
-		pOut->fin[i].basic_eps = atof(PQgetvalue(res, i, 5));
-		pOut->fin[i].dilut_eps = atof(PQgetvalue(res, i, 6));
-		pOut->fin[i].margin = atof(PQgetvalue(res, i, 7));
-		pOut->fin[i].invent = atof(PQgetvalue(res, i, 8));
-		pOut->fin[i].assets = atof(PQgetvalue(res, i, 9));
-		pOut->fin[i].liab = atof(PQgetvalue(res, i, 10));
-		pOut->fin[i].out_basic = atof(PQgetvalue(res, i, 11));
-		pOut->fin[i].out_dilut = atof(PQgetvalue(res, i, 12));
+		pOut->fin[i].year = getInt32(res, i, 0);
+		pOut->fin[i].qtr = getInt32(res, i, 1);
+		getTimestamp(res, i, 2, &pOut->fin[i].start_date);
+		pOut->fin[i].rev = getDouble(res, i, 3);
+		pOut->fin[i].net_earn = getDouble(res, i, 4);
+		pOut->fin[i].basic_eps = getDouble(res, i, 5);
+		pOut->fin[i].dilut_eps = getDouble(res, i, 6);
+		pOut->fin[i].margin = getDouble(res, i, 7);
+		pOut->fin[i].invent = getDouble(res, i, 8);
+		pOut->fin[i].assets = getDouble(res, i, 9);
+		pOut->fin[i].liab = getDouble(res, i, 10);
+		pOut->fin[i].out_basic = getDouble(res, i, 11);
+		pOut->fin[i].out_dilut = getDouble(res, i, 12);
 	}
 	PQclear(res);
 
@@ -1253,23 +1241,18 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 		sizeof(uint32_t), sizeof(uint32_t) };
 	const int paramFormats3[3] = { 0, 1, 1 };
 
-	stringstream ss;
-	ss << pIn->start_day.year << "-" 
-	   << pIn->start_day.month << "-" 
-	   << pIn->start_day.day;
-	replace_map[1] = ss.str();
+	replaceDate(1, pIn->start_day);
 
 	res = exec(SDF1Q4, 3, paramTypes3, paramValues3, paramLengths3,
-			paramFormats3, 0);
+			paramFormats3, m_iResultFormat);
 
 	pOut->day_len = PQntuples(res);
 	for (int i = 0; i < pOut->day_len; i++) {
-		sscanf(PQgetvalue(res, i, 0), "%hd-%hd-%hd", &pOut->day[i].date.year,
-				&pOut->day[i].date.month, &pOut->day[i].date.day);
-		pOut->day[i].close = atof(PQgetvalue(res, i, 1));
-		pOut->day[i].high = atof(PQgetvalue(res, i, 2));
-		pOut->day[i].low = atof(PQgetvalue(res, i, 3));
-		pOut->day[i].vol = atoll(PQgetvalue(res, i, 4));
+		getTimestamp(res, i, 0, &pOut->day[i].date);
+		pOut->day[i].close = getDouble(res, i, 1);
+		pOut->day[i].high = getDouble(res, i, 2);
+		pOut->day[i].low = getDouble(res, i, 3);
+		pOut->day[i].vol = getInt64(res, i, 4);
 	}
 	PQclear(res);
 
@@ -1297,7 +1280,8 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 		cout << "$1 = " << pIn->symbol << endl;
 	}
 
-	res = exec(SDF1Q5, 1, NULL, paramValues3, paramLengths3, paramFormats3, 0);
+	res = exec(SDF1Q5, 1, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		cerr << __FILE__ << ":" << __LINE__ << " WARNING: NO ROWS RETURNED"
@@ -1306,9 +1290,9 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 		return;
 	}
 
-	pOut->last_price = atof(PQgetvalue(res, 0, 0));
-	pOut->last_open = atof(PQgetvalue(res, 0, 1));
-	pOut->last_vol = atoll(PQgetvalue(res, 0, 2));
+	pOut->last_price = getDouble(res, 0, 0);
+	pOut->last_open = getDouble(res, 0, 1);
+	pOut->last_vol = getInt64(res, 0, 2);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -1340,7 +1324,7 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 		}
 
 		res = exec(SDF1Q6A, 2, paramTypes2, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 	} else {
 #define SDF1Q6B                                                               \
 	"SELECT '' AS ni_item\n"                                                  \
@@ -1362,22 +1346,17 @@ CDBConnectionClientSide::execute(const TSecurityDetailFrame1Input *pIn,
 		}
 
 		res = exec(SDF1Q6B, 2, paramTypes2, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 	}
 
 	pOut->news_len = PQntuples(res);
 	for (int i = 0; i < pOut->news_len; i++) {
-		strncpy(pOut->news[i].item, PQgetvalue(res, i, 0), cNI_ITEM_len);
-		sscanf(PQgetvalue(res, i, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-				&pOut->news[i].dts.year, &pOut->news[i].dts.month,
-				&pOut->news[i].dts.day, &pOut->news[i].dts.hour,
-				&pOut->news[i].dts.minute, &pOut->news[i].dts.second,
-				&pOut->news[i].dts.fraction);
-		strncpy(pOut->news[i].src, PQgetvalue(res, i, 2), cNI_SOURCE_len);
-		strncpy(pOut->news[i].auth, PQgetvalue(res, i, 3), cNI_AUTHOR_len);
-		strncpy(pOut->news[i].headline, PQgetvalue(res, i, 4),
-				cNI_HEADLINE_len);
-		strncpy(pOut->news[i].summary, PQgetvalue(res, i, 5), cNI_SUMMARY_len);
+		getString(res, i, 0, pOut->news[i].item, cNI_ITEM_len);
+		getTimestamp(res, i, 1, &pOut->news[i].dts);
+		getString(res, i, 2, pOut->news[i].src, cNI_SOURCE_len);
+		getString(res, i, 3, pOut->news[i].auth, cNI_AUTHOR_len);
+		getString(res, i, 4, pOut->news[i].headline, cNI_HEADLINE_len);
+		getString(res, i, 5, pOut->news[i].summary, cNI_SUMMARY_len);
 	}
 	PQclear(res);
 
@@ -1431,19 +1410,18 @@ CDBConnectionClientSide::execute(
 		const int paramFormats[1] = { 1 };
 
 		res = exec(
-				TLF1Q1, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				TLF1Q1, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res) > 0) {
 			++pOut->num_found;
 
-			pOut->trade_info[i].bid_price = atof(PQgetvalue(res, 0, 0));
-			strncpy(pOut->trade_info[i].exec_name, PQgetvalue(res, 0, 1),
+			pOut->trade_info[i].bid_price = getDouble(res, 0, 0);
+			getString(res, 0, 1, pOut->trade_info[i].exec_name,
 					cEXEC_NAME_len);
-			pOut->trade_info[i].is_cash
-					= PQgetvalue(res, 0, 2)[0] == 't' ? true : false;
-			pOut->trade_info[i].is_market
-					= PQgetvalue(res, 0, 3)[0] == 't' ? true : false;
-			pOut->trade_info[i].trade_price = atof(PQgetvalue(res, 0, 4));
+			pOut->trade_info[i].is_cash = getBool(res, 0, 2);
+			pOut->trade_info[i].is_market = getBool(res, 0, 3);
+			pOut->trade_info[i].trade_price = getDouble(res, 0, 4);
 		}
 		PQclear(res);
 
@@ -1473,17 +1451,15 @@ CDBConnectionClientSide::execute(
 		}
 
 		res = exec(
-				TLF1Q2, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				TLF1Q2, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res) > 0) {
-			pOut->trade_info[i].settlement_amount
-					= atof(PQgetvalue(res, 0, 0));
-			sscanf(PQgetvalue(res, 0, 1), "%hd-%hd-%hd",
-					&pOut->trade_info[i].settlement_cash_due_date.year,
-					&pOut->trade_info[i].settlement_cash_due_date.month,
-					&pOut->trade_info[i].settlement_cash_due_date.day);
-			strncpy(pOut->trade_info[i].settlement_cash_type,
-					PQgetvalue(res, 0, 2), cSE_CASH_TYPE_len);
+			pOut->trade_info[i].settlement_amount = getDouble(res, 0, 0);
+			getTimestamp(res, 0, 1,
+					&pOut->trade_info[i].settlement_cash_due_date);
+			getString(res, 0, 2, pOut->trade_info[i].settlement_cash_type,
+					cSE_CASH_TYPE_len);
 		}
 		PQclear(res);
 
@@ -1513,21 +1489,15 @@ CDBConnectionClientSide::execute(
 			}
 
 			res = exec(TLF1Q3, 1, NULL, paramValues, paramLengths,
-					paramFormats, 0);
+					paramFormats, m_iResultFormat);
 
 			if (PQntuples(res) > 0) {
 				pOut->trade_info[i].cash_transaction_amount
-						= atof(PQgetvalue(res, 0, 0));
-				sscanf(PQgetvalue(res, 0, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-						&pOut->trade_info[i].cash_transaction_dts.year,
-						&pOut->trade_info[i].cash_transaction_dts.month,
-						&pOut->trade_info[i].cash_transaction_dts.day,
-						&pOut->trade_info[i].cash_transaction_dts.hour,
-						&pOut->trade_info[i].cash_transaction_dts.minute,
-						&pOut->trade_info[i].cash_transaction_dts.second,
-						&pOut->trade_info[i].cash_transaction_dts.fraction);
-				strncpy(pOut->trade_info[i].cash_transaction_name,
-						PQgetvalue(res, 0, 2), cCT_NAME_len);
+						= getDouble(res, 0, 0);
+				getTimestamp(res, 0, 1,
+						&pOut->trade_info[i].cash_transaction_dts);
+				getString(res, 0, 2, pOut->trade_info[i].cash_transaction_name,
+						cCT_NAME_len);
 			}
 			PQclear(res);
 
@@ -1564,20 +1534,15 @@ CDBConnectionClientSide::execute(
 			}
 
 			res = exec(TLF1Q4, 1, NULL, paramValues, paramLengths,
-					paramFormats, 0);
+					paramFormats, m_iResultFormat);
 
 			int count = PQntuples(res);
 			for (int k = 0; k < count; k++) {
-				sscanf(PQgetvalue(res, k, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-						&pOut->trade_info[i].trade_history_dts[k].year,
-						&pOut->trade_info[i].trade_history_dts[k].month,
-						&pOut->trade_info[i].trade_history_dts[k].day,
-						&pOut->trade_info[i].trade_history_dts[k].hour,
-						&pOut->trade_info[i].trade_history_dts[k].minute,
-						&pOut->trade_info[i].trade_history_dts[k].second,
-						&pOut->trade_info[i].trade_history_dts[k].fraction);
-				strncpy(pOut->trade_info[i].trade_history_status_id[k],
-						PQgetvalue(res, k, 1), cTH_ST_ID_len);
+				getTimestamp(res, k, 0,
+						&pOut->trade_info[i].trade_history_dts[k]);
+				getString(res, k, 1,
+						pOut->trade_info[i].trade_history_status_id[k],
+						cTH_ST_ID_len);
 			}
 			PQclear(res);
 
@@ -1675,42 +1640,22 @@ CDBConnectionClientSide::execute(
 	const int paramFormats1[4] = { 1, 1, 1, 1 };
 	const int paramLengths1[4] = { sizeof(uint64_t), sizeof(uint64_t),
 		sizeof(uint64_t), sizeof(uint32_t) };
-	
-	stringstream ss;
-	
-	ss << pIn->start_trade_dts.year << "-"
-	   << pIn->start_trade_dts.month << "-" 
-	   << pIn->start_trade_dts.day << " " 
-	   << pIn->start_trade_dts.hour << ":"
-	   << pIn->start_trade_dts.minute << ":"
-	   << pIn->start_trade_dts.second;
-	replace_map[1] = ss.str();
-
-	ss.str("");
-	ss.clear();
-
-	ss << pIn->end_trade_dts.year << "-"
-	   << pIn->end_trade_dts.month << "-" 
-	   << pIn->end_trade_dts.day << " " 
-	   << pIn->end_trade_dts.hour << ":"
-	   << pIn->end_trade_dts.minute << ":" 
-	   << pIn->end_trade_dts.second;
-	replace_map[2] = ss.str();
+
+	replaceTimestamp(1, pIn->start_trade_dts);
+	replaceTimestamp(2, pIn->end_trade_dts);
 
 	res = exec(TLF2Q1, 4, paramTypes1, paramValues1, paramLengths1,
-			paramFormats1, 0);
+			paramFormats1, m_iResultFormat);
 
 	pOut->num_found = PQntuples(res);
 	for (int i = 0; i < pOut->num_found; i++) {
 		PGresult *res2 = NULL;
 
-		pOut->trade_info[i].bid_price = atof(PQgetvalue(res, i, 0));
-		strncpy(pOut->trade_info[i].exec_name, PQgetvalue(res, i, 1),
-				cEXEC_NAME_len);
-		pOut->trade_info[i].is_cash
-				= PQgetvalue(res, i, 2)[0] == 't' ? true : false;
-		pOut->trade_info[i].trade_id = atoll(PQgetvalue(res, i, 3));
-		pOut->trade_info[i].trade_price = atof(PQgetvalue(res, i, 4));
+		pOut->trade_info[i].bid_price = getDouble(res, i, 0);
+		getString(res, i, 1, pOut->trade_info[i].exec_name, cEXEC_NAME_len);
+		pOut->trade_info[i].is_cash = getBool(res, i, 2);
+		pOut->trade_info[i].trade_id = getInt64(res, i, 3);
+		pOut->trade_info[i].trade_price = getDouble(res, i, 4);
 
 		if (m_bVerbose) {
 			cout << "bid_price[" << i
@@ -1744,17 +1689,14 @@ CDBConnectionClientSide::execute(
 		const int paramLengths2[1] = { sizeof(uint64_t) };
 
 		res2 = exec(TLF2Q2, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res2) > 0) {
-			pOut->trade_info[i].settlement_amount
-					= atof(PQgetvalue(res2, 0, 0));
-			sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd",
-					&pOut->trade_info[i].settlement_cash_due_date.year,
-					&pOut->trade_info[i].settlement_cash_due_date.month,
-					&pOut->trade_info[i].settlement_cash_due_date.day);
-			strncpy(pOut->trade_info[i].settlement_cash_type,
-					PQgetvalue(res2, 0, 2), cSE_CASH_TYPE_len);
+			pOut->trade_info[i].settlement_amount = getDouble(res2, 0, 0);
+			getTimestamp(res2, 0, 1,
+					&pOut->trade_info[i].settlement_cash_due_date);
+			getString(res2, 0, 2, pOut->trade_info[i].settlement_cash_type,
+					cSE_CASH_TYPE_len);
 		}
 		PQclear(res2);
 
@@ -1783,21 +1725,13 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(TLF2Q3, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res) > 0) {
-			pOut->trade_info[i].cash_transaction_amount
-					= atof(PQgetvalue(res, 0, 0));
-			sscanf(PQgetvalue(res, 0, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].cash_transaction_dts.year,
-					&pOut->trade_info[i].cash_transaction_dts.month,
-					&pOut->trade_info[i].cash_transaction_dts.day,
-					&pOut->trade_info[i].cash_transaction_dts.hour,
-					&pOut->trade_info[i].cash_transaction_dts.minute,
-					&pOut->trade_info[i].cash_transaction_dts.second,
-					&pOut->trade_info[i].cash_transaction_dts.fraction);
-			strncpy(pOut->trade_info[i].cash_transaction_name,
-					PQgetvalue(res, 0, 2), cCT_NAME_len);
+			pOut->trade_info[i].cash_transaction_amount = getDouble(res, 0, 0);
+			getTimestamp(res, 0, 1, &pOut->trade_info[i].cash_transaction_dts);
+			getString(res, 0, 2, pOut->trade_info[i].cash_transaction_name,
+					cCT_NAME_len);
 		}
 		PQclear(res2);
 
@@ -1832,20 +1766,14 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(TLF2Q4, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		int count = PQntuples(res);
 		for (int j = 0; j < count; j++) {
-			sscanf(PQgetvalue(res, j, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].trade_history_dts[j].year,
-					&pOut->trade_info[i].trade_history_dts[j].month,
-					&pOut->trade_info[i].trade_history_dts[j].day,
-					&pOut->trade_info[i].trade_history_dts[j].hour,
-					&pOut->trade_info[i].trade_history_dts[j].minute,
-					&pOut->trade_info[i].trade_history_dts[j].second,
-					&pOut->trade_info[i].trade_history_dts[j].fraction);
-			strncpy(pOut->trade_info[i].trade_history_status_id[j],
-					PQgetvalue(res, j, 1), cTH_ST_ID_len);
+			getTimestamp(res, j, 0, &pOut->trade_info[i].trade_history_dts[j]);
+			getString(res, j, 1,
+					pOut->trade_info[i].trade_history_status_id[j],
+					cTH_ST_ID_len);
 		}
 		PQclear(res2);
 
@@ -1938,53 +1866,25 @@ CDBConnectionClientSide::execute(
 	const int paramFormats1[4] = { 0, 1, 1, 1 };
 	const int paramLengths1[4] = { sizeof(char) * (cSYMBOL_len + 1),
 		sizeof(uint64_t), sizeof(uint64_t), sizeof(uint32_t) };
-	
-	stringstream ss;
-
-	ss << pIn->start_trade_dts.year << "-"
-	   << pIn->start_trade_dts.month << "-" 
-	   << pIn->start_trade_dts.day << " " 
-	   << pIn->start_trade_dts.hour << ":"
-	   << pIn->start_trade_dts.minute << ":"
-	   << pIn->start_trade_dts.second;
-	replace_map[1] = ss.str();
-
-	ss.str("");
-	ss.clear();
-
-	ss << pIn->end_trade_dts.year << "-"
-	   << pIn->end_trade_dts.month << "-" 
-	   << pIn->end_trade_dts.day << " " 
-	   << pIn->end_trade_dts.hour << ":"
-	   << pIn->end_trade_dts.minute << ":" 
-	   << pIn->end_trade_dts.second;
-	replace_map[2] = ss.str();
+
+	replaceTimestamp(1, pIn->start_trade_dts);
+	replaceTimestamp(2, pIn->end_trade_dts);
 
 	res = exec(TLF3Q1, 4, paramTypes1, paramValues1, paramLengths1,
-			paramFormats1, 0);
+			paramFormats1, m_iResultFormat);
 
 	pOut->num_found = PQntuples(res);
 	for (int i = 0; i < pOut->num_found; i++) {
 		PGresult *res2 = NULL;
 
-		pOut->trade_info[i].acct_id = atoll(PQgetvalue(res, i, 0));
-		strncpy(pOut->trade_info[i].exec_name, PQgetvalue(res, i, 1),
-				cEXEC_NAME_len);
-		pOut->trade_info[i].is_cash
-				= PQgetvalue(res, 0, 2)[0] == 't' ? true : false;
-		pOut->trade_info[i].price = atof(PQgetvalue(res, i, 3));
-		pOut->trade_info[i].quantity = atoi(PQgetvalue(res, i, 4));
-		sscanf(PQgetvalue(res, i, 5), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-				&pOut->trade_info[i].trade_dts.year,
-				&pOut->trade_info[i].trade_dts.month,
-				&pOut->trade_info[i].trade_dts.day,
-				&pOut->trade_info[i].trade_dts.hour,
-				&pOut->trade_info[i].trade_dts.minute,
-				&pOut->trade_info[i].trade_dts.second,
-				&pOut->trade_info[i].trade_dts.fraction);
-		pOut->trade_info[i].trade_id = atoll(PQgetvalue(res, i, 6));
-		strncpy(pOut->trade_info[i].trade_type, PQgetvalue(res, i, 7),
-				cTT_ID_len);
+		pOut->trade_info[i].acct_id = getInt64(res, i, 0);
+		getString(res, i, 1, pOut->trade_info[i].exec_name, cEXEC_NAME_len);
+		pOut->trade_info[i].is_cash = getBool(res, 0, 2);
+		pOut->trade_info[i].price = getDouble(res, i, 3);
+		pOut->trade_info[i].quantity = getInt32(res, i, 4);
+		getTimestamp(res, i, 5, &pOut->trade_info[i].trade_dts);
+		pOut->trade_info[i].trade_id = getInt64(res, i, 6);
+		getString(res, i, 7, pOut->trade_info[i].trade_type, cTT_ID_len);
 
 		if (m_bVerbose) {
 			cout << "acct_id[" << i << "] = " << pOut->trade_info[i].acct_id
@@ -2030,17 +1930,14 @@ CDBConnectionClientSide::execute(
 		const int paramLengths2[1] = { sizeof(uint64_t) };
 
 		res2 = exec(TLF3Q2, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res2) > 0) {
-			pOut->trade_info[i].settlement_amount
-					= atof(PQgetvalue(res2, 0, 0));
-			sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd",
-					&pOut->trade_info[i].settlement_cash_due_date.year,
-					&pOut->trade_info[i].settlement_cash_due_date.month,
-					&pOut->trade_info[i].settlement_cash_due_date.day);
-			strncpy(pOut->trade_info[i].settlement_cash_type,
-					PQgetvalue(res2, 0, 2), cSE_CASH_TYPE_len);
+			pOut->trade_info[i].settlement_amount = getDouble(res2, 0, 0);
+			getTimestamp(res2, 0, 1,
+					&pOut->trade_info[i].settlement_cash_due_date);
+			getString(res2, 0, 2, pOut->trade_info[i].settlement_cash_type,
+					cSE_CASH_TYPE_len);
 		}
 		PQclear(res2);
 
@@ -2069,21 +1966,15 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(TLF3Q3, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res2) > 0) {
 			pOut->trade_info[i].cash_transaction_amount
-					= atof(PQgetvalue(res2, 0, 0));
-			sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].cash_transaction_dts.year,
-					&pOut->trade_info[i].cash_transaction_dts.month,
-					&pOut->trade_info[i].cash_transaction_dts.day,
-					&pOut->trade_info[i].cash_transaction_dts.hour,
-					&pOut->trade_info[i].cash_transaction_dts.minute,
-					&pOut->trade_info[i].cash_transaction_dts.second,
-					&pOut->trade_info[i].cash_transaction_dts.fraction);
-			strncpy(pOut->trade_info[i].cash_transaction_name,
-					PQgetvalue(res2, 0, 2), cCT_NAME_len);
+					= getDouble(res2, 0, 0);
+			getTimestamp(res2, 0, 1,
+					&pOut->trade_info[i].cash_transaction_dts);
+			getString(res2, 0, 2, pOut->trade_info[i].cash_transaction_name,
+					cCT_NAME_len);
 		}
 		PQclear(res2);
 
@@ -2118,20 +2009,15 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(TLF3Q4, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		int count = PQntuples(res2);
 		for (int j = 0; j < count; j++) {
-			sscanf(PQgetvalue(res2, j, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].trade_history_dts[j].year,
-					&pOut->trade_info[i].trade_history_dts[j].month,
-					&pOut->trade_info[i].trade_history_dts[j].day,
-					&pOut->trade_info[i].trade_history_dts[j].hour,
-					&pOut->trade_info[i].trade_history_dts[j].minute,
-					&pOut->trade_info[i].trade_history_dts[j].second,
-					&pOut->trade_info[i].trade_history_dts[j].fraction);
-			strncpy(pOut->trade_info[i].trade_history_status_id[j],
-					PQgetvalue(res2, j, 1), cTH_ST_ID_len);
+			getTimestamp(res2, j, 0,
+					&pOut->trade_info[i].trade_history_dts[j]);
+			getString(res2, j, 1,
+					pOut->trade_info[i].trade_history_status_id[j],
+					cTH_ST_ID_len);
 		}
 		PQclear(res2);
 
@@ -2195,17 +2081,10 @@ CDBConnectionClientSide::execute(
 	const int paramFormats1[2] = { 1, 1 };
 	const int paramLengths1[2] = { sizeof(uint64_t), sizeof(uint64_t) };
 
-	stringstream ss;
-	ss << pIn->trade_dts.year << "-" 
-	   << pIn->trade_dts.month << "-" 
-	   << pIn->trade_dts.day << " " 
-	   << pIn->trade_dts.hour << ":"
-	   << pIn->trade_dts.minute << ":" 
-	   << pIn->trade_dts.second;
-	replace_map[1] = ss.str();
+	replaceTimestamp(1, pIn->trade_dts);
 
 	res = exec(TLF4Q1, 2, paramTypes1, paramValues1, paramLengths1,
-			paramFormats1, 0);
+			paramFormats1, m_iResultFormat);
 
 	pOut->num_trades_found = PQntuples(res);
 	if (pOut->num_trades_found == 0) {
@@ -2213,7 +2092,7 @@ CDBConnectionClientSide::execute(
 		return;
 	}
 
-	pOut->trade_id = atoll(PQgetvalue(res, 0, 0));
+	pOut->trade_id = getInt64(res, 0, 0);
 	uint64_t trade_id = htobe64((uint64_t) pOut->trade_id);
 	PQclear(res);
 
@@ -2238,15 +2117,15 @@ CDBConnectionClientSide::execute(
 	const int paramFormats2[1] = { 1 };
 	const int paramLengths2[1] = { sizeof(uint64_t) };
 
-	res = exec(TLF4Q2, 1, NULL, paramValues2, paramLengths2, paramFormats2, 0);
+	res = exec(TLF4Q2, 1, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 
 	pOut->num_found = PQntuples(res);
 	for (int i = 0; i < pOut->num_found; i++) {
-		pOut->trade_info[i].holding_history_id = atoll(PQgetvalue(res, i, 0));
-		pOut->trade_info[i].holding_history_trade_id
-				= atoll(PQgetvalue(res, i, 1));
-		pOut->trade_info[i].quantity_before = atoi(PQgetvalue(res, i, 2));
-		pOut->trade_info[i].quantity_after = atoi(PQgetvalue(res, i, 3));
+		pOut->trade_info[i].holding_history_id = getInt64(res, i, 0);
+		pOut->trade_info[i].holding_history_trade_id = getInt64(res, i, 1);
+		pOut->trade_info[i].quantity_before = getInt32(res, i, 2);
+		pOut->trade_info[i].quantity_after = getInt32(res, i, 3);
 	}
 	PQclear(res);
 
@@ -2290,7 +2169,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths1[1] = { sizeof(uint64_t) };
 	const int paramFormats1[1] = { 1 };
 
-	res = exec(TOF1Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TOF1Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	pOut->num_found = PQntuples(res);
 	if (pOut->num_found == 0) {
@@ -2298,10 +2178,10 @@ CDBConnectionClientSide::execute(
 		return;
 	}
 
-	strncpy(pOut->acct_name, PQgetvalue(res, 0, 0), cCA_NAME_len);
-	pOut->broker_id = atoll(PQgetvalue(res, 0, 1));
-	pOut->cust_id = atoll(PQgetvalue(res, 0, 2));
-	pOut->tax_status = atoi(PQgetvalue(res, 0, 3));
+	getString(res, 0, 0, pOut->acct_name, cCA_NAME_len);
+	pOut->broker_id = getInt64(res, 0, 1);
+	pOut->cust_id = getInt64(res, 0, 2);
+	pOut->tax_status = getInt32(res, 0, 3);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -2328,13 +2208,14 @@ CDBConnectionClientSide::execute(
 
 	paramValues1[0] = (char *) &cust_id;
 
-	res = exec(TOF1Q2, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TOF1Q2, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	if (PQntuples(res) != 0) {
-		strncpy(pOut->cust_f_name, PQgetvalue(res, 0, 0), cF_NAME_len);
-		strncpy(pOut->cust_l_name, PQgetvalue(res, 0, 1), cL_NAME_len);
-		pOut->cust_tier = atoi(PQgetvalue(res, 0, 2));
-		strncpy(pOut->tax_id, PQgetvalue(res, 0, 3), cTAX_ID_len);
+		getString(res, 0, 0, pOut->cust_f_name, cF_NAME_len);
+		getString(res, 0, 1, pOut->cust_l_name, cL_NAME_len);
+		pOut->cust_tier = getInt32(res, 0, 2);
+		getString(res, 0, 3, pOut->tax_id, cTAX_ID_len);
 	}
 	PQclear(res);
 
@@ -2359,10 +2240,11 @@ CDBConnectionClientSide::execute(
 
 	paramValues1[0] = (char *) &broker_id;
 
-	res = exec(TOF1Q3, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TOF1Q3, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	if (PQntuples(res) != 0) {
-		strncpy(pOut->broker_name, PQgetvalue(res, 0, 0), cB_NAME_len);
+		getString(res, 0, 0, pOut->broker_name, cB_NAME_len);
 	}
 	PQclear(res);
 
@@ -2402,14 +2284,15 @@ CDBConnectionClientSide::execute(
 		sizeof(char) * (cTAX_ID_len + 1) };
 	const int paramFormats[4] = { 1, 0, 0, 0 };
 
-	res = exec(TOF2Q1, 4, NULL, paramValues, paramLengths, paramFormats, 0);
+	res = exec(TOF2Q1, 4, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	strncpy(pOut->ap_acl, PQgetvalue(res, 0, 0), cACL_len);
+	getString(res, 0, 0, pOut->ap_acl, cACL_len);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -2442,14 +2325,14 @@ CDBConnectionClientSide::execute(
 		const int paramFormats1[1] = { 0 };
 
 		res = exec(TOF3Q1A, 1, NULL, paramValues1, paramLengths1,
-				paramFormats1, 0);
+				paramFormats1, m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		co_id = htobe64((uint64_t) atoll(PQgetvalue(res, 0, 0)));
+		co_id = htobe64((uint64_t) getInt64(res, 0, 0));
 		PQclear(res);
 
 #define TOF3Q2A                                                               \
@@ -2472,16 +2355,16 @@ CDBConnectionClientSide::execute(
 		const int paramFormats2[2] = { 1, 0 };
 
 		res = exec(TOF3Q2A, 2, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		strncpy(ex_id, PQgetvalue(res, 0, 0), cEX_ID_len);
-		strncpy(pOut->s_name, PQgetvalue(res, 0, 1), cS_NAME_len);
-		strncpy(pOut->symbol, PQgetvalue(res, 0, 2), cSYMBOL_len);
+		getString(res, 0, 0, ex_id, cEX_ID_len);
+		getString(res, 0, 1, pOut->s_name, cS_NAME_len);
+		getString(res, 0, 2, pOut->symbol, cSYMBOL_len);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -2509,16 +2392,16 @@ CDBConnectionClientSide::execute(
 		const int paramFormats1[1] = { 0 };
 
 		res = exec(TOF3Q1B, 1, NULL, paramValues1, paramLengths1,
-				paramFormats1, 0);
+				paramFormats1, m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		co_id = htobe64((uint64_t) atoll(PQgetvalue(res, 0, 0)));
-		strncpy(ex_id, PQgetvalue(res, 0, 1), cEX_ID_len);
-		strncpy(pOut->s_name, PQgetvalue(res, 0, 2), cS_NAME_len);
+		co_id = htobe64((uint64_t) getInt64(res, 0, 0));
+		getString(res, 0, 1, ex_id, cEX_ID_len);
+		getString(res, 0, 2, pOut->s_name, cS_NAME_len);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -2541,14 +2424,14 @@ CDBConnectionClientSide::execute(
 		const int paramFormats2[1] = { 1 };
 
 		res = exec(TOF3Q2B, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		strncpy(pOut->co_name, PQgetvalue(res, 0, 0), cCO_NAME_len);
+		getString(res, 0, 0, pOut->co_name, cCO_NAME_len);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -2570,14 +2453,15 @@ CDBConnectionClientSide::execute(
 	const int paramLengths3[1] = { sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats3[1] = { 0 };
 
-	res = exec(TOF3Q3, 1, NULL, paramValues3, paramLengths3, paramFormats3, 0);
+	res = exec(TOF3Q3, 1, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->market_price = atof(PQgetvalue(res, 0, 0));
+	pOut->market_price = getDouble(res, 0, 0);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -2599,15 +2483,16 @@ CDBConnectionClientSide::execute(
 	const int paramLengths4[1] = { sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats4[1] = { 0 };
 
-	res = exec(TOF3Q4, 1, NULL, paramValues4, paramLengths4, paramFormats4, 0);
+	res = exec(TOF3Q4, 1, NULL, paramValues4, paramLengths4, paramFormats4,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->type_is_market = PQgetvalue(res, 0, 0)[0] == 't' ? 1 : 0;
-	pOut->type_is_sell = PQgetvalue(res, 0, 1)[0] == 't' ? 1 : 0;
+	pOut->type_is_market = getBool(res, 0, 0) ? 1 : 0;
+	pOut->type_is_sell = getBool(res, 0, 1) ? 1 : 0;
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -2643,12 +2528,13 @@ CDBConnectionClientSide::execute(
 			= { sizeof(uint64_t), sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats5[2] = { 1, 0 };
 
-	res = exec(TOF3Q5, 2, NULL, paramValues5, paramLengths5, paramFormats5, 0);
+	res = exec(TOF3Q5, 2, NULL, paramValues5, paramLengths5, paramFormats5,
+			m_iResultFormat);
 
 	int hs_qty = 0;
 
 	if (PQntuples(res) != 0) {
-		hs_qty = atoi(PQgetvalue(res, 0, 0));
+		hs_qty = getInt32(res, 0, 0);
 	}
 	PQclear(res);
 
@@ -2674,7 +2560,7 @@ CDBConnectionClientSide::execute(
 				}
 
 				res = exec(TOF3Q6A1, 2, NULL, paramValues5, paramLengths5,
-						paramFormats5, 0);
+						paramFormats5, m_iResultFormat);
 			} else {
 #define TOF3Q6A2                                                              \
 	"SELECT h_qty\n"                                                          \
@@ -2691,15 +2577,15 @@ CDBConnectionClientSide::execute(
 				}
 
 				res = exec(TOF3Q6A2, 2, NULL, paramValues5, paramLengths5,
-						paramFormats5, 0);
+						paramFormats5, m_iResultFormat);
 			}
 
 			INT32 hold_qty;
 			double hold_price;
 			int count = PQntuples(res);
 			for (int i = 0; i < count && needed_qty != 0; i++) {
-				hold_qty = atoll(PQgetvalue(res, i, 0));
-				hold_price = atof(PQgetvalue(res, i, 1));
+				hold_qty = getInt64(res, i, 0);
+				hold_price = getDouble(res, i, 1);
 				if (hold_qty > needed_qty) {
 					pOut->buy_value += (double) needed_qty * hold_price;
 					pOut->sell_value
@@ -2737,7 +2623,7 @@ CDBConnectionClientSide::execute(
 				}
 
 				res = exec(TOF3Q6B1, 2, NULL, paramValues5, paramLengths5,
-						paramFormats5, 0);
+						paramFormats5, m_iResultFormat);
 			} else {
 #define TOF3Q6B2                                                              \
 	"SELECT h_qty\n"                                                          \
@@ -2754,15 +2640,15 @@ CDBConnectionClientSide::execute(
 				}
 
 				res = exec(TOF3Q6B2, 2, NULL, paramValues5, paramLengths5,
-						paramFormats5, 0);
+						paramFormats5, m_iResultFormat);
 			}
 
 			INT32 hold_qty;
 			double hold_price;
 			int count = PQntuples(res);
 			for (int i = 0; i < count && needed_qty != 0; i++) {
-				hold_qty = atoll(PQgetvalue(res, i, 0));
-				hold_price = atof(PQgetvalue(res, i, 1));
+				hold_qty = getInt64(res, i, 0);
+				hold_price = getDouble(res, i, 1);
 				if (hold_qty + needed_qty < 0) {
 					pOut->sell_value += (double) needed_qty * hold_price;
 					pOut->buy_value
@@ -2815,7 +2701,7 @@ CDBConnectionClientSide::execute(
 		const int paramFormats7[2] = { 1 };
 
 		res = exec(TOF3Q7, 1, NULL, paramValues7, paramLengths7, paramFormats7,
-				0);
+				m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
@@ -2823,7 +2709,7 @@ CDBConnectionClientSide::execute(
 		}
 
 		pOut->tax_amount = (pOut->sell_value - pOut->buy_value)
-						   * atof(PQgetvalue(res, 0, 0));
+						   * getDouble(res, 0, 0);
 		PQclear(res);
 	}
 
@@ -2858,14 +2744,15 @@ CDBConnectionClientSide::execute(
 				  sizeof(char) * (cEX_ID_len + 1), sizeof(uint32_t) };
 	const int paramFormats8[4] = { 1, 0, 0, 1 };
 
-	res = exec(TOF3Q8, 4, NULL, paramValues8, paramLengths8, paramFormats8, 0);
+	res = exec(TOF3Q8, 4, NULL, paramValues8, paramLengths8, paramFormats8,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->comm_rate = atof(PQgetvalue(res, 0, 0));
+	pOut->comm_rate = getDouble(res, 0, 0);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -2884,14 +2771,15 @@ CDBConnectionClientSide::execute(
 		cout << "$2 = " << pIn->trade_type_id << endl;
 	}
 
-	res = exec(TOF3Q9, 2, NULL, paramValues8, paramLengths8, paramFormats8, 0);
+	res = exec(TOF3Q9, 2, NULL, paramValues8, paramLengths8, paramFormats8,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->charge_amount = atof(PQgetvalue(res, 0, 0));
+	pOut->charge_amount = getDouble(res, 0, 0);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -2914,14 +2802,14 @@ CDBConnectionClientSide::execute(
 		}
 
 		res = exec(TOF3Q10, 1, NULL, paramValues5, paramLengths5,
-				paramFormats5, 0);
+				paramFormats5, m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		acct_bal = atof(PQgetvalue(res, 0, 0));
+		acct_bal = getDouble(res, 0, 0);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -2941,13 +2829,13 @@ CDBConnectionClientSide::execute(
 		}
 
 		res = exec(TOF3Q11, 1, NULL, paramValues5, paramLengths5,
-				paramFormats5, 0);
+				paramFormats5, m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			pOut->acct_assets = acct_bal;
 		}
 
-		pOut->acct_assets = atof(PQgetvalue(res, 0, 0)) + acct_bal;
+		pOut->acct_assets = getDouble(res, 0, 0) + acct_bal;
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -3047,21 +2935,14 @@ CDBConnectionClientSide::execute(
 		sizeof(char) * 14, sizeof(char) * 14, sizeof(unsigned char) };
 	const int paramFormats1[11] = { 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1 };
 
-	if (is_cash) {
-		replace_map[2] = "true";
-	} else {
-		replace_map[2] = "false";
-	}
+	replaceParam(2, is_cash ? "true" : "false");
+	replaceParam(10, is_lifo ? "true" : "false");
 
-	if (is_lifo) {
-		replace_map[10] = "true";
-	} else {
-		replace_map[10] = "false";
-	}
 	res = exec(
-			TOF4Q1, 11, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+			TOF4Q1, 11, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
-	pOut->trade_id = atoll(PQgetvalue(res, 0, 0));
+	pOut->trade_id = getInt64(res, 0, 0);
 	uint64_t trade_id = htobe64((uint64_t) pOut->trade_id);
 	PQclear(res);
 
@@ -3109,7 +2990,7 @@ CDBConnectionClientSide::execute(
 		const int paramFormats2[6] = { 1, 0, 0, 1, 0, 1 };
 
 		res = exec(TOF4Q2, 6, NULL, paramValues2, paramLengths2, paramFormats2,
-				0);
+				m_iResultFormat);
 		PQclear(res);
 	}
 
@@ -3136,7 +3017,8 @@ CDBConnectionClientSide::execute(
 			= { sizeof(uint64_t), sizeof(char) * (cST_ID_len + 1) };
 	const int paramFormats3[2] = { 1, 0 };
 
-	res = exec(TOF4Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3, 0);
+	res = exec(TOF4Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
 	PQclear(res);
 }
 
@@ -3172,7 +3054,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths1[1] = { sizeof(uint64_t) };
 	const int paramFormats1[1] = { 1 };
 
-	res = exec(TRF1Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TRF1Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
@@ -3180,13 +3063,13 @@ CDBConnectionClientSide::execute(
 	}
 
 	pOut->num_found = PQntuples(res);
-	pOut->acct_id = atoll(PQgetvalue(res, 0, 0));
-	strncpy(pOut->type_id, PQgetvalue(res, 0, 1), cTT_ID_len);
-	strncpy(pOut->symbol, PQgetvalue(res, 0, 2), cSYMBOL_len);
-	pOut->trade_qty = atoi(PQgetvalue(res, 0, 3));
-	pOut->charge = atof(PQgetvalue(res, 0, 4));
-	pOut->is_lifo = atoi(PQgetvalue(res, 0, 5));
-	pOut->trade_is_cash = atoi(PQgetvalue(res, 0, 6));
+	pOut->acct_id = getInt64(res, 0, 0);
+	getString(res, 0, 1, pOut->type_id, cTT_ID_len);
+	getString(res, 0, 2, pOut->symbol, cSYMBOL_len);
+	pOut->trade_qty = getInt32(res, 0, 3);
+	pOut->charge = getDouble(res, 0, 4);
+	pOut->is_lifo = getInt32(res, 0, 5);
+	pOut->trade_is_cash = getInt32(res, 0, 6);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -3220,16 +3103,17 @@ CDBConnectionClientSide::execute(
 	const int paramLengths2[1] = { sizeof(char) * (cTT_ID_len + 1) };
 	const int paramFormats2[1] = { 0 };
 
-	res = exec(TRF1Q2, 1, NULL, paramValues2, paramLengths2, paramFormats2, 0);
+	res = exec(TRF1Q2, 1, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	strncpy(pOut->type_name, PQgetvalue(res, 0, 0), cTT_NAME_len);
-	pOut->type_is_sell = atoi(PQgetvalue(res, 0, 1));
-	pOut->type_is_market = atoi(PQgetvalue(res, 0, 2));
+	getString(res, 0, 0, pOut->type_name, cTT_NAME_len);
+	pOut->type_is_sell = getInt32(res, 0, 1);
+	pOut->type_is_market = getInt32(res, 0, 2);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -3257,14 +3141,15 @@ CDBConnectionClientSide::execute(
 			= { sizeof(uint64_t), sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats3[2] = { 1, 0 };
 
-	res = exec(TRF1Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3, 0);
+	res = exec(TRF1Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->hs_qty = atoi(PQgetvalue(res, 0, 0));
+	pOut->hs_qty = getInt32(res, 0, 0);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -3282,11 +3167,7 @@ CDBConnectionClientSide::execute(
 	INT32 needed_qty = pIn->trade_qty;
 
 	res = exec("SELECT CURRENT_TIMESTAMP");
-	sscanf(PQgetvalue(res, 0, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-			&pOut->trade_dts.year, &pOut->trade_dts.month,
-			&pOut->trade_dts.day, &pOut->trade_dts.hour,
-			&pOut->trade_dts.minute, &pOut->trade_dts.second,
-			&pOut->trade_dts.fraction);
+	getTimestamp(res, 0, 0, &pOut->trade_dts);
 	PQclear(res);
 
 #define TRF2Q2                                                                \
@@ -3308,16 +3189,17 @@ CDBConnectionClientSide::execute(
 	const int paramLengths1[1] = { sizeof(uint64_t) };
 	const int paramFormats1[1] = { 1 };
 
-	res = exec(TRF2Q2, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TRF2Q2, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->broker_id = atoll(PQgetvalue(res, 0, 0));
-	pOut->cust_id = atoll(PQgetvalue(res, 0, 1));
-	pOut->tax_status = atoi(PQgetvalue(res, 0, 2));
+	pOut->broker_id = getInt64(res, 0, 0);
+	pOut->cust_id = getInt64(res, 0, 1);
+	pOut->tax_status = getInt32(res, 0, 2);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -3429,7 +3311,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats2[3] = { 1, 0, 1 };
 
 			res = exec(TRF2Q3A, 3, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 			PQclear(res);
 		} else if (pIn->hs_qty != pIn->trade_qty) {
 			uint32_t hs_qty
@@ -3449,7 +3331,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats2[3] = { 1, 1, 0 };
 
 			res = exec(TRF2Q3B, 3, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 			PQclear(res);
 		} else if (pIn->hs_qty > 0) {
 			if (pIn->is_lifo) {
@@ -3464,7 +3346,7 @@ CDBConnectionClientSide::execute(
 				const int paramFormats2[2] = { 1, 0 };
 
 				res = exec(TRF2Q3C1, 2, NULL, paramValues2, paramLengths2,
-						paramFormats2, 0);
+						paramFormats2, m_iResultFormat);
 			} else {
 				if (m_bVerbose) {
 					cout << TRF2Q3C2 << endl;
@@ -3479,7 +3361,7 @@ CDBConnectionClientSide::execute(
 				const int paramFormats2[2] = { 1, 0 };
 
 				res = exec(TRF2Q3C2, 2, NULL, paramValues2, paramLengths2,
-						paramFormats2, 0);
+						paramFormats2, m_iResultFormat);
 			}
 
             PGresult *res2 = NULL;
@@ -3489,9 +3371,9 @@ CDBConnectionClientSide::execute(
 					break;
 
 				uint64_t hold_id
-						= htobe64((uint64_t) atoll(PQgetvalue(res, i, 0)));
-				INT32 hold_qty = atoi(PQgetvalue(res, i, 1));
-				double hold_price = atof(PQgetvalue(res, i, 2));
+						= htobe64((uint64_t) getInt64(res, i, 0));
+				INT32 hold_qty = getInt32(res, i, 1);
+				double hold_price = getDouble(res, i, 2);
 
 				if (m_bVerbose) {
 					cout << "hold_id[" << i << "] = " << hold_id << endl;
@@ -3520,7 +3402,7 @@ CDBConnectionClientSide::execute(
 					const int paramFormats3[4] = { 1, 1, 1, 1 };
 
 					res2 = exec(TRF2Q4, 4, NULL, paramValues3, paramLengths3,
-							paramFormats3, 0);
+							paramFormats3, m_iResultFormat);
 					PQclear(res2);
 
 					if (m_bVerbose) {
@@ -3536,7 +3418,7 @@ CDBConnectionClientSide::execute(
 					const int paramFormats4[2] = { 1, 1 };
 
 					res2 = exec(TRF2Q5, 2, NULL, paramValues4, paramLengths4,
-							paramFormats4, 0);
+							paramFormats4, m_iResultFormat);
 					PQclear(res2);
 
 					pOut->buy_value += (double) needed_qty * hold_price;
@@ -3561,7 +3443,7 @@ CDBConnectionClientSide::execute(
 					const int paramFormats3[4] = { 1, 1, 1, 1 };
 
 					res2 = exec(TRF2Q4, 4, NULL, paramValues3, paramLengths3,
-							paramFormats3, 0);
+							paramFormats3, m_iResultFormat);
 					PQclear(res2);
 
 					if (m_bVerbose) {
@@ -3570,7 +3452,7 @@ CDBConnectionClientSide::execute(
 					}
 
 					res2 = exec(TRF2Q6, 1, NULL, paramValues3, paramLengths3,
-							paramFormats3, 0);
+							paramFormats3, m_iResultFormat);
 					PQclear(res2);
 
 					pOut->buy_value += (double) hold_qty * hold_price;
@@ -3601,7 +3483,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats3[4] = { 1, 1, 1, 1 };
 
 			res = exec(TRF2Q4, 4, NULL, paramValues3, paramLengths3,
-					paramFormats3, 0);
+					paramFormats3, m_iResultFormat);
 			PQclear(res);
 
 			char h_price[14];
@@ -3625,7 +3507,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats6[5] = { 1, 1, 0, 0, 1 };
 
 			res = exec(TRF2Q7, 5, NULL, paramValues6, paramLengths6,
-					paramFormats6, 0);
+					paramFormats6, m_iResultFormat);
 			PQclear(res);
 		} else if (pIn->hs_qty == pIn->trade_qty) {
 			if (m_bVerbose) {
@@ -3640,7 +3522,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats2[2] = { 1, 0 };
 
 			res = exec(TRF2Q8, 2, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 			PQclear(res);
 		}
 	} else {
@@ -3661,7 +3543,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats2[3] = { 1, 0, 1 };
 
 			res = exec(TRF2Q3A, 3, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 			PQclear(res);
 		} else if ((-1 * pIn->hs_qty) != pIn->trade_qty) {
 			uint32_t hs_qty
@@ -3681,7 +3563,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats2[3] = { 1, 1, 0 };
 
 			res = exec(TRF2Q3B, 3, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 			PQclear(res);
 		}
 
@@ -3698,7 +3580,7 @@ CDBConnectionClientSide::execute(
 				const int paramFormats2[2] = { 1, 0 };
 
 				res = exec(TRF2Q3C1, 2, NULL, paramValues2, paramLengths2,
-						paramFormats2, 0);
+						paramFormats2, m_iResultFormat);
 			} else {
 				if (m_bVerbose) {
 					cout << TRF2Q3C2 << endl;
@@ -3713,7 +3595,7 @@ CDBConnectionClientSide::execute(
 				const int paramFormats2[2] = { 1, 0 };
 
 				res = exec(TRF2Q3C2, 2, NULL, paramValues2, paramLengths2,
-						paramFormats2, 0);
+						paramFormats2, m_iResultFormat);
 			}
 
             PGresult *res2 = NULL;
@@ -3723,9 +3605,9 @@ CDBConnectionClientSide::execute(
                     break;
 
 				uint64_t hold_id
-						= htobe64((uint64_t) atoll(PQgetvalue(res, i, 0)));
-				INT32 hold_qty = atoi(PQgetvalue(res, i, 1));
-				double hold_price = atof(PQgetvalue(res, i, 2));
+						= htobe64((uint64_t) getInt64(res, i, 0));
+				INT32 hold_qty = getInt32(res, i, 1);
+				double hold_price = getDouble(res, i, 2);
 
 				if (m_bVerbose) {
 					cout << "hold_id[" << i << "] = " << hold_id << endl;
@@ -3754,7 +3636,7 @@ CDBConnectionClientSide::execute(
 					const int paramFormats3[4] = { 1, 1, 1, 1 };
 
 					res2 = exec(TRF2Q4, 4, NULL, paramValues3, paramLengths3,
-							paramFormats3, 0);
+							paramFormats3, m_iResultFormat);
 					PQclear(res2);
 
 					if (m_bVerbose) {
@@ -3770,7 +3652,7 @@ CDBConnectionClientSide::execute(
 					const int paramFormats4[2] = { 1, 1 };
 
 					res2 = exec(TRF2Q5, 2, NULL, paramValues4, paramLengths4,
-							paramFormats4, 0);
+							paramFormats4, m_iResultFormat);
 					PQclear(res2);
 
 					pOut->sell_value += (double) needed_qty * hold_price;
@@ -3796,7 +3678,7 @@ CDBConnectionClientSide::execute(
 					const int paramFormats3[4] = { 1, 1, 1, 1 };
 
 					res2 = exec(TRF2Q4, 4, NULL, paramValues3, paramLengths3,
-							paramFormats3, 0);
+							paramFormats3, m_iResultFormat);
 					PQclear(res2);
 
 					if (m_bVerbose) {
@@ -3805,7 +3687,7 @@ CDBConnectionClientSide::execute(
 					}
 
 					res2 = exec(TRF2Q6, 1, NULL, paramValues3, paramLengths3,
-							paramFormats3, 0);
+							paramFormats3, m_iResultFormat);
 					PQclear(res2);
 
 					hold_qty *= -1;
@@ -3837,7 +3719,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats3[4] = { 1, 1, 1, 1 };
 
 			res = exec(TRF2Q4, 4, NULL, paramValues3, paramLengths3,
-					paramFormats3, 0);
+					paramFormats3, m_iResultFormat);
 			PQclear(res);
 
 			char h_price[14];
@@ -3861,7 +3743,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats6[5] = { 1, 1, 0, 0, 1 };
 
 			res = exec(TRF2Q7, 5, NULL, paramValues6, paramLengths6,
-					paramFormats6, 0);
+					paramFormats6, m_iResultFormat);
 			PQclear(res);
 		} else if ((-1 * pIn->hs_qty) == pIn->trade_qty) {
 			if (m_bVerbose) {
@@ -3876,7 +3758,7 @@ CDBConnectionClientSide::execute(
 			const int paramFormats2[2] = { 1, 0 };
 
 			res = exec(TRF2Q8, 2, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 			PQclear(res);
 		}
 	}
@@ -3908,7 +3790,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths1[1] = { sizeof(uint64_t) };
 	const int paramFormats1[1] = { 1 };
 
-	res = exec(TRF3Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TRF3Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
@@ -3916,11 +3799,11 @@ CDBConnectionClientSide::execute(
 	}
 
 	if (m_bVerbose) {
-		cout << "sum = " << PQgetvalue(res, 0, 0) << endl;
+		cout << "sum = " << getDouble(res, 0, 0) << endl;
 	}
 
 	pOut->tax_amount
-			= (pIn->sell_value - pIn->buy_value) * atof(PQgetvalue(res, 0, 0));
+			= (pIn->sell_value - pIn->buy_value) * getDouble(res, 0, 0);
 	PQclear(res);
 
 #define TRF3Q2                                                                \
@@ -3942,7 +3825,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths2[2] = { sizeof(char) * 14, sizeof(uint64_t) };
 	const int paramFormats2[2] = { 0, 1 };
 
-	res = exec(TRF3Q2, 2, NULL, paramValues2, paramLengths2, paramFormats2, 0);
+	res = exec(TRF3Q2, 2, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 	PQclear(res);
 }
 
@@ -3967,7 +3851,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths1[1] = { sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats1[1] = { 0 };
 
-	res = exec(TRF4Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1, 0);
+	res = exec(TRF4Q1, 1, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
@@ -3975,8 +3860,8 @@ CDBConnectionClientSide::execute(
 	}
 
 	char ex_id[cEX_ID_len + 1];
-	strncpy(ex_id, PQgetvalue(res, 0, 0), cEX_ID_len);
-	strncpy(pOut->s_name, PQgetvalue(res, 0, 1), cS_NAME_len);
+	getString(res, 0, 0, ex_id, cEX_ID_len);
+	getString(res, 0, 1, pOut->s_name, cS_NAME_len);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -4000,9 +3885,10 @@ CDBConnectionClientSide::execute(
 	const int paramLengths2[1] = { sizeof(uint64_t) };
 	const int paramFormats2[1] = { 1 };
 
-	res = exec(TRF4Q2, 1, NULL, paramValues2, paramLengths2, paramFormats2, 0);
+	res = exec(TRF4Q2, 1, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 
-	uint16_t c_tier = htobe16((uint16_t) atoi(PQgetvalue(res, 0, 0)));
+	uint16_t c_tier = htobe16((uint16_t) getInt32(res, 0, 0));
 	PQclear(res);
 
 	if (PQntuples(res) == 0) {
@@ -4037,14 +3923,15 @@ CDBConnectionClientSide::execute(
 				  sizeof(char) * (cEX_ID_len + 1), sizeof(uint32_t) };
 	const int paramFormats3[4] = { 1, 0, 0, 1 };
 
-	res = exec(TRF4Q3, 4, NULL, paramValues3, paramLengths3, paramFormats3, 0);
+	res = exec(TRF4Q3, 4, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->comm_rate = atof(PQgetvalue(res, 0, 0));
+	pOut->comm_rate = getDouble(res, 0, 0);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -4101,17 +3988,12 @@ CDBConnectionClientSide::execute(const TTradeResultFrame5Input *pIn)
 		sizeof(char) * (cST_ID_len + 1), sizeof(char) * 14, sizeof(uint64_t) };
 	const int paramFormats1[5] = { 0, 1, 0, 0, 1 };
 
-	stringstream ss;
-	ss << pIn->trade_dts.year << "-" 
-	   << pIn->trade_dts.month << "-" 
-	   << pIn->trade_dts.day << " " 
-	   << pIn->trade_dts.hour << ":"
-	   << pIn->trade_dts.minute << ":" 
-	   << pIn->trade_dts.second;
-	replace_map[1] = ss.str();
+	replaceTimestamp(1, pIn->trade_dts);
 
-	res = exec(TRF5Q1, 5, NULL, paramValues1, paramLengths1, paramFormats1, 0);
-	PQclear(res);
+	// None of the changes needs the others.
+	pipeline(PIPELINE_TR5);
+	send(TRF5Q1, 5, NULL, paramValues1, paramLengths1, paramFormats1,
+			m_iResultFormat);
 
 #define TRF5Q2                                                                \
 	"INSERT INTO trade_history(\n"                                            \
@@ -4133,14 +4015,8 @@ CDBConnectionClientSide::execute(const TTradeResultFrame5Input *pIn)
 			 << pIn->trade_dts.minute << ":" << pIn->trade_dts.second << endl;
 		cout << "$3 = " << pIn->st_completed_id << endl;
 	}
-	
-	ss.str("");
-	ss.clear();
 
-	ss << pIn->trade_dts.year << "-" << pIn->trade_dts.month
-			 << "-" << pIn->trade_dts.day << " " << pIn->trade_dts.hour << ":"
-			 << pIn->trade_dts.minute << ":" << pIn->trade_dts.second;
-	replace_map[1] = ss.str();
+	replaceTimestamp(1, pIn->trade_dts);
 
 	const char *paramValues2[3] = { (char *) &trade_id, (char *) &trade_dts,
 		pIn->st_completed_id };
@@ -4148,8 +4024,8 @@ CDBConnectionClientSide::execute(const TTradeResultFrame5Input *pIn)
 		sizeof(char) * (cST_ID_len + 1) };
 	const int paramFormats2[3] = { 1, 1, 0 };
 
-	res = exec(TRF5Q2, 3, NULL, paramValues2, paramLengths2, paramFormats2, 0);
-	PQclear(res);
+	send(TRF5Q2, 3, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 
 #define TRF5Q3                                                                \
 	"UPDATE broker\n"                                                         \
@@ -4169,8 +4045,13 @@ CDBConnectionClientSide::execute(const TTradeResultFrame5Input *pIn)
 	const int paramLengths3[2] = { sizeof(char) * 14, sizeof(uint64_t) };
 	const int paramFormats3[2] = { 0, 1 };
 
-	res = exec(TRF5Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3, 0);
-	PQclear(res);
+	send(TRF5Q3, 2, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
+
+	for (int i = 0; i < 3; i++) {
+		res = receive();
+		PQclear(res);
+	}
 }
 
 void
@@ -4198,12 +4079,10 @@ CDBConnectionClientSide::execute(
 			= { sizeof(uint64_t), sizeof(uint32_t), sizeof(char) * 14 };
 	const int paramFormats1[3] = { 1, 1, 0 };
 
-	stringstream ss;
-	ss << pIn->due_date.year << "-" 
-	   << pIn->due_date.month << "-" 
-	   << pIn->due_date.day;
-	replace_map[1] = ss.str();
+	replaceDate(1, pIn->due_date);
 
+	// The balance is read after the changes, which need nothing back.
+	pipeline(PIPELINE_TR6);
 	if (pIn->trade_is_cash) {
 #define TRF6Q1A                                                               \
 	"INSERT INTO settlement(\n"                                               \
@@ -4226,8 +4105,8 @@ CDBConnectionClientSide::execute(
 			cout << "$3 = " << se_amount << endl;
 		}
 
-		res = exec(TRF6Q1A, 3, paramTypes1, paramValues1, paramLengths1,
-				paramFormats1, 0);
+		send(TRF6Q1A, 3, paramTypes1, paramValues1, paramLengths1,
+				paramFormats1, m_iResultFormat);
 	} else {
 #define TRF6Q1B                                                               \
 	"INSERT INTO settlement(\n"                                               \
@@ -4250,10 +4129,9 @@ CDBConnectionClientSide::execute(
 			cout << "$3 = " << se_amount << endl;
 		}
 
-		res = exec(TRF6Q1B, 3, paramTypes1, paramValues1, paramLengths1,
-				paramFormats1, 0);
+		send(TRF6Q1B, 3, paramTypes1, paramValues1, paramLengths1,
+				paramFormats1, m_iResultFormat);
 	}
-	PQclear(res);
 
 #define TRF6Q2                                                                \
 	"UPDATE customer_account\n"                                               \
@@ -4272,8 +4150,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths2[2] = { sizeof(uint64_t), sizeof(uint64_t) };
 	const int paramFormats2[2] = { 0, 1 };
 
-	res = exec(TRF6Q2, 2, NULL, paramValues2, paramLengths2, paramFormats2, 0);
-	PQclear(res);
+	send(TRF6Q2, 2, NULL, paramValues2, paramLengths2, paramFormats2,
+			m_iResultFormat);
 
 	char ct_name[cCT_NAME_len + 1];
 	snprintf(ct_name, cCT_NAME_len, "%s %d shares of %s", pIn->type_name,
@@ -4320,19 +4198,10 @@ CDBConnectionClientSide::execute(
 		sizeof(uint64_t), sizeof(char) * (cCT_NAME_len + 1) };
 	const int paramFormats3[4] = { 1, 1, 0, 0 };
 
-	ss.str("");
-	ss.clear();
+	replaceTimestamp(0, pIn->trade_dts);
 
-	ss << pIn->trade_dts.year << "-" 
-	   << pIn->trade_dts.month << "-" 
-	   << pIn->trade_dts.day << " " 
-	   << pIn->trade_dts.hour << ":"
-	   << pIn->trade_dts.minute << ":" 
-	   << pIn->trade_dts.second;
-	replace_map[0] = ss.str();
-
-	res = exec(TRF6Q3, 4, NULL, paramValues3, paramLengths3, paramFormats3, 0);
-	PQclear(res);
+	send(TRF6Q3, 4, NULL, paramValues3, paramLengths3, paramFormats3,
+			m_iResultFormat);
 
 #define TRF6Q4                                                                \
 	"SELECT ca_bal\n"                                                         \
@@ -4348,14 +4217,21 @@ CDBConnectionClientSide::execute(
 	const int paramLengths4[1] = { sizeof(uint64_t) };
 	const int paramFormats4[1] = { 1 };
 
-	res = exec(TRF6Q4, 1, NULL, paramValues4, paramLengths4, paramFormats4, 0);
+	send(TRF6Q4, 1, NULL, paramValues4, paramLengths4, paramFormats4,
+			m_iResultFormat);
+
+	for (int i = 0; i < 3; i++) {
+		res = receive();
+		PQclear(res);
+	}
+	res = receive();
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	pOut->acct_bal = atof(PQgetvalue(res, 0, 0));
+	pOut->acct_bal = getDouble(res, 0, 0);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -4404,7 +4280,8 @@ CDBConnectionClientSide::execute(
 	const int paramLengths[1] = { sizeof(uint64_t) };
 	const int paramFormats[1] = { 1 };
 
-	res = exec(TSF1Q1, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+	res = exec(TSF1Q1, 1, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
@@ -4413,20 +4290,16 @@ CDBConnectionClientSide::execute(
 
 	pOut->num_found = PQntuples(res);
 	for (int i = 0; i < pOut->num_found; i++) {
-		pOut->trade_id[i] = atoll(PQgetvalue(res, i, 0));
-		sscanf(PQgetvalue(res, i, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-				&pOut->trade_dts[i].year, &pOut->trade_dts[i].month,
-				&pOut->trade_dts[i].day, &pOut->trade_dts[i].hour,
-				&pOut->trade_dts[i].minute, &pOut->trade_dts[i].second,
-				&pOut->trade_dts[i].fraction);
-		strncpy(pOut->status_name[i], PQgetvalue(res, i, 2), cST_NAME_len);
-		strncpy(pOut->type_name[i], PQgetvalue(res, i, 3), cTT_NAME_len);
-		strncpy(pOut->symbol[i], PQgetvalue(res, i, 4), cSYMBOL_len);
-		pOut->trade_qty[i] = atoll(PQgetvalue(res, i, 5));
-		strncpy(pOut->exec_name[i], PQgetvalue(res, i, 6), cEXEC_NAME_len);
-		pOut->charge[i] = atof(PQgetvalue(res, i, 7));
-		strncpy(pOut->s_name[i], PQgetvalue(res, i, 8), cS_NAME_len);
-		strncpy(pOut->ex_name[i], PQgetvalue(res, i, 9), cEX_NAME_len);
+		pOut->trade_id[i] = getInt64(res, i, 0);
+		getTimestamp(res, i, 1, &pOut->trade_dts[i]);
+		getString(res, i, 2, pOut->status_name[i], cST_NAME_len);
+		getString(res, i, 3, pOut->type_name[i], cTT_NAME_len);
+		getString(res, i, 4, pOut->symbol[i], cSYMBOL_len);
+		pOut->trade_qty[i] = getInt64(res, i, 5);
+		getString(res, i, 6, pOut->exec_name[i], cEXEC_NAME_len);
+		pOut->charge[i] = getDouble(res, i, 7);
+		getString(res, i, 8, pOut->s_name[i], cS_NAME_len);
+		getString(res, i, 9, pOut->ex_name[i], cEX_NAME_len);
 	}
 	PQclear(res);
 
@@ -4467,16 +4340,17 @@ CDBConnectionClientSide::execute(
 		cout << "$1 = " << be64toh(acct_id) << endl;
 	}
 
-	res = exec(TSF1Q2, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+	res = exec(TSF1Q2, 1, NULL, paramValues, paramLengths, paramFormats,
+			m_iResultFormat);
 
 	if (PQntuples(res) == 0) {
 		PQclear(res);
 		return;
 	}
 
-	strncpy(pOut->cust_l_name, PQgetvalue(res, 0, 0), cL_NAME_len);
-	strncpy(pOut->cust_f_name, PQgetvalue(res, 0, 1), cF_NAME_len);
-	strncpy(pOut->broker_name, PQgetvalue(res, 0, 2), cB_NAME_len);
+	getString(res, 0, 0, pOut->cust_l_name, cL_NAME_len);
+	getString(res, 0, 1, pOut->cust_f_name, cF_NAME_len);
+	getString(res, 0, 2, pOut->broker_name, cB_NAME_len);
 	PQclear(res);
 
 	if (m_bVerbose) {
@@ -4515,7 +4389,7 @@ CDBConnectionClientSide::execute(
 			}
 
 			res = exec(TUF1Q1, 1, NULL, paramValues, paramLengths,
-					paramFormats, 0);
+					paramFormats, m_iResultFormat);
 
 			if (PQntuples(res) == 0) {
 				PQclear(res);
@@ -4524,7 +4398,7 @@ CDBConnectionClientSide::execute(
 
 			pOut->num_found += PQntuples(res);
 			char ex_name[cEX_NAME_len + 1];
-			strncpy(ex_name, PQgetvalue(res, 0, 0), cEX_NAME_len);
+			getString(res, 0, 0, ex_name, cEX_NAME_len);
 			PQclear(res);
 
 			if (m_bVerbose) {
@@ -4543,7 +4417,7 @@ CDBConnectionClientSide::execute(
 				}
 
 				res = exec(TUF1Q2A, 1, NULL, paramValues, paramLengths,
-						paramFormats, 0);
+						paramFormats, m_iResultFormat);
 			} else {
 #define TUF1Q2B                                                               \
 	"UPDATE trade\n"                                                          \
@@ -4556,7 +4430,7 @@ CDBConnectionClientSide::execute(
 				}
 
 				res = exec(TUF1Q2B, 1, NULL, paramValues, paramLengths,
-						paramFormats, 0);
+						paramFormats, m_iResultFormat);
 			}
 			PQclear(res);
 
@@ -4584,27 +4458,27 @@ CDBConnectionClientSide::execute(
 		}
 
 		res = exec(
-				TUF1Q3, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				TUF1Q3, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		pOut->trade_info[i].bid_price = atof(PQgetvalue(res, 0, 0));
-		strncpy(pOut->trade_info[i].exec_name, PQgetvalue(res, 0, 1),
-				cEXEC_NAME_len);
-		if (PQgetvalue(res, 0, 2)[0] == 't') {
+		pOut->trade_info[i].bid_price = getDouble(res, 0, 0);
+		getString(res, 0, 1, pOut->trade_info[i].exec_name, cEXEC_NAME_len);
+		if (getBool(res, 0, 2)) {
 			pOut->trade_info[i].is_cash = true;
 		} else {
 			pOut->trade_info[i].is_cash = false;
 		}
-		if (PQgetvalue(res, 0, 3)[0] == 't') {
+		if (getBool(res, 0, 3)) {
 			pOut->trade_info[i].is_market = true;
 		} else {
 			pOut->trade_info[i].is_market = false;
 		}
-		pOut->trade_info[i].trade_price = atof(PQgetvalue(res, 0, 4));
+		pOut->trade_info[i].trade_price = getDouble(res, 0, 4);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -4633,20 +4507,18 @@ CDBConnectionClientSide::execute(
 		}
 
 		res = exec(
-				TUF1Q4, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				TUF1Q4, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		if (PQntuples(res) == 0) {
 			PQclear(res);
 			return;
 		}
 
-		pOut->trade_info[i].settlement_amount = atof(PQgetvalue(res, 0, 0));
-		sscanf(PQgetvalue(res, 0, 1), "%hd-%hd-%hd",
-				&pOut->trade_info[i].settlement_cash_due_date.year,
-				&pOut->trade_info[i].settlement_cash_due_date.month,
-				&pOut->trade_info[i].settlement_cash_due_date.day);
-		strncpy(pOut->trade_info[i].settlement_cash_type,
-				PQgetvalue(res, 0, 2), cSE_CASH_TYPE_len);
+		pOut->trade_info[i].settlement_amount = getDouble(res, 0, 0);
+		getTimestamp(res, 0, 1, &pOut->trade_info[i].settlement_cash_due_date);
+		getString(res, 0, 2, pOut->trade_info[i].settlement_cash_type,
+				cSE_CASH_TYPE_len);
 		PQclear(res);
 
 		if (m_bVerbose) {
@@ -4675,25 +4547,17 @@ CDBConnectionClientSide::execute(
 			}
 
 			res = exec(TUF1Q5, 1, NULL, paramValues, paramLengths,
-					paramFormats, 0);
+					paramFormats, m_iResultFormat);
 
 			if (PQntuples(res) == 0) {
 				PQclear(res);
 				return;
 			}
 
-			pOut->trade_info[i].cash_transaction_amount
-					= atof(PQgetvalue(res, 0, 0));
-			sscanf(PQgetvalue(res, 0, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].cash_transaction_dts.year,
-					&pOut->trade_info[i].cash_transaction_dts.month,
-					&pOut->trade_info[i].cash_transaction_dts.day,
-					&pOut->trade_info[i].cash_transaction_dts.hour,
-					&pOut->trade_info[i].cash_transaction_dts.minute,
-					&pOut->trade_info[i].cash_transaction_dts.second,
-					&pOut->trade_info[i].cash_transaction_dts.fraction);
-			strncpy(pOut->trade_info[i].cash_transaction_name,
-					PQgetvalue(res, 0, 2), cCT_NAME_len);
+			pOut->trade_info[i].cash_transaction_amount = getDouble(res, 0, 0);
+			getTimestamp(res, 0, 1, &pOut->trade_info[i].cash_transaction_dts);
+			getString(res, 0, 2, pOut->trade_info[i].cash_transaction_name,
+					cCT_NAME_len);
 			PQclear(res);
 		}
 
@@ -4728,20 +4592,15 @@ CDBConnectionClientSide::execute(
 		}
 
 		res = exec(
-				TUF1Q6, 1, NULL, paramValues, paramLengths, paramFormats, 0);
+				TUF1Q6, 1, NULL, paramValues, paramLengths, paramFormats,
+				m_iResultFormat);
 
 		int count = PQntuples(res);
 		for (int j = 0; j < count; j++) {
-			sscanf(PQgetvalue(res, j, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].trade_history_dts[j].year,
-					&pOut->trade_info[i].trade_history_dts[j].month,
-					&pOut->trade_info[i].trade_history_dts[j].day,
-					&pOut->trade_info[i].trade_history_dts[j].hour,
-					&pOut->trade_info[i].trade_history_dts[j].minute,
-					&pOut->trade_info[i].trade_history_dts[j].second,
-					&pOut->trade_info[i].trade_history_dts[j].fraction);
-			strncpy(pOut->trade_info[i].trade_history_status_id[j],
-					PQgetvalue(res, j, 1), cTH_ST_ID_len);
+			getTimestamp(res, j, 0, &pOut->trade_info[i].trade_history_dts[j]);
+			getString(res, j, 1,
+					pOut->trade_info[i].trade_history_status_id[j],
+					cTH_ST_ID_len);
 		}
 		PQclear(res);
 
@@ -4834,44 +4693,25 @@ CDBConnectionClientSide::execute(
 		sizeof(uint64_t), sizeof(uint32_t) };
 	const int paramFormats1[4] = { 1, 1, 1, 1 };
 
-	stringstream ss;
-
-	ss << pIn->start_trade_dts.year << "-"
-	   << pIn->start_trade_dts.month << "-" 
-	   << pIn->start_trade_dts.day << " " 
-	   << pIn->start_trade_dts.hour << ":"
-	   << pIn->start_trade_dts.minute << ":"
-	   << pIn->start_trade_dts.second;
-	replace_map[1] = ss.str();
-
-	ss.str("");
-	ss.clear();
-
-	ss << pIn->end_trade_dts.year << "-"
-	   << pIn->end_trade_dts.month << "-" 
-	   << pIn->end_trade_dts.day << " " 
-	   << pIn->end_trade_dts.hour << ":"
-	   << pIn->end_trade_dts.minute << ":" 
-	   << pIn->end_trade_dts.second;
-	replace_map[2] = ss.str();
+	replaceTimestamp(1, pIn->start_trade_dts);
+	replaceTimestamp(2, pIn->end_trade_dts);
 
 	res = exec(TUF2Q1, 4, paramTypes1, paramValues1, paramLengths1,
-			paramFormats1, 0);
+			paramFormats1, m_iResultFormat);
 
 	PGresult *res2 = NULL;
 	pOut->num_updated = 0;
 	pOut->num_found = PQntuples(res);
 	for (int i = 0; i < pOut->num_found; i++) {
-		pOut->trade_info[i].bid_price = atof(PQgetvalue(res, i, 0));
-		strncpy(pOut->trade_info[i].exec_name, PQgetvalue(res, i, 1),
-				cEXEC_NAME_len);
-		if (PQgetvalue(res, 0, 2)[0] == 't') {
+		pOut->trade_info[i].bid_price = getDouble(res, i, 0);
+		getString(res, i, 1, pOut->trade_info[i].exec_name, cEXEC_NAME_len);
+		if (getBool(res, 0, 2)) {
 			pOut->trade_info[i].is_cash = true;
 		} else {
 			pOut->trade_info[i].is_cash = false;
 		}
-		pOut->trade_info[i].trade_id = atoll(PQgetvalue(res, i, 3));
-		pOut->trade_info[i].trade_price = atof(PQgetvalue(res, i, 4));
+		pOut->trade_info[i].trade_id = getInt64(res, i, 3);
+		pOut->trade_info[i].trade_price = getDouble(res, i, 4);
 
 		if (m_bVerbose) {
 			cout << "bid_price[" << i
@@ -4906,9 +4746,9 @@ CDBConnectionClientSide::execute(
 			}
 
 			res2 = exec(TUF2Q2, 1, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 
-			strncpy(cash_type, PQgetvalue(res2, 0, 0), cSE_CASH_TYPE_len);
+			getString(res2, 0, 0, cash_type, cSE_CASH_TYPE_len);
 			PQclear(res2);
 
 			if (m_bVerbose) {
@@ -4929,7 +4769,7 @@ CDBConnectionClientSide::execute(
 					}
 
 					res2 = exec(TUF2Q4A1, 1, NULL, paramValues2, paramLengths2,
-							paramFormats2, 0);
+							paramFormats2, m_iResultFormat);
 				} else {
 #define TUF2Q4A2                                                              \
 	"UPDATE settlement\n"                                                     \
@@ -4942,7 +4782,7 @@ CDBConnectionClientSide::execute(
 					}
 
 					res2 = exec(TUF2Q4A2, 1, NULL, paramValues2, paramLengths2,
-							paramFormats2, 0);
+							paramFormats2, m_iResultFormat);
 				}
 			} else {
 				if (strncmp(cash_type, "Margin Account", cSE_CASH_TYPE_len)
@@ -4958,7 +4798,7 @@ CDBConnectionClientSide::execute(
 					}
 
 					res2 = exec(TUF2Q4B1, 1, NULL, paramValues2, paramLengths2,
-							paramFormats2, 0);
+							paramFormats2, m_iResultFormat);
 				} else {
 #define TUF2Q4B2                                                              \
 	"UPDATE settlement\n"                                                     \
@@ -4972,7 +4812,7 @@ CDBConnectionClientSide::execute(
 				}
 
 				res2 = exec(TUF2Q4B2, 1, NULL, paramValues2, paramLengths2,
-						paramFormats2, 0);
+						paramFormats2, m_iResultFormat);
 			}
 
 			if (m_bVerbose) {
@@ -4995,22 +4835,62 @@ CDBConnectionClientSide::execute(
 			cout << "$1 = " << be64toh(trade_id) << endl;
 		}
 
-		res2 = exec(TUF2Q5, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+		// The settlement, cash transaction and history of the trade are read
+		// together.
+		pipeline(PIPELINE_TU2);
+		send(TUF2Q5, 1, NULL, paramValues2, paramLengths2, paramFormats2,
+				m_iResultFormat);
+		if (pOut->trade_info[i].is_cash) {
+#define TUF2Q6                                                                \
+	"SELECT ct_amt\n"                                                         \
+	"     , ct_dts\n"                                                         \
+	"     , ct_name\n"                                                        \
+	"FROM cash_transaction\n"                                                 \
+	"WHERE ct_t_id = $1"
+
+			if (m_bVerbose) {
+				cout << TUF2Q6 << endl;
+				cout << "$1 = " << be64toh(trade_id) << endl;
+			}
+
+			send(TUF2Q6, 1, NULL, paramValues2, paramLengths2, paramFormats2,
+					m_iResultFormat);
+
+#define TUF2Q7                                                                \
+	"SELECT th_dts\n"                                                         \
+	"     , th_st_id\n"                                                       \
+	"FROM trade_history\n"                                                    \
+	"WHERE th_t_id = $1\n"                                                    \
+	"ORDER BY th_dts\n"                                                       \
+	"LIMIT 3"
+
+			if (m_bVerbose) {
+				cout << TUF2Q7 << endl;
+				cout << "$1 = " << be64toh(trade_id) << endl;
+			}
+
+			send(TUF2Q7, 1, NULL, paramValues2, paramLengths2, paramFormats2,
+					m_iResultFormat);
+		}
 
+		res2 = receive();
 		if (PQntuples(res2) == 0) {
 			PQclear(res2);
+			if (pOut->trade_info[i].is_cash) {
+				for (int j = 0; j < 2; j++) {
+					res2 = receive();
+					PQclear(res2);
+				}
+			}
 			PQclear(res);
 			return;
 		}
 
-		pOut->trade_info[i].settlement_amount = atof(PQgetvalue(res2, 0, 0));
-		sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd",
-				&pOut->trade_info[i].settlement_cash_due_date.year,
-				&pOut->trade_info[i].settlement_cash_due_date.month,
-				&pOut->trade_info[i].settlement_cash_due_date.day);
-		strncpy(pOut->trade_info[i].settlement_cash_type,
-				PQgetvalue(res2, 0, 2), cSE_CASH_TYPE_len);
+		pOut->trade_info[i].settlement_amount = getDouble(res2, 0, 0);
+		getTimestamp(res2, 0, 1,
+				&pOut->trade_info[i].settlement_cash_due_date);
+		getString(res2, 0, 2, pOut->trade_info[i].settlement_cash_type,
+				cSE_CASH_TYPE_len);
 		PQclear(res2);
 
 		if (m_bVerbose) {
@@ -5026,34 +4906,16 @@ CDBConnectionClientSide::execute(
 		}
 
 		if (pOut->trade_info[i].is_cash) {
-#define TUF2Q6                                                                \
-	"SELECT ct_amt\n"                                                         \
-	"     , ct_dts\n"                                                         \
-	"     , ct_name\n"                                                        \
-	"FROM cash_transaction\n"                                                 \
-	"WHERE ct_t_id = $1"
-
-			if (m_bVerbose) {
-				cout << TUF2Q6 << endl;
-				cout << "$1 = " << be64toh(trade_id) << endl;
-			}
-
-			res2 = exec(TUF2Q6, 1, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+			res2 = receive();
 
 			if (PQntuples(res2) > 0) {
 				pOut->trade_info[i].cash_transaction_amount
-						= atof(PQgetvalue(res2, 0, 0));
-				sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-						&pOut->trade_info[i].cash_transaction_dts.year,
-						&pOut->trade_info[i].cash_transaction_dts.month,
-						&pOut->trade_info[i].cash_transaction_dts.day,
-						&pOut->trade_info[i].cash_transaction_dts.hour,
-						&pOut->trade_info[i].cash_transaction_dts.minute,
-						&pOut->trade_info[i].cash_transaction_dts.second,
-						&pOut->trade_info[i].cash_transaction_dts.fraction);
-				strncpy(pOut->trade_info[i].cash_transaction_name,
-						PQgetvalue(res2, 0, 2), cCT_NAME_len);
+						= getDouble(res2, 0, 0);
+				getTimestamp(res2, 0, 1,
+						&pOut->trade_info[i].cash_transaction_dts);
+				getString(res2, 0, 2,
+						pOut->trade_info[i].cash_transaction_name,
+						cCT_NAME_len);
 			}
 			PQclear(res2);
 
@@ -5076,34 +4938,15 @@ CDBConnectionClientSide::execute(
 					 << endl;
 			}
 
-#define TUF2Q7                                                                \
-	"SELECT th_dts\n"                                                         \
-	"     , th_st_id\n"                                                       \
-	"FROM trade_history\n"                                                    \
-	"WHERE th_t_id = $1\n"                                                    \
-	"ORDER BY th_dts\n"                                                       \
-	"LIMIT 3"
-
-			if (m_bVerbose) {
-				cout << TUF2Q7 << endl;
-				cout << "$1 = " << be64toh(trade_id) << endl;
-			}
-
-			res2 = exec(TUF2Q7, 1, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+			res2 = receive();
 
 			int count = PQntuples(res2);
 			for (int j = 0; j < count; j++) {
-				sscanf(PQgetvalue(res2, j, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-						&pOut->trade_info[i].trade_history_dts[j].year,
-						&pOut->trade_info[i].trade_history_dts[j].month,
-						&pOut->trade_info[i].trade_history_dts[j].day,
-						&pOut->trade_info[i].trade_history_dts[j].hour,
-						&pOut->trade_info[i].trade_history_dts[j].minute,
-						&pOut->trade_info[i].trade_history_dts[j].second,
-						&pOut->trade_info[i].trade_history_dts[j].fraction);
-				strncpy(pOut->trade_info[i].trade_history_status_id[j],
-						PQgetvalue(res2, j, 1), cTH_ST_ID_len);
+				getTimestamp(res2, j, 0,
+						&pOut->trade_info[i].trade_history_dts[j]);
+				getString(res2, j, 1,
+						pOut->trade_info[i].trade_history_status_id[j],
+						cTH_ST_ID_len);
 			}
 			PQclear(res2);
 
@@ -5208,57 +5051,27 @@ CDBConnectionClientSide::execute(
 	const int paramFormats1[4] = { 0, 1, 1, 1 };
 	const int paramLengths1[4] = { sizeof(char) * (cSYMBOL_len + 1),
 		sizeof(uint64_t), sizeof(uint64_t), sizeof(uint32_t) };
-	
-	stringstream ss;
-
-	ss << pIn->start_trade_dts.year << "-"
-	   << pIn->start_trade_dts.month << "-" 
-	   << pIn->start_trade_dts.day << " " 
-	   << pIn->start_trade_dts.hour << ":"
-	   << pIn->start_trade_dts.minute << ":"
-	   << pIn->start_trade_dts.second;
-	replace_map[1] = ss.str();
-
-	ss.str("");
-	ss.clear();
-
-	ss << pIn->end_trade_dts.year << "-"
-	   << pIn->end_trade_dts.month << "-" 
-	   << pIn->end_trade_dts.day << " " 
-	   << pIn->end_trade_dts.hour << ":"
-	   << pIn->end_trade_dts.minute << ":" 
-	   << pIn->end_trade_dts.second;
-	replace_map[2] = ss.str();
+
+	replaceTimestamp(1, pIn->start_trade_dts);
+	replaceTimestamp(2, pIn->end_trade_dts);
 
 	res = exec(TUF3Q1, 4, paramTypes1, paramValues1, paramLengths1,
-			paramFormats1, 0);
+			paramFormats1, m_iResultFormat);
 
 	PGresult *res2 = NULL;
 	pOut->num_updated = 0;
 	pOut->num_found = PQntuples(res);
 	for (int i = 0; i < pOut->num_found; i++) {
-		pOut->trade_info[i].acct_id = atoll(PQgetvalue(res, i, 0));
-		strncpy(pOut->trade_info[i].exec_name, PQgetvalue(res, i, 1),
-				cEXEC_NAME_len);
-		pOut->trade_info[i].is_cash
-				= PQgetvalue(res, i, 2)[0] == 't' ? true : false;
-		pOut->trade_info[i].price = atof(PQgetvalue(res, i, 3));
-		pOut->trade_info[i].quantity = atoi(PQgetvalue(res, i, 4));
-		strncpy(pOut->trade_info[i].s_name, PQgetvalue(res, i, 5),
-				cS_NAME_len);
-		sscanf(PQgetvalue(res, i, 6), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-				&pOut->trade_info[i].trade_dts.year,
-				&pOut->trade_info[i].trade_dts.month,
-				&pOut->trade_info[i].trade_dts.day,
-				&pOut->trade_info[i].trade_dts.hour,
-				&pOut->trade_info[i].trade_dts.minute,
-				&pOut->trade_info[i].trade_dts.second,
-				&pOut->trade_info[i].trade_dts.fraction);
-		pOut->trade_info[i].trade_id = atoll(PQgetvalue(res, i, 7));
-		strncpy(pOut->trade_info[i].trade_type, PQgetvalue(res, i, 8),
-				cTT_ID_len);
-		strncpy(pOut->trade_info[i].type_name, PQgetvalue(res, i, 9),
-				cTT_NAME_len);
+		pOut->trade_info[i].acct_id = getInt64(res, i, 0);
+		getString(res, i, 1, pOut->trade_info[i].exec_name, cEXEC_NAME_len);
+		pOut->trade_info[i].is_cash = getBool(res, i, 2);
+		pOut->trade_info[i].price = getDouble(res, i, 3);
+		pOut->trade_info[i].quantity = getInt32(res, i, 4);
+		getString(res, i, 5, pOut->trade_info[i].s_name, cS_NAME_len);
+		getTimestamp(res, i, 6, &pOut->trade_info[i].trade_dts);
+		pOut->trade_info[i].trade_id = getInt64(res, i, 7);
+		getString(res, i, 8, pOut->trade_info[i].trade_type, cTT_ID_len);
+		getString(res, i, 9, pOut->trade_info[i].type_name, cTT_NAME_len);
 
 		if (m_bVerbose) {
 			cout << "acct_id[" << i << "] = " << pOut->trade_info[i].acct_id
@@ -5308,7 +5121,7 @@ CDBConnectionClientSide::execute(
 		const int paramFormats2[1] = { 1 };
 
 		res2 = exec(TUF3Q2, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		if (PQntuples(res2) == 0) {
 			PQclear(res2);
@@ -5316,13 +5129,11 @@ CDBConnectionClientSide::execute(
 			return;
 		}
 
-		pOut->trade_info[i].settlement_amount = atof(PQgetvalue(res2, 0, 0));
-		sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd",
-				&pOut->trade_info[i].settlement_cash_due_date.year,
-				&pOut->trade_info[i].settlement_cash_due_date.month,
-				&pOut->trade_info[i].settlement_cash_due_date.day);
-		strncpy(pOut->trade_info[i].settlement_cash_type,
-				PQgetvalue(res2, 0, 2), cSE_CASH_TYPE_len);
+		pOut->trade_info[i].settlement_amount = getDouble(res2, 0, 0);
+		getTimestamp(res2, 0, 1,
+				&pOut->trade_info[i].settlement_cash_due_date);
+		getString(res2, 0, 2, pOut->trade_info[i].settlement_cash_type,
+				cSE_CASH_TYPE_len);
 		PQclear(res2);
 
 		if (m_bVerbose) {
@@ -5352,9 +5163,9 @@ CDBConnectionClientSide::execute(
 				}
 
 				res2 = exec(TUF3Q3, 1, NULL, paramValues2, paramLengths2,
-						paramFormats2, 0);
+						paramFormats2, m_iResultFormat);
 
-				strncpy(ct_name, PQgetvalue(res2, 0, 0), cCT_NAME_len);
+				getString(res2, 0, 0, ct_name, cCT_NAME_len);
 				PQclear(res2);
 
 				if (m_bVerbose) {
@@ -5391,7 +5202,7 @@ CDBConnectionClientSide::execute(
 				const int paramFormats3[2] = { 0, 1 };
 
 				res2 = exec(TUF3Q4, 2, NULL, paramValues3, paramLengths3,
-						paramFormats3, 0);
+						paramFormats3, m_iResultFormat);
 
 				if (m_bVerbose) {
 					cout << "PQcmdTuples = " << PQcmdTuples(res2) << endl;
@@ -5414,23 +5225,18 @@ CDBConnectionClientSide::execute(
 			}
 
 			res2 = exec(TUF3Q5, 1, NULL, paramValues2, paramLengths2,
-					paramFormats2, 0);
+					paramFormats2, m_iResultFormat);
 
-			strncpy(ct_name, PQgetvalue(res2, 0, 0), cCT_NAME_len);
+			getString(res2, 0, 0, ct_name, cCT_NAME_len);
 
 			if (PQntuples(res2) > 0) {
 				pOut->trade_info[i].cash_transaction_amount
-						= atof(PQgetvalue(res2, 0, 0));
-				sscanf(PQgetvalue(res2, 0, 1), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-						&pOut->trade_info[i].cash_transaction_dts.year,
-						&pOut->trade_info[i].cash_transaction_dts.month,
-						&pOut->trade_info[i].cash_transaction_dts.day,
-						&pOut->trade_info[i].cash_transaction_dts.hour,
-						&pOut->trade_info[i].cash_transaction_dts.minute,
-						&pOut->trade_info[i].cash_transaction_dts.second,
-						&pOut->trade_info[i].cash_transaction_dts.fraction);
-				strncpy(pOut->trade_info[i].cash_transaction_name,
-						PQgetvalue(res2, 0, 2), cCT_NAME_len);
+						= getDouble(res2, 0, 0);
+				getTimestamp(res2, 0, 1,
+						&pOut->trade_info[i].cash_transaction_dts);
+				getString(res2, 0, 2,
+						pOut->trade_info[i].cash_transaction_name,
+						cCT_NAME_len);
 			}
 			PQclear(res2);
 
@@ -5468,20 +5274,15 @@ CDBConnectionClientSide::execute(
 		}
 
 		res2 = exec(TUF3Q6, 1, NULL, paramValues2, paramLengths2,
-				paramFormats2, 0);
+				paramFormats2, m_iResultFormat);
 
 		int count = PQntuples(res2);
 		for (int j = 0; j < count; j++) {
-			sscanf(PQgetvalue(res2, j, 0), "%hd-%hd-%hd %hd:%hd:%hd.%d",
-					&pOut->trade_info[i].trade_history_dts[j].year,
-					&pOut->trade_info[i].trade_history_dts[j].month,
-					&pOut->trade_info[i].trade_history_dts[j].day,
-					&pOut->trade_info[i].trade_history_dts[j].hour,
-					&pOut->trade_info[i].trade_history_dts[j].minute,
-					&pOut->trade_info[i].trade_history_dts[j].second,
-					&pOut->trade_info[i].trade_history_dts[j].fraction);
-			strncpy(pOut->trade_info[i].trade_history_status_id[j],
-					PQgetvalue(res2, j, 1), cTH_ST_ID_len);
+			getTimestamp(res2, j, 0,
+					&pOut->trade_info[i].trade_history_dts[j]);
+			getString(res2, j, 1,
+					pOut->trade_info[i].trade_history_status_id[j],
+					cTH_ST_ID_len);
 		}
 		PQclear(res2);
 
@@ -5504,3 +5305,123 @@ CDBConnectionClientSide::execute(
 	}
 	PQclear(res);
 }
+
+// The statements of the frames above, with the parameter types they pass.
+static const Oid MWF1Q1BTypes[3] = { TEXTOID, INT8OID, INT8OID };
+static const Oid SDF1Types[2] = { INT8OID, INT4OID };
+static const Oid SDF1Q4Types[3] = { TEXTOID, DATEOID, INT4OID };
+static const Oid TLF2Q1Types[4]
+		= { INT8OID, TIMESTAMPOID, TIMESTAMPOID, INT4OID };
+static const Oid TLF3Q1Types[4]
+		= { TEXTOID, TIMESTAMPOID, TIMESTAMPOID, INT4OID };
+static const Oid TLF4Q1Types[2] = { INT8OID, TIMESTAMPOID };
+static const Oid TRF6Q1Types[3] = { INT8OID, DATEOID, NUMERICOID };
+
+const TPreparedStatement CDBConnectionClientSide::Statements[] = {
+	{ "BVF1Q1", BVF1Q1, 0, NULL },
+	{ "CPF1Q1", CPF1Q1, 0, NULL },
+	{ "CPF1Q2", CPF1Q2, 0, NULL },
+	{ "CPF1Q3", CPF1Q3, 0, NULL },
+	{ "CPF2Q1", CPF2Q1, 0, NULL },
+	{ "MWF1Q1A", MWF1Q1A, 0, NULL },
+	{ "MWF1Q1B", MWF1Q1B, 3, MWF1Q1BTypes },
+	{ "MWF1Q1C", MWF1Q1C, 0, NULL },
+	{ "MWF1Q2", MWF1Q2, 0, NULL },
+	{ "MWF1Q3", MWF1Q3, 0, NULL },
+	{ "MWF1Q4", MWF1Q4, 0, NULL },
+	{ "SDF1Q1", SDF1Q1, 0, NULL },
+	{ "SDF1Q2", SDF1Q2, 2, SDF1Types },
+	{ "SDF1Q3", SDF1Q3, 2, SDF1Types },
+	{ "SDF1Q4", SDF1Q4, 3, SDF1Q4Types },
+	{ "SDF1Q5", SDF1Q5, 0, NULL },
+	{ "SDF1Q6A", SDF1Q6A, 2, SDF1Types },
+	{ "SDF1Q6B", SDF1Q6B, 2, SDF1Types },
+	{ "TLF1Q1", TLF1Q1, 0, NULL },
+	{ "TLF1Q2", TLF1Q2, 0, NULL },
+	{ "TLF1Q3", TLF1Q3, 0, NULL },
+	{ "TLF1Q4", TLF1Q4, 0, NULL },
+	{ "TLF2Q1", TLF2Q1, 4, TLF2Q1Types },
+	{ "TLF2Q2", TLF2Q2, 0, NULL },
+	{ "TLF2Q3", TLF2Q3, 0, NULL },
+	{ "TLF2Q4", TLF2Q4, 0, NULL },
+	{ "TLF3Q1", TLF3Q1, 4, TLF3Q1Types },
+	{ "TLF3Q2", TLF3Q2, 0, NULL },
+	{ "TLF3Q3", TLF3Q3, 0, NULL },
+	{ "TLF3Q4", TLF3Q4, 0, NULL },
+	{ "TLF4Q1", TLF4Q1, 2, TLF4Q1Types },
+	{ "TLF4Q2", TLF4Q2, 0, NULL },
+	{ "TOF1Q1", TOF1Q1, 0, NULL },
+	{ "TOF1Q2", TOF1Q2, 0, NULL },
+	{ "TOF1Q3", TOF1Q3, 0, NULL },
+	{ "TOF2Q1", TOF2Q1, 0, NULL },
+	{ "TOF3Q1A", TOF3Q1A, 0, NULL },
+	{ "TOF3Q2A", TOF3Q2A, 0, NULL },
+	{ "TOF3Q1B", TOF3Q1B, 0, NULL },
+	{ "TOF3Q2B", TOF3Q2B, 0, NULL },
+	{ "TOF3Q3", TOF3Q3, 0, NULL },
+	{ "TOF3Q4", TOF3Q4, 0, NULL },
+	{ "TOF3Q5", TOF3Q5, 0, NULL },
+	{ "TOF3Q6A1", TOF3Q6A1, 0, NULL },
+	{ "TOF3Q6A2", TOF3Q6A2, 0, NULL },
+	{ "TOF3Q6B1", TOF3Q6B1, 0, NULL },
+	{ "TOF3Q6B2", TOF3Q6B2, 0, NULL },
+	{ "TOF3Q7", TOF3Q7, 0, NULL },
+	{ "TOF3Q8", TOF3Q8, 0, NULL },
+	{ "TOF3Q9", TOF3Q9, 0, NULL },
+	{ "TOF3Q10", TOF3Q10, 0, NULL },
+	{ "TOF3Q11", TOF3Q11, 0, NULL },
+	{ "TOF4Q1", TOF4Q1, 0, NULL },
+	{ "TOF4Q2", TOF4Q2, 0, NULL },
+	{ "TOF4Q3", TOF4Q3, 0, NULL },
+	{ "TRF1Q1", TRF1Q1, 0, NULL },
+	{ "TRF1Q2", TRF1Q2, 0, NULL },
+	{ "TRF1Q3", TRF1Q3, 0, NULL },
+	{ "TRF2Q2", TRF2Q2, 0, NULL },
+	{ "TRF2Q3A", TRF2Q3A, 0, NULL },
+	{ "TRF2Q3B", TRF2Q3B, 0, NULL },
+	{ "TRF2Q3C1", TRF2Q3C1, 0, NULL },
+	{ "TRF2Q3C2", TRF2Q3C2, 0, NULL },
+	{ "TRF2Q4", TRF2Q4, 0, NULL },
+	{ "TRF2Q5", TRF2Q5, 0, NULL },
+	{ "TRF2Q6", TRF2Q6, 0, NULL },
+	{ "TRF2Q7", TRF2Q7, 0, NULL },
+	{ "TRF2Q8", TRF2Q8, 0, NULL },
+	{ "TRF3Q1", TRF3Q1, 0, NULL },
+	{ "TRF3Q2", TRF3Q2, 0, NULL },
+	{ "TRF4Q1", TRF4Q1, 0, NULL },
+	{ "TRF4Q2", TRF4Q2, 0, NULL },
+	{ "TRF4Q3", TRF4Q3, 0, NULL },
+	{ "TRF5Q1", TRF5Q1, 0, NULL },
+	{ "TRF5Q2", TRF5Q2, 0, NULL },
+	{ "TRF5Q3", TRF5Q3, 0, NULL },
+	{ "TRF6Q1A", TRF6Q1A, 3, TRF6Q1Types },
+	{ "TRF6Q1B", TRF6Q1B, 3, TRF6Q1Types },
+	{ "TRF6Q2", TRF6Q2, 0, NULL },
+	{ "TRF6Q3", TRF6Q3, 0, NULL },
+	{ "TRF6Q4", TRF6Q4, 0, NULL },
+	{ "TSF1Q1", TSF1Q1, 0, NULL },
+	{ "TSF1Q2", TSF1Q2, 0, NULL },
+	{ "TUF1Q1", TUF1Q1, 0, NULL },
+	{ "TUF1Q2A", TUF1Q2A, 0, NULL },
+	{ "TUF1Q2B", TUF1Q2B, 0, NULL },
+	{ "TUF1Q3", TUF1Q3, 0, NULL },
+	{ "TUF1Q4", TUF1Q4, 0, NULL },
+	{ "TUF1Q5", TUF1Q5, 0, NULL },
+	{ "TUF1Q6", TUF1Q6, 0, NULL },
+	{ "TUF2Q1", TUF2Q1, 4, TLF2Q1Types },
+	{ "TUF2Q2", TUF2Q2, 0, NULL },
+	{ "TUF2Q4A1", TUF2Q4A1, 0, NULL },
+	{ "TUF2Q4A2", TUF2Q4A2, 0, NULL },
+	{ "TUF2Q4B1", TUF2Q4B1, 0, NULL },
+	{ "TUF2Q4B2", TUF2Q4B2, 0, NULL },
+	{ "TUF2Q5", TUF2Q5, 0, NULL },
+	{ "TUF2Q6", TUF2Q6, 0, NULL },
+	{ "TUF2Q7", TUF2Q7, 0, NULL },
+	{ "TUF3Q1", TUF3Q1, 4, TLF3Q1Types },
+	{ "TUF3Q2", TUF3Q2, 0, NULL },
+	{ "TUF3Q3", TUF3Q3, 0, NULL },
+	{ "TUF3Q4", TUF3Q4, 0, NULL },
+	{ "TUF3Q5", TUF3Q5, 0, NULL },
+	{ "TUF3Q6", TUF3Q6, 0, NULL },
+	{ NULL, NULL, 0, NULL }
+};
@@ -5,6 +5,8 @@
  * Copyright The DBT-5 Authors
  */
 
+#include <endian.h>
+
 #include <catalog/pg_type_d.h>
 
 #include "DBConnectionServerSide.h"
@@ -21,108 +23,156 @@ bool inline check_count(int should, int is, const char *file, int line)
 	return true;
 }
 
-int inline get_col_num(PGresult *res, const char *col_name)
+CDBConnectionServerSide::CDBConnectionServerSide(const char *szHost,
+		const char *szDBName, const char *szDBPort, bool bVerbose)
+: CDBConnection(szHost, szDBName, szDBPort, bVerbose)
+{
+	addStatements(CDBConnection::Statements);
+	addStatements(Statements);
+}
+
+CDBConnectionServerSide::~CDBConnectionServerSide() {}
+
+// Number of a column of res.  The stored functions always return the same
+// columns, so the number found last time is checked before searching.
+int
+CDBConnectionServerSide::column(PGresult *res, const char *name)
 {
-	int col_num = PQfnumber(res, col_name);
+	std::unordered_map<const char *, int>::iterator it = m_Columns.find(name);
+	if (it != m_Columns.end() && it->second < PQnfields(res)
+			&& strcmp(PQfname(res, it->second), name) == 0)
+		return it->second;
+
+	int col_num = PQfnumber(res, name);
 	if (col_num == -1) {
-		cerr << "ERROR: column " << col_name << " not found" << endl;
+		cerr << "ERROR: column " << name << " not found" << endl;
 		exit(1);
 	}
+	m_Columns[name] = col_num;
 	return col_num;
 }
 
-void inline TokenizeArray2(const string &str2, vector<string> &tokens)
+// A 32-bit integer in the network byte order of the binary formats.
+static void
+appendInt32(string &buffer, uint32_t value)
 {
-	// This is essentially an empty array. i.e. '()'
-	if (str2.size() < 3)
-		return;
-
-	// We only call this function because we need to chop up arrays that
-	// are in the format '{(1,2,3),(a,b,c)}', so trim off the braces.
-	string str = str2.substr(1, str2.size() - 2);
+	value = htobe32(value);
+	buffer.append((const char *) &value, sizeof(value));
+}
 
-	// Skip delimiters at beginning.
-	string::size_type lastPos = str.find_first_of("(", 0);
-	// Find first "non-delimiter".
-	string::size_type pos = str.find_first_of(")", lastPos);
+// Start m_Array as a one-dimensional array of n elements of type element,
+// without NULLs, in the binary format read by array_recv().  Each element
+// then follows as its length and its own binary format.
+void
+CDBConnectionServerSide::beginArray(Oid element, int n)
+{
+	m_Array.clear();
+	appendInt32(m_Array, 1); // dimensions
+	appendInt32(m_Array, 0); // no NULLs
+	appendInt32(m_Array, element);
+	appendInt32(m_Array, n);
+	appendInt32(m_Array, 1); // lower bound
+}
 
-	while (string::npos != pos || string::npos != lastPos) {
-		// Found a token, add it to the vector.
-		tokens.push_back(str.substr(lastPos, pos - lastPos + 1));
+// The first n values as a binary bigint[] parameter of length, captured as
+// the text of the array for param.
+const char *
+CDBConnectionServerSide::int8Array(
+		int param, const TTrade *values, int n, int *length)
+{
+	beginArray(INT8OID, n);
+	for (int i = 0; i < n; i++) {
+		uint64_t value = htobe64((uint64_t) values[i]);
+		appendInt32(m_Array, sizeof(value));
+		m_Array.append((const char *) &value, sizeof(value));
+	}
 
-		lastPos = str.find_first_of("(", pos);
-		pos = str.find_first_of(")", lastPos);
+	if (capturing(CAPTURE_PARAMS)) {
+		ostringstream osText;
+		osText << "{";
+		for (int i = 0; i < n; i++)
+			osText << (i > 0 ? "," : "") << values[i];
+		osText << "}";
+		replaceParam(param, osText.str().c_str());
 	}
+
+	*length = m_Array.size();
+	return m_Array.data();
 }
 
-// String Tokenizer
-// FIXME: This token doesn't handle strings with escaped characters.
-void inline TokenizeSmart(const string &str, vector<string> &tokens)
+// The first n strings, each stride apart from the previous one, as a binary
+// text[] parameter of length, captured as the text of the array for param.
+const char *
+CDBConnectionServerSide::textArray(
+		int param, const char *values, size_t stride, int n, int *length)
 {
-	// This is essentially an empty array. i.e. '{}'
-	if (str.size() < 3)
-		return;
-
-	string::size_type lastPos = 1;
-	string::size_type pos = 1;
-	bool end = false;
-	while (end == false) {
-		if (str[lastPos] == '"') {
-			pos = str.find_first_of("\"", lastPos + 1);
-			if (pos == string::npos) {
-				pos = str.find_first_of("}", lastPos);
-				end = true;
-			}
-			tokens.push_back(str.substr(lastPos + 1, pos - lastPos - 1));
-			lastPos = pos + 2;
-		} else if (str[lastPos] == '\0') {
-			return;
-		} else {
-			pos = str.find_first_of(",", lastPos);
-			if (pos == string::npos) {
-				pos = str.find_first_of("}", lastPos);
-				end = true;
+	beginArray(TEXTOID, n);
+	for (int i = 0; i < n; i++) {
+		const char *value = values + i * stride;
+		size_t valueLength = strnlen(value, stride);
+		appendInt32(m_Array, valueLength);
+		m_Array.append(value, valueLength);
+	}
+
+	if (capturing(CAPTURE_PARAMS)) {
+		string text = "{";
+		for (int i = 0; i < n; i++) {
+			const char *value = values + i * stride;
+			text += i > 0 ? ",\"" : "\"";
+			for (size_t j = 0; j < stride && value[j] != '\0'; j++) {
+				if (value[j] == '"' || value[j] == '\\')
+					text += '\\';
+				text += value[j];
 			}
-			tokens.push_back(str.substr(lastPos, pos - lastPos));
-			lastPos = pos + 1;
+			text += '"';
 		}
+		text += "}";
+		replaceParam(param, text.c_str());
 	}
+
+	*length = m_Array.size();
+	return m_Array.data();
 }
 
-CDBConnectionServerSide::CDBConnectionServerSide(const char *szHost,
-		const char *szDBName, const char *szDBPort, bool bVerbose)
-: CDBConnection(szHost, szDBName, szDBPort, bVerbose)
+// Each frame is a call to its stored function, except for Market Feed and
+// Trade Cleanup which are never committed with a frame.
+bool
+CDBConnectionServerSide::framesAreOneStatement()
 {
+	return true;
 }
 
-CDBConnectionServerSide::~CDBConnectionServerSide() {}
-
 void
 CDBConnectionServerSide::execute(
 		const TBrokerVolumeFrame1Input *pIn, TBrokerVolumeFrame1Output *pOut)
 {
-	ostringstream osBrokers;
-	int i = 0;
-	osBrokers << pIn->broker_list[i];
-	for (i = 1; pIn->broker_list[i][0] != '\0' && i < max_broker_list_len;
-			i++) {
-		osBrokers << ", " << pIn->broker_list[i];
-	}
+	int n = 0;
+	while (n < max_broker_list_len && pIn->broker_list[n][0] != '\0')
+		n++;
 
-	ostringstream osSQL;
-	osSQL << "SELECT * FROM BrokerVolumeFrame1('{" << osBrokers.str() << "}','"
-		  << pIn->sector_name << "')";
+	int brokersLength;
+	const char *brokers = textArray(0, pIn->broker_list[0],
+			sizeof(pIn->broker_list[0]), n, &brokersLength);
 
-	PGresult *res = exec(osSQL.str().c_str());
-	int i_broker_name = get_col_num(res, "broker_name");
-	int i_list_len = get_col_num(res, "list_len");
-	int i_volume = get_col_num(res, "volume");
+	const Oid paramTypes[2] = { TEXTARRAYOID, TEXTOID };
+	const char *paramValues[2] = { brokers, pIn->sector_name };
+	const int paramLengths[2]
+			= { brokersLength, sizeof(char) * (cSC_NAME_len + 1) };
+	const int paramFormats[2] = { 1, 0 };
+
+#define BVF1 "SELECT * FROM BrokerVolumeFrame1($1::VARCHAR[], $2)"
+
+	PGresult *res = exec(BVF1, 2, paramTypes, paramValues, paramLengths,
+			paramFormats, 0);
+	int i_broker_name = column(res, "broker_name");
+	int i_list_len = column(res, "list_len");
+	int i_volume = column(res, "volume");
 
 	pOut->list_len = atoi(PQgetvalue(res, 0, i_list_len));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_broker_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_broker_name), vAux);
 	for (size_t j = 0; j < vAux.size(); ++j) {
 		strncpy(pOut->broker_name[j], vAux[j].c_str(), cB_NAME_len);
 		pOut->broker_name[j][cB_NAME_len] = '\0';
@@ -130,7 +180,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->list_len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_volume), vAux);
+	splitArray(PQgetvalue(res, 0, i_volume), vAux);
 	for (size_t j = 0; j < vAux.size(); ++j) {
 		pOut->volume[j] = atof(vAux[j].c_str());
 	}
@@ -150,50 +200,52 @@ CDBConnectionServerSide::execute(const TCustomerPositionFrame1Input *pIn,
 			= { sizeof(uint64_t), sizeof(char) * (cTAX_ID_len + 1) };
 	const int paramFormats[2] = { 1, 0 };
 
-	PGresult *res = exec("SELECT * FROM CustomerPositionFrame1($1, $2)", 2,
-			NULL, paramValues, paramLengths, paramFormats, 0);
-
-	int i_cust_id = get_col_num(res, "cust_id");
-	int i_acct_id = get_col_num(res, "acct_id");
-	int i_acct_len = get_col_num(res, "acct_len");
-	int i_asset_total = get_col_num(res, "asset_total");
-	int i_c_ad_id = get_col_num(res, "c_ad_id");
-	int i_c_area_1 = get_col_num(res, "c_area_1");
-	int i_c_area_2 = get_col_num(res, "c_area_2");
-	int i_c_area_3 = get_col_num(res, "c_area_3");
-	int i_c_ctry_1 = get_col_num(res, "c_ctry_1");
-	int i_c_ctry_2 = get_col_num(res, "c_ctry_2");
-	int i_c_ctry_3 = get_col_num(res, "c_ctry_3");
-	int i_c_dob = get_col_num(res, "c_dob");
-	int i_c_email_1 = get_col_num(res, "c_email_1");
-	int i_c_email_2 = get_col_num(res, "c_email_2");
-	int i_c_ext_1 = get_col_num(res, "c_ext_1");
-	int i_c_ext_2 = get_col_num(res, "c_ext_2");
-	int i_c_ext_3 = get_col_num(res, "c_ext_3");
-	int i_c_f_name = get_col_num(res, "c_f_name");
-	int i_c_gndr = get_col_num(res, "c_gndr");
-	int i_c_l_name = get_col_num(res, "c_l_name");
-	int i_c_local_1 = get_col_num(res, "c_local_1");
-	int i_c_local_2 = get_col_num(res, "c_local_2");
-	int i_c_local_3 = get_col_num(res, "c_local_3");
-	int i_c_m_name = get_col_num(res, "c_m_name");
-	int i_c_st_id = get_col_num(res, "c_st_id");
-	int i_c_tier = get_col_num(res, "c_tier");
-	int i_cash_bal = get_col_num(res, "cash_bal");
+#define CPF1 "SELECT * FROM CustomerPositionFrame1($1, $2)"
+
+	PGresult *res = exec(CPF1, 2, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_cust_id = column(res, "cust_id");
+	int i_acct_id = column(res, "acct_id");
+	int i_acct_len = column(res, "acct_len");
+	int i_asset_total = column(res, "asset_total");
+	int i_c_ad_id = column(res, "c_ad_id");
+	int i_c_area_1 = column(res, "c_area_1");
+	int i_c_area_2 = column(res, "c_area_2");
+	int i_c_area_3 = column(res, "c_area_3");
+	int i_c_ctry_1 = column(res, "c_ctry_1");
+	int i_c_ctry_2 = column(res, "c_ctry_2");
+	int i_c_ctry_3 = column(res, "c_ctry_3");
+	int i_c_dob = column(res, "c_dob");
+	int i_c_email_1 = column(res, "c_email_1");
+	int i_c_email_2 = column(res, "c_email_2");
+	int i_c_ext_1 = column(res, "c_ext_1");
+	int i_c_ext_2 = column(res, "c_ext_2");
+	int i_c_ext_3 = column(res, "c_ext_3");
+	int i_c_f_name = column(res, "c_f_name");
+	int i_c_gndr = column(res, "c_gndr");
+	int i_c_l_name = column(res, "c_l_name");
+	int i_c_local_1 = column(res, "c_local_1");
+	int i_c_local_2 = column(res, "c_local_2");
+	int i_c_local_3 = column(res, "c_local_3");
+	int i_c_m_name = column(res, "c_m_name");
+	int i_c_st_id = column(res, "c_st_id");
+	int i_c_tier = column(res, "c_tier");
+	int i_cash_bal = column(res, "cash_bal");
 
 	pOut->acct_len = atoi(PQgetvalue(res, 0, i_acct_len));
 	pOut->cust_id = atoll(PQgetvalue(res, 0, i_cust_id));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_acct_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_acct_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->acct_id[i] = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->acct_len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_asset_total), vAux);
+	splitArray(PQgetvalue(res, 0, i_asset_total), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->asset_total[i] = atof(vAux[i].c_str());
 	}
@@ -251,7 +303,7 @@ CDBConnectionServerSide::execute(const TCustomerPositionFrame1Input *pIn,
 	pOut->c_st_id[cST_ID_len] = '\0';
 	strncpy(&pOut->c_tier, PQgetvalue(res, 0, i_c_tier), 1);
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_bal), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_bal), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->cash_bal[i] = atof(vAux[i].c_str());
 	}
@@ -270,21 +322,23 @@ CDBConnectionServerSide::execute(const TCustomerPositionFrame2Input *pIn,
 	const int paramLengths[1] = { sizeof(uint64_t) };
 	const int paramFormats[1] = { 1 };
 
-	PGresult *res = exec("SELECT * FROM CustomerPositionFrame2($1)", 1, NULL,
-			paramValues, paramLengths, paramFormats, 0);
+#define CPF2 "SELECT * FROM CustomerPositionFrame2($1)"
+
+	PGresult *res = exec(CPF2, 1, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
-	int i_hist_dts = get_col_num(res, "hist_dts");
-	int i_hist_len = get_col_num(res, "hist_len");
-	int i_qty = get_col_num(res, "qty");
-	int i_symbol = get_col_num(res, "symbol");
-	int i_trade_id = get_col_num(res, "trade_id");
-	int i_trade_status = get_col_num(res, "trade_status");
+	int i_hist_dts = column(res, "hist_dts");
+	int i_hist_len = column(res, "hist_len");
+	int i_qty = column(res, "qty");
+	int i_symbol = column(res, "symbol");
+	int i_trade_id = column(res, "trade_id");
+	int i_trade_status = column(res, "trade_status");
 
 	pOut->hist_len = atoi(PQgetvalue(res, 0, i_hist_len));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_hist_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_hist_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->hist_dts[i].year, &pOut->hist_dts[i].month,
@@ -294,14 +348,14 @@ CDBConnectionServerSide::execute(const TCustomerPositionFrame2Input *pIn,
 	check_count(pOut->hist_len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_qty), vAux);
+	splitArray(PQgetvalue(res, 0, i_qty), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->qty[i] = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->hist_len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_symbol), vAux);
+	splitArray(PQgetvalue(res, 0, i_symbol), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->symbol[i], vAux[i].c_str(), cSYMBOL_len);
 		pOut->symbol[i][cSYMBOL_len] = '\0';
@@ -309,14 +363,14 @@ CDBConnectionServerSide::execute(const TCustomerPositionFrame2Input *pIn,
 	check_count(pOut->hist_len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_id[i] = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->hist_len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_status), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_status), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_status[i], vAux[i].c_str(), cST_NAME_len);
 		pOut->trade_status[i][cST_NAME_len] = '\0';
@@ -344,9 +398,11 @@ CDBConnectionServerSide::execute(const TDataMaintenanceFrame1Input *pIn)
 		sizeof(uint32_t) };
 	const int paramFormats[8] = { 1, 1, 1, 1, 0, 0, 0, 1 };
 
-	PGresult *res = exec("SELECT * FROM DataMaintenanceFrame1($1, $2, $3, $4, "
-						 "$5, $6, $7, $8)",
-			8, NULL, paramValues, paramLengths, paramFormats, 0);
+#define DMF1                                                                  \
+	"SELECT * FROM DataMaintenanceFrame1($1, $2, $3, $4, $5, $6, $7, $8)"
+
+	PGresult *res = exec(DMF1, 8, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 	PQclear(res);
 }
 
@@ -377,15 +433,12 @@ CDBConnectionServerSide::execute(
 		sizeof(uint64_t) };
 	const int paramFormats[6] = { 1, 1, 1, 0, 1, 1 };
 
-	stringstream ss;
-	ss << pIn->start_day.year << "-" 
-	   << pIn->start_day.month << "-" 
-	   << pIn->start_day.day;
-	replace_map[4] = ss.str();
+	replaceDate(4, pIn->start_day);
+
+#define MWF1 "SELECT * FROM MarketWatchFrame1($1, $2, $3, $4, $5, $6)"
 
-	PGresult *res
-			= exec("SELECT * FROM MarketWatchFrame1($1, $2, $3, $4, $5, $6)",
-					6, paramTypes, paramValues, paramLengths, paramFormats, 0);
+	PGresult *res = exec(MWF1, 6, paramTypes, paramValues, paramLengths,
+			paramFormats, 0);
 
 	pOut->pct_change = atof(PQgetvalue(res, 0, 0));
 	PQclear(res);
@@ -414,60 +467,58 @@ CDBConnectionServerSide::execute(const TSecurityDetailFrame1Input *pIn,
 		sizeof(uint32_t), sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats[4] = { 1, 1, 1, 0 };
 
-	stringstream ss;
-	ss << pIn->start_day.year << "-" 
-	   << pIn->start_day.month << "-" 
-	   << pIn->start_day.day;
-	replace_map[2] = ss.str();
-
-	PGresult *res = exec("SELECT * FROM SecurityDetailFrame1($1, $2, $3, $4)",
-			4, paramTypes, paramValues, paramLengths, paramFormats, 0);
-
-	int i_s52_wk_high = get_col_num(res, "x52_wk_high");
-	int i_s52_wk_high_date = get_col_num(res, "x52_wk_high_date");
-	int i_s52_wk_low = get_col_num(res, "x52_wk_low");
-	int i_s52_wk_low_date = get_col_num(res, "x52_wk_low_date");
-	int i_ceo_name = get_col_num(res, "ceo_name");
-	int i_co_ad_cty = get_col_num(res, "co_ad_ctry");
-	int i_co_ad_div = get_col_num(res, "co_ad_div");
-	int i_co_ad_line1 = get_col_num(res, "co_ad_line1");
-	int i_co_ad_line2 = get_col_num(res, "co_ad_line2");
-	int i_co_ad_town = get_col_num(res, "co_ad_town");
-	int i_co_ad_zip = get_col_num(res, "co_ad_zip");
-	int i_co_desc = get_col_num(res, "co_desc");
-	int i_co_name = get_col_num(res, "co_name");
-	int i_co_st_id = get_col_num(res, "co_st_id");
-	int i_cp_co_name = get_col_num(res, "cp_co_name");
-	int i_cp_in_name = get_col_num(res, "cp_in_name");
-	int i_day = get_col_num(res, "day");
-	int i_day_len = get_col_num(res, "day_len");
-	int i_divid = get_col_num(res, "divid");
-	int i_ex_ad_cty = get_col_num(res, "ex_ad_ctry");
-	int i_ex_ad_div = get_col_num(res, "ex_ad_div");
-	int i_ex_ad_line1 = get_col_num(res, "ex_ad_line1");
-	int i_ex_ad_line2 = get_col_num(res, "ex_ad_line2");
-	int i_ex_ad_town = get_col_num(res, "ex_ad_town");
-	int i_ex_ad_zip = get_col_num(res, "ex_ad_zip");
-	int i_ex_close = get_col_num(res, "ex_close");
-	int i_ex_date = get_col_num(res, "ex_date");
-	int i_ex_desc = get_col_num(res, "ex_desc");
-	int i_ex_name = get_col_num(res, "ex_name");
-	int i_ex_num_symb = get_col_num(res, "ex_num_symb");
-	int i_ex_open = get_col_num(res, "ex_open");
-	int i_fin = get_col_num(res, "fin");
-	int i_fin_len = get_col_num(res, "fin_len");
-	int i_last_open = get_col_num(res, "last_open");
-	int i_last_price = get_col_num(res, "last_price");
-	int i_last_vol = get_col_num(res, "last_vol");
-	int i_news = get_col_num(res, "news");
-	int i_news_len = get_col_num(res, "news_len");
-	int i_num_out = get_col_num(res, "num_out");
-	int i_open_date = get_col_num(res, "open_date");
-	int i_pe_ratio = get_col_num(res, "pe_ratio");
-	int i_s_name = get_col_num(res, "s_name");
-	int i_sp_rate = get_col_num(res, "sp_rate");
-	int i_start_date = get_col_num(res, "start_date");
-	int i_yield = get_col_num(res, "yield");
+	replaceDate(2, pIn->start_day);
+
+#define SDF1 "SELECT * FROM SecurityDetailFrame1($1, $2, $3, $4)"
+
+	PGresult *res = exec(SDF1, 4, paramTypes, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_s52_wk_high = column(res, "x52_wk_high");
+	int i_s52_wk_high_date = column(res, "x52_wk_high_date");
+	int i_s52_wk_low = column(res, "x52_wk_low");
+	int i_s52_wk_low_date = column(res, "x52_wk_low_date");
+	int i_ceo_name = column(res, "ceo_name");
+	int i_co_ad_cty = column(res, "co_ad_ctry");
+	int i_co_ad_div = column(res, "co_ad_div");
+	int i_co_ad_line1 = column(res, "co_ad_line1");
+	int i_co_ad_line2 = column(res, "co_ad_line2");
+	int i_co_ad_town = column(res, "co_ad_town");
+	int i_co_ad_zip = column(res, "co_ad_zip");
+	int i_co_desc = column(res, "co_desc");
+	int i_co_name = column(res, "co_name");
+	int i_co_st_id = column(res, "co_st_id");
+	int i_cp_co_name = column(res, "cp_co_name");
+	int i_cp_in_name = column(res, "cp_in_name");
+	int i_day = column(res, "day");
+	int i_day_len = column(res, "day_len");
+	int i_divid = column(res, "divid");
+	int i_ex_ad_cty = column(res, "ex_ad_ctry");
+	int i_ex_ad_div = column(res, "ex_ad_div");
+	int i_ex_ad_line1 = column(res, "ex_ad_line1");
+	int i_ex_ad_line2 = column(res, "ex_ad_line2");
+	int i_ex_ad_town = column(res, "ex_ad_town");
+	int i_ex_ad_zip = column(res, "ex_ad_zip");
+	int i_ex_close = column(res, "ex_close");
+	int i_ex_date = column(res, "ex_date");
+	int i_ex_desc = column(res, "ex_desc");
+	int i_ex_name = column(res, "ex_name");
+	int i_ex_num_symb = column(res, "ex_num_symb");
+	int i_ex_open = column(res, "ex_open");
+	int i_fin = column(res, "fin");
+	int i_fin_len = column(res, "fin_len");
+	int i_last_open = column(res, "last_open");
+	int i_last_price = column(res, "last_price");
+	int i_last_vol = column(res, "last_vol");
+	int i_news = column(res, "news");
+	int i_news_len = column(res, "news_len");
+	int i_num_out = column(res, "num_out");
+	int i_open_date = column(res, "open_date");
+	int i_pe_ratio = column(res, "pe_ratio");
+	int i_s_name = column(res, "s_name");
+	int i_sp_rate = column(res, "sp_rate");
+	int i_start_date = column(res, "start_date");
+	int i_yield = column(res, "yield");
 
 	pOut->fin_len = atoi(PQgetvalue(res, 0, i_fin_len));
 	pOut->day_len = atoi(PQgetvalue(res, 0, i_day_len));
@@ -505,9 +556,9 @@ CDBConnectionServerSide::execute(const TSecurityDetailFrame1Input *pIn,
 	strncpy(pOut->co_st_id, PQgetvalue(res, 0, i_co_st_id), cST_ID_len);
 	pOut->co_st_id[cST_ID_len] = '\0';
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cp_co_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cp_co_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->cp_co_name[i], vAux[i].c_str(), cCO_NAME_len);
 		pOut->cp_co_name[i][cCO_NAME_len] = '\0';
@@ -517,7 +568,7 @@ CDBConnectionServerSide::execute(const TSecurityDetailFrame1Input *pIn,
 	check_count(3, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cp_in_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cp_in_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->cp_in_name[i], vAux[i].c_str(), cIN_NAME_len);
 		pOut->cp_in_name[i][cIN_NAME_len] = '\0';
@@ -528,12 +579,12 @@ CDBConnectionServerSide::execute(const TSecurityDetailFrame1Input *pIn,
 	check_count(3, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeArray2(PQgetvalue(res, 0, i_day), vAux);
+	splitArray(PQgetvalue(res, 0, i_day), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
-		vector<string> v2;
-		vector<string>::iterator p2;
+		vector<TArrayElement> &v2 = m_Fields;
+		vector<TArrayElement>::iterator p2;
 
-		TokenizeSmart(vAux[i].c_str(), v2);
+		splitRecord(vAux[i].text, v2);
 
 		p2 = v2.begin();
 		sscanf((*p2++).c_str(), "%hd-%hd-%hd", &pOut->day[i].date.year,
@@ -573,12 +624,12 @@ CDBConnectionServerSide::execute(const TSecurityDetailFrame1Input *pIn,
 	pOut->ex_num_symb = atoi(PQgetvalue(res, 0, i_ex_num_symb));
 	pOut->ex_open = atoi(PQgetvalue(res, 0, i_ex_open));
 
-	TokenizeArray2(PQgetvalue(res, 0, i_fin), vAux);
+	splitArray(PQgetvalue(res, 0, i_fin), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
-		vector<string> v2;
-		vector<string>::iterator p2;
+		vector<TArrayElement> &v2 = m_Fields;
+		vector<TArrayElement>::iterator p2;
 
-		TokenizeSmart(vAux[i].c_str(), v2);
+		splitRecord(vAux[i].text, v2);
 
 		p2 = v2.begin();
 		pOut->fin[i].year = atoi((*p2++).c_str());
@@ -604,12 +655,12 @@ CDBConnectionServerSide::execute(const TSecurityDetailFrame1Input *pIn,
 	pOut->last_price = atof(PQgetvalue(res, 0, i_last_price));
 	pOut->last_vol = atoi(PQgetvalue(res, 0, i_last_vol));
 
-	TokenizeArray2(PQgetvalue(res, 0, i_news), vAux);
+	splitArray(PQgetvalue(res, 0, i_news), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
-		vector<string> v2;
-		vector<string>::iterator p2;
+		vector<TArrayElement> &v2 = m_Fields;
+		vector<TArrayElement>::iterator p2;
 
-		TokenizeSmart(vAux[i].c_str(), v2);
+		splitRecord(vAux[i].text, v2);
 
 		p2 = v2.begin();
 		// FIXME: Postgresql can actually return 5 times the amount of data due
@@ -654,64 +705,54 @@ void
 CDBConnectionServerSide::execute(
 		const TTradeLookupFrame1Input *pIn, TTradeLookupFrame1Output *pOut)
 {
-	ostringstream osTrades;
-	int j = 0;
-	osTrades << "{" << pIn->trade_id[j];
-	for (j = 1; j < pIn->max_trades; j++) {
-		osTrades << "," << pIn->trade_id[j];
-	}
-	osTrades << "}";
-
-	char trade_id[osTrades.str().length() + 1];
-	strncpy(trade_id, osTrades.str().c_str(), osTrades.str().length());
-	trade_id[osTrades.str().length()] = '\0';
-
 	uint32_t max_trades = htobe32((uint32_t) pIn->max_trades);
+	int tradesLength;
+	const char *trades
+			= int8Array(1, pIn->trade_id, pIn->max_trades, &tradesLength);
 
-	const char *paramValues[2] = { (char *) &max_trades, trade_id };
-	const int paramLengths[2] = { sizeof(uint32_t),
-		(int) sizeof(char) * ((int) osTrades.str().length() + 1) };
-	const int paramFormats[2] = { 1, 0 };
+	const Oid paramTypes[2] = { INT4OID, INT8ARRAYOID };
+	const char *paramValues[2] = { (char *) &max_trades, trades };
+	const int paramLengths[2] = { sizeof(uint32_t), tradesLength };
+	const int paramFormats[2] = { 1, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeLookupFrame1($1, $2)", 2, NULL,
-			paramValues, paramLengths, paramFormats, 0);
-
-	int i_bid_price = get_col_num(res, "bid_price");
-	int i_cash_transaction_amount
-			= get_col_num(res, "cash_transaction_amount");
-	int i_cash_transaction_dts = get_col_num(res, "cash_transaction_dts");
-	int i_cash_transaction_name = get_col_num(res, "cash_transaction_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_is_cash = get_col_num(res, "is_cash");
-	int i_is_market = get_col_num(res, "is_market");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_settlement_amount = get_col_num(res, "settlement_amount");
-	int i_settlement_cash_due_date
-			= get_col_num(res, "settlement_cash_due_date");
-	int i_settlement_cash_type = get_col_num(res, "settlement_cash_type");
-	int i_trade_history_dts = get_col_num(res, "trade_history_dts");
-	int i_trade_history_status_id
-			= get_col_num(res, "trade_history_status_id");
-	int i_trade_price = get_col_num(res, "trade_price");
+#define TLF1 "SELECT * FROM TradeLookupFrame1($1, $2::TRADE_T[])"
+
+	PGresult *res = exec(TLF1, 2, paramTypes, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_bid_price = column(res, "bid_price");
+	int i_cash_transaction_amount = column(res, "cash_transaction_amount");
+	int i_cash_transaction_dts = column(res, "cash_transaction_dts");
+	int i_cash_transaction_name = column(res, "cash_transaction_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_is_cash = column(res, "is_cash");
+	int i_is_market = column(res, "is_market");
+	int i_num_found = column(res, "num_found");
+	int i_settlement_amount = column(res, "settlement_amount");
+	int i_settlement_cash_due_date = column(res, "settlement_cash_due_date");
+	int i_settlement_cash_type = column(res, "settlement_cash_type");
+	int i_trade_history_dts = column(res, "trade_history_dts");
+	int i_trade_history_status_id = column(res, "trade_history_status_id");
+	int i_trade_price = column(res, "trade_price");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_bid_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_bid_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].bid_price = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].cash_transaction_amount = atof(vAux[i].c_str());
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].cash_transaction_dts.year,
@@ -723,7 +764,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].cash_transaction_name, vAux[i].c_str(),
 				cCT_NAME_len);
@@ -731,7 +772,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].exec_name, vAux[i].c_str(),
 				cEXEC_NAME_len);
@@ -740,28 +781,28 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_cash), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_cash), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_cash = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_market), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_market), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_market = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].settlement_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].settlement_cash_due_date.year,
@@ -772,11 +813,15 @@ CDBConnectionServerSide::execute(
 				&pOut->trade_info[i].settlement_cash_due_date.second);
 	}
 	if (!check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__)) {
-		cout << "*** settlement_cash_due_date = "
-			 << PQgetvalue(res, 0, i_settlement_cash_due_date) << endl;
+		// The value was split in place, print what it held.
+		cout << "*** settlement_cash_due_date =";
+		for (size_t i = 0; i < vAux.size(); ++i) {
+			cout << " " << vAux[i].c_str();
+		}
+		cout << endl;
 	}
 	vAux.clear();
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].settlement_cash_type, vAux[i].c_str(),
 				cSE_CASH_TYPE_len);
@@ -785,7 +830,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_dts), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeLookupFrame1MaxRows;
 			++i, ++k) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
@@ -814,7 +859,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeLookupFrame1MaxRows;
 			++i, ++k) {
 		strncpy(pOut->trade_info[k].trade_history_status_id[0],
@@ -828,7 +873,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_price = atof(vAux[i].c_str());
 	}
@@ -873,46 +918,45 @@ CDBConnectionServerSide::execute(
 		sizeof(uint32_t), sizeof(uint64_t) };
 	const int paramFormats[4] = { 1, 1, 1, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeLookupFrame2($1, $2, $3, $4)", 4,
-			NULL, paramValues, paramLengths, paramFormats, 0);
-
-	int i_bid_price = get_col_num(res, "bid_price");
-	int i_cash_transaction_amount
-			= get_col_num(res, "cash_transaction_amount");
-	int i_cash_transaction_dts = get_col_num(res, "cash_transaction_dts");
-	int i_cash_transaction_name = get_col_num(res, "cash_transaction_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_is_cash = get_col_num(res, "is_cash");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_settlement_amount = get_col_num(res, "settlement_amount");
-	int i_settlement_cash_due_date
-			= get_col_num(res, "settlement_cash_due_date");
-	int i_settlement_cash_type = get_col_num(res, "settlement_cash_type");
-	int i_trade_history_dts = get_col_num(res, "trade_history_dts");
-	int i_trade_history_status_id
-			= get_col_num(res, "trade_history_status_id");
-	int i_trade_list = get_col_num(res, "trade_list");
-	int i_trade_price = get_col_num(res, "trade_price");
+#define TLF2 "SELECT * FROM TradeLookupFrame2($1, $2, $3, $4)"
+
+	PGresult *res = exec(TLF2, 4, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_bid_price = column(res, "bid_price");
+	int i_cash_transaction_amount = column(res, "cash_transaction_amount");
+	int i_cash_transaction_dts = column(res, "cash_transaction_dts");
+	int i_cash_transaction_name = column(res, "cash_transaction_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_is_cash = column(res, "is_cash");
+	int i_num_found = column(res, "num_found");
+	int i_settlement_amount = column(res, "settlement_amount");
+	int i_settlement_cash_due_date = column(res, "settlement_cash_due_date");
+	int i_settlement_cash_type = column(res, "settlement_cash_type");
+	int i_trade_history_dts = column(res, "trade_history_dts");
+	int i_trade_history_status_id = column(res, "trade_history_status_id");
+	int i_trade_list = column(res, "trade_list");
+	int i_trade_price = column(res, "trade_price");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_bid_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_bid_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].bid_price = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].cash_transaction_amount = atof(vAux[i].c_str());
 	}
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].cash_transaction_dts.year,
@@ -925,7 +969,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].cash_transaction_name, vAux[i].c_str(),
 				cCT_NAME_len);
@@ -934,7 +978,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].exec_name, vAux[i].c_str(),
 				cEXEC_NAME_len);
@@ -943,21 +987,21 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_cash), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_cash), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_cash = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].settlement_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].settlement_cash_due_date.year,
@@ -970,7 +1014,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].settlement_cash_type, vAux[i].c_str(),
 				cSE_CASH_TYPE_len);
@@ -979,7 +1023,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_dts), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeLookupFrame2MaxRows;
 			++i, ++k) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
@@ -1008,7 +1052,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeLookupFrame2MaxRows;
 			++i, ++k) {
 		strncpy(pOut->trade_info[k].trade_history_status_id[0],
@@ -1022,14 +1066,14 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_list), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_list), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_price = atof(vAux[i].c_str());
 	}
@@ -1075,49 +1119,48 @@ CDBConnectionServerSide::execute(
 		sizeof(uint32_t), sizeof(uint64_t), sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats[5] = { 1, 1, 1, 1, 0 };
 
-	PGresult *res = exec("SELECT * FROM TradeLookupFrame3($1, $2, $3, $4, $5)",
-			5, NULL, paramValues, paramLengths, paramFormats, 0);
-
-	int i_acct_id = get_col_num(res, "acct_id");
-	int i_cash_transaction_amount
-			= get_col_num(res, "cash_transaction_amount");
-	int i_cash_transaction_dts = get_col_num(res, "cash_transaction_dts");
-	int i_cash_transaction_name = get_col_num(res, "cash_transaction_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_is_cash = get_col_num(res, "is_cash");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_price = get_col_num(res, "price");
-	int i_quantity = get_col_num(res, "quantity");
-	int i_settlement_amount = get_col_num(res, "settlement_amount");
-	int i_settlement_cash_due_date
-			= get_col_num(res, "settlement_cash_due_date");
-	int i_settlement_cash_type = get_col_num(res, "settlement_cash_type");
-	int i_trade_dts = get_col_num(res, "trade_dts");
-	int i_trade_history_dts = get_col_num(res, "trade_history_dts");
-	int i_trade_history_status_id
-			= get_col_num(res, "trade_history_status_id");
-	int i_trade_list = get_col_num(res, "trade_list");
-	int i_trade_type = get_col_num(res, "trade_type");
+#define TLF3 "SELECT * FROM TradeLookupFrame3($1, $2, $3, $4, $5)"
+
+	PGresult *res = exec(TLF3, 5, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_acct_id = column(res, "acct_id");
+	int i_cash_transaction_amount = column(res, "cash_transaction_amount");
+	int i_cash_transaction_dts = column(res, "cash_transaction_dts");
+	int i_cash_transaction_name = column(res, "cash_transaction_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_is_cash = column(res, "is_cash");
+	int i_num_found = column(res, "num_found");
+	int i_price = column(res, "price");
+	int i_quantity = column(res, "quantity");
+	int i_settlement_amount = column(res, "settlement_amount");
+	int i_settlement_cash_due_date = column(res, "settlement_cash_due_date");
+	int i_settlement_cash_type = column(res, "settlement_cash_type");
+	int i_trade_dts = column(res, "trade_dts");
+	int i_trade_history_dts = column(res, "trade_history_dts");
+	int i_trade_history_status_id = column(res, "trade_history_status_id");
+	int i_trade_list = column(res, "trade_list");
+	int i_trade_type = column(res, "trade_type");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_acct_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_acct_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].acct_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].cash_transaction_amount = atof(vAux[i].c_str());
 	}
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].cash_transaction_dts.year,
@@ -1130,7 +1173,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].cash_transaction_name, vAux[i].c_str(),
 				cCT_NAME_len);
@@ -1139,7 +1182,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].exec_name, vAux[i].c_str(),
 				cEXEC_NAME_len);
@@ -1148,35 +1191,35 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_cash), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_cash), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_cash = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].price = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_quantity), vAux);
+	splitArray(PQgetvalue(res, 0, i_quantity), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].quantity = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].settlement_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].settlement_cash_due_date.year,
@@ -1189,7 +1232,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].settlement_cash_type, vAux[i].c_str(),
 				cSE_CASH_TYPE_len);
@@ -1198,7 +1241,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].trade_dts.year,
@@ -1211,7 +1254,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_dts), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeLookupFrame3MaxRows;
 			++i, ++k) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
@@ -1240,7 +1283,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeLookupFrame3MaxRows;
 			++i, ++k) {
 		strncpy(pOut->trade_info[k].trade_history_status_id[0],
@@ -1254,14 +1297,14 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_list), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_list), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].trade_type, vAux[i].c_str(), cTT_ID_len);
 		pOut->trade_info[i].trade_type[cTT_ID_len] = '\0';
@@ -1292,45 +1335,46 @@ CDBConnectionServerSide::execute(
 	const int paramLengths[2] = { sizeof(uint64_t), sizeof(uint64_t) };
 	const int paramFormats[2] = { 1, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeLookupFrame4($1, $2)", 2, NULL,
-			paramValues, paramLengths, paramFormats, 0);
+#define TLF4 "SELECT * FROM TradeLookupFrame4($1, $2)"
 
-	int i_holding_history_id = get_col_num(res, "holding_history_id");
-	int i_holding_history_trade_id
-			= get_col_num(res, "holding_history_trade_id");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_num_trades_found = get_col_num(res, "num_trades_found");
-	int i_quantity_after = get_col_num(res, "quantity_after");
-	int i_quantity_before = get_col_num(res, "quantity_before");
-	int i_trade_id = get_col_num(res, "trade_id");
+	PGresult *res = exec(TLF4, 2, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_holding_history_id = column(res, "holding_history_id");
+	int i_holding_history_trade_id = column(res, "holding_history_trade_id");
+	int i_num_found = column(res, "num_found");
+	int i_num_trades_found = column(res, "num_trades_found");
+	int i_quantity_after = column(res, "quantity_after");
+	int i_quantity_before = column(res, "quantity_before");
+	int i_trade_id = column(res, "trade_id");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 	pOut->num_trades_found = atoi(PQgetvalue(res, 0, i_num_trades_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_holding_history_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_holding_history_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].holding_history_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_holding_history_trade_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_holding_history_trade_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].holding_history_trade_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_quantity_after), vAux);
+	splitArray(PQgetvalue(res, 0, i_quantity_after), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].quantity_after = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_quantity_before), vAux);
+	splitArray(PQgetvalue(res, 0, i_quantity_before), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].quantity_before = atoi(vAux[i].c_str());
 	}
@@ -1351,19 +1395,21 @@ CDBConnectionServerSide::execute(
 	const int paramLengths[1] = { sizeof(uint64_t) };
 	const int paramFormats[1] = { 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeOrderFrame1($1)", 1, NULL,
-			paramValues, paramLengths, paramFormats, 0);
+#define TOF1 "SELECT * FROM TradeOrderFrame1($1)"
+
+	PGresult *res = exec(TOF1, 1, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
-	int i_acct_name = get_col_num(res, "acct_name");
-	int i_broker_id = get_col_num(res, "broker_id");
-	int i_broker_name = get_col_num(res, "broker_name");
-	int i_cust_f_name = get_col_num(res, "cust_f_name");
-	int i_cust_id = get_col_num(res, "cust_id");
-	int i_cust_l_name = get_col_num(res, "cust_l_name");
-	int i_cust_tier = get_col_num(res, "cust_tier");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_tax_id = get_col_num(res, "tax_id");
-	int i_tax_status = get_col_num(res, "tax_status");
+	int i_acct_name = column(res, "acct_name");
+	int i_broker_id = column(res, "broker_id");
+	int i_broker_name = column(res, "broker_name");
+	int i_cust_f_name = column(res, "cust_f_name");
+	int i_cust_id = column(res, "cust_id");
+	int i_cust_l_name = column(res, "cust_l_name");
+	int i_cust_tier = column(res, "cust_tier");
+	int i_num_found = column(res, "num_found");
+	int i_tax_id = column(res, "tax_id");
+	int i_tax_status = column(res, "tax_status");
 
 	strncpy(pOut->acct_name, PQgetvalue(res, 0, i_acct_name), cCA_NAME_len);
 	pOut->acct_name[cCA_NAME_len] = '\0';
@@ -1396,8 +1442,10 @@ CDBConnectionServerSide::execute(
 		sizeof(char) * (cTAX_ID_len + 1) };
 	const int paramFormats[4] = { 1, 0, 0, 0 };
 
-	PGresult *res = exec("SELECT * FROM TradeOrderFrame2($1, $2, $3, $4)", 4,
-			NULL, paramValues, paramLengths, paramFormats, 0);
+#define TOF2 "SELECT * FROM TradeOrderFrame2($1, $2, $3, $4)"
+
+	PGresult *res = exec(TOF2, 4, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	if (PQgetvalue(res, 0, 0) != NULL) {
 		strncpy(pOut->ap_acl, PQgetvalue(res, 0, 0), cACL_len);
@@ -1435,28 +1483,31 @@ CDBConnectionServerSide::execute(
 		sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats[14] = { 1, 1, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 0, 0 };
 
-	PGresult *res = exec("SELECT * FROM TradeOrderFrame3($1, $2, $3, $4, $5, "
-						 "$6, $7, $8, $9, $10, $11, $12, $13, $14)",
-			14, NULL, paramValues, paramLengths, paramFormats, 0);
+#define TOF3                                                                  \
+	"SELECT * FROM TradeOrderFrame3($1, $2, $3, $4, $5, "                     \
+	"$6, $7, $8, $9, $10, $11, $12, $13, $14)"
+
+	PGresult *res = exec(TOF3, 14, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	if (PQntuples(res) == 0) {
 		return;
 	}
 
-	int i_co_name = get_col_num(res, "co_name");
-	int i_requested_price = get_col_num(res, "requested_price");
-	int i_symbol = get_col_num(res, "symbol");
-	int i_buy_value = get_col_num(res, "buy_value");
-	int i_charge_amount = get_col_num(res, "charge_amount");
-	int i_comm_rate = get_col_num(res, "comm_rate");
-	int i_acct_assets = get_col_num(res, "acct_assets");
-	int i_market_price = get_col_num(res, "market_price");
-	int i_s_name = get_col_num(res, "s_name");
-	int i_sell_value = get_col_num(res, "sell_value");
-	int i_status_id = get_col_num(res, "status_id");
-	int i_tax_amount = get_col_num(res, "tax_amount");
-	int i_type_is_market = get_col_num(res, "type_is_market");
-	int i_type_is_sell = get_col_num(res, "type_is_sell");
+	int i_co_name = column(res, "co_name");
+	int i_requested_price = column(res, "requested_price");
+	int i_symbol = column(res, "symbol");
+	int i_buy_value = column(res, "buy_value");
+	int i_charge_amount = column(res, "charge_amount");
+	int i_comm_rate = column(res, "comm_rate");
+	int i_acct_assets = column(res, "acct_assets");
+	int i_market_price = column(res, "market_price");
+	int i_s_name = column(res, "s_name");
+	int i_sell_value = column(res, "sell_value");
+	int i_status_id = column(res, "status_id");
+	int i_tax_amount = column(res, "tax_amount");
+	int i_type_is_market = column(res, "type_is_market");
+	int i_type_is_sell = column(res, "type_is_sell");
 
 	strncpy(pOut->co_name, PQgetvalue(res, 0, i_co_name), cCO_NAME_len);
 	pOut->requested_price = atof(PQgetvalue(res, 0, i_requested_price));
@@ -1509,9 +1560,12 @@ CDBConnectionServerSide::execute(
 
 	const int paramFormats[13] = { 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeOrderFrame4($1, $2, $3, $4, $5, "
-						 "$6, $7, $8, $9, $10, $11, $12, $13)",
-			13, NULL, paramValues, paramLengths, paramFormats, 0);
+#define TOF4                                                                  \
+	"SELECT * FROM TradeOrderFrame4($1, $2, $3, $4, $5, "                     \
+	"$6, $7, $8, $9, $10, $11, $12, $13)"
+
+	PGresult *res = exec(TOF4, 13, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	pOut->trade_id = atoll(PQgetvalue(res, 0, 0));
 	PQclear(res);
@@ -1527,21 +1581,23 @@ CDBConnectionServerSide::execute(
 	const int paramLengths[1] = { sizeof(uint64_t) };
 	const int paramFormats[1] = { 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeResultFrame1($1)", 1, NULL,
-			paramValues, paramLengths, paramFormats, 0);
-
-	int i_acct_id = get_col_num(res, "acct_id");
-	int i_charge = get_col_num(res, "charge");
-	int i_hs_qty = get_col_num(res, "hs_qty");
-	int i_is_lifo = get_col_num(res, "is_lifo");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_symbol = get_col_num(res, "symbol");
-	int i_trade_is_cash = get_col_num(res, "trade_is_cash");
-	int i_trade_qty = get_col_num(res, "trade_qty");
-	int i_type_id = get_col_num(res, "type_id");
-	int i_type_is_market = get_col_num(res, "type_is_market");
-	int i_type_is_sell = get_col_num(res, "type_is_sell");
-	int i_type_name = get_col_num(res, "type_name");
+#define TRF1 "SELECT * FROM TradeResultFrame1($1)"
+
+	PGresult *res = exec(TRF1, 1, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_acct_id = column(res, "acct_id");
+	int i_charge = column(res, "charge");
+	int i_hs_qty = column(res, "hs_qty");
+	int i_is_lifo = column(res, "is_lifo");
+	int i_num_found = column(res, "num_found");
+	int i_symbol = column(res, "symbol");
+	int i_trade_is_cash = column(res, "trade_is_cash");
+	int i_trade_qty = column(res, "trade_qty");
+	int i_type_id = column(res, "type_id");
+	int i_type_is_market = column(res, "type_is_market");
+	int i_type_is_sell = column(res, "type_is_sell");
+	int i_type_name = column(res, "type_name");
 
 	pOut->acct_id = atoll(PQgetvalue(res, 0, i_acct_id));
 	pOut->charge = atof(PQgetvalue(res, 0, i_charge));
@@ -1584,9 +1640,10 @@ CDBConnectionServerSide::execute(
 
 	const int paramFormats[8] = { 1, 1, 1, 0, 1, 0, 1, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeResultFrame2($1, $2, $3, $4, $5, "
-						 "$6, $7, $8)",
-			8, NULL, paramValues, paramLengths, paramFormats, 0);
+#define TRF2 "SELECT * FROM TradeResultFrame2($1, $2, $3, $4, $5, $6, $7, $8)"
+
+	PGresult *res = exec(TRF2, 8, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	pOut->broker_id = atoll(PQgetvalue(res, 0, 0));
 	pOut->buy_value = atof(PQgetvalue(res, 0, 1));
@@ -1617,8 +1674,10 @@ CDBConnectionServerSide::execute(
 		sizeof(char) * 14, sizeof(uint64_t) };
 	const int paramFormats[4] = { 0, 1, 0, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeResultFrame3($1, $2, $3, $4)", 4,
-			NULL, paramValues, paramLengths, paramFormats, 0);
+#define TRF3 "SELECT * FROM TradeResultFrame3($1, $2, $3, $4)"
+
+	PGresult *res = exec(TRF3, 4, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	pOut->tax_amount = atof(PQgetvalue(res, 0, 0));
 	PQclear(res);
@@ -1638,8 +1697,10 @@ CDBConnectionServerSide::execute(
 				  sizeof(uint32_t), sizeof(char) * (cTT_ID_len + 1) };
 	const int paramFormats[4] = { 1, 0, 1, 0 };
 
-	PGresult *res = exec("SELECT * FROM TradeResultFrame4($1, $2, $3, $4)", 4,
-			NULL, paramValues, paramLengths, paramFormats, 0);
+#define TRF4 "SELECT * FROM TradeResultFrame4($1, $2, $3, $4)"
+
+	PGresult *res = exec(TRF4, 4, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	pOut->comm_rate = atof(PQgetvalue(res, 0, 0));
 	strncpy(pOut->s_name, PQgetvalue(res, 0, 1), cS_NAME_len);
@@ -1676,9 +1737,10 @@ CDBConnectionServerSide::execute(const TTradeResultFrame5Input *pIn)
 		sizeof(char) * 14 };
 	const int paramFormats[6] = { 1, 0, 0, 1, 1, 0 };
 
-	PGresult *res
-			= exec("SELECT * FROM TradeResultFrame5($1, $2, $3, $4, $5, $6)",
-					6, NULL, paramValues, paramLengths, paramFormats, 0);
+#define TRF5 "SELECT * FROM TradeResultFrame5($1, $2, $3, $4, $5, $6)"
+
+	PGresult *res = exec(TRF5, 6, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 	PQclear(res);
 }
 
@@ -1722,9 +1784,11 @@ CDBConnectionServerSide::execute(
 		sizeof(char) * (cTT_NAME_len + 1) };
 	const int paramFormats[9] = { 1, 1, 0, 0, 1, 1, 1, 1, 0 };
 
-	PGresult *res = exec("SELECT * FROM TradeResultFrame6($1, $2, $3, $4, $5, "
-						 "$6, $7, $8, $9)",
-			9, NULL, paramValues, paramLengths, paramFormats, 0);
+#define TRF6                                                                  \
+	"SELECT * FROM TradeResultFrame6($1, $2, $3, $4, $5, $6, $7, $8, $9)"
+
+	PGresult *res = exec(TRF6, 9, NULL, paramValues, paramLengths,
+			paramFormats, 0);
 
 	pOut->acct_bal = atof(PQgetvalue(res, 0, 0));
 	PQclear(res);
@@ -1740,32 +1804,34 @@ CDBConnectionServerSide::execute(
 	const int paramLengths[1] = { sizeof(uint64_t) };
 	const int paramFormats[1] = { 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeStatusFrame1($1)", 1, NULL,
-			paramValues, paramLengths, paramFormats, 0);
-
-	int i_broker_name = get_col_num(res, "broker_name");
-	int i_charge = get_col_num(res, "charge");
-	int i_cust_f_name = get_col_num(res, "cust_f_name");
-	int i_cust_l_name = get_col_num(res, "cust_l_name");
-	int i_ex_name = get_col_num(res, "ex_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_s_name = get_col_num(res, "s_name");
-	int i_status_name = get_col_num(res, "status_name");
-	int i_symbol = get_col_num(res, "symbol");
-	int i_trade_dts = get_col_num(res, "trade_dts");
-	int i_trade_id = get_col_num(res, "trade_id");
-	int i_trade_qty = get_col_num(res, "trade_qty");
-	int i_type_name = get_col_num(res, "type_name");
-
-	vector<string> vAux;
+#define TSF1 "SELECT * FROM TradeStatusFrame1($1)"
+
+	PGresult *res = exec(TSF1, 1, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_broker_name = column(res, "broker_name");
+	int i_charge = column(res, "charge");
+	int i_cust_f_name = column(res, "cust_f_name");
+	int i_cust_l_name = column(res, "cust_l_name");
+	int i_ex_name = column(res, "ex_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_num_found = column(res, "num_found");
+	int i_s_name = column(res, "s_name");
+	int i_status_name = column(res, "status_name");
+	int i_symbol = column(res, "symbol");
+	int i_trade_dts = column(res, "trade_dts");
+	int i_trade_id = column(res, "trade_id");
+	int i_trade_qty = column(res, "trade_qty");
+	int i_type_name = column(res, "type_name");
+
+	vector<TArrayElement> &vAux = m_Elements;
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
 	strncpy(pOut->broker_name, PQgetvalue(res, 0, i_broker_name), cB_NAME_len);
 	pOut->broker_name[cB_NAME_len] = '\0';
 
-	TokenizeSmart(PQgetvalue(res, 0, i_charge), vAux);
+	splitArray(PQgetvalue(res, 0, i_charge), vAux);
 	int len = vAux.size();
 	for (size_t i = 0; i < (size_t) len; ++i) {
 		pOut->charge[i] = atof(vAux[i].c_str());
@@ -1777,7 +1843,7 @@ CDBConnectionServerSide::execute(
 	strncpy(pOut->cust_l_name, PQgetvalue(res, 0, i_cust_l_name), cL_NAME_len);
 	pOut->cust_l_name[cL_NAME_len] = '\0';
 
-	TokenizeSmart(PQgetvalue(res, 0, i_ex_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_ex_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->ex_name[i], vAux[i].c_str(), cEX_NAME_len);
 		pOut->ex_name[i][cEX_NAME_len] = '\0';
@@ -1785,7 +1851,7 @@ CDBConnectionServerSide::execute(
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->exec_name[i], vAux[i].c_str(), cEXEC_NAME_len);
 		pOut->exec_name[i][cEXEC_NAME_len] = '\0';
@@ -1793,7 +1859,7 @@ CDBConnectionServerSide::execute(
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_s_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_s_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->s_name[i], vAux[i].c_str(), cS_NAME_len);
 		pOut->s_name[i][cS_NAME_len] = '\0';
@@ -1801,14 +1867,14 @@ CDBConnectionServerSide::execute(
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_status_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_status_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->status_name[i], vAux[i].c_str(), cST_NAME_len);
 		pOut->status_name[i][cST_NAME_len] = '\0';
 	}
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
-	TokenizeSmart(PQgetvalue(res, 0, i_symbol), vAux);
+	splitArray(PQgetvalue(res, 0, i_symbol), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->symbol[i], vAux[i].c_str(), cSYMBOL_len);
 		pOut->symbol[i][cSYMBOL_len] = '\0';
@@ -1816,7 +1882,7 @@ CDBConnectionServerSide::execute(
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_dts[i].year, &pOut->trade_dts[i].month,
@@ -1826,21 +1892,21 @@ CDBConnectionServerSide::execute(
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_id[i] = atoll(vAux[i].c_str());
 	}
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_qty), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_qty), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_qty[i] = atoi(vAux[i].c_str());
 	}
 	check_count(len, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_type_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_type_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->type_name[i], vAux[i].c_str(), cTT_NAME_len);
 		pOut->type_name[i][cTT_NAME_len] = '\0';
@@ -1854,67 +1920,59 @@ void
 CDBConnectionServerSide::execute(
 		const TTradeUpdateFrame1Input *pIn, TTradeUpdateFrame1Output *pOut)
 {
-	ostringstream osTrades;
-	int i = 0;
-	osTrades << "{" << pIn->trade_id[i];
-	for (i = 1; i < pIn->max_trades; i++) {
-		osTrades << "," << pIn->trade_id[i];
-	}
-	osTrades << "}";
-
 	uint32_t max_trades = htobe32((uint32_t) pIn->max_trades);
-	char trade_id[osTrades.str().length() + 1];
-	strncpy(trade_id, osTrades.str().c_str(), osTrades.str().length());
-	trade_id[osTrades.str().length()] = '\0';
 	uint32_t max_updates = htobe32((uint32_t) pIn->max_updates);
+	int tradesLength;
+	const char *trades
+			= int8Array(2, pIn->trade_id, pIn->max_trades, &tradesLength);
 
+	const Oid paramTypes[3] = { INT4OID, INT4OID, INT8ARRAYOID };
 	const char *paramValues[3]
-			= { (char *) &max_trades, (char *) &max_updates, trade_id };
-	const int paramLengths[3] = { sizeof(uint32_t), sizeof(uint32_t),
-		(int) sizeof(char) * ((int) strlen(trade_id) + 1) };
-	const int paramFormats[3] = { 1, 1, 0 };
-
-	PGresult *res = exec("SELECT * FROM TradeUpdateFrame1($1, $2, $3)", 3,
-			NULL, paramValues, paramLengths, paramFormats, 0);
-
-	int i_bid_price = get_col_num(res, "bid_price");
-	int i_cash_transaction_amount
-			= get_col_num(res, "cash_transaction_amount");
-	int i_cash_transaction_dts = get_col_num(res, "cash_transaction_dts");
-	int i_cash_transaction_name = get_col_num(res, "cash_transaction_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_is_cash = get_col_num(res, "is_cash");
-	int i_is_market = get_col_num(res, "is_market");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_num_updated = get_col_num(res, "num_updated");
-	int i_settlement_amount = get_col_num(res, "settlement_amount");
-	int i_settlement_cash_due_date
-			= get_col_num(res, "settlement_cash_due_date");
-	int i_settlement_cash_type = get_col_num(res, "settlement_cash_type");
-	int i_trade_history_dts = get_col_num(res, "trade_history_dts");
-	int i_trade_history_status_id
-			= get_col_num(res, "trade_history_status_id");
-	int i_trade_price = get_col_num(res, "trade_price");
+			= { (char *) &max_trades, (char *) &max_updates, trades };
+	const int paramLengths[3]
+			= { sizeof(uint32_t), sizeof(uint32_t), tradesLength };
+	const int paramFormats[3] = { 1, 1, 1 };
+
+#define TUF1 "SELECT * FROM TradeUpdateFrame1($1, $2, $3::IDENT_T[])"
+
+	PGresult *res = exec(TUF1, 3, paramTypes, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_bid_price = column(res, "bid_price");
+	int i_cash_transaction_amount = column(res, "cash_transaction_amount");
+	int i_cash_transaction_dts = column(res, "cash_transaction_dts");
+	int i_cash_transaction_name = column(res, "cash_transaction_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_is_cash = column(res, "is_cash");
+	int i_is_market = column(res, "is_market");
+	int i_num_found = column(res, "num_found");
+	int i_num_updated = column(res, "num_updated");
+	int i_settlement_amount = column(res, "settlement_amount");
+	int i_settlement_cash_due_date = column(res, "settlement_cash_due_date");
+	int i_settlement_cash_type = column(res, "settlement_cash_type");
+	int i_trade_history_dts = column(res, "trade_history_dts");
+	int i_trade_history_status_id = column(res, "trade_history_status_id");
+	int i_trade_price = column(res, "trade_price");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_bid_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_bid_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].bid_price = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].cash_transaction_amount = atof(vAux[i].c_str());
 	}
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].cash_transaction_dts.year,
@@ -1927,7 +1985,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].cash_transaction_name, vAux[i].c_str(),
 				cCT_NAME_len);
@@ -1936,7 +1994,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].exec_name, vAux[i].c_str(),
 				cEXEC_NAME_len);
@@ -1944,28 +2002,28 @@ CDBConnectionServerSide::execute(
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
-	TokenizeSmart(PQgetvalue(res, 0, i_is_cash), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_cash), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_cash = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_market), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_market), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_market = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].settlement_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].settlement_cash_due_date.year,
@@ -1978,7 +2036,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].settlement_cash_type, vAux[i].c_str(),
 				cSE_CASH_TYPE_len);
@@ -1989,7 +2047,7 @@ CDBConnectionServerSide::execute(
 
 	pOut->num_updated = atoi(PQgetvalue(res, 0, i_num_updated));
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_dts), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeUpdateFrame1MaxRows;
 			++i, ++k) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
@@ -2018,7 +2076,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeUpdateFrame1MaxRows;
 			++i, ++k) {
 		strncpy(pOut->trade_info[k].trade_history_status_id[0],
@@ -2032,7 +2090,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_price = atof(vAux[i].c_str());
 	}
@@ -2076,47 +2134,46 @@ CDBConnectionServerSide::execute(
 		sizeof(uint32_t), sizeof(uint32_t), sizeof(uint64_t) };
 	const int paramFormats[5] = { 1, 1, 1, 1, 1 };
 
-	PGresult *res = exec("SELECT * FROM TradeUpdateFrame2($1, $2, $3, $4, $5)",
-			5, NULL, paramValues, paramLengths, paramFormats, 0);
-
-	int i_bid_price = get_col_num(res, "bid_price");
-	int i_cash_transaction_amount
-			= get_col_num(res, "cash_transaction_amount");
-	int i_cash_transaction_dts = get_col_num(res, "cash_transaction_dts");
-	int i_cash_transaction_name = get_col_num(res, "cash_transaction_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_is_cash = get_col_num(res, "is_cash");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_num_updated = get_col_num(res, "num_updated");
-	int i_settlement_amount = get_col_num(res, "settlement_amount");
-	int i_settlement_cash_due_date
-			= get_col_num(res, "settlement_cash_due_date");
-	int i_settlement_cash_type = get_col_num(res, "settlement_cash_type");
-	int i_trade_history_dts = get_col_num(res, "trade_history_dts");
-	int i_trade_history_status_id
-			= get_col_num(res, "trade_history_status_id");
-	int i_trade_list = get_col_num(res, "trade_list");
-	int i_trade_price = get_col_num(res, "trade_price");
+#define TUF2 "SELECT * FROM TradeUpdateFrame2($1, $2, $3, $4, $5)"
+
+	PGresult *res = exec(TUF2, 5, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_bid_price = column(res, "bid_price");
+	int i_cash_transaction_amount = column(res, "cash_transaction_amount");
+	int i_cash_transaction_dts = column(res, "cash_transaction_dts");
+	int i_cash_transaction_name = column(res, "cash_transaction_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_is_cash = column(res, "is_cash");
+	int i_num_found = column(res, "num_found");
+	int i_num_updated = column(res, "num_updated");
+	int i_settlement_amount = column(res, "settlement_amount");
+	int i_settlement_cash_due_date = column(res, "settlement_cash_due_date");
+	int i_settlement_cash_type = column(res, "settlement_cash_type");
+	int i_trade_history_dts = column(res, "trade_history_dts");
+	int i_trade_history_status_id = column(res, "trade_history_status_id");
+	int i_trade_list = column(res, "trade_list");
+	int i_trade_price = column(res, "trade_price");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_bid_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_bid_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].bid_price = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].cash_transaction_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].cash_transaction_dts.year,
@@ -2129,7 +2186,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].cash_transaction_name, vAux[i].c_str(),
 				cCT_NAME_len);
@@ -2138,7 +2195,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].exec_name, vAux[i].c_str(),
 				cEXEC_NAME_len);
@@ -2147,7 +2204,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_cash), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_cash), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_cash = atof(vAux[i].c_str());
 	}
@@ -2156,14 +2213,14 @@ CDBConnectionServerSide::execute(
 
 	pOut->num_updated = atoi(PQgetvalue(res, 0, i_num_updated));
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].settlement_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].settlement_cash_due_date.year,
@@ -2176,7 +2233,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].settlement_cash_type, vAux[i].c_str(),
 				cSE_CASH_TYPE_len);
@@ -2185,7 +2242,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_dts), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeUpdateFrame2MaxRows;
 			++i, ++k) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
@@ -2214,7 +2271,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeUpdateFrame2MaxRows;
 			++i, ++k) {
 		strncpy(pOut->trade_info[k].trade_history_status_id[0],
@@ -2228,7 +2285,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_list), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_list), vAux);
 	this->bh = bh;
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_id = atoll(vAux[i].c_str());
@@ -2236,7 +2293,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_price = atof(vAux[i].c_str());
 	}
@@ -2281,53 +2338,51 @@ CDBConnectionServerSide::execute(
 		sizeof(char) * (cSYMBOL_len + 1) };
 	const int paramFormats[6] = { 1, 1, 1, 1, 1, 0 };
 
-	PGresult *res
-			= exec("SELECT * FROM TradeUpdateFrame3($1, $2, $3, $4, $5, $6)",
-					6, NULL, paramValues, paramLengths, paramFormats, 0);
-
-	int i_acct_id = get_col_num(res, "acct_id");
-	int i_cash_transaction_amount
-			= get_col_num(res, "cash_transaction_amount");
-	int i_cash_transaction_dts = get_col_num(res, "cash_transaction_dts");
-	int i_cash_transaction_name = get_col_num(res, "cash_transaction_name");
-	int i_exec_name = get_col_num(res, "exec_name");
-	int i_is_cash = get_col_num(res, "is_cash");
-	int i_num_found = get_col_num(res, "num_found");
-	int i_num_updated = get_col_num(res, "num_updated");
-	int i_price = get_col_num(res, "price");
-	int i_quantity = get_col_num(res, "quantity");
-	int i_s_name = get_col_num(res, "s_name");
-	int i_settlement_amount = get_col_num(res, "settlement_amount");
-	int i_settlement_cash_due_date
-			= get_col_num(res, "settlement_cash_due_date");
-	int i_settlement_cash_type = get_col_num(res, "settlement_cash_type");
-	int i_trade_dts = get_col_num(res, "trade_dts");
-	int i_trade_history_dts = get_col_num(res, "trade_history_dts");
-	int i_trade_history_status_id
-			= get_col_num(res, "trade_history_status_id");
-	int i_trade_list = get_col_num(res, "trade_list");
-	int i_type_name = get_col_num(res, "type_name");
-	int i_trade_type = get_col_num(res, "trade_type");
+#define TUF3 "SELECT * FROM TradeUpdateFrame3($1, $2, $3, $4, $5, $6)"
+
+	PGresult *res = exec(TUF3, 6, NULL, paramValues, paramLengths,
+			paramFormats, 0);
+
+	int i_acct_id = column(res, "acct_id");
+	int i_cash_transaction_amount = column(res, "cash_transaction_amount");
+	int i_cash_transaction_dts = column(res, "cash_transaction_dts");
+	int i_cash_transaction_name = column(res, "cash_transaction_name");
+	int i_exec_name = column(res, "exec_name");
+	int i_is_cash = column(res, "is_cash");
+	int i_num_found = column(res, "num_found");
+	int i_num_updated = column(res, "num_updated");
+	int i_price = column(res, "price");
+	int i_quantity = column(res, "quantity");
+	int i_s_name = column(res, "s_name");
+	int i_settlement_amount = column(res, "settlement_amount");
+	int i_settlement_cash_due_date = column(res, "settlement_cash_due_date");
+	int i_settlement_cash_type = column(res, "settlement_cash_type");
+	int i_trade_dts = column(res, "trade_dts");
+	int i_trade_history_dts = column(res, "trade_history_dts");
+	int i_trade_history_status_id = column(res, "trade_history_status_id");
+	int i_trade_list = column(res, "trade_list");
+	int i_type_name = column(res, "type_name");
+	int i_trade_type = column(res, "trade_type");
 
 	pOut->num_found = atoi(PQgetvalue(res, 0, i_num_found));
 
-	vector<string> vAux;
+	vector<TArrayElement> &vAux = m_Elements;
 
-	TokenizeSmart(PQgetvalue(res, 0, i_acct_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_acct_id), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].acct_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].cash_transaction_amount = atof(vAux[i].c_str());
 	}
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].cash_transaction_dts.year,
@@ -2340,7 +2395,7 @@ CDBConnectionServerSide::execute(
 	// FIXME: According to spec, this may not match the returned number found?
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_cash_transaction_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].cash_transaction_name, vAux[i].c_str(),
 				cCT_NAME_len);
@@ -2348,7 +2403,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_exec_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_exec_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].exec_name, vAux[i].c_str(),
 				cEXEC_NAME_len);
@@ -2357,7 +2412,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_is_cash), vAux);
+	splitArray(PQgetvalue(res, 0, i_is_cash), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].is_cash = atof(vAux[i].c_str());
 	}
@@ -2366,35 +2421,35 @@ CDBConnectionServerSide::execute(
 
 	pOut->num_updated = atoi(PQgetvalue(res, 0, i_num_updated));
 
-	TokenizeSmart(PQgetvalue(res, 0, i_price), vAux);
+	splitArray(PQgetvalue(res, 0, i_price), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].price = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_quantity), vAux);
+	splitArray(PQgetvalue(res, 0, i_quantity), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].quantity = atoi(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_s_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_s_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].s_name, vAux[i].c_str(), cS_NAME_len);
 		pOut->trade_info[i].s_name[cS_NAME_len] = '\0';
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_amount), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_amount), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].settlement_amount = atof(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_due_date), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].settlement_cash_due_date.year,
@@ -2407,7 +2462,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_settlement_cash_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].settlement_cash_type, vAux[i].c_str(),
 				cSE_CASH_TYPE_len);
@@ -2416,7 +2471,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_dts), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
 				&pOut->trade_info[i].trade_dts.year,
@@ -2429,7 +2484,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_dts), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_dts), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeUpdateFrame3MaxRows;
 			++i, ++k) {
 		sscanf(vAux[i].c_str(), "%hd-%hd-%hd %hd:%hd:%hd",
@@ -2458,7 +2513,7 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_history_status_id), vAux);
 	for (size_t i = 0, k = 0; i < vAux.size() && k < TradeUpdateFrame3MaxRows;
 			++i, ++k) {
 		strncpy(pOut->trade_info[k].trade_history_status_id[0],
@@ -2472,14 +2527,14 @@ CDBConnectionServerSide::execute(
 	}
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_list), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_list), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		pOut->trade_info[i].trade_id = atoll(vAux[i].c_str());
 	}
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_type_name), vAux);
+	splitArray(PQgetvalue(res, 0, i_type_name), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].type_name, vAux[i].c_str(), cTT_NAME_len);
 		pOut->trade_info[i].type_name[cTT_NAME_len] = '\0';
@@ -2487,7 +2542,7 @@ CDBConnectionServerSide::execute(
 	check_count(pOut->num_found, vAux.size(), __FILE__, __LINE__);
 	vAux.clear();
 
-	TokenizeSmart(PQgetvalue(res, 0, i_trade_type), vAux);
+	splitArray(PQgetvalue(res, 0, i_trade_type), vAux);
 	for (size_t i = 0; i < vAux.size(); ++i) {
 		strncpy(pOut->trade_info[i].trade_type, vAux[i].c_str(), cTT_ID_len);
 		pOut->trade_info[i].trade_type[cTT_ID_len] = '\0';
@@ -2496,3 +2551,40 @@ CDBConnectionServerSide::execute(
 	vAux.clear();
 	PQclear(res);
 }
+
+// The stored functions called by the frames above, with the parameter types
+// they pass.
+static const Oid BVF1Types[2] = { TEXTARRAYOID, TEXTOID };
+static const Oid MWF1Types[6]
+		= { INT8OID, INT8OID, INT8OID, TEXTOID, DATEOID, INT8OID };
+static const Oid SDF1Types[4] = { INT2OID, INT4OID, DATEOID, TEXTOID };
+static const Oid TLF1Types[2] = { INT4OID, INT8ARRAYOID };
+static const Oid TUF1Types[3] = { INT4OID, INT4OID, INT8ARRAYOID };
+
+const TPreparedStatement CDBConnectionServerSide::Statements[] = {
+	{ "BrokerVolumeFrame1", BVF1, 2, BVF1Types },
+	{ "CustomerPositionFrame1", CPF1, 0, NULL },
+	{ "CustomerPositionFrame2", CPF2, 0, NULL },
+	{ "DataMaintenanceFrame1", DMF1, 0, NULL },
+	{ "MarketWatchFrame1", MWF1, 6, MWF1Types },
+	{ "SecurityDetailFrame1", SDF1, 4, SDF1Types },
+	{ "TradeLookupFrame1", TLF1, 2, TLF1Types },
+	{ "TradeLookupFrame2", TLF2, 0, NULL },
+	{ "TradeLookupFrame3", TLF3, 0, NULL },
+	{ "TradeLookupFrame4", TLF4, 0, NULL },
+	{ "TradeOrderFrame1", TOF1, 0, NULL },
+	{ "TradeOrderFrame2", TOF2, 0, NULL },
+	{ "TradeOrderFrame3", TOF3, 0, NULL },
+	{ "TradeOrderFrame4", TOF4, 0, NULL },
+	{ "TradeResultFrame1", TRF1, 0, NULL },
+	{ "TradeResultFrame2", TRF2, 0, NULL },
+	{ "TradeResultFrame3", TRF3, 0, NULL },
+	{ "TradeResultFrame4", TRF4, 0, NULL },
+	{ "TradeResultFrame5", TRF5, 0, NULL },
+	{ "TradeResultFrame6", TRF6, 0, NULL },
+	{ "TradeStatusFrame1", TSF1, 0, NULL },
+	{ "TradeUpdateFrame1", TUF1, 3, TUF1Types },
+	{ "TradeUpdateFrame2", TUF2, 0, NULL },
+	{ "TradeUpdateFrame3", TUF3, 0, NULL },
+	{ NULL, NULL, 0, NULL }
+};
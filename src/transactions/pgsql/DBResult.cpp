@@ -0,0 +1,469 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ *
+ * The binary formats are those of the send functions of the types in the
+ * PostgreSQL server, all in network byte order.  Timestamps are the integer
+ * ones, counted in microseconds, PostgreSQL 10 and later have no others.
+ */
+
+#include <endian.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+
+#include <catalog/pg_type_d.h>
+
+#include "DBResult.h"
+
+// Days from 0000-03-01 in the proleptic Gregorian calendar to 2000-01-01,
+// from which PostgreSQL counts dates and timestamps.
+#define POSTGRES_EPOCH_DAYS 730425
+#define USECS_PER_DAY 86400000000LL
+
+// Numeric sign
+#define NUMERIC_NEG 0x4000
+#define NUMERIC_NAN 0xC000
+
+static INT16
+int16At(const char *value)
+{
+	UINT16 i;
+	memcpy(&i, value, sizeof(i));
+	return (INT16) be16toh(i);
+}
+
+static INT32
+int32At(const char *value)
+{
+	UINT32 i;
+	memcpy(&i, value, sizeof(i));
+	return (INT32) be32toh(i);
+}
+
+static INT64
+int64At(const char *value)
+{
+	UINT64 i;
+	memcpy(&i, value, sizeof(i));
+	return (INT64) be64toh(i);
+}
+
+static bool
+isBinary(const PGresult *res, int column)
+{
+	return PQfformat(res, column) == 1;
+}
+
+static bool
+isCharacterType(Oid type)
+{
+	return type == TEXTOID || type == VARCHAROID || type == BPCHAROID
+			|| type == NAMEOID || type == CHAROID;
+}
+
+// The base-10000 digits of a binary numeric, NULL for NaN or a malformed
+// value.  value is the numeric times 10000 to the power of 1 + *weight -
+// *ndigits.
+static const char *
+numericDigits(const char *value, int length, int *ndigits, int *weight,
+		bool *negative, int *dscale)
+{
+	if (length < 8)
+		return NULL;
+	*ndigits = int16At(value);
+	*weight = int16At(value + 2);
+	UINT16 sign = (UINT16) int16At(value + 4);
+	*dscale = int16At(value + 6);
+	if (sign == NUMERIC_NAN || length < 8 + 2 * *ndigits)
+		return NULL;
+	*negative = sign == NUMERIC_NEG;
+	return value + 8;
+}
+
+static double
+numericDouble(const char *value, int length)
+{
+	// As atof() reads the text of a NaN.
+	if (length >= 8 && (UINT16) int16At(value + 4) == NUMERIC_NAN)
+		return NAN;
+
+	int ndigits, weight, dscale;
+	bool negative;
+	const char *digits = numericDigits(
+			value, length, &ndigits, &weight, &negative, &dscale);
+	if (digits == NULL)
+		return 0;
+
+	// Summing the digits as an integer and scaling once rounds as atof()
+	// does, as long as there are less than 16 significant digits.
+	double d = 0;
+	for (int i = 0; i < ndigits; i++)
+		d = d * 10000 + int16At(digits + 2 * i);
+	double scale = 1;
+	int exponent = 1 + weight - ndigits;
+	for (int i = 0; i < abs(exponent); i++)
+		scale *= 10000;
+	d = exponent < 0 ? d / scale : d * scale;
+	return negative ? -d : d;
+}
+
+static INT64
+numericInt64(const char *value, int length)
+{
+	int ndigits, weight, dscale;
+	bool negative;
+	const char *digits = numericDigits(
+			value, length, &ndigits, &weight, &negative, &dscale);
+	if (digits == NULL)
+		return 0;
+
+	INT64 i = 0;
+	for (int j = 0; j <= weight; j++)
+		i = i * 10000 + (j < ndigits ? int16At(digits + 2 * j) : 0);
+	return negative ? -i : i;
+}
+
+static void
+writeNumeric(std::ostream &os, const char *value, int length)
+{
+	int ndigits, weight, dscale;
+	bool negative;
+	const char *digits = numericDigits(
+			value, length, &ndigits, &weight, &negative, &dscale);
+	if (digits == NULL) {
+		os << "NaN";
+		return;
+	}
+
+	char group[8];
+	if (negative)
+		os << '-';
+	if (weight < 0) {
+		os << '0';
+	} else {
+		for (int i = 0; i <= weight; i++) {
+			int digit = i < ndigits ? int16At(digits + 2 * i) : 0;
+			snprintf(group, sizeof(group), i == 0 ? "%d" : "%04d", digit);
+			os << group;
+		}
+	}
+	if (dscale <= 0)
+		return;
+
+	os << '.';
+	for (int i = weight + 1, written = 0; written < dscale; i++) {
+		int digit = i >= 0 && i < ndigits ? int16At(digits + 2 * i) : 0;
+		snprintf(group, sizeof(group), "%04d", digit);
+		for (int j = 0; j < 4 && written < dscale; j++, written++)
+			os << group[j];
+	}
+}
+
+// Split days since 2000-01-01 into a date of the proleptic Gregorian
+// calendar.
+static void
+splitDate(INT64 days, TIMESTAMP_STRUCT *pTimestamp)
+{
+	// In 400-year cycles of years from March, so that the leap day ends the
+	// year.
+	INT64 z = days + POSTGRES_EPOCH_DAYS;
+	INT64 era = (z >= 0 ? z : z - 146096) / 146097;
+	INT64 doe = z - era * 146097;
+	INT64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	INT64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	INT64 mp = (5 * doy + 2) / 153;
+
+	pTimestamp->day = (UINT16) (doy - (153 * mp + 2) / 5 + 1);
+	pTimestamp->month = (UINT16) (mp < 10 ? mp + 3 : mp - 9);
+	pTimestamp->year
+			= (INT16) (yoe + era * 400 + (pTimestamp->month <= 2 ? 1 : 0));
+}
+
+static void
+splitTimestamp(INT64 usecs, TIMESTAMP_STRUCT *pTimestamp)
+{
+	INT64 days = usecs / USECS_PER_DAY;
+	INT64 time = usecs % USECS_PER_DAY;
+	if (time < 0) {
+		days--;
+		time += USECS_PER_DAY;
+	}
+	splitDate(days, pTimestamp);
+	pTimestamp->fraction = (UINT32) (time % 1000000);
+	time /= 1000000;
+	pTimestamp->second = (UINT16) (time % 60);
+	pTimestamp->minute = (UINT16) (time / 60 % 60);
+	pTimestamp->hour = (UINT16) (time / 3600);
+}
+
+static INT64 binaryInt64(Oid, const char *, int);
+
+static double
+binaryDouble(Oid type, const char *value, int length)
+{
+	switch (type) {
+	case FLOAT4OID:
+		if (length == 4) {
+			INT32 i = int32At(value);
+			float f;
+			memcpy(&f, &i, sizeof(f));
+			return f;
+		}
+		break;
+	case FLOAT8OID:
+		if (length == 8) {
+			INT64 i = int64At(value);
+			double d;
+			memcpy(&d, &i, sizeof(d));
+			return d;
+		}
+		break;
+	case NUMERICOID:
+		return numericDouble(value, length);
+	default:
+		return (double) binaryInt64(type, value, length);
+	}
+	return 0;
+}
+
+static INT64
+binaryInt64(Oid type, const char *value, int length)
+{
+	switch (type) {
+	case BOOLOID:
+		return length == 1 ? value[0] != 0 : 0;
+	case INT2OID:
+		return length == 2 ? int16At(value) : 0;
+	case INT4OID:
+	case OIDOID:
+		return length == 4 ? int32At(value) : 0;
+	case INT8OID:
+		return length == 8 ? int64At(value) : 0;
+	case NUMERICOID:
+		return numericInt64(value, length);
+	case FLOAT4OID:
+	case FLOAT8OID:
+		return (INT64) binaryDouble(type, value, length);
+	}
+	return 0;
+}
+
+static void
+binaryTimestamp(Oid type, const char *value, int length,
+		TIMESTAMP_STRUCT *pTimestamp)
+{
+	switch (type) {
+	case DATEOID:
+		if (length == 4)
+			splitDate(int32At(value), pTimestamp);
+		break;
+	case TIMESTAMPOID:
+	case TIMESTAMPTZOID:
+		if (length == 8)
+			splitTimestamp(int64At(value), pTimestamp);
+		break;
+	}
+}
+
+std::string
+binary_to_int(const char *data, int length)
+{
+	std::ostringstream oss;
+	if (length == 1) { // INT1
+		int8_t val;
+		memcpy(&val, data, sizeof(int8_t));
+		oss << static_cast<int16_t>(val);
+		return oss.str();
+	} else if (length == 2) { // INT2
+		oss << int16At(data);
+	} else if (length == 4) { // INT4
+		oss << int32At(data);
+	} else if (length == 8) { // INT8
+		oss << (uint64_t) int64At(data);
+	} else {
+		oss << "Unknown int length: " << length;
+	}
+	return oss.str();
+}
+
+bool
+getBool(const PGresult *res, int row, int column)
+{
+	const char *value = PQgetvalue(res, row, column);
+	if (!isBinary(res, column))
+		return value[0] == 't';
+	return PQgetlength(res, row, column) > 0 && value[0] != 0;
+}
+
+size_t
+getBytes(const PGresult *res, int row, int column, char *dst, size_t size)
+{
+	const char *value = PQgetvalue(res, row, column);
+	if (isBinary(res, column)) {
+		size_t length = PQgetlength(res, row, column);
+		if (length > size)
+			length = size;
+		memcpy(dst, value, length);
+		return length;
+	}
+
+	size_t length;
+	unsigned char *bytes = PQunescapeBytea(
+			reinterpret_cast<const unsigned char *>(value), &length);
+	if (bytes == NULL)
+		return 0;
+	if (length > size)
+		length = size;
+	memcpy(dst, bytes, length);
+	PQfreemem(bytes);
+	return length;
+}
+
+double
+getDouble(const PGresult *res, int row, int column)
+{
+	const char *value = PQgetvalue(res, row, column);
+	if (!isBinary(res, column))
+		return atof(value);
+	return binaryDouble(
+			PQftype(res, column), value, PQgetlength(res, row, column));
+}
+
+INT32
+getInt32(const PGresult *res, int row, int column)
+{
+	return (INT32) getInt64(res, row, column);
+}
+
+INT64
+getInt64(const PGresult *res, int row, int column)
+{
+	const char *value = PQgetvalue(res, row, column);
+	if (!isBinary(res, column))
+		return atoll(value);
+	return binaryInt64(
+			PQftype(res, column), value, PQgetlength(res, row, column));
+}
+
+void
+getString(const PGresult *res, int row, int column, char *dst, size_t len)
+{
+	if (!isBinary(res, column)
+			|| isCharacterType(PQftype(res, column))) {
+		strncpy(dst, PQgetvalue(res, row, column), len);
+		return;
+	}
+
+	std::ostringstream os;
+	writeValue(os, res, row, column);
+	strncpy(dst, os.str().c_str(), len);
+}
+
+void
+getTimestamp(const PGresult *res, int row, int column,
+		TIMESTAMP_STRUCT *pTimestamp)
+{
+	const char *value = PQgetvalue(res, row, column);
+	memset(pTimestamp, 0, sizeof(*pTimestamp));
+
+	if (!isBinary(res, column)) {
+		int n = 0;
+		sscanf(value, "%hd-%hu-%hu %hu:%hu:%hu%n", &pTimestamp->year,
+				&pTimestamp->month, &pTimestamp->day, &pTimestamp->hour,
+				&pTimestamp->minute, &pTimestamp->second, &n);
+		// The text leaves out the trailing zeroes of the fraction.
+		if (n > 0 && value[n] == '.') {
+			UINT32 scale = 100000;
+			for (const char *p = value + n + 1; *p >= '0' && *p <= '9'; p++) {
+				pTimestamp->fraction += (*p - '0') * scale;
+				scale /= 10;
+			}
+		}
+		return;
+	}
+
+	binaryTimestamp(PQftype(res, column), value,
+			PQgetlength(res, row, column), pTimestamp);
+}
+
+void
+writeBinaryValue(std::ostream &os, Oid type, const char *value, int length)
+{
+	char buffer[32];
+	TIMESTAMP_STRUCT ts;
+	switch (type) {
+	case BOOLOID:
+		os << (length > 0 && value[0] != 0 ? 't' : 'f');
+		break;
+	case INT2OID:
+	case INT4OID:
+	case INT8OID:
+	case OIDOID:
+		os << binaryInt64(type, value, length);
+		break;
+	case FLOAT4OID:
+	case FLOAT8OID:
+		snprintf(buffer, sizeof(buffer), "%.*g", type == FLOAT4OID ? 9 : 17,
+				binaryDouble(type, value, length));
+		os << buffer;
+		break;
+	case NUMERICOID:
+		writeNumeric(os, value, length);
+		break;
+	case DATEOID:
+	case TIMESTAMPOID:
+	case TIMESTAMPTZOID:
+		memset(&ts, 0, sizeof(ts));
+		binaryTimestamp(type, value, length, &ts);
+		snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", ts.year, ts.month,
+				ts.day);
+		os << buffer;
+		if (type == DATEOID)
+			break;
+		snprintf(buffer, sizeof(buffer), " %02d:%02d:%02d", ts.hour,
+				ts.minute, ts.second);
+		os << buffer;
+		// Without the trailing zeros of the fraction, if any.
+		if (ts.fraction != 0) {
+			int digits = 6;
+			while (ts.fraction % 10 == 0) {
+				ts.fraction /= 10;
+				digits--;
+			}
+			snprintf(buffer, sizeof(buffer), ".%0*u", digits, ts.fraction);
+			os << buffer;
+		}
+		break;
+	default:
+		if (isCharacterType(type)) {
+			os.write(value, length);
+			break;
+		}
+		// bytea and the rest, in the hex format of bytea.
+		os << "\\x";
+		for (int i = 0; i < length; i++) {
+			snprintf(buffer, sizeof(buffer), "%02x",
+					(unsigned char) value[i]);
+			os << buffer;
+		}
+	}
+}
+
+void
+writeValue(std::ostream &os, const PGresult *res, int row, int column)
+{
+	const char *value = PQgetvalue(res, row, column);
+	if (!isBinary(res, column)) {
+		os << value;
+		return;
+	}
+	if (PQgetisnull(res, row, column))
+		return;
+	writeBinaryValue(
+			os, PQftype(res, column), value, PQgetlength(res, row, column));
+}
@@ -0,0 +1,196 @@
+/*
+ * This file is released under the terms of the Artistic License.  Please see
+ * the file LICENSE, included in this package, for details.
+ *
+ * Copyright The DBT-5 Authors
+ */
+
+#include <pthread.h>
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "StatementStats.h"
+
+// Totals of a statement over the connections merged.
+typedef struct TStatementTotals
+{
+	UINT64 calls;
+	UINT64 errors;
+	UINT64 rows;
+	INT64 total;
+	INT64 min;
+	INT64 max;
+	CLatencyHistogram latency;
+
+	TStatementTotals()
+	: calls(0), errors(0), rows(0), total(0),
+	  min(std::numeric_limits<INT64>::max()), max(0)
+	{
+	}
+} TStatementTotals;
+
+// Names of the statements by identifier, the connections open, and what
+// the ones closed counted.
+static pthread_mutex_t mutexStatements = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, UINT32> statementIds;
+static std::vector<std::string> statementNames;
+static std::set<const CStatementStats *> openStats;
+static std::vector<TStatementTotals> closedTotals(STATEMENT_STATS_MAX);
+
+// Constructor
+CStatementStats::CStatementStats()
+{
+	for (int i = 0; i < STATEMENT_STATS_MAX; i++) {
+		m_Counters[i].calls.store(0, std::memory_order_relaxed);
+		m_Counters[i].errors.store(0, std::memory_order_relaxed);
+		m_Counters[i].rows.store(0, std::memory_order_relaxed);
+		m_Counters[i].total.store(0, std::memory_order_relaxed);
+		m_Counters[i].min.store(
+				std::numeric_limits<INT64>::max(), std::memory_order_relaxed);
+		m_Counters[i].max.store(0, std::memory_order_relaxed);
+	}
+
+	pthread_mutex_lock(&mutexStatements);
+	openStats.insert(this);
+	pthread_mutex_unlock(&mutexStatements);
+}
+
+// Destructor: keep what the connection counted for the totals.
+CStatementStats::~CStatementStats()
+{
+	pthread_mutex_lock(&mutexStatements);
+	openStats.erase(this);
+	mergeInto(closedTotals);
+	pthread_mutex_unlock(&mutexStatements);
+}
+
+UINT32
+CStatementStats::id(const std::string &name)
+{
+	std::unordered_map<std::string, UINT32>::const_iterator it
+			= m_Ids.find(name);
+	if (it != m_Ids.end())
+		return it->second;
+
+	pthread_mutex_lock(&mutexStatements);
+	std::map<std::string, UINT32>::const_iterator named
+			= statementIds.find(name);
+	UINT32 id;
+	if (named != statementIds.end()) {
+		id = named->second;
+	} else if (statementNames.size() < STATEMENT_STATS_MAX - 1) {
+		id = statementNames.size();
+		statementIds[name] = id;
+		statementNames.push_back(name);
+	} else {
+		id = STATEMENT_STATS_MAX - 1;
+	}
+	pthread_mutex_unlock(&mutexStatements);
+
+	m_Ids[name] = id;
+	return id;
+}
+
+// Add the counters to the totals, under mutexStatements.
+void
+CStatementStats::mergeInto(std::vector<TStatementTotals> &totals) const
+{
+	for (int i = 0; i < STATEMENT_STATS_MAX; i++) {
+		const TCounters &counters = m_Counters[i];
+		UINT64 calls = counters.calls.load(std::memory_order_relaxed);
+		if (calls == 0)
+			continue;
+
+		TStatementTotals &statement = totals[i];
+		statement.calls += calls;
+		statement.errors += counters.errors.load(std::memory_order_relaxed);
+		statement.rows += counters.rows.load(std::memory_order_relaxed);
+		statement.total += counters.total.load(std::memory_order_relaxed);
+		statement.min = std::min(statement.min,
+				counters.min.load(std::memory_order_relaxed));
+		statement.max = std::max(statement.max,
+				counters.max.load(std::memory_order_relaxed));
+		counters.latency.mergeInto(&statement.latency);
+	}
+}
+
+void
+CStatementStats::record(UINT32 id, INT64 llNs, INT64 llRows, bool bError)
+{
+	TCounters &counters = m_Counters[id];
+	add<UINT64>(counters.calls, 1);
+	if (bError)
+		add<UINT64>(counters.errors, 1);
+	add<UINT64>(counters.rows, llRows);
+	add<INT64>(counters.total, llNs);
+	if (llNs < counters.min.load(std::memory_order_relaxed))
+		counters.min.store(llNs, std::memory_order_relaxed);
+	if (llNs > counters.max.load(std::memory_order_relaxed))
+		counters.max.store(llNs, std::memory_order_relaxed);
+	counters.latency.record(llNs);
+}
+
+// The name of a statement as a CSV field, quoted if it is text with commas.
+static std::string
+csvField(const std::string &name)
+{
+	if (name.find_first_of(",\"") == std::string::npos)
+		return name;
+
+	std::string field = "\"";
+	for (size_t i = 0; i < name.size(); i++) {
+		if (name[i] == '"')
+			field += '"';
+		field += name[i];
+	}
+	return field + "\"";
+}
+
+static bool
+byTotal(const std::pair<INT64, UINT32> &a, const std::pair<INT64, UINT32> &b)
+{
+	return a.first > b.first;
+}
+
+void
+CStatementStats::write(std::ostream &out)
+{
+	pthread_mutex_lock(&mutexStatements);
+	std::vector<TStatementTotals> totals = closedTotals;
+	for (std::set<const CStatementStats *>::const_iterator it
+			= openStats.begin();
+			it != openStats.end(); ++it) {
+		(*it)->mergeInto(totals);
+	}
+	std::vector<std::string> names = statementNames;
+	pthread_mutex_unlock(&mutexStatements);
+	names.resize(STATEMENT_STATS_MAX);
+	names[STATEMENT_STATS_MAX - 1] = "(other)";
+
+	std::vector<std::pair<INT64, UINT32> > order;
+	for (UINT32 i = 0; i < STATEMENT_STATS_MAX; i++) {
+		if (totals[i].calls > 0)
+			order.push_back(std::make_pair(totals[i].total, i));
+	}
+	std::sort(order.begin(), order.end(), byTotal);
+
+	out << "statement,calls,errors,rows,total_ms,mean_ms,min_ms,max_ms,"
+		   "p50_ms,p90_ms,p99_ms"
+		<< std::endl;
+	out << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < order.size(); i++) {
+		const TStatementTotals &statement = totals[order[i].second];
+		out << csvField(names[order[i].second]) << "," << statement.calls
+			<< "," << statement.errors << "," << statement.rows << ","
+			<< statement.total / 1e6 << ","
+			<< statement.total / 1e6 / statement.calls << ","
+			<< statement.min / 1e6 << "," << statement.max / 1e6 << ","
+			<< statement.latency.percentile(50) / 1e6 << ","
+			<< statement.latency.percentile(90) / 1e6 << ","
+			<< statement.latency.percentile(99) / 1e6 << std::endl;
+	}
+}
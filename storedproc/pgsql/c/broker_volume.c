@@ -9,7 +9,6 @@
 
 #include <sys/types.h>
 #include <unistd.h>
-#include <inttypes.h>
 #include <postgres.h>
 #include <fmgr.h>
 #include <executor/spi.h> /* this should include most necessary APIs */
@@ -24,8 +23,6 @@
 #include "frame.h"
 #include "dbt5common.h"
 
-#define BROKER_LIST_ARRAY_LEN ((B_NAME_LEN + 3) * 40 + 4)
-
 #define SQLBVF1_1                                                             \
 	"SELECT b_name\n"                                                         \
 	"     , sum(tr_qty * tr_bid_price)\n"                                     \
@@ -107,17 +104,13 @@ Datum
 BrokerVolumeFrame1(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 
-	int ndim, nitems;
-	int *dim;
-	char *broker_list;
-
-	char **values = NULL;
+	Datum values[3];
+	bool isnull[3];
 
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
@@ -133,94 +126,17 @@ BrokerVolumeFrame1(PG_FUNCTION_ARGS)
 			i_volume
 		};
 
-		int16 typlen;
-		bool typbyval;
-		char typalign;
-
 		int ret;
 		TupleDesc tupdesc;
 		SPITupleTable *tuptable = NULL;
 		HeapTuple tuple = NULL;
 
-		char broker_list_array[BROKER_LIST_ARRAY_LEN + 1] = "'{";
-		int length_bl = BROKER_LIST_ARRAY_LEN - 2;
 		Datum args[2];
 		char nulls[2] = { ' ', ' ' };
 
-		char *tmp;
-
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 3);
-		values[i_list_len]
-				= (char *) palloc((SMALLINT_LEN + 1) * sizeof(char));
-
-		/*
-		 * This might be overkill since we always expect single dimensions
-		 * arrays.
-		 */
-		ndim = ARR_NDIM(broker_list_p);
-		dim = ARR_DIMS(broker_list_p);
-		nitems = ArrayGetNItems(ndim, dim);
-		get_typlenbyvalalign(
-				ARR_ELEMTYPE(broker_list_p), &typlen, &typbyval, &typalign);
-		broker_list = ARR_DATA_PTR(broker_list_p);
-		/* Turn the broker_list input into an array format. */
-		if (nitems > 0) {
-			strncat(broker_list_array, "\"", length_bl--);
-			if (length_bl < 0) {
-				FAIL_FRAME("broker_list_array needs to be increased");
-			}
-
-			tmp = DatumGetCString(DirectFunctionCall1(
-					textout, PointerGetDatum(broker_list)));
-			strncat(broker_list_array,
-					DatumGetCString(DirectFunctionCall1(
-							textout, PointerGetDatum(broker_list))),
-					length_bl);
-			length_bl -= strlen(tmp);
-			if (length_bl < 0) {
-				FAIL_FRAME("broker_list_array needs to be increased");
-			}
-
-			broker_list
-					= att_addlength_pointer(broker_list, typlen, broker_list);
-			broker_list = (char *) att_align_nominal(broker_list, typalign);
-			strncat(broker_list_array, "\"", length_bl--);
-			if (length_bl < 0) {
-				FAIL_FRAME("broker_list_array needs to be increased");
-			}
-		}
-		for (i = 1; i < nitems; i++) {
-			strncat(broker_list_array, ",\"", length_bl--);
-			if (length_bl < 0) {
-				FAIL_FRAME("broker_list_array needs to be increased");
-			}
-
-			tmp = DatumGetCString(DirectFunctionCall1(
-					textout, PointerGetDatum(broker_list)));
-			strncat(broker_list_array, tmp, length_bl);
-			length_bl -= strlen(tmp);
-			if (length_bl < 0) {
-				FAIL_FRAME("broker_list_array needs to be increased");
-			}
-
-			broker_list
-					= att_addlength_pointer(broker_list, typlen, broker_list);
-			broker_list = (char *) att_align_nominal(broker_list, typalign);
-			strncat(broker_list_array, "\"", length_bl--);
-			if (length_bl < 0) {
-				FAIL_FRAME("broker_list_array needs to be increased");
-			}
-		}
-		strncat(broker_list_array, "}'", length_bl);
-		length_bl -= 2;
-		if (length_bl < 0) {
-			FAIL_FRAME("broker_list_array needs to be increased");
-		}
+		result_array broker_name;
+		result_array volume;
+
 #ifdef DEBUG
 		dump_bvf1_inputs(broker_list_p, sector_name_p);
 #endif
@@ -245,116 +161,23 @@ BrokerVolumeFrame1(PG_FUNCTION_ARGS)
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		tuple = tuptable->vals[0];
-
-		snprintf(values[i_list_len], BIGINT_LEN, "%" PRId64, SPI_processed);
-
-		if (SPI_processed == 0) {
-			values[i_broker_name] = (char *) palloc(3 * sizeof(char));
-			values[i_volume] = (char *) palloc(3 * sizeof(char));
-
-			strncpy(values[i_broker_name], "{}", 3);
-			strncpy(values[i_volume], "{}", 3);
-		} else {
-			int length_bn, length_v;
-
-			length_bn = (B_NAME_LEN + 2) * (SPI_processed + 1) + 3;
-			values[i_broker_name]
-					= (char *) palloc(length_bn-- * sizeof(char));
-
-			length_v = INTEGER_LEN * (SPI_processed + 1) + 3;
-			values[i_volume] = (char *) palloc(length_v-- * sizeof(char));
-
-			values[i_broker_name][0] = '{';
-			values[i_broker_name][1] = '\0';
-
-			values[i_volume][0] = '{';
-			values[i_volume][1] = '\0';
-
-			if (SPI_processed > 0) {
-				strncat(values[i_broker_name], "\"", length_bn--);
-				if (length_bn < 0) {
-					FAIL_FRAME("broker_name values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_broker_name], tmp, length_bn);
-				length_bn -= strlen(tmp);
-				if (length_bn < 0) {
-					FAIL_FRAME("broker_name values needs to be increased");
-				}
-
-				strncat(values[i_broker_name], "\"", length_bn--);
-				if (length_bn < 0) {
-					FAIL_FRAME("broker_name values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_volume], tmp, length_v);
-				length_v -= strlen(tmp);
-				if (length_v < 0) {
-					FAIL_FRAME("volume values needs to be increased");
-				}
-			}
-			for (i = 1; i < SPI_processed; i++) {
-				tuple = tuptable->vals[i];
-
-				strncat(values[i_broker_name], ",\"", length_bn);
-				length_bn -= 2;
-				if (length_bn < 0) {
-					FAIL_FRAME("broker_name values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_broker_name], tmp, length_bn);
-				length_bn -= strlen(tmp);
-				if (length_bn < 0) {
-					FAIL_FRAME("broker_name values needs to be increased");
-				}
-
-				strncat(values[i_broker_name], "\"", length_bn--);
-				if (length_bn < 0) {
-					FAIL_FRAME("broker_name values needs to be increased");
-				}
-
-				strncat(values[i_volume], ",", length_v--);
-				if (length_v < 0) {
-					FAIL_FRAME("volume values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_volume], tmp, length_v);
-				length_v -= strlen(tmp);
-				if (length_v < 0) {
-					FAIL_FRAME("volume values needs to be increased");
-				}
-			}
-			strncat(values[i_broker_name], "}", length_bn--);
-			if (length_bn < 0) {
-				FAIL_FRAME("broker_name values needs to be increased");
-			}
-
-			strncat(values[i_volume], "}", length_v--);
-			if (length_v < 0) {
-				FAIL_FRAME("volume values needs to be increased");
-			}
-		}
 
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		init_result_array(&broker_name, funcctx->tuple_desc, i_broker_name,
+				SPI_processed);
+		init_result_array(
+				&volume, funcctx->tuple_desc, i_volume, SPI_processed);
+		for (i = 0; i < SPI_processed; i++) {
+			tuple = tuptable->vals[i];
+			add_column(&broker_name, tuple, tupdesc, 1);
+			add_column(&volume, tuple, tupdesc, 2);
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from raw
-		 * C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
+		values[i_broker_name] = result_array_datum(&broker_name);
+		values[i_list_len] = Int32GetDatum(SPI_processed);
+		values[i_volume] = result_array_datum(&volume);
+		for (i = 0; i < 3; i++)
+			isnull[i] = false;
 
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -364,7 +187,6 @@ BrokerVolumeFrame1(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -372,13 +194,11 @@ BrokerVolumeFrame1(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 3; i++) {
-			elog(DEBUG1, "BVF1 OUT: %d %s", i, values[i]);
-		}
+		dump_result("BVF1", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -9,7 +9,6 @@
 
 #include <sys/types.h>
 #include <unistd.h>
-#include <inttypes.h>
 #include <postgres.h>
 #include <fmgr.h>
 #include <executor/spi.h> /* this should include most necessary APIs */
@@ -153,7 +152,8 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
 	int i;
-	char **values = NULL;
+	Datum values[27];
+	bool isnull[27];
 
 	int64 cust_id;
 
@@ -194,6 +194,13 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 			i_cash_bal
 		};
 
+		/* The result columns of the columns of CPF1_2, in order. */
+		const int customer[22] = { i_c_st_id, i_c_l_name, i_c_f_name,
+			i_c_m_name, i_c_gndr, i_c_tier, i_c_dob, i_c_ad_id, i_c_ctry_1,
+			i_c_area_1, i_c_local_1, i_c_ext_1, i_c_ctry_2, i_c_area_2,
+			i_c_local_2, i_c_ext_2, i_c_ctry_3, i_c_area_3, i_c_local_3,
+			i_c_ext_3, i_c_email_1, i_c_email_2 };
+
 		int ret;
 		Datum args[1];
 		char nulls[1] = { ' ' };
@@ -201,14 +208,10 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 		SPITupleTable *tuptable = NULL;
 		HeapTuple tuple;
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 27);
-		values[i_cust_id] = (char *) palloc((IDENT_T_LEN + 1) * sizeof(char));
-		values[i_acct_len] = (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
+		for (i = 0; i < 27; i++) {
+			values[i] = (Datum) 0;
+			isnull[i] = true;
+		}
 
 		/* Create a function context for cross-call persistence. */
 		funcctx = SRF_FIRSTCALL_INIT();
@@ -224,6 +227,7 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(CPF1_statements);
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
 		if (cust_id == 0) {
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLCPF1_1);
@@ -231,10 +235,13 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 			args[0] = PointerGetDatum(tax_id_p);
 			ret = SPI_execute_plan(CPF1_1, args, nulls, true, 0);
 			if (ret == SPI_OK_SELECT && SPI_processed > 0) {
+				bool null;
+
 				tupdesc = SPI_tuptable->tupdesc;
 				tuptable = SPI_tuptable;
 				tuple = tuptable->vals[0];
-				cust_id = atoll(SPI_getvalue(tuple, tupdesc, 1));
+				cust_id = DatumGetInt64(
+						SPI_getbinval(tuple, tupdesc, 1, &null));
 #ifdef DEBUG
 				elog(DEBUG1, "Got cust_id ok: %ld", cust_id);
 #endif /* DEBUG */
@@ -256,28 +263,11 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 			tuptable = SPI_tuptable;
 			tuple = tuptable->vals[0];
 
-			values[i_c_st_id] = SPI_getvalue(tuple, tupdesc, 1);
-			values[i_c_l_name] = SPI_getvalue(tuple, tupdesc, 2);
-			values[i_c_f_name] = SPI_getvalue(tuple, tupdesc, 3);
-			values[i_c_m_name] = SPI_getvalue(tuple, tupdesc, 4);
-			values[i_c_gndr] = SPI_getvalue(tuple, tupdesc, 5);
-			values[i_c_tier] = SPI_getvalue(tuple, tupdesc, 6);
-			values[i_c_dob] = SPI_getvalue(tuple, tupdesc, 7);
-			values[i_c_ad_id] = SPI_getvalue(tuple, tupdesc, 8);
-			values[i_c_ctry_1] = SPI_getvalue(tuple, tupdesc, 9);
-			values[i_c_area_1] = SPI_getvalue(tuple, tupdesc, 10);
-			values[i_c_local_1] = SPI_getvalue(tuple, tupdesc, 11);
-			values[i_c_ext_1] = SPI_getvalue(tuple, tupdesc, 12);
-			values[i_c_ctry_2] = SPI_getvalue(tuple, tupdesc, 13);
-			values[i_c_area_2] = SPI_getvalue(tuple, tupdesc, 14);
-			values[i_c_local_2] = SPI_getvalue(tuple, tupdesc, 15);
-			values[i_c_ext_2] = SPI_getvalue(tuple, tupdesc, 16);
-			values[i_c_ctry_3] = SPI_getvalue(tuple, tupdesc, 17);
-			values[i_c_area_3] = SPI_getvalue(tuple, tupdesc, 18);
-			values[i_c_local_3] = SPI_getvalue(tuple, tupdesc, 19);
-			values[i_c_ext_3] = SPI_getvalue(tuple, tupdesc, 20);
-			values[i_c_email_1] = SPI_getvalue(tuple, tupdesc, 21);
-			values[i_c_email_2] = SPI_getvalue(tuple, tupdesc, 22);
+			for (i = 0; i < 22; i++) {
+				values[customer[i]] = result_column(funcctx->tuple_desc,
+						customer[i], tuple, tupdesc, i + 1,
+						&isnull[customer[i]]);
+			}
 		} else {
 			FAIL_FRAME_SET(&funcctx->max_calls, CPF1_statements[1].sql);
 		}
@@ -286,145 +276,48 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 #endif /* DEBUG */
 		args[0] = Int64GetDatum(cust_id);
 		ret = SPI_execute_plan(CPF1_3, args, nulls, true, 0);
-		snprintf(values[i_acct_len], BIGINT_LEN, "%" PRId64, SPI_processed);
+		values[i_acct_len] = Int32GetDatum(SPI_processed);
+		isnull[i_acct_len] = false;
 #ifdef DEBUG
 		elog(DEBUG1, "%ld row(s) returned from CPF1_3.", SPI_processed);
 #endif /* DEBUG */
 		if (ret == SPI_OK_SELECT && SPI_processed > 0) {
-			char *tmp;
-			int length_ai, length_at, length_cb;
+			result_array acct_id;
+			result_array cash_bal;
+			result_array asset_total;
 
 			/* Total number of tuples to be returned. */
 			funcctx->max_calls = 1;
 
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
-			tuple = tuptable->vals[0];
 
-			length_ai = (BIGINT_LEN + 1) * (SPI_processed + 1) + 2;
-			values[i_acct_id] = (char *) palloc(length_ai-- * sizeof(char));
-
-			length_cb = (BALANCE_T_LEN + 1) * (SPI_processed + 1) + 2;
-			values[i_cash_bal] = (char *) palloc(length_cb-- * sizeof(char));
-
-			length_at = (S_PRICE_T_LEN + 1) * (SPI_processed + 1) + 2;
-			values[i_asset_total]
-					= (char *) palloc(length_at-- * sizeof(char));
-
-			values[i_acct_id][0] = '{';
-			values[i_acct_id][1] = '\0';
-
-			values[i_cash_bal][0] = '{';
-			values[i_cash_bal][1] = '\0';
-
-			values[i_asset_total][0] = '{';
-			values[i_asset_total][1] = '\0';
-
-			if (SPI_processed > 0) {
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_acct_id], tmp, length_ai);
-				length_ai -= strlen(tmp);
-				if (length_ai < 0) {
-					FAIL_FRAME("acct_id values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_cash_bal], tmp, length_cb);
-				length_cb -= strlen(tmp);
-				if (length_cb < 0) {
-					FAIL_FRAME("cash_bal values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 3);
-				strncat(values[i_asset_total], tmp, length_at);
-				length_at -= strlen(tmp);
-				if (length_at < 0) {
-					FAIL_FRAME("asset_total values needs to be increased");
-				}
-			}
-			for (i = 1; i < SPI_processed; i++) {
-				tuple = tuptable->vals[i];
+			init_result_array(
+					&acct_id, funcctx->tuple_desc, i_acct_id, SPI_processed);
+			init_result_array(
+					&cash_bal, funcctx->tuple_desc, i_cash_bal, SPI_processed);
+			init_result_array(&asset_total, funcctx->tuple_desc,
+					i_asset_total, SPI_processed);
 
-				strncat(values[i_acct_id], ",", length_ai--);
-				if (length_ai < 0) {
-					FAIL_FRAME("acct_id values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_acct_id], tmp, length_ai);
-				length_ai -= strlen(tmp);
-				if (length_ai < 0) {
-					FAIL_FRAME("account_id values needs to be increased");
-				}
-
-				strncat(values[i_cash_bal], ",", length_cb--);
-				if (length_cb < 0) {
-					FAIL_FRAME("cash_bal values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_cash_bal], tmp, length_cb);
-				length_cb -= strlen(tmp);
-				if (length_cb < 0) {
-					FAIL_FRAME("cash_bal values needs to be increased");
-				}
-
-				strncat(values[i_asset_total], ",", length_at--);
-				if (length_at < 0) {
-					FAIL_FRAME("asset_total values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 3);
-				if (tmp != NULL) {
-					strncat(values[i_asset_total], tmp, length_at);
-					length_at -= strlen(tmp);
-					if (length_at < 0) {
-						FAIL_FRAME("asset_total values needs to be increased");
-					}
-				} else {
-					strncat(values[i_asset_total], "0.00", length_at);
-					length_at -= 4;
-					if (length_at < 0) {
-						FAIL_FRAME("asset_total values needs to be increased");
-					}
-				}
-			}
-			strncat(values[i_acct_id], "}", length_ai--);
-			if (length_ai < 0) {
-				FAIL_FRAME("account_id values needs to be increased");
-			}
+			for (i = 0; i < SPI_processed; i++) {
+				tuple = tuptable->vals[i];
 
-			strncat(values[i_cash_bal], "}", length_cb--);
-			if (length_cb < 0) {
-				FAIL_FRAME("cash_bal values needs to be increased");
+				add_column(&acct_id, tuple, tupdesc, 1);
+				add_column(&cash_bal, tuple, tupdesc, 2);
+				add_column(&asset_total, tuple, tupdesc, 3);
 			}
 
-			strncat(values[i_asset_total], "}", length_at--);
-			if (length_at < 0) {
-				FAIL_FRAME("asset_total values needs to be increased");
-			}
+			values[i_acct_id] = result_array_datum(&acct_id);
+			values[i_cash_bal] = result_array_datum(&cash_bal);
+			values[i_asset_total] = result_array_datum(&asset_total);
+			isnull[i_acct_id] = false;
+			isnull[i_cash_bal] = false;
+			isnull[i_asset_total] = false;
 		} else {
 			FAIL_FRAME_SET(&funcctx->max_calls, CPF1_statements[2].sql);
 		}
-		snprintf(values[i_cust_id], 12, "%" PRId64, cust_id);
-
-		/* Build a tuple descriptor for our result type. */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
-		}
-
-		/*
-		 * Generate attribute metadata needed later to produce tuples from raw
-		 * C strings.
-		 */
-		funcctx->attinmeta = TupleDescGetAttInMetadata(tupdesc);
-
-		/* save SPI data for use across calls */
-		funcctx->user_fctx = tuptable;
+		values[i_cust_id] = Int64GetDatum(cust_id);
+		isnull[i_cust_id] = false;
 
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -437,13 +330,11 @@ CustomerPositionFrame1(PG_FUNCTION_ARGS)
 		HeapTuple tuple;
 
 #ifdef DEBUG
-		for (i = 0; i < 27; i++) {
-			elog(DEBUG1, "CPF1 OUT: %d '%s'", i, values[i]);
-		}
+		dump_result("CPF1", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(funcctx->attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -460,7 +351,8 @@ Datum
 CustomerPositionFrame2(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	char **values = NULL;
+	Datum values[6];
+	bool isnull[6];
 	int i;
 
 	if (SRF_IS_FIRSTCALL()) {
@@ -485,18 +377,12 @@ CustomerPositionFrame2(PG_FUNCTION_ARGS)
 		int ret;
 		Datum args[1];
 		char nulls[] = { ' ' };
+
+		result_array out[6];
 #ifdef DEBUG
 		dump_cpf2_inputs(acct_id);
 #endif /* DEBUG */
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 6);
-		values[i_hist_len] = (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
 		/* Create a function context for cross-call persistence. */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -511,207 +397,34 @@ CustomerPositionFrame2(PG_FUNCTION_ARGS)
 #endif /* DEBUG */
 		args[0] = Int64GetDatum(acct_id);
 		ret = SPI_execute_plan(CPF2_1, args, nulls, true, 0);
-		snprintf(values[i_hist_len], BIGINT_LEN, "%" PRId64, SPI_processed);
+		values[i_hist_len] = Int32GetDatum(SPI_processed);
 #ifdef DEBUG
 		elog(DEBUG1, "%ld row(s) returned.", SPI_processed);
 #endif /* DEBUG */
+
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 6; i++) {
+			if (i != i_hist_len)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, SPI_processed);
+		}
+
 		/* Should return 1 to rows. */
 		if (ret == SPI_OK_SELECT && SPI_processed > 0) {
-			char *tmp;
-			int length_hd, length_q, length_s, length_ti, length_ts;
-
 			/* Total number of tuples to be returned. */
 			funcctx->max_calls = 1;
 
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
-			tuple = tuptable->vals[0];
-
-			length_hd = (MAXDATELEN + 1) * SPI_processed + 3;
-			values[i_hist_dts] = (char *) palloc(length_hd-- * sizeof(char));
-
-			length_q = (INTEGER_LEN + 1) * SPI_processed + 3;
-			values[i_qty] = (char *) palloc(length_q-- * sizeof(char));
-
-			length_s = (S_SYMB_LEN + 3) * SPI_processed + 3;
-			values[i_symbol] = (char *) palloc(length_s-- * sizeof(char));
-
-			length_ti = (IDENT_T_LEN + 1) * SPI_processed + 3;
-			values[i_trade_id] = (char *) palloc(length_ti-- * sizeof(char));
-
-			length_ts = (ST_NAME_LEN + 3) * SPI_processed + 3;
-			values[i_trade_status]
-					= (char *) palloc(length_ts-- * sizeof(char));
-
-			values[i_hist_dts][0] = '{';
-			values[i_hist_dts][1] = '\0';
-
-			values[i_qty][0] = '{';
-			values[i_qty][1] = '\0';
-
-			values[i_symbol][0] = '{';
-			values[i_symbol][1] = '\0';
-
-			values[i_trade_id][0] = '{';
-			values[i_trade_id][1] = '\0';
-
-			values[i_trade_status][0] = '{';
-			values[i_trade_status][1] = '\0';
 
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_hist_dts], tmp, length_hd);
-			length_hd -= strlen(tmp);
-			if (length_hd < 0) {
-				FAIL_FRAME("hist_dts values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_qty], tmp, length_q);
-			length_q -= strlen(tmp);
-			if (length_q < 0) {
-				FAIL_FRAME("qty values needs to be increased");
-			}
-
-			strncat(values[i_symbol], "\"", length_s--);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_symbol], tmp, length_s);
-			length_s -= strlen(tmp);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			strncat(values[i_symbol], "\"", length_s--);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_trade_id], tmp, length_ti);
-			length_ti -= strlen(tmp);
-			if (length_ti < 0) {
-				FAIL_FRAME("trade_id values needs to be increased");
-			}
-
-			strncat(values[i_trade_status], "\"", length_ts--);
-			if (length_ts < 0) {
-				FAIL_FRAME("trade_status values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_trade_status], tmp, length_ts);
-			length_ts -= strlen(tmp);
-			if (length_ts < 0) {
-				FAIL_FRAME("trade_status values needs to be increased");
-			}
-
-			strncat(values[i_trade_status], "\"", length_ts--);
-			if (length_ts < 0) {
-				FAIL_FRAME("trade_status values needs to be increased");
-			}
-
-			for (i = 1; i < SPI_processed; i++) {
+			for (i = 0; i < SPI_processed; i++) {
 				tuple = tuptable->vals[i];
 
-				strncat(values[i_hist_dts], ",", length_hd--);
-				if (length_hd < 0) {
-					FAIL_FRAME("hist_dts values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 5);
-				strncat(values[i_hist_dts], tmp, length_hd);
-				length_hd -= strlen(tmp);
-				if (length_hd < 0) {
-					FAIL_FRAME("hist_dts values needs to be increased");
-				}
-
-				strncat(values[i_qty], ",", length_q--);
-				if (length_q < 0) {
-					FAIL_FRAME("qty values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 3);
-				strncat(values[i_qty], tmp, length_q);
-				length_q -= strlen(tmp);
-				if (length_q < 0) {
-					FAIL_FRAME("qty values needs to be increased");
-				}
-
-				strncat(values[i_symbol], ",\"", length_s);
-				length_s -= 2;
-				if (length_s < 0) {
-					FAIL_FRAME("symbol values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_symbol], tmp, length_s);
-				length_s -= strlen(tmp);
-				if (length_s < 0) {
-					FAIL_FRAME("symbol values needs to be increased");
-				}
-
-				strncat(values[i_symbol], "\"", length_s--);
-				if (length_s < 0) {
-					FAIL_FRAME("symbol values needs to be increased");
-				}
-
-				strncat(values[i_trade_id], ",", length_ti--);
-				if (length_ti < 0) {
-					FAIL_FRAME("trade_id values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_trade_id], tmp, length_ti);
-				length_ti -= strlen(tmp);
-				if (length_ti < 0) {
-					FAIL_FRAME("trade_id values needs to be increased");
-				}
-
-				strncat(values[i_trade_status], ",\"", length_ts);
-				length_ts -= 2;
-				if (length_ts < 0) {
-					FAIL_FRAME("trade_status values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 4);
-				strncat(values[i_trade_status], tmp, length_ts);
-				length_ts -= strlen(tmp);
-				if (length_ts < 0) {
-					FAIL_FRAME("trade_status values needs to be increased");
-				}
-
-				strncat(values[i_trade_status], "\"", length_ts--);
-				if (length_ts < 0) {
-					FAIL_FRAME("trade_status values needs to be increased");
-				}
-			}
-
-			strncat(values[i_hist_dts], "}", length_hd--);
-			if (length_hd < 0) {
-				FAIL_FRAME("hist_dts values needs to be increased");
-			}
-
-			strncat(values[i_qty], "}", length_q--);
-			if (length_q < 0) {
-				FAIL_FRAME("qty values needs to be increased");
-			}
-
-			strncat(values[i_symbol], "}", length_s--);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			strncat(values[i_trade_id], "}", length_ti--);
-			if (length_ti < 0) {
-				FAIL_FRAME("trade_id values needs to be increased");
-			}
-
-			strncat(values[i_trade_status], "}", length_ts--);
-			if (length_ts < 0) {
-				FAIL_FRAME("trade_status values needs to be increased");
+				add_column(&out[i_trade_id], tuple, tupdesc, 1);
+				add_column(&out[i_symbol], tuple, tupdesc, 2);
+				add_column(&out[i_qty], tuple, tupdesc, 3);
+				add_column(&out[i_trade_status], tuple, tupdesc, 4);
+				add_column(&out[i_hist_dts], tuple, tupdesc, 5);
 			}
 		} else {
 			if (ret == SPI_OK_SELECT && SPI_processed == 0) {
@@ -721,43 +434,14 @@ CustomerPositionFrame2(PG_FUNCTION_ARGS)
 			dump_cpf2_inputs(acct_id);
 #endif /* DEBUG */
 			FAIL_FRAME_SET(&funcctx->max_calls, CPF2_statements[1].sql);
-
-			/*
-			 * FIXME: Probably don't need to do this if we're not going to
-			 * return any rows, but if we do then we don't need to figure
-			 * out what pieces of memory we need to free later in the function.
-			 */
-			values[i_hist_dts] = (char *) palloc(3 * sizeof(char));
-			values[i_qty] = (char *) palloc(3 * sizeof(char));
-			values[i_symbol] = (char *) palloc(3 * sizeof(char));
-			values[i_trade_id] = (char *) palloc(3 * sizeof(char));
-			values[i_trade_status] = (char *) palloc(3 * sizeof(char));
-
-			strncpy(values[i_hist_dts], "{}", 3);
-			strncpy(values[i_qty], "{}", 3);
-			strncpy(values[i_symbol], "{}", 3);
-			strncpy(values[i_trade_id], "{}", 3);
-			strncpy(values[i_trade_status], "{}", 3);
 		}
 
-		/* Build a tuple descriptor for our result type. */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 6; i++) {
+			if (i != i_hist_len)
+				values[i] = result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * Generate attribute metadata needed later to produce tuples from raw
-		 * C strings.
-		 */
-		funcctx->attinmeta = TupleDescGetAttInMetadata(tupdesc);
-
-		/* save SPI data for use across calls */
-		funcctx->user_fctx = tuptable;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -769,13 +453,11 @@ CustomerPositionFrame2(PG_FUNCTION_ARGS)
 		HeapTuple tuple;
 
 #ifdef DEBUG
-		for (i = 0; i < 6; i++) {
-			elog(DEBUG1, "CPF2 OUT: %d '%s'", i, values[i]);
-		}
+		dump_result("CPF2", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(funcctx->attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
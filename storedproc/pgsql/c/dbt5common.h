@@ -10,6 +10,11 @@
 #ifndef _DBT5COMMON_H_
 #define _DBT5COMMON_H_
 
+#include <funcapi.h>
+#include <utils/array.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
+
 #if PG_VERSION_NUM >= 90200
 #define EncodeDateTimeM(tm, fsec, tzn, dts)                                   \
 	EncodeDateTime(tm, fsec, false, 0, tzn, USE_ISO_DATES, dts);
@@ -18,7 +23,7 @@
 	EncodeDateTime(tm, fsec, NULL, &tzn, USE_ISO_DATES, dts);
 #endif
 
-/*  PostgreSQL < 8.4 didn't have this handy macro */
+/* PostgreSQL < 8.4 didn't have this handy macro */
 #ifndef CStringGetTextDatum
 #define CStringGetTextDatum(s) DirectFunctionCall1(textin, PointerGetDatum(s))
 #endif
@@ -29,10 +34,10 @@
  */
 typedef struct
 {
-	const char *sql; /*  statement text */
-	int nargs; /*  number of arguments in the query */
-	Oid argtypes[11]; /*  argument types */
-	SPIPlanPtr plan; /*  plan_queries() stores the prepared plan here */
+	const char *sql; /* statement text */
+	int nargs; /* number of arguments in the query */
+	Oid argtypes[11]; /* argument types */
+	SPIPlanPtr plan; /* plan_queries() stores the prepared plan here */
 } cached_statement;
 
 /*
@@ -59,4 +64,231 @@ plan_queries(cached_statement *statements)
 		}
 	}
 }
+
+/*
+ * result_array collects the values of an array returned by a frame as
+ * datums, straight from the rows of its queries, instead of formatting them
+ * into the text of the array.  The element type is the one of the array the
+ * function returns.  A value of another type, such as a date returned as a
+ * timestamp, still goes through its text, as all of them used to.
+ */
+typedef struct
+{
+	Oid elemtype;
+	Oid basetype; /* elemtype, or the type of the domain it is */
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	FmgrInfo input;
+	Oid ioparam;
+	Oid fromtype; /* type of the column added last */
+	bool convert; /* whether values of fromtype go through their text */
+	FmgrInfo output;
+	TupleDesc rowdesc; /* fields of a composite elemtype, or NULL */
+	int n;
+	int size;
+	Datum *values;
+	bool *nulls;
+} result_array;
+
+/*
+ * Start the array returned as column attnum, counted from 0, of the result
+ * described by tupdesc, with room for size values to begin with.
+ */
+static inline void
+init_result_array(result_array *a, TupleDesc tupdesc, int attnum, int size)
+{
+	Oid func;
+
+	a->elemtype = get_element_type(TupleDescAttr(tupdesc, attnum)->atttypid);
+	if (a->elemtype == InvalidOid)
+		elog(ERROR, "result column %d is not an array", attnum);
+	a->basetype = getBaseType(a->elemtype);
+	get_typlenbyvalalign(a->elemtype, &a->typlen, &a->typbyval, &a->typalign);
+	getTypeInputInfo(a->elemtype, &func, &a->ioparam);
+	fmgr_info(func, &a->input);
+	a->fromtype = InvalidOid;
+	a->convert = false;
+	a->rowdesc = type_is_rowtype(a->elemtype)
+			? lookup_rowtype_tupdesc_copy(a->elemtype, -1)
+			: NULL;
+	a->n = 0;
+	a->size = size > 0 ? size : 1;
+	a->values = (Datum *) palloc(sizeof(Datum) * a->size);
+	a->nulls = (bool *) palloc(sizeof(bool) * a->size);
+}
+
+static inline void
+add_datum(result_array *a, Datum value, bool isnull)
+{
+	if (a->n == a->size) {
+		a->size *= 2;
+		a->values = (Datum *) repalloc(a->values, sizeof(Datum) * a->size);
+		a->nulls = (bool *) repalloc(a->nulls, sizeof(bool) * a->size);
+	}
+	a->values[a->n] = value;
+	a->nulls[a->n] = isnull;
+	a->n++;
+}
+
+/* Add a value given as text, or a NULL for NULL. */
+static inline void
+add_cstring(result_array *a, char *value)
+{
+	if (value == NULL) {
+		add_datum(a, (Datum) 0, true);
+		return;
+	}
+	add_datum(a, InputFunctionCall(&a->input, value, a->ioparam, -1), false);
+}
+
+/*
+ * Add column, counted from 1, of a row returned by SPI.  The value is kept
+ * where SPI left it, which lasts until SPI_finish().
+ */
+static inline void
+add_column(result_array *a, HeapTuple tuple, TupleDesc tupdesc, int column)
+{
+	bool isnull;
+	Datum value = SPI_getbinval(tuple, tupdesc, column, &isnull);
+	Oid type = SPI_gettypeid(tupdesc, column);
+
+	if (type != a->fromtype) {
+		a->fromtype = type;
+		a->convert = getBaseType(type) != a->basetype;
+		if (a->convert) {
+			Oid func;
+			bool varlena;
+
+			getTypeOutputInfo(type, &func, &varlena);
+			fmgr_info(func, &a->output);
+		}
+	}
+
+	if (isnull)
+		add_datum(a, (Datum) 0, true);
+	else if (a->convert)
+		add_cstring(a, OutputFunctionCall(&a->output, value));
+	else
+		add_datum(a, value, false);
+}
+
+/*
+ * Column, counted from 1, of a row returned by SPI as the column attnum,
+ * counted from 0, of the result described by result, going through its text
+ * when their types differ.
+ */
+static inline Datum
+result_column(TupleDesc result, int attnum, HeapTuple tuple,
+		TupleDesc tupdesc, int column, bool *isnull)
+{
+	Datum value = SPI_getbinval(tuple, tupdesc, column, isnull);
+	Oid type = SPI_gettypeid(tupdesc, column);
+	Oid restype = TupleDescAttr(result, attnum)->atttypid;
+	Oid func;
+	Oid ioparam;
+	bool varlena;
+	char *text;
+
+	if (*isnull || getBaseType(type) == getBaseType(restype))
+		return value;
+
+	getTypeOutputInfo(type, &func, &varlena);
+	text = OidOutputFunctionCall(func, value);
+	getTypeInputInfo(restype, &func, &ioparam);
+	return OidInputFunctionCall(func, text, ioparam, -1);
+}
+
+/*
+ * Add a row returned by SPI as a record of the composite element type, its
+ * columns in the order of the fields.
+ */
+static inline void
+add_record(result_array *a, HeapTuple tuple, TupleDesc tupdesc)
+{
+	int natts = a->rowdesc->natts;
+	Datum *values = (Datum *) palloc(sizeof(Datum) * natts);
+	bool *nulls = (bool *) palloc(sizeof(bool) * natts);
+	int i;
+
+	for (i = 0; i < natts; i++) {
+		values[i] = result_column(
+				a->rowdesc, i, tuple, tupdesc, i + 1, &nulls[i]);
+	}
+	add_datum(a, HeapTupleGetDatum(heap_form_tuple(a->rowdesc, values, nulls)),
+			false);
+}
+
+/* Add a boolean, as the 0 or 1 the frames return for it in integers. */
+static inline void
+add_flag(result_array *a, bool value)
+{
+	switch (a->basetype) {
+	case BOOLOID:
+		add_datum(a, BoolGetDatum(value), false);
+		break;
+	case INT2OID:
+		add_datum(a, Int16GetDatum(value ? 1 : 0), false);
+		break;
+	default:
+		add_datum(a, Int32GetDatum(value ? 1 : 0), false);
+		break;
+	}
+}
+
+/* The one-dimensional array of the values added. */
+static inline Datum
+result_array_datum(result_array *a)
+{
+	int dims[1];
+	int lbs[1] = { 1 };
+
+	if (a->n == 0)
+		return PointerGetDatum(construct_empty_array(a->elemtype));
+
+	dims[0] = a->n;
+	return PointerGetDatum(construct_md_array(a->values, a->nulls, 1, dims,
+			lbs, a->elemtype, a->typlen, a->typbyval, a->typalign));
+}
+
+/*
+ * The descriptor of the row returned by the function called with fcinfo,
+ * ready to form it from datums.
+ */
+static inline TupleDesc
+result_tupdesc(FunctionCallInfo fcinfo)
+{
+	TupleDesc tupdesc;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE) {
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							   errmsg("function returning record called in "
+									  "context that cannot accept type "
+									  "record")));
+	}
+	return BlessTupleDesc(tupdesc);
+}
+
+#ifdef DEBUG
+static inline void
+dump_result(const char *frame, TupleDesc tupdesc, Datum *values, bool *nulls)
+{
+	int i;
+
+	for (i = 0; i < tupdesc->natts; i++) {
+		Oid func;
+		bool varlena;
+
+		if (nulls[i]) {
+			elog(DEBUG1, "%s OUT: %d NULL", frame, i);
+			continue;
+		}
+		getTypeOutputInfo(TupleDescAttr(tupdesc, i)->atttypid, &func,
+				&varlena);
+		elog(DEBUG1, "%s OUT: %d %s", frame, i,
+				OidOutputFunctionCall(func, values[i]));
+	}
+}
+#endif /* DEBUG */
+
 #endif /* _DBT5COMMON_H_ */
@@ -9,7 +9,6 @@
 
 #include <sys/types.h>
 #include <unistd.h>
-#include <inttypes.h>
 #include <postgres.h>
 #include <fmgr.h>
 #include <executor/spi.h> /* this should include most necessary APIs */
@@ -213,13 +212,13 @@ Datum
 SecurityDetailFrame1(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 
-	char **values = NULL;
+	Datum values[45];
+	bool isnull[45];
 
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
@@ -229,6 +228,7 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		int max_rows_to_return = PG_GETARG_INT32(1);
 		DateADT start_date_p = PG_GETARG_DATEADT(2);
 		char *symbol_p = (char *) PG_GETARG_TEXT_P(3);
+
 		char symbol[S_SYMB_LEN + 1];
 
 		enum sdf1
@@ -280,63 +280,40 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 			i_yield
 		};
 
-		char *tmp;
+		/*
+		 * Result columns of the columns of SQLSDF1_1, in order, with -1 for
+		 * co_id, which is only used by the following queries.
+		 */
+		const int security[35] = { i_s_name, -1, i_co_name, i_sp_rate,
+			i_ceo_name, i_co_desc, i_open_date, i_co_st_id, i_co_ad_line1,
+			i_co_ad_line2, i_co_ad_town, i_co_ad_div, i_co_ad_zip,
+			i_co_ad_ctry, i_num_out, i_start_date, i_ex_date, i_pe_ratio,
+			i_x52_wk_high, i_x52_wk_high_date, i_x52_wk_low,
+			i_x52_wk_low_date, i_divid, i_yield, i_ex_ad_div, i_ex_ad_ctry,
+			i_ex_ad_line1, i_ex_ad_line2, i_ex_ad_town, i_ex_ad_zip,
+			i_ex_close, i_ex_desc, i_ex_name, i_ex_num_symb, i_ex_open };
+
 		int ret;
 		TupleDesc tupdesc;
 		SPITupleTable *tuptable = NULL;
 		HeapTuple tuple = NULL;
-		char *co_id = NULL;
+
+		Datum co_id = Int64GetDatum(0);
 		Datum args[3];
 		char nulls[3] = { ' ', ' ', ' ' };
 
-		int length_cn, length_d, length_f, length_in, length_n;
+		result_array cp_co_name, cp_in_name, fin, day, news;
 
 		strncpy(symbol,
 				DatumGetCString(DirectFunctionCall1(
 						textout, PointerGetDatum(symbol_p))),
 				S_SYMB_LEN);
 		symbol[S_SYMB_LEN] = '\0';
+
 #ifdef DEBUG
 		dump_sdf1_inputs(access_lob_flag, max_rows_to_return, "TODO", symbol);
 #endif
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		length_cn = MAX_COMP_LEN * (CO_NAME_LEN + 3) + 3;
-		length_in = MAX_COMP_LEN * (IN_NAME_LEN + 3) + 3;
-
-		values = (char **) palloc(sizeof(char *) * 45);
-		values[i_cp_co_name] = (char *) palloc(sizeof(char) * length_cn--);
-		values[i_cp_in_name] = (char *) palloc(sizeof(char) * length_in--);
-
-		length_d = (MAXDATELEN + DM_CLOSE_LEN + DM_HIGH_LEN + DM_LOW_LEN
-						   + DM_VOL_LEN + 9)
-						   * max_rows_to_return
-				   + 3;
-		values[i_day] = (char *) palloc(sizeof(char) * length_d--);
-
-		values[i_day_len] = (char *) palloc(sizeof(char) * (INTEGER_LEN + 1));
-
-		length_f
-				= (FI_YEAR_LEN + FI_QTR_LEN + MAXDATELEN + FI_REVENUE_LEN
-						  + FI_NET_EARN_LEN + FI_BASIC_EPS_LEN + FI_MARGIN_LEN
-						  + FI_INVENTORY_LEN + FI_ASSETS_LEN + FI_LIABILITY_LEN
-						  + FI_OUT_BASIC_LEN + FI_OUT_DILUT_LEN + 16)
-						  * MAX_FIN_LEN
-				  + 3;
-		values[i_fin] = (char *) palloc(length_f-- * sizeof(char));
-		values[i_fin_len] = (char *) palloc(sizeof(char) * (INTEGER_LEN + 1));
-
-		length_n = (NI_ITEM_LEN + MAXDATELEN + NI_SOURCE_LEN + NI_AUTHOR_LEN
-						   + NI_SUMMARY_LEN + NI_HEADLINE_LEN + 35)
-						   * MAX_NEWS_LEN
-				   + 3;
-		values[i_news] = (char *) palloc(sizeof(char) * length_n--);
-		values[i_news_len] = (char *) palloc(sizeof(char) * (INTEGER_LEN + 1));
-
 		/* create a function context for cross-call persistence */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -346,6 +323,21 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(SDF1_statements);
+
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 45; i++) {
+			values[i] = (Datum) 0;
+			isnull[i] = true;
+		}
+		init_result_array(
+				&cp_co_name, funcctx->tuple_desc, i_cp_co_name, MAX_COMP_LEN);
+		init_result_array(
+				&cp_in_name, funcctx->tuple_desc, i_cp_in_name, MAX_COMP_LEN);
+		init_result_array(&fin, funcctx->tuple_desc, i_fin, MAX_FIN_LEN);
+		init_result_array(
+				&day, funcctx->tuple_desc, i_day, max_rows_to_return);
+		init_result_array(&news, funcctx->tuple_desc, i_news, MAX_NEWS_LEN);
+
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLSDF1_1);
 #endif /* DEBUG */
@@ -356,161 +348,42 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		tuple = tuptable->vals[0];
-
-		values[i_s_name] = SPI_getvalue(tuple, tupdesc, 1);
-		co_id = SPI_getvalue(tuple, tupdesc, 2);
-		values[i_co_name] = SPI_getvalue(tuple, tupdesc, 3);
-		values[i_sp_rate] = SPI_getvalue(tuple, tupdesc, 4);
-		values[i_ceo_name] = SPI_getvalue(tuple, tupdesc, 5);
-		values[i_co_desc] = SPI_getvalue(tuple, tupdesc, 6);
-		values[i_open_date] = SPI_getvalue(tuple, tupdesc, 7);
-		values[i_co_st_id] = SPI_getvalue(tuple, tupdesc, 8);
-		values[i_co_ad_line1] = SPI_getvalue(tuple, tupdesc, 9);
-		values[i_co_ad_line2] = SPI_getvalue(tuple, tupdesc, 10);
-		values[i_co_ad_town] = SPI_getvalue(tuple, tupdesc, 11);
-		values[i_co_ad_div] = SPI_getvalue(tuple, tupdesc, 12);
-		values[i_co_ad_zip] = SPI_getvalue(tuple, tupdesc, 13);
-		values[i_co_ad_ctry] = SPI_getvalue(tuple, tupdesc, 14);
-		values[i_num_out] = SPI_getvalue(tuple, tupdesc, 15);
-		values[i_start_date] = SPI_getvalue(tuple, tupdesc, 16);
-		values[i_ex_date] = SPI_getvalue(tuple, tupdesc, 17);
-		values[i_pe_ratio] = SPI_getvalue(tuple, tupdesc, 18);
-		values[i_x52_wk_high] = SPI_getvalue(tuple, tupdesc, 19);
-		values[i_x52_wk_high_date] = SPI_getvalue(tuple, tupdesc, 20);
-		values[i_x52_wk_low] = SPI_getvalue(tuple, tupdesc, 21);
-		values[i_x52_wk_low_date] = SPI_getvalue(tuple, tupdesc, 22);
-		values[i_divid] = SPI_getvalue(tuple, tupdesc, 23);
-		values[i_yield] = SPI_getvalue(tuple, tupdesc, 24);
-		values[i_ex_ad_div] = SPI_getvalue(tuple, tupdesc, 25);
-		values[i_ex_ad_ctry] = SPI_getvalue(tuple, tupdesc, 26);
-		values[i_ex_ad_line1] = SPI_getvalue(tuple, tupdesc, 27);
-		values[i_ex_ad_line2] = SPI_getvalue(tuple, tupdesc, 28);
-		values[i_ex_ad_town] = SPI_getvalue(tuple, tupdesc, 29);
-		values[i_ex_ad_zip] = SPI_getvalue(tuple, tupdesc, 30);
-		values[i_ex_close] = SPI_getvalue(tuple, tupdesc, 31);
-		values[i_ex_desc] = SPI_getvalue(tuple, tupdesc, 32);
-		values[i_ex_name] = SPI_getvalue(tuple, tupdesc, 33);
-		values[i_ex_num_symb] = SPI_getvalue(tuple, tupdesc, 34);
-		values[i_ex_open] = SPI_getvalue(tuple, tupdesc, 35);
+		if (SPI_processed > 0) {
+			bool null;
+
+			tuple = tuptable->vals[0];
+			co_id = SPI_getbinval(tuple, tupdesc, 2, &null);
+			for (i = 0; i < 35; i++) {
+				if (security[i] >= 0) {
+					values[security[i]]
+							= result_column(funcctx->tuple_desc, security[i],
+									tuple, tupdesc, i + 1,
+									&isnull[security[i]]);
+				}
+			}
+		}
 
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLSDF1_2);
 #endif /* DEBUG */
-		args[0] = Int64GetDatum(atoll(co_id));
+		args[0] = co_id;
 		args[1] = Int16GetDatum(MAX_COMP_LEN);
 		ret = SPI_execute_plan(SDF1_2, args, nulls, true, 0);
 		if (ret != SPI_OK_SELECT) {
 			FAIL_FRAME_SET(&funcctx->max_calls, SDF1_statements[1].sql);
-			strncpy(values[i_cp_co_name], "{}", 3);
-			strncpy(values[i_cp_in_name], "{}", 3);
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-
-		values[i_cp_co_name][0] = '{';
-		values[i_cp_co_name][1] = '\0';
-		if (length_cn < 0) {
-			FAIL_FRAME("cp_co_name values needs to be increased");
-		}
-
-		values[i_cp_in_name][0] = '{';
-		values[i_cp_in_name][1] = '\0';
-		if (length_in < 0) {
-			FAIL_FRAME("cp_in_name values needs to be increased");
-		}
-
-		if (SPI_processed > 0) {
-			tuple = tuptable->vals[0];
-
-			strncat(values[i_cp_co_name], "\"", length_cn--);
-			if (length_cn < 0) {
-				FAIL_FRAME("cp_co_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_cp_co_name], tmp, length_cn);
-			length_cn -= strlen(tmp);
-			if (length_cn < 0) {
-				FAIL_FRAME("cp_co_name values needs to be increased");
-			}
-
-			strncat(values[i_cp_co_name], "\"", length_cn--);
-			if (length_cn < 0) {
-				FAIL_FRAME("cp_co_name values needs to be increased");
-			}
-
-			strncat(values[i_cp_in_name], "\"", length_in--);
-			if (length_in < 0) {
-				FAIL_FRAME("cp_in_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_cp_in_name], tmp, length_in--);
-			length_in -= strlen(tmp);
-			if (length_in < 0) {
-				FAIL_FRAME("cp_in_name values needs to be increased");
-			}
-
-			strncat(values[i_cp_in_name], "\"", length_in--);
-			if (length_in < 0) {
-				FAIL_FRAME("cp_in_name values needs to be increased");
-			}
-		}
-		for (i = 1; i < SPI_processed; i++) {
+		for (i = 0; i < SPI_processed; i++) {
 			tuple = tuptable->vals[i];
-
-			strncat(values[i_cp_co_name], ",\"", length_cn);
-			length_cn -= 2;
-			if (length_cn < 0) {
-				FAIL_FRAME("cp_co_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_cp_co_name], tmp, length_cn);
-			length_cn -= strlen(tmp);
-			if (length_cn < 0) {
-				FAIL_FRAME("cp_co_name values needs to be increased");
-			}
-
-			strncat(values[i_cp_co_name], "\"", length_cn--);
-			if (length_cn < 0) {
-				FAIL_FRAME("cp_co_name values needs to be increased");
-			}
-
-			strncat(values[i_cp_in_name], ",\"", length_in);
-			length_in -= 2;
-			if (length_in < 0) {
-				FAIL_FRAME("cp_in_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_cp_in_name], tmp, length_in);
-			length_in -= strlen(tmp);
-			if (length_in < 0) {
-				FAIL_FRAME("cp_in_name values needs to be increased");
-			}
-
-			strncat(values[i_cp_in_name], "\"", length_in--);
-			if (length_in < 0) {
-				FAIL_FRAME("cp_in_name values needs to be increased");
-			}
-		}
-
-		strncat(values[i_cp_co_name], "}", length_cn--);
-		if (length_cn < 0) {
-			FAIL_FRAME("cp_co_name values needs to be increased");
-		}
-
-		strncat(values[i_cp_in_name], "}", length_in--);
-		if (length_in < 0) {
-			FAIL_FRAME("cp_in_name values needs to be increased");
+			add_column(&cp_co_name, tuple, tupdesc, 1);
+			add_column(&cp_in_name, tuple, tupdesc, 2);
 		}
 
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLSDF1_3);
 #endif /* DEBUG */
-		args[0] = Int64GetDatum(atoll(co_id));
+		args[0] = co_id;
 		args[1] = Int16GetDatum(MAX_FIN_LEN);
 		ret = SPI_execute_plan(SDF1_3, args, nulls, true, 0);
 		if (ret != SPI_OK_SELECT) {
@@ -518,185 +391,9 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		snprintf(values[i_fin_len], sizeof(values[i_fin_len]), "%" PRId64,
-				SPI_processed);
-		values[i_fin][0] = '{';
-		values[i_fin][1] = '\0';
-		for (i = 0; i < SPI_processed; i++) {
-			tuple = tuptable->vals[i];
-			if (i > 0) {
-				strncat(values[i_fin], ",", length_f--);
-				if (length_f < 0) {
-					FAIL_FRAME("fin values needs to be increased");
-				}
-			}
-			strncat(values[i_fin], "\"(", length_f);
-			length_f -= 2;
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 6);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 7);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 8);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 9);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 10);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
+		for (i = 0; i < SPI_processed; i++)
+			add_record(&fin, tuptable->vals[i], tupdesc);
 
-			tmp = SPI_getvalue(tuple, tupdesc, 11);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 12);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ",", length_f--);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 13);
-			strncat(values[i_fin], tmp, length_f);
-			length_f -= strlen(tmp);
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_fin], ")\"", length_f);
-			length_f -= 2;
-			if (length_f < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-		}
-		strncat(values[i_fin], "}", length_f--);
-		if (length_f < 0) {
-			FAIL_FRAME("fin values needs to be increased");
-		}
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLSDF1_4);
 #endif /* DEBUG */
@@ -709,89 +406,8 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		snprintf(values[i_day_len], sizeof(values[i_day_len]), "%" PRId64,
-				SPI_processed);
-		values[i_day][0] = '{';
-		values[i_day][1] = '\0';
-		for (i = 0; i < SPI_processed; i++) {
-			tuple = tuptable->vals[i];
-			if (i > 0) {
-				strncat(values[i_day], ",", length_d--);
-				if (length_d < 0) {
-					FAIL_FRAME("fin values needs to be increased");
-				}
-			}
-			strncat(values[i_day], "\"(", length_d);
-			length_d -= 2;
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_day], tmp, length_d);
-			length_d -= strlen(tmp);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_day], ",", length_d--);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_day], tmp, length_d);
-			length_d -= strlen(tmp);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_day], ",", length_d--);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_day], tmp, length_d);
-			length_d -= strlen(tmp);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_day], ",", length_d--);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_day], tmp, length_d);
-			length_d -= strlen(tmp);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_day], ",", length_d--);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_day], tmp, length_d);
-			length_d -= strlen(tmp);
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-
-			strncat(values[i_day], ")\"", length_d);
-			length_d -= 2;
-			if (length_d < 0) {
-				FAIL_FRAME("fin values needs to be increased");
-			}
-		}
-		strncat(values[i_day], "}", length_d--);
-		if (length_d < 0) {
-			FAIL_FRAME("fin values needs to be increased");
-		}
+		for (i = 0; i < SPI_processed; i++)
+			add_record(&day, tuptable->vals[i], tupdesc);
 
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLSDF1_5);
@@ -800,19 +416,21 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		ret = SPI_execute_plan(SDF1_5, args, nulls, true, 0);
 		if (ret != SPI_OK_SELECT) {
 			FAIL_FRAME_SET(&funcctx->max_calls, SDF1_statements[4].sql);
-			values[i_last_open] = NULL;
-			values[i_last_price] = NULL;
-			values[i_last_vol] = NULL;
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		tuple = tuptable->vals[0];
-		values[i_last_price] = SPI_getvalue(tuple, tupdesc, 1);
-		values[i_last_open] = SPI_getvalue(tuple, tupdesc, 2);
-		values[i_last_vol] = SPI_getvalue(tuple, tupdesc, 3);
-		args[0] = Int64GetDatum(atoll(co_id));
-		args[1] = Int16GetDatum(MAX_NEWS_LEN);
+		if (SPI_processed > 0) {
+			tuple = tuptable->vals[0];
+			values[i_last_price] = result_column(funcctx->tuple_desc,
+					i_last_price, tuple, tupdesc, 1, &isnull[i_last_price]);
+			values[i_last_open] = result_column(funcctx->tuple_desc,
+					i_last_open, tuple, tupdesc, 2, &isnull[i_last_open]);
+			values[i_last_vol] = result_column(funcctx->tuple_desc,
+					i_last_vol, tuple, tupdesc, 3, &isnull[i_last_vol]);
+		}
 
+		args[0] = co_id;
+		args[1] = Int16GetDatum(MAX_NEWS_LEN);
 		if (access_lob_flag == true) {
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLSDF1_6);
@@ -831,122 +449,21 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		snprintf(values[i_news_len], sizeof(values[i_news_len]), "%" PRId64,
-				SPI_processed);
-		values[i_news][0] = '{';
-		values[i_news][1] = '\0';
-		for (i = 0; i < SPI_processed; i++) {
-			tuple = tuptable->vals[i];
-			if (i > 0) {
-				strncat(values[i_news], ",", length_n--);
-				if (length_n < 0) {
-					FAIL_FRAME("news values needs to be increased");
-				}
-			}
-			strncat(values[i_news], "\"(\\\"", length_n);
-			length_n -= 4;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_news], tmp, length_n);
-			length_n -= strlen(tmp);
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			strncat(values[i_news], "\\\",\\\"", length_n);
-			length_n -= 5;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_news], tmp, length_n);
-			length_n -= strlen(tmp);
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			strncat(values[i_news], "\\\",\\\"", length_n);
-			length_n -= 5;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_news], tmp, length_n);
-			length_n -= strlen(tmp);
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			strncat(values[i_news], "\\\",\\\"", length_n);
-			length_n -= 5;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_news], tmp, length_n);
-			length_n -= strlen(tmp);
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			strncat(values[i_news], "\\\",\\\"", length_n);
-			length_n -= 5;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_news], tmp, length_n);
-			length_n -= strlen(tmp);
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			strncat(values[i_news], "\\\",\\\"", length_n);
-			length_n -= 5;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 6);
-			strncat(values[i_news], tmp, length_n);
-			length_n -= strlen(tmp);
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-
-			strncat(values[i_news], "\\\")\"", length_n);
-			length_n -= 4;
-			if (length_n < 0) {
-				FAIL_FRAME("news values needs to be increased");
-			}
-		}
-		strncat(values[i_news], "}", length_n--);
-		if (length_n < 0) {
-			FAIL_FRAME("news values needs to be increased");
-		}
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
-		}
-
-		/*
-		 * generate attribute metadata needed later to produce tuples from raw
-		 * C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
+		for (i = 0; i < SPI_processed; i++)
+			add_record(&news, tuptable->vals[i], tupdesc);
+
+		values[i_cp_co_name] = result_array_datum(&cp_co_name);
+		values[i_cp_in_name] = result_array_datum(&cp_in_name);
+		values[i_fin] = result_array_datum(&fin);
+		values[i_fin_len] = Int32GetDatum(fin.n);
+		values[i_day] = result_array_datum(&day);
+		values[i_day_len] = Int32GetDatum(day.n);
+		values[i_news] = result_array_datum(&news);
+		values[i_news_len] = Int32GetDatum(news.n);
+		isnull[i_cp_co_name] = isnull[i_cp_in_name] = false;
+		isnull[i_fin] = isnull[i_fin_len] = false;
+		isnull[i_day] = isnull[i_day_len] = false;
+		isnull[i_news] = isnull[i_news_len] = false;
 
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -956,7 +473,6 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -964,13 +480,11 @@ SecurityDetailFrame1(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 45; i++) {
-			elog(DEBUG1, "SDF1 OUT: %d %s", i, values[i]);
-		}
+		dump_result("SDF1", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -307,7 +307,6 @@ Datum
 TradeLookupFrame1(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
@@ -315,7 +314,8 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 
 	long *trade_id;
 
-	char **values = NULL;
+	Datum values[14];
+	bool isnull[14];
 
 	enum tlf1
 	{
@@ -337,11 +337,6 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 
 	int num_found_count = 0;
 
-	/* Helper counters to determine when to add commas. */
-	int num_cash_txn = 0;
-	int num_settlement = 0;
-	int num_history = 0;
-
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
 		MemoryContext oldcontext;
@@ -360,67 +355,7 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 		Datum args[1];
 		char nulls[1] = { ' ' };
 
-		char *tmp;
-		int length_bp, length_cta, length_ctd, length_ctn, length_en,
-				length_ic, length_im, length_sa, length_scdd, length_sct,
-				length_thd, length_thsi, length_tp;
-
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 14);
-
-		length_bp = (S_PRICE_T_LEN + 1) * max_trades + 2;
-		values[i_bid_price] = (char *) palloc(length_bp-- * sizeof(char));
-
-		length_cta = (VALUE_T_LEN + 1) * max_trades + 2;
-		values[i_cash_transaction_amount]
-				= (char *) palloc(length_cta-- * sizeof(char));
-
-		length_ctd = (MYMAXDATELEN + 3) * max_trades + 2;
-		values[i_cash_transaction_dts]
-				= (char *) palloc(length_ctd-- * sizeof(char));
-
-		length_ctn = (CT_NAME_LEN + 3) * max_trades + 2;
-		values[i_cash_transaction_name]
-				= (char *) palloc(length_ctn-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 3) * max_trades + 2;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		length_ic = (BOOLEAN_LEN + 1) * max_trades + 2;
-		values[i_is_cash] = (char *) palloc(length_ic-- * sizeof(char));
-
-		length_im = (BOOLEAN_LEN + 1) * max_trades + 3;
-		values[i_is_market] = (char *) palloc(length_im-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_sa = (VALUE_T_LEN + 1) * max_trades + 2;
-		values[i_settlement_amount]
-				= (char *) palloc(length_sa-- * sizeof(char));
-
-		length_scdd = (MYMAXDATELEN + 3) * max_trades + 2;
-		values[i_settlement_cash_due_date]
-				= (char *) palloc(length_scdd-- * sizeof(char));
-
-		length_sct = (SE_CASH_TYPE_LEN + 3) * max_trades + 2;
-		values[i_settlement_cash_type]
-				= (char *) palloc(length_sct-- * sizeof(char));
-
-		length_thd = ((MYMAXDATELEN + 1) * max_trades + 3) * 3 + 2;
-		values[i_trade_history_dts]
-				= (char *) palloc(length_thd-- * sizeof(char));
-
-		length_thsi = ((ST_ID_LEN + 3) * max_trades + 3) * 3 + 2;
-		values[i_trade_history_status_id]
-				= (char *) palloc(length_thsi-- * sizeof(char));
-
-		length_tp = (S_PRICE_T_LEN + 1) * max_trades + 2;
-		values[i_trade_price] = (char *) palloc(length_tp-- * sizeof(char));
+		result_array out[14];
 
 		get_typlenbyvalalign(
 				ARR_ELEMTYPE(trade_id_p), &typlen, &typbyval, &typalign);
@@ -439,47 +374,16 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 		dump_tlf1_inputs(max_trades, trade_id_p);
 #endif
 
-		values[i_bid_price][0] = '{';
-		values[i_bid_price][1] = '\0';
-
-		values[i_cash_transaction_amount][0] = '{';
-		values[i_cash_transaction_amount][1] = '\0';
-
-		values[i_cash_transaction_dts][0] = '{';
-		values[i_cash_transaction_dts][1] = '\0';
-
-		values[i_cash_transaction_name][0] = '{';
-		values[i_cash_transaction_name][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_is_cash][0] = '{';
-		values[i_is_cash][1] = '\0';
-
-		values[i_is_market][0] = '{';
-		values[i_is_market][1] = '\0';
-
-		values[i_settlement_amount][0] = '{';
-		values[i_settlement_amount][1] = '\0';
-
-		values[i_settlement_cash_due_date][0] = '{';
-		values[i_settlement_cash_due_date][1] = '\0';
-
-		values[i_settlement_cash_type][0] = '{';
-		values[i_settlement_cash_type][1] = '\0';
-
-		values[i_trade_history_dts][0] = '{';
-		values[i_trade_history_dts][1] = '\0';
-
-		values[i_trade_history_status_id][0] = '{';
-		values[i_trade_history_status_id][1] = '\0';
-
-		values[i_trade_price][0] = '{';
-		values[i_trade_price][1] = '\0';
+		/* Room for the 3 trade history rows of each trade. */
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 14; i++) {
+			if (i != i_num_found)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, max_trades * 3);
+		}
 
 		for (i = 0; i < max_trades; i++) {
-			char *is_cash_str = NULL;
+			bool is_cash = false;
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTLF1_1);
@@ -494,98 +398,20 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				char *trade_price;
-				if (num_found_count > 0) {
-					strncat(values[i_bid_price], ",", length_bp--);
-					if (length_bp < 0) {
-						FAIL_FRAME("bid_price values needs to be increased");
-					}
-
-					strncat(values[i_exec_name], ",", length_en--);
-					if (length_en < 0) {
-						FAIL_FRAME("exec_name values needs to be increased");
-					}
-
-					strncat(values[i_is_cash], ",", length_ic--);
-					if (length_ic < 0) {
-						FAIL_FRAME("is_cash values needs to be increased");
-					}
-
-					strncat(values[i_is_market], ",", length_im--);
-					if (length_im < 0) {
-						FAIL_FRAME("is_market values needs to be increased");
-					}
-
-					strncat(values[i_trade_price], ",", length_tp--);
-					if (length_tp < 0) {
-						FAIL_FRAME("trade_price values needs to be increased");
-					}
-				}
+				bool null;
 
 				tuple = tuptable->vals[j];
 
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				length_bp -= strlen(tmp);
-				strncat(values[i_bid_price], tmp, length_bp);
-				if (length_bp < 0) {
-					FAIL_FRAME("bid_price values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], "\"", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_exec_name], tmp, length_en--);
-				length_en -= strlen(tmp);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], "\"", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				/* Use the is_cash pointer, easier to reference later. */
-				is_cash_str = SPI_getvalue(tuple, tupdesc, 3);
-				if (is_cash_str[0] == 't') {
-					strncat(values[i_is_cash], "1", length_ic--);
-				} else {
-					strncat(values[i_is_cash], "0", length_ic--);
-				}
-				if (length_ic < 0) {
-					FAIL_FRAME("is_cash values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 4);
-				if (tmp[0] == 't') {
-					strncat(values[i_is_market], "1", length_im--);
-				} else {
-					strncat(values[i_is_market], "0", length_im--);
-				}
-				if (length_im < 0) {
-					FAIL_FRAME("is_market values needs to be increased");
-				}
-
-				trade_price = SPI_getvalue(tuple, tupdesc, 5);
-				if (trade_price != NULL) {
-					tmp = SPI_getvalue(tuple, tupdesc, 5);
-					strncat(values[i_trade_price], tmp, length_tp);
-					length_tp -= strlen(tmp);
-					if (length_tp < 0) {
-						FAIL_FRAME("trade_price values needs to be increased");
-					}
-				} else {
-					strncat(values[i_trade_price], "NULL", length_tp);
-					length_tp -= 4;
-					if (length_tp < 0) {
-						FAIL_FRAME("trade_price values needs to be increased");
-					}
-				}
+				add_column(&out[i_bid_price], tuple, tupdesc, 1);
+				add_column(&out[i_exec_name], tuple, tupdesc, 2);
+				is_cash = DatumGetBool(
+						SPI_getbinval(tuple, tupdesc, 3, &null));
+				add_flag(&out[i_is_cash], is_cash);
+				add_flag(&out[i_is_market],
+						DatumGetBool(SPI_getbinval(tuple, tupdesc, 4, &null)));
+				add_column(&out[i_trade_price], tuple, tupdesc, 5);
 #ifdef DEBUG
-				elog(DEBUG1, "t_is_cash = %s", is_cash_str);
+				elog(DEBUG1, "t_is_cash = %d", is_cash);
 #endif /* DEBUG */
 
 				++num_found_count;
@@ -602,83 +428,14 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				if (num_settlement > 0) {
-					strncat(values[i_settlement_amount], ",", length_sa--);
-					if (length_sa < 0) {
-						FAIL_FRAME("settlement_amount values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_settlement_cash_due_date], ",",
-							length_scdd--);
-					if (length_scdd < 0) {
-						FAIL_FRAME("settlement_cash_due_date values needs "
-								   "to be increased");
-					}
-
-					strncat(values[i_settlement_cash_type], ",", length_sct--);
-					if (length_sct < 0) {
-						FAIL_FRAME("settlement_cash_type values needs to "
-								   "be increased");
-					}
-				}
-
 				tuple = tuptable->vals[j];
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_settlement_amount], tmp, length_sa);
-				length_sa -= strlen(tmp);
-				if (length_sa < 0) {
-					FAIL_FRAME("settlement_amount values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], "\"",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_settlement_cash_due_date], tmp, length_scdd);
-				length_scdd -= strlen(tmp);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to "
-							   "be increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], "\"",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 3);
-				strncat(values[i_settlement_cash_type], tmp, length_sct);
-				length_sct -= strlen(tmp);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				++num_settlement;
+				add_column(&out[i_settlement_amount], tuple, tupdesc, 1);
+				add_column(
+						&out[i_settlement_cash_due_date], tuple, tupdesc, 2);
+				add_column(&out[i_settlement_cash_type], tuple, tupdesc, 3);
 			}
 
-			if (is_cash_str[0] == 't') {
+			if (is_cash) {
 #ifdef DEBUG
 				elog(DEBUG1, "%s", SQLTLF1_3);
 #endif /* DEBUG */
@@ -691,100 +448,21 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 				tuptable = SPI_tuptable;
 
 				for (j = 0; j < SPI_processed; j++) {
-					if (num_cash_txn > 0) {
-						strncat(values[i_cash_transaction_amount], ",",
-								length_cta--);
-						if (length_cta < 0) {
-							FAIL_FRAME("cash_transaction_amount values "
-									   "needs to be increased");
-						}
-
-						strncat(values[i_cash_transaction_dts], ",",
-								length_ctd--);
-						if (length_ctd < 0) {
-							FAIL_FRAME("cash_transaction_dts values needs "
-									   "to be increased");
-						}
-
-						strncat(values[i_cash_transaction_name], ",",
-								length_ctn--);
-						if (length_ctn < 0) {
-							FAIL_FRAME("cash_transaction_name values "
-									   "needs to be increased");
-						}
-					}
 					tuple = tuptable->vals[j];
-
-					strncat(values[i_cash_transaction_amount], "\"",
-							length_cta--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					tmp = SPI_getvalue(tuple, tupdesc, 1);
-					strncat(values[i_cash_transaction_amount], tmp,
-							length_cta);
-					length_cta -= strlen(tmp);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs "
-								   "to be increased");
-					}
-
-					strncat(values[i_cash_transaction_amount], "\"",
-							length_cta--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to "
-								   "be increased");
-					}
-
-					tmp = SPI_getvalue(tuple, tupdesc, 2);
-					strncat(values[i_cash_transaction_dts], tmp, length_ctd);
-					length_ctd -= strlen(tmp);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to "
-								   "be increased");
-					}
-
-					tmp = SPI_getvalue(tuple, tupdesc, 3);
-					strncat(values[i_cash_transaction_name], tmp, length_ctn);
-					length_ctn -= strlen(tmp);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to "
-								   "be increased");
-					}
-
-					++num_cash_txn;
+					add_column(&out[i_cash_transaction_amount], tuple,
+							tupdesc, 1);
+					add_column(&out[i_cash_transaction_dts], tuple, tupdesc,
+							2);
+					add_column(&out[i_cash_transaction_name], tuple, tupdesc,
+							3);
 				}
 			}
+			/* Clients read a cash transaction at the position of its trade. */
+			if (!is_cash || SPI_processed == 0) {
+				add_cstring(&out[i_cash_transaction_amount], NULL);
+				add_cstring(&out[i_cash_transaction_dts], NULL);
+				add_cstring(&out[i_cash_transaction_name], NULL);
+			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTLF1_4);
@@ -796,81 +474,11 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
 
-			if (SPI_processed > 0) {
-				if (num_history > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs "
-								   "to be increased");
-					}
-				}
-			}
-
 			for (j = 0; j < SPI_processed; j++) {
 				tuple = tuptable->vals[j];
-
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs "
-								   "to be increased");
-					}
-				}
-
-				strncat(values[i_trade_history_dts], "\"", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME("trade_history_dts values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_trade_history_dts], tmp, length_thd);
-				length_thd -= strlen(tmp);
-				if (length_thd < 0) {
-					FAIL_FRAME("trade_history_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_trade_history_dts], "\"", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME("trade_history_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "\"", length_thsi);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs "
-							   "to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_trade_history_status_id], tmp, length_thsi);
-				length_thsi -= strlen(tmp);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs "
-							   "to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "\"",
-						length_thsi--);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs "
-							   "to be increased");
-				}
+				add_column(&out[i_trade_history_dts], tuple, tupdesc, 1);
+				add_column(
+						&out[i_trade_history_status_id], tuple, tupdesc, 2);
 			}
 
 			/*
@@ -879,125 +487,17 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 			 * the array up to 3 all the time.
 			 */
 			for (j = SPI_processed; j < 3; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values "
-								   "needs to be increased");
-					}
-				}
-				strncat(values[i_trade_history_dts], "NULL", length_thd);
-				length_thd -= 4;
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "\"\"",
-						length_thsi);
-				length_thsi -= 2;
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs "
-							   "to be increased");
-				}
+				add_cstring(&out[i_trade_history_dts], NULL);
+				add_cstring(&out[i_trade_history_status_id], NULL);
 			}
-
-			++num_history;
-		}
-
-		strncat(values[i_bid_price], "}", length_bp--);
-		if (length_bp < 0) {
-			FAIL_FRAME("bid_price values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_amount], "}", length_cta--);
-		if (length_cta < 0) {
-			FAIL_FRAME("cash_transaction_amount values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_cash_transaction_dts], "}", length_ctd--);
-		if (length_ctd < 0) {
-			FAIL_FRAME("cash_transaction_dts values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_name], "}", length_ctn--);
-		if (length_ctn < 0) {
-			FAIL_FRAME("cash_transaction_name values needs to be increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_is_cash], "}", length_ic--);
-		if (length_ic < 0) {
-			FAIL_FRAME("is_cash values needs to be increased");
-		}
-
-		strncat(values[i_is_market], "}", length_im--);
-		if (length_im < 0) {
-			FAIL_FRAME("is_market values needs to be increased");
 		}
 
-		strncat(values[i_settlement_amount], "}", length_sa--);
-		if (length_sa < 0) {
-			FAIL_FRAME("settlement_amount values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_due_date], "}", length_scdd--);
-		if (length_scdd < 0) {
-			FAIL_FRAME("settlement_cash_due_date values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_settlement_cash_type], "}", length_sct--);
-		if (length_sct < 0) {
-			FAIL_FRAME("settlement_cash_type values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_dts], "}", length_thd--);
-		if (length_thd < 0) {
-			FAIL_FRAME("trade_history_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_status_id], "}", length_thsi--);
-		if (length_thsi < 0) {
-			FAIL_FRAME("trade_history_status_id values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_trade_price], "}", length_tp--);
-		if (length_tp < 0) {
-			FAIL_FRAME("trade_price values needs to be increased");
-		}
-
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found_count);
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 14; i++) {
+			values[i] = i == i_num_found ? Int32GetDatum(num_found_count)
+										 : result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from
-		 * raw C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -1006,7 +506,6 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -1014,13 +513,11 @@ TradeLookupFrame1(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 14; i++) {
-			elog(DEBUG1, "TLF1 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TLF1", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -1038,13 +535,13 @@ Datum
 TradeLookupFrame2(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 
-	char **values = NULL;
+	Datum values[14];
+	bool isnull[14];
 
 	enum tlf2
 	{
@@ -1086,16 +583,9 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 		HeapTuple tuple = NULL;
 
 		int num_found_count = 0;
-		int num_settlements = 0;
-		int num_cash_txn = 0;
-		int num_trade_history = 0;
-
-		char *is_cash_str;
 
 		int j;
-		int length_bp, length_cta, length_ctd, length_ctn, length_en,
-				length_ic, length_sa, length_scdd, length_sct, length_thd,
-				length_thsi, length_tl, length_tp;
+		result_array out[14];
 
 		if (timestamp2tm(end_trade_dts_ts, NULL, tm, &fsec, NULL, NULL) == 0) {
 			EncodeDateTimeM(tm, fsec, tzn, end_trade_dts);
@@ -1109,63 +599,6 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 		dump_tlf2_inputs(acct_id, end_trade_dts, max_trades, start_trade_dts);
 #endif /* DEBUG */
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 14);
-
-		length_bp = (S_PRICE_T_LEN + 1) * 20 + 2;
-		values[i_bid_price] = (char *) palloc(length_bp-- * sizeof(char));
-
-		length_cta = (VALUE_T_LEN + 1) * 20 + 2;
-		values[i_cash_transaction_amount]
-				= (char *) palloc(length_cta-- * sizeof(char));
-
-		length_ctd = (MYMAXDATELEN + 1) * 20 + 2;
-		values[i_cash_transaction_dts]
-				= (char *) palloc(length_ctd-- * sizeof(char));
-
-		length_ctn = (CT_NAME_LEN + 3) * 20 + 2;
-		values[i_cash_transaction_name]
-				= (char *) palloc(length_ctn-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 1) * 20 + 3;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		length_ic = (BOOLEAN_LEN + 1) * 20 + 2;
-		values[i_is_cash] = (char *) palloc(length_ic-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_sa = (VALUE_T_LEN + 1) * 20 + 2;
-		values[i_settlement_amount]
-				= (char *) palloc(length_sa-- * sizeof(char));
-
-		length_scdd = (MYMAXDATELEN + 1) * 20 + 2;
-		values[i_settlement_cash_due_date]
-				= (char *) palloc(length_scdd-- * sizeof(char));
-
-		length_sct = (SE_CASH_TYPE_LEN + 1) * 20 + 2;
-		values[i_settlement_cash_type]
-				= (char *) palloc(length_sct-- * sizeof(char));
-
-		length_thd = (MYMAXDATELEN + 1) * 60 + 2;
-		values[i_trade_history_dts]
-				= (char *) palloc(length_thd-- * sizeof(char));
-
-		length_thsi = (ST_ID_LEN + 1) * 60 + 2;
-		values[i_trade_history_status_id]
-				= (char *) palloc(length_thsi-- * sizeof(char));
-
-		length_tl = (TRADE_T_LEN + 1) * 20 + 2;
-		values[i_trade_list] = (char *) palloc(length_tl-- * sizeof(char));
-
-		length_tp = (S_PRICE_T_LEN + 1) * 20 + 2;
-		values[i_trade_price] = (char *) palloc(length_tp-- * sizeof(char));
-
 		/* create a function context for cross-call persistence */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -1177,6 +610,14 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 		SPI_connect();
 		plan_queries(TLF2_statements);
 
+		/* Room for the 3 trade history rows of each trade. */
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 14; i++) {
+			if (i != i_num_found)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, max_trades * 3);
+		}
+
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLTLF2_1);
 #endif /* DEBUG */
@@ -1195,137 +636,32 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
 		num_found_count = SPI_processed;
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found_count);
 
 #ifdef DEBUG
 		elog(DEBUG1, "num_found = %d", num_found_count);
 #endif /* DEBUG */
 
-		values[i_bid_price][0] = '{';
-		values[i_bid_price][1] = '\0';
-
-		values[i_cash_transaction_amount][0] = '{';
-		values[i_cash_transaction_amount][1] = '\0';
-
-		values[i_cash_transaction_dts][0] = '{';
-		values[i_cash_transaction_dts][1] = '\0';
-
-		values[i_cash_transaction_name][0] = '{';
-		values[i_cash_transaction_name][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_is_cash][0] = '{';
-		values[i_is_cash][1] = '\0';
-
-		values[i_settlement_amount][0] = '{';
-		values[i_settlement_amount][1] = '\0';
-
-		values[i_settlement_cash_due_date][0] = '{';
-		values[i_settlement_cash_due_date][1] = '\0';
-
-		values[i_settlement_cash_type][0] = '{';
-		values[i_settlement_cash_type][1] = '\0';
-
-		values[i_trade_history_dts][0] = '{';
-		values[i_trade_history_dts][1] = '\0';
-
-		values[i_trade_history_status_id][0] = '{';
-		values[i_trade_history_status_id][1] = '\0';
-
-		values[i_trade_list][0] = '{';
-		values[i_trade_list][1] = '\0';
-
-		values[i_trade_price][0] = '{';
-		values[i_trade_price][1] = '\0';
-
 		for (i = 0; i < num_found_count; i++) {
-			char *tmp;
 			TupleDesc tupdesc2;
 			SPITupleTable *tuptable2 = NULL;
 			HeapTuple tuple2 = NULL;
 
-			char *trade_list_str;
+			bool is_cash;
+			bool null;
 
 			tuple = tuptable->vals[i];
 
-			if (i > 0) {
-				strncat(values[i_bid_price], ",", length_bp--);
-				if (length_bp < 0) {
-					FAIL_FRAME("bid_price values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], ",", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_is_cash], ",", length_ic--);
-				if (length_ic < 0) {
-					FAIL_FRAME("is_cash values needs to be increased");
-				}
-
-				strncat(values[i_trade_list], ",", length_tl--);
-				if (length_tl < 0) {
-					FAIL_FRAME("trade_list values needs to be increased");
-				}
-
-				strncat(values[i_trade_price], ",", length_tp--);
-				if (length_tp < 0) {
-					FAIL_FRAME("trade_price values needs to be increased");
-				}
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_bid_price], tmp, length_bp);
-			length_bp -= strlen(tmp);
-			if (length_bp < 0) {
-				FAIL_FRAME("bid_price values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_exec_name], tmp, length_en--);
-			length_en -= strlen(tmp);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			is_cash_str = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_is_cash], (is_cash_str[0] == 't' ? "0" : "1"),
-					length_ic--);
-			if (length_ic < 0) {
-				FAIL_FRAME("is_cash values needs to be increased");
-			}
-
-			trade_list_str = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_trade_list], trade_list_str, length_tl);
-			length_tl -= strlen(trade_list_str);
-			if (length_tl < 0) {
-				FAIL_FRAME("trade_list values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_trade_price], tmp, length_tp);
-			length_tp -= strlen(tmp);
-			if (length_tp < 0) {
-				FAIL_FRAME("trade_price values needs to be increased");
-			}
+			add_column(&out[i_bid_price], tuple, tupdesc, 1);
+			add_column(&out[i_exec_name], tuple, tupdesc, 2);
+			is_cash = DatumGetBool(SPI_getbinval(tuple, tupdesc, 3, &null));
+			add_flag(&out[i_is_cash], is_cash);
+			add_column(&out[i_trade_list], tuple, tupdesc, 4);
+			add_column(&out[i_trade_price], tuple, tupdesc, 5);
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTLF2_2);
 #endif /* DEBUG */
-			args[0] = Int64GetDatum(atoll(trade_list_str));
+			args[0] = SPI_getbinval(tuple, tupdesc, 4, &null);
 			ret = SPI_execute_plan(TLF2_2, args, nulls, true, 0);
 			if (ret != SPI_OK_SELECT) {
 #ifdef DEBUG
@@ -1335,61 +671,17 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 				FAIL_FRAME_SET(&funcctx->max_calls, TLF2_statements[1].sql);
 				continue;
 			}
+			tupdesc2 = SPI_tuptable->tupdesc;
+			tuptable2 = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				tupdesc2 = SPI_tuptable->tupdesc;
-				tuptable2 = SPI_tuptable;
-				++num_settlements;
-
-				if (num_settlements > 1) {
-					strncat(values[i_settlement_amount], ",", length_sa--);
-					if (length_sa < 0) {
-						FAIL_FRAME("settlement_amount values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_settlement_cash_due_date], ",",
-							length_scdd--);
-					if (length_scdd < 0) {
-						FAIL_FRAME(
-								"settlement_cash_due_date values needs to be "
-								"increased");
-					}
-
-					strncat(values[i_settlement_cash_type], ",", length_sct--);
-					if (length_sct < 0) {
-						FAIL_FRAME("settlement_cash_type values needs to be "
-								   "increased");
-					}
-				}
-
 				tuple2 = tuptable2->vals[j];
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 1);
-				strncat(values[i_settlement_amount], tmp, length_sa);
-				length_sa -= strlen(tmp);
-				if (length_sa < 0) {
-					FAIL_FRAME(
-							"settlement_amount values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 2);
-				strncat(values[i_settlement_cash_due_date], tmp, length_scdd);
-				length_scdd -= strlen(tmp);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 3);
-				strncat(values[i_settlement_cash_type], tmp, length_sct);
-				length_sct -= strlen(tmp);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
+				add_column(&out[i_settlement_amount], tuple2, tupdesc2, 1);
+				add_column(
+						&out[i_settlement_cash_due_date], tuple2, tupdesc2, 2);
+				add_column(&out[i_settlement_cash_type], tuple2, tupdesc2, 3);
 			}
 
-			if (is_cash_str[0] == 't') {
+			if (is_cash) {
 #ifdef DEBUG
 				elog(DEBUG1, "%s", SQLTLF2_3);
 #endif /* DEBUG */
@@ -1407,85 +699,20 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 				tuptable2 = SPI_tuptable;
 				for (j = 0; j < SPI_processed; j++) {
 					tuple2 = tuptable2->vals[j];
-					++num_cash_txn;
-
-					if (num_cash_txn > 1) {
-						strncat(values[i_cash_transaction_amount], ",",
-								length_cta--);
-						if (length_cta < 0) {
-							FAIL_FRAME("cash_transaction_amount values needs "
-									   "to be increased");
-						}
-
-						strncat(values[i_cash_transaction_dts], ",",
-								length_ctd--);
-						if (length_ctd < 0) {
-							FAIL_FRAME("cash_transaction_dts values needs to "
-									   "be increased");
-						}
-
-						strncat(values[i_cash_transaction_name], ",",
-								length_ctn--);
-						if (length_ctn < 0) {
-							FAIL_FRAME("cash_transaction_name values needs to "
-									   "be increased");
-						}
-					}
-
-					tmp = SPI_getvalue(tuple2, tupdesc2, 1);
-					strncat(values[i_cash_transaction_amount], tmp,
-							length_cta);
-					length_cta -= strlen(tmp);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(tuple2, tupdesc2, 2);
-					strncat(values[i_cash_transaction_dts], tmp, length_ctd);
-					length_ctd -= strlen(tmp);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(tuple2, tupdesc2, 3);
-					strncat(values[i_cash_transaction_name], tmp, length_ctn);
-					length_ctn -= strlen(tmp);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
+					add_column(&out[i_cash_transaction_amount], tuple2,
+							tupdesc2, 1);
+					add_column(&out[i_cash_transaction_dts], tuple2, tupdesc2,
+							2);
+					add_column(&out[i_cash_transaction_name], tuple2,
+							tupdesc2, 3);
 				}
 			}
+			/* Clients read a cash transaction at the position of its trade. */
+			if (!is_cash || SPI_processed == 0) {
+				add_cstring(&out[i_cash_transaction_amount], NULL);
+				add_cstring(&out[i_cash_transaction_dts], NULL);
+				add_cstring(&out[i_cash_transaction_name], NULL);
+			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTLF2_4);
@@ -1505,167 +732,22 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 
 			for (j = 0; j < SPI_processed; j++) {
 				tuple2 = tuptable2->vals[j];
-
-				++num_trade_history;
-
-				if (num_trade_history > 1) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME(
-								"trade_history_status_id values needs to be "
-								"increased");
-					}
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 1);
-				strncat(values[i_trade_history_dts], tmp, length_thd);
-				length_thd -= strlen(tmp);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 2);
-				strncat(values[i_trade_history_status_id], tmp, length_thsi);
-				length_thsi -= strlen(tmp);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
+				add_column(&out[i_trade_history_dts], tuple2, tupdesc2, 1);
+				add_column(
+						&out[i_trade_history_status_id], tuple2, tupdesc2, 2);
 			}
 			for (j = SPI_processed; j < 3; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						elog(DEBUG1,
-								"TUF2 trade_history_status_id out of space: "
-								"%s",
-								values[i_trade_history_status_id]);
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
-				}
-				strncat(values[i_trade_history_dts], "NULL", length_thd);
-				length_thd -= 4;
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "NULL",
-						length_thsi);
-				length_thsi -= 4;
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-#ifdef DEBUG
-				elog(DEBUG1, "TUF2 trade_history_dts[%d][%d] %s", i, j,
-						values[i_trade_history_dts]);
-				elog(DEBUG1, "TUF2 trade_history_status_id[%d][%d] %s", i, j,
-						values[i_trade_history_status_id]);
-#endif /* DEBUG */
+				add_cstring(&out[i_trade_history_dts], NULL);
+				add_cstring(&out[i_trade_history_status_id], NULL);
 			}
 		}
 
-		strncat(values[i_bid_price], "}", length_bp--);
-		if (length_bp < 0) {
-			FAIL_FRAME("bid_price values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_amount], "}", length_cta--);
-		if (length_cta < 0) {
-			FAIL_FRAME("cash_transaction_amount values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_cash_transaction_dts], "}", length_ctd--);
-		if (length_ctd < 0) {
-			FAIL_FRAME("cash_transaction_dts values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_name], "}", length_ctn--);
-		if (length_ctn < 0) {
-			FAIL_FRAME("cash_transaction_name values needs to be increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_is_cash], "}", length_ic--);
-		if (length_ic < 0) {
-			FAIL_FRAME("is_cash values needs to be increased");
-		}
-
-		strncat(values[i_settlement_amount], "}", length_sa--);
-		if (length_sa < 0) {
-			FAIL_FRAME("settlement_amount values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_due_date], "}", length_scdd--);
-		if (length_scdd < 0) {
-			FAIL_FRAME("settlement_cash_due_date values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_settlement_cash_type], "}", length_sct--);
-		if (length_sct < 0) {
-			FAIL_FRAME("settlement_cash_type values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_dts], "}", length_thd--);
-		if (length_thd < 0) {
-			FAIL_FRAME("trade_history_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_status_id], "}", length_thsi--);
-		if (length_thsi < 0) {
-			FAIL_FRAME("trade_history_status_id values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_trade_list], "}", length_tl--);
-		if (length_tl < 0) {
-			FAIL_FRAME("trade_list values needs to be increased");
-		}
-
-		strncat(values[i_trade_price], "}", length_tp--);
-		if (length_tp < 0) {
-			FAIL_FRAME("trade_price values needs to be increased");
-		}
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 14; i++) {
+			values[i] = i == i_num_found ? Int32GetDatum(num_found_count)
+										 : result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from
-		 * raw C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -1674,7 +756,6 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -1682,13 +763,11 @@ TradeLookupFrame2(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 14; i++) {
-			elog(DEBUG1, "TLF2 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TLF2", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -1705,13 +784,13 @@ Datum
 TradeLookupFrame3(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 
-	char **values = NULL;
+	Datum values[17];
+	bool isnull[17];
 
 	enum tlf3
 	{
@@ -1762,18 +841,9 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 		HeapTuple tuple = NULL;
 
 		int num_found_count = 0;
-		int num_settlements = 0;
-		int num_cash_txn = 0;
-		int num_trade_history = 0;
-
-		char *is_cash_str;
 
 		int j;
-		char *tmp;
-		int length_ai, length_cta, length_ctd, length_ctn, length_en,
-				length_ic, length_p, length_q, length_sa, length_scdd,
-				length_sct, length_td, length_tl, length_thd, length_thsi,
-				length_tt;
+		result_array out[17];
 
 		if (timestamp2tm(end_trade_dts_ts, NULL, tm, &fsec, NULL, NULL) == 0) {
 			EncodeDateTimeM(tm, fsec, tzn, end_trade_dts);
@@ -1792,73 +862,6 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 				start_trade_dts, symbol);
 #endif /* DEBUG */
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 17);
-
-		length_ai = (IDENT_T_LEN + 1) * max_trades + 2;
-		values[i_acct_id] = (char *) palloc(length_ai-- * sizeof(char));
-
-		length_cta = (VALUE_T_LEN + 1) * max_trades + 2;
-		values[i_cash_transaction_amount]
-				= (char *) palloc(length_cta-- * sizeof(char));
-
-		length_ctd = (MYMAXDATELEN + 1) * max_trades + 2;
-
-		values[i_cash_transaction_dts]
-				= (char *) palloc(length_ctd-- * sizeof(char));
-
-		length_ctn = (CT_NAME_LEN + 3) * max_trades + 2;
-		values[i_cash_transaction_name]
-				= (char *) palloc(length_ctn-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 3) * max_trades + 2;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		length_ic = (BOOLEAN_LEN + 1) * max_trades + 2;
-		values[i_is_cash] = (char *) palloc(length_ic-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_p = (S_PRICE_T_LEN + 1) * max_trades + 2;
-		values[i_price] = (char *) palloc(length_p-- * sizeof(char));
-
-		length_q = (INTEGER_LEN + 1) * max_trades + 2;
-		values[i_quantity] = (char *) palloc(length_q-- * sizeof(char));
-
-		length_sa = (VALUE_T_LEN + 1) * max_trades + 2;
-		values[i_settlement_amount]
-				= (char *) palloc(length_sa-- * sizeof(char));
-
-		length_scdd = (MYMAXDATELEN + 1) * max_trades + 2;
-		values[i_settlement_cash_due_date]
-				= (char *) palloc(length_scdd-- * sizeof(char));
-
-		length_sct = (SE_CASH_TYPE_LEN + 3) * max_trades + 2;
-		values[i_settlement_cash_type]
-				= (char *) palloc(length_sct-- * sizeof(char));
-
-		length_td = (MYMAXDATELEN * 3 + 4) * max_trades + max_trades + 2;
-		values[i_trade_dts] = (char *) palloc(length_td-- * sizeof(char));
-
-		length_thd = (MYMAXDATELEN * 3 + 4) * max_trades + max_trades + 2;
-		values[i_trade_history_dts]
-				= (char *) palloc(length_thd-- * sizeof(char));
-
-		length_thsi = (ST_ID_LEN + 3) * max_trades * 3 + 2;
-		values[i_trade_history_status_id]
-				= (char *) palloc(length_thsi-- * sizeof(char));
-
-		length_tl = (TRADE_T_LEN + 1) * max_trades + 2;
-		values[i_trade_list] = (char *) palloc(length_tl-- * sizeof(char));
-
-		length_tt = (TT_ID_LEN + 3) * max_trades + 2;
-		values[i_trade_type] = (char *) palloc(length_tt-- * sizeof(char));
-
 		/* create a function context for cross-call persistence */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -1869,6 +872,15 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(TLF3_statements);
+
+		/* Room for the 3 trade history rows of each trade. */
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 17; i++) {
+			if (i != i_num_found)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, max_trades * 3);
+		}
+
 #ifdef DEBUG
 		elog(DEBUG1, "SQLTLF3_1\n%s", SQLTLF3_1);
 		elog(DEBUG1, "$1 %s", symbol);
@@ -1891,201 +903,35 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
 		num_found_count = SPI_processed;
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found_count);
 
 #ifdef DEBUG
 		elog(DEBUG1, "num_found = %d", num_found_count);
 #endif /* DEBUG */
 
-		values[i_acct_id][0] = '{';
-		values[i_acct_id][1] = '\0';
-
-		values[i_cash_transaction_amount][0] = '{';
-		values[i_cash_transaction_amount][1] = '\0';
-
-		values[i_cash_transaction_dts][0] = '{';
-		values[i_cash_transaction_dts][1] = '\0';
-
-		values[i_cash_transaction_name][0] = '{';
-		values[i_cash_transaction_name][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_is_cash][0] = '{';
-		values[i_is_cash][1] = '\0';
-
-		values[i_price][0] = '{';
-		values[i_price][1] = '\0';
-
-		values[i_quantity][0] = '{';
-		values[i_quantity][1] = '\0';
-
-		values[i_settlement_amount][0] = '{';
-		values[i_settlement_amount][1] = '\0';
-
-		values[i_settlement_cash_due_date][0] = '{';
-		values[i_settlement_cash_due_date][1] = '\0';
-
-		values[i_settlement_cash_type][0] = '{';
-		values[i_settlement_cash_type][1] = '\0';
-
-		values[i_trade_dts][0] = '{';
-		values[i_trade_dts][1] = '\0';
-
-		values[i_trade_history_dts][0] = '{';
-		values[i_trade_history_dts][1] = '\0';
-
-		values[i_trade_history_status_id][0] = '{';
-		values[i_trade_history_status_id][1] = '\0';
-
-		values[i_trade_list][0] = '{';
-		values[i_trade_list][1] = '\0';
-
-		values[i_trade_type][0] = '{';
-		values[i_trade_type][1] = '\0';
-
 		for (i = 0; i < num_found_count; i++) {
 			TupleDesc tupdesc2;
 			SPITupleTable *tuptable2 = NULL;
 			HeapTuple tuple2 = NULL;
 
-			char *trade_list_str;
+			bool null;
 
 			tuple = tuptable->vals[i];
-			if (i > 0) {
-				strncat(values[i_acct_id], ",", length_ai--);
-				if (length_ai < 0) {
-					FAIL_FRAME("acct_id values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], ",", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_is_cash], ",", length_ic--);
-				if (length_ic < 0) {
-					FAIL_FRAME("is_cash values needs to be increased");
-				}
-
-				strncat(values[i_price], ",", length_p--);
-				if (length_p < 0) {
-					FAIL_FRAME("price values needs to be increased");
-				}
-
-				strncat(values[i_quantity], ",", length_q--);
-				if (length_q < 0) {
-					FAIL_FRAME("quantity values needs to be increased");
-				}
-
-				strncat(values[i_trade_dts], ",", length_td--);
-				if (length_td < 0) {
-					FAIL_FRAME("trade_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_list], ",", length_tl--);
-				if (length_tl < 0) {
-					FAIL_FRAME("trade_list values needs to be increased");
-				}
-
-				strncat(values[i_trade_type], ",", length_tt--);
-				if (length_tt < 0) {
-					FAIL_FRAME("trade_type values needs to be increased");
-				}
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_acct_id], tmp, length_ai);
-			length_ai -= strlen(tmp);
-			if (length_ai < 0) {
-				FAIL_FRAME("acct_id values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_exec_name], tmp, length_en--);
-			length_en -= strlen(tmp);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
 
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			is_cash_str = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_is_cash], (is_cash_str[0] == 't' ? "0" : "1"),
-					length_ic--);
-			if (length_ic < 0) {
-				FAIL_FRAME("is_cash values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_price], tmp, length_p);
-			length_p -= strlen(tmp);
-			if (length_p < 0) {
-				FAIL_FRAME("price values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_quantity], tmp, length_q);
-			length_q -= strlen(tmp);
-			if (length_q < 0) {
-				FAIL_FRAME("quantity values needs to be increased");
-			}
-
-			strncat(values[i_trade_dts], "\"", length_td--);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 6);
-			strncat(values[i_trade_dts], tmp, length_td);
-			length_td -= strlen(tmp);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			strncat(values[i_trade_dts], "\"", length_td--);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			trade_list_str = SPI_getvalue(tuple, tupdesc, 7);
-			strncat(values[i_trade_list], trade_list_str, length_tl);
-			length_tl -= strlen(trade_list_str);
-			if (length_tl < 0) {
-				FAIL_FRAME("trade_list values needs to be increased");
-			}
-
-			strncat(values[i_trade_type], "\"", length_tt--);
-			if (length_tt < 0) {
-				FAIL_FRAME("trade_type values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 8);
-			strncat(values[i_trade_type], tmp, length_tt);
-			length_tt -= strlen(tmp);
-			if (length_tt < 0) {
-				FAIL_FRAME("trade_type values needs to be increased");
-			}
-
-			strncat(values[i_trade_type], "\"", length_tt--);
-			if (length_tt < 0) {
-				FAIL_FRAME("trade_type values needs to be increased");
-			}
+			add_column(&out[i_acct_id], tuple, tupdesc, 1);
+			add_column(&out[i_exec_name], tuple, tupdesc, 2);
+			add_flag(&out[i_is_cash],
+					DatumGetBool(SPI_getbinval(tuple, tupdesc, 3, &null)));
+			add_column(&out[i_price], tuple, tupdesc, 4);
+			add_column(&out[i_quantity], tuple, tupdesc, 5);
+			add_column(&out[i_trade_dts], tuple, tupdesc, 6);
+			add_column(&out[i_trade_list], tuple, tupdesc, 7);
+			add_column(&out[i_trade_type], tuple, tupdesc, 8);
 
 #ifdef DEBUG
 			elog(DEBUG1, "SQLTLF3_2\n%s", SQLTLF3_2);
-			elog(DEBUG1, "$1 %s", trade_list_str);
+			elog(DEBUG1, "$1 %s", SPI_getvalue(tuple, tupdesc, 7));
 #endif /* DEBUG */
-			args[0] = Int64GetDatum(atoll(trade_list_str));
+			args[0] = SPI_getbinval(tuple, tupdesc, 7, &null);
 			ret = SPI_execute_plan(TLF3_2, args, nulls, true, 0);
 			if (ret != SPI_OK_SELECT) {
 #ifdef DEBUG
@@ -2095,86 +941,19 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 				FAIL_FRAME_SET(&funcctx->max_calls, TLF3_statements[1].sql);
 				continue;
 			}
+			tupdesc2 = SPI_tuptable->tupdesc;
+			tuptable2 = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				tupdesc2 = SPI_tuptable->tupdesc;
-				tuptable2 = SPI_tuptable;
 				tuple2 = tuptable2->vals[j];
-				++num_settlements;
-
-				if (num_settlements > 1) {
-					strncat(values[i_settlement_amount], ",", length_sa--);
-					if (length_sa < 0) {
-						FAIL_FRAME("settlement_amount values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_settlement_cash_due_date], ",",
-							length_scdd--);
-					if (length_scdd < 0) {
-						FAIL_FRAME("settlement_cash_due_date values needs "
-								   "to be increased");
-					}
-
-					strncat(values[i_settlement_cash_type], ",", length_sct--);
-					if (length_sct < 0) {
-						FAIL_FRAME("settlement_cash_type values needs to "
-								   "be increased");
-					}
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 1);
-				strncat(values[i_settlement_amount], tmp, length_sa--);
-				if (length_sa < 0) {
-					FAIL_FRAME("settlement_amount values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], "\"",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to "
-							   "be increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 2);
-				strncat(values[i_settlement_cash_due_date], tmp, length_scdd);
-				length_scdd -= strlen(tmp);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to "
-							   "be increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], "\"",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to "
-							   "be increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 3);
-				strncat(values[i_settlement_cash_type], tmp, length_sct);
-				length_sct -= strlen(tmp);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
+				add_column(&out[i_settlement_amount], tuple2, tupdesc2, 1);
+				add_column(
+						&out[i_settlement_cash_due_date], tuple2, tupdesc2, 2);
+				add_column(&out[i_settlement_cash_type], tuple2, tupdesc2, 3);
 			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "SQLTLF3_3\n%s", SQLTLF3_3);
-			elog(DEBUG1, "$1 %s", trade_list_str);
+			elog(DEBUG1, "$1 %s", SPI_getvalue(tuple, tupdesc, 7));
 #endif /* DEBUG */
 			ret = SPI_execute_plan(TLF3_3, args, nulls, true, 0);
 			if (ret != SPI_OK_SELECT) {
@@ -2185,87 +964,26 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 				FAIL_FRAME_SET(&funcctx->max_calls, TLF3_statements[2].sql);
 				continue;
 			}
+			tupdesc2 = SPI_tuptable->tupdesc;
+			tuptable2 = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				tupdesc2 = SPI_tuptable->tupdesc;
-				tuptable2 = SPI_tuptable;
 				tuple2 = tuptable2->vals[j];
-
-				if (num_cash_txn > 0) {
-					strncat(values[i_cash_transaction_amount], ",",
-							length_cta--);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs "
-								   "to be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], ",", length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_name], ",",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to "
-								   "be increased");
-					}
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 1);
-				strncat(values[i_cash_transaction_amount], tmp, length_cta);
-				length_cta -= strlen(tmp);
-				if (length_cta < 0) {
-					FAIL_FRAME("cash_transaction_amount values needs to "
-							   "be increased");
-				}
-
-				strncat(values[i_cash_transaction_dts], "\"", length_ctd--);
-				if (length_ctd < 0) {
-					FAIL_FRAME("cash_transaction_dts values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 2);
-				strncat(values[i_cash_transaction_dts], tmp, length_ctd--);
-				length_ctd -= strlen(tmp);
-				if (length_ctd < 0) {
-					FAIL_FRAME("cash_transaction_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_cash_transaction_dts], "\"", length_ctd--);
-				if (length_ctd < 0) {
-					FAIL_FRAME("cash_transaction_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_cash_transaction_name], "\"", length_ctn--);
-				if (length_ctn < 0) {
-					FAIL_FRAME("cash_transaction_name values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 3);
-				strncat(values[i_cash_transaction_name], tmp, length_ctn);
-				length_ctn -= strlen(tmp);
-				if (length_ctn < 0) {
-					FAIL_FRAME("cash_transaction_name values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_cash_transaction_name], "\"", length_ctn--);
-				if (length_ctn < 0) {
-					FAIL_FRAME("cash_transaction_name values needs to be "
-							   "increased");
-				}
-
-				++num_cash_txn;
+				add_column(
+						&out[i_cash_transaction_amount], tuple2, tupdesc2, 1);
+				add_column(&out[i_cash_transaction_dts], tuple2, tupdesc2, 2);
+				add_column(
+						&out[i_cash_transaction_name], tuple2, tupdesc2, 3);
+			}
+			/* Clients read a cash transaction at the position of its trade. */
+			if (SPI_processed == 0) {
+				add_cstring(&out[i_cash_transaction_amount], NULL);
+				add_cstring(&out[i_cash_transaction_dts], NULL);
+				add_cstring(&out[i_cash_transaction_name], NULL);
 			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "SQLTLF3_4\n%s", SQLTLF3_4);
-			elog(DEBUG1, "$1 %s", trade_list_str);
+			elog(DEBUG1, "$1 %s", SPI_getvalue(tuple, tupdesc, 7));
 #endif /* DEBUG */
 			ret = SPI_execute_plan(TLF3_4, args, nulls, true, 0);
 			if (ret != SPI_OK_SELECT) {
@@ -2278,66 +996,12 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 			}
 			tupdesc2 = SPI_tuptable->tupdesc;
 			tuptable2 = SPI_tuptable;
-			tuple2 = tuptable2->vals[j];
 
 			for (j = 0; j < SPI_processed; j++) {
-				++num_trade_history;
-				if (num_trade_history > 1) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs "
-								   "to be increased");
-					}
-				}
-
-				strncat(values[i_trade_history_dts], "\"", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME("trade_history_dts values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 1);
-				strncat(values[i_trade_history_dts], tmp, length_thd);
-				length_thd -= strlen(tmp);
-				if (length_thd < 0) {
-					FAIL_FRAME("trade_history_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_trade_history_dts], "\"", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME("trade_history_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "\"",
-						length_thsi--);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to "
-							   "be increased");
-				}
-
-				tmp = SPI_getvalue(tuple2, tupdesc2, 2);
-				strncat(values[i_trade_history_status_id], tmp, length_thsi);
-				length_thsi -= strlen(tmp);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to "
-							   "be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "\"",
-						length_thsi--);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to "
-							   "be increased");
-				}
+				tuple2 = tuptable2->vals[j];
+				add_column(&out[i_trade_history_dts], tuple2, tupdesc2, 1);
+				add_column(
+						&out[i_trade_history_status_id], tuple2, tupdesc2, 2);
 			}
 
 			/*
@@ -2346,137 +1010,17 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 			 * the array up to 3 all the time.
 			 */
 			for (j = SPI_processed; j < 3; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values "
-								   "needs to be increased");
-					}
-				}
-				strncat(values[i_trade_history_dts], "NULL", length_thd);
-				length_thd -= 4;
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "NULL",
-						length_thsi);
-				length_thsi -= 4;
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs "
-							   "to be increased");
-				}
+				add_cstring(&out[i_trade_history_dts], NULL);
+				add_cstring(&out[i_trade_history_status_id], NULL);
 			}
 		}
 
-		strncat(values[i_acct_id], "}", length_ai--);
-		if (length_ai < 0) {
-			FAIL_FRAME("acct_id values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_amount], "}", length_cta--);
-		if (length_cta < 0) {
-			FAIL_FRAME("cash_transaction_amount values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_cash_transaction_dts], "}", length_ctd--);
-		if (length_ctd < 0) {
-			FAIL_FRAME("cash_transaction_dts values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_name], "}", length_ctn--);
-		if (length_ctn < 0) {
-			FAIL_FRAME("cash_transaction_name values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_is_cash], "}", length_ic);
-		if (length_ic < 0) {
-			FAIL_FRAME("is_cash values needs to be increased");
-		}
-
-		strncat(values[i_price], "}", length_p--);
-		if (length_p < 0) {
-			FAIL_FRAME("price values needs to be increased");
-		}
-
-		strncat(values[i_quantity], "}", length_q--);
-		if (length_q < 0) {
-			FAIL_FRAME("quantity values needs to be increased");
-		}
-
-		strncat(values[i_settlement_amount], "}", length_sa--);
-		if (length_sa < 0) {
-			FAIL_FRAME("settlement_amount values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_due_date], "}", length_scdd--);
-		if (length_scdd < 0) {
-			FAIL_FRAME("settlement_cash_due_date values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_settlement_cash_type], "}", length_sct--);
-		if (length_sct < 0) {
-			FAIL_FRAME("settlement_cash_type values needs to be increased");
-		}
-
-		strncat(values[i_trade_dts], "}", length_td--);
-		if (length_td < 0) {
-			FAIL_FRAME("trade_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_dts], "}", length_thd--);
-		if (length_thd < 0) {
-			FAIL_FRAME("trade_history_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_status_id], "}", length_thsi--);
-		if (length_thsi < 0) {
-			FAIL_FRAME("trade_history_status_id values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_trade_list], "}", length_tl--);
-		if (length_tl < 0) {
-			FAIL_FRAME("trade_list values needs to be increased");
-		}
-
-		strncat(values[i_trade_type], "}", length_tt--);
-		if (length_tt < 0) {
-			FAIL_FRAME("trade_type values needs to be increased");
-		}
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 17; i++) {
+			values[i] = i == i_num_found ? Int32GetDatum(num_found_count)
+										 : result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from
-		 * raw C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -2485,7 +1029,6 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -2493,13 +1036,11 @@ TradeLookupFrame3(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 17; i++) {
-			elog(DEBUG1, "TLF3 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TLF3", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -2517,13 +1058,13 @@ Datum
 TradeLookupFrame4(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 
-	char **values = NULL;
+	Datum values[7];
+	bool isnull[7];
 
 	enum tlf4
 	{
@@ -2557,8 +1098,7 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 		SPITupleTable *tuptable = NULL;
 		HeapTuple tuple = NULL;
 
-		char *tmp;
-		int length_hhi, length_hhti, length_qa, length_qb;
+		result_array out[7];
 
 		if (timestamp2tm(start_trade_dts_ts, NULL, tm, &fsec, NULL, NULL)
 				== 0) {
@@ -2569,33 +1109,6 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 		dump_tlf4_inputs(acct_id, start_trade_dts);
 #endif /* DEBUG */
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 7);
-
-		length_hhi = (TRADE_T_LEN + 1) * 20 + 2;
-		values[i_holding_history_id]
-				= (char *) palloc(length_hhi-- * sizeof(char));
-
-		length_hhti = (TRADE_T_LEN + 1) * 20 + 2;
-		values[i_holding_history_trade_id]
-				= (char *) palloc(length_hhti-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-		values[i_num_trades_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_qa = (S_QTY_T_LEN + 1) * 20 + 2;
-		values[i_quantity_after] = (char *) palloc(length_qa-- * sizeof(char));
-
-		length_qb = (S_QTY_T_LEN + 1) * 20 + 2;
-		values[i_quantity_before]
-				= (char *) palloc(length_qb-- * sizeof(char));
-
 		/* create a function context for cross-call persistence */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -2606,6 +1119,17 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(TLF4_statements);
+
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		init_result_array(&out[i_holding_history_id], funcctx->tuple_desc,
+				i_holding_history_id, 20);
+		init_result_array(&out[i_holding_history_trade_id],
+				funcctx->tuple_desc, i_holding_history_trade_id, 20);
+		init_result_array(&out[i_quantity_after], funcctx->tuple_desc,
+				i_quantity_after, 20);
+		init_result_array(&out[i_quantity_before], funcctx->tuple_desc,
+				i_quantity_before, 20);
+
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLTLF4_1);
 #endif /* DEBUG */
@@ -2613,7 +1137,6 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 		args[1] = TimestampGetDatum(start_trade_dts_ts);
 		ret = SPI_execute_plan(TLF4_1, args, nulls, true, 0);
 		if (ret != SPI_OK_SELECT) {
-			values[i_trade_id] = NULL;
 #ifdef DEBUG
 			dump_tlf4_inputs(acct_id, start_trade_dts);
 #endif /* DEBUG */
@@ -2623,16 +1146,19 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 		tuptable = SPI_tuptable;
 		if (SPI_processed > 0) {
 			tuple = tuptable->vals[0];
-			values[i_trade_id] = SPI_getvalue(tuple, tupdesc, 1);
-		} else
-			values[i_trade_id] = NULL;
+			values[i_trade_id] = SPI_getbinval(
+					tuple, tupdesc, 1, &isnull[i_trade_id]);
+		} else {
+			values[i_trade_id] = (Datum) 0;
+			isnull[i_trade_id] = true;
+		}
 		num_trades_found_count = SPI_processed;
 
-		if (values[i_trade_id] != NULL) {
+		if (!isnull[i_trade_id]) {
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTLF4_2);
 #endif /* DEBUG */
-			args[0] = Int64GetDatum(atoll(values[i_trade_id]));
+			args[0] = values[i_trade_id];
 			ret = SPI_execute_plan(TLF4_2, args, nulls, true, 0);
 			if (ret != SPI_OK_SELECT) {
 #ifdef DEBUG
@@ -2646,120 +1172,30 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 		} else
 			num_found_count = 0;
 
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found_count);
-		snprintf(values[i_num_trades_found], INTEGER_LEN, "%d",
-				num_trades_found_count);
 #ifdef DEBUG
 		elog(DEBUG1, "num_found = %d", num_found_count);
 		elog(DEBUG1, "num_trades_found = %d", num_trades_found_count);
 #endif /* DEBUG */
 
-		values[i_holding_history_id][0] = '{';
-		values[i_holding_history_id][1] = '\0';
-
-		values[i_holding_history_trade_id][0] = '{';
-		values[i_holding_history_trade_id][1] = '\0';
-
-		values[i_quantity_after][0] = '{';
-		values[i_quantity_after][1] = '\0';
-
-		values[i_quantity_before][0] = '{';
-		values[i_quantity_before][1] = '\0';
-
 		for (i = 0; i < num_found_count; i++) {
 			tuple = tuptable->vals[i];
-			if (i > 0) {
-				strncat(values[i_holding_history_id], ",", length_hhi--);
-				if (length_hhi < 0) {
-					FAIL_FRAME("holding_history_id values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_holding_history_trade_id], ",",
-						length_hhti--);
-				if (length_hhti < 0) {
-					FAIL_FRAME("holding_history_trade_id values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_quantity_after], ",", length_qa--);
-				if (length_qa < 0) {
-					FAIL_FRAME("quantify_after values needs to be increased");
-				}
-
-				strncat(values[i_quantity_before], ",", length_qb--);
-				if (length_qb < 0) {
-					FAIL_FRAME("quantify_before values needs to be "
-							   "increased");
-				}
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_holding_history_id], tmp, length_hhi);
-			length_hhi -= strlen(tmp);
-			if (length_hhi < 0) {
-				FAIL_FRAME("holding_history_id values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_holding_history_trade_id], tmp, length_hhti);
-			length_hhti -= strlen(tmp);
-			if (length_hhti < 0) {
-				FAIL_FRAME("holding_history_trade_id values needs to be "
-						   "increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_quantity_after], tmp, length_qa--);
-			length_qa -= strlen(tmp);
-			if (length_qa < 0) {
-				FAIL_FRAME("quantify_after values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_quantity_before], tmp, length_qb);
-			length_qb -= strlen(tmp);
-			if (length_qb < 0) {
-				FAIL_FRAME("quantify_before values needs to be increased");
-			}
-		}
-
-		strncat(values[i_holding_history_id], "}", length_hhi--);
-		if (length_hhi < 0) {
-			FAIL_FRAME("holding_history_id values needs to be increased");
-		}
-
-		strncat(values[i_holding_history_trade_id], "}", length_hhti--);
-		if (length_hhti < 0) {
-			FAIL_FRAME("holding_history_trade_id values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_quantity_after], "}", length_qa--);
-		if (length_qa < 0) {
-			FAIL_FRAME("quantify_after values needs to be increased");
-		}
-
-		strncat(values[i_quantity_before], "}", length_qb--);
-		if (length_qb < 0) {
-			FAIL_FRAME("quantify_before values needs to be increased");
+			add_column(&out[i_holding_history_id], tuple, tupdesc, 1);
+			add_column(&out[i_holding_history_trade_id], tuple, tupdesc, 2);
+			add_column(&out[i_quantity_before], tuple, tupdesc, 3);
+			add_column(&out[i_quantity_after], tuple, tupdesc, 4);
 		}
 
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
-		}
-
-		/*
-		 * generate attribute metadata needed later to produce tuples from
-		 * raw C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
+		values[i_holding_history_id]
+				= result_array_datum(&out[i_holding_history_id]);
+		values[i_holding_history_trade_id]
+				= result_array_datum(&out[i_holding_history_trade_id]);
+		values[i_num_found] = Int32GetDatum(num_found_count);
+		values[i_num_trades_found] = Int32GetDatum(num_trades_found_count);
+		values[i_quantity_after] = result_array_datum(&out[i_quantity_after]);
+		values[i_quantity_before]
+				= result_array_datum(&out[i_quantity_before]);
+		for (i = 0; i < i_trade_id; i++)
+			isnull[i] = false;
 
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -2769,7 +1205,6 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -2777,13 +1212,11 @@ TradeLookupFrame4(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 7; i++) {
-			elog(DEBUG1, "TLF4 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TLF4", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
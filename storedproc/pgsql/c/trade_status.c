@@ -9,7 +9,6 @@
 
 #include <sys/types.h>
 #include <unistd.h>
-#include <inttypes.h>
 #include <postgres.h>
 #include <fmgr.h>
 #include <executor/spi.h> /* this should include most necessary APIs */
@@ -97,13 +96,13 @@ Datum
 TradeStatusFrame1(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 
-	char **values = NULL;
+	Datum values[14];
+	bool isnull[14];
 
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
@@ -113,8 +112,8 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 		{
 			i_broker_name = 0,
 			i_charge,
-			i_cust_f_name,
 			i_cust_l_name,
+			i_cust_f_name,
 			i_ex_name,
 			i_exec_name,
 			i_num_found,
@@ -127,6 +126,11 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 			i_type_name
 		};
 
+		/* Result arrays of the columns of SQLTSF1_1, in order. */
+		const int trade[10] = { i_trade_id, i_trade_dts, i_status_name,
+			i_type_name, i_symbol, i_trade_qty, i_exec_name, i_charge,
+			i_s_name, i_ex_name };
+
 		long acct_id = PG_GETARG_INT64(0);
 
 		int ret;
@@ -136,52 +140,8 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 		Datum args[1];
 		char nulls[1] = { ' ' };
 
-		char *tmp;
-		int length_c, length_en, length_en2, length_s, length_sn, length_sn2,
-				length_td, length_ti, length_tn, length_tq;
-
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 */
-		values = (char **) palloc(sizeof(char *) * 14);
-
-		length_c = (VALUE_T_LEN + 1) * 50;
-		values[i_charge] = (char *) palloc(length_c-- * sizeof(char));
-
-		length_en2 = (EX_NAME_LEN + 3) * 50;
-		values[i_ex_name] = (char *) palloc(length_en2-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 3) * 50;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		values[i_num_found] = (char *) palloc((BIGINT_LEN + 1) * sizeof(char));
-
-		length_sn2 = (S_NAME_LEN + 3) * 50;
-		values[i_s_name] = (char *) palloc(length_sn2-- * sizeof(char));
-
-		length_sn = (ST_NAME_LEN + 3) * 50;
-		values[i_status_name] = (char *) palloc(length_sn-- * sizeof(char));
-
-		length_s = (S_SYMB_LEN + 3) * 50;
-		values[i_symbol] = (char *) palloc(length_s-- * sizeof(char));
-
-		length_td = (MAXDATELEN + 1) * 50;
-		values[i_trade_dts] = (char *) palloc(length_td-- * sizeof(char));
-
-		length_ti = (BIGINT_LEN + 1) * 50;
-		values[i_trade_id] = (char *) palloc(length_ti-- * sizeof(char));
-
-		length_tq = (INTEGER_LEN + 1) * 50;
-		values[i_trade_qty] = (char *) palloc(length_tq-- * sizeof(char));
-
-		length_tn = (TT_NAME_LEN + 3) * 50;
-		values[i_type_name] = (char *) palloc(length_tn-- * sizeof(char));
-
-		values[i_cust_l_name] = NULL;
-		values[i_cust_f_name] = NULL;
-		values[i_broker_name] = NULL;
+		int j;
+		result_array out[10];
 
 #ifdef DEBUG
 		dump_tsf1_inputs(acct_id);
@@ -196,6 +156,11 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(TSF1_statements);
+
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 10; i++)
+			init_result_array(&out[i], funcctx->tuple_desc, trade[i], 50);
+
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLTSF1_1);
 #endif /* DEBUG */
@@ -206,271 +171,18 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 		}
 		tupdesc = SPI_tuptable->tupdesc;
 		tuptable = SPI_tuptable;
-		snprintf(values[i_num_found], BIGINT_LEN, "%" PRId64, SPI_processed);
-
-		values[i_trade_id][0] = '{';
-		values[i_trade_id][1] = '\0';
-
-		values[i_trade_dts][0] = '{';
-		values[i_trade_dts][1] = '\0';
-
-		values[i_status_name][0] = '{';
-		values[i_status_name][1] = '\0';
-
-		values[i_type_name][0] = '{';
-		values[i_type_name][1] = '\0';
-
-		values[i_symbol][0] = '{';
-		values[i_symbol][1] = '\0';
-
-		values[i_trade_qty][0] = '{';
-		values[i_trade_qty][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_charge][0] = '{';
-		values[i_charge][1] = '\0';
-
-		values[i_s_name][0] = '{';
-		values[i_s_name][1] = '\0';
-
-		values[i_ex_name][0] = '{';
-		values[i_ex_name][1] = '\0';
+		values[i_num_found] = Int32GetDatum(SPI_processed);
+		isnull[i_num_found] = false;
 
 		for (i = 0; i < SPI_processed; i++) {
 			tuple = tuptable->vals[i];
-			if (i > 0) {
-				strncat(values[i_trade_id], ",", length_ti--);
-				if (length_ti < 0) {
-					FAIL_FRAME("trade_id values needs to be increased");
-				}
-
-				strncat(values[i_trade_dts], ",", length_td--);
-				if (length_td < 0) {
-					FAIL_FRAME("trade_dts values needs to be increased");
-				}
-
-				strncat(values[i_status_name], ",", length_sn--);
-				if (length_sn < 0) {
-					FAIL_FRAME("status_name values needs to be increased");
-				}
-
-				strncat(values[i_type_name], ",", length_tn--);
-				if (length_tn < 0) {
-					FAIL_FRAME("type_name values needs to be increased");
-				}
-
-				strncat(values[i_symbol], ",", length_s--);
-				if (length_s < 0) {
-					FAIL_FRAME("symbol values needs to be increased");
-				}
-
-				strncat(values[i_trade_qty], ",", length_tq--);
-				if (length_tq < 0) {
-					FAIL_FRAME("trade_qty values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], ",", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_charge], ",", length_c--);
-				if (length_c < 0) {
-					FAIL_FRAME("charge values needs to be increased");
-				}
-
-				strncat(values[i_s_name], ",", length_sn2--);
-				if (length_sn2 < 0) {
-					FAIL_FRAME("s_name values needs to be increased");
-				}
-
-				strncat(values[i_ex_name], ",", length_en2--);
-				if (length_en2 < 0) {
-					FAIL_FRAME("ex_name values needs to be increased");
-				}
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_trade_id], tmp, length_ti);
-			length_ti -= strlen(tmp);
-			if (length_ti < 0) {
-				FAIL_FRAME("trade_id values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_trade_dts], tmp, length_td);
-			length_td -= strlen(tmp);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			strncat(values[i_status_name], "\"", length_sn--);
-			if (length_sn < 0) {
-				FAIL_FRAME("status_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 3);
-			strncat(values[i_status_name], tmp, length_sn);
-			length_sn -= strlen(tmp);
-			if (length_sn < 0) {
-				FAIL_FRAME("status_name values needs to be increased");
-			}
-
-			strncat(values[i_status_name], "\"", length_sn--);
-			if (length_sn < 0) {
-				FAIL_FRAME("status_name values needs to be increased");
-			}
-
-			strncat(values[i_type_name], "\"", length_tn--);
-			if (length_tn < 0) {
-				FAIL_FRAME("type_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_type_name], tmp, length_tn);
-			length_tn -= strlen(tmp);
-			if (length_tn < 0) {
-				FAIL_FRAME("type_name values needs to be increased");
-			}
-
-			strncat(values[i_type_name], "\"", length_tn--);
-			if (length_tn < 0) {
-				FAIL_FRAME("type_name values needs to be increased");
-			}
-
-			strncat(values[i_symbol], "\"", length_s--);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_symbol], tmp, length_s);
-			length_s -= strlen(tmp);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			strncat(values[i_symbol], "\"", length_s--);
-			if (length_s < 0) {
-				FAIL_FRAME("symbol values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 6);
-			strncat(values[i_trade_qty], tmp, length_tq);
-			length_tq -= strlen(tmp);
-			if (length_tq < 0) {
-				FAIL_FRAME("trade_qty values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 7);
-			strncat(values[i_exec_name], tmp, length_en);
-			length_en -= strlen(tmp);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 8);
-			strncat(values[i_charge], tmp, length_c);
-			length_c -= strlen(tmp);
-			if (length_c < 0) {
-				FAIL_FRAME("charge values needs to be increased");
-			}
-
-			strncat(values[i_s_name], "\"", length_sn2--);
-			if (length_sn2 < 0) {
-				FAIL_FRAME("s_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 9);
-			strncat(values[i_s_name], tmp, length_sn2);
-			length_sn2 -= strlen(tmp);
-			if (length_sn2 < 0) {
-				FAIL_FRAME("s_name values needs to be increased");
-			}
-
-			strncat(values[i_s_name], "\"", length_sn2--);
-			if (length_sn2 < 0) {
-				FAIL_FRAME("s_name values needs to be increased");
-			}
-
-			strncat(values[i_ex_name], "\"", length_en2--);
-			if (length_en2 < 0) {
-				FAIL_FRAME("ex_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 10);
-			strncat(values[i_ex_name], tmp, length_en2);
-			length_en2 -= strlen(tmp);
-			if (length_en2 < 0) {
-				FAIL_FRAME("ex_name values needs to be increased");
-			}
-
-			strncat(values[i_ex_name], "\"", length_en2--);
-			if (length_en2 < 0) {
-				FAIL_FRAME("ex_name values needs to be increased");
-			}
-		}
-
-		strncat(values[i_trade_id], "}", length_ti--);
-		if (length_ti < 0) {
-			FAIL_FRAME("trade_id values needs to be increased");
-		}
-
-		strncat(values[i_trade_dts], "}", length_td--);
-		if (length_td < 0) {
-			FAIL_FRAME("trade_dts values needs to be increased");
-		}
-
-		strncat(values[i_status_name], "}", length_sn--);
-		if (length_sn < 0) {
-			FAIL_FRAME("status_name values needs to be increased");
-		}
-
-		strncat(values[i_type_name], "}", length_tn--);
-		if (length_tn < 0) {
-			FAIL_FRAME("type_name values needs to be increased");
-		}
-
-		strncat(values[i_symbol], "}", length_s--);
-		if (length_s < 0) {
-			FAIL_FRAME("symbol values needs to be increased");
-		}
-
-		strncat(values[i_trade_qty], "}", length_tq--);
-		if (length_tq < 0) {
-			FAIL_FRAME("trade_qty values needs to be increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_charge], "}", length_c--);
-		if (length_c < 0) {
-			FAIL_FRAME("charge values needs to be increased");
-		}
-
-		strncat(values[i_s_name], "}", length_sn2--);
-		if (length_sn2 < 0) {
-			FAIL_FRAME("s_name values needs to be increased");
+			for (j = 0; j < 10; j++)
+				add_column(&out[j], tuple, tupdesc, j + 1);
 		}
 
-		strncat(values[i_ex_name], "}", length_en2--);
-		if (length_en2 < 0) {
-			FAIL_FRAME("ex_name values needs to be increased");
+		for (i = 0; i < 10; i++) {
+			values[trade[i]] = result_array_datum(&out[i]);
+			isnull[trade[i]] = false;
 		}
 
 #ifdef DEBUG
@@ -484,25 +196,17 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 		tuptable = SPI_tuptable;
 		if (SPI_processed > 0) {
 			tuple = tuptable->vals[0];
-			values[i_cust_l_name] = SPI_getvalue(tuple, tupdesc, 1);
-			values[i_cust_f_name] = SPI_getvalue(tuple, tupdesc, 2);
-			values[i_broker_name] = SPI_getvalue(tuple, tupdesc, 3);
+			values[i_cust_l_name] = result_column(funcctx->tuple_desc,
+					i_cust_l_name, tuple, tupdesc, 1, &isnull[i_cust_l_name]);
+			values[i_cust_f_name] = result_column(funcctx->tuple_desc,
+					i_cust_f_name, tuple, tupdesc, 2, &isnull[i_cust_f_name]);
+			values[i_broker_name] = result_column(funcctx->tuple_desc,
+					i_broker_name, tuple, tupdesc, 3, &isnull[i_broker_name]);
+		} else {
+			isnull[i_cust_l_name] = true;
+			isnull[i_cust_f_name] = true;
+			isnull[i_broker_name] = true;
 		}
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
-		}
-
-		/*
-		 * generate attribute metadata needed later to produce tuples from raw
-		 * C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
 
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -512,7 +216,6 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -520,13 +223,11 @@ TradeStatusFrame1(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 14; i++) {
-			elog(DEBUG1, "TSF1 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TSF1", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -181,6 +181,10 @@ PG_MODULE_MAGIC;
 #define TUF3_5 TUF3_statements[4].plan
 #define TUF3_6 TUF3_statements[5].plan
 
+/*
+ * No statement runs read-only: the frames return rows they have just
+ * updated, which a read-only statement would still see as they were.
+ */
 static cached_statement TUF1_statements[] = {
 
 	{ SQLTUF1_1, 1, { INT8OID } },
@@ -299,14 +303,14 @@ Datum
 TradeUpdateFrame1(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 	int j;
 
-	char **values = NULL;
+	Datum values[15];
+	bool isnull[15];
 
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
@@ -350,80 +354,13 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 
 		int num_found = 0;
 		int num_updated = 0;
-		int num_updated4 = 0;
-		int num_updated5 = 0;
-		int num_updated7 = 0;
-		int num_cash = 0;
 
-		char *tmp;
-		int length_bp, length_cta, length_ctd, length_ctn, length_en,
-				length_ic, length_im, length_sa, length_scdd, length_sct,
-				length_thd, length_thsi, length_tp;
+		result_array out[15];
 
 		get_typlenbyvalalign(
 				ARR_ELEMTYPE(trade_id_p), &typlen, &typbyval, &typalign);
 		trade_id = (long *) ARR_DATA_PTR(trade_id_p);
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 * Don't forget to factor in commas (,) and braces ({}) for the arrays.
-		 */
-		values = (char **) palloc(sizeof(char *) * 15);
-
-		length_bp = (S_PRICE_T_LEN + 1) * 20 + 2;
-		values[i_bid_price] = (char *) palloc(length_bp-- * sizeof(char));
-
-		length_cta = ((VALUE_T_LEN + 1) * 20 + 2);
-		values[i_cash_transaction_amount]
-				= (char *) palloc(length_cta-- * sizeof(char));
-
-		length_ctd = (MAXDATELEN + 3) * 20 + 2;
-		values[i_cash_transaction_dts]
-				= (char *) palloc(length_ctd-- * sizeof(char));
-
-		length_ctn = (CT_NAME_LEN + 3) * 20 + 2;
-		values[i_cash_transaction_name]
-				= (char *) palloc(length_ctn-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 3) * 20 + 2;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		length_ic = (SMALLINT_LEN + 1) * 20 + 2;
-		values[i_is_cash] = (char *) palloc(length_ic-- * sizeof(char));
-
-		length_im = (SMALLINT_LEN + 1) * 20 + 3;
-		values[i_is_market] = (char *) palloc(length_im-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-		values[i_num_updated]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_sa = (VALUE_T_LEN + 1) * 20 + 2;
-		values[i_settlement_amount]
-				= (char *) palloc(length_sa-- * sizeof(char));
-
-		length_scdd = (MAXDATELEN + 1) * 20 + 2;
-		values[i_settlement_cash_due_date]
-				= (char *) palloc(length_scdd-- * sizeof(char));
-
-		length_sct = (SE_CASH_TYPE_LEN + 3) * 20 + 2;
-		values[i_settlement_cash_type]
-				= (char *) palloc(length_sct-- * sizeof(char));
-
-		length_thd = (MAXDATELEN + 2) * 60 + 62;
-		values[i_trade_history_dts]
-				= (char *) palloc(length_thd-- * sizeof(char));
-
-		length_thsi = (ST_ID_LEN) * 60 + 62;
-		values[i_trade_history_status_id]
-				= (char *) palloc(length_thsi-- * sizeof(char));
-
-		length_tp = (S_PRICE_T_LEN + 1) * 20 + 2;
-		values[i_trade_price] = (char *) palloc(length_tp-- * sizeof(char));
-
 #ifdef DEBUG
 		dump_tuf1_inputs(max_trades, max_updates, trade_id);
 #endif
@@ -438,48 +375,16 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 		SPI_connect();
 		plan_queries(TUF1_statements);
 
-		values[i_bid_price][0] = '{';
-		values[i_bid_price][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_is_cash][0] = '{';
-		values[i_is_cash][1] = '\0';
-
-		values[i_is_market][0] = '{';
-		values[i_is_market][1] = '\0';
-
-		values[i_trade_price][0] = '{';
-		values[i_trade_price][1] = '\0';
-
-		values[i_settlement_amount][0] = '{';
-		values[i_settlement_amount][1] = '\0';
-
-		values[i_settlement_cash_due_date][0] = '{';
-		values[i_settlement_cash_due_date][1] = '\0';
-
-		values[i_settlement_cash_type][0] = '{';
-		values[i_settlement_cash_type][1] = '\0';
-
-		values[i_cash_transaction_amount][0] = '{';
-		values[i_cash_transaction_amount][1] = '\0';
-
-		values[i_cash_transaction_dts][0] = '{';
-		values[i_cash_transaction_dts][1] = '\0';
-
-		values[i_cash_transaction_name][0] = '{';
-		values[i_cash_transaction_name][1] = '\0';
-
-		values[i_trade_history_dts][0] = '{';
-		values[i_trade_history_dts][1] = '\0';
-
-		values[i_trade_history_status_id][0] = '{';
-		values[i_trade_history_status_id][1] = '\0';
+		/* Room for the 3 trade history rows of each trade. */
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 15; i++) {
+			if (i != i_num_found && i != i_num_updated)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, max_trades * 3);
+		}
 
 		for (i = 0; i < max_trades; i++) {
-			char *is_cash_str = NULL;
-			char *is_market_str;
+			bool is_cash = false;
 
 			if (num_updated < max_updates) {
 				char *ex_name;
@@ -488,7 +393,7 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 				elog(DEBUG1, "%s", SQLTUF1_1);
 #endif /* DEBUG */
 				args[0] = Int64GetDatum(trade_id[i]);
-				ret = SPI_execute_plan(TUF1_1, args, nulls, true, 0);
+				ret = SPI_execute_plan(TUF1_1, args, nulls, false, 0);
 				if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 					tupdesc = SPI_tuptable->tupdesc;
 					tuptable = SPI_tuptable;
@@ -505,19 +410,20 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 					elog(DEBUG1, "%s", SQLTUF1_2a);
 					elog(DEBUG1, "ex_name = %s", ex_name);
 #endif /* DEBUG */
-					ret = SPI_execute_plan(TUF1_2a, args, nulls, true, 0);
+					ret = SPI_execute_plan(TUF1_2a, args, nulls, false, 0);
 				} else {
 #ifdef DEBUG
 					elog(DEBUG1, "%s", SQLTUF1_2b);
 					elog(DEBUG1, "ex_name = %s", ex_name);
 #endif /* DEBUG */
-					ret = SPI_execute_plan(TUF1_2b, args, nulls, true, 0);
+					ret = SPI_execute_plan(TUF1_2b, args, nulls, false, 0);
 				}
 				if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 					tupdesc = SPI_tuptable->tupdesc;
 					tuptable = SPI_tuptable;
 					tuple = tuptable->vals[0];
 					ex_name = SPI_getvalue(tuple, tupdesc, 1);
+					args[0] = CStringGetTextDatum(ex_name);
 				} else {
 					FAIL_FRAME_SET(&funcctx->max_calls,
 							strstr(ex_name, " X ") ? TUF1_statements[1].sql
@@ -532,7 +438,7 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 				ret = SPI_execute_plan(TUF1_3, args, nulls, false, 0);
 				if (ret != SPI_OK_UPDATE) {
 					FAIL_FRAME_SET(
-							&funcctx->max_calls, TUF1_statements[4].sql);
+							&funcctx->max_calls, TUF1_statements[3].sql);
 					continue;
 				}
 
@@ -544,456 +450,108 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 #endif /* DEBUG */
 			args[0] = Int64GetDatum(trade_id[i]);
 			args[1] = Int32GetDatum(max_trades);
-			ret = SPI_execute_plan(TUF1_4, args, nulls, true, 0);
+			ret = SPI_execute_plan(TUF1_4, args, nulls, false, 0);
 			if (ret != SPI_OK_SELECT) {
-				FAIL_FRAME_SET(&funcctx->max_calls, TUF1_statements[5].sql);
+				FAIL_FRAME_SET(&funcctx->max_calls, TUF1_statements[4].sql);
 				continue;
 			}
 
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				char *trade_price;
-				if (num_updated4 > 0) {
-					strncat(values[i_bid_price], ",", length_bp--);
-					if (length_bp < 0) {
-						FAIL_FRAME("bid_price values needs to be increased");
-					}
-
-					strncat(values[i_exec_name], ",", length_en--);
-					if (length_en < 0) {
-						FAIL_FRAME("exec_name values needs to be increased");
-					}
-
-					strncat(values[i_is_cash], ",", length_ic--);
-					if (length_ic < 0) {
-						FAIL_FRAME("is_cash values needs to be increased");
-					}
-
-					strncat(values[i_is_market], ",", length_im--);
-					if (length_im < 0) {
-						FAIL_FRAME("is_market values needs to be increased");
-					}
-
-					strncat(values[i_trade_price], ",", length_tp--);
-					if (length_tp < 0) {
-						FAIL_FRAME("trade_price values needs to be increased");
-					}
-				}
+				bool null;
 
 				tuple = tuptable->vals[j];
 
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_bid_price], tmp, length_bp);
-				length_bp -= strlen(tmp);
-				if (length_bp < 0) {
-					FAIL_FRAME("bid_price values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], "\"", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_exec_name], tmp, length_en);
-				length_en -= strlen(tmp);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], "\"", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				is_cash_str = SPI_getvalue(tuple, tupdesc, 3);
-				if (is_cash_str[0] == 't') {
-					strncat(values[i_is_cash], "1", length_ic--);
-				} else {
-					strncat(values[i_is_cash], "0", length_ic--);
-				}
-				if (length_ic < 0) {
-					FAIL_FRAME("is_cash values needs to be increased");
-				}
-
-				is_market_str = SPI_getvalue(tuple, tupdesc, 4);
-				if (is_market_str[0] == 't') {
-					strncat(values[i_is_market], "1", length_im--);
-				} else {
-					strncat(values[i_is_market], "0", length_im--);
-				}
-				if (length_im < 0) {
-					FAIL_FRAME("is_market values needs to be increased");
-				}
-
-				trade_price = SPI_getvalue(tuple, tupdesc, 5);
-				if (trade_price != NULL) {
-					tmp = SPI_getvalue(tuple, tupdesc, 5);
-					strncat(values[i_trade_price], tmp, length_tp);
-					length_tp -= strlen(tmp);
-					if (length_tp < 0) {
-						FAIL_FRAME("trade_price values needs to be increased");
-					}
-				} else {
-					strncat(values[i_trade_price], "NULL", length_tp);
-					length_tp -= 4;
-					if (length_tp < 0) {
-						FAIL_FRAME("trade_price values needs to be increased");
-					}
-				}
-
-				num_updated4++;
+				add_column(&out[i_bid_price], tuple, tupdesc, 1);
+				add_column(&out[i_exec_name], tuple, tupdesc, 2);
+				is_cash = DatumGetBool(
+						SPI_getbinval(tuple, tupdesc, 3, &null));
+				add_flag(&out[i_is_cash], is_cash);
+				add_flag(&out[i_is_market],
+						DatumGetBool(SPI_getbinval(tuple, tupdesc, 4, &null)));
+				add_column(&out[i_trade_price], tuple, tupdesc, 5);
 			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTUF1_5);
 #endif /* DEBUG */
-			ret = SPI_execute_plan(TUF1_5, args, nulls, true, 0);
+			ret = SPI_execute_plan(TUF1_5, args, nulls, false, 0);
 			if (ret != SPI_OK_SELECT) {
-				FAIL_FRAME_SET(&funcctx->max_calls, TUF1_statements[6].sql);
+				FAIL_FRAME_SET(&funcctx->max_calls, TUF1_statements[5].sql);
 				continue;
 			}
 
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
 			for (j = 0; j < SPI_processed; j++) {
-				if (num_updated5 > 0) {
-					strncat(values[i_settlement_amount], ",", length_sa--);
-					if (length_sa < 0) {
-						FAIL_FRAME("settlement_amount values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_settlement_cash_due_date], ",",
-							length_scdd--);
-					if (length_scdd < 0) {
-						FAIL_FRAME("settlement_cash_due_date values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_settlement_cash_type], ",", length_sct--);
-					if (length_sct < 0) {
-						FAIL_FRAME("settlement_cash_type values needs to be "
-								   "increased");
-					}
-				}
-
 				tuple = tuptable->vals[j];
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_settlement_amount], tmp, length_sa);
-				length_sa -= strlen(tmp);
-				if (length_sa < 0) {
-					FAIL_FRAME(
-							"settlement_amount values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_settlement_cash_due_date], tmp, length_scdd);
-				length_scdd -= strlen(tmp);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 3);
-				strncat(values[i_settlement_cash_type], tmp, length_sct);
-				length_sct -= strlen(tmp);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				num_updated5++;
+				add_column(&out[i_settlement_amount], tuple, tupdesc, 1);
+				add_column(
+						&out[i_settlement_cash_due_date], tuple, tupdesc, 2);
+				add_column(&out[i_settlement_cash_type], tuple, tupdesc, 3);
 			}
 
-			if (is_cash_str[0] == 't') {
-				if (num_cash > 0) {
-					strncat(values[i_cash_transaction_amount], ",",
-							length_cta--);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], ",", length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], ",",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-				}
-
+			if (is_cash) {
 #ifdef DEBUG
 				elog(DEBUG1, "%s", SQLTUF1_6);
 #endif /* DEBUG */
-				ret = SPI_execute_plan(TUF1_6, args, nulls, true, 0);
+				ret = SPI_execute_plan(TUF1_6, args, nulls, false, 0);
 				if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 					tupdesc = SPI_tuptable->tupdesc;
 					tuptable = SPI_tuptable;
 					tuple = tuptable->vals[0];
-
-					tmp = SPI_getvalue(tuple, tupdesc, 1);
-					strncat(values[i_cash_transaction_amount], tmp,
-							length_cta);
-					length_cta -= strlen(tmp);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(tuple, tupdesc, 2);
-					strncat(values[i_cash_transaction_dts], tmp, length_ctd);
-					length_ctd -= strlen(tmp);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(tuple, tupdesc, 3);
-					strncat(values[i_cash_transaction_name], tmp, length_ctn);
-					length_ctn -= strlen(tmp);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					++num_cash;
+					add_column(&out[i_cash_transaction_amount], tuple,
+							tupdesc, 1);
+					add_column(
+							&out[i_cash_transaction_dts], tuple, tupdesc, 2);
+					add_column(
+							&out[i_cash_transaction_name], tuple, tupdesc, 3);
 				} else {
 					FAIL_FRAME_SET(
-							&funcctx->max_calls, TUF1_statements[7].sql);
+							&funcctx->max_calls, TUF1_statements[6].sql);
 					continue;
 				}
+			} else {
+				/* Clients read a cash transaction at the position of its
+				 * trade. */
+				add_cstring(&out[i_cash_transaction_amount], NULL);
+				add_cstring(&out[i_cash_transaction_dts], NULL);
+				add_cstring(&out[i_cash_transaction_name], NULL);
 			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTUF1_7);
 #endif /* DEBUG */
-			ret = SPI_execute_plan(TUF1_7, args, nulls, true, 0);
+			ret = SPI_execute_plan(TUF1_7, args, nulls, false, 0);
 			if (ret != SPI_OK_SELECT) {
-				FAIL_FRAME_SET(&funcctx->max_calls, TUF1_statements[8].sql);
+				FAIL_FRAME_SET(&funcctx->max_calls, TUF1_statements[7].sql);
 				continue;
 			}
 			tupdesc = SPI_tuptable->tupdesc;
 			tuptable = SPI_tuptable;
 
-			if (num_updated7 > 0) {
-				strncat(values[i_trade_history_dts], ",", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], ",", length_thsi--);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-			}
-
 			for (j = 0; j < SPI_processed; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
-				}
-
 				tuple = tuptable->vals[j];
-
-				tmp = SPI_getvalue(tuple, tupdesc, 1);
-				strncat(values[i_trade_history_dts], tmp, length_thd);
-				length_thd -= strlen(tmp);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(tuple, tupdesc, 2);
-				strncat(values[i_trade_history_status_id], tmp, length_thsi);
-				length_thsi -= strlen(tmp);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-
-				num_updated7++;
+				add_column(&out[i_trade_history_dts], tuple, tupdesc, 1);
+				add_column(&out[i_trade_history_status_id], tuple, tupdesc, 2);
 			}
 			for (j = SPI_processed; j < 3; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
-				}
-
-				strncat(values[i_trade_history_dts], "NULL", length_thd);
-				length_thd -= 4;
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "NULL",
-						length_thsi);
-				length_thsi -= 4;
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-
-				num_updated7++;
+				add_cstring(&out[i_trade_history_dts], NULL);
+				add_cstring(&out[i_trade_history_status_id], NULL);
 			}
 		}
 
-		strncat(values[i_bid_price], "}", length_bp--);
-		if (length_bp < 0) {
-			FAIL_FRAME("bid_price values needs to be increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_is_cash], "}", length_ic--);
-		if (length_ic < 0) {
-			FAIL_FRAME("is_cash values needs to be increased");
-		}
-
-		strncat(values[i_is_market], "}", length_im--);
-		if (length_im < 0) {
-			FAIL_FRAME("is_market values needs to be increased");
-		}
-
-		strncat(values[i_trade_price], "}", length_tp--);
-		if (length_tp < 0) {
-			FAIL_FRAME("trade_price values needs to be increased");
-		}
-
-		strncat(values[i_settlement_amount], "}", length_sa--);
-		if (length_sa < 0) {
-			FAIL_FRAME("settlement_amount values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_due_date], "}", length_scdd--);
-		if (length_scdd < 0) {
-			FAIL_FRAME(
-					"settlement_cash_due_date values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_type], "}", length_sct--);
-		if (length_sct < 0) {
-			FAIL_FRAME("settlement_cash_type values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_amount], "}", length_cta--);
-		if (length_cta < 0) {
-			FAIL_FRAME("cash_transaction_amount values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_dts], "}", length_ctd--);
-		if (length_ctd < 0) {
-			FAIL_FRAME("cash_transaction_dts values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_name], "}", length_ctn--);
-		if (length_ctn < 0) {
-			FAIL_FRAME("cash_transaction_name values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_dts], "}", length_thd--);
-		if (length_thd < 0) {
-			FAIL_FRAME("trade_history_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_status_id], "}", length_thsi--);
-		if (length_thsi < 0) {
-			FAIL_FRAME("trade_history_status_id values needs to be increased");
-		}
-
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found);
-		snprintf(values[i_num_updated], INTEGER_LEN, "%d", num_updated);
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 15; i++) {
+			if (i == i_num_found)
+				values[i] = Int32GetDatum(num_found);
+			else if (i == i_num_updated)
+				values[i] = Int32GetDatum(num_updated);
+			else
+				values[i] = result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from raw
-		 * C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -1002,7 +560,6 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -1010,13 +567,11 @@ TradeUpdateFrame1(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 15; i++) {
-			elog(DEBUG1, "TUF1 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TUF1", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -1034,14 +589,14 @@ Datum
 TradeUpdateFrame2(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 	int j;
 
-	char **values = NULL;
+	Datum values[15];
+	bool isnull[15];
 
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
@@ -1088,12 +643,8 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 
 		int num_found;
 		int num_updated = 0;
-		int num_cash = 0;
 
-		char *tmp;
-		int length_bp, length_cta, length_ctd, length_ctn, length_en,
-				length_ic, length_sa, length_scdd, length_sct, length_thd,
-				length_thsi, length_tl, length_tp;
+		result_array out[15];
 
 		if (timestamp2tm(end_trade_dts_ts, NULL, tm, &fsec, NULL, NULL) == 0) {
 			EncodeDateTimeM(tm, fsec, tzn, end_trade_dts);
@@ -1108,66 +659,6 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 				start_trade_dts);
 #endif
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 * Don't forget to factor in commas (,) and braces ({}) for the arrays.
-		 */
-		values = (char **) palloc(sizeof(char *) * 15);
-
-		length_bp = (S_PRICE_T_LEN + 1) * 20 + 2;
-		values[i_bid_price] = (char *) palloc(length_bp-- * sizeof(char));
-
-		length_cta = (VALUE_T_LEN + 1) * 20 + 2;
-		values[i_cash_transaction_amount]
-				= (char *) palloc(length_cta-- * sizeof(char));
-
-		length_ctd = (MAXDATELEN + 3) * 20 + 2;
-		values[i_cash_transaction_dts]
-				= (char *) palloc(length_ctd-- * sizeof(char));
-
-		length_ctn = (CT_NAME_LEN + 3) * 20 + 2;
-		values[i_cash_transaction_name]
-				= (char *) palloc(length_ctn-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 3) * 20 + 2;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		length_ic = (SMALLINT_LEN + 1) * 20 + 2;
-		values[i_is_cash] = (char *) palloc(length_ic-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-		values[i_num_updated]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_sa = (VALUE_T_LEN + 1) * 20 + 2;
-		values[i_settlement_amount]
-				= (char *) palloc(length_sa-- * sizeof(char));
-
-		length_scdd = (MAXDATELEN + 3) * 20 + 2;
-		values[i_settlement_cash_due_date]
-				= (char *) palloc(length_scdd-- * sizeof(char));
-
-		length_sct = (SE_CASH_TYPE_LEN + 3) * 20 + 2;
-		values[i_settlement_cash_type]
-				= (char *) palloc(length_sct-- * sizeof(char));
-
-		length_thd = (MAXDATELEN + 2) * 60 + 62;
-		values[i_trade_history_dts]
-				= (char *) palloc(length_thd-- * sizeof(char));
-
-		length_thsi = (ST_ID_LEN) * 60 + 62;
-		values[i_trade_history_status_id]
-				= (char *) palloc(length_thsi-- * sizeof(char));
-
-		length_tl = (BIGINT_LEN + 1) * 20 + 2;
-		values[i_trade_list] = (char *) palloc(length_tl-- * sizeof(char));
-
-		length_tp = (S_PRICE_T_LEN + 1) * 20 + 2;
-		values[i_trade_price] = (char *) palloc(length_tp-- * sizeof(char));
-
 		/* create a function context for cross-call persistence */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -1177,6 +668,15 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(TUF2_statements);
+
+		/* Room for the 3 trade history rows of each trade. */
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 15; i++) {
+			if (i != i_num_found && i != i_num_updated)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, max_trades * 3);
+		}
+
 #ifdef DEBUG
 		elog(DEBUG1, "TUF2_1 %s", SQLTUF2_1);
 		elog(DEBUG1, "TUF2_1 $1 %ld", acct_id);
@@ -1188,7 +688,7 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 		args[1] = TimestampGetDatum(start_trade_dts_ts);
 		args[2] = TimestampGetDatum(end_trade_dts_ts);
 		args[3] = Int32GetDatum(max_trades);
-		ret = SPI_execute_plan(TUF2_1, args, nulls, true, 0);
+		ret = SPI_execute_plan(TUF2_1, args, nulls, false, 0);
 		if (ret != SPI_OK_SELECT) {
 			FAIL_FRAME_SET(&funcctx->max_calls, TUF2_statements[0].sql);
 		}
@@ -1198,45 +698,6 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 
 		num_found = SPI_processed;
 
-		values[i_bid_price][0] = '{';
-		values[i_bid_price][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_is_cash][0] = '{';
-		values[i_is_cash][1] = '\0';
-
-		values[i_trade_list][0] = '{';
-		values[i_trade_list][1] = '\0';
-
-		values[i_trade_price][0] = '{';
-		values[i_trade_price][1] = '\0';
-
-		values[i_settlement_amount][0] = '{';
-		values[i_settlement_amount][1] = '\0';
-
-		values[i_settlement_cash_due_date][0] = '{';
-		values[i_settlement_cash_due_date][1] = '\0';
-
-		values[i_settlement_cash_type][0] = '{';
-		values[i_settlement_cash_type][1] = '\0';
-
-		values[i_cash_transaction_amount][0] = '{';
-		values[i_cash_transaction_amount][1] = '\0';
-
-		values[i_cash_transaction_dts][0] = '{';
-		values[i_cash_transaction_dts][1] = '\0';
-
-		values[i_cash_transaction_name][0] = '{';
-		values[i_cash_transaction_name][1] = '\0';
-
-		values[i_trade_history_dts][0] = '{';
-		values[i_trade_history_dts][1] = '\0';
-
-		values[i_trade_history_status_id][0] = '{';
-		values[i_trade_history_status_id][1] = '\0';
-
 #ifdef DEBUG
 		elog(DEBUG1, "TUF2 num_found %d", num_found);
 #endif /* DEBUG */
@@ -1245,127 +706,31 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 			SPITupleTable *l_tuptable = NULL;
 			HeapTuple l_tuple = NULL;
 
-			char *is_cash_str;
-			char *trade_list;
+			bool is_cash;
+			Datum trade_list;
+			bool null;
 			char cash_type[41];
 
 			tuple = tuptable->vals[i];
 
-			if (i > 0) {
-				strncat(values[i_bid_price], ",", length_bp--);
-				if (length_bp < 0) {
-					FAIL_FRAME("bid_price values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], ",", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_is_cash], ",", length_ic--);
-				if (length_ic < 0) {
-					FAIL_FRAME("is_cash values needs to be increased");
-				}
-
-				strncat(values[i_trade_list], ",", length_tl--);
-				if (length_tl < 0) {
-					FAIL_FRAME("trade_list values needs to be increased");
-				}
-
-				strncat(values[i_trade_price], ",", length_tp--);
-				if (length_tp < 0) {
-					FAIL_FRAME("trade_price values needs to be increased");
-				}
-
-				strncat(values[i_settlement_amount], ",", length_sa--);
-				if (length_sa < 0) {
-					FAIL_FRAME(
-							"settlement_amount values needs to be increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], ",",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], ",", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_trade_history_dts], ",", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], ",", length_thsi--);
-				if (length_thsi < 0) {
-					elog(DEBUG1,
-							"TUF2 trade_history_status_id out of space: %s",
-							values[i_trade_history_status_id]);
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_bid_price], tmp, length_bp);
-			length_bp -= strlen(tmp);
-			if (length_bp < 0) {
-				FAIL_FRAME("bid_price values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_exec_name], tmp, length_en);
-			length_en -= strlen(tmp);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			is_cash_str = SPI_getvalue(tuple, tupdesc, 3);
-			if (is_cash_str[0] == 't') {
-				strncat(values[i_is_cash], "1", length_ic--);
-			} else {
-				strncat(values[i_is_cash], "0", length_ic--);
-			}
-			if (length_ic < 0) {
-				FAIL_FRAME("is_cash values needs to be increased");
-			}
-
-			trade_list = SPI_getvalue(tuple, tupdesc, 4);
-			strncat(values[i_trade_list], trade_list, length_tl);
-			length_tl -= strlen(trade_list);
-			if (length_tl < 0) {
-				FAIL_FRAME("trade_list values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_trade_price], tmp, length_tp);
-			length_tp -= strlen(tmp);
-			if (length_tp < 0) {
-				FAIL_FRAME("trade_price values needs to be increased");
-			}
+			add_column(&out[i_bid_price], tuple, tupdesc, 1);
+			add_column(&out[i_exec_name], tuple, tupdesc, 2);
+			is_cash = DatumGetBool(SPI_getbinval(tuple, tupdesc, 3, &null));
+			add_flag(&out[i_is_cash], is_cash);
+			trade_list = SPI_getbinval(tuple, tupdesc, 4, &null);
+			add_column(&out[i_trade_list], tuple, tupdesc, 4);
+			add_column(&out[i_trade_price], tuple, tupdesc, 5);
 
 #ifdef DEBUG
-			elog(DEBUG1, "TUF2 bid_price[%d] %s", i, values[i_bid_price]);
-			elog(DEBUG1, "TUF2 exec_name[%d] %s", i, values[i_exec_name]);
-			elog(DEBUG1, "TUF2 is_cash[%d] %s", i, values[i_is_cash]);
-			elog(DEBUG1, "TUF2 trade_ist[%d] %s", i, values[i_trade_list]);
-			elog(DEBUG1, "TUF2 trade_price[%d] %s", i, values[i_trade_price]);
+			elog(DEBUG1, "TUF2 bid_price[%d] %s", i,
+					SPI_getvalue(tuple, tupdesc, 1));
+			elog(DEBUG1, "TUF2 exec_name[%d] %s", i,
+					SPI_getvalue(tuple, tupdesc, 2));
+			elog(DEBUG1, "TUF2 is_cash[%d] %d", i, is_cash);
+			elog(DEBUG1, "TUF2 trade_list[%d] %ld", i,
+					DatumGetInt64(trade_list));
+			elog(DEBUG1, "TUF2 trade_price[%d] %s", i,
+					SPI_getvalue(tuple, tupdesc, 5));
 #endif /* DEBUG */
 
 			if (num_updated < max_updates) {
@@ -1373,10 +738,10 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 
 #ifdef DEBUG
 				elog(DEBUG1, "TUF2_2 %s", SQLTUF2_2);
-				elog(DEBUG1, "TUF2_2 $1 %lld", atoll(trade_list));
+				elog(DEBUG1, "TUF2_2 $1 %ld", DatumGetInt64(trade_list));
 #endif /* DEBUG */
-				args[0] = Int64GetDatum(atoll(trade_list));
-				ret = SPI_execute_plan(TUF2_2, args, nulls, true, 0);
+				args[0] = trade_list;
+				ret = SPI_execute_plan(TUF2_2, args, nulls, false, 0);
 				if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 					l_tupdesc = SPI_tuptable->tupdesc;
 					l_tuptable = SPI_tuptable;
@@ -1392,7 +757,7 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 				elog(DEBUG1, "TUF2 cash_type[%d] = '%s'", i, old_cash_type);
 #endif /* DEBUG */
 
-				if (is_cash_str[0] == 't') {
+				if (is_cash) {
 					if (strcmp(old_cash_type, "Cash Account") == 0) {
 						strncpy(cash_type, "Cash", sizeof(cash_type));
 					} else {
@@ -1410,10 +775,10 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 #ifdef DEBUG
 				elog(DEBUG1, "TUF2_3 %s", SQLTUF2_3);
 				elog(DEBUG1, "TUF2_3 $1 %s", cash_type);
-				elog(DEBUG1, "TUF2_3 $2 %s", trade_list);
+				elog(DEBUG1, "TUF2_3 $2 %ld", DatumGetInt64(trade_list));
 #endif /* DEBUG */
 				args[0] = CStringGetTextDatum(cash_type);
-				args[1] = Int64GetDatum(atoll(trade_list));
+				args[1] = trade_list;
 				ret = SPI_execute_plan(TUF2_3, args, nulls, false, 0);
 				if (ret != SPI_OK_UPDATE) {
 					FAIL_FRAME_SET(
@@ -1425,212 +790,59 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 
 #ifdef DEBUG
 			elog(DEBUG1, "TUF2_4 %s", SQLTUF2_4);
-			elog(DEBUG1, "TUF2_4 $1 %s", trade_list);
+			elog(DEBUG1, "TUF2_4 $1 %ld", DatumGetInt64(trade_list));
 #endif /* DEBUG */
-			args[0] = Int64GetDatum(atoll(trade_list));
-			ret = SPI_execute_plan(TUF2_4, args, nulls, true, 0);
+			args[0] = trade_list;
+			ret = SPI_execute_plan(TUF2_4, args, nulls, false, 0);
 			if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 				l_tupdesc = SPI_tuptable->tupdesc;
 				l_tuptable = SPI_tuptable;
 				l_tuple = l_tuptable->vals[0];
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 1);
-				strncat(values[i_settlement_amount], tmp, length_sa);
-				length_sa -= strlen(tmp);
-				if (length_sa < 0) {
-					FAIL_FRAME(
-							"settlement_amount values needs to be increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], "\"",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 2);
-				strncat(values[i_settlement_cash_due_date], tmp, length_scdd);
-				length_scdd -= strlen(tmp);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], "\"",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 3);
-				strncat(values[i_settlement_cash_type], tmp, length_sct);
-				length_sct -= strlen(tmp);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
+				add_column(&out[i_settlement_amount], l_tuple, l_tupdesc, 1);
+				add_column(&out[i_settlement_cash_due_date], l_tuple,
+						l_tupdesc, 2);
+				add_column(
+						&out[i_settlement_cash_type], l_tuple, l_tupdesc, 3);
 			} else {
 				FAIL_FRAME_SET(&funcctx->max_calls, TUF2_statements[3].sql);
 				continue;
 			}
 
-			if (is_cash_str[0] == 't') {
+			if (is_cash) {
 #ifdef DEBUG
 				elog(DEBUG1, "TUF2_5 %s", SQLTUF2_5);
-				elog(DEBUG1, "TUF2_5 $1 %s", trade_list);
+				elog(DEBUG1, "TUF2_5 $1 %ld", DatumGetInt64(trade_list));
 #endif /* DEBUG */
-				ret = SPI_execute_plan(TUF2_5, args, nulls, true, 0);
+				ret = SPI_execute_plan(TUF2_5, args, nulls, false, 0);
 				if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 					l_tupdesc = SPI_tuptable->tupdesc;
 					l_tuptable = SPI_tuptable;
 					l_tuple = l_tuptable->vals[0];
-					if (num_cash > 0) {
-						strncat(values[i_cash_transaction_amount], ",",
-								length_cta--);
-						if (length_cta < 0) {
-							FAIL_FRAME("cash_transaction_amount values needs "
-									   "to be increased");
-						}
-
-						strncat(values[i_cash_transaction_dts], ",",
-								length_ctd--);
-						if (length_ctd < 0) {
-							FAIL_FRAME("cash_transaction_dts values needs to "
-									   "be increased");
-						}
-
-						strncat(values[i_cash_transaction_name], ",",
-								length_ctn--);
-						if (length_ctn < 0) {
-							FAIL_FRAME("cash_transaction_name values needs to "
-									   "be increased");
-						}
-					}
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 1);
-					strncat(values[i_cash_transaction_amount], tmp,
-							length_cta);
-					length_cta -= strlen(tmp);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
+					add_column(&out[i_cash_transaction_amount], l_tuple,
+							l_tupdesc, 1);
+					add_column(&out[i_cash_transaction_dts], l_tuple,
+							l_tupdesc, 2);
+					add_column(&out[i_cash_transaction_name], l_tuple,
+							l_tupdesc, 3);
+				} else {
+					FAIL_FRAME_SET(
+							&funcctx->max_calls, TUF2_statements[4].sql);
+					continue;
+				}
+			} else {
+				/* Clients read a cash transaction at the position of its
+				 * trade. */
+				add_cstring(&out[i_cash_transaction_amount], NULL);
+				add_cstring(&out[i_cash_transaction_dts], NULL);
+				add_cstring(&out[i_cash_transaction_name], NULL);
+			}
 
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
+#ifdef DEBUG
+			elog(DEBUG1, "TUF2_6 %s", SQLTUF2_6);
+			elog(DEBUG1, "TUF2_6 $1 %ld", DatumGetInt64(trade_list));
+#endif /* DEBUG */
 
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 2);
-					strncat(values[i_cash_transaction_dts], tmp, length_ctd);
-					length_ctd -= strlen(tmp);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 3);
-					strncat(values[i_cash_transaction_name], tmp, length_ctn);
-					length_ctn -= strlen(tmp);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					++num_cash;
-				} else {
-					FAIL_FRAME_SET(
-							&funcctx->max_calls, TUF2_statements[4].sql);
-					continue;
-				}
-			} else {
-				if (num_cash > 0) {
-					strncat(values[i_cash_transaction_amount], ",",
-							length_cta--);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], ",", length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], ",",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-				}
-				strncat(values[i_cash_transaction_amount], "0", length_cta--);
-				if (length_cta < 0) {
-					FAIL_FRAME("cash_transaction_amount values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_cash_transaction_dts], "NULL", length_ctd);
-				length_ctd -= 4;
-				if (length_ctd < 0) {
-					FAIL_FRAME("cash_transaction_dts values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_cash_transaction_name], "\"\"", length_ctn);
-				length_ctn -= 2;
-				if (length_ctn < 0) {
-					FAIL_FRAME("cash_transaction_name values needs to be "
-							   "increased");
-				}
-
-				++num_cash;
-			}
-
-#ifdef DEBUG
-			elog(DEBUG1, "TUF2_6 %s", SQLTUF2_6);
-			elog(DEBUG1, "TUF2_6 $1 %s", trade_list);
-#endif /* DEBUG */
-
-			ret = SPI_execute_plan(TUF2_6, args, nulls, true, 0);
+			ret = SPI_execute_plan(TUF2_6, args, nulls, false, 0);
 			if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 				l_tupdesc = SPI_tuptable->tupdesc;
 				l_tuptable = SPI_tuptable;
@@ -1640,184 +852,27 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 			}
 
 			for (j = 0; j < SPI_processed; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						elog(DEBUG1,
-								"TUF2 trade_history_status_id out of space: "
-								"%s",
-								values[i_trade_history_status_id]);
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
-				}
 				l_tuple = l_tuptable->vals[j];
-
-				strncat(values[i_trade_history_dts], "\"", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 1);
-				strncat(values[i_trade_history_dts], tmp, length_thd);
-				length_thd -= strlen(tmp);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_dts], "\"", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 2);
-				strncat(values[i_trade_history_status_id], tmp, length_thsi);
-				length_thsi -= strlen(tmp);
-				if (length_thsi < 0) {
-					elog(DEBUG1,
-							"TUF2 trade_history_status_id out of space: %s",
-							values[i_trade_history_status_id]);
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
+				add_column(&out[i_trade_history_dts], l_tuple, l_tupdesc, 1);
+				add_column(&out[i_trade_history_status_id], l_tuple,
+						l_tupdesc, 2);
 			}
 			for (j = SPI_processed; j < 3; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						elog(DEBUG1,
-								"TUF2 trade_history_status_id out of space: "
-								"%s",
-								values[i_trade_history_status_id]);
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
-				}
-				strncat(values[i_trade_history_dts], "NULL", length_thd);
-				length_thd -= 4;
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], "NULL",
-						length_thsi);
-				length_thsi -= 4;
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-#ifdef DEBUG
-				elog(DEBUG1, "TUF2 trade_history_dts[%d][%d] %s", i, j,
-						values[i_trade_history_dts]);
-				elog(DEBUG1, "TUF2 trade_history_status_id[%d][%d] %s", i, j,
-						values[i_trade_history_status_id]);
-#endif /* DEBUG */
+				add_cstring(&out[i_trade_history_dts], NULL);
+				add_cstring(&out[i_trade_history_status_id], NULL);
 			}
 		}
 
-		strncat(values[i_bid_price], "}", length_bp--);
-		if (length_bp < 0) {
-			FAIL_FRAME("bid_price values needs to be increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_is_cash], "}", length_ic--);
-		if (length_ic < 0) {
-			FAIL_FRAME("is_cash values needs to be increased");
-		}
-
-		strncat(values[i_trade_list], "}", length_tl--);
-		if (length_tl < 0) {
-			FAIL_FRAME("trade_list values needs to be increased");
-		}
-
-		strncat(values[i_trade_price], "}", length_tp--);
-		if (length_tp < 0) {
-			FAIL_FRAME("trade_price values needs to be increased");
-		}
-
-		strncat(values[i_settlement_amount], "}", length_sa--);
-		if (length_sa < 0) {
-			FAIL_FRAME("settlement_amount values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_due_date], "}", length_scdd--);
-		if (length_scdd < 0) {
-			FAIL_FRAME("settlement_cash_due_date values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_settlement_cash_type], "}", length_sct--);
-		if (length_sct < 0) {
-			FAIL_FRAME("settlement_cash_type values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_amount], "}", length_cta--);
-		if (length_cta < 0) {
-			FAIL_FRAME("cash_transaction_amount values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_dts], "}", length_ctd--);
-		if (length_ctd < 0) {
-			FAIL_FRAME("cash_transaction_dts values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_name], "}", length_ctn--);
-		if (length_ctn < 0) {
-			FAIL_FRAME("cash_transaction_name values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_dts], "}", length_thd--);
-		if (length_thd < 0) {
-			FAIL_FRAME("trade_history_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_status_id], "}", length_thsi--);
-		if (length_thsi < 0) {
-			FAIL_FRAME("trade_history_status_id values needs to be increased");
-		}
-
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found);
-		snprintf(values[i_num_updated], INTEGER_LEN, "%d", num_updated);
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 15; i++) {
+			if (i == i_num_found)
+				values[i] = Int32GetDatum(num_found);
+			else if (i == i_num_updated)
+				values[i] = Int32GetDatum(num_updated);
+			else
+				values[i] = result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from raw
-		 * C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -1826,7 +881,6 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -1834,13 +888,11 @@ TradeUpdateFrame2(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 15; i++) {
-			elog(DEBUG1, "TUF2 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TUF2", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -1858,15 +910,14 @@ Datum
 TradeUpdateFrame3(PG_FUNCTION_ARGS)
 {
 	FuncCallContext *funcctx;
-	AttInMetadata *attinmeta;
 	int call_cntr;
 	int max_calls;
 
 	int i;
 	int j;
-	int k;
 
-	char **values = NULL;
+	Datum values[20];
+	bool isnull[20];
 
 	/* Stuff done only on the first call of the function. */
 	if (SRF_IS_FIRSTCALL()) {
@@ -1922,13 +973,8 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 
 		int num_found;
 		int num_updated = 0;
-		int num_cash = 0;
 
-		char *tmp;
-		int length_ai, length_ic, length_cta, length_ctd, length_ctn,
-				length_en, length_p, length_q, length_sa, length_scdd,
-				length_sct, length_sn, length_td, length_thd, length_thsi,
-				length_tl, length_tn, length_tt;
+		result_array out[20];
 
 		strncpy(symbol,
 				DatumGetCString(DirectFunctionCall1(
@@ -1947,81 +993,6 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 				start_trade_dts, symbol);
 #endif
 
-		/*
-		 * Prepare a values array for building the returned tuple.
-		 * This should be an array of C strings, which will
-		 * be processed later by the type input functions.
-		 * Don't forget to factor in commas (,) and braces ({}) for the arrays.
-		 */
-		values = (char **) palloc(sizeof(char *) * 20);
-
-		length_ai = BIGINT_LEN * 20 + 22;
-		values[i_acct_id] = (char *) palloc(length_ai-- * sizeof(char));
-
-		length_cta = VALUE_T_LEN * 20 + 22;
-		values[i_cash_transaction_amount]
-				= (char *) palloc(length_cta-- * sizeof(char));
-
-		length_ctd = (MAXDATELEN + 2) * 20 + 22;
-		values[i_cash_transaction_dts]
-				= (char *) palloc(length_ctd-- * sizeof(char));
-
-		length_ctn = (CT_NAME_LEN + 2) * 20 + 22;
-		values[i_cash_transaction_name]
-				= (char *) palloc(length_ctn-- * sizeof(char));
-
-		length_en = (T_EXEC_NAME_LEN + 2) * 20 + 22;
-		values[i_exec_name] = (char *) palloc(length_en-- * sizeof(char));
-
-		length_ic = SMALLINT_LEN * 20 + 22;
-		values[i_is_cash] = (char *) palloc(length_ic-- * sizeof(char));
-
-		values[i_num_found]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-		values[i_num_updated]
-				= (char *) palloc((INTEGER_LEN + 1) * sizeof(char));
-
-		length_p = S_PRICE_T_LEN * 20 + 22;
-		values[i_price] = (char *) palloc(length_p-- * sizeof(char));
-
-		length_q = INTEGER_LEN * 20 + 22;
-		values[i_quantity] = (char *) palloc(length_q-- * sizeof(char));
-
-		length_sn = (S_NAME_LEN + 2) * 20 + 22;
-		values[i_s_name] = (char *) palloc(length_sn-- * sizeof(char));
-
-		length_sa = VALUE_T_LEN * 20 + 22;
-		values[i_settlement_amount]
-				= (char *) palloc(length_sa-- * sizeof(char));
-
-		length_scdd = MAXDATELEN * 20 + 22;
-		values[i_settlement_cash_due_date]
-				= (char *) palloc(length_scdd-- * sizeof(char));
-
-		length_sct = (SE_CASH_TYPE_LEN + 2) * 20 + 22;
-		values[i_settlement_cash_type]
-				= (char *) palloc(length_sct-- * sizeof(char));
-
-		length_td = (MAXDATELEN + 1) * 20 + 2;
-		values[i_trade_dts] = (char *) palloc(length_td-- * sizeof(char));
-
-		length_thd = (MAXDATELEN + 2) * 60 + 62;
-		values[i_trade_history_dts]
-				= (char *) palloc(length_thd-- * sizeof(char));
-
-		length_thsi = ST_ID_LEN * 60 + 62;
-		values[i_trade_history_status_id]
-				= (char *) palloc(length_thsi-- * sizeof(char));
-
-		length_tl = BIGINT_LEN * 20 + 22;
-		values[i_trade_list] = (char *) palloc(length_tl-- * sizeof(char));
-
-		length_tn = (TT_NAME_LEN + 2) * 20 + 2;
-		values[i_type_name] = (char *) palloc(length_tn-- * sizeof(char));
-
-		length_tt = TT_ID_LEN * 20 + 22;
-		values[i_trade_type] = (char *) palloc(length_tt-- * sizeof(char));
-
 		/* create a function context for cross-call persistence */
 		funcctx = SRF_FIRSTCALL_INIT();
 		funcctx->max_calls = 1;
@@ -2031,6 +1002,15 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 
 		SPI_connect();
 		plan_queries(TUF3_statements);
+
+		/* Room for the 3 trade history rows of each trade. */
+		funcctx->tuple_desc = result_tupdesc(fcinfo);
+		for (i = 0; i < 20; i++) {
+			if (i != i_num_found && i != i_num_updated)
+				init_result_array(
+						&out[i], funcctx->tuple_desc, i, max_trades * 3);
+		}
+
 #ifdef DEBUG
 		elog(DEBUG1, "%s", SQLTUF3_1);
 #endif /* DEBUG */
@@ -2038,9 +1018,9 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 		args[1] = TimestampGetDatum(start_trade_dts_ts);
 		args[2] = TimestampGetDatum(end_trade_dts_ts);
 		args[3] = Int32GetDatum(max_trades);
-		ret = SPI_execute_plan(TUF3_1, args, nulls, true, 0);
+		ret = SPI_execute_plan(TUF3_1, args, nulls, false, 0);
 		if (ret != SPI_OK_SELECT) {
-			FAIL_FRAME_SET(&funcctx->max_calls, TUF2_statements[0].sql);
+			FAIL_FRAME_SET(&funcctx->max_calls, TUF3_statements[0].sql);
 		}
 
 		tupdesc = SPI_tuptable->tupdesc;
@@ -2048,283 +1028,40 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 
 		num_found = SPI_processed;
 
-		values[i_acct_id][0] = '{';
-		values[i_acct_id][1] = '\0';
-
-		values[i_cash_transaction_amount][0] = '{';
-		values[i_cash_transaction_amount][1] = '\0';
-
-		values[i_cash_transaction_dts][0] = '{';
-		values[i_cash_transaction_dts][1] = '\0';
-
-		values[i_cash_transaction_name][0] = '{';
-		values[i_cash_transaction_name][1] = '\0';
-
-		values[i_exec_name][0] = '{';
-		values[i_exec_name][1] = '\0';
-
-		values[i_is_cash][0] = '{';
-		values[i_is_cash][1] = '\0';
-
-		values[i_price][0] = '{';
-		values[i_price][1] = '\0';
-
-		values[i_quantity][0] = '{';
-		values[i_quantity][1] = '\0';
-
-		values[i_s_name][0] = '{';
-		values[i_s_name][1] = '\0';
-
-		values[i_settlement_amount][0] = '{';
-		values[i_settlement_amount][1] = '\0';
-
-		values[i_settlement_cash_due_date][0] = '{';
-		values[i_settlement_cash_due_date][1] = '\0';
-
-		values[i_settlement_cash_type][0] = '{';
-		values[i_settlement_cash_type][1] = '\0';
-
-		values[i_trade_dts][0] = '{';
-		values[i_trade_dts][1] = '\0';
-
-		values[i_trade_history_dts][0] = '{';
-		values[i_trade_history_dts][1] = '\0';
-
-		values[i_trade_history_status_id][0] = '{';
-		values[i_trade_history_status_id][1] = '\0';
-
-		values[i_trade_list][0] = '{';
-		values[i_trade_list][1] = '\0';
-
-		values[i_type_name][0] = '{';
-		values[i_type_name][1] = '\0';
-
-		values[i_trade_type][0] = '{';
-		values[i_trade_type][1] = '\0';
-
 		for (i = 0; i < num_found; i++) {
 			TupleDesc l_tupdesc;
 			SPITupleTable *l_tuptable = NULL;
 			HeapTuple l_tuple = NULL;
 
-			char *is_cash_str;
-			char *trade_list;
+			bool is_cash;
+			Datum trade_list;
+			bool null;
 			char *old_ct_name;
 			char *quantity;
 			char *s_name;
 			char *type_name;
 			char ct_name[CT_NAME_LEN + 1];
-			char ct_name_esc[2 * CT_NAME_LEN + 1];
-			char *price;
 
 			tuple = tuptable->vals[i];
 
-			if (i > 0) {
-				strncat(values[i_acct_id], ",", length_ai--);
-				if (length_ai < 0) {
-					FAIL_FRAME("acct_id values needs to be increased");
-				}
-
-				strncat(values[i_exec_name], ",", length_en--);
-				if (length_en < 0) {
-					FAIL_FRAME("exec_name values needs to be increased");
-				}
-
-				strncat(values[i_is_cash], ",", length_ic--);
-				if (length_ic < 0) {
-					FAIL_FRAME("is_cash values needs to be increased");
-				}
-
-				strncat(values[i_price], ",", length_p--);
-				if (length_p < 0) {
-					FAIL_FRAME("price values needs to be increased");
-				}
-
-				strncat(values[i_quantity], ",", length_q--);
-				if (length_q < 0) {
-					FAIL_FRAME("quantity values needs to be increased");
-				}
-
-				strncat(values[i_s_name], ",", length_sn--);
-				if (length_sn < 0) {
-					FAIL_FRAME("s_name values needs to be increased");
-				}
-
-				strncat(values[i_trade_dts], ",", length_td--);
-				if (length_td < 0) {
-					FAIL_FRAME("trade_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_list], ",", length_tl--);
-				if (length_tl < 0) {
-					FAIL_FRAME("trade_list values needs to be increased");
-				}
-
-				strncat(values[i_trade_type], ",", length_tt--);
-				if (length_tt < 0) {
-					FAIL_FRAME("trade_type values needs to be increased");
-				}
-
-				strncat(values[i_type_name], ",", length_tn--);
-				if (length_tn < 0) {
-					FAIL_FRAME("type_name values needs to be increased");
-				}
-
-				strncat(values[i_settlement_amount], ",", length_sa--);
-				if (length_sa < 0) {
-					FAIL_FRAME(
-							"settlement_amount values needs to be increased");
-				}
-
-				strncat(values[i_settlement_cash_due_date], ",",
-						length_scdd--);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], ",", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_trade_history_dts], ",", length_thd--);
-				if (length_thd < 0) {
-					FAIL_FRAME(
-							"trade_history_dts values needs to be increased");
-				}
-
-				strncat(values[i_trade_history_status_id], ",", length_thsi--);
-				if (length_thsi < 0) {
-					FAIL_FRAME("trade_history_status_id values needs to be "
-							   "increased");
-				}
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 1);
-			strncat(values[i_acct_id], tmp, length_ai);
-			length_ai -= strlen(tmp);
-			if (length_ai < 0) {
-				FAIL_FRAME("acct_id values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 2);
-			strncat(values[i_exec_name], tmp, length_en);
-			length_en -= strlen(tmp);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			strncat(values[i_exec_name], "\"", length_en--);
-			if (length_en < 0) {
-				FAIL_FRAME("exec_name values needs to be increased");
-			}
-
-			is_cash_str = SPI_getvalue(tuple, tupdesc, 3);
-			if (is_cash_str[0] == 't') {
-				strncat(values[i_is_cash], "1", length_ic--);
-			} else {
-				strncat(values[i_is_cash], "0", length_ic--);
-			}
-			if (length_ic < 0) {
-				FAIL_FRAME("is_cash values needs to be increased");
-			}
-
-			price = SPI_getvalue(tuple, tupdesc, 4);
-			if (price == NULL) {
-				strncat(values[i_price], "NULL", length_p);
-				length_p -= 4;
-			} else {
-				strncat(values[i_price], price, length_p);
-				length_p -= strlen(price);
-			}
-			if (length_p < 0) {
-				FAIL_FRAME("price values needs to be increased");
-			}
-
-			quantity = SPI_getvalue(tuple, tupdesc, 5);
-			strncat(values[i_quantity], quantity, length_q);
-			length_q -= strlen(quantity);
-			if (length_q < 0) {
-				FAIL_FRAME("quantity values needs to be increased");
-			}
-
-			strncat(values[i_s_name], "\"", length_sn--);
-			if (length_sn < 0) {
-				FAIL_FRAME("s_name values needs to be increased");
-			}
-
-			s_name = SPI_getvalue(tuple, tupdesc, 6);
-			strncat(values[i_s_name], s_name, length_sn);
-			length_sn -= strlen(s_name);
-			if (length_sn < 0) {
-				FAIL_FRAME("s_name values needs to be increased");
-			}
-
-			strncat(values[i_s_name], "\"", length_sn--);
-			if (length_sn < 0) {
-				FAIL_FRAME("s_name values needs to be increased");
-			}
-
-			strncat(values[i_trade_dts], "\"", length_td--);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 7);
-			strncat(values[i_trade_dts], tmp, length_td);
-			length_td -= strlen(tmp);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			strncat(values[i_trade_dts], "\"", length_td--);
-			if (length_td < 0) {
-				FAIL_FRAME("trade_dts values needs to be increased");
-			}
-
-			trade_list = SPI_getvalue(tuple, tupdesc, 8);
-			strncat(values[i_trade_list], trade_list, length_tl);
-			length_tl -= strlen(trade_list);
-			if (length_tl < 0) {
-				FAIL_FRAME("trade_list values needs to be increased");
-			}
-
-			tmp = SPI_getvalue(tuple, tupdesc, 9);
-			strncat(values[i_trade_type], tmp, length_tt);
-			length_tt -= strlen(tmp);
-			if (length_tt < 0) {
-				FAIL_FRAME("trade_type values needs to be increased");
-			}
-
-			strncat(values[i_type_name], "\"", length_tn--);
-			if (length_tn < 0) {
-				FAIL_FRAME("type_name values needs to be increased");
-			}
-
-			type_name = SPI_getvalue(tuple, tupdesc, 10);
-			strncat(values[i_type_name], type_name, length_tn);
-			length_tn -= strlen(type_name);
-			if (length_tn < 0) {
-				FAIL_FRAME("type_name values needs to be increased");
-			}
-
-			strncat(values[i_type_name], "\"", length_tn--);
-			if (length_tn < 0) {
-				FAIL_FRAME("type_name values needs to be increased");
-			}
+			add_column(&out[i_acct_id], tuple, tupdesc, 1);
+			add_column(&out[i_exec_name], tuple, tupdesc, 2);
+			is_cash = DatumGetBool(SPI_getbinval(tuple, tupdesc, 3, &null));
+			add_flag(&out[i_is_cash], is_cash);
+			add_column(&out[i_price], tuple, tupdesc, 4);
+			add_column(&out[i_quantity], tuple, tupdesc, 5);
+			add_column(&out[i_s_name], tuple, tupdesc, 6);
+			add_column(&out[i_trade_dts], tuple, tupdesc, 7);
+			trade_list = SPI_getbinval(tuple, tupdesc, 8, &null);
+			add_column(&out[i_trade_list], tuple, tupdesc, 8);
+			add_column(&out[i_trade_type], tuple, tupdesc, 9);
+			add_column(&out[i_type_name], tuple, tupdesc, 10);
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTUF3_2);
 #endif /* DEBUG */
-			args[0] = Int64GetDatum(atoll(trade_list));
-			ret = SPI_execute_plan(TUF3_2, args, nulls, true, 0);
+			args[0] = trade_list;
+			ret = SPI_execute_plan(TUF3_2, args, nulls, false, 0);
 			if (ret != SPI_OK_SELECT) {
 				FAIL_FRAME_SET(&funcctx->max_calls, TUF3_statements[1].sql);
 				continue;
@@ -2335,50 +1072,19 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 
 			for (j = 0; j < SPI_processed; j++) {
 				l_tuple = l_tuptable->vals[j];
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 1);
-				strncat(values[i_settlement_amount], tmp, length_sa);
-				length_sa -= strlen(tmp);
-				if (length_sa < 0) {
-					FAIL_FRAME(
-							"settlement_amount values needs to be increased");
-				}
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 2);
-				strncat(values[i_settlement_cash_due_date], tmp, length_scdd);
-				length_scdd -= strlen(tmp);
-				if (length_scdd < 0) {
-					FAIL_FRAME("settlement_cash_due_date values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				tmp = SPI_getvalue(l_tuple, l_tupdesc, 3);
-				strncat(values[i_settlement_cash_type], tmp, length_sct);
-				length_sct -= strlen(tmp);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
-
-				strncat(values[i_settlement_cash_type], "\"", length_sct--);
-				if (length_sct < 0) {
-					FAIL_FRAME("settlement_cash_type values needs to be "
-							   "increased");
-				}
+				add_column(&out[i_settlement_amount], l_tuple, l_tupdesc, 1);
+				add_column(&out[i_settlement_cash_due_date], l_tuple,
+						l_tupdesc, 2);
+				add_column(
+						&out[i_settlement_cash_type], l_tuple, l_tupdesc, 3);
 			}
 
-			if (is_cash_str[0] == 't') {
+			if (is_cash) {
 				if (num_updated < max_updates) {
 #ifdef DEBUG
 					elog(DEBUG1, "%s", SQLTUF3_3);
 #endif /* DEBUG */
-					ret = SPI_execute_plan(TUF3_3, args, nulls, true, 0);
+					ret = SPI_execute_plan(TUF3_3, args, nulls, false, 0);
 					if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 						l_tupdesc = SPI_tuptable->tupdesc;
 						l_tuptable = SPI_tuptable;
@@ -2390,6 +1096,9 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 						continue;
 					}
 
+					quantity = SPI_getvalue(tuple, tupdesc, 5);
+					s_name = SPI_getvalue(tuple, tupdesc, 6);
+					type_name = SPI_getvalue(tuple, tupdesc, 10);
 					if (strstr(old_ct_name, " shares of ")) {
 						snprintf(ct_name, sizeof(ct_name),
 								"%s %s Shares of %s", type_name, quantity,
@@ -2399,19 +1108,12 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 								"%s %s shares of %s", type_name, quantity,
 								s_name);
 					}
-					for (j = 0, k = 0; j < CT_NAME_LEN && ct_name[j] != '\0';
-							j++, k++) {
-						if (ct_name[j] == '\'')
-							ct_name_esc[k++] = '\\';
-						ct_name_esc[k] = ct_name[j];
-					}
-					ct_name_esc[k] = '\0';
 
 #ifdef DEBUG
 					elog(DEBUG1, "%s", SQLTUF3_4);
 #endif /* DEBUG */
-					args[0] = CStringGetTextDatum(ct_name_esc);
-					args[1] = Int64GetDatum(atoll(trade_list));
+					args[0] = CStringGetTextDatum(ct_name);
+					args[1] = trade_list;
 					ret = SPI_execute_plan(TUF3_4, args, nulls, false, 0);
 					if (ret != SPI_OK_UPDATE) {
 						FAIL_FRAME_SET(
@@ -2421,103 +1123,39 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 					num_updated += SPI_processed;
 				}
 
-				if (num_cash > 0) {
-					strncat(values[i_cash_transaction_amount], ",",
-							length_cta--);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], ",", length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], ",",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-				}
 #ifdef DEBUG
 				elog(DEBUG1, "%s", SQLTUF3_5);
 #endif /* DEBUG */
-				args[0] = Int64GetDatum(atoll(trade_list));
-				ret = SPI_execute_plan(TUF3_5, args, nulls, true, 0);
+				args[0] = trade_list;
+				ret = SPI_execute_plan(TUF3_5, args, nulls, false, 0);
 				if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 					l_tupdesc = SPI_tuptable->tupdesc;
 					l_tuptable = SPI_tuptable;
 					l_tuple = l_tuptable->vals[0];
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 1);
-					strncat(values[i_cash_transaction_amount], tmp,
-							length_cta--);
-					length_cta -= strlen(tmp);
-					if (length_cta < 0) {
-						FAIL_FRAME("cash_transaction_amount values needs to "
-								   "be increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 2);
-					strncat(values[i_cash_transaction_dts], tmp, length_ctd);
-					length_ctd -= strlen(tmp);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_dts], "\"",
-							length_ctd--);
-					if (length_ctd < 0) {
-						FAIL_FRAME("cash_transaction_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 3);
-					strncat(values[i_cash_transaction_name], tmp, length_ctn);
-					length_ctn -= strlen(tmp);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_cash_transaction_name], "\"",
-							length_ctn--);
-					if (length_ctn < 0) {
-						FAIL_FRAME("cash_transaction_name values needs to be "
-								   "increased");
-					}
-
-					++num_cash;
+					add_column(&out[i_cash_transaction_amount], l_tuple,
+							l_tupdesc, 1);
+					add_column(&out[i_cash_transaction_dts], l_tuple,
+							l_tupdesc, 2);
+					add_column(&out[i_cash_transaction_name], l_tuple,
+							l_tupdesc, 3);
 				} else {
 					FAIL_FRAME_SET(
 							&funcctx->max_calls, TUF3_statements[4].sql);
 					continue;
 				}
+			} else {
+				/* Clients read a cash transaction at the position of its
+				 * trade. */
+				add_cstring(&out[i_cash_transaction_amount], NULL);
+				add_cstring(&out[i_cash_transaction_dts], NULL);
+				add_cstring(&out[i_cash_transaction_name], NULL);
 			}
 
 #ifdef DEBUG
 			elog(DEBUG1, "%s", SQLTUF3_6);
 #endif /* DEBUG */
-			args[0] = Int64GetDatum(atoll(trade_list));
-			ret = SPI_execute_plan(TUF3_6, args, nulls, true, 0);
+			args[0] = trade_list;
+			ret = SPI_execute_plan(TUF3_6, args, nulls, false, 0);
 			if (ret == SPI_OK_SELECT && SPI_processed > 0) {
 				l_tupdesc = SPI_tuptable->tupdesc;
 				l_tuptable = SPI_tuptable;
@@ -2527,169 +1165,29 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 			}
 
 			for (j = 0; j < 3; j++) {
-				if (j > 0) {
-					strncat(values[i_trade_history_dts], ",", length_thd--);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], ",",
-							length_thsi--);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
-				}
 				if (j < SPI_processed) {
 					l_tuple = l_tuptable->vals[j];
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 1);
-					strncat(values[i_trade_history_dts], tmp, length_thd);
-					length_thd -= strlen(tmp);
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					tmp = SPI_getvalue(l_tuple, l_tupdesc, 2);
-					strncat(values[i_trade_history_status_id], tmp,
-							length_thsi);
-					length_thsi -= strlen(tmp);
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
+					add_column(
+							&out[i_trade_history_dts], l_tuple, l_tupdesc, 1);
+					add_column(&out[i_trade_history_status_id], l_tuple,
+							l_tupdesc, 2);
 				} else {
-					strncat(values[i_trade_history_dts], "NULL", length_thd);
-					length_thd -= 4;
-					if (length_thd < 0) {
-						FAIL_FRAME("trade_history_dts values needs to be "
-								   "increased");
-					}
-
-					strncat(values[i_trade_history_status_id], "NULL",
-							length_thsi);
-					length_thsi -= 4;
-					if (length_thsi < 0) {
-						FAIL_FRAME("trade_history_status_id values needs to "
-								   "be increased");
-					}
+					add_cstring(&out[i_trade_history_dts], NULL);
+					add_cstring(&out[i_trade_history_status_id], NULL);
 				}
 			}
 		}
 
-		strncat(values[i_acct_id], "}", length_ai--);
-		if (length_ai < 0) {
-			FAIL_FRAME("acct_id values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_amount], "}", length_cta--);
-		if (length_cta < 0) {
-			FAIL_FRAME("cash_transaction_amount values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_dts], "}", length_ctd--);
-		if (length_ctd < 0) {
-			FAIL_FRAME("cash_transaction_dts values needs to be increased");
-		}
-
-		strncat(values[i_cash_transaction_name], "}", length_ctn--);
-		if (length_ctn < 0) {
-			FAIL_FRAME("cash_transaction_name values needs to be increased");
-		}
-
-		strncat(values[i_exec_name], "}", length_en--);
-		if (length_en < 0) {
-			FAIL_FRAME("exec_name values needs to be increased");
-		}
-
-		strncat(values[i_is_cash], "}", length_ic--);
-		if (length_ic < 0) {
-			FAIL_FRAME("is_cash values needs to be increased");
-		}
-
-		strncat(values[i_price], "}", length_p--);
-		if (length_p < 0) {
-			FAIL_FRAME("price values needs to be increased");
-		}
-
-		strncat(values[i_quantity], "}", length_q--);
-		if (length_q < 0) {
-			FAIL_FRAME("quantity values needs to be increased");
-		}
-
-		strncat(values[i_s_name], "}", length_sn--);
-		if (length_sn < 0) {
-			FAIL_FRAME("s_name values needs to be increased");
-		}
-
-		strncat(values[i_settlement_amount], "}", length_sa--);
-		if (length_sa < 0) {
-			FAIL_FRAME("settlement_amount values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_due_date], "}", length_scdd--);
-		if (length_scdd < 0) {
-			FAIL_FRAME(
-					"settlement_cash_due_date values needs to be increased");
-		}
-
-		strncat(values[i_settlement_cash_type], "}", length_sct--);
-		if (length_sct < 0) {
-			FAIL_FRAME("settlement_cash_type values needs to be "
-					   "increased");
-		}
-
-		strncat(values[i_trade_dts], "}", length_td);
-		if (length_td < 0) {
-			FAIL_FRAME("trade_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_dts], "}", length_thd--);
-		if (length_thd < 0) {
-			FAIL_FRAME("trade_history_dts values needs to be increased");
-		}
-
-		strncat(values[i_trade_history_status_id], "}", length_thsi--);
-		if (length_thsi < 0) {
-			FAIL_FRAME("trade_history_status_id values needs to be increased");
-		}
-
-		strncat(values[i_trade_list], "}", length_tl--);
-		if (length_tl < 0) {
-			FAIL_FRAME("trade_list values needs to be increased");
-		}
-
-		strncat(values[i_type_name], "}", length_tn--);
-		if (length_tn < 0) {
-			FAIL_FRAME("type_name values needs to be increased");
-		}
-
-		strncat(values[i_trade_type], "}", length_tt--);
-		if (length_tt < 0) {
-			FAIL_FRAME("trade_type values needs to be increased");
-		}
-
-		snprintf(values[i_num_found], INTEGER_LEN, "%d", num_found);
-		snprintf(values[i_num_updated], INTEGER_LEN, "%d", num_updated);
-
-		/* Build a tuple descriptor for our result type */
-		if (get_call_result_type(fcinfo, NULL, &tupdesc)
-				!= TYPEFUNC_COMPOSITE) {
-			ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								   errmsg("function returning record called "
-										  "in context "
-										  "that cannot accept type record")));
+		for (i = 0; i < 20; i++) {
+			if (i == i_num_found)
+				values[i] = Int32GetDatum(num_found);
+			else if (i == i_num_updated)
+				values[i] = Int32GetDatum(num_updated);
+			else
+				values[i] = result_array_datum(&out[i]);
+			isnull[i] = false;
 		}
 
-		/*
-		 * generate attribute metadata needed later to produce tuples from raw
-		 * C strings
-		 */
-		attinmeta = TupleDescGetAttInMetadata(tupdesc);
-		funcctx->attinmeta = attinmeta;
-
 		MemoryContextSwitchTo(oldcontext);
 	}
 
@@ -2698,7 +1196,6 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 
 	call_cntr = funcctx->call_cntr;
 	max_calls = funcctx->max_calls;
-	attinmeta = funcctx->attinmeta;
 
 	if (call_cntr < max_calls) {
 		/* do when there is more left to send */
@@ -2706,13 +1203,11 @@ TradeUpdateFrame3(PG_FUNCTION_ARGS)
 		Datum result;
 
 #ifdef DEBUG
-		for (i = 0; i < 20; i++) {
-			elog(DEBUG1, "TUF3 OUT: %d %s", i, values[i]);
-		}
+		dump_result("TUF3", funcctx->tuple_desc, values, isnull);
 #endif /* DEBUG */
 
 		/* Build a tuple. */
-		tuple = BuildTupleFromCStrings(attinmeta, values);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, isnull);
 
 		/* Make the tuple into a datum. */
 		result = HeapTupleGetDatum(tuple);
@@ -41,6 +41,9 @@ AS $$
 DECLARE
     r RECORD;
 BEGIN
+    acct_id := '{}';
+    asset_total := '{}';
+    cash_bal := '{}';
     IF cust_id = 0 THEN
         SELECT c_id
         INTO cust_id
@@ -133,6 +136,11 @@ AS $$
 DECLARE
     r RECORD;
 BEGIN
+    hist_dts := '{}';
+    qty := '{}';
+    symbol := '{}';
+    trade_id := '{}';
+    trade_status := '{}';
     hist_len := 0;
     FOR r IN
         SELECT t_id
@@ -95,8 +95,6 @@ AS $$
 << sdf1 >>
 DECLARE
     co_id IDENT_T;
-    co_name VARCHAR(60);
-    exch_date DATE;
     -- variables
     rs RECORD;
     i INTEGER;
@@ -104,6 +102,11 @@ DECLARE
     sdf SECURITY_DETAIL_FIN;
     sdn SECURITY_DETAIL_NEWS;
 BEGIN
+    cp_co_name := '{}';
+    cp_in_name := '{}';
+    day := '{}';
+    fin := '{}';
+    news := '{}';
     SELECT security.s_name
          , company.co_id
          , company.co_name
@@ -155,7 +158,7 @@ BEGIN
        , co_ad_ctry
        , num_out
        , start_date
-       , exch_date
+       , ex_date
        , pe_ratio
        , x52_wk_high
        , x52_wk_high_date
@@ -46,11 +46,19 @@ DECLARE
     tmp_cash_transaction_name VARCHAR(100);
 BEGIN
     num_found = 0;
+    bid_price := '{}';
     cash_transaction_amount := '{}';
     cash_transaction_dts := '{}';
     cash_transaction_name := '{}';
+    exec_name := '{}';
+    is_cash := '{}';
+    is_market := '{}';
+    settlement_amount := '{}';
+    settlement_cash_due_date := '{}';
+    settlement_cash_type := '{}';
     trade_history_dts := '{}';
     trade_history_status_id := '{}';
+    trade_price := '{}';
     i = 0;
     WHILE i < max_trades LOOP
         i = i + 1;
@@ -114,11 +122,19 @@ BEGIN
                , tmp_cash_transaction_name
             FROM cash_transaction
             WHERE ct_t_id = trade_id[i];
+            GET DIAGNOSTICS irow_count = ROW_COUNT;
+        ELSE
+            irow_count := 0;
         END IF;
+        -- Clients read a cash transaction at the position of its trade.
         IF irow_count > 0 THEN
             cash_transaction_amount[i] := tmp_cash_transaction_amount;
             cash_transaction_dts[i] := tmp_cash_transaction_dts;
             cash_transaction_name[i] := tmp_cash_transaction_name;
+        ELSE
+            cash_transaction_amount[i] := NULL;
+            cash_transaction_dts[i] := NULL;
+            cash_transaction_name[i] := NULL;
         END IF;
         -- read trade_history for the trades
         -- Should return 2 to 3 rows per trade
@@ -129,7 +145,7 @@ BEGIN
         trade_history_dts[k + j + 2] = NULL;
         trade_history_status_id[k + j] = NULL;
         trade_history_status_id[k + j + 1] = NULL;
-        trade_history_status_id[k + j + 1] = NULL;
+        trade_history_status_id[k + j + 2] = NULL;
         FOR rs IN
             SELECT th_dts
                  , th_st_id
@@ -185,6 +201,19 @@ DECLARE
     tmp_cash_transaction_dts TIMESTAMP;
     tmp_cash_transaction_name VARCHAR(100);
 BEGIN
+    bid_price := '{}';
+    cash_transaction_amount := '{}';
+    cash_transaction_dts := '{}';
+    cash_transaction_name := '{}';
+    exec_name := '{}';
+    is_cash := '{}';
+    settlement_amount := '{}';
+    settlement_cash_due_date := '{}';
+    settlement_cash_type := '{}';
+    trade_history_dts := '{}';
+    trade_history_status_id := '{}';
+    trade_list := '{}';
+    trade_price := '{}';
     -- Get trade information
     -- Should return between 0 and max_trades rows
     i = 0;
@@ -238,12 +267,19 @@ BEGIN
                , tmp_cash_transaction_name
             FROM cash_transaction
             WHERE ct_t_id = rs.t_id;
+            GET DIAGNOSTICS irow_count = ROW_COUNT;
+        ELSE
+            irow_count := 0;
         END IF;
-        GET DIAGNOSTICS irow_count = ROW_COUNT;
+        -- Clients read a cash transaction at the position of its trade.
         IF irow_count > 0 THEN
             cash_transaction_amount[i] := tmp_cash_transaction_amount;
             cash_transaction_dts[i] := tmp_cash_transaction_dts;
             cash_transaction_name[i] := tmp_cash_transaction_name;
+        ELSE
+            cash_transaction_amount[i] := NULL;
+            cash_transaction_dts[i] := NULL;
+            cash_transaction_name[i] := NULL;
         END IF;
         -- read trade_history for the trades
         -- Should return 2 to 3 rows per trade
@@ -254,7 +290,7 @@ BEGIN
         trade_history_dts[k + j + 2] = NULL;
         trade_history_status_id[k + j] = NULL;
         trade_history_status_id[k + j + 1] = NULL;
-        trade_history_status_id[k + j + 1] = NULL;
+        trade_history_status_id[k + j + 2] = NULL;
         FOR aux IN
             SELECT th_dts
                  , th_st_id
@@ -315,6 +351,22 @@ DECLARE
     tmp_cash_transaction_dts TIMESTAMP;
     tmp_cash_transaction_name VARCHAR(100);
 BEGIN
+    acct_id := '{}';
+    cash_transaction_amount := '{}';
+    cash_transaction_dts := '{}';
+    cash_transaction_name := '{}';
+    exec_name := '{}';
+    is_cash := '{}';
+    price := '{}';
+    quantity := '{}';
+    settlement_amount := '{}';
+    settlement_cash_due_date := '{}';
+    settlement_cash_type := '{}';
+    trade_dts := '{}';
+    trade_history_dts := '{}';
+    trade_history_status_id := '{}';
+    trade_list := '{}';
+    trade_type := '{}';
     -- Should return between 0 and max_trades rows.
     i = 0;
     FOR rs IN
@@ -374,11 +426,19 @@ BEGIN
                , tmp_cash_transaction_name
             FROM cash_transaction
             WHERE ct_t_id = rs.t_id;
+            GET DIAGNOSTICS irow_count = ROW_COUNT;
+        ELSE
+            irow_count := 0;
         END IF;
+        -- Clients read a cash transaction at the position of its trade.
         IF irow_count > 0 THEN
             cash_transaction_amount[i] := tmp_cash_transaction_amount;
             cash_transaction_dts[i] := tmp_cash_transaction_dts;
             cash_transaction_name[i] := tmp_cash_transaction_name;
+        ELSE
+            cash_transaction_amount[i] := NULL;
+            cash_transaction_dts[i] := NULL;
+            cash_transaction_name[i] := NULL;
         END IF;
         -- read trade_history for the trades
         -- Should return 2 to 3 rows per trade
@@ -389,7 +449,7 @@ BEGIN
         trade_history_dts[k + j + 2] = NULL;
         trade_history_status_id[k + j] = NULL;
         trade_history_status_id[k + j + 1] = NULL;
-        trade_history_status_id[k + j + 1] = NULL;
+        trade_history_status_id[k + j + 2] = NULL;
         FOR aux IN
             SELECT th_dts
                  , th_st_id
@@ -426,6 +486,10 @@ DECLARE
     -- Local Frame variables
     rs RECORD;
 BEGIN
+    holding_history_id := '{}';
+    holding_history_trade_id := '{}';
+    quantity_after := '{}';
+    quantity_before := '{}';
     SELECT t_id
     FROM trade
     INTO trade_id
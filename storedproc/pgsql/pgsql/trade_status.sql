@@ -30,6 +30,16 @@ DECLARE
     rs RECORD;
     i INTEGER;
 BEGIN
+    charge := '{}';
+    ex_name := '{}';
+    exec_name := '{}';
+    s_name := '{}';
+    status_name := '{}';
+    symbol := '{}';
+    trade_dts := '{}';
+    trade_id := '{}';
+    trade_qty := '{}';
+    type_name := '{}';
     -- Only want 50 rows, the 50 most recent trades for this customer account
     i := 0;
     FOR rs IN
@@ -30,7 +30,7 @@ CREATE OR REPLACE FUNCTION TradeUpdateFrame1 (
 AS $$
 DECLARE
     -- variables
-    exch_name CHAR(64);
+    exch_name VARCHAR(64);
     i INTEGER;
     j INTEGER;
     k INTEGER;
@@ -48,6 +48,19 @@ DECLARE
     tmp_cash_transaction_dts TIMESTAMP;
     tmp_cash_transaction_name VARCHAR(100);
 BEGIN
+    bid_price := '{}';
+    cash_transaction_amount := '{}';
+    cash_transaction_dts := '{}';
+    cash_transaction_name := '{}';
+    exec_name := '{}';
+    is_cash := '{}';
+    is_market := '{}';
+    settlement_amount := '{}';
+    settlement_cash_due_date := '{}';
+    settlement_cash_type := '{}';
+    trade_history_dts := '{}';
+    trade_history_status_id := '{}';
+    trade_price := '{}';
     num_found = 0;
     num_updated = 0;
     i = 0;
@@ -63,10 +76,10 @@ BEGIN
             GET DIAGNOSTICS irow_count = ROW_COUNT;
             num_found := num_found + irow_count;
             IF exch_name LIKE '% X %' THEN
-                SELECT replace(exch_name , ' ' , ' X ')
+                SELECT replace(exch_name , ' X ' , ' ')
                 INTO exch_name;
             ELSE
-                SELECT replace(exch_name , ' X ' , ' ')
+                SELECT replace(exch_name , ' ' , ' X ')
                 INTO exch_name;
             END IF;
             UPDATE trade
@@ -133,12 +146,19 @@ BEGIN
                , tmp_cash_transaction_name
             FROM cash_transaction
             WHERE ct_t_id = trade_id[i];
+            GET DIAGNOSTICS irow_count = ROW_COUNT;
+        ELSE
+            irow_count := 0;
         END IF;
-        GET DIAGNOSTICS irow_count = ROW_COUNT;
+        -- Clients read a cash transaction at the position of its trade.
         IF irow_count > 0 THEN
             cash_transaction_amount[i] := tmp_cash_transaction_amount;
             cash_transaction_dts[i] := tmp_cash_transaction_dts;
             cash_transaction_name[i] := tmp_cash_transaction_name;
+        ELSE
+            cash_transaction_amount[i] := NULL;
+            cash_transaction_dts[i] := NULL;
+            cash_transaction_name[i] := NULL;
         END IF;
         -- read trade_history for the trades
         -- Will return 2 to 3 rows per trade
@@ -208,6 +228,19 @@ DECLARE
     tmp_cash_transaction_dts TIMESTAMP;
     tmp_cash_transaction_name VARCHAR(100);
 BEGIN
+    bid_price := '{}';
+    cash_transaction_amount := '{}';
+    cash_transaction_dts := '{}';
+    cash_transaction_name := '{}';
+    exec_name := '{}';
+    is_cash := '{}';
+    settlement_amount := '{}';
+    settlement_cash_due_date := '{}';
+    settlement_cash_type := '{}';
+    trade_history_dts := '{}';
+    trade_history_status_id := '{}';
+    trade_list := '{}';
+    trade_price := '{}';
     -- Get trade information
     -- Should return between 0 and max_trades rows
     i = 0;
@@ -287,12 +320,19 @@ BEGIN
                , tmp_cash_transaction_name
             FROM cash_transaction
             WHERE ct_t_id = rs.t_id;
+            GET DIAGNOSTICS irow_count = ROW_COUNT;
+        ELSE
+            irow_count := 0;
         END IF;
-        GET DIAGNOSTICS irow_count = ROW_COUNT;
+        -- Clients read a cash transaction at the position of its trade.
         IF irow_count > 0 THEN
             cash_transaction_amount[i] := tmp_cash_transaction_amount;
             cash_transaction_dts[i] := tmp_cash_transaction_dts;
             cash_transaction_name[i] := tmp_cash_transaction_name;
+        ELSE
+            cash_transaction_amount[i] := NULL;
+            cash_transaction_dts[i] := NULL;
+            cash_transaction_name[i] := NULL;
         END IF;
         -- read trade_history for the trades
         -- Should return 2 to 3 rows per trade
@@ -373,6 +413,24 @@ DECLARE
     tmp_cash_transaction_dts TIMESTAMP;
     tmp_cash_transaction_name VARCHAR(100);
 BEGIN
+    acct_id := '{}';
+    cash_transaction_amount := '{}';
+    cash_transaction_dts := '{}';
+    cash_transaction_name := '{}';
+    exec_name := '{}';
+    is_cash := '{}';
+    price := '{}';
+    quantity := '{}';
+    s_name := '{}';
+    settlement_amount := '{}';
+    settlement_cash_due_date := '{}';
+    settlement_cash_type := '{}';
+    trade_dts := '{}';
+    trade_history_dts := '{}';
+    trade_history_status_id := '{}';
+    trade_list := '{}';
+    type_name := '{}';
+    trade_type := '{}';
     -- Should return between 0 and max_trades rows.
     num_found = 0;
     FOR rs IN
@@ -471,6 +529,11 @@ BEGIN
                 cash_transaction_dts[i] := tmp_cash_transaction_dts;
                 cash_transaction_name[i] := tmp_cash_transaction_name;
             END IF;
+        ELSE
+            -- Clients read a cash transaction at the position of its trade.
+            cash_transaction_amount[i] := NULL;
+            cash_transaction_dts[i] := NULL;
+            cash_transaction_name[i] := NULL;
         END IF;
         -- read trade_history for the trades
         -- Should return 2 to 3 rows per trade